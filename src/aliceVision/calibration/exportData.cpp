@@ -45,6 +45,7 @@ void exportImages(aliceVision::dataio::FeedProvider& feed,
                                                        distCoeffs.at<double>(0), distCoeffs.at<double>(1), distCoeffs.at<double>(4));
   ALICEVISION_LOG_DEBUG("Coefficients matrix :\n " << distCoeffs);
   ALICEVISION_LOG_DEBUG("Exporting images ...");
+  aliceVision::camera::UndistortionMapCache undistortionMaps;
   for (std::size_t currentFrame : exportFrames)
   {
     feed.goToFrame(currentFrame);
@@ -53,7 +54,7 @@ void exportImages(aliceVision::dataio::FeedProvider& feed,
 
     // drawChessboardCorners(view, boardSize, cv::Mat(pointbuf), found);
 
-    aliceVision::camera::UndistortImage(inputImage, &camera, outputImage, static_cast<unsigned char>(0));
+    aliceVision::camera::UndistortImage(inputImage, *undistortionMaps.get(camera, inputImage.Width(), inputImage.Height()), outputImage, static_cast<unsigned char>(0));
     const boost::filesystem::path imagePath = boost::filesystem::path(debugFolder) / (std::to_string(currentFrame) + suffix);
     aliceVision::image::writeImage(imagePath.string(), outputImage, image::EImageColorSpace::AUTO);
   }
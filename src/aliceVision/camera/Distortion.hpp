@@ -36,6 +36,20 @@ public:
         return p;
     }
 
+    /// Add distortion to all the points (one per column, in the camera frame [normalized coordinates])
+    virtual void addDistortion(Mat2X& points) const
+    {
+        for(Mat2X::Index i = 0; i < points.cols(); ++i)
+            points.col(i) = addDistortion(Vec2(points.col(i)));
+    }
+
+    /// Remove distortion of all the points (one per column, in the camera frame [normalized coordinates])
+    virtual void removeDistortion(Mat2X& points) const
+    {
+        for(Mat2X::Index i = 0; i < points.cols(); ++i)
+            points.col(i) = removeDistortion(Vec2(points.col(i)));
+    }
+
     virtual double getUndistortedRadius(double r) const
     {
         return r;
@@ -36,6 +36,21 @@ public:
         return (p + distoFunction(_distortionParams, p));
     }
 
+    void addDistortion(Mat2X& points) const override
+    {
+        const double k1 = _distortionParams[0], k2 = _distortionParams[1], k3 = _distortionParams[2];
+        const double t1 = _distortionParams[3], t2 = _distortionParams[4];
+
+        for(Mat2X::Index i = 0; i < points.cols(); ++i)
+        {
+            const double x = points(0, i), y = points(1, i);
+            const double r2 = x * x + y * y;
+            const double k_diff = r2 * (k1 + r2 * (k2 + r2 * k3));
+            points(0, i) = x + x * k_diff + t2 * (r2 + 2 * x * x) + 2 * t1 * x * y;
+            points(1, i) = y + y * k_diff + t1 * (r2 + 2 * y * y) + 2 * t2 * x * y;
+        }
+    }
+
     /// Remove distortion (return p' such that disto(p') = p)
     Vec2 removeDistortion(const Vec2& p) const override
     {
@@ -50,6 +65,70 @@ public:
         return p_u;
     }
 
+    void removeDistortion(Mat2X& points) const override
+    {
+        for(Mat2X::Index i = 0; i < points.cols(); ++i)
+            points.col(i) = DistortionBrown::removeDistortion(Vec2(points.col(i)));
+    }
+
+    Eigen::Matrix2d getDerivativeAddDistoWrtPt(const Vec2& p) const override
+    {
+        const double k1 = _distortionParams[0], k2 = _distortionParams[1], k3 = _distortionParams[2];
+        const double t1 = _distortionParams[3], t2 = _distortionParams[4];
+        const double x = p(0), y = p(1);
+
+        const double r2 = x * x + y * y;
+        const double k_diff = r2 * (k1 + r2 * (k2 + r2 * k3));
+        const double d_k_diff_d_r2 = k1 + r2 * (2.0 * k2 + r2 * 3.0 * k3);
+
+        Eigen::Matrix2d ret;
+        ret(0, 0) = 1.0 + k_diff + 2.0 * x * x * d_k_diff_d_r2 + 6.0 * t2 * x + 2.0 * t1 * y;
+        ret(0, 1) = 2.0 * x * y * d_k_diff_d_r2 + 2.0 * t2 * y + 2.0 * t1 * x;
+        ret(1, 0) = 2.0 * x * y * d_k_diff_d_r2 + 2.0 * t1 * x + 2.0 * t2 * y;
+        ret(1, 1) = 1.0 + k_diff + 2.0 * y * y * d_k_diff_d_r2 + 6.0 * t1 * y + 2.0 * t2 * x;
+
+        return ret;
+    }
+
+    Eigen::MatrixXd getDerivativeAddDistoWrtDisto(const Vec2& p) const override
+    {
+        const double x = p(0), y = p(1);
+        const double r2 = x * x + y * y;
+        const double r4 = r2 * r2;
+        const double r6 = r4 * r2;
+
+        Eigen::Matrix<double, 2, 5> ret;
+        ret(0, 0) = x * r2;
+        ret(0, 1) = x * r4;
+        ret(0, 2) = x * r6;
+        ret(0, 3) = 2.0 * x * y;
+        ret(0, 4) = r2 + 2.0 * x * x;
+        ret(1, 0) = y * r2;
+        ret(1, 1) = y * r4;
+        ret(1, 2) = y * r6;
+        ret(1, 3) = r2 + 2.0 * y * y;
+        ret(1, 4) = 2.0 * x * y;
+
+        return ret;
+    }
+
+    Eigen::Matrix2d getDerivativeRemoveDistoWrtPt(const Vec2& p) const override
+    {
+        const Vec2 undist = removeDistortion(p);
+
+        const Eigen::Matrix2d Jinv = getDerivativeAddDistoWrtPt(undist);
+
+        return Jinv.inverse();
+    }
+
+    Eigen::MatrixXd getDerivativeRemoveDistoWrtDisto(const Vec2& p) const override
+    {
+        // p = addDistortion(p_u, params) => d_p_u_d_params = - d_add_d_pt^-1 * d_add_d_params
+        const Vec2 undist = removeDistortion(p);
+
+        return -getDerivativeAddDistoWrtPt(undist).inverse() * getDerivativeAddDistoWrtDisto(undist);
+    }
+
     // Functor to calculate distortion offset accounting for both radial and tangential distortion
     static Vec2 distoFunction(const std::vector<double>& params, const Vec2& p)
     {
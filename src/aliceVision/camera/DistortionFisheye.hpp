@@ -60,6 +60,32 @@ public:
     return p * cdist;
   }
 
+  void addDistortion(Mat2X& points) const override
+  {
+    const double eps = 1e-8;
+    const double k1 = _distortionParams.at(0);
+    const double k2 = _distortionParams.at(1);
+    const double k3 = _distortionParams.at(2);
+    const double k4 = _distortionParams.at(3);
+
+    for(Mat2X::Index i = 0; i < points.cols(); ++i)
+    {
+      const double r = std::hypot(points(0, i), points(1, i));
+      if (r < eps)
+      {
+        continue;
+      }
+
+      const double theta = std::atan(r);
+      const double theta2 = theta*theta;
+      const double theta_dist = theta * (1.0 + theta2 * (k1 + theta2 * (k2 + theta2 * (k3 + theta2 * k4))));
+      const double cdist = theta_dist / r;
+
+      points(0, i) *= cdist;
+      points(1, i) *= cdist;
+    }
+  }
+
    Eigen::Matrix2d getDerivativeAddDistoWrtPt(const Vec2 & p) const override
   {
       const double eps = 1e-8;
@@ -157,6 +183,35 @@ public:
     return p * scale;
   }
 
+  void removeDistortion(Mat2X& points) const override
+  {
+    const double eps = 1e-8;
+    const double k1 = _distortionParams.at(0);
+    const double k2 = _distortionParams.at(1);
+    const double k3 = _distortionParams.at(2);
+    const double k4 = _distortionParams.at(3);
+
+    for(Mat2X::Index i = 0; i < points.cols(); ++i)
+    {
+      const double theta_dist = std::hypot(points(0, i), points(1, i));
+      if (theta_dist <= eps)
+      {
+        continue;
+      }
+
+      double theta = theta_dist;
+      for (int j = 0; j < 10; ++j)
+      {
+        const double theta2 = theta*theta;
+        theta = theta_dist / (1 + theta2 * (k1 + theta2 * (k2 + theta2 * (k3 + theta2 * k4))));
+      }
+
+      const double scale = std::tan(theta) / theta_dist;
+      points(0, i) *= scale;
+      points(1, i) *= scale;
+    }
+  }
+
   Eigen::Matrix2d getDerivativeRemoveDistoWrtPt(const Vec2 & p) const override
   {
     const double eps = 1e-8;
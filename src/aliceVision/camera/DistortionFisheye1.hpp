@@ -37,6 +37,20 @@ public:
     return  p * coef;
   }
 
+  void addDistortion(Mat2X& points) const override
+  {
+    const double k1 = _distortionParams.at(0);
+    const double twoTanHalfK1 = 2.0 * std::tan(0.5 * k1);
+
+    for(Mat2X::Index i = 0; i < points.cols(); ++i)
+    {
+      const double r = std::hypot(points(0, i), points(1, i));
+      const double coef = (std::atan(r * twoTanHalfK1) / k1) / r;
+      points(0, i) *= coef;
+      points(1, i) *= coef;
+    }
+  }
+
   /// Remove distortion (return p' such that disto(p') = p)
   Vec2 removeDistortion(const Vec2& p) const override {
     const double k1 = _distortionParams.at(0);
@@ -45,6 +59,84 @@ public:
     return  p * coef;
   }
 
+  void removeDistortion(Mat2X& points) const override
+  {
+    const double k1 = _distortionParams.at(0);
+    const double tanHalfK1 = std::tan(0.5 * k1);
+
+    for(Mat2X::Index i = 0; i < points.cols(); ++i)
+    {
+      const double r = std::hypot(points(0, i), points(1, i));
+      const double coef = 0.5 * std::tan(r * k1) / (tanHalfK1 * r);
+      points(0, i) *= coef;
+      points(1, i) *= coef;
+    }
+  }
+
+  Eigen::Matrix2d getDerivativeAddDistoWrtPt(const Vec2 & p) const override
+  {
+    const double k1 = _distortionParams.at(0);
+    const double twoTanHalfK1 = 2.0 * std::tan(0.5 * k1);
+
+    const double r = std::hypot(p(0), p(1));
+    const double eps = 1e-8;
+    if (r < eps)
+    {
+      return Eigen::Matrix2d::Identity() * (twoTanHalfK1 / k1);
+    }
+
+    Eigen::Matrix<double, 1, 2> d_r_d_p;
+    d_r_d_p(0) = p(0) / r;
+    d_r_d_p(1) = p(1) / r;
+
+    const double theta = std::atan(r * twoTanHalfK1);
+    const double coef = (theta / k1) / r;
+
+    const double d_theta_d_r = twoTanHalfK1 / (1.0 + r * r * twoTanHalfK1 * twoTanHalfK1);
+    const double d_coef_d_r = (d_theta_d_r * r - theta) / (k1 * r * r);
+
+    return Eigen::Matrix2d::Identity() * coef + p * (d_coef_d_r * d_r_d_p);
+  }
+
+  Eigen::MatrixXd getDerivativeAddDistoWrtDisto(const Vec2 & p) const override
+  {
+    const double k1 = _distortionParams.at(0);
+    const double tanHalfK1 = std::tan(0.5 * k1);
+    const double twoTanHalfK1 = 2.0 * tanHalfK1;
+
+    const double r = std::hypot(p(0), p(1));
+    const double eps = 1e-8;
+    if (r < eps)
+    {
+      return Eigen::Matrix<double, 2, 1>::Zero();
+    }
+
+    const double theta = std::atan(r * twoTanHalfK1);
+
+    // d(2 tan(k1 / 2)) / dk1 = 1 + tan(k1 / 2)^2
+    const double d_theta_d_k1 = r * (1.0 + tanHalfK1 * tanHalfK1) / (1.0 + r * r * twoTanHalfK1 * twoTanHalfK1);
+    const double d_coef_d_k1 = (d_theta_d_k1 * k1 - theta) / (k1 * k1 * r);
+
+    return p * d_coef_d_k1;
+  }
+
+  Eigen::Matrix2d getDerivativeRemoveDistoWrtPt(const Vec2 & p) const override
+  {
+    const Vec2 undist = removeDistortion(p);
+
+    const Eigen::Matrix2d Jinv = getDerivativeAddDistoWrtPt(undist);
+
+    return Jinv.inverse();
+  }
+
+  Eigen::MatrixXd getDerivativeRemoveDistoWrtDisto(const Vec2 & p) const override
+  {
+    // p = addDistortion(p_u, k1) => d_p_u_d_k1 = - d_add_d_pt^-1 * d_add_d_k1
+    const Vec2 undist = removeDistortion(p);
+
+    return -getDerivativeAddDistoWrtPt(undist).inverse() * getDerivativeAddDistoWrtDisto(undist);
+  }
+
   ~DistortionFisheye1() override  = default;
 };
 
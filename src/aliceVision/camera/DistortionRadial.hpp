@@ -84,6 +84,19 @@ public:
     return (p * r_coeff);
   }
 
+  void addDistortion(Mat2X& points) const override
+  {
+    const double k1 = _distortionParams[0];
+
+    for(Mat2X::Index i = 0; i < points.cols(); ++i)
+    {
+      const double r2 = points(0, i) * points(0, i) + points(1, i) * points(1, i);
+      const double r_coeff = 1. + k1 * r2;
+      points(0, i) *= r_coeff;
+      points(1, i) *= r_coeff;
+    }
+  }
+
   Eigen::Matrix2d getDerivativeAddDistoWrtPt(const Vec2 & p) const override
   {
 
@@ -112,9 +125,6 @@ public:
 
   Eigen::MatrixXd getDerivativeAddDistoWrtDisto(const Vec2 & p) const  override
   {
-    
-    const double k1 = _distortionParams[0];
-
     const double r = sqrt(p(0)*p(0) + p(1)*p(1));   
     const double eps = 1e-8;
     if (r < eps)
@@ -122,11 +132,11 @@ public:
       return Eigen::Matrix<double, 2, 1>::Zero();
     }
 
-//    const double r2 = r * r;
-    
+    const double r2 = r * r;
+
     /*const double r_coeff = 1.0 + k1 * r2;*/
 
-    const Eigen::MatrixXd ret = p * 2.0 * k1 * r;
+    const Eigen::MatrixXd ret = p * r2;
 
     return ret;
   }
@@ -142,6 +152,12 @@ public:
     return radius * p;
   }
 
+  void removeDistortion(Mat2X& points) const override
+  {
+    for(Mat2X::Index i = 0; i < points.cols(); ++i)
+      points.col(i) = DistortionRadialK1::removeDistortion(Vec2(points.col(i)));
+  }
+
   Eigen::Matrix2d getDerivativeRemoveDistoWrtPt(const Vec2 & p) const override
   {
 
@@ -248,6 +264,21 @@ public:
     return (p * r_coeff);
   }
 
+  void addDistortion(Mat2X& points) const override
+  {
+    const double k1 = _distortionParams[0];
+    const double k2 = _distortionParams[1];
+    const double k3 = _distortionParams[2];
+
+    for(Mat2X::Index i = 0; i < points.cols(); ++i)
+    {
+      const double r2 = points(0, i) * points(0, i) + points(1, i) * points(1, i);
+      const double r_coeff = 1. + r2 * (k1 + r2 * (k2 + r2 * k3));
+      points(0, i) *= r_coeff;
+      points(1, i) *= r_coeff;
+    }
+  }
+
   Eigen::Matrix2d getDerivativeAddDistoWrtPt(const Vec2 & p) const override
   {
 
@@ -319,6 +350,12 @@ public:
     return radius * p;
   }
 
+  void removeDistortion(Mat2X& points) const override
+  {
+    for(Mat2X::Index i = 0; i < points.cols(); ++i)
+      points.col(i) = DistortionRadialK3::removeDistortion(Vec2(points.col(i)));
+  }
+
   Eigen::Matrix2d getDerivativeRemoveDistoWrtPt(const Vec2 & p) const override
   {
 
@@ -420,6 +457,22 @@ public:
     return (p * r_coeff);
   }
 
+  void addDistortion(Mat2X& points) const override
+  {
+    const double k1 = _distortionParams[0];
+    const double k2 = _distortionParams[1];
+    const double k3 = _distortionParams[2];
+    const double normalization = 1.0 / (1.0 + k1 + k2 + k3);
+
+    for(Mat2X::Index i = 0; i < points.cols(); ++i)
+    {
+      const double r2 = points(0, i) * points(0, i) + points(1, i) * points(1, i);
+      const double r_coeff = (1.0 + r2 * (k1 + r2 * (k2 + r2 * k3))) * normalization;
+      points(0, i) *= r_coeff;
+      points(1, i) *= r_coeff;
+    }
+  }
+
   Eigen::Matrix2d getDerivativeAddDistoWrtPt(const Vec2 & p) const override
   {
 
@@ -569,6 +622,12 @@ public:
     return p_undist;
   }
 
+  void removeDistortion(Mat2X& points) const override
+  {
+    for(Mat2X::Index i = 0; i < points.cols(); ++i)
+      points.col(i) = DistortionRadialK3PT::removeDistortion(Vec2(points.col(i)));
+  }
+
   double getUndistortedRadius(double r) const override
   {
     return std::sqrt(radial_distortion::bisection_Radius_Solve(_distortionParams, r * r, distoFunctor));
@@ -96,6 +96,42 @@ public:
     return pt_ima;
   }
 
+  void project(const geometry::Pose3& pose, const Mat3X& pts3D, Mat2X& pts2D, bool applyDistortion = true) const override
+  {
+    const double rsensor = std::min(sensorWidth(), sensorHeight());
+    const double rscale = sensorWidth() / std::max(w(), h());
+    const double fmm = _scale(0) * rscale;
+    const double fov = rsensor / fmm;
+    const double halfFov = 0.5 * fov;
+
+    const Mat3X X = pose(pts3D);
+    pts2D.resize(2, X.cols());
+
+    for(Mat3X::Index i = 0; i < X.cols(); ++i)
+    {
+      const double len2d = sqrt(X(0, i) * X(0, i) + X(1, i) * X(1, i));
+      const double radius = std::atan2(len2d, X(2, i)) / halfFov;
+
+      // the radial direction is (X, Y) / len2d, avoid computing its angle
+      if (len2d > 0.0)
+      {
+        pts2D(0, i) = X(0, i) / len2d * radius;
+        pts2D(1, i) = X(1, i) / len2d * radius;
+      }
+      else
+      {
+        pts2D(0, i) = radius;
+        pts2D(1, i) = 0.0;
+      }
+    }
+
+    if (applyDistortion)
+    {
+      this->addDistortion(pts2D);
+    }
+    this->cam2ima(pts2D);
+  }
+
   Eigen::Matrix<double, 2, 9> getDerivativeProjectWrtRotation(const geometry::Pose3& pose, const Vec3 & pt) 
   {
     const Vec3 X = pose(pt);
@@ -390,6 +426,11 @@ public:
     return _circleRadius * p  + _offset;
   }
 
+  void cam2ima(Mat2X& points) const override
+  {
+    points = (_circleRadius * points).colwise() + _offset;
+  }
+
   Eigen::Matrix2d getDerivativeCam2ImaWrtPoint() const override
   {
     return Eigen::Matrix2d::Identity() * _circleRadius;
@@ -401,6 +442,11 @@ public:
     return (p - _offset) / _circleRadius;
   }
 
+  void ima2cam(Mat2X& points) const override
+  {
+    points = (points.colwise() - _offset) / _circleRadius;
+  }
+
   Eigen::Matrix2d getDerivativeIma2CamWrtPoint() const override
   {
     return Eigen::Matrix2d::Identity() * (1.0 / _circleRadius);
@@ -123,6 +123,20 @@ public:
    */
   virtual Vec2 project(const geometry::Pose3& pose, const Vec3& pt3D, bool applyDistortion = true) const = 0;
 
+  /**
+   * @brief Projection of 3D points into the camera plane (Apply pose, disto (if any) and Intrinsics)
+   * @param[in] pose The pose
+   * @param[in] pts3D The 3d points, one per column
+   * @param[out] pts2D The 2d projections in the camera plane, one per column
+   * @param[in] applyDistortion If true apply distrortion if any
+   */
+  virtual void project(const geometry::Pose3& pose, const Mat3X& pts3D, Mat2X& pts2D, bool applyDistortion = true) const
+  {
+    pts2D.resize(2, pts3D.cols());
+    for(Mat3X::Index i = 0; i < pts3D.cols(); ++i)
+      pts2D.col(i) = project(pose, pts3D.col(i), applyDistortion);
+  }
+
   /**
    * @brief Back-projection of a 2D point at a specific depth into a 3D point
    * @param[in] pt2D The 2d point
@@ -191,13 +205,9 @@ public:
   inline Mat2X residuals(const geometry::Pose3& pose, const Mat3X& X, const Mat2X& x) const
   {
     assert(X.cols() == x.cols());
-    const std::size_t numPts = x.cols();
-    Mat2X residuals = Mat2X::Zero(2, numPts);
-    for(std::size_t i = 0; i < numPts; ++i)
-    {
-      residuals.col(i) = residual(pose, X.col(i), x.col(i));
-    }
-    return residuals;
+    Mat2X proj;
+    this->project(pose, X, proj);
+    return x - proj;
   }
 
   /**
@@ -324,6 +334,26 @@ public:
    */
   virtual Vec2 ima2cam(const Vec2& p) const = 0;
 
+  /**
+   * @brief Transform points from the camera plane to the image plane
+   * @param[in,out] points Points from the camera plane, one per column, replaced by the image plane points
+   */
+  virtual void cam2ima(Mat2X& points) const
+  {
+    for(Mat2X::Index i = 0; i < points.cols(); ++i)
+      points.col(i) = cam2ima(Vec2(points.col(i)));
+  }
+
+  /**
+   * @brief Transform points from the image plane to the camera plane
+   * @param[in,out] points Points from the image plane, one per column, replaced by the camera plane points
+   */
+  virtual void ima2cam(Mat2X& points) const
+  {
+    for(Mat2X::Index i = 0; i < points.cols(); ++i)
+      points.col(i) = ima2cam(Vec2(points.col(i)));
+  }
+
   /**
    * @brief Camera model handle a distortion field
    * @return True if the camera model handle a distortion field
@@ -361,6 +391,46 @@ public:
    */
   virtual Vec2 get_d_pixel(const Vec2& p) const = 0;
 
+  /**
+   * @brief Add the distortion field to points (that are in normalized camera frame)
+   * @param[in,out] points The points, one per column
+   */
+  virtual void addDistortion(Mat2X& points) const
+  {
+    for(Mat2X::Index i = 0; i < points.cols(); ++i)
+      points.col(i) = addDistortion(Vec2(points.col(i)));
+  }
+
+  /**
+   * @brief Remove the distortion to camera points (that are in normalized camera frame)
+   * @param[in,out] points The points, one per column
+   */
+  virtual void removeDistortion(Mat2X& points) const
+  {
+    for(Mat2X::Index i = 0; i < points.cols(); ++i)
+      points.col(i) = removeDistortion(Vec2(points.col(i)));
+  }
+
+  /**
+   * @brief Replace pixels by the undistorted pixels (with removed distortion)
+   * @param[in,out] points The pixels, one per column
+   */
+  virtual void get_ud_pixel(Mat2X& points) const
+  {
+    for(Mat2X::Index i = 0; i < points.cols(); ++i)
+      points.col(i) = get_ud_pixel(Vec2(points.col(i)));
+  }
+
+  /**
+   * @brief Replace undistorted pixels by the distorted pixels (with added distortion)
+   * @param[in,out] points The undistorted pixels, one per column
+   */
+  virtual void get_d_pixel(Mat2X& points) const
+  {
+    for(Mat2X::Index i = 0; i < points.cols(); ++i)
+      points.col(i) = get_d_pixel(Vec2(points.col(i)));
+  }
+
   /**
    * @brief Normalize a given unit pixel error to the camera plane
    * @param[in] value Given unit pixel error
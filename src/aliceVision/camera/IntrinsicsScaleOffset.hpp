@@ -55,6 +55,11 @@ public:
     return p.cwiseProduct(_scale) + _offset;
   }
 
+  void cam2ima(Mat2X& points) const override
+  {
+    points = (points.array().colwise() * _scale.array()).matrix().colwise() + _offset;
+  }
+
   virtual Vec2 getDerivativeCam2ImaWrtScale(const Vec2& p) const
   {
     return p;
@@ -76,6 +81,11 @@ public:
     return (p - _offset) / _scale(0);
   }
 
+  void ima2cam(Mat2X& points) const override
+  {
+    points = (points.colwise() - _offset) / _scale(0);
+  }
+
   virtual Eigen::Matrix<double, 2, 1> getDerivativeIma2CamWrtScale(const Vec2& p) const
   {
       return -(p - _offset) / (_scale(0) * _scale(0));
@@ -56,6 +56,22 @@ public:
     return _pDistortion->removeDistortion(p); 
   }
 
+  void addDistortion(Mat2X& points) const override
+  {
+    if (_pDistortion != nullptr)
+    {
+      _pDistortion->addDistortion(points);
+    }
+  }
+
+  void removeDistortion(Mat2X& points) const override
+  {
+    if (_pDistortion != nullptr)
+    {
+      _pDistortion->removeDistortion(points);
+    }
+  }
+
   /// Return the un-distorted pixel (with removed distortion)
   Vec2 get_ud_pixel(const Vec2& p) const override
   {
@@ -68,6 +84,20 @@ public:
     return cam2ima(addDistortion(ima2cam(p)));
   }
 
+  void get_ud_pixel(Mat2X& points) const override
+  {
+    ima2cam(points);
+    removeDistortion(points);
+    cam2ima(points);
+  }
+
+  void get_d_pixel(Mat2X& points) const override
+  {
+    ima2cam(points);
+    addDistortion(points);
+    cam2ima(points);
+  }
+
   std::vector<double> getDistortionParams() const
   {
     if (!hasDistortion()) {
@@ -93,12 +93,24 @@ public:
     const Vec3 X = pose(pt); // apply pose
     const Vec2 P = X.head<2>() / X(2);
 
-    const Vec2 distorted = this->addDistortion(P);
+    const Vec2 distorted = applyDistortion ? this->addDistortion(P) : P;
     const Vec2 impt = this->cam2ima(distorted);
 
     return impt;
   }
 
+  void project(const geometry::Pose3& pose, const Mat3X& pts3D, Mat2X& pts2D, bool applyDistortion = true) const override
+  {
+    const Mat3X X = pose(pts3D); // apply pose
+    pts2D = X.topRows<2>().array().rowwise() / X.row(2).array();
+
+    if (applyDistortion)
+    {
+      this->addDistortion(pts2D);
+    }
+    this->cam2ima(pts2D);
+  }
+
   Eigen::Matrix<double, 2, 9> getDerivativeProjectWrtRotation(const geometry::Pose3& pose, const Vec3 & pt)
   {
     const Vec3 X = pose(pt); // apply pose
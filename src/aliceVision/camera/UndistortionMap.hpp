@@ -0,0 +1,546 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/image/Image.hpp>
+#include <aliceVision/image/Sampler.hpp>
+#include <aliceVision/camera/cameraCommon.hpp>
+#include <aliceVision/camera/IntrinsicBase.hpp>
+#include <aliceVision/camera/Pinhole.hpp>
+#include <aliceVision/stl/hash.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace camera {
+
+/**
+ * @brief Precomputed remap table of the undistortion of an image.
+ *
+ * For each pixel of the undistorted image, the table stores the top-left source pixel
+ * in the distorted image and its bilinear weights in 8-bit fixed point (6 bytes per pixel).
+ * The distortion model is evaluated once when the map is built, so the map can be applied
+ * to all the images sharing the same intrinsic and resolution.
+ */
+class UndistortionMap
+{
+public:
+  /// Source pixel of an undistorted pixel, fx and fy are the subpixel offsets in 1/256 pixel
+  struct Entry
+  {
+    uint16_t x;
+    uint16_t y;
+    uint8_t fx;
+    uint8_t fy;
+  };
+
+  /// Binary file header (see save / load), followed by the intrinsic parameters and the entries
+  struct FileHeader
+  {
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    uint32_t width;
+    uint32_t height;
+    uint32_t intrinsicType;
+    uint32_t correctPrincipalPoint;
+    uint32_t nbParams;
+    uint32_t reserved;
+  };
+
+  /// Everything the map depends on, compared to tell apart the intrinsics with the same key
+  struct Source
+  {
+    EINTRINSIC intrinsicType = EINTRINSIC::UNKNOWN;
+    std::vector<double> params;
+    int width = 0;
+    int height = 0;
+    bool correctPrincipalPoint = false;
+
+    Source() = default;
+    Source(const IntrinsicBase& intrinsic, int width, int height, bool correctPrincipalPoint)
+      : intrinsicType(intrinsic.getType())
+      , params(intrinsic.getParams())
+      , width(width)
+      , height(height)
+      , correctPrincipalPoint(correctPrincipalPoint)
+    {}
+
+    bool operator==(const Source& other) const
+    {
+      return intrinsicType == other.intrinsicType && params == other.params && width == other.width &&
+             height == other.height && correctPrincipalPoint == other.correctPrincipalPoint;
+    }
+  };
+
+  /// Coordinate value marking a pixel without source (outside of the distorted image)
+  static constexpr uint16_t invalidCoordinate = 0xFFFF;
+
+  UndistortionMap() = default;
+
+  /**
+   * @brief Build the undistortion map of an intrinsic
+   * @param[in] intrinsic the camera intrinsic
+   * @param[in] width the width of the images to undistort
+   * @param[in] height the height of the images to undistort
+   * @param[in] correctPrincipalPoint move the principal point of pinhole cameras to the image center
+   */
+  UndistortionMap(const IntrinsicBase& intrinsic, int width, int height, bool correctPrincipalPoint = false)
+    : _key(computeKey(intrinsic, width, height, correctPrincipalPoint))
+    , _source(intrinsic, width, height, correctPrincipalPoint)
+    , _width(width)
+    , _height(height)
+  {
+    if(width <= 0 || height <= 0 || width >= invalidCoordinate || height >= invalidCoordinate)
+      throw std::invalid_argument("Unsupported image size for an undistortion map: " + std::to_string(width) + "x" + std::to_string(height));
+
+    Vec2 ppCorrection(0.0, 0.0);
+
+    if(correctPrincipalPoint && camera::isPinhole(intrinsic.getType()))
+    {
+      const camera::Pinhole& pinhole = dynamic_cast<const camera::Pinhole&>(intrinsic);
+      ppCorrection = pinhole.getPrincipalPoint() - Vec2(width * 0.5, height * 0.5);
+    }
+
+    _entries.resize(std::size_t(width) * height);
+
+    #pragma omp parallel for
+    for(int j = 0; j < height; ++j)
+    {
+      Mat2X disto_pix(2, width);
+      disto_pix.row(0) = Eigen::RowVectorXd::LinSpaced(width, 0, width - 1);
+      disto_pix.row(1).setConstant(j);
+      intrinsic.get_d_pixel(disto_pix);
+      disto_pix.colwise() += ppCorrection;
+
+      Entry* row = &_entries[std::size_t(j) * width];
+      for(int i = 0; i < width; ++i)
+      {
+        Entry& entry = row[i];
+        if(!quantize(disto_pix(0, i), width, entry.x, entry.fx) ||
+           !quantize(disto_pix(1, i), height, entry.y, entry.fy))
+        {
+          entry.x = invalidCoordinate;
+          entry.y = invalidCoordinate;
+          entry.fx = 0;
+          entry.fy = 0;
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief Compute the key identifying an undistortion map
+   * @param[in] intrinsic the camera intrinsic
+   * @param[in] width the width of the images to undistort
+   * @param[in] height the height of the images to undistort
+   * @param[in] correctPrincipalPoint move the principal point of pinhole cameras to the image center
+   * @return the map key
+   */
+  static std::size_t computeKey(const IntrinsicBase& intrinsic, int width, int height, bool correctPrincipalPoint)
+  {
+    std::size_t seed = intrinsic.hashValue();
+    stl::hash_combine(seed, width);
+    stl::hash_combine(seed, height);
+    stl::hash_combine(seed, correctPrincipalPoint);
+    return seed;
+  }
+
+  bool empty() const { return _entries.empty(); }
+  int width() const { return _width; }
+  int height() const { return _height; }
+  std::size_t key() const { return _key; }
+  const Source& source() const { return _source; }
+  /// Memory used by the entries, in bytes
+  std::size_t byteSize() const { return _entries.size() * sizeof(Entry); }
+  const std::vector<Entry>& entries() const { return _entries; }
+
+  /**
+   * @brief Undistort an image with the map (separable bilinear interpolation)
+   * @param[in] imageIn the distorted image, its size must be the size of the map
+   * @param[out] imageOut the undistorted image
+   * @param[in] fillcolor the color of the pixels without source
+   */
+  template <typename T>
+  void apply(const image::Image<T>& imageIn, image::Image<T>& imageOut, T fillcolor) const
+  {
+    if(imageIn.Width() != _width || imageIn.Height() != _height)
+      throw std::invalid_argument("The image size (" + std::to_string(imageIn.Width()) + "x" + std::to_string(imageIn.Height()) +
+                                  ") does not match the undistortion map size (" + std::to_string(_width) + "x" + std::to_string(_height) + ").");
+
+    typedef image::RealPixel<T> RealPixelT;
+    typedef typename RealPixelT::real_type RealT;
+
+    imageOut.resize(_width, _height, true, fillcolor);
+
+    const int lastCol = _width - 1;
+    const int lastRow = _height - 1;
+
+    #pragma omp parallel for
+    for(int j = 0; j < _height; ++j)
+    {
+      const Entry* row = &_entries[std::size_t(j) * _width];
+      for(int i = 0; i < _width; ++i)
+      {
+        const Entry& entry = row[i];
+        if(entry.x == invalidCoordinate)
+          continue;
+
+        // the neighbors out of the image are clamped, as Sampler2d drops them and renormalizes
+        const int x1 = std::min<int>(entry.x + 1, lastCol);
+        const int y1 = std::min<int>(entry.y + 1, lastRow);
+        const double wx = entry.fx * (1.0 / 256.0);
+        const double wy = entry.fy * (1.0 / 256.0);
+
+        const RealT top = RealPixelT::convert_to_real(imageIn(entry.y, entry.x)) * (1.0 - wx) +
+                          RealPixelT::convert_to_real(imageIn(entry.y, x1)) * wx;
+        const RealT bottom = RealPixelT::convert_to_real(imageIn(y1, entry.x)) * (1.0 - wx) +
+                             RealPixelT::convert_to_real(imageIn(y1, x1)) * wx;
+
+        imageOut(j, i) = RealPixelT::convert_from_real(RealT(top * (1.0 - wy) + bottom * wy));
+      }
+    }
+  }
+
+  /**
+   * @brief Save the map to a binary file
+   * @param[in] file the output file path
+   */
+  void save(const std::string& file) const
+  {
+    std::ofstream out(file.c_str(), std::ios_base::binary);
+    if(!out.is_open())
+      throw std::runtime_error("Unable to open the undistortion map file: " + file);
+
+    FileHeader header = createHeader(_key, _width, _height);
+    header.intrinsicType = static_cast<uint32_t>(_source.intrinsicType);
+    header.correctPrincipalPoint = _source.correctPrincipalPoint;
+    header.nbParams = static_cast<uint32_t>(_source.params.size());
+    out.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+    out.write(reinterpret_cast<const char*>(_source.params.data()), _source.params.size() * sizeof(double));
+    out.write(reinterpret_cast<const char*>(_entries.data()), _entries.size() * sizeof(Entry));
+
+    if(!out.good())
+      throw std::runtime_error("Unable to write the undistortion map file: " + file);
+  }
+
+  /**
+   * @brief Load the map from a binary file
+   * @param[in] file the input file path
+   */
+  void load(const std::string& file)
+  {
+    std::ifstream in(file.c_str(), std::ios_base::binary);
+    if(!in.is_open())
+      throw std::runtime_error("Unable to open the undistortion map file: " + file);
+
+    FileHeader header;
+    if(!in.read(reinterpret_cast<char*>(&header), sizeof(FileHeader)))
+      throw std::runtime_error("Invalid undistortion map file: " + file);
+
+    const FileHeader expected = createHeader(header.key, header.width, header.height);
+    if(std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 || header.version != expected.version ||
+       header.width == 0 || header.height == 0 || header.width >= invalidCoordinate || header.height >= invalidCoordinate ||
+       header.nbParams > maxParams)
+      throw std::runtime_error("Invalid undistortion map file: " + file);
+
+    Source source;
+    source.intrinsicType = static_cast<EINTRINSIC>(header.intrinsicType);
+    source.params.resize(header.nbParams);
+    source.width = header.width;
+    source.height = header.height;
+    source.correctPrincipalPoint = (header.correctPrincipalPoint != 0);
+    if(!in.read(reinterpret_cast<char*>(source.params.data()), source.params.size() * sizeof(double)))
+      throw std::runtime_error("Corrupted undistortion map file: " + file);
+
+    std::vector<Entry> entries(std::size_t(header.width) * header.height);
+    if(!in.read(reinterpret_cast<char*>(entries.data()), entries.size() * sizeof(Entry)))
+      throw std::runtime_error("Corrupted undistortion map file: " + file);
+
+    _key = header.key;
+    _source = std::move(source);
+    _width = header.width;
+    _height = header.height;
+    _entries.swap(entries);
+  }
+
+private:
+  static_assert(sizeof(Entry) == 6, "The undistortion map entries must not have padding.");
+  static_assert(sizeof(FileHeader) == 40, "The undistortion map file header must not have padding.");
+
+  /// Upper bound of the number of intrinsic parameters accepted when loading a file
+  static constexpr uint32_t maxParams = 256;
+
+  /**
+   * @brief Convert a coordinate in the distorted image to a source pixel and a subpixel offset.
+   * Follows the behavior of UndistortImage with Sampler2d<SamplerLinear>: a coordinate is valid
+   * if its truncation is in the image, the missing neighbors are clamped.
+   * @note On the one pixel band around the image, Sampler2d returns the nearest pixel when the weight
+   *       of the neighbors inside the image is low, the map always interpolates.
+   */
+  static bool quantize(double value, int size, uint16_t& pixel, uint8_t& offset)
+  {
+    if(!(value > -1.0 && value < size))
+      return false;
+
+    if(value < 0.0)
+    {
+      pixel = 0;
+      offset = 0;
+      return true;
+    }
+
+    int p = static_cast<int>(std::floor(value));
+    int o = static_cast<int>(std::lround((value - p) * 256.0));
+    if(o == 256)
+    {
+      ++p;
+      o = 0;
+    }
+    if(p > size - 1)
+    {
+      p = size - 1;
+      o = 0;
+    }
+    pixel = static_cast<uint16_t>(p);
+    offset = static_cast<uint8_t>(o);
+    return true;
+  }
+
+  static FileHeader createHeader(uint64_t key, uint32_t width, uint32_t height)
+  {
+    FileHeader header;
+    std::memset(&header, 0, sizeof(FileHeader));
+    std::memcpy(header.magic, "AVUM", sizeof(header.magic));
+    header.version = 2;
+    header.key = key;
+    header.width = width;
+    header.height = height;
+    return header;
+  }
+
+  std::size_t _key = 0;
+  Source _source;
+  int _width = 0;
+  int _height = 0;
+  std::vector<Entry> _entries;
+};
+
+/**
+ * @brief Thread-safe cache of undistortion maps, shared by the images of the same intrinsic.
+ *
+ * The maps kept in memory are bounded by a byte budget, the least recently used ones are released first.
+ * If a folder is given, the maps are also saved to / reloaded from this folder,
+ * so several runs on the same dataset compute each map only once.
+ */
+class UndistortionMapCache
+{
+public:
+  /// Default memory budget of the maps kept in memory (1 GiB)
+  static constexpr std::size_t defaultMaxBytes = std::size_t(1) << 30;
+
+  /**
+   * @param[in] folder the folder of the maps saved on disk, empty to keep them in memory only
+   * @param[in] maxBytes the memory budget of the maps kept in memory, the last used map is always kept
+   */
+  explicit UndistortionMapCache(const std::string& folder = "", std::size_t maxBytes = defaultMaxBytes)
+    : _folder(folder)
+    , _maxBytes(maxBytes)
+  {}
+
+  /**
+   * @brief Get the undistortion map of an intrinsic, built on first use
+   * @param[in] intrinsic the camera intrinsic
+   * @param[in] width the width of the images to undistort
+   * @param[in] height the height of the images to undistort
+   * @param[in] correctPrincipalPoint move the principal point of pinhole cameras to the image center
+   * @return the undistortion map
+   */
+  std::shared_ptr<const UndistortionMap> get(const IntrinsicBase& intrinsic, int width, int height, bool correctPrincipalPoint = false)
+  {
+    const std::size_t key = UndistortionMap::computeKey(intrinsic, width, height, correctPrincipalPoint);
+    UndistortionMap::Source source(intrinsic, width, height, correctPrincipalPoint);
+
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    for(auto it = _items.begin(); it != _items.end(); ++it)
+    {
+      if(it->key == key && it->source == source)
+      {
+        _items.splice(_items.begin(), _items, it);
+        // wait outside of the lock if the map is still being built by another thread
+        const std::shared_future<std::shared_ptr<const UndistortionMap>> map = it->map;
+        lock.unlock();
+        return map.get();
+      }
+    }
+
+    std::promise<std::shared_ptr<const UndistortionMap>> promise;
+    const std::size_t id = _nextId++;
+    _items.push_front(Item{id, key, std::move(source), promise.get_future().share(), 0});
+    lock.unlock();
+
+    // the map is built outside of the lock, the other threads asking for it wait on the future
+    std::shared_ptr<const UndistortionMap> map;
+    try
+    {
+      map = loadOrBuild(intrinsic, width, height, correctPrincipalPoint, key);
+    }
+    catch(...)
+    {
+      lock.lock();
+      erase(id);
+      promise.set_exception(std::current_exception());
+      throw;
+    }
+    promise.set_value(map);
+
+    lock.lock();
+    for(Item& item : _items)
+    {
+      if(item.id == id)
+      {
+        item.bytes = map->byteSize();
+        _bytes += item.bytes;
+        break;
+      }
+    }
+    evict(id);
+    return map;
+  }
+
+  /**
+   * @brief Release all the maps kept in memory
+   */
+  void clear()
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _items.clear();
+    _bytes = 0;
+  }
+
+  /**
+   * @brief Get the memory used by the maps kept in memory
+   * @return the size of the maps, in bytes
+   */
+  std::size_t byteSize() const
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _bytes;
+  }
+
+private:
+  /// A map kept in memory, the map is ready when bytes is set
+  struct Item
+  {
+    std::size_t id;
+    std::size_t key;
+    UndistortionMap::Source source;
+    std::shared_future<std::shared_ptr<const UndistortionMap>> map;
+    std::size_t bytes;
+  };
+
+  std::shared_ptr<const UndistortionMap> loadOrBuild(const IntrinsicBase& intrinsic, int width, int height, bool correctPrincipalPoint, std::size_t key) const
+  {
+    std::shared_ptr<UndistortionMap> map;
+    const std::string file = getFilePath(key);
+
+    if(!file.empty() && std::ifstream(file.c_str()).good())
+    {
+      try
+      {
+        map = std::make_shared<UndistortionMap>();
+        map->load(file);
+        if(map->key() != key || !(map->source() == UndistortionMap::Source(intrinsic, width, height, correctPrincipalPoint)))
+          throw std::runtime_error("The undistortion map file does not match the intrinsic: " + file);
+        ALICEVISION_LOG_DEBUG("Undistortion map loaded from: " << file);
+      }
+      catch(const std::exception& e)
+      {
+        ALICEVISION_LOG_WARNING(e.what());
+        map.reset();
+      }
+    }
+
+    if(!map)
+    {
+      map = std::make_shared<UndistortionMap>(intrinsic, width, height, correctPrincipalPoint);
+
+      if(!file.empty())
+      {
+        try
+        {
+          map->save(file);
+        }
+        catch(const std::exception& e)
+        {
+          ALICEVISION_LOG_WARNING(e.what());
+        }
+      }
+    }
+    return map;
+  }
+
+  void erase(std::size_t id)
+  {
+    for(auto it = _items.begin(); it != _items.end(); ++it)
+    {
+      if(it->id == id)
+      {
+        _bytes -= it->bytes;
+        _items.erase(it);
+        return;
+      }
+    }
+  }
+
+  /// Release the least recently used maps over the budget, except the given one
+  void evict(std::size_t keepId)
+  {
+    for(auto it = _items.end(); _bytes > _maxBytes && it != _items.begin();)
+    {
+      --it;
+      if(it->id == keepId || it->bytes == 0)
+        continue;
+      _bytes -= it->bytes;
+      it = _items.erase(it);
+    }
+  }
+
+  std::string getFilePath(std::size_t key) const
+  {
+    if(_folder.empty())
+      return std::string();
+    std::ostringstream os;
+    os << _folder << "/undistortionMap_" << std::hex << key << ".bin";
+    return os.str();
+  }
+
+  std::string _folder;
+  std::size_t _maxBytes;
+  std::size_t _bytes = 0;
+  std::size_t _nextId = 0;
+  mutable std::mutex _mutex;
+  /// maps kept in memory, the most recently used first
+  std::list<Item> _items;
+};
+
+} // namespace camera
+} // namespace aliceVision
@@ -14,6 +14,7 @@
 #include <aliceVision/camera/cameraCommon.hpp>
 #include <aliceVision/camera/IntrinsicBase.hpp>
 #include <aliceVision/camera/Pinhole.hpp>
+#include <aliceVision/camera/UndistortionMap.hpp>
 
 #include <memory>
 
@@ -52,20 +53,35 @@ void UndistortImage(
 
     #pragma omp parallel for
     for (int j = 0; j < imageIn.Height(); ++j)
+    {
+      // compute the coordinates with distortion of the whole row at once
+      Mat2X disto_pix(2, imageIn.Width());
+      disto_pix.row(0) = Eigen::RowVectorXd::LinSpaced(imageIn.Width(), 0, imageIn.Width() - 1);
+      disto_pix.row(1).setConstant(j);
+      intrinsicPtr->get_d_pixel(disto_pix);
+      disto_pix.colwise() += ppCorrection;
+
       for (int i = 0; i < imageIn.Width(); ++i)
       {
-        const Vec2 undisto_pix(i,j);
-
-        // compute coordinates with distortion
-        const Vec2 disto_pix = intrinsicPtr->get_d_pixel(undisto_pix) + ppCorrection;
-
         // pick pixel if it is in the image domain
-        if ( imageIn.Contains(disto_pix(1), disto_pix(0)) )
-          image_ud( j, i ) = sampler(imageIn, disto_pix(1), disto_pix(0));
+        if ( imageIn.Contains(disto_pix(1, i), disto_pix(0, i)) )
+          image_ud( j, i ) = sampler(imageIn, disto_pix(1, i), disto_pix(0, i));
       }
+    }
   }
 }
 
+/// Undistort an image with a precomputed undistortion map (see UndistortionMapCache)
+template <typename T>
+void UndistortImage(
+  const image::Image<T>& imageIn,
+  const UndistortionMap& undistortionMap,
+  image::Image<T>& image_ud,
+  T fillcolor)
+{
+  undistortionMap.apply(imageIn, image_ud, fillcolor);
+}
+
 } // namespace camera
 } // namespace aliceVision
 
@@ -49,3 +49,56 @@ BOOST_AUTO_TEST_CASE(distortion_distort_undistort)
         }
     }
 }
+
+//-----------------
+BOOST_AUTO_TEST_CASE(distortion_derivatives)
+{
+    std::array<std::unique_ptr<Distortion>, 6> distortionsModels;
+    distortionsModels[0].reset(new DistortionBrown(-0.25349, 0.11868, -0.00028, 0.00005, 0.0000001));
+    distortionsModels[1].reset(new DistortionFisheye(0.02, -0.03, 0.1, -0.2));
+    distortionsModels[2].reset(new DistortionFisheye1(0.9));
+    distortionsModels[3].reset(new DistortionRadialK1(0.02));
+    distortionsModels[4].reset(new DistortionRadialK3(-1.8061369278146561e-01, 1.8759742680633607e-01, -2.5341468279930644e-02));
+    distortionsModels[5].reset(new DistortionRadialK3PT(-1.8061369278146561e-01, 1.8759742680633607e-01, -2.5341468279930644e-02));
+
+    // compare the analytic derivatives with central finite differences
+    const double h = 1e-6;
+    const double epsilon = 1e-5;
+    const std::size_t numPts{100};
+    for(std::size_t i = 0; i < numPts; ++i)
+    {
+        // random point in [-lim, lim]x[-lim, lim]
+        const double lim{0.8};
+        const Vec2 ptImage = lim*Vec2::Random();
+
+        for(const auto& model : distortionsModels)
+        {
+            Eigen::Matrix2d d_pt;
+            for(int c = 0; c < 2; ++c)
+            {
+                Vec2 delta = Vec2::Zero();
+                delta(c) = h;
+                d_pt.col(c) = (model->addDistortion(ptImage + delta) - model->addDistortion(ptImage - delta)) / (2.0 * h);
+            }
+
+            std::vector<double>& params = model->getParameters();
+            Eigen::MatrixXd d_disto(2, params.size());
+            for(std::size_t c = 0; c < params.size(); ++c)
+            {
+                const double value = params[c];
+                params[c] = value + h;
+                const Vec2 distortedPlus = model->addDistortion(ptImage);
+                params[c] = value - h;
+                const Vec2 distortedMinus = model->addDistortion(ptImage);
+                params[c] = value;
+                d_disto.col(c) = (distortedPlus - distortedMinus) / (2.0 * h);
+            }
+
+            const Eigen::Matrix2d d_pt_analytic = model->getDerivativeAddDistoWrtPt(ptImage);
+            const Eigen::MatrixXd d_disto_analytic = model->getDerivativeAddDistoWrtDisto(ptImage);
+
+            EXPECT_MATRIX_NEAR(d_pt, d_pt_analytic, epsilon);
+            EXPECT_MATRIX_NEAR(d_disto, d_disto_analytic, epsilon);
+        }
+    }
+}
@@ -11,6 +11,7 @@
 #include <boost/test/unit_test.hpp>
 #include <boost/test/tools/floating_point_comparison.hpp>
 #include <aliceVision/unitTest.hpp>
+#include <aliceVision/camera/intrinsicsBatchTest.hpp>
 
 using namespace aliceVision;
 using namespace aliceVision::camera;
@@ -62,5 +63,16 @@ BOOST_AUTO_TEST_CASE(cameraEquidistant_disto_undisto_Radial)
   }
 }
 
+//-----------------
+// Test summary:
+//-----------------
+// - Create a Equidistant camera
+// - Generate random points inside the image domain
+// - Assert that the batched projection and (un)distortion give the same result as the per-point versions
+//-----------------
+BOOST_AUTO_TEST_CASE(cameraEquidistant_batched_Radial)
+{
+  const EquiDistantRadialK3 cam(1000, 800, 800.0, 500.0, 400.0, 0.0, 0.3, 0.2, 0.1);
 
-
+  checkBatchedIntrinsic(cam);
+}
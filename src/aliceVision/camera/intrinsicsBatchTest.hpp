@@ -0,0 +1,56 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/camera/IntrinsicBase.hpp>
+#include <aliceVision/geometry/Pose3.hpp>
+#include <aliceVision/numeric/numeric.hpp>
+#include <aliceVision/unitTest.hpp>
+
+#include <cmath>
+
+namespace aliceVision {
+namespace camera {
+
+/**
+ * @brief Assert that the batched projection and (un)distortion of a camera give
+ *        the same result as the per-point versions, for random points inside the image domain.
+ * @param[in] cam The camera
+ * @param[in] epsilon The tolerance on the image coordinates
+ * @param[in] nbPoints The number of random points
+ */
+inline void checkBatchedIntrinsic(const IntrinsicBase& cam, double epsilon = 1e-6, int nbPoints = 100)
+{
+  const geometry::Pose3 pose(geometry::randomPose());
+  const Vec2 center(cam.w() / 2.0, cam.h() / 2.0);
+
+  Mat2X ptsImage(2, nbPoints);
+  Mat3X pts3d(3, nbPoints);
+  for(int i = 0; i < nbPoints; ++i)
+  {
+    ptsImage.col(i) = (Vec2::Random() * center(1)) + center + Vec2::Random();
+    pts3d.col(i) = cam.backproject(ptsImage.col(i), true, pose, 1.0 + std::abs(Vec2::Random()(0)) * 100.0);
+  }
+
+  Mat2X pts2d;
+  cam.project(pose, pts3d, pts2d, true);
+  Mat2X ptsDisto = ptsImage;
+  cam.get_d_pixel(ptsDisto);
+  Mat2X ptsUndisto = ptsImage;
+  cam.get_ud_pixel(ptsUndisto);
+
+  BOOST_CHECK_EQUAL(pts2d.cols(), nbPoints);
+  for(int i = 0; i < nbPoints; ++i)
+  {
+    EXPECT_MATRIX_NEAR(cam.project(pose, pts3d.col(i), true), pts2d.col(i), epsilon);
+    EXPECT_MATRIX_NEAR(cam.get_d_pixel(ptsImage.col(i)), ptsDisto.col(i), epsilon);
+    EXPECT_MATRIX_NEAR(cam.get_ud_pixel(ptsImage.col(i)), ptsUndisto.col(i), epsilon);
+  }
+}
+
+} // namespace camera
+} // namespace aliceVision
@@ -12,6 +12,7 @@
 #include <boost/test/unit_test.hpp>
 #include <boost/test/tools/floating_point_comparison.hpp>
 #include <aliceVision/unitTest.hpp>
+#include <aliceVision/camera/intrinsicsBatchTest.hpp>
 
 using namespace aliceVision;
 using namespace aliceVision::camera;
@@ -53,3 +54,17 @@ BOOST_AUTO_TEST_CASE(cameraPinholeFisheye_disto_undisto_Fisheye)
     EXPECT_MATRIX_NEAR(ptImage_gt, pt2d_proj, epsilon);
   }
 }
+
+//-----------------
+// Test summary:
+//-----------------
+// - Create a PinholeFisheye
+// - Generate random points inside the image domain
+// - Assert that the batched projection and (un)distortion give the same result as the per-point versions
+//-----------------
+BOOST_AUTO_TEST_CASE(cameraPinholeFisheye_batched_Fisheye)
+{
+  const PinholeFisheye cam(1000, 800, 1000, 500, 400, -0.054, 0.014, 0.006, 0.011);
+
+  checkBatchedIntrinsic(cam);
+}
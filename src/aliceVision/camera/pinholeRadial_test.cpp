@@ -12,6 +12,7 @@
 #include <boost/test/unit_test.hpp>
 #include <boost/test/tools/floating_point_comparison.hpp>
 #include <aliceVision/unitTest.hpp>
+#include <aliceVision/camera/intrinsicsBatchTest.hpp>
 
 using namespace aliceVision;
 using namespace aliceVision::camera;
@@ -98,3 +99,17 @@ BOOST_AUTO_TEST_CASE(cameraPinholeRadial_disto_undisto_K3)
 
   }
 }
+
+//-----------------
+// Test summary:
+//-----------------
+// - Create a PinholeRadialK3 camera
+// - Generate random points inside the image domain
+// - Assert that the batched projection and (un)distortion give the same result as the per-point versions
+//-----------------
+BOOST_AUTO_TEST_CASE(cameraPinholeRadial_batched_K3)
+{
+  const PinholeRadialK3 cam(1000, 800, 1000, 500, 400, -0.245539, 0.255195, 0.163773);
+
+  checkBatchedIntrinsic(cam);
+}
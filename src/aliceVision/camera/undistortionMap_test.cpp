@@ -0,0 +1,175 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/camera/camera.hpp>
+
+#define BOOST_TEST_MODULE undistortionMap
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/tools/floating_point_comparison.hpp>
+#include <aliceVision/unitTest.hpp>
+
+#include <boost/filesystem.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::camera;
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+image::Image<float> createSmoothImage(int width, int height)
+{
+  image::Image<float> img(width, height);
+  for(int j = 0; j < height; ++j)
+    for(int i = 0; i < width; ++i)
+      img(j, i) = 100.f + 50.f * std::sin(i * 0.05f) * std::cos(j * 0.03f);
+  return img;
+}
+
+} // namespace
+
+//-----------------
+// Test summary:
+//-----------------
+// - Create a PinholeRadialK3 camera and a smooth image
+// - Undistort the image with UndistortImage and with an UndistortionMap
+// - Assert that both give the same valid pixels, and close values where the source pixel is inside the image
+//   (on the border band, Sampler2d falls back to the nearest pixel while the map keeps interpolating)
+//-----------------
+BOOST_AUTO_TEST_CASE(undistortionMap_sameAsUndistortImage)
+{
+  const int w = 320;
+  const int h = 240;
+  const PinholeRadialK3 cam(w, h, 300, 165, 118, 0.245539, 0.055195, 0.013773);
+  const image::Image<float> img = createSmoothImage(w, h);
+
+  for(bool correctPrincipalPoint : {false, true})
+  {
+    image::Image<float> imgRef, imgMap;
+    UndistortImage(img, &cam, imgRef, -1.f, correctPrincipalPoint);
+
+    const UndistortionMap map(cam, w, h, correctPrincipalPoint);
+    UndistortImage(img, map, imgMap, -1.f);
+
+    const Vec2 ppCorrection = correctPrincipalPoint ? Vec2(cam.getPrincipalPoint() - Vec2(w * 0.5, h * 0.5)) : Vec2(0.0, 0.0);
+
+    BOOST_CHECK_EQUAL(imgMap.Width(), w);
+    BOOST_CHECK_EQUAL(imgMap.Height(), h);
+
+    int nbInvalid = 0;
+    for(int j = 0; j < h; ++j)
+    {
+      for(int i = 0; i < w; ++i)
+      {
+        BOOST_CHECK_EQUAL(imgRef(j, i) == -1.f, imgMap(j, i) == -1.f);
+
+        const Vec2 source = cam.get_d_pixel(Vec2(i, j)) + ppCorrection;
+        if(source(0) >= 0.0 && source(0) <= w - 1 && source(1) >= 0.0 && source(1) <= h - 1)
+          BOOST_CHECK_SMALL(imgRef(j, i) - imgMap(j, i), 0.1f);
+        nbInvalid += (imgMap(j, i) == -1.f);
+      }
+    }
+    // the distortion is strong enough to leave pixels without source
+    BOOST_CHECK(nbInvalid > 0);
+  }
+}
+
+//-----------------
+// Test summary:
+//-----------------
+// - Save and reload an UndistortionMap
+// - Assert that the cache returns the same map for identical intrinsics and reuses the saved file
+//-----------------
+BOOST_AUTO_TEST_CASE(undistortionMap_saveLoadCache)
+{
+  const int w = 200;
+  const int h = 100;
+  const PinholeFisheye cam(w, h, 150, 100, 50, -0.054, 0.014, 0.006, 0.011);
+  const UndistortionMap map(cam, w, h);
+
+  const fs::path folder = fs::temp_directory_path() / fs::unique_path();
+  fs::create_directories(folder);
+  const std::string file = (folder / "map.bin").string();
+
+  map.save(file);
+  UndistortionMap loaded;
+  loaded.load(file);
+
+  BOOST_CHECK_EQUAL(loaded.key(), map.key());
+  BOOST_CHECK_EQUAL(loaded.width(), w);
+  BOOST_CHECK_EQUAL(loaded.height(), h);
+  BOOST_CHECK(std::memcmp(loaded.entries().data(), map.entries().data(), map.entries().size() * sizeof(UndistortionMap::Entry)) == 0);
+
+  {
+    UndistortionMapCache cache(folder.string());
+    const PinholeFisheye sameCam(cam);
+    const auto map1 = cache.get(cam, w, h);
+    const auto map2 = cache.get(sameCam, w, h);
+    const auto map3 = cache.get(cam, w, h, true);
+    BOOST_CHECK(map1 == map2);
+    BOOST_CHECK(map1 != map3);
+    BOOST_CHECK_EQUAL(map1->key(), map.key());
+  }
+  {
+    // a new cache reloads the maps saved in the folder
+    UndistortionMapCache cache(folder.string());
+    const auto map1 = cache.get(cam, w, h);
+    BOOST_CHECK(std::memcmp(map1->entries().data(), map.entries().data(), map.entries().size() * sizeof(UndistortionMap::Entry)) == 0);
+  }
+
+  fs::remove_all(folder);
+}
+
+//-----------------
+// Test summary:
+//-----------------
+// - Fill a cache with a budget of one map
+// - Assert that the least recently used map is released and rebuilt on the next use
+// - Assert that a saved map of another intrinsic is not reused, even under the expected file name
+//-----------------
+BOOST_AUTO_TEST_CASE(undistortionMap_cacheBudget)
+{
+  const int w = 200;
+  const int h = 100;
+  const PinholeFisheye cam1(w, h, 150, 100, 50, -0.054, 0.014, 0.006, 0.011);
+  const PinholeFisheye cam2(w, h, 160, 100, 50, -0.054, 0.014, 0.006, 0.011);
+  const std::size_t mapBytes = std::size_t(w) * h * sizeof(UndistortionMap::Entry);
+
+  {
+    UndistortionMapCache cache("", mapBytes);
+    const auto map1 = cache.get(cam1, w, h);
+    BOOST_CHECK_EQUAL(map1->byteSize(), mapBytes);
+    BOOST_CHECK(cache.get(cam1, w, h) == map1);
+
+    const auto map2 = cache.get(cam2, w, h);
+    BOOST_CHECK_EQUAL(cache.byteSize(), mapBytes);
+    BOOST_CHECK(cache.get(cam2, w, h) == map2);
+
+    // map1 has been released, it is built again
+    const auto map1Rebuilt = cache.get(cam1, w, h);
+    BOOST_CHECK(map1Rebuilt != map1);
+    BOOST_CHECK(std::memcmp(map1Rebuilt->entries().data(), map1->entries().data(), mapBytes) == 0);
+    BOOST_CHECK_EQUAL(cache.byteSize(), mapBytes);
+  }
+
+  const fs::path folder = fs::temp_directory_path() / fs::unique_path();
+  fs::create_directories(folder);
+  {
+    // save the map of cam2 under the file name of cam1
+    const UndistortionMap map1(cam1, w, h);
+    const UndistortionMap map2(cam2, w, h);
+    std::ostringstream os;
+    os << folder.string() << "/undistortionMap_" << std::hex << map1.key() << ".bin";
+    map2.save(os.str());
+
+    UndistortionMapCache cache(folder.string());
+    const auto map = cache.get(cam1, w, h);
+    BOOST_CHECK(map->source() == map1.source());
+    BOOST_CHECK(std::memcmp(map->entries().data(), map1.entries().data(), mapBytes) == 0);
+  }
+  fs::remove_all(folder);
+}
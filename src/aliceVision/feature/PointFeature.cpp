@@ -0,0 +1,190 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "PointFeature.hpp"
+
+#include <aliceVision/system/MemoryMappedFile.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace aliceVision {
+namespace feature {
+
+constexpr char FeatsBinHeader::magic[8];
+constexpr std::uint32_t FeatsBinHeader::currentVersion;
+constexpr std::uint32_t FeatsBinHeader::byteOrderMark;
+
+namespace {
+
+template<typename T>
+inline T byteSwap(T value)
+{
+  char* bytes = reinterpret_cast<char*>(&value);
+  std::reverse(bytes, bytes + sizeof(T));
+  return value;
+}
+
+/**
+ * @brief Check the header read from a binary features file.
+ * @param[in,out] header The header, converted to the native endianness
+ * @param[in] sfileNameFeats The features file path (for error messages)
+ */
+void checkFeatsBinHeader(FeatsBinHeader& header, const std::string& sfileNameFeats)
+{
+  if(std::memcmp(header.fileMagic, FeatsBinHeader::magic, sizeof(FeatsBinHeader::magic)) != 0)
+    throw std::runtime_error("Can't load features file, '" + sfileNameFeats + "' is not a binary features file !");
+
+  if(header.isByteSwapped())
+  {
+    if(byteSwap(header.fileByteOrderMark) != FeatsBinHeader::byteOrderMark)
+      throw std::runtime_error("Can't load features file, '" + sfileNameFeats + "' has an invalid byte order mark !");
+
+    header.version = byteSwap(header.version);
+    header.featureCount = byteSwap(header.featureCount);
+    header.featureSize = byteSwap(header.featureSize);
+  }
+
+  if(header.version > FeatsBinHeader::currentVersion)
+    throw std::runtime_error("Can't load features file, '" + sfileNameFeats + "' has an unsupported version (" + std::to_string(header.version) + ") !");
+
+  if(header.featureSize < 4 * sizeof(float))
+    throw std::runtime_error("Can't load features file, '" + sfileNameFeats + "' has an invalid feature size !");
+}
+
+} // namespace
+
+FeatsBinHeader::FeatsBinHeader()
+{
+  std::memcpy(fileMagic, magic, sizeof(magic));
+  std::memset(describerType, 0, sizeof(describerType));
+}
+
+void FeatsBinHeader::setDescriberType(const std::string& name)
+{
+  std::memset(describerType, 0, sizeof(describerType));
+  std::memcpy(describerType, name.c_str(), std::min(name.size(), sizeof(describerType) - 1));
+}
+
+std::string FeatsBinHeader::getDescriberType() const
+{
+  return std::string(describerType, strnlen(describerType, sizeof(describerType)));
+}
+
+bool isFeatsBinFile(const std::string& sfileNameFeats)
+{
+  std::ifstream fileIn(sfileNameFeats, std::ios::in | std::ios::binary);
+
+  if(!fileIn.is_open())
+    throw std::runtime_error("Can't load features file, can't open '" + sfileNameFeats + "' !");
+
+  char fileMagic[sizeof(FeatsBinHeader::magic)];
+  fileIn.read(fileMagic, sizeof(fileMagic));
+
+  return (fileIn.gcount() == sizeof(fileMagic)) &&
+         (std::memcmp(fileMagic, FeatsBinHeader::magic, sizeof(fileMagic)) == 0);
+}
+
+FeatsBinHeader readFeatsBinHeader(const std::string& sfileNameFeats)
+{
+  std::ifstream fileIn(sfileNameFeats, std::ios::in | std::ios::binary);
+
+  if(!fileIn.is_open())
+    throw std::runtime_error("Can't load features file, can't open '" + sfileNameFeats + "' !");
+
+  FeatsBinHeader header;
+  fileIn.read(reinterpret_cast<char*>(&header), sizeof(FeatsBinHeader));
+
+  if(fileIn.gcount() != sizeof(FeatsBinHeader))
+    throw std::runtime_error("Can't load features file, '" + sfileNameFeats + "' is incorrect !");
+
+  checkFeatsBinHeader(header, sfileNameFeats);
+  return header;
+}
+
+void loadFeatsFromBinFile(const std::string& sfileNameFeats, PointFeatures& vec_feat)
+{
+  vec_feat.clear();
+
+  const system::MemoryMappedFile file(sfileNameFeats);
+
+  if(file.size() < sizeof(FeatsBinHeader))
+    throw std::runtime_error("Can't load features file, '" + sfileNameFeats + "' is incorrect !");
+
+  FeatsBinHeader header;
+  std::memcpy(&header, file.data(), sizeof(FeatsBinHeader));
+  checkFeatsBinHeader(header, sfileNameFeats);
+
+  // featureCount * featureSize may overflow on a corrupted header
+  if(header.featureCount > (file.size() - sizeof(FeatsBinHeader)) / header.featureSize)
+    throw std::runtime_error("Can't load features file, '" + sfileNameFeats + "' is truncated !");
+
+  const char* records = file.data() + sizeof(FeatsBinHeader);
+  const bool byteSwapped = header.isByteSwapped();
+
+  vec_feat.resize(header.featureCount);
+
+  for(std::size_t i = 0; i < vec_feat.size(); ++i)
+  {
+    float values[4];
+    std::memcpy(values, records + i * header.featureSize, sizeof(values));
+
+    if(byteSwapped)
+    {
+      for(float& value : values)
+        value = byteSwap(value);
+    }
+
+    vec_feat[i] = PointFeature(values[0], values[1], values[2], values[3]);
+  }
+}
+
+void saveFeatsToBinFile(const std::string& sfileNameFeats, const PointFeatures& vec_feat, const std::string& describerType)
+{
+  std::ofstream file(sfileNameFeats, std::ios::out | std::ios::binary);
+
+  if(!file.is_open())
+    throw std::runtime_error("Can't save features file, can't open '" + sfileNameFeats + "' !");
+
+  FeatsBinHeader header;
+  header.featureCount = vec_feat.size();
+  header.setDescriberType(describerType);
+
+  file.write(reinterpret_cast<const char*>(&header), sizeof(FeatsBinHeader));
+
+  std::vector<float> records(4 * vec_feat.size());
+  for(std::size_t i = 0; i < vec_feat.size(); ++i)
+  {
+    const PointFeature& feat = vec_feat[i];
+    records[4 * i + 0] = feat.x();
+    records[4 * i + 1] = feat.y();
+    records[4 * i + 2] = feat.scale();
+    records[4 * i + 3] = feat.orientation();
+  }
+
+  file.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(float));
+
+  if(!file.good())
+    throw std::runtime_error("Can't save features file, '" + sfileNameFeats + "' is incorrect !");
+
+  file.close();
+}
+
+void loadFeatsFromFile(const std::string& sfileNameFeats, PointFeatures& vec_feat)
+{
+  if(isFeatsBinFile(sfileNameFeats))
+    loadFeatsFromBinFile(sfileNameFeats, vec_feat);
+  else
+    loadFeatsFromTextFile(sfileNameFeats, vec_feat);
+}
+
+void saveFeatsToFile(const std::string& sfileNameFeats, const PointFeatures& vec_feat)
+{
+  saveFeatsToBinFile(sfileNameFeats, vec_feat);
+}
+
+} // namespace feature
+} // namespace aliceVision
@@ -8,6 +8,7 @@
 #pragma once
 
 #include "aliceVision/numeric/numeric.hpp"
+#include <cstdint>
 #include <iostream>
 #include <iterator>
 #include <fstream>
@@ -94,9 +95,9 @@ inline std::istream& operator>>(std::istream& in, PointFeature& obj)
   return in >> obj._coords(0) >> obj._coords(1) >> obj._scale >> obj._orientation;
 }
 
-/// Read feats from file
+/// Read feats from an ASCII file (legacy .feat format)
 template<typename FeaturesT >
-inline void loadFeatsFromFile(
+inline void loadFeatsFromTextFile(
   const std::string & sfileNameFeats,
   FeaturesT & vec_feat)
 {
@@ -116,11 +117,11 @@ inline void loadFeatsFromFile(
   fileIn.close();
 }
 
-/// Write feats to file
+/// Write feats to an ASCII file (legacy .feat format)
 template<typename FeaturesT >
-inline void saveFeatsToFile(
+inline void saveFeatsToTextFile(
   const std::string & sfileNameFeats,
-  FeaturesT & vec_feat)
+  const FeaturesT & vec_feat)
 {
   std::ofstream file(sfileNameFeats.c_str());
 
@@ -135,6 +136,122 @@ inline void saveFeatsToFile(
   file.close();
 }
 
+/**
+ * @brief Header of the binary features file (.feat).
+ *
+ * The header is followed by featureCount records of featureSize bytes,
+ * each record stores 4 float32: x, y, scale, orientation.
+ * The records start at a 16-bytes aligned offset to be directly usable from a memory mapping.
+ */
+struct FeatsBinHeader
+{
+  /// magic number to identify a binary features file
+  static constexpr char magic[8] = {'A', 'V', 'F', 'E', 'A', 'T', '\0', '\0'};
+  /// current version of the binary features file
+  static constexpr std::uint32_t currentVersion = 1;
+  /// byte order mark, read as swapped if the file was written on a machine with a different endianness
+  static constexpr std::uint32_t byteOrderMark = 0x01020304;
+
+  char fileMagic[8];
+  std::uint32_t version = currentVersion;
+  std::uint32_t fileByteOrderMark = byteOrderMark;
+  std::uint64_t featureCount = 0;
+  std::uint32_t featureSize = 4 * sizeof(float);
+  std::uint32_t reserved = 0;
+  /// image describer type name (could be empty)
+  char describerType[32];
+
+  FeatsBinHeader();
+
+  /**
+   * @brief Set the image describer type name.
+   * @param[in] name The image describer type name (truncated to 31 characters)
+   */
+  void setDescriberType(const std::string& name);
+
+  /**
+   * @brief Get the image describer type name.
+   * @return the image describer type name or an empty string if not specified
+   */
+  std::string getDescriberType() const;
+
+  /**
+   * @brief Does the header has been written with a different endianness.
+   */
+  bool isByteSwapped() const { return fileByteOrderMark != byteOrderMark; }
+};
+
+static_assert(sizeof(FeatsBinHeader) == 64, "The binary features file header should be 64 bytes long.");
+
+/**
+ * @brief Check if the given file is a binary features file.
+ * @param[in] sfileNameFeats The features file path
+ * @return true if the file starts with the binary features file magic number
+ */
+bool isFeatsBinFile(const std::string& sfileNameFeats);
+
+/**
+ * @brief Read the header of a binary features file.
+ * @param[in] sfileNameFeats The features file path
+ * @return the header (count and version are converted to the native endianness)
+ */
+FeatsBinHeader readFeatsBinHeader(const std::string& sfileNameFeats);
+
+/**
+ * @brief Read feats from a binary features file.
+ *        The file is memory mapped and the records are decoded in a single pass,
+ *        no text parsing is involved.
+ * @param[in] sfileNameFeats The features file path
+ * @param[out] vec_feat The loaded features
+ */
+void loadFeatsFromBinFile(const std::string& sfileNameFeats, PointFeatures& vec_feat);
+
+/**
+ * @brief Write feats to a binary features file.
+ * @param[in] sfileNameFeats The features file path
+ * @param[in] vec_feat The features to write
+ * @param[in] describerType The image describer type name stored in the header (optional)
+ */
+void saveFeatsToBinFile(const std::string& sfileNameFeats, const PointFeatures& vec_feat, const std::string& describerType = "");
+
+/**
+ * @brief Read feats from file.
+ *        Binary and legacy ASCII features files are both supported.
+ * @param[in] sfileNameFeats The features file path
+ * @param[out] vec_feat The loaded features
+ */
+void loadFeatsFromFile(const std::string& sfileNameFeats, PointFeatures& vec_feat);
+
+/**
+ * @brief Write feats to file (binary format).
+ * @param[in] sfileNameFeats The features file path
+ * @param[in] vec_feat The features to write
+ */
+void saveFeatsToFile(const std::string& sfileNameFeats, const PointFeatures& vec_feat);
+
+/**
+ * @brief Read feats from file, for the containers other than PointFeatures.
+ *        The binary format only stores PointFeature records: the legacy ASCII format is used.
+ * @param[in] sfileNameFeats The features file path
+ * @param[out] vec_feat The loaded features
+ */
+template<typename FeaturesT>
+inline void loadFeatsFromFile(const std::string& sfileNameFeats, FeaturesT& vec_feat)
+{
+  loadFeatsFromTextFile(sfileNameFeats, vec_feat);
+}
+
+/**
+ * @brief Write feats to file, for the containers other than PointFeatures (legacy ASCII format).
+ * @param[in] sfileNameFeats The features file path
+ * @param[in] vec_feat The features to write
+ */
+template<typename FeaturesT>
+inline void saveFeatsToFile(const std::string& sfileNameFeats, const FeaturesT& vec_feat)
+{
+  saveFeatsToTextFile(sfileNameFeats, vec_feat);
+}
+
 /// Export point feature based vector to a matrix [(x,y)'T, (x,y)'T]
 template< typename FeaturesT, typename MatT >
 void PointsToMat(
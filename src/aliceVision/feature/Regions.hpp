@@ -12,9 +12,12 @@
 #include <aliceVision/feature/PointFeature.hpp>
 #include <aliceVision/feature/Descriptor.hpp>
 #include <aliceVision/feature/metric.hpp>
+#include <aliceVision/system/MemoryMappedFile.hpp>
 
 #include <string>
 #include <cstddef>
+#include <cstring>
+#include <stdexcept>
 #include <typeinfo>
 #include <memory>
 
@@ -87,6 +90,22 @@ public:
     const std::string& sfileNameFeats,
     const std::string& sfileNameDescs) = 0;
 
+  /**
+   * @brief Load the region features and map the region descriptors file (read-only).
+   *        Descriptors are not copied in memory, they are paged in on demand by the OS
+   *        and are only accessible through DescriptorRawData().
+   * @param[in] sfileNameFeats The features file path
+   * @param[in] sfileNameDescs The binary descriptors file path
+   */
+  virtual void LoadMapped(
+    const std::string& sfileNameFeats,
+    const std::string& sfileNameDescs) = 0;
+
+  /**
+   * @brief Are the region descriptors a read-only view over a mapped file.
+   */
+  virtual bool isDescriptorsMapped() const = 0;
+
   virtual void Save(
     const std::string& sfileNameFeats,
     const std::string& sfileNameDescs) const = 0;
@@ -107,6 +126,7 @@ public:
    * @brief Return a blind pointer to the container of the descriptors array.
    *
    * @note: Descriptors are always stored as an std::vector<DescType>.
+   * @warning Not available if the descriptors are memory mapped.
    */
   virtual const void* blindDescriptors() const = 0;
 
@@ -172,8 +192,42 @@ public:
   /// Container for multiple regions description
   typedef std::vector<DescriptorT> DescsT;
 
+  static_assert(sizeof(DescriptorT) == L * sizeof(T), "Descriptors should be stored as a flat array to be memory mapped.");
+
 protected:
   std::vector<DescriptorT> _vec_descs; // region descriptions
+  std::shared_ptr<system::MemoryMappedFile> _descsFile; // memory mapped region descriptions file (optional, shared between copies)
+  const DescriptorT* _mappedDescs = nullptr; // region descriptions in the mapped file
+  std::size_t _mappedDescsCount = 0;
+
+  /// Non-mutable pointer on the first region description (in memory or mapped)
+  inline const DescriptorT* descriptorsData() const
+  {
+    return (_descsFile ? _mappedDescs : _vec_descs.data());
+  }
+
+  /// Number of region descriptions (in memory or mapped)
+  inline std::size_t descriptorsCount() const
+  {
+    return (_descsFile ? _mappedDescsCount : _vec_descs.size());
+  }
+
+  /// Release the mapped region descriptions file
+  inline void unmapDescriptors()
+  {
+    _descsFile.reset();
+    _mappedDescs = nullptr;
+    _mappedDescsCount = 0;
+  }
+
+  /// Copy the mapped region descriptions in memory and release the mapped file
+  inline void copyMappedDescriptors()
+  {
+    if(!_descsFile)
+      return;
+    _vec_descs.assign(_mappedDescs, _mappedDescs + _mappedDescsCount);
+    unmapDescriptors();
+  }
 
 public:
   std::string Type_id() const override {return typeid(T).name();}
@@ -192,50 +246,118 @@ public:
     const std::string& sfileNameFeats,
     const std::string& sfileNameDescs) override
   {
+    unmapDescriptors();
     loadFeatsFromFile(sfileNameFeats, this->_vec_feats);
     loadDescsFromBinFile(sfileNameDescs, _vec_descs);
   }
 
+  /// Read from files the regions and map their corresponding descriptors (read-only).
+  void LoadMapped(
+    const std::string& sfileNameFeats,
+    const std::string& sfileNameDescs) override
+  {
+    loadFeatsFromFile(sfileNameFeats, this->_vec_feats);
+
+    _vec_descs.clear();
+    _vec_descs.shrink_to_fit();
+    unmapDescriptors();
+
+    // binary descriptors file: number of descriptors followed by the flat array of descriptors
+    std::shared_ptr<system::MemoryMappedFile> descsFile = std::make_shared<system::MemoryMappedFile>(sfileNameDescs);
+
+    if(descsFile->size() < sizeof(std::size_t))
+      throw std::runtime_error("Can't load descriptor binary file, '" + sfileNameDescs + "' is incorrect !");
+
+    std::size_t cardDesc = 0;
+    std::memcpy(&cardDesc, descsFile->data(), sizeof(std::size_t));
+
+    // cardDesc comes from the file: check the size without overflow
+    if((descsFile->size() - sizeof(std::size_t)) / sizeof(DescriptorT) < cardDesc)
+      throw std::runtime_error("Can't load descriptor binary file, '" + sfileNameDescs + "' is truncated !");
+
+    _descsFile = descsFile;
+    _mappedDescs = reinterpret_cast<const DescriptorT*>(_descsFile->data() + sizeof(std::size_t));
+    _mappedDescsCount = cardDesc;
+  }
+
+  bool isDescriptorsMapped() const override { return _descsFile != nullptr; }
+
   /// Export in two separate files the regions and their corresponding descriptors.
   void Save(
     const std::string& sfileNameFeats,
     const std::string& sfileNameDescs) const override
   {
     saveFeatsToFile(sfileNameFeats, this->_vec_feats);
-    saveDescsToBinFile(sfileNameDescs, _vec_descs);
+    SaveDesc(sfileNameDescs);
   }
 
   void SaveDesc(const std::string& sfileNameDescs) const override
   {
+    if(_descsFile)
+      throw std::runtime_error("Can't save descriptor binary file '" + sfileNameDescs + "', descriptors are memory mapped !");
     saveDescsToBinFile(sfileNameDescs, _vec_descs);
   }
 
-  /// Mutable and non-mutable DescriptorT getters.
-  inline std::vector<DescriptorT> & Descriptors() { return _vec_descs; }
-  inline const std::vector<DescriptorT> & Descriptors() const { return _vec_descs; }
+  /**
+   * @brief Mutable DescriptorT getter.
+   * @note If the descriptors are memory mapped, they are first copied in memory.
+   */
+  inline std::vector<DescriptorT> & Descriptors()
+  {
+    copyMappedDescriptors();
+    return _vec_descs;
+  }
+
+  /**
+   * @brief Non-mutable DescriptorT getter.
+   * @warning Not available if the descriptors are memory mapped, use DescriptorRawData().
+   */
+  inline const std::vector<DescriptorT> & Descriptors() const
+  {
+    if(_descsFile)
+      throw std::logic_error("Descriptors are memory mapped, use DescriptorRawData().");
+    return _vec_descs;
+  }
 
-  inline const void* blindDescriptors() const override { return &_vec_descs; }
+  /**
+   * @brief Non-mutable DescriptorT getter of the i-th region (in memory or mapped).
+   */
+  inline const DescriptorT& GetDescriptor(std::size_t i) const { return descriptorsData()[i]; }
 
-  inline const void* DescriptorRawData() const override { return &_vec_descs[0];}
+  /**
+   * @brief Number of region descriptors (in memory or mapped).
+   */
+  inline std::size_t DescriptorCount() const { return descriptorsCount(); }
+
+  inline const void* blindDescriptors() const override { return &Descriptors(); }
 
-  inline void clearDescriptors() override { _vec_descs.clear(); }
+  inline const void* DescriptorRawData() const override { return descriptorsData(); }
+
+  inline void clearDescriptors() override
+  {
+    _vec_descs.clear();
+    unmapDescriptors();
+  }
 
   inline void swap(This& other)
   {
     this->_vec_feats.swap(other._vec_feats);
     _vec_descs.swap(other._vec_descs);
+    std::swap(_descsFile, other._descsFile);
+    std::swap(_mappedDescs, other._mappedDescs);
+    std::swap(_mappedDescsCount, other._mappedDescsCount);
   }
 
   // Return the distance between two descriptors
   double SquaredDescriptorDistance(std::size_t i, const Regions * genericRegions, std::size_t j) const override
   {
-    assert(i < this->_vec_descs.size());
+    assert(i < this->descriptorsCount());
     assert(genericRegions);
     assert(j < genericRegions->RegionCount());
 
     const This * regionsT = dynamic_cast<const This*>(genericRegions);
     static typename SquaredMetric<T, regionType>::Metric metric;
-    return metric(this->_vec_descs[i].getData(), regionsT->_vec_descs[j].getData(), DescriptorT::static_size);
+    return metric(this->descriptorsData()[i].getData(), regionsT->descriptorsData()[j].getData(), DescriptorT::static_size);
   }
 
   /**
@@ -245,9 +367,9 @@ public:
    */
   void CopyRegion(std::size_t i, Regions * outRegionContainer) const override
   {
-    assert(i < this->_vec_feats.size() && i < this->_vec_descs.size());
+    assert(i < this->_vec_feats.size() && i < this->descriptorsCount());
     static_cast<This*>(outRegionContainer)->_vec_feats.push_back(this->_vec_feats[i]);
-    static_cast<This*>(outRegionContainer)->_vec_descs.push_back(this->_vec_descs[i]);
+    static_cast<This*>(outRegionContainer)->Descriptors().push_back(this->descriptorsData()[i]);
   }
 
   /**
@@ -273,7 +395,7 @@ public:
     {
       const FeatureInImage & feat = featuresInImage[i];
       regionsPtr->Features().push_back(this->_vec_feats[feat._featureIndex]);
-      regionsPtr->Descriptors().push_back(this->_vec_descs[feat._featureIndex]);
+      regionsPtr->Descriptors().push_back(this->descriptorsData()[feat._featureIndex]);
 
       // This assert should be valid in theory, but in the context of CameraLocalization
       // we can have the same 2D feature associated to different 3D points (2 in practice).
@@ -7,6 +7,7 @@
 
 #include "aliceVision/feature/feature.hpp"
 
+#include <deque>
 #include <iostream>
 #include <fstream>
 #include <iterator>
@@ -56,7 +57,8 @@ BOOST_AUTO_TEST_CASE(featureIO_ASCII) {
   }
 
   //Save them to a file
-  BOOST_CHECK_NO_THROW(saveFeatsToFile("tempFeats.feat", vec_feats));
+  BOOST_CHECK_NO_THROW(saveFeatsToTextFile("tempFeats.feat", vec_feats));
+  BOOST_CHECK(!isFeatsBinFile("tempFeats.feat"));
 
   //Read the saved data and compare to input (to check write/read IO)
   Feats_T vec_feats_read;
@@ -71,6 +73,72 @@ BOOST_AUTO_TEST_CASE(featureIO_ASCII) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(featureIO_BINARY) {
+  Feats_T vec_feats;
+  for(int i = 0; i < CARD; ++i)  {
+    vec_feats.push_back(Feature_T(i + 0.1f, i*2 + 0.2f, i*3 + 0.3f, i*4 + 0.4f));
+  }
+
+  //Save them to a file
+  BOOST_CHECK_NO_THROW(saveFeatsToBinFile("tempFeatsBin.feat", vec_feats, "sift"));
+  BOOST_CHECK(isFeatsBinFile("tempFeatsBin.feat"));
+
+  const FeatsBinHeader header = readFeatsBinHeader("tempFeatsBin.feat");
+  BOOST_CHECK_EQUAL(CARD, header.featureCount);
+  BOOST_CHECK_EQUAL(FeatsBinHeader::currentVersion, header.version);
+  BOOST_CHECK_EQUAL("sift", header.getDescriberType());
+  BOOST_CHECK(!header.isByteSwapped());
+
+  //Read the saved data and compare to input (to check write/read IO)
+  Feats_T vec_feats_read;
+  BOOST_CHECK_NO_THROW(loadFeatsFromFile("tempFeatsBin.feat", vec_feats_read));
+  BOOST_CHECK_EQUAL(CARD, vec_feats_read.size());
+
+  for(int i = 0; i < CARD; ++i) {
+    BOOST_CHECK_EQUAL(vec_feats[i], vec_feats_read[i]);
+  }
+
+  //A corrupted feature count (featureCount * featureSize overflows) is detected
+  {
+    FeatsBinHeader corruptedHeader = header;
+    corruptedHeader.featureCount = std::uint64_t(1) << 60;
+    std::fstream file("tempFeatsBin.feat", std::ios::in | std::ios::out | std::ios::binary);
+    file.write(reinterpret_cast<const char*>(&corruptedHeader), sizeof(FeatsBinHeader));
+  }
+  BOOST_CHECK_THROW(loadFeatsFromFile("tempFeatsBin.feat", vec_feats_read), std::runtime_error);
+
+  //An empty features file is valid
+  Feats_T vec_feats_empty;
+  BOOST_CHECK_NO_THROW(saveFeatsToFile("tempFeatsEmpty.feat", vec_feats_empty));
+  BOOST_CHECK_NO_THROW(loadFeatsFromFile("tempFeatsEmpty.feat", vec_feats_read));
+  BOOST_CHECK(vec_feats_read.empty());
+}
+
+BOOST_AUTO_TEST_CASE(featureIO_KeypointSet) {
+  // features stored in a container other than PointFeatures use the ASCII format
+  typedef std::deque<Feature_T> DequeFeats_T;
+  KeypointSet<DequeFeats_T, Descs_T> kpSet;
+  for(int i = 0; i < CARD; ++i)  {
+    kpSet.features().push_back(Feature_T(i, i*2, i*3, i*4));
+    Desc_T desc;
+    for (int j = 0; j < DESC_LENGTH; ++j)
+      desc[j] = i*DESC_LENGTH+j;
+    kpSet.descriptors().push_back(desc);
+  }
+
+  BOOST_CHECK_NO_THROW(kpSet.saveToBinFile("tempKpSet.feat", "tempKpSet.desc"));
+  BOOST_CHECK(!isFeatsBinFile("tempKpSet.feat"));
+
+  KeypointSet<DequeFeats_T, Descs_T> kpSetRead;
+  BOOST_CHECK_NO_THROW(kpSetRead.loadFromBinFile("tempKpSet.feat", "tempKpSet.desc"));
+  BOOST_CHECK_EQUAL(CARD, kpSetRead.features().size());
+  BOOST_CHECK_EQUAL(CARD, kpSetRead.descriptors().size());
+
+  for(int i = 0; i < CARD; ++i) {
+    BOOST_CHECK_EQUAL(kpSet.features()[i], kpSetRead.features()[i]);
+  }
+}
+
 //--
 //-- Descriptors interface test
 //--
@@ -123,3 +191,55 @@ BOOST_AUTO_TEST_CASE(descriptorIO_BINARY) {
       BOOST_CHECK_EQUAL(vec_descs[i][j], vec_descs_read[i][j]);
   }
 }
+
+//Test memory mapped regions descriptors
+BOOST_AUTO_TEST_CASE(regionsIO_MAPPED) {
+  typedef ScalarRegions<float, DESC_LENGTH> Regions_T;
+
+  Regions_T regions;
+  for(int i = 0; i < CARD; ++i)
+  {
+    regions.Features().push_back(Feature_T(i, i*2, i*3, i*4));
+    Desc_T desc;
+    for (int j = 0; j < DESC_LENGTH; ++j)
+      desc[j] = i*DESC_LENGTH+j;
+    regions.Descriptors().push_back(desc);
+  }
+
+  BOOST_CHECK_NO_THROW(regions.Save("tempRegions.feat", "tempRegions.desc"));
+
+  Regions_T regions_mapped;
+  BOOST_CHECK_NO_THROW(regions_mapped.LoadMapped("tempRegions.feat", "tempRegions.desc"));
+  BOOST_CHECK(regions_mapped.isDescriptorsMapped());
+  BOOST_CHECK_EQUAL(CARD, regions_mapped.RegionCount());
+
+  const Desc_T* descs_mapped = static_cast<const Desc_T*>(regions_mapped.DescriptorRawData());
+  BOOST_CHECK_EQUAL(CARD, regions_mapped.DescriptorCount());
+  for(int i = 0; i < CARD; ++i) {
+    for (int j = 0; j < DESC_LENGTH; ++j)
+    {
+      BOOST_CHECK_EQUAL(regions.Descriptors()[i][j], descs_mapped[i][j]);
+      BOOST_CHECK_EQUAL(regions.Descriptors()[i][j], regions_mapped.GetDescriptor(i)[j]);
+    }
+    BOOST_CHECK_EQUAL(0.0, regions_mapped.SquaredDescriptorDistance(i, &regions, i));
+  }
+
+  // copy a mapped region in an in-memory container
+  std::unique_ptr<Regions> regions_copy(regions_mapped.EmptyClone());
+  regions_mapped.CopyRegion(CARD - 1, regions_copy.get());
+  BOOST_CHECK(!regions_copy->isDescriptorsMapped());
+  BOOST_CHECK_EQUAL(0.0, regions_copy->SquaredDescriptorDistance(0, &regions, CARD - 1));
+
+  // mutable access copies the descriptors in memory
+  BOOST_CHECK_EQUAL(CARD, regions_mapped.Descriptors().size());
+  BOOST_CHECK(!regions_mapped.isDescriptorsMapped());
+
+  // a corrupted descriptors count (cardDesc * sizeof(DescriptorT) overflows) is detected
+  {
+    const std::size_t corruptedCount = std::size_t(1) << 60;
+    std::fstream file("tempRegions.desc", std::ios::in | std::ios::out | std::ios::binary);
+    file.write(reinterpret_cast<const char*>(&corruptedCount), sizeof(std::size_t));
+  }
+  Regions_T regions_corrupted;
+  BOOST_CHECK_THROW(regions_corrupted.LoadMapped("tempRegions.feat", "tempRegions.desc"), std::runtime_error);
+}
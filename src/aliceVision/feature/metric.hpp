@@ -100,8 +100,9 @@ namespace optim_ss2{
       cumSum = _mm_load_ps( zeros );
       for(int i = 0 ; i < size; i+=4)
       {
-        srcA = _mm_load_ps(b1Pt+i);
-        srcB = _mm_load_ps(b2Pt+i);
+        // unaligned loads: descriptors could be read from a memory mapped file
+        srcA = _mm_loadu_ps(b1Pt+i);
+        srcB = _mm_loadu_ps(b2Pt+i);
         //-- Subtract
         temp = _mm_sub_ps( srcA, srcB );
         //-- Multiply
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <aliceVision/types.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 #include <aliceVision/graph/graph.hpp>
 
 #include <lemon/list_graph.h>
@@ -120,28 +121,96 @@ bool List_Triplets(const GraphT & g, std::vector< Triplet > & vec_triplets)
 }
 
 /// Return triplets contained in the graph build from IterablePairs
+/// The triplets are listed in parallel from a compressed adjacency of the graph:
+/// each triplet (i < j < k) is found once from its edge (i,j), by intersecting
+/// the sorted neighbors of i and j with a greater index.
+/// The triplets are sorted and each triplet is sorted.
 template <typename IterablePairs>
 inline std::vector< graph::Triplet > tripletListing(
   const IterablePairs & pairs)
 {
-  std::vector< graph::Triplet > vec_triplets;
+  // Compact node indexes (in the node ids order)
+  std::vector<IndexT> nodes;
+  for (const auto & pair : pairs)
+  {
+    nodes.push_back(pair.first);
+    nodes.push_back(pair.second);
+  }
+  std::sort(nodes.begin(), nodes.end());
+  nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
 
-  indexedGraph putativeGraph(pairs);
+  const auto nodeIndex = [&nodes](IndexT id)
+  {
+    return static_cast<IndexT>(std::lower_bound(nodes.begin(), nodes.end(), id) - nodes.begin());
+  };
 
-  graph::List_Triplets<indexedGraph::GraphT>(putativeGraph.g, vec_triplets);
+  // Undirected edges from the lower to the greater node index
+  std::vector<std::pair<IndexT, IndexT>> edges;
+  edges.reserve(pairs.size());
+  for (const auto & pair : pairs)
+  {
+    if (pair.first == pair.second)
+      continue;
+    const IndexT I = nodeIndex(pair.first), J = nodeIndex(pair.second);
+    edges.emplace_back(std::min(I, J), std::max(I, J));
+  }
+  std::sort(edges.begin(), edges.end());
+  edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+  // Compressed adjacency: the neighbors of node i with a greater index
+  // are neighbors[offsets[i], offsets[i+1]), sorted
+  std::vector<std::size_t> offsets(nodes.size() + 1, 0);
+  std::vector<IndexT> neighbors(edges.size());
+  for (std::size_t e = 0; e < edges.size(); ++e)
+  {
+    ++offsets[edges[e].first + 1];
+    neighbors[e] = edges[e].second;
+  }
+  for (std::size_t i = 0; i < nodes.size(); ++i)
+    offsets[i + 1] += offsets[i];
+
+  // Triplets found from each node, concatenated in the nodes order
+  std::vector<std::vector<graph::Triplet>> tripletsPerNode(nodes.size());
 
-  //Change triplets to ImageIds
-  for (size_t i = 0; i < vec_triplets.size(); ++i)
+  #pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < static_cast<int>(nodes.size()); ++i)
   {
-    graph::Triplet & triplet = vec_triplets[i];
-    IndexT I = triplet.i, J = triplet.j , K = triplet.k;
-    I = (*putativeGraph.map_nodeMapIndex)[putativeGraph.g.nodeFromId(I)];
-    J = (*putativeGraph.map_nodeMapIndex)[putativeGraph.g.nodeFromId(J)];
-    K = (*putativeGraph.map_nodeMapIndex)[putativeGraph.g.nodeFromId(K)];
-    IndexT triplet_[3] = { I, J, K };
-    std::sort(&triplet_[0], &triplet_[3]);
-    triplet = graph::Triplet(triplet_[0],triplet_[1],triplet_[2]);
+    const IndexT* neighborsI = neighbors.data() + offsets[i];
+    const IndexT* neighborsIEnd = neighbors.data() + offsets[i + 1];
+
+    for (const IndexT* itJ = neighborsI; itJ != neighborsIEnd; ++itJ)
+    {
+      const IndexT j = *itJ;
+      const IndexT* itK = itJ + 1;
+      const IndexT* neighborsJ = neighbors.data() + offsets[j];
+      const IndexT* neighborsJEnd = neighbors.data() + offsets[j + 1];
+
+      // Common neighbors of i and j greater than j
+      while (itK != neighborsIEnd && neighborsJ != neighborsJEnd)
+      {
+        if (*itK < *neighborsJ)
+          ++itK;
+        else if (*neighborsJ < *itK)
+          ++neighborsJ;
+        else
+        {
+          tripletsPerNode[i].emplace_back(nodes[i], nodes[j], nodes[*itK]);
+          ++itK;
+          ++neighborsJ;
+        }
+      }
+    }
   }
+
+  std::size_t nbTriplets = 0;
+  for (const std::vector<graph::Triplet> & triplets : tripletsPerNode)
+    nbTriplets += triplets.size();
+
+  std::vector< graph::Triplet > vec_triplets;
+  vec_triplets.reserve(nbTriplets);
+  for (const std::vector<graph::Triplet> & triplets : tripletsPerNode)
+    vec_triplets.insert(vec_triplets.end(), triplets.begin(), triplets.end());
+
   return vec_triplets;
 }
 
@@ -8,6 +8,9 @@
 #include "aliceVision/graph/Triplet.hpp"
 
 #include <iostream>
+#include <random>
+#include <set>
+#include <tuple>
 #include <vector>
 
 #define BOOST_TEST_MODULE tripletFinder
@@ -15,6 +18,7 @@
 #include <boost/test/unit_test.hpp>
 #include <boost/test/tools/floating_point_comparison.hpp>
 
+using namespace aliceVision;
 using namespace aliceVision::graph;
 
 BOOST_AUTO_TEST_CASE(test_no_triplet) {
@@ -269,3 +273,55 @@ BOOST_AUTO_TEST_CASE(test_for_triplet) {
     BOOST_CHECK_EQUAL(4, vec_triplets.size());
   }
 }
+
+BOOST_AUTO_TEST_CASE(test_tripletListing) {
+
+  // random graph with sparse node ids and some duplicated edges (in both directions)
+  std::mt19937 randomNumberGenerator(0);
+  std::uniform_int_distribution<IndexT> distribution(0, 59);
+
+  std::set<std::pair<IndexT, IndexT>> pairs;
+  for (int e = 0; e < 400; ++e)
+  {
+    const IndexT I = 3 * distribution(randomNumberGenerator) + 10;
+    const IndexT J = 3 * distribution(randomNumberGenerator) + 10;
+    if (I != J)
+      pairs.insert(std::make_pair(I, J));
+  }
+
+  const std::vector< Triplet > vec_triplets = tripletListing(pairs);
+
+  // reference: triplets of the lemon graph, converted to node ids
+  indexedGraph putativeGraph(pairs);
+  std::vector< Triplet > vec_tripletsRef;
+  BOOST_CHECK(List_Triplets(putativeGraph.g, vec_tripletsRef));
+
+  std::set<std::vector<IndexT>> triplets, tripletsRef;
+  for (const Triplet & t : vec_triplets)
+  {
+    BOOST_CHECK(t.i < t.j && t.j < t.k);
+    triplets.insert({t.i, t.j, t.k});
+  }
+  for (const Triplet & t : vec_tripletsRef)
+  {
+    std::vector<IndexT> triplet = {
+      (*putativeGraph.map_nodeMapIndex)[putativeGraph.g.nodeFromId(t.i)],
+      (*putativeGraph.map_nodeMapIndex)[putativeGraph.g.nodeFromId(t.j)],
+      (*putativeGraph.map_nodeMapIndex)[putativeGraph.g.nodeFromId(t.k)]};
+    std::sort(triplet.begin(), triplet.end());
+    tripletsRef.insert(triplet);
+  }
+
+  // each triplet is listed once (the lemon graph lists twice the triplets of edges given in both directions)
+  BOOST_CHECK_EQUAL(triplets.size(), vec_triplets.size());
+  BOOST_CHECK_EQUAL(vec_triplets.size(), tripletsRef.size());
+  BOOST_CHECK(triplets == tripletsRef);
+
+  // triplets are sorted
+  for (std::size_t i = 1; i < vec_triplets.size(); ++i)
+  {
+    const Triplet & a = vec_triplets[i - 1];
+    const Triplet & b = vec_triplets[i];
+    BOOST_CHECK(std::make_tuple(a.i, a.j, a.k) < std::make_tuple(b.i, b.j, b.k));
+  }
+}
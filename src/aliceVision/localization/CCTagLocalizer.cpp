@@ -155,9 +155,9 @@ bool CCTagLocalizer::loadReconstructionDescriptors(const sfmData::SfMData & sfm_
       {
         ss << " contains CCTag Id: ";
         const feature::CCTAG_Regions& cctagRegions = dynamic_cast<const feature::CCTAG_Regions&>(regions);
-        for(const auto &desc : cctagRegions.Descriptors())
+        for(std::size_t i = 0; i < cctagRegions.DescriptorCount(); ++i)
         {
-          const IndexT cctagIdA = feature::getCCTagId(desc);
+          const IndexT cctagIdA = feature::getCCTagId(cctagRegions.GetDescriptor(i));
           if(cctagIdA != UndefinedIndexT)
           {
             presentCCtagIds.insert(cctagIdA);
@@ -165,7 +165,7 @@ bool CCTagLocalizer::loadReconstructionDescriptors(const sfmData::SfMData & sfm_
           }
         }
         // Update histogram
-        int countcctag = cctagRegions.Descriptors().size();
+        int countcctag = cctagRegions.DescriptorCount();
         if(countcctag >= 5)
           counterCCtagsInImage[5] +=1;
         else
@@ -951,15 +951,15 @@ void viewMatching(const feature::CCTAG_Regions & regionsA,
 {
   out_featureMatches.clear();
   
-  for(std::size_t i=0 ; i < regionsA.Descriptors().size() ; ++i)
+  for(std::size_t i=0 ; i < regionsA.DescriptorCount() ; ++i)
   {
-    const IndexT cctagIdA = feature::getCCTagId(regionsA.Descriptors()[i]);
+    const IndexT cctagIdA = feature::getCCTagId(regionsA.GetDescriptor(i));
     // todo: Should be change to: Find in regionsB.Descriptors() the nearest 
     // descriptor to descriptorA. Currently, a cctag descriptor encode directly
     // the cctag id, then the id equality is tested.
-    for(std::size_t j=0 ; j < regionsB.Descriptors().size() ; ++j)
+    for(std::size_t j=0 ; j < regionsB.DescriptorCount() ; ++j)
     {
-      const IndexT cctagIdB = feature::getCCTagId(regionsB.Descriptors()[j]);
+      const IndexT cctagIdB = feature::getCCTagId(regionsB.GetDescriptor(j));
       if ( cctagIdA == cctagIdB )
       {
         out_featureMatches.emplace_back(i,j);
@@ -976,19 +976,19 @@ float viewSimilarity(const feature::CCTAG_Regions & regionsA,
 {
   assert(regionsA.DescriptorLength() == regionsB.DescriptorLength()); 
   
-  const std::bitset<128> descriptorViewA = constructCCTagViewDescriptor(regionsA.Descriptors());
-  const std::bitset<128> descriptorViewB = constructCCTagViewDescriptor(regionsB.Descriptors());
+  const std::bitset<128> descriptorViewA = constructCCTagViewDescriptor(regionsA);
+  const std::bitset<128> descriptorViewB = constructCCTagViewDescriptor(regionsB);
   
   // The similarity is the sum of all the cctags sharing the same id visible in both views.
   return (descriptorViewA & descriptorViewB).count();
 }
 
-std::bitset<128> constructCCTagViewDescriptor(const std::vector<feature::CCTAG_Regions::DescriptorT> & vCCTagDescriptors)
+std::bitset<128> constructCCTagViewDescriptor(const feature::CCTAG_Regions & cctagRegions)
 {
   std::bitset<128> descriptorView;
-  for(const auto & cctagDescriptor : vCCTagDescriptors )
+  for(std::size_t i = 0; i < cctagRegions.DescriptorCount(); ++i)
   {
-    const IndexT cctagId = feature::getCCTagId(cctagDescriptor);
+    const IndexT cctagId = feature::getCCTagId(cctagRegions.GetDescriptor(i));
     if ( cctagId != UndefinedIndexT)
     {
       descriptorView.set(cctagId, true);
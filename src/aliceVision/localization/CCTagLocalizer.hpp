@@ -197,12 +197,12 @@ void kNearestKeyFrames(
  * bits are 0 or 1 whether the corresponding marker is seen or not. E.g. if the 
  * bit in position 8 is 1 it means that the marker with ID 8 has been seen by the view.
  * 
- * @param[in] vCCTagDescriptors The input descriptors associated to the view.
+ * @param[in] cctagRegions The input CCTag regions of the view (descriptors in memory or mapped).
  * @return The view descriptor as a set of bit representing the visibility of
  * each possible marker for that view.
  */
 std::bitset<128> constructCCTagViewDescriptor(
-        const std::vector<feature::CCTAG_Regions::DescriptorT> & vCCTagDescriptors);
+        const feature::CCTAG_Regions & cctagRegions);
 
 float viewSimilarity(
         const feature::CCTAG_Regions & regionsA,
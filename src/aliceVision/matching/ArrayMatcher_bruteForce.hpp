@@ -9,7 +9,9 @@
 
 #include <aliceVision/numeric/numeric.hpp>
 #include <aliceVision/matching/ArrayMatcher.hpp>
+#include <aliceVision/matching/bruteForceKernels.hpp>
 #include <aliceVision/feature/metric.hpp>
+#include <aliceVision/feature/Hamming.hpp>
 #include <aliceVision/stl/indexedSort.hpp>
 
 #include <aliceVision/config.hpp>
@@ -21,6 +23,47 @@
 namespace aliceVision {
 namespace matching {
 
+/**
+ * @brief (Scalar, Metric) couples that have a tiled SIMD kernel for the 2 nearest neighbours search.
+ * The generic per-pair metric loop is used for the other ones.
+ */
+template <typename Scalar, typename Metric>
+struct BruteForceNN2Kernel
+{
+  static const bool available = false;
+  typedef int DistanceType;
+  static void compute(const Scalar*, int, const Scalar*, int, int, NearestNeighbours2<DistanceType>*) {}
+};
+
+template <typename Scalar, typename Distance>
+struct BruteForceNN2KernelL2
+{
+  static const bool available = true;
+  typedef Distance DistanceType;
+  static void compute(const Scalar* queries, int nbQueries, const Scalar* database, int nbDatabase, int dimension,
+                      NearestNeighbours2<DistanceType>* nearestNeighbours)
+  {
+    bruteForceNN2L2(queries, nbQueries, database, nbDatabase, dimension, nearestNeighbours);
+  }
+};
+
+template <> struct BruteForceNN2Kernel<unsigned char, feature::L2_Simple<unsigned char> > : BruteForceNN2KernelL2<unsigned char, int> {};
+template <> struct BruteForceNN2Kernel<unsigned char, feature::L2_Vectorized<unsigned char> > : BruteForceNN2KernelL2<unsigned char, int> {};
+template <> struct BruteForceNN2Kernel<float, feature::L2_Simple<float> > : BruteForceNN2KernelL2<float, float> {};
+template <> struct BruteForceNN2Kernel<float, feature::L2_Vectorized<float> > : BruteForceNN2KernelL2<float, float> {};
+
+template <>
+struct BruteForceNN2Kernel<unsigned char, feature::Hamming<unsigned char> >
+{
+  static const bool available = true;
+  typedef int DistanceType;
+  static void compute(const unsigned char* queries, int nbQueries, const unsigned char* database, int nbDatabase, int nbBytes,
+                      NearestNeighbours2<DistanceType>* nearestNeighbours)
+  {
+    bruteForceNN2Hamming(queries, nbQueries, database, nbDatabase, nbBytes, nearestNeighbours);
+  }
+};
+
 // By default compute square(L2 distance).
 template < typename Scalar = float, typename Metric = feature::L2_Simple<Scalar> >
 class ArrayMatcher_bruteForce  : public ArrayMatcher<Scalar, Metric>
@@ -124,6 +167,24 @@ class ArrayMatcher_bruteForce  : public ArrayMatcher<Scalar, Metric>
     pvec_distances->resize(nbQuery * NN);
     pvec_indices->resize(nbQuery * NN);
 
+    // Tiled SIMD kernels for the common 2 nearest neighbours search (ratio test)
+    typedef BruteForceNN2Kernel<Scalar, Metric> KernelT;
+    if(KernelT::available && NN <= 2)
+    {
+      std::vector<NearestNeighbours2<typename KernelT::DistanceType> > nearestNeighbours(nbQuery);
+      KernelT::compute(query, nbQuery, (*memMapping).data(), (*memMapping).rows(), (*memMapping).cols(), &nearestNeighbours[0]);
+
+      for(int queryIndex = 0; queryIndex < nbQuery; ++queryIndex)
+      {
+        for(std::size_t i = 0; i < NN; ++i)
+        {
+          (*pvec_distances)[queryIndex*NN+i] = static_cast<DistanceType>(nearestNeighbours[queryIndex].distances[i]);
+          (*pvec_indices)[queryIndex*NN+i] = IndMatch(queryIndex, nearestNeighbours[queryIndex].indices[i]);
+        }
+      }
+      return true;
+    }
+
     #pragma omp parallel for schedule(dynamic)
     for (int queryIndex=0; queryIndex < nbQuery; ++queryIndex) 
     {
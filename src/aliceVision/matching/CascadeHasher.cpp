@@ -0,0 +1,97 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "CascadeHasher.hpp"
+
+#include <aliceVision/system/cpu.hpp>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace aliceVision {
+namespace matching {
+
+namespace {
+
+inline unsigned int popcount64Generic(uint64_t n)
+{
+  n -= ((n >> 1) & 0x5555555555555555ULL);
+  n = (n & 0x3333333333333333ULL) + ((n >> 2) & 0x3333333333333333ULL);
+  return static_cast<unsigned int>((((n + (n >> 4)) & 0x0f0f0f0f0f0f0f0fULL) * 0x0101010101010101ULL) >> 56);
+}
+
+void hammingDistancesGeneric(const uint64_t* queryCode, const uint64_t* codes, int nbWordsPerCode,
+                             const int* candidates, int nbCandidates, uint16_t* distances)
+{
+  for(int k = 0; k < nbCandidates; ++k)
+  {
+    const uint64_t* code = codes + static_cast<std::size_t>(candidates[k]) * nbWordsPerCode;
+    unsigned int distance = 0;
+    for(int w = 0; w < nbWordsPerCode; ++w)
+      distance += popcount64Generic(queryCode[w] ^ code[w]);
+    distances[k] = static_cast<uint16_t>(distance);
+  }
+}
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define ALICEVISION_HAVE_POPCNT_DISPATCH
+
+// Compiled for POPCNT whatever the global compiler flags, only called after a runtime check.
+__attribute__((target("popcnt")))
+void hammingDistancesPopcnt(const uint64_t* queryCode, const uint64_t* codes, int nbWordsPerCode,
+                            const int* candidates, int nbCandidates, uint16_t* distances)
+{
+  for(int k = 0; k < nbCandidates; ++k)
+  {
+    const uint64_t* code = codes + static_cast<std::size_t>(candidates[k]) * nbWordsPerCode;
+    unsigned int distance = 0;
+    for(int w = 0; w < nbWordsPerCode; ++w)
+      distance += static_cast<unsigned int>(__builtin_popcountll(queryCode[w] ^ code[w]));
+    distances[k] = static_cast<uint16_t>(distance);
+  }
+}
+
+#elif defined(_MSC_VER) && defined(_M_X64)
+#define ALICEVISION_HAVE_POPCNT_DISPATCH
+
+void hammingDistancesPopcnt(const uint64_t* queryCode, const uint64_t* codes, int nbWordsPerCode,
+                            const int* candidates, int nbCandidates, uint16_t* distances)
+{
+  for(int k = 0; k < nbCandidates; ++k)
+  {
+    const uint64_t* code = codes + static_cast<std::size_t>(candidates[k]) * nbWordsPerCode;
+    unsigned int distance = 0;
+    for(int w = 0; w < nbWordsPerCode; ++w)
+      distance += static_cast<unsigned int>(__popcnt64(queryCode[w] ^ code[w]));
+    distances[k] = static_cast<uint16_t>(distance);
+  }
+}
+
+#endif
+
+} // namespace
+
+void computeHashCodesHammingDistances(const uint64_t* queryCode,
+                                      const uint64_t* codes,
+                                      int nbWordsPerCode,
+                                      const int* candidates,
+                                      int nbCandidates,
+                                      uint16_t* distances)
+{
+#ifdef ALICEVISION_HAVE_POPCNT_DISPATCH
+  static const bool hasPopcnt = system::getCpuFeatures().popcnt;
+  if(hasPopcnt)
+  {
+    hammingDistancesPopcnt(queryCode, codes, nbWordsPerCode, candidates, nbCandidates, distances);
+    return;
+  }
+#endif
+  hammingDistancesGeneric(queryCode, codes, nbWordsPerCode, candidates, nbCandidates, distances);
+}
+
+} // namespace matching
+} // namespace aliceVision
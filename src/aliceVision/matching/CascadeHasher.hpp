@@ -10,33 +10,75 @@
 #include <aliceVision/numeric/numeric.hpp>
 #include <aliceVision/feature/metric.hpp>
 #include <aliceVision/matching/IndMatch.hpp>
-#include <aliceVision/stl/DynamicBitset.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <random>
-#include <cmath>
+#include <utility>
+#include <vector>
 
 namespace aliceVision {
 namespace matching {
 
-struct HashedDescription {
-  // Hash code generated by the primary hashing function.
-  stl::dynamic_bitset hash_code;
-
-  // Each bucket_ids[x] = y means the descriptor belongs to bucket y in bucket
-  // group x.
+/**
+ * @brief Hash codes and buckets of a set of descriptors.
+ * Hash codes are packed in 64-bit words, bucket contents are stored contiguously per group.
+ */
+struct HashedDescriptions
+{
+  // Number of 64-bit words of each hash code.
+  int nb_words_per_code = 0;
+  // Number of bucket groups.
+  int nb_bucket_groups = 0;
+  // Number of buckets in each group.
+  int nb_buckets_per_group = 0;
+
+  // Packed hash codes: hash_codes[i * nb_words_per_code + w] is the word w of the descriptor i.
+  std::vector<uint64_t, Eigen::aligned_allocator<uint64_t> > hash_codes;
+
+  // bucket_ids[i * nb_bucket_groups + g] = y means the descriptor i belongs to bucket y in bucket group g.
   std::vector<uint16_t> bucket_ids;
-};
 
-struct HashedDescriptions{
-  // The hash information.
-  std::vector<HashedDescription> hashed_desc;
+  // Descriptor ids of the bucket y in group g are stored in bucket_items
+  // from bucket_offsets[g * (nb_buckets_per_group + 1) + y] to bucket_offsets[g * (nb_buckets_per_group + 1) + y + 1].
+  std::vector<int> bucket_offsets;
+  std::vector<int> bucket_items;
+
+  std::size_t size() const { return (nb_bucket_groups > 0) ? bucket_ids.size() / nb_bucket_groups : 0; }
 
-  typedef std::vector<int> Bucket;
-  // buckets[bucket_group][bucket_id] = bucket (container of description ids).
-  std::vector<std::vector<Bucket> > buckets;
+  const uint64_t* hashCode(int i) const { return hash_codes.data() + static_cast<std::size_t>(i) * nb_words_per_code; }
+
+  const int* bucketBegin(int group, int bucketId) const
+  {
+    return bucket_items.data() + bucket_offsets[group * (nb_buckets_per_group + 1) + bucketId];
+  }
+
+  const int* bucketEnd(int group, int bucketId) const
+  {
+    return bucket_items.data() + bucket_offsets[group * (nb_buckets_per_group + 1) + bucketId + 1];
+  }
 };
 
+/**
+ * @brief Compute the Hamming distances between a query hash code and a list of candidate hash codes.
+ * Uses the POPCNT instruction when the CPU supports it.
+ *
+ * @param[in] queryCode The query hash code
+ * @param[in] codes The packed hash codes of the candidates
+ * @param[in] nbWordsPerCode The number of 64-bit words of each hash code
+ * @param[in] candidates The indexes of the candidates in codes
+ * @param[in] nbCandidates The number of candidates
+ * @param[out] distances The Hamming distance of each candidate
+ */
+void computeHashCodesHammingDistances(const uint64_t* queryCode,
+                                      const uint64_t* codes,
+                                      int nbWordsPerCode,
+                                      const int* candidates,
+                                      int nbCandidates,
+                                      uint16_t* distances);
+
 /**
  * This hasher will hash descriptors with a two-step hashing system:
  * 1. it generates a hash code,
@@ -54,7 +96,9 @@ struct HashedDescriptions{
  *
  * This implementation is based on the Theia library implementation from Chris Sweeney.
  * Update compare to the initial paper [1] and initial author code:
- * - hashing projection is made by using Eigen to use vectorization
+ * - hashing projection is made by using Eigen to use vectorization,
+ *   all the projections of a block of descriptors are computed with one matrix product
+ * - hash codes are packed in 64-bit words and compared with popcount
  * - replace the BoxMuller random number generation by C++ 11 random number generation
  * - this implementation can support various descriptor length and internal type
  *   SIFT, SURF, ... all scalar based descriptor
@@ -71,7 +115,44 @@ private:
   // The number of buckets in each group.
   int nb_buckets_per_group_;
 
+  // Number of descriptors hashed by one matrix product.
+  static const int kHashingBlockSize = 1024;
+
 public:
+
+  /**
+   * @brief Reusable buffers of Match_HashedDescriptions.
+   * Keep one per thread to avoid allocations for each matched pair.
+   */
+  struct MatchingBuffers
+  {
+    // Unique candidates of the current query.
+    std::vector<int> candidates;
+    // Hamming distance of each candidate.
+    std::vector<uint16_t> hamming_distances;
+    // Number of candidates for each Hamming distance.
+    std::vector<int> hamming_histogram;
+    // visit_stamps[id] == stamp if the database descriptor id is already a candidate of the current query.
+    std::vector<uint32_t> visit_stamps;
+    uint32_t stamp = 0;
+
+    void prepare(std::size_t nbDatabaseDescriptors, int nbHashCode)
+    {
+      if(visit_stamps.size() < nbDatabaseDescriptors)
+        visit_stamps.resize(nbDatabaseDescriptors, 0);
+      hamming_histogram.resize(nbHashCode + 1);
+    }
+
+    void nextStamp()
+    {
+      if(++stamp == 0)
+      {
+        std::fill(visit_stamps.begin(), visit_stamps.end(), 0);
+        stamp = 1;
+      }
+    }
+  };
+
   CascadeHasher() {}
 
   // Creates the hashing projections (cascade of two level of hash codes)
@@ -94,25 +175,24 @@ public:
     std::mt19937 gen(rd());
     std::normal_distribution<> d(0,1);
 
-    primary_hash_projection_.resize(nb_hash_code, nb_hash_code);
+    // The primary hash projection (nb_hash_code rows) is followed by the
+    // secondary hash projection of each bucket group (nb_bits_per_bucket rows each).
+    hash_projection_.resize(nb_hash_code + nb_bucket_groups * nb_bits_per_bucket, nb_hash_code);
 
     // Initialize primary hash projection.
     for (int i = 0; i < nb_hash_code; ++i)
     {
       for (int j = 0; j < nb_hash_code; ++j)
-        primary_hash_projection_(i, j) = d(gen);
+        hash_projection_(i, j) = d(gen);
     }
 
     // Initialize secondary hash projection.
-    secondary_hash_projection_.resize(nb_bucket_groups);
     for (int i = 0; i < nb_bucket_groups; ++i)
     {
-      secondary_hash_projection_[i].resize(nb_bits_per_bucket_,
-        nb_hash_code);
       for (int j = 0; j < nb_bits_per_bucket_; ++j)
       {
         for (int k = 0; k < nb_hash_code; ++k)
-          secondary_hash_projection_[i](j, k) = d(gen);
+          hash_projection_(nb_hash_code + i * nb_bits_per_bucket_ + j, k) = d(gen);
       }
     }
     return true;
@@ -156,60 +236,77 @@ public:
       return hashed_descriptions;
     }
 
+    const int nbDescriptions = static_cast<int>(descriptions.rows());
+    hashed_descriptions.nb_words_per_code = (nb_hash_code_ + 63) / 64;
+    hashed_descriptions.nb_bucket_groups = nb_bucket_groups_;
+    hashed_descriptions.nb_buckets_per_group = nb_buckets_per_group_;
+    hashed_descriptions.hash_codes.assign(static_cast<std::size_t>(nbDescriptions) * hashed_descriptions.nb_words_per_code, 0);
+    hashed_descriptions.bucket_ids.resize(static_cast<std::size_t>(nbDescriptions) * nb_bucket_groups_);
+
     // Create hash codes for each description.
     {
-      // Allocate space for hash codes.
-      const typename MatrixT::Index nbDescriptions = descriptions.rows();
-      hashed_descriptions.hashed_desc.resize(nbDescriptions);
-      Eigen::VectorXf descriptor(descriptions.cols());
-      for (int i = 0; i < nbDescriptions; ++i)
-      {
-        // Allocate space for each bucket id.
-        hashed_descriptions.hashed_desc[i].bucket_ids.resize(nb_bucket_groups_);
+      typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMatrixXf;
+      RowMatrixXf centered;
+      RowMatrixXf projections;
 
-        for (int k = 0; k < descriptions.cols(); ++k)
-        {
-          descriptor(k) = descriptions(i,k);
-        }
-        descriptor -= zero_mean_descriptor;
+      for (int blockBegin = 0; blockBegin < nbDescriptions; blockBegin += kHashingBlockSize)
+      {
+        const int blockSize = std::min(kHashingBlockSize, nbDescriptions - blockBegin);
 
-        auto& hash_code = hashed_descriptions.hashed_desc[i].hash_code;
-        hash_code = stl::dynamic_bitset(descriptions.cols());
+        // Project a block of zero mean descriptors on all the hashing functions at once.
+        centered = descriptions.middleRows(blockBegin, blockSize).template cast<float>();
+        centered.rowwise() -= zero_mean_descriptor.transpose();
+        projections.noalias() = centered * hash_projection_.transpose();
 
-        // Compute hash code.
-        const Eigen::VectorXf primary_projection = primary_hash_projection_ * descriptor;
-        for (int j = 0; j < nb_hash_code_; ++j)
+        for (int r = 0; r < blockSize; ++r)
         {
-          hash_code[j] = primary_projection(j) > 0;
-        }
+          const int i = blockBegin + r;
+          const float* projection = projections.row(r).data();
 
-        // Determine the bucket index for each group.
-        Eigen::VectorXf secondary_projection;
-        for (int j = 0; j < nb_bucket_groups_; ++j)
-        {
-          uint16_t bucket_id = 0;
-          secondary_projection = secondary_hash_projection_[j] * descriptor;
+          // Compute hash code.
+          uint64_t* hash_code = hashed_descriptions.hash_codes.data() + static_cast<std::size_t>(i) * hashed_descriptions.nb_words_per_code;
+          for (int j = 0; j < nb_hash_code_; ++j)
+          {
+            if (projection[j] > 0)
+              hash_code[j >> 6] |= uint64_t(1) << (j & 63);
+          }
 
-          for (int k = 0; k < nb_bits_per_bucket_; ++k)
+          // Determine the bucket index for each group.
+          const float* secondary_projection = projection + nb_hash_code_;
+          for (int j = 0; j < nb_bucket_groups_; ++j)
           {
-            bucket_id = (bucket_id << 1) + (secondary_projection(k) > 0 ? 1 : 0);
+            uint16_t bucket_id = 0;
+            for (int k = 0; k < nb_bits_per_bucket_; ++k)
+            {
+              bucket_id = (bucket_id << 1) + (secondary_projection[j * nb_bits_per_bucket_ + k] > 0 ? 1 : 0);
+            }
+            hashed_descriptions.bucket_ids[static_cast<std::size_t>(i) * nb_bucket_groups_ + j] = bucket_id;
           }
-          hashed_descriptions.hashed_desc[i].bucket_ids[j] = bucket_id;
         }
       }
     }
-    // Build the Buckets
+    // Build the Buckets (counting sort of the descriptor ids by bucket id)
     {
-      hashed_descriptions.buckets.resize(nb_bucket_groups_);
+      const int nbOffsetsPerGroup = nb_buckets_per_group_ + 1;
+      hashed_descriptions.bucket_offsets.assign(static_cast<std::size_t>(nb_bucket_groups_) * nbOffsetsPerGroup, 0);
+      hashed_descriptions.bucket_items.resize(static_cast<std::size_t>(nb_bucket_groups_) * nbDescriptions);
+
       for (int i = 0; i < nb_bucket_groups_; ++i)
       {
-        hashed_descriptions.buckets[i].resize(nb_buckets_per_group_);
+        int* offsets = hashed_descriptions.bucket_offsets.data() + i * nbOffsetsPerGroup;
+        for (int j = 0; j < nbDescriptions; ++j)
+          ++offsets[hashed_descriptions.bucket_ids[static_cast<std::size_t>(j) * nb_bucket_groups_ + i] + 1];
+
+        offsets[0] = i * nbDescriptions;
+        for (int b = 0; b < nb_buckets_per_group_; ++b)
+          offsets[b + 1] += offsets[b];
 
         // Add the descriptor ID to the proper bucket group and id.
-        for (int j = 0; j < hashed_descriptions.hashed_desc.size(); ++j)
+        std::vector<int> cursor(offsets, offsets + nb_buckets_per_group_);
+        for (int j = 0; j < nbDescriptions; ++j)
         {
-          const uint16_t bucket_id = hashed_descriptions.hashed_desc[j].bucket_ids[i];
-          hashed_descriptions.buckets[i][bucket_id].push_back(j);
+          const uint16_t bucket_id = hashed_descriptions.bucket_ids[static_cast<std::size_t>(j) * nb_bucket_groups_ + i];
+          hashed_descriptions.bucket_items[cursor[bucket_id]++] = j;
         }
       }
     }
@@ -218,6 +315,7 @@ public:
 
   // Matches two collection of hashed descriptions with a fast matching scheme
   // based on the hash codes previously generated.
+  // The buffers can be given to reuse the memory between calls (one per thread).
   template <typename MatrixT, typename DistanceType>
   void Match_HashedDescriptions
   (
@@ -227,7 +325,8 @@ public:
     const MatrixT & descriptions2,
     IndMatches * pvec_indices,
     std::vector<DistanceType> * pvec_distances,
-    const int NN = 2
+    const int NN = 2,
+    MatchingBuffers* buffers = nullptr
   ) const
   {
     typedef feature::L2_Vectorized<typename MatrixT::Scalar> MetricT;
@@ -235,99 +334,97 @@ public:
 
     static const int kNumTopCandidates = 10;
 
-    // Preallocate the candidate descriptors container.
-    std::vector<int> candidate_descriptors;
-    candidate_descriptors.reserve(hashed_descriptions2.hashed_desc.size());
-
-    // Preallocated hamming distances. Each column indicates the hamming distance
-    // and the rows collect the descriptor ids with that
-    // distance. num_descriptors_with_hamming_distance keeps track of how many
-    // descriptors have that distance.
-    Eigen::MatrixXi candidate_hamming_distances(
-      hashed_descriptions2.hashed_desc.size(), nb_hash_code_ + 1);
-    Eigen::VectorXi num_descriptors_with_hamming_distance(nb_hash_code_ + 1);
-
-    // Preallocate the container for keeping euclidean distances.
-    std::vector<std::pair<DistanceType, int> > candidate_euclidean_distances;
-    candidate_euclidean_distances.reserve(kNumTopCandidates);
-
-    // A preallocated vector to determine if we have already used a particular
-    // feature for matching (i.e., prevents duplicates).
-    std::vector<bool> used_descriptor(hashed_descriptions2.hashed_desc.size());
-
-    typedef feature::Hamming<stl::dynamic_bitset::BlockType> HammingMetricType;
-    static const HammingMetricType metricH = {};
-    for (int i = 0; i < hashed_descriptions1.hashed_desc.size(); ++i)
-    {
-      candidate_descriptors.clear();
-      num_descriptors_with_hamming_distance.setZero();
-      candidate_euclidean_distances.clear();
+    MatchingBuffers localBuffers;
+    MatchingBuffers& b = (buffers != nullptr) ? *buffers : localBuffers;
+    b.prepare(hashed_descriptions2.size(), nb_hash_code_);
+
+    // Container for keeping euclidean distances.
+    std::pair<DistanceType, int> candidate_euclidean_distances[kNumTopCandidates];
 
-      const auto& hashed_desc = hashed_descriptions1.hashed_desc[i];
+    const int nbQueries = static_cast<int>(hashed_descriptions1.size());
+    for (int i = 0; i < nbQueries; ++i)
+    {
+      b.candidates.clear();
+      b.nextStamp();
 
       // Accumulate all descriptors in each bucket group that are in the same
       // bucket id as the query descriptor.
+      std::size_t nbCandidatesWithDuplicates = 0;
       for (int j = 0; j < nb_bucket_groups_; ++j)
       {
-        const uint16_t bucket_id = hashed_desc.bucket_ids[j];
-        for (const auto& feature_id : hashed_descriptions2.buckets[j][bucket_id])
+        const uint16_t bucket_id = hashed_descriptions1.bucket_ids[static_cast<std::size_t>(i) * nb_bucket_groups_ + j];
+        const int* bucketBegin = hashed_descriptions2.bucketBegin(j, bucket_id);
+        const int* bucketEnd = hashed_descriptions2.bucketEnd(j, bucket_id);
+        nbCandidatesWithDuplicates += bucketEnd - bucketBegin;
+        for (const int* it = bucketBegin; it != bucketEnd; ++it)
         {
-          candidate_descriptors.emplace_back(feature_id);
-          used_descriptor[feature_id] = false;
+          // avoid selecting the same candidate multiple times
+          if (b.visit_stamps[*it] != b.stamp)
+          {
+            b.visit_stamps[*it] = b.stamp;
+            b.candidates.push_back(*it);
+          }
         }
       }
 
       // Skip matching this descriptor if there are not at least NN candidates.
-      if (candidate_descriptors.size() <= NN)
+      if (nbCandidatesWithDuplicates <= NN)
       {
         continue;
       }
 
-      // Compute the hamming distance of all candidates based on the comp hash
-      // code. Put the descriptors into buckets corresponding to their hamming
-      // distance.
-      for (const int candidate_id : candidate_descriptors)
+      // Compute the hamming distance of all candidates based on the comp hash code.
+      const int nbCandidates = static_cast<int>(b.candidates.size());
+      b.hamming_distances.resize(nbCandidates);
+      computeHashCodesHammingDistances(
+        hashed_descriptions1.hashCode(i),
+        hashed_descriptions2.hash_codes.data(),
+        hashed_descriptions2.nb_words_per_code,
+        b.candidates.data(),
+        nbCandidates,
+        b.hamming_distances.data());
+
+      // Find the hamming distance threshold that keeps the kNumTopCandidates best candidates.
+      std::fill(b.hamming_histogram.begin(), b.hamming_histogram.end(), 0);
+      for (int k = 0; k < nbCandidates; ++k)
+        ++b.hamming_histogram[b.hamming_distances[k]];
+
+      int threshold = 0;
+      int nbBelowThreshold = 0;
+      while (threshold <= nb_hash_code_ && nbBelowThreshold + b.hamming_histogram[threshold] < kNumTopCandidates)
+        nbBelowThreshold += b.hamming_histogram[threshold++];
+      // number of candidates to keep at the threshold distance
+      int nbAtThreshold = kNumTopCandidates - nbBelowThreshold;
+
+      // Compute the euclidean distance of the k descriptors with the best hamming distance.
+      int nbEuclideanDistances = 0;
+      for (int k = 0; k < nbCandidates && nbEuclideanDistances < kNumTopCandidates; ++k)
       {
-        if (!used_descriptor[candidate_id]) // avoid selecting the same candidate multiple times
+        const int hammingDistance = b.hamming_distances[k];
+        if (hammingDistance > threshold)
+          continue;
+        if (hammingDistance == threshold)
         {
-          used_descriptor[candidate_id] = true;
-
-          const HammingMetricType::ResultType hamming_distance = metricH(
-            hashed_desc.hash_code.data(),
-            hashed_descriptions2.hashed_desc[candidate_id].hash_code.data(),
-            hashed_desc.hash_code.num_blocks());
-          candidate_hamming_distances(
-              num_descriptors_with_hamming_distance(hamming_distance)++,
-              hamming_distance) = candidate_id;
+          if (nbAtThreshold == 0)
+            continue;
+          --nbAtThreshold;
         }
-      }
-
-      // Compute the euclidean distance of the k descriptors with the best hamming
-      // distance.
-      candidate_euclidean_distances.reserve(kNumTopCandidates);
-      for (int j = 0; j < candidate_hamming_distances.cols() &&
-        (candidate_euclidean_distances.size() < kNumTopCandidates); ++j)
-      {
-        for(int k = 0; k < num_descriptors_with_hamming_distance(j) &&
-          (candidate_euclidean_distances.size() < kNumTopCandidates); ++k)
-        {
-          const int candidate_id = candidate_hamming_distances(k, j);
-          const DistanceType distance = metric(
-            descriptions2.row(candidate_id).data(),
-            descriptions1.row(i).data(),
-            descriptions1.cols());
+        const int candidate_id = b.candidates[k];
+        const DistanceType distance = metric(
+          descriptions2.row(candidate_id).data(),
+          descriptions1.row(i).data(),
+          descriptions1.cols());
 
-          candidate_euclidean_distances.emplace_back(distance, candidate_id);
-        }
+        candidate_euclidean_distances[nbEuclideanDistances++] = std::make_pair(distance, candidate_id);
       }
 
       // Assert that each query is having at least NN retrieved neighbors
-      if (candidate_euclidean_distances.size() >= NN)
+      if (nbEuclideanDistances >= NN)
       {
         // Find the top NN candidates based on euclidean distance.
-        std::partial_sort(candidate_euclidean_distances.begin(),
-          candidate_euclidean_distances.begin() + NN,
-          candidate_euclidean_distances.end());
+        std::partial_sort(candidate_euclidean_distances,
+          candidate_euclidean_distances + NN,
+          candidate_euclidean_distances + nbEuclideanDistances);
         // save resulting neighbors
         for (int l = 0; l < NN; ++l)
         {
@@ -340,11 +437,9 @@ public:
   }
 
   private:
-  // Primary hashing function.
-  Eigen::MatrixXf primary_hash_projection_;
-
-  // Secondary hashing function.
-  std::vector<Eigen::MatrixXf> secondary_hash_projection_;
+  // Primary hashing function (first nb_hash_code_ rows),
+  // followed by the secondary hashing functions of each bucket group.
+  Eigen::MatrixXf hash_projection_;
 };
 
 }  // namespace matching
@@ -0,0 +1,205 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "bruteForceKernelsImpl.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ALICEVISION_BRUTEFORCE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace aliceVision {
+namespace matching {
+namespace {
+
+#ifdef ALICEVISION_BRUTEFORCE_SSE2
+
+inline int hsum(__m128i v)
+{
+  v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+  v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtsi128_si32(v);
+}
+
+inline float hsum(__m128 v)
+{
+  v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+  v = _mm_add_ss(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)));
+  return _mm_cvtss_f32(v);
+}
+
+/// Accumulate the squared differences of 16 uint8 values as 4 int32.
+inline __m128i sqrDiffU8(__m128i qLo, __m128i qHi, const unsigned char* b, __m128i acc)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+  const __m128i diffLo = _mm_sub_epi16(qLo, _mm_unpacklo_epi8(d, zero));
+  const __m128i diffHi = _mm_sub_epi16(qHi, _mm_unpackhi_epi8(d, zero));
+  acc = _mm_add_epi32(acc, _mm_madd_epi16(diffLo, diffLo));
+  return _mm_add_epi32(acc, _mm_madd_epi16(diffHi, diffHi));
+}
+
+struct L2UcharSSE2Kernel
+{
+  typedef L2ScalarKernel<unsigned char, int> Scalar;
+
+  static inline int maxDistance() { return Scalar::maxDistance(); }
+
+  static inline int distance1x1(const unsigned char* a, const unsigned char* b, int dimension)
+  {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = zero;
+    int k = 0;
+    for(; k + 16 <= dimension; k += 16)
+    {
+      const __m128i q = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + k));
+      acc = sqrDiffU8(_mm_unpacklo_epi8(q, zero), _mm_unpackhi_epi8(q, zero), b + k, acc);
+    }
+    return hsum(acc) + Scalar::distance1x1(a + k, b + k, dimension - k);
+  }
+
+  static inline void distance1x4(const unsigned char* a, const unsigned char* b, int dimension, int* out)
+  {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc0 = zero, acc1 = zero, acc2 = zero, acc3 = zero;
+    int k = 0;
+    for(; k + 16 <= dimension; k += 16)
+    {
+      const __m128i q = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + k));
+      const __m128i qLo = _mm_unpacklo_epi8(q, zero);
+      const __m128i qHi = _mm_unpackhi_epi8(q, zero);
+      acc0 = sqrDiffU8(qLo, qHi, b + k, acc0);
+      acc1 = sqrDiffU8(qLo, qHi, b + dimension + k, acc1);
+      acc2 = sqrDiffU8(qLo, qHi, b + 2 * dimension + k, acc2);
+      acc3 = sqrDiffU8(qLo, qHi, b + 3 * dimension + k, acc3);
+    }
+    out[0] = hsum(acc0);
+    out[1] = hsum(acc1);
+    out[2] = hsum(acc2);
+    out[3] = hsum(acc3);
+    if(k < dimension)
+    {
+      for(int r = 0; r < 4; ++r)
+        out[r] += Scalar::distance1x1(a + k, b + r * dimension + k, dimension - k);
+    }
+  }
+};
+
+inline __m128 sqrDiffF32(__m128 q, const float* b, __m128 acc)
+{
+  const __m128 diff = _mm_sub_ps(q, _mm_loadu_ps(b));
+  return _mm_add_ps(acc, _mm_mul_ps(diff, diff));
+}
+
+struct L2FloatSSE2Kernel
+{
+  typedef L2ScalarKernel<float, float> Scalar;
+
+  static inline float maxDistance() { return Scalar::maxDistance(); }
+
+  static inline float distance1x1(const float* a, const float* b, int dimension)
+  {
+    __m128 acc = _mm_setzero_ps();
+    int k = 0;
+    for(; k + 4 <= dimension; k += 4)
+      acc = sqrDiffF32(_mm_loadu_ps(a + k), b + k, acc);
+    return hsum(acc) + Scalar::distance1x1(a + k, b + k, dimension - k);
+  }
+
+  static inline void distance1x4(const float* a, const float* b, int dimension, float* out)
+  {
+    __m128 acc0 = _mm_setzero_ps(), acc1 = acc0, acc2 = acc0, acc3 = acc0;
+    int k = 0;
+    for(; k + 4 <= dimension; k += 4)
+    {
+      const __m128 q = _mm_loadu_ps(a + k);
+      acc0 = sqrDiffF32(q, b + k, acc0);
+      acc1 = sqrDiffF32(q, b + dimension + k, acc1);
+      acc2 = sqrDiffF32(q, b + 2 * dimension + k, acc2);
+      acc3 = sqrDiffF32(q, b + 3 * dimension + k, acc3);
+    }
+    out[0] = hsum(acc0);
+    out[1] = hsum(acc1);
+    out[2] = hsum(acc2);
+    out[3] = hsum(acc3);
+    if(k < dimension)
+    {
+      for(int r = 0; r < 4; ++r)
+        out[r] += Scalar::distance1x1(a + k, b + r * dimension + k, dimension - k);
+    }
+  }
+};
+
+typedef L2UcharSSE2Kernel L2UcharBaseKernel;
+typedef L2FloatSSE2Kernel L2FloatBaseKernel;
+
+#else
+
+typedef L2ScalarKernel<unsigned char, int> L2UcharBaseKernel;
+typedef L2ScalarKernel<float, float> L2FloatBaseKernel;
+
+#endif // ALICEVISION_BRUTEFORCE_SSE2
+
+/// Returns the kernels of the best instruction set allowed by simdLevel, nullptr for the generic ones.
+const detail::BruteForceKernels* selectKernels(system::ESimdLevel simdLevel)
+{
+  if(simdLevel >= system::ESimdLevel::AVX512)
+  {
+    if(const detail::BruteForceKernels* kernels = detail::getBruteForceKernelsAVX512())
+      return kernels;
+  }
+  if(simdLevel >= system::ESimdLevel::AVX2)
+  {
+    if(const detail::BruteForceKernels* kernels = detail::getBruteForceKernelsAVX2())
+      return kernels;
+  }
+  return nullptr;
+}
+
+} // namespace
+
+void bruteForceNN2L2(const unsigned char* queries, int nbQueries,
+                     const unsigned char* database, int nbDatabase,
+                     int dimension,
+                     NearestNeighbours2<int>* nearestNeighbours,
+                     system::ESimdLevel simdLevel)
+{
+  if(const detail::BruteForceKernels* kernels = selectKernels(simdLevel))
+    kernels->nn2L2Uchar(queries, nbQueries, database, nbDatabase, dimension, nearestNeighbours);
+  else if(simdLevel >= system::ESimdLevel::SSE2)
+    tiledNN2<L2UcharBaseKernel>(queries, nbQueries, database, nbDatabase, dimension, nearestNeighbours);
+  else
+    tiledNN2<L2ScalarKernel<unsigned char, int> >(queries, nbQueries, database, nbDatabase, dimension, nearestNeighbours);
+}
+
+void bruteForceNN2L2(const float* queries, int nbQueries,
+                     const float* database, int nbDatabase,
+                     int dimension,
+                     NearestNeighbours2<float>* nearestNeighbours,
+                     system::ESimdLevel simdLevel)
+{
+  if(const detail::BruteForceKernels* kernels = selectKernels(simdLevel))
+    kernels->nn2L2Float(queries, nbQueries, database, nbDatabase, dimension, nearestNeighbours);
+  else if(simdLevel >= system::ESimdLevel::SSE2)
+    tiledNN2<L2FloatBaseKernel>(queries, nbQueries, database, nbDatabase, dimension, nearestNeighbours);
+  else
+    tiledNN2<L2ScalarKernel<float, float> >(queries, nbQueries, database, nbDatabase, dimension, nearestNeighbours);
+}
+
+void bruteForceNN2Hamming(const unsigned char* queries, int nbQueries,
+                          const unsigned char* database, int nbDatabase,
+                          int nbBytes,
+                          NearestNeighbours2<int>* nearestNeighbours,
+                          system::ESimdLevel simdLevel)
+{
+  if(const detail::BruteForceKernels* kernels = selectKernels(simdLevel))
+    kernels->nn2Hamming(queries, nbQueries, database, nbDatabase, nbBytes, nearestNeighbours);
+  else
+    tiledNN2<HammingPopcountKernel>(queries, nbQueries, database, nbDatabase, nbBytes, nearestNeighbours);
+}
+
+} // namespace matching
+} // namespace aliceVision
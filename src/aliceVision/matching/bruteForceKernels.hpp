@@ -0,0 +1,93 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/system/cpu.hpp>
+
+#include <limits>
+
+namespace aliceVision {
+namespace matching {
+
+/**
+ * @brief The two nearest neighbours of a query descriptor, sorted by increasing distance.
+ * It is all that is needed by the nearest neighbour distance ratio test.
+ * An index of -1 means that no neighbour has been found (database smaller than 2).
+ */
+template <typename DistanceT>
+struct NearestNeighbours2
+{
+  int indices[2];
+  DistanceT distances[2];
+
+  NearestNeighbours2()
+  {
+    indices[0] = indices[1] = -1;
+    distances[0] = distances[1] = std::numeric_limits<DistanceT>::max();
+  }
+};
+
+/**
+ * @brief Compute the 2 nearest neighbours (squared L2 distance) of each query descriptor.
+ *
+ * Descriptors are stored contiguously (row major), queries and database are tiled
+ * so that a block of database descriptors stays in cache while a block of queries is processed.
+ * The distance kernels are selected at runtime according to the SIMD level.
+ *
+ * @param[in] queries The query descriptors (nbQueries x dimension)
+ * @param[in] nbQueries The number of query descriptors
+ * @param[in] database The database descriptors (nbDatabase x dimension)
+ * @param[in] nbDatabase The number of database descriptors
+ * @param[in] dimension The descriptor length
+ * @param[out] nearestNeighbours The 2 nearest neighbours of each query (nbQueries elements)
+ * @param[in] simdLevel The maximal SIMD level to use
+ */
+void bruteForceNN2L2(const unsigned char* queries, int nbQueries,
+                     const unsigned char* database, int nbDatabase,
+                     int dimension,
+                     NearestNeighbours2<int>* nearestNeighbours,
+                     system::ESimdLevel simdLevel = system::getSimdLevel());
+
+void bruteForceNN2L2(const float* queries, int nbQueries,
+                     const float* database, int nbDatabase,
+                     int dimension,
+                     NearestNeighbours2<float>* nearestNeighbours,
+                     system::ESimdLevel simdLevel = system::getSimdLevel());
+
+/**
+ * @brief Compute the 2 nearest neighbours (Hamming distance) of each binary query descriptor.
+ * @see bruteForceNN2L2
+ * @param[in] nbBytes The binary descriptor length in bytes
+ */
+void bruteForceNN2Hamming(const unsigned char* queries, int nbQueries,
+                          const unsigned char* database, int nbDatabase,
+                          int nbBytes,
+                          NearestNeighbours2<int>* nearestNeighbours,
+                          system::ESimdLevel simdLevel = system::getSimdLevel());
+
+namespace detail {
+
+/**
+ * @brief Table of brute force kernels compiled for a given instruction set.
+ */
+struct BruteForceKernels
+{
+  void (*nn2L2Uchar)(const unsigned char*, int, const unsigned char*, int, int, NearestNeighbours2<int>*);
+  void (*nn2L2Float)(const float*, int, const float*, int, int, NearestNeighbours2<float>*);
+  void (*nn2Hamming)(const unsigned char*, int, const unsigned char*, int, int, NearestNeighbours2<int>*);
+};
+
+/// Kernels built with AVX2, nullptr if the compiler does not support it.
+const BruteForceKernels* getBruteForceKernelsAVX2();
+
+/// Kernels built with AVX-512, nullptr if the compiler does not support it.
+const BruteForceKernels* getBruteForceKernelsAVX512();
+
+} // namespace detail
+
+} // namespace matching
+} // namespace aliceVision
@@ -0,0 +1,178 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+// This translation unit is compiled with AVX2/FMA/POPCNT flags (see CMakeLists.txt).
+// Its kernels are only called after a runtime check of the CPU features.
+
+#include "bruteForceKernelsImpl.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+namespace aliceVision {
+namespace matching {
+namespace {
+
+inline int hsum(__m256i v)
+{
+  __m128i s = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+  s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+  s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtsi128_si32(s);
+}
+
+inline float hsum(__m256 v)
+{
+  __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+  s = _mm_add_ss(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 1, 1, 1)));
+  return _mm_cvtss_f32(s);
+}
+
+/// Accumulate the squared differences of 16 uint8 values (widened to int16) as 8 int32.
+inline __m256i sqrDiffU8(__m256i q, const unsigned char* b, __m256i acc)
+{
+  const __m256i d = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b)));
+  const __m256i diff = _mm256_sub_epi16(q, d);
+  return _mm256_add_epi32(acc, _mm256_madd_epi16(diff, diff));
+}
+
+struct L2UcharAVX2Kernel
+{
+  typedef L2ScalarKernel<unsigned char, int> Scalar;
+
+  static inline int maxDistance() { return Scalar::maxDistance(); }
+
+  static inline int distance1x1(const unsigned char* a, const unsigned char* b, int dimension)
+  {
+    __m256i acc = _mm256_setzero_si256();
+    int k = 0;
+    for(; k + 16 <= dimension; k += 16)
+    {
+      const __m256i q = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + k)));
+      acc = sqrDiffU8(q, b + k, acc);
+    }
+    return hsum(acc) + Scalar::distance1x1(a + k, b + k, dimension - k);
+  }
+
+  static inline void distance1x4(const unsigned char* a, const unsigned char* b, int dimension, int* out)
+  {
+    __m256i acc0 = _mm256_setzero_si256(), acc1 = acc0, acc2 = acc0, acc3 = acc0;
+    int k = 0;
+    for(; k + 16 <= dimension; k += 16)
+    {
+      const __m256i q = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + k)));
+      acc0 = sqrDiffU8(q, b + k, acc0);
+      acc1 = sqrDiffU8(q, b + dimension + k, acc1);
+      acc2 = sqrDiffU8(q, b + 2 * dimension + k, acc2);
+      acc3 = sqrDiffU8(q, b + 3 * dimension + k, acc3);
+    }
+    out[0] = hsum(acc0);
+    out[1] = hsum(acc1);
+    out[2] = hsum(acc2);
+    out[3] = hsum(acc3);
+    if(k < dimension)
+    {
+      for(int r = 0; r < 4; ++r)
+        out[r] += Scalar::distance1x1(a + k, b + r * dimension + k, dimension - k);
+    }
+  }
+};
+
+inline __m256 sqrDiffF32(__m256 q, const float* b, __m256 acc)
+{
+  const __m256 diff = _mm256_sub_ps(q, _mm256_loadu_ps(b));
+  return _mm256_fmadd_ps(diff, diff, acc);
+}
+
+struct L2FloatAVX2Kernel
+{
+  typedef L2ScalarKernel<float, float> Scalar;
+
+  static inline float maxDistance() { return Scalar::maxDistance(); }
+
+  static inline float distance1x1(const float* a, const float* b, int dimension)
+  {
+    __m256 acc = _mm256_setzero_ps();
+    int k = 0;
+    for(; k + 8 <= dimension; k += 8)
+      acc = sqrDiffF32(_mm256_loadu_ps(a + k), b + k, acc);
+    return hsum(acc) + Scalar::distance1x1(a + k, b + k, dimension - k);
+  }
+
+  static inline void distance1x4(const float* a, const float* b, int dimension, float* out)
+  {
+    __m256 acc0 = _mm256_setzero_ps(), acc1 = acc0, acc2 = acc0, acc3 = acc0;
+    int k = 0;
+    for(; k + 8 <= dimension; k += 8)
+    {
+      const __m256 q = _mm256_loadu_ps(a + k);
+      acc0 = sqrDiffF32(q, b + k, acc0);
+      acc1 = sqrDiffF32(q, b + dimension + k, acc1);
+      acc2 = sqrDiffF32(q, b + 2 * dimension + k, acc2);
+      acc3 = sqrDiffF32(q, b + 3 * dimension + k, acc3);
+    }
+    out[0] = hsum(acc0);
+    out[1] = hsum(acc1);
+    out[2] = hsum(acc2);
+    out[3] = hsum(acc3);
+    if(k < dimension)
+    {
+      for(int r = 0; r < 4; ++r)
+        out[r] += Scalar::distance1x1(a + k, b + r * dimension + k, dimension - k);
+    }
+  }
+};
+
+void nn2L2Uchar(const unsigned char* queries, int nbQueries, const unsigned char* database, int nbDatabase,
+                int dimension, NearestNeighbours2<int>* nearestNeighbours)
+{
+  tiledNN2<L2UcharAVX2Kernel>(queries, nbQueries, database, nbDatabase, dimension, nearestNeighbours);
+}
+
+void nn2L2Float(const float* queries, int nbQueries, const float* database, int nbDatabase,
+                int dimension, NearestNeighbours2<float>* nearestNeighbours)
+{
+  tiledNN2<L2FloatAVX2Kernel>(queries, nbQueries, database, nbDatabase, dimension, nearestNeighbours);
+}
+
+void nn2Hamming(const unsigned char* queries, int nbQueries, const unsigned char* database, int nbDatabase,
+                int nbBytes, NearestNeighbours2<int>* nearestNeighbours)
+{
+  tiledNN2<HammingPopcountKernel>(queries, nbQueries, database, nbDatabase, nbBytes, nearestNeighbours);
+}
+
+const detail::BruteForceKernels kernelsAVX2 = {&nn2L2Uchar, &nn2L2Float, &nn2Hamming};
+
+} // namespace
+
+namespace detail {
+
+const BruteForceKernels* getBruteForceKernelsAVX2()
+{
+  return &kernelsAVX2;
+}
+
+} // namespace detail
+} // namespace matching
+} // namespace aliceVision
+
+#else
+
+namespace aliceVision {
+namespace matching {
+namespace detail {
+
+const BruteForceKernels* getBruteForceKernelsAVX2()
+{
+  return nullptr;
+}
+
+} // namespace detail
+} // namespace matching
+} // namespace aliceVision
+
+#endif // __AVX2__
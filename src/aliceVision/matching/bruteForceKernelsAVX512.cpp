@@ -0,0 +1,164 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+// This translation unit is compiled with AVX-512 F/BW flags (see CMakeLists.txt).
+// Its kernels are only called after a runtime check of the CPU features.
+
+#include "bruteForceKernelsImpl.hpp"
+
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+#include <immintrin.h>
+
+namespace aliceVision {
+namespace matching {
+namespace {
+
+/// Accumulate the squared differences of 32 uint8 values (widened to int16) as 16 int32.
+inline __m512i sqrDiffU8(__m512i q, const unsigned char* b, __m512i acc)
+{
+  const __m512i d = _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b)));
+  const __m512i diff = _mm512_sub_epi16(q, d);
+  return _mm512_add_epi32(acc, _mm512_madd_epi16(diff, diff));
+}
+
+struct L2UcharAVX512Kernel
+{
+  typedef L2ScalarKernel<unsigned char, int> Scalar;
+
+  static inline int maxDistance() { return Scalar::maxDistance(); }
+
+  static inline int distance1x1(const unsigned char* a, const unsigned char* b, int dimension)
+  {
+    __m512i acc = _mm512_setzero_si512();
+    int k = 0;
+    for(; k + 32 <= dimension; k += 32)
+    {
+      const __m512i q = _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + k)));
+      acc = sqrDiffU8(q, b + k, acc);
+    }
+    return _mm512_reduce_add_epi32(acc) + Scalar::distance1x1(a + k, b + k, dimension - k);
+  }
+
+  static inline void distance1x4(const unsigned char* a, const unsigned char* b, int dimension, int* out)
+  {
+    __m512i acc0 = _mm512_setzero_si512(), acc1 = acc0, acc2 = acc0, acc3 = acc0;
+    int k = 0;
+    for(; k + 32 <= dimension; k += 32)
+    {
+      const __m512i q = _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + k)));
+      acc0 = sqrDiffU8(q, b + k, acc0);
+      acc1 = sqrDiffU8(q, b + dimension + k, acc1);
+      acc2 = sqrDiffU8(q, b + 2 * dimension + k, acc2);
+      acc3 = sqrDiffU8(q, b + 3 * dimension + k, acc3);
+    }
+    out[0] = _mm512_reduce_add_epi32(acc0);
+    out[1] = _mm512_reduce_add_epi32(acc1);
+    out[2] = _mm512_reduce_add_epi32(acc2);
+    out[3] = _mm512_reduce_add_epi32(acc3);
+    if(k < dimension)
+    {
+      for(int r = 0; r < 4; ++r)
+        out[r] += Scalar::distance1x1(a + k, b + r * dimension + k, dimension - k);
+    }
+  }
+};
+
+inline __m512 sqrDiffF32(__m512 q, const float* b, __m512 acc)
+{
+  const __m512 diff = _mm512_sub_ps(q, _mm512_loadu_ps(b));
+  return _mm512_fmadd_ps(diff, diff, acc);
+}
+
+struct L2FloatAVX512Kernel
+{
+  typedef L2ScalarKernel<float, float> Scalar;
+
+  static inline float maxDistance() { return Scalar::maxDistance(); }
+
+  static inline float distance1x1(const float* a, const float* b, int dimension)
+  {
+    __m512 acc = _mm512_setzero_ps();
+    int k = 0;
+    for(; k + 16 <= dimension; k += 16)
+      acc = sqrDiffF32(_mm512_loadu_ps(a + k), b + k, acc);
+    return _mm512_reduce_add_ps(acc) + Scalar::distance1x1(a + k, b + k, dimension - k);
+  }
+
+  static inline void distance1x4(const float* a, const float* b, int dimension, float* out)
+  {
+    __m512 acc0 = _mm512_setzero_ps(), acc1 = acc0, acc2 = acc0, acc3 = acc0;
+    int k = 0;
+    for(; k + 16 <= dimension; k += 16)
+    {
+      const __m512 q = _mm512_loadu_ps(a + k);
+      acc0 = sqrDiffF32(q, b + k, acc0);
+      acc1 = sqrDiffF32(q, b + dimension + k, acc1);
+      acc2 = sqrDiffF32(q, b + 2 * dimension + k, acc2);
+      acc3 = sqrDiffF32(q, b + 3 * dimension + k, acc3);
+    }
+    out[0] = _mm512_reduce_add_ps(acc0);
+    out[1] = _mm512_reduce_add_ps(acc1);
+    out[2] = _mm512_reduce_add_ps(acc2);
+    out[3] = _mm512_reduce_add_ps(acc3);
+    if(k < dimension)
+    {
+      for(int r = 0; r < 4; ++r)
+        out[r] += Scalar::distance1x1(a + k, b + r * dimension + k, dimension - k);
+    }
+  }
+};
+
+void nn2L2Uchar(const unsigned char* queries, int nbQueries, const unsigned char* database, int nbDatabase,
+                int dimension, NearestNeighbours2<int>* nearestNeighbours)
+{
+  tiledNN2<L2UcharAVX512Kernel>(queries, nbQueries, database, nbDatabase, dimension, nearestNeighbours);
+}
+
+void nn2L2Float(const float* queries, int nbQueries, const float* database, int nbDatabase,
+                int dimension, NearestNeighbours2<float>* nearestNeighbours)
+{
+  tiledNN2<L2FloatAVX512Kernel>(queries, nbQueries, database, nbDatabase, dimension, nearestNeighbours);
+}
+
+// Binary descriptors are short (32 to 64 bytes): the hardware 64-bit popcount is used,
+// AVX-512 VPOPCNTDQ would not pay off the horizontal reductions.
+void nn2Hamming(const unsigned char* queries, int nbQueries, const unsigned char* database, int nbDatabase,
+                int nbBytes, NearestNeighbours2<int>* nearestNeighbours)
+{
+  tiledNN2<HammingPopcountKernel>(queries, nbQueries, database, nbDatabase, nbBytes, nearestNeighbours);
+}
+
+const detail::BruteForceKernels kernelsAVX512 = {&nn2L2Uchar, &nn2L2Float, &nn2Hamming};
+
+} // namespace
+
+namespace detail {
+
+const BruteForceKernels* getBruteForceKernelsAVX512()
+{
+  return &kernelsAVX512;
+}
+
+} // namespace detail
+} // namespace matching
+} // namespace aliceVision
+
+#else
+
+namespace aliceVision {
+namespace matching {
+namespace detail {
+
+const BruteForceKernels* getBruteForceKernelsAVX512()
+{
+  return nullptr;
+}
+
+} // namespace detail
+} // namespace matching
+} // namespace aliceVision
+
+#endif // __AVX512F__ && __AVX512BW__
@@ -0,0 +1,226 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+// Private header, only included by the bruteForceKernels*.cpp translation units.
+// Each of them is compiled with different instruction set flags, so everything here
+// has internal linkage: an inline function emitted with AVX instructions must not be
+// picked by the linker for the generic code path.
+
+#include "bruteForceKernels.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace aliceVision {
+namespace matching {
+namespace {
+
+/// Number of queries processed against a database block.
+const int kQueryBlockSize = 32;
+/// Size in bytes of a database block, sized to stay in the L2 cache.
+const int kDatabaseBlockBytes = 256 * 1024;
+
+template <typename DistanceT>
+inline void insertNeighbour(NearestNeighbours2<DistanceT>& nn, int index, DistanceT distance)
+{
+  if(distance < nn.distances[1])
+  {
+    if(distance < nn.distances[0])
+    {
+      nn.distances[1] = nn.distances[0];
+      nn.indices[1] = nn.indices[0];
+      nn.distances[0] = distance;
+      nn.indices[0] = index;
+    }
+    else
+    {
+      nn.distances[1] = distance;
+      nn.indices[1] = index;
+    }
+  }
+}
+
+/**
+ * @brief Tiled top-2 search.
+ * Kernel must provide distance1x4 (one query against 4 consecutive database rows)
+ * and distance1x1.
+ */
+template <typename Kernel, typename T, typename DistanceT>
+void tiledNN2(const T* queries, int nbQueries,
+              const T* database, int nbDatabase,
+              int dimension,
+              NearestNeighbours2<DistanceT>* nearestNeighbours)
+{
+  const int rowBytes = dimension * static_cast<int>(sizeof(T));
+  int databaseBlockSize = (rowBytes > 0) ? (kDatabaseBlockBytes / rowBytes) & ~3 : nbDatabase;
+  if(databaseBlockSize < 4)
+    databaseBlockSize = 4;
+  const int nbQueryBlocks = (nbQueries + kQueryBlockSize - 1) / kQueryBlockSize;
+
+  #pragma omp parallel for schedule(dynamic)
+  for(int queryBlock = 0; queryBlock < nbQueryBlocks; ++queryBlock)
+  {
+    const int queryBegin = queryBlock * kQueryBlockSize;
+    const int queryEnd = (queryBegin + kQueryBlockSize < nbQueries) ? queryBegin + kQueryBlockSize : nbQueries;
+
+    for(int q = queryBegin; q < queryEnd; ++q)
+    {
+      NearestNeighbours2<DistanceT>& nn = nearestNeighbours[q];
+      nn.indices[0] = nn.indices[1] = -1;
+      nn.distances[0] = nn.distances[1] = Kernel::maxDistance();
+    }
+
+    for(int databaseBegin = 0; databaseBegin < nbDatabase; databaseBegin += databaseBlockSize)
+    {
+      const int databaseEnd = (databaseBegin + databaseBlockSize < nbDatabase) ? databaseBegin + databaseBlockSize : nbDatabase;
+
+      for(int q = queryBegin; q < queryEnd; ++q)
+      {
+        const T* query = queries + static_cast<std::size_t>(q) * dimension;
+        NearestNeighbours2<DistanceT> nn = nearestNeighbours[q];
+
+        int d = databaseBegin;
+        for(; d + 4 <= databaseEnd; d += 4)
+        {
+          DistanceT distances[4];
+          Kernel::distance1x4(query, database + static_cast<std::size_t>(d) * dimension, dimension, distances);
+          insertNeighbour(nn, d, distances[0]);
+          insertNeighbour(nn, d + 1, distances[1]);
+          insertNeighbour(nn, d + 2, distances[2]);
+          insertNeighbour(nn, d + 3, distances[3]);
+        }
+        for(; d < databaseEnd; ++d)
+          insertNeighbour(nn, d, Kernel::distance1x1(query, database + static_cast<std::size_t>(d) * dimension, dimension));
+
+        nearestNeighbours[q] = nn;
+      }
+    }
+  }
+}
+
+/**
+ * @brief Scalar squared L2 kernels, used for the tails and when no SIMD is available.
+ */
+template <typename T, typename DistanceT>
+struct L2ScalarKernel
+{
+  static inline DistanceT maxDistance() { return static_cast<DistanceT>(0x7fffffff); }
+
+  static inline DistanceT distance1x1(const T* a, const T* b, int dimension)
+  {
+    DistanceT result = 0;
+    for(int k = 0; k < dimension; ++k)
+    {
+      const DistanceT diff = static_cast<DistanceT>(a[k]) - static_cast<DistanceT>(b[k]);
+      result += diff * diff;
+    }
+    return result;
+  }
+
+  static inline void distance1x4(const T* a, const T* b, int dimension, DistanceT* out)
+  {
+    const T* b0 = b;
+    const T* b1 = b0 + dimension;
+    const T* b2 = b1 + dimension;
+    const T* b3 = b2 + dimension;
+    DistanceT r0 = 0, r1 = 0, r2 = 0, r3 = 0;
+    for(int k = 0; k < dimension; ++k)
+    {
+      const DistanceT q = static_cast<DistanceT>(a[k]);
+      const DistanceT d0 = q - static_cast<DistanceT>(b0[k]);
+      const DistanceT d1 = q - static_cast<DistanceT>(b1[k]);
+      const DistanceT d2 = q - static_cast<DistanceT>(b2[k]);
+      const DistanceT d3 = q - static_cast<DistanceT>(b3[k]);
+      r0 += d0 * d0;
+      r1 += d1 * d1;
+      r2 += d2 * d2;
+      r3 += d3 * d3;
+    }
+    out[0] = r0; out[1] = r1; out[2] = r2; out[3] = r3;
+  }
+};
+
+/// Float distances can go above the int range.
+template <>
+inline float L2ScalarKernel<float, float>::maxDistance() { return 3.402823466e+38F; }
+
+inline unsigned int popcount64(std::uint64_t n)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+  return static_cast<unsigned int>(__popcnt64(n));
+#elif defined(__GNUC__) || defined(__clang__)
+  return static_cast<unsigned int>(__builtin_popcountll(n));
+#else
+  n -= ((n >> 1) & 0x5555555555555555ULL);
+  n = (n & 0x3333333333333333ULL) + ((n >> 2) & 0x3333333333333333ULL);
+  return static_cast<unsigned int>((((n + (n >> 4)) & 0x0f0f0f0f0f0f0f0fULL) * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+inline std::uint64_t load64(const unsigned char* p)
+{
+  std::uint64_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+/**
+ * @brief Hamming kernels on 64-bit words.
+ * Compiled with -mpopcnt (AVX2/AVX-512 translation units), __builtin_popcountll maps to
+ * the hardware instruction, which is as fast as any vector popcount for short binary descriptors.
+ */
+struct HammingPopcountKernel
+{
+  static inline int maxDistance() { return 0x7fffffff; }
+
+  static inline int distance1x1(const unsigned char* a, const unsigned char* b, int nbBytes)
+  {
+    unsigned int result = 0;
+    int k = 0;
+    for(; k + 8 <= nbBytes; k += 8)
+      result += popcount64(load64(a + k) ^ load64(b + k));
+    for(; k < nbBytes; ++k)
+      result += popcount64(static_cast<std::uint64_t>(a[k] ^ b[k]));
+    return static_cast<int>(result);
+  }
+
+  static inline void distance1x4(const unsigned char* a, const unsigned char* b, int nbBytes, int* out)
+  {
+    const unsigned char* b0 = b;
+    const unsigned char* b1 = b0 + nbBytes;
+    const unsigned char* b2 = b1 + nbBytes;
+    const unsigned char* b3 = b2 + nbBytes;
+    unsigned int r0 = 0, r1 = 0, r2 = 0, r3 = 0;
+    int k = 0;
+    for(; k + 8 <= nbBytes; k += 8)
+    {
+      const std::uint64_t q = load64(a + k);
+      r0 += popcount64(q ^ load64(b0 + k));
+      r1 += popcount64(q ^ load64(b1 + k));
+      r2 += popcount64(q ^ load64(b2 + k));
+      r3 += popcount64(q ^ load64(b3 + k));
+    }
+    for(; k < nbBytes; ++k)
+    {
+      r0 += popcount64(static_cast<std::uint64_t>(a[k] ^ b0[k]));
+      r1 += popcount64(static_cast<std::uint64_t>(a[k] ^ b1[k]));
+      r2 += popcount64(static_cast<std::uint64_t>(a[k] ^ b2[k]));
+      r3 += popcount64(static_cast<std::uint64_t>(a[k] ^ b3[k]));
+    }
+    out[0] = static_cast<int>(r0); out[1] = static_cast<int>(r1);
+    out[2] = static_cast<int>(r2); out[3] = static_cast<int>(r3);
+  }
+};
+
+} // namespace
+} // namespace matching
+} // namespace aliceVision
@@ -7,6 +7,7 @@
 
 #include "aliceVision/matching/IndMatch.hpp"
 #include "aliceVision/matching/io.hpp"
+#include "aliceVision/matching/matchesBinIO.hpp"
 
 #include <boost/filesystem/operations.hpp>
 
@@ -108,6 +109,114 @@ BOOST_AUTO_TEST_CASE(IndMatch_IO)
   boost::filesystem::remove_all(testFolder);
 }
 
+BOOST_AUTO_TEST_CASE(IndMatch_IO_Binary)
+{
+  const std::string testFolder = "matchingBinTest";
+  boost::filesystem::create_directory(testFolder);
+  {
+    std::set<IndexT> viewsKeys;
+    PairwiseMatches matches;
+
+    // Test save + load of empty data
+    BOOST_CHECK(Save(matches, testFolder, "bin", false));
+    BOOST_CHECK(Load(matches, viewsKeys, {testFolder}, {}));
+    BOOST_CHECK_EQUAL(0, matches.size());
+  }
+  boost::filesystem::remove_all(testFolder);
+  boost::filesystem::create_directory(testFolder);
+  {
+    std::set<IndexT> viewsKeys = {0, 1, 2};
+    PairwiseMatches matches;
+    matches[std::make_pair(0,1)][EImageDescriberType::UNKNOWN] = {{0,0,0.5f},{1,1,0.25f}};
+    matches[std::make_pair(1,2)][EImageDescriberType::UNKNOWN] = {{0,0},{1,1}, {2,2}};
+    matches[std::make_pair(1,2)][EImageDescriberType::SIFT] = {{3,4}};
+
+    BOOST_CHECK(Save(matches, testFolder, "bin", true));
+    matches.clear();
+    BOOST_CHECK(Load(matches, viewsKeys, {testFolder}, {}));
+    BOOST_CHECK_EQUAL(2, matches.size());
+    BOOST_CHECK_EQUAL(2, matches.at(std::make_pair(0,1)).at(EImageDescriberType::UNKNOWN).size());
+    BOOST_CHECK_EQUAL(0.25f, matches.at(std::make_pair(0,1)).at(EImageDescriberType::UNKNOWN).at(1)._distanceRatio);
+    BOOST_CHECK_EQUAL(3, matches.at(std::make_pair(1,2)).at(EImageDescriberType::UNKNOWN).size());
+    BOOST_CHECK_EQUAL(1, matches.at(std::make_pair(1,2)).at(EImageDescriberType::SIFT).size());
+    BOOST_CHECK(IndMatch(3,4) == matches.at(std::make_pair(1,2)).at(EImageDescriberType::SIFT).front());
+  }
+  boost::filesystem::remove_all(testFolder);
+  boost::filesystem::create_directory(testFolder);
+  {
+    // Test random access and concurrent append
+    const std::string filepath = (fs::path(testFolder) / "matches.bin").string();
+    const int nbPairs = 100;
+    {
+      MatchesBinWriter writer(filepath);
+
+      #pragma omp parallel for
+      for(int i = 0; i < nbPairs; ++i)
+      {
+        MatchesPerDescType matchesPerDesc;
+        matchesPerDesc[EImageDescriberType::UNKNOWN] = IndMatches(i, IndMatch(i, i + 1));
+        writer.append(std::make_pair(i, i + 1), matchesPerDesc);
+      }
+
+      // a pair can't be written twice
+      BOOST_CHECK_THROW(writer.append(std::make_pair(0, 1), MatchesPerDescType()), std::exception);
+    }
+
+    const MatchesBinReader reader(filepath);
+    BOOST_CHECK_EQUAL(nbPairs, reader.getNbPairs());
+    BOOST_CHECK(!reader.hasPair(std::make_pair(1, 0)));
+
+    for(int i = nbPairs - 1; i >= 0; --i)
+    {
+      MatchesPerDescType matchesPerDesc;
+      BOOST_CHECK(reader.read(std::make_pair(i, i + 1), matchesPerDesc));
+      BOOST_CHECK_EQUAL(i, matchesPerDesc.getNbMatches(EImageDescriberType::UNKNOWN));
+      if(i > 0)
+        BOOST_CHECK(IndMatch(i, i + 1) == matchesPerDesc.at(EImageDescriberType::UNKNOWN).back());
+    }
+  }
+  boost::filesystem::remove_all(testFolder);
+  boost::filesystem::create_directory(testFolder);
+  {
+    // Test the merge per describer type of the same pair from two files
+    const std::string filepathA = (fs::path(testFolder) / "A.matches.bin").string();
+    const std::string filepathB = (fs::path(testFolder) / "B.matches.bin").string();
+    {
+      MatchesPerDescType matchesPerDesc;
+      matchesPerDesc[EImageDescriberType::UNKNOWN] = {{0,0},{1,1}};
+      MatchesBinWriter writer(filepathA);
+      writer.append(std::make_pair(0, 1), matchesPerDesc);
+    }
+    {
+      MatchesPerDescType matchesPerDesc;
+      matchesPerDesc[EImageDescriberType::SIFT] = {{2,3}};
+      MatchesBinWriter writer(filepathB);
+      writer.append(std::make_pair(0, 1), matchesPerDesc);
+    }
+
+    PairwiseMatches matches;
+    MatchesBinReader(filepathA).readAll(matches);
+    MatchesBinReader(filepathB).readAll(matches);
+    BOOST_CHECK_EQUAL(1, matches.size());
+    BOOST_CHECK_EQUAL(2, matches.at(std::make_pair(0,1)).at(EImageDescriberType::UNKNOWN).size());
+    BOOST_CHECK_EQUAL(1, matches.at(std::make_pair(0,1)).at(EImageDescriberType::SIFT).size());
+
+    // a corrupted pairs count (nbPairs * sizeof(MatchesBinPairEntry) overflows) is detected
+    {
+      MatchesBinHeader header;
+      {
+        std::ifstream file(filepathA, std::ios::binary);
+        file.read(reinterpret_cast<char*>(&header), sizeof(MatchesBinHeader));
+      }
+      header.nbPairs = std::uint64_t(1) << 62;
+      std::fstream file(filepathA, std::ios::in | std::ios::out | std::ios::binary);
+      file.write(reinterpret_cast<const char*>(&header), sizeof(MatchesBinHeader));
+    }
+    BOOST_CHECK_THROW(MatchesBinReader reader(filepathA), std::runtime_error);
+  }
+  boost::filesystem::remove_all(testFolder);
+}
+
 BOOST_AUTO_TEST_CASE(IndMatch_DuplicateRemoval_NoRemoval)
 {
   std::vector<IndMatch> vec_indMatch;
@@ -7,6 +7,7 @@
 
 #include "io.hpp"
 #include <aliceVision/matching/IndMatch.hpp>
+#include <aliceVision/matching/matchesBinIO.hpp>
 #include <aliceVision/config.hpp>
 #include <aliceVision/system/Logger.hpp>
 
@@ -71,6 +72,20 @@ bool LoadMatchFile(PairwiseMatches& matches, const std::string& filepath)
     stream.close();
     return true;
   }
+  else if(ext == ".bin")
+  {
+    try
+    {
+      const MatchesBinReader reader(filepath);
+      reader.readAll(matches);
+    }
+    catch(const std::exception& e)
+    {
+      ALICEVISION_LOG_WARNING(e.what());
+      return false;
+    }
+    return true;
+  }
   else
   {
     ALICEVISION_LOG_WARNING("Unknown matching file format: " << ext);
@@ -217,8 +232,6 @@ std::size_t loadMatchesFromFolder(PairwiseMatches& matches, const std::string& f
     ++nbLoadedMatchFiles;
     }   
   }
-  if(!nbLoadedMatchFiles)
-    ALICEVISION_LOG_WARNING("No matches file loaded in: " << folder);
   return nbLoadedMatchFiles;
 }
 
@@ -230,7 +243,7 @@ bool Load(PairwiseMatches& matches,
           int minNbMatches)
 {
   std::size_t nbLoadedMatchFiles = 0;
-  const std::string pattern = "matches.txt";
+  const std::vector<std::string> patterns = {"matches.txt", "matches.bin"};
 
   // build up a set with normalized paths to remove duplicates
   std::set<std::string> foldersSet;
@@ -239,7 +252,13 @@ bool Load(PairwiseMatches& matches,
 
   for(const auto& folder : foldersSet)
   {
-    nbLoadedMatchFiles += loadMatchesFromFolder(matches, folder, pattern);
+    std::size_t nbLoadedFolderMatchFiles = 0;
+    for(const auto& pattern : patterns)
+      nbLoadedFolderMatchFiles += loadMatchesFromFolder(matches, folder, pattern);
+
+    if(!nbLoadedFolderMatchFiles)
+      ALICEVISION_LOG_WARNING("No matches file loaded in: " << folder);
+    nbLoadedMatchFiles += nbLoadedFolderMatchFiles;
   }
 
   if(!nbLoadedMatchFiles)
@@ -310,6 +329,43 @@ private:
     fs::rename(tmpPath, filepath);
   }
 
+  void saveBin(
+    const std::string& filepath,
+    const PairwiseMatches::const_iterator& matchBegin,
+    const PairwiseMatches::const_iterator& matchEnd)
+  {
+    const fs::path bPath = fs::path(filepath);
+    const std::string tmpPath = (bPath.parent_path() / bPath.stem()).string() + "." + fs::unique_path().string() + bPath.extension().string();
+
+    // write temporary file
+    {
+      MatchesBinWriter writer(tmpPath);
+      for(PairwiseMatches::const_iterator match = matchBegin;
+        match != matchEnd;
+        ++match)
+      {
+        writer.append(match->first, match->second);
+      }
+      writer.close();
+    }
+
+    // rename temporary file
+    fs::rename(tmpPath, filepath);
+  }
+
+  void save(
+    const std::string& filepath,
+    const PairwiseMatches::const_iterator& matchBegin,
+    const PairwiseMatches::const_iterator& matchEnd)
+  {
+    if(m_ext == ".txt")
+      saveTxt(filepath, matchBegin, matchEnd);
+    else if(m_ext == ".bin")
+      saveBin(filepath, matchBegin, matchEnd);
+    else
+      throw std::runtime_error(std::string("Unknown matching file format: ") + m_ext);
+  }
+
 public:
   MatchExporter(
     const PairwiseMatches& matches,
@@ -326,11 +382,7 @@ public:
   void saveGlobalFile()
   {
     const std::string filepath = (fs::path(m_directory) / m_filename).string();
-
-    if(m_ext == ".txt")
-      saveTxt(filepath, m_matches.begin(), m_matches.end());
-    else
-      throw std::runtime_error(std::string("Unknown matching file format: ") + m_ext);
+    save(filepath, m_matches.begin(), m_matches.end());
   }
 
   /// Export matches into separate files, one for each image.
@@ -351,11 +403,7 @@ public:
         ++match;
       const std::string filepath = (fs::path(m_directory) / (std::to_string(key) + "." + m_filename)).string();
       ALICEVISION_LOG_DEBUG("Export Matches in: " << filepath);
-      
-      if(m_ext == ".txt")
-        saveTxt(filepath, matchBegin, match);
-      else
-        throw std::runtime_error(std::string("Unknown matching file format: ") + m_ext);
+      save(filepath, matchBegin, match);
 
       matchBegin = match;
     }
@@ -17,6 +17,7 @@ namespace matching {
 
 /**
  * @brief Load a match file.
+ *        The format is deduced from the extension: text (.txt) or binary (.bin).
  *
  * @param[out] matches container for the output matches
  * @param[in] filepath the match file to load
@@ -37,7 +38,7 @@ std::size_t LoadMatchFilePerImage(PairwiseMatches& matches,
                                   const std::string& extension);
 
 /**
- * @brief Load all the matches from the folder. Optionally filter the view, the type of descriptors
+ * @brief Load all the matches (text and binary files) from the folder. Optionally filter the view, the type of descriptors
  * and the number of matches.
  *
  * @param[out] matches container for the output matches.
@@ -0,0 +1,291 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "matchesBinIO.hpp"
+
+#include <aliceVision/system/Logger.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace matching {
+
+constexpr char MatchesBinHeader::magic[8];
+constexpr std::uint32_t MatchesBinHeader::currentVersion;
+constexpr std::uint32_t MatchesBinHeader::byteOrderMark;
+
+/// Size of a describer type name in the describer type table
+static const std::size_t descTypeNameSize = 32;
+
+MatchesBinHeader::MatchesBinHeader()
+{
+  std::memcpy(fileMagic, magic, sizeof(magic));
+}
+
+MatchesBinWriter::MatchesBinWriter(const std::string& filepath)
+  : _stream(filepath, std::ios::out | std::ios::binary)
+  , _filepath(filepath)
+{
+  if(!_stream.is_open())
+    throw std::runtime_error("Can't save matches file, can't open '" + filepath + "' !");
+
+  // write a placeholder header, updated on close
+  const MatchesBinHeader header;
+  _stream.write(reinterpret_cast<const char*>(&header), sizeof(MatchesBinHeader));
+  _offset = sizeof(MatchesBinHeader);
+}
+
+MatchesBinWriter::~MatchesBinWriter()
+{
+  try
+  {
+    close();
+  }
+  catch(const std::exception& e)
+  {
+    ALICEVISION_LOG_ERROR(e.what());
+  }
+}
+
+std::uint32_t MatchesBinWriter::getDescTypeIndex(feature::EImageDescriberType descType)
+{
+  const auto it = std::find(_descTypes.begin(), _descTypes.end(), descType);
+  if(it != _descTypes.end())
+    return static_cast<std::uint32_t>(std::distance(_descTypes.begin(), it));
+
+  _descTypes.push_back(descType);
+  return static_cast<std::uint32_t>(_descTypes.size() - 1);
+}
+
+void MatchesBinWriter::append(const Pair& pair, const MatchesPerDescType& matchesPerDesc)
+{
+  // pack the matches outside of the lock
+  std::vector<MatchesBinRecord> records;
+  records.reserve(matchesPerDesc.getNbAllMatches());
+
+  for(const auto& matchesIt : matchesPerDesc)
+  {
+    for(const IndMatch& match : matchesIt.second)
+    {
+      MatchesBinRecord record;
+      record.i = match._i;
+      record.j = match._j;
+      record.distanceRatio = match._distanceRatio;
+#ifdef ALICEVISION_DEBUG_MATCHING
+      record.distance = match._distance;
+#else
+      record.distance = 0.f;
+#endif
+      records.push_back(record);
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  if(!_stream.is_open())
+    throw std::runtime_error("Can't append matches to '" + _filepath + "', the file is closed !");
+
+  if(_pairTable.count(pair))
+    throw std::runtime_error("Can't append matches to '" + _filepath + "', the pair (" + std::to_string(pair.first) + ", " + std::to_string(pair.second) + ") has already been written !");
+
+  MatchesBinPairEntry entry;
+  entry.I = pair.first;
+  entry.J = pair.second;
+  entry.nbBlocks = static_cast<std::uint32_t>(matchesPerDesc.size());
+  entry.reserved = 0;
+  entry.offset = _offset;
+  entry.nbMatches = records.size();
+
+  std::size_t recordIndex = 0;
+  for(const auto& matchesIt : matchesPerDesc)
+  {
+    MatchesBinBlock block;
+    block.descTypeIndex = getDescTypeIndex(matchesIt.first);
+    block.reserved = 0;
+    block.nbMatches = matchesIt.second.size();
+
+    _stream.write(reinterpret_cast<const char*>(&block), sizeof(MatchesBinBlock));
+    _stream.write(reinterpret_cast<const char*>(records.data() + recordIndex), block.nbMatches * sizeof(MatchesBinRecord));
+
+    recordIndex += block.nbMatches;
+    _offset += sizeof(MatchesBinBlock) + block.nbMatches * sizeof(MatchesBinRecord);
+  }
+
+  if(!_stream.good())
+    throw std::runtime_error("Can't save matches file, '" + _filepath + "' is incorrect !");
+
+  _pairTable.emplace(pair, entry);
+}
+
+void MatchesBinWriter::close()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  if(!_stream.is_open())
+    return;
+
+  MatchesBinHeader header;
+  header.nbPairs = _pairTable.size();
+  header.pairTableOffset = _offset;
+  header.nbDescTypes = static_cast<std::uint32_t>(_descTypes.size());
+  header.descTypeTableOffset = _offset + _pairTable.size() * sizeof(MatchesBinPairEntry);
+
+  // pair table (sorted by pair)
+  for(const auto& entryIt : _pairTable)
+    _stream.write(reinterpret_cast<const char*>(&entryIt.second), sizeof(MatchesBinPairEntry));
+
+  // describer type table
+  for(const feature::EImageDescriberType descType : _descTypes)
+  {
+    char name[descTypeNameSize] = {0};
+    const std::string descTypeName = feature::EImageDescriberType_enumToString(descType);
+    std::memcpy(name, descTypeName.c_str(), std::min(descTypeName.size(), descTypeNameSize - 1));
+    _stream.write(name, descTypeNameSize);
+  }
+
+  // final header
+  _stream.seekp(0);
+  _stream.write(reinterpret_cast<const char*>(&header), sizeof(MatchesBinHeader));
+
+  const bool good = _stream.good();
+  _stream.close();
+
+  if(!good)
+    throw std::runtime_error("Can't save matches file, '" + _filepath + "' is incorrect !");
+}
+
+MatchesBinReader::MatchesBinReader(const std::string& filepath)
+  : _file(filepath)
+{
+  if(_file.size() < sizeof(MatchesBinHeader))
+    throw std::runtime_error("Can't load matches file, '" + filepath + "' is incorrect !");
+
+  MatchesBinHeader header;
+  std::memcpy(&header, _file.data(), sizeof(MatchesBinHeader));
+
+  if(std::memcmp(header.fileMagic, MatchesBinHeader::magic, sizeof(MatchesBinHeader::magic)) != 0)
+    throw std::runtime_error("Can't load matches file, '" + filepath + "' is not a binary matches file !");
+
+  if(header.fileByteOrderMark != MatchesBinHeader::byteOrderMark)
+    throw std::runtime_error("Can't load matches file, '" + filepath + "' has been written with a different endianness !");
+
+  if(header.version > MatchesBinHeader::currentVersion)
+    throw std::runtime_error("Can't load matches file, '" + filepath + "' has an unsupported version (" + std::to_string(header.version) + ") !");
+
+  // the counts and offsets come from the file: check the sizes without overflow
+  if(header.pairTableOffset > _file.size() ||
+     header.nbPairs > (_file.size() - header.pairTableOffset) / sizeof(MatchesBinPairEntry) ||
+     header.descTypeTableOffset > _file.size() ||
+     header.nbDescTypes > (_file.size() - header.descTypeTableOffset) / descTypeNameSize)
+    throw std::runtime_error("Can't load matches file, '" + filepath + "' is truncated !");
+
+  _nbPairs = header.nbPairs;
+  _pairTable = reinterpret_cast<const MatchesBinPairEntry*>(_file.data() + header.pairTableOffset);
+
+  _descTypes.reserve(header.nbDescTypes);
+  for(std::size_t i = 0; i < header.nbDescTypes; ++i)
+  {
+    const char* name = _file.data() + header.descTypeTableOffset + i * descTypeNameSize;
+    _descTypes.push_back(feature::EImageDescriberType_stringToEnum(std::string(name, strnlen(name, descTypeNameSize))));
+  }
+}
+
+PairSet MatchesBinReader::getPairs() const
+{
+  PairSet pairs;
+  for(std::size_t i = 0; i < _nbPairs; ++i)
+    pairs.emplace_hint(pairs.end(), _pairTable[i].I, _pairTable[i].J);
+  return pairs;
+}
+
+const MatchesBinPairEntry* MatchesBinReader::findPair(const Pair& pair) const
+{
+  const MatchesBinPairEntry* end = _pairTable + _nbPairs;
+  const MatchesBinPairEntry* it = std::lower_bound(_pairTable, end, pair,
+    [](const MatchesBinPairEntry& entry, const Pair& p)
+    {
+      return Pair(entry.I, entry.J) < p;
+    });
+
+  if(it == end || it->I != pair.first || it->J != pair.second)
+    return nullptr;
+  return it;
+}
+
+void MatchesBinReader::readEntry(const MatchesBinPairEntry& entry, MatchesPerDescType& matchesPerDesc) const
+{
+  // the describer types read from this entry replace the existing ones, the others are kept
+  std::vector<bool> descTypeRead(_descTypes.size(), false);
+
+  std::uint64_t offset = entry.offset;
+  for(std::uint32_t b = 0; b < entry.nbBlocks; ++b)
+  {
+    if(offset > _file.size() || sizeof(MatchesBinBlock) > _file.size() - offset)
+      throw std::runtime_error("Can't load matches file, '" + _file.path() + "' is truncated !");
+
+    MatchesBinBlock block;
+    std::memcpy(&block, _file.data() + offset, sizeof(MatchesBinBlock));
+    offset += sizeof(MatchesBinBlock);
+
+    if(block.descTypeIndex >= _descTypes.size() ||
+       block.nbMatches > (_file.size() - offset) / sizeof(MatchesBinRecord))
+      throw std::runtime_error("Can't load matches file, '" + _file.path() + "' is incorrect !");
+
+    const MatchesBinRecord* records = reinterpret_cast<const MatchesBinRecord*>(_file.data() + offset);
+    IndMatches& matches = matchesPerDesc[_descTypes[block.descTypeIndex]];
+    if(!descTypeRead[block.descTypeIndex])
+    {
+      matches.clear();
+      descTypeRead[block.descTypeIndex] = true;
+    }
+    matches.reserve(matches.size() + block.nbMatches);
+
+    for(std::uint64_t m = 0; m < block.nbMatches; ++m)
+    {
+      const MatchesBinRecord& record = records[m];
+#ifdef ALICEVISION_DEBUG_MATCHING
+      matches.emplace_back(record.i, record.j, record.distanceRatio, record.distance);
+#else
+      matches.emplace_back(record.i, record.j, record.distanceRatio);
+#endif
+    }
+    offset += block.nbMatches * sizeof(MatchesBinRecord);
+  }
+}
+
+bool MatchesBinReader::read(const Pair& pair, MatchesPerDescType& matchesPerDesc) const
+{
+  const MatchesBinPairEntry* entry = findPair(pair);
+  if(entry == nullptr)
+    return false;
+  matchesPerDesc.clear();
+  readEntry(*entry, matchesPerDesc);
+  return true;
+}
+
+void MatchesBinReader::readAt(std::size_t pairIndex, Pair& pair, MatchesPerDescType& matchesPerDesc) const
+{
+  if(pairIndex >= _nbPairs)
+    throw std::out_of_range("Invalid pair index " + std::to_string(pairIndex) + " in matches file '" + _file.path() + "' !");
+  const MatchesBinPairEntry& entry = _pairTable[pairIndex];
+  pair = Pair(entry.I, entry.J);
+  matchesPerDesc.clear();
+  readEntry(entry, matchesPerDesc);
+}
+
+void MatchesBinReader::readAll(PairwiseMatches& matches) const
+{
+  for(std::size_t i = 0; i < _nbPairs; ++i)
+  {
+    const MatchesBinPairEntry& entry = _pairTable[i];
+    readEntry(entry, matches[Pair(entry.I, entry.J)]);
+  }
+}
+
+}  // namespace matching
+}  // namespace aliceVision
@@ -0,0 +1,197 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/matching/IndMatch.hpp>
+#include <aliceVision/system/MemoryMappedFile.hpp>
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace matching {
+
+/**
+ * @brief Binary matches file (.bin) layout.
+ *
+ * - header (64 bytes)
+ * - matches blocks: for each pair and each describer type, a MatchesBinBlock
+ *   followed by the packed MatchesBinRecord array
+ * - pair table: one MatchesBinPairEntry per pair, sorted by pair
+ * - describer type table: one 32 bytes name per describer type
+ */
+struct MatchesBinHeader
+{
+  /// magic number to identify a binary matches file
+  static constexpr char magic[8] = {'A', 'V', 'M', 'A', 'T', 'C', 'H', '\0'};
+  /// current version of the binary matches file
+  static constexpr std::uint32_t currentVersion = 1;
+  /// byte order mark, to detect a file written on a machine with a different endianness
+  static constexpr std::uint32_t byteOrderMark = 0x01020304;
+
+  char fileMagic[8];
+  std::uint32_t version = currentVersion;
+  std::uint32_t fileByteOrderMark = byteOrderMark;
+  std::uint64_t nbPairs = 0;
+  std::uint64_t pairTableOffset = 0;
+  std::uint64_t descTypeTableOffset = 0;
+  std::uint32_t nbDescTypes = 0;
+  std::uint32_t reserved0 = 0;
+  std::uint64_t reserved1 = 0;
+  std::uint64_t reserved2 = 0;
+
+  MatchesBinHeader();
+};
+
+/// Matches of one describer type for one pair
+struct MatchesBinBlock
+{
+  std::uint32_t descTypeIndex; //< index in the describer type table
+  std::uint32_t reserved;
+  std::uint64_t nbMatches;
+};
+
+/// Packed IndMatch
+struct MatchesBinRecord
+{
+  std::uint32_t i;
+  std::uint32_t j;
+  float distanceRatio;
+  float distance;
+};
+
+/// Entry of the pair table
+struct MatchesBinPairEntry
+{
+  std::uint32_t I;
+  std::uint32_t J;
+  std::uint32_t nbBlocks; //< number of describer types
+  std::uint32_t reserved;
+  std::uint64_t offset;   //< offset of the first block of the pair
+  std::uint64_t nbMatches; //< number of matches of the pair (all describer types)
+};
+
+static_assert(sizeof(MatchesBinHeader) == 64, "The binary matches file header should be 64 bytes long.");
+static_assert(sizeof(MatchesBinBlock) == 16, "Unexpected binary matches block size.");
+static_assert(sizeof(MatchesBinRecord) == 16, "Unexpected binary matches record size.");
+static_assert(sizeof(MatchesBinPairEntry) == 32, "Unexpected binary matches pair entry size.");
+
+/**
+ * @brief Write a binary matches file.
+ *
+ * Pairs are streamed to the file with append(), the pair table is written on close().
+ * append() can be called concurrently from several threads.
+ */
+class MatchesBinWriter
+{
+public:
+  /**
+   * @brief Create the binary matches file.
+   * @param[in] filepath The output file path
+   * @throw std::runtime_error if the file can't be opened
+   */
+  explicit MatchesBinWriter(const std::string& filepath);
+
+  /**
+   * @brief Write the pair table and close the file if not already done.
+   */
+  ~MatchesBinWriter();
+
+  /**
+   * @brief Append the matches of a pair to the file.
+   * @param[in] pair The image pair
+   * @param[in] matchesPerDesc The matches of the pair per describer type
+   * @throw std::runtime_error if the pair has already been written
+   */
+  void append(const Pair& pair, const MatchesPerDescType& matchesPerDesc);
+
+  /**
+   * @brief Write the pair and describer type tables and close the file.
+   */
+  void close();
+
+private:
+  std::uint32_t getDescTypeIndex(feature::EImageDescriberType descType);
+
+  std::ofstream _stream;
+  std::string _filepath;
+  std::mutex _mutex;
+  std::map<Pair, MatchesBinPairEntry> _pairTable;
+  std::vector<feature::EImageDescriberType> _descTypes;
+  std::uint64_t _offset = 0;
+};
+
+/**
+ * @brief Read a binary matches file.
+ *
+ * The file is memory mapped, matches of a given pair can be read without
+ * parsing the rest of the file.
+ */
+class MatchesBinReader
+{
+public:
+  /**
+   * @brief Map the binary matches file and read its pair table.
+   * @param[in] filepath The input file path
+   * @throw std::runtime_error if the file is not a valid binary matches file
+   */
+  explicit MatchesBinReader(const std::string& filepath);
+
+  /**
+   * @brief Get the number of pairs stored in the file.
+   */
+  std::size_t getNbPairs() const { return _nbPairs; }
+
+  /**
+   * @brief Get the image pairs stored in the file.
+   */
+  PairSet getPairs() const;
+
+  /**
+   * @brief Is the given pair stored in the file.
+   */
+  bool hasPair(const Pair& pair) const { return findPair(pair) != nullptr; }
+
+  /**
+   * @brief Read the matches of one pair.
+   * @param[in] pair The image pair
+   * @param[out] matchesPerDesc The matches of the pair per describer type
+   * @return false if the pair is not stored in the file
+   */
+  bool read(const Pair& pair, MatchesPerDescType& matchesPerDesc) const;
+
+  /**
+   * @brief Read the matches of the pair stored at the given index (pairs are sorted).
+   * @param[in] pairIndex The pair index in [0, getNbPairs()[
+   * @param[out] pair The image pair
+   * @param[out] matchesPerDesc The matches of the pair per describer type
+   */
+  void readAt(std::size_t pairIndex, Pair& pair, MatchesPerDescType& matchesPerDesc) const;
+
+  /**
+   * @brief Read the matches of all the pairs.
+   * @param[in,out] matches The matches per pair, merged per describer type like the text format
+   *                        (the describer types of an existing pair stored in the file are replaced, the others are kept)
+   */
+  void readAll(PairwiseMatches& matches) const;
+
+private:
+  const MatchesBinPairEntry* findPair(const Pair& pair) const;
+  void readEntry(const MatchesBinPairEntry& entry, MatchesPerDescType& matchesPerDesc) const;
+
+  system::MemoryMappedFile _file;
+  const MatchesBinPairEntry* _pairTable = nullptr;
+  std::size_t _nbPairs = 0;
+  std::vector<feature::EImageDescriberType> _descTypes;
+};
+
+}  // namespace matching
+}  // namespace aliceVision
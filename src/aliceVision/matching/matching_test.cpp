@@ -9,7 +9,10 @@
 #include "aliceVision/matching/ArrayMatcher_bruteForce.hpp"
 #include "aliceVision/matching/ArrayMatcher_kdtreeFlann.hpp"
 #include "aliceVision/matching/ArrayMatcher_cascadeHashing.hpp"
+#include "aliceVision/matching/bruteForceKernels.hpp"
+#include "aliceVision/feature/Hamming.hpp"
 #include <iostream>
+#include <random>
 
 #define BOOST_TEST_MODULE matching
 
@@ -115,6 +118,135 @@ BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_kdtreeFlann_Simple__NN)
   BOOST_CHECK_EQUAL(IndMatch(0,4), vec_nIndice[4]);
 }
 
+/// Check the 2 nearest neighbours found by the SIMD kernels against the per-pair metric.
+template <typename T, typename DistanceT, typename Metric, typename NN2Function>
+void checkBruteForceNN2(const std::vector<T>& queries, const std::vector<T>& database, int dimension,
+                        const Metric& metric, NN2Function nn2Function, double tolerance)
+{
+  const int nbQueries = queries.size() / dimension;
+  const int nbDatabase = database.size() / dimension;
+
+  for(system::ESimdLevel level : {system::ESimdLevel::NONE, system::ESimdLevel::SSE2, system::ESimdLevel::AVX2, system::ESimdLevel::AVX512})
+  {
+    if(level > system::getSimdLevel())
+      break;
+
+    std::vector<NearestNeighbours2<DistanceT> > nearestNeighbours(nbQueries);
+    nn2Function(&queries[0], nbQueries, &database[0], nbDatabase, dimension, &nearestNeighbours[0], level);
+
+    for(int q = 0; q < nbQueries; ++q)
+    {
+      std::vector<double> distances(nbDatabase);
+      for(int d = 0; d < nbDatabase; ++d)
+        distances[d] = metric(&queries[q * dimension], &database[d * dimension], dimension);
+      std::vector<double> sorted = distances;
+      std::partial_sort(sorted.begin(), sorted.begin() + 2, sorted.end());
+
+      const NearestNeighbours2<DistanceT>& nn = nearestNeighbours[q];
+      BOOST_CHECK_CLOSE_FRACTION(sorted[0], static_cast<double>(nn.distances[0]), tolerance);
+      BOOST_CHECK_CLOSE_FRACTION(sorted[1], static_cast<double>(nn.distances[1]), tolerance);
+      BOOST_CHECK_NE(nn.indices[0], nn.indices[1]);
+      BOOST_CHECK_CLOSE_FRACTION(distances[nn.indices[0]], static_cast<double>(nn.distances[0]), tolerance);
+      BOOST_CHECK_CLOSE_FRACTION(distances[nn.indices[1]], static_cast<double>(nn.distances[1]), tolerance);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Matching_bruteForceKernels_NN2)
+{
+  std::mt19937 randomNumberGenerator(42);
+  std::uniform_int_distribution<int> byteDistribution(0, 255);
+  std::uniform_real_distribution<float> floatDistribution(-1.f, 1.f);
+
+  const int nbQueries = 70;
+  const int nbDatabase = 1003;
+
+  // uint8 SIFT-like descriptors
+  {
+    const int dimension = 128;
+    std::vector<unsigned char> queries(nbQueries * dimension), database(nbDatabase * dimension);
+    for(unsigned char& v : queries) v = byteDistribution(randomNumberGenerator);
+    for(unsigned char& v : database) v = byteDistribution(randomNumberGenerator);
+    void (*nn2)(const unsigned char*, int, const unsigned char*, int, int, NearestNeighbours2<int>*, system::ESimdLevel) = &bruteForceNN2L2;
+    checkBruteForceNN2<unsigned char, int>(queries, database, dimension, feature::L2_Simple<unsigned char>(), nn2, 0.0);
+  }
+  // float descriptors, with a dimension that is not a multiple of the SIMD width
+  {
+    const int dimension = 37;
+    std::vector<float> queries(nbQueries * dimension), database(nbDatabase * dimension);
+    for(float& v : queries) v = floatDistribution(randomNumberGenerator);
+    for(float& v : database) v = floatDistribution(randomNumberGenerator);
+    void (*nn2)(const float*, int, const float*, int, int, NearestNeighbours2<float>*, system::ESimdLevel) = &bruteForceNN2L2;
+    checkBruteForceNN2<float, float>(queries, database, dimension, feature::L2_Simple<float>(), nn2, 1e-5);
+  }
+  // binary descriptors
+  {
+    const int nbBytes = 61;
+    std::vector<unsigned char> queries(nbQueries * nbBytes), database(nbDatabase * nbBytes);
+    for(unsigned char& v : queries) v = byteDistribution(randomNumberGenerator);
+    for(unsigned char& v : database) v = byteDistribution(randomNumberGenerator);
+    checkBruteForceNN2<unsigned char, int>(queries, database, nbBytes, feature::Hamming<unsigned char>(), &bruteForceNN2Hamming, 0.0);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_bruteForce_NN2_uchar)
+{
+  const unsigned char array[] = {0, 10, 20, 50, 60};
+  ArrayMatcher_bruteForce<unsigned char, feature::L2_Vectorized<unsigned char> > matcher;
+  BOOST_CHECK( matcher.Build(array, 5, 1) );
+
+  const unsigned char query[] = {22, 58};
+  IndMatches vec_nIndice;
+  vector<float> vec_fDistance;
+  BOOST_CHECK( matcher.SearchNeighbours(query, 2, &vec_nIndice, &vec_fDistance, 2) );
+
+  BOOST_CHECK_EQUAL( 4, vec_nIndice.size());
+  BOOST_CHECK_EQUAL(IndMatch(0,2), vec_nIndice[0]);
+  BOOST_CHECK_EQUAL(IndMatch(0,1), vec_nIndice[1]);
+  BOOST_CHECK_EQUAL(IndMatch(1,4), vec_nIndice[2]);
+  BOOST_CHECK_EQUAL(IndMatch(1,3), vec_nIndice[3]);
+  BOOST_CHECK_SMALL(static_cast<double>(vec_fDistance[0] - 4.0f), 1e-6);
+  BOOST_CHECK_SMALL(static_cast<double>(vec_fDistance[1] - 144.0f), 1e-6);
+  BOOST_CHECK_SMALL(static_cast<double>(vec_fDistance[2] - 4.0f), 1e-6);
+  BOOST_CHECK_SMALL(static_cast<double>(vec_fDistance[3] - 64.0f), 1e-6);
+}
+
+BOOST_AUTO_TEST_CASE(Matching_Cascade_Hashing_NN)
+{
+  std::mt19937 randomNumberGenerator(42);
+  std::uniform_real_distribution<float> descDistribution(0.f, 1.f);
+  std::normal_distribution<float> noiseDistribution(0.f, 0.01f);
+
+  const int dimension = 128;
+  const int nbDescriptors = 2000;
+  std::vector<float> database(nbDescriptors * dimension);
+  for(float& v : database) v = descDistribution(randomNumberGenerator);
+
+  // the queries are the noisy database descriptors, in reverse order
+  std::vector<float> queries(nbDescriptors * dimension);
+  for(int i = 0; i < nbDescriptors; ++i)
+    for(int k = 0; k < dimension; ++k)
+      queries[i * dimension + k] = database[(nbDescriptors - 1 - i) * dimension + k] + noiseDistribution(randomNumberGenerator);
+
+  ArrayMatcher_cascadeHashing<float> matcher;
+  BOOST_CHECK( matcher.Build(&database[0], nbDescriptors, dimension) );
+
+  IndMatches vec_nIndice;
+  vector<float> vec_fDistance;
+  BOOST_CHECK( matcher.SearchNeighbours(&queries[0], nbDescriptors, &vec_nIndice, &vec_fDistance, 2) );
+  BOOST_CHECK_EQUAL(vec_nIndice.size(), vec_fDistance.size());
+
+  int nbFound = 0;
+  for(std::size_t k = 0; k < vec_nIndice.size(); k += 2)
+  {
+    BOOST_CHECK_LE(vec_fDistance[k], vec_fDistance[k + 1]);
+    if(vec_nIndice[k]._j == nbDescriptors - 1 - vec_nIndice[k]._i)
+      ++nbFound;
+  }
+  // descriptors close to each other fall in the same buckets
+  BOOST_CHECK_GT(nbFound, 0.95 * nbDescriptors);
+}
+
 //-- Test LIMIT case (empty arrays)
 
 BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_bruteForce_Simple_EmptyArrays)
@@ -732,9 +732,10 @@ void saveCCTag2SVG(const std::string &inputImagePath,
   const float strokeWidth = getStrokeEstimate(imageSize);
     
   const auto &feat = cctags.Features();
-  const auto &desc = cctags.Descriptors();
+  // the descriptors may be memory mapped, read them through the raw data
+  const auto *desc = static_cast<const feature::CCTAG_Regions::DescriptorT*>(cctags.DescriptorRawData());
   
-  for(std::size_t i = 0; i < desc.size(); ++i) 
+  for(std::size_t i = 0; i < feat.size(); ++i) 
   {
     const IndexT cctagId = feature::getCCTagId(desc[i]);
     if ( cctagId == UndefinedIndexT)
@@ -770,12 +771,9 @@ void saveCCTagMatches2SVG(const std::string &imagePathLeft,
 
   const auto &keypointsLeft = cctagLeft.Features();
   const auto &keypointsRight = cctagRight.Features();
-  const auto &descLeft = cctagLeft.Descriptors();
-  const auto &descRight = cctagRight.Descriptors();
-  
-  //just to be sure...
-  assert(keypointsLeft.size() == descLeft.size());
-  assert(keypointsRight.size() == descRight.size());
+  // the descriptors may be memory mapped, read them through the raw data
+  const auto *descLeft = static_cast<const feature::CCTAG_Regions::DescriptorT*>(cctagLeft.DescriptorRawData());
+  const auto *descRight = static_cast<const feature::CCTAG_Regions::DescriptorT*>(cctagRight.DescriptorRawData());
   
   const float radiusLeft = getRadiusEstimate(imageSizeLeft);
   const float radiusRight = getRadiusEstimate(imageSizeRight);
@@ -821,7 +819,7 @@ void saveCCTagMatches2SVG(const std::string &imagePathLeft,
       if(found)
         continue;
       
-      assert(i < descLeft.size());
+      assert(i < keypointsLeft.size());
       // find the cctag id
       const IndexT cctagIdLeft = feature::getCCTagId(descLeft[i]);
       if(cctagIdLeft == UndefinedIndexT)
@@ -848,7 +846,7 @@ void saveCCTagMatches2SVG(const std::string &imagePathLeft,
       if(found)
         continue;
       
-      assert(i < descRight.size());
+      assert(i < keypointsRight.size());
       // find the cctag id
       const IndexT cctagIdRight = feature::getCCTagId(descRight[i]);
       if(cctagIdRight == UndefinedIndexT)
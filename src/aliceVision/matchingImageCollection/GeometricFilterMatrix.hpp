@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <aliceVision/robustEstimation/ACRansac.hpp>
+
 namespace aliceVision {
 
 
@@ -30,10 +32,12 @@ struct GeometricFilterMatrix
 {
   GeometricFilterMatrix(double precision,
                         double precisionRobust,
-                        std::size_t stIteration)
+                        std::size_t stIteration,
+                        robustEstimation::EACRansacMode acRansacMode = robustEstimation::EACRansacMode::EXACT)
     : m_dPrecision(precision)
     , m_dPrecision_robust(precisionRobust)
     , m_stIteration(stIteration)
+    , m_acRansacMode(acRansacMode)
   {}
 
   /**
@@ -58,6 +62,7 @@ struct GeometricFilterMatrix
   double m_dPrecision;  //upper_bound precision used for robust estimation
   double m_dPrecision_robust;
   std::size_t m_stIteration; //maximal number of iteration for robust estimation
+  robustEstimation::EACRansacMode m_acRansacMode; //NFA evaluation mode of the a contrario robust estimation
 };
 
 
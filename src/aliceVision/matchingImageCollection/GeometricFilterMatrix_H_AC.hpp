@@ -28,8 +28,9 @@ namespace matchingImageCollection {
 struct GeometricFilterMatrix_H_AC : public GeometricFilterMatrix
 {
   GeometricFilterMatrix_H_AC(double dPrecision = std::numeric_limits<double>::infinity(),
-                             std::size_t iteration = 1024)
-    : GeometricFilterMatrix(dPrecision, std::numeric_limits<double>::infinity(), iteration)
+                             std::size_t iteration = 1024,
+                             robustEstimation::EACRansacMode acRansacMode = robustEstimation::EACRansacMode::EXACT)
+    : GeometricFilterMatrix(dPrecision, std::numeric_limits<double>::infinity(), iteration, acRansacMode)
     , m_H(Mat3::Identity())
   {}
 
@@ -77,7 +78,7 @@ struct GeometricFilterMatrix_H_AC : public GeometricFilterMatrix
 
     std::vector<std::size_t> inliers;
     robustEstimation::Mat3Model model;
-    const std::pair<double,double> ACRansacOut = robustEstimation::ACRANSAC(kernel, inliers, m_stIteration, &model, upperBoundPrecision);
+    const std::pair<double,double> ACRansacOut = robustEstimation::ACRANSAC(kernel, inliers, m_stIteration, &model, upperBoundPrecision, m_acRansacMode);
     m_H = model.getMatrix();
 
     if (inliers.empty())
@@ -9,7 +9,9 @@
 #include <aliceVision/matching/ArrayMatcher_cascadeHashing.hpp>
 #include <aliceVision/matching/IndMatchDecorator.hpp>
 #include <aliceVision/matching/filters.hpp>
+#include <aliceVision/matchingImageCollection/pairScheduler.hpp>
 #include <aliceVision/config.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <boost/progress.hpp>
 
@@ -43,12 +45,8 @@ void Match
 
   // Collect used view indexes
   std::set<IndexT> used_index;
-  // Sort pairs according the first index to minimize later memory swapping
-  typedef std::map<IndexT, std::vector<IndexT> > Map_vectorT;
-  Map_vectorT map_Pairs;
   for (PairSet::const_iterator iter = pairs.begin(); iter != pairs.end(); ++iter)
   {
-    map_Pairs[iter->first].push_back(iter->second);
     used_index.insert(iter->first);
     used_index.insert(iter->second);
   }
@@ -115,93 +113,96 @@ void Match
     }
   }
 
+  // Per thread state: reusable matching buffers and resulting matches
+  struct ThreadData
+  {
+    CascadeHasher::MatchingBuffers matchingBuffers;
+    PairwiseMatches matches;
+  };
+  PairScheduler scheduler(pairs);
+  std::vector<ThreadData> threadsData(scheduler.getNbThreads());
+
   // Perform matching between all the pairs
-  for (Map_vectorT::const_iterator iter = map_Pairs.begin();
-    iter != map_Pairs.end(); ++iter)
+  scheduler.run([&](const Pair& pair, int threadId)
   {
-    const IndexT I = iter->first;
-    const std::vector<IndexT> & indexToCompare = iter->second;
+    const IndexT I = pair.first;
+    const IndexT J = pair.second;
+    ThreadData& threadData = threadsData[threadId];
+
+    if (!regionsPerView.viewExist(J))
+      return;
 
     const feature::Regions &regionsI = regionsPerView.getRegions(I, descType);
-    if (regionsI.RegionCount() == 0)
+    const feature::Regions &regionsJ = regionsPerView.getRegions(J, descType);
+    if (regionsI.RegionCount() == 0
+        || regionsI.Type_id() != regionsJ.Type_id())
     {
-      my_progress_bar += indexToCompare.size();
-      continue;
+      return;
     }
 
-    const std::vector<feature::PointFeature> pointFeaturesI = regionsI.GetRegionsPositions();
     const ScalarT * tabI =
       reinterpret_cast<const ScalarT*>(regionsI.DescriptorRawData());
     const size_t dimension = regionsI.DescriptorLength();
     Eigen::Map<BaseMat> mat_I( (ScalarT*)tabI, regionsI.RegionCount(), dimension);
-    #pragma omp parallel for schedule(dynamic)
-    for (int j = 0; j < (int)indexToCompare.size(); ++j)
-    {
-      size_t J = indexToCompare[j];
-      const feature::Regions &regionsJ = regionsPerView.getRegions(I, descType);
 
-      if (!regionsPerView.viewExist(J)
-          || regionsI.Type_id() != regionsJ.Type_id())
-      {
-        #pragma omp critical
-        ++my_progress_bar;
-        continue;
-      }
+    // Matrix representation of the query input data;
+    const ScalarT * tabJ = reinterpret_cast<const ScalarT*>(regionsJ.DescriptorRawData());
+    Eigen::Map<BaseMat> mat_J( (ScalarT*)tabJ, regionsJ.RegionCount(), dimension);
 
-      // Matrix representation of the query input data;
-      const ScalarT * tabJ = reinterpret_cast<const ScalarT*>(regionsJ.DescriptorRawData());
-      Eigen::Map<BaseMat> mat_J( (ScalarT*)tabJ, regionsJ.RegionCount(), dimension);
-
-      IndMatches pvec_indices;
-      typedef typename Accumulator<ScalarT>::Type ResultType;
-      std::vector<ResultType> pvec_distances;
-      pvec_distances.reserve(regionsJ.RegionCount() * 2);
-      pvec_indices.reserve(regionsJ.RegionCount() * 2);
-
-      // Match the query descriptors to the database
-      cascade_hasher.Match_HashedDescriptions<BaseMat, ResultType>(
-        hashed_base_[J], mat_J,
-        hashed_base_[I], mat_I,
-        &pvec_indices, &pvec_distances);
-
-      std::vector<int> vec_nn_ratio_idx;
-      // Filter the matches using a distance ratio test:
-      //   The probability that a match is correct is determined by taking
-      //   the ratio of distance from the closest neighbor to the distance
-      //   of the second closest.
-      matching::NNdistanceRatio(
-        pvec_distances.begin(), // distance start
-        pvec_distances.end(),   // distance end
-        2, // Number of neighbor in iterator sequence (minimum required 2)
-        vec_nn_ratio_idx, // output (indices that respect the distance Ratio)
-        Square(fDistRatio));
-
-      matching::IndMatches vec_putative_matches;
-      vec_putative_matches.reserve(vec_nn_ratio_idx.size());
-      for (size_t k=0; k < vec_nn_ratio_idx.size(); ++k)
-      {
-        const size_t index = vec_nn_ratio_idx[k];
-        vec_putative_matches.emplace_back(pvec_indices[index*2]._j, pvec_indices[index*2]._i);
-      }
+    IndMatches pvec_indices;
+    typedef typename Accumulator<ScalarT>::Type ResultType;
+    std::vector<ResultType> pvec_distances;
+    pvec_distances.reserve(regionsJ.RegionCount() * 2);
+    pvec_indices.reserve(regionsJ.RegionCount() * 2);
 
-      // Remove duplicates
-      matching::IndMatch::getDeduplicated(vec_putative_matches);
+    // Match the query descriptors to the database
+    cascade_hasher.Match_HashedDescriptions<BaseMat, ResultType>(
+      hashed_base_.at(J), mat_J,
+      hashed_base_.at(I), mat_I,
+      &pvec_indices, &pvec_distances,
+      2, &threadData.matchingBuffers);
 
-      // Remove matches that have the same (X,Y) coordinates
-      const std::vector<feature::PointFeature> pointFeaturesJ = regionsJ.GetRegionsPositions();
-      matching::IndMatchDecorator<float> matchDeduplicator(vec_putative_matches,
-        pointFeaturesI, pointFeaturesJ);
-      matchDeduplicator.getDeduplicated(vec_putative_matches);
+    std::vector<int> vec_nn_ratio_idx;
+    // Filter the matches using a distance ratio test:
+    //   The probability that a match is correct is determined by taking
+    //   the ratio of distance from the closest neighbor to the distance
+    //   of the second closest.
+    matching::NNdistanceRatio(
+      pvec_distances.begin(), // distance start
+      pvec_distances.end(),   // distance end
+      2, // Number of neighbor in iterator sequence (minimum required 2)
+      vec_nn_ratio_idx, // output (indices that respect the distance Ratio)
+      Square(fDistRatio));
 
-      #pragma omp critical
-      {
-        ++my_progress_bar;
-        if (!vec_putative_matches.empty())
-        {
-          assert(map_PutativesMatches.count(std::make_pair(I,J)) == 0);
-          map_PutativesMatches[std::make_pair(I,J)].emplace(descType, std::move(vec_putative_matches));
-        }
-      }
+    matching::IndMatches vec_putative_matches;
+    vec_putative_matches.reserve(vec_nn_ratio_idx.size());
+    for (size_t k=0; k < vec_nn_ratio_idx.size(); ++k)
+    {
+      const size_t index = vec_nn_ratio_idx[k];
+      vec_putative_matches.emplace_back(pvec_indices[index*2]._j, pvec_indices[index*2]._i);
+    }
+
+    // Remove duplicates
+    matching::IndMatch::getDeduplicated(vec_putative_matches);
+
+    // Remove matches that have the same (X,Y) coordinates
+    matching::IndMatchDecorator<float> matchDeduplicator(vec_putative_matches,
+      regionsI.Features(), regionsJ.Features());
+    matchDeduplicator.getDeduplicated(vec_putative_matches);
+
+    if (!vec_putative_matches.empty())
+    {
+      threadData.matches[pair].emplace(descType, std::move(vec_putative_matches));
+    }
+  }, &my_progress_bar);
+
+  // Merge the per thread matches
+  for (ThreadData& threadData : threadsData)
+  {
+    for (auto& matchesIt : threadData.matches)
+    {
+      for (auto& descMatchesIt : matchesIt.second)
+        map_PutativesMatches[matchesIt.first].emplace(descMatchesIt.first, std::move(descMatchesIt.second));
     }
   }
 }
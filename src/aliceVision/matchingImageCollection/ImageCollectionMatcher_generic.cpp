@@ -11,7 +11,9 @@
 #include <aliceVision/matching/ArrayMatcher_cascadeHashing.hpp>
 #include <aliceVision/matching/RegionsMatcher.hpp>
 #include <aliceVision/matchingImageCollection/IImageCollectionMatcher.hpp>
+#include <aliceVision/matchingImageCollection/pairScheduler.hpp>
 #include <aliceVision/config.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <boost/progress.hpp>
 
@@ -38,60 +40,60 @@ void ImageCollectionMatcher_generic::Match(
 #if ALICEVISION_IS_DEFINED(ALICEVISION_HAVE_OPENMP)
   ALICEVISION_LOG_DEBUG("Using the OPENMP thread interface");
 #endif
-  const bool b_multithreaded_pair_search = (_matcherType == CASCADE_HASHING_L2);
-  // -> set to true for CASCADE_HASHING_L2, since OpenMP instructions are not used in this matcher
+  // The brute force and kd-tree matchers are multithreaded (on the query descriptors):
+  // only parallelize over the pairs if there are enough of them to keep all the threads busy.
+  const bool multithreadedMatcher = (_matcherType != CASCADE_HASHING_L2);
+  const int nbThreads = (multithreadedMatcher && pairs.size() < static_cast<std::size_t>(omp_get_max_threads())) ? 1 : omp_get_max_threads();
 
+  PairScheduler scheduler(pairs, nbThreads);
   boost::progress_display my_progress_bar( pairs.size() );
 
-  // Sort pairs according the first index to minimize the MatcherT build operations
-  typedef std::map<size_t, std::vector<size_t> > Map_vectorT;
-  Map_vectorT map_Pairs;
-  for (PairSet::const_iterator iter = pairs.begin(); iter != pairs.end(); ++iter)
+  // Per thread state: the matching structure of the last first view and the resulting matches
+  struct ThreadData
   {
-    map_Pairs[iter->first].push_back(iter->second);
-  }
+    IndexT I = UndefinedIndexT;
+    std::unique_ptr<matching::RegionsDatabaseMatcher> matcher;
+    matching::PairwiseMatches matches;
+  };
+  std::vector<ThreadData> threadsData(scheduler.getNbThreads());
 
-  // Perform matching between all the pairs
-  for (Map_vectorT::const_iterator iter = map_Pairs.begin();
-    iter != map_Pairs.end(); ++iter)
+  scheduler.run([&](const Pair& pair, int threadId)
   {
-    const size_t I = iter->first;
-    const std::vector<size_t> & indexToCompare = iter->second;
+    const IndexT I = pair.first;
+    const IndexT J = pair.second;
+    ThreadData& threadData = threadsData[threadId];
 
     const feature::Regions & regionsI = regionsPerView.getRegions(I, descType);
-    if (regionsI.RegionCount() == 0)
+    const feature::Regions & regionsJ = regionsPerView.getRegions(J, descType);
+    if (regionsI.RegionCount() == 0
+        || regionsJ.RegionCount() == 0
+        || regionsI.Type_id() != regionsJ.Type_id())
     {
-      my_progress_bar += indexToCompare.size();
-      continue;
+      return;
     }
 
-    // Initialize the matching interface
-    matching::RegionsDatabaseMatcher matcher(_matcherType, regionsI);
-
-    #pragma omp parallel for schedule(dynamic) if(b_multithreaded_pair_search)
-    for (int j = 0; j < (int)indexToCompare.size(); ++j)
+    // Initialize the matching interface, once per first view
+    if (threadData.I != I || !threadData.matcher)
     {
-      const size_t J = indexToCompare[j];
+      threadData.matcher.reset(new matching::RegionsDatabaseMatcher(_matcherType, regionsI));
+      threadData.I = I;
+    }
 
-      const feature::Regions &regionsJ = regionsPerView.getRegions(J, descType);
-      if (regionsJ.RegionCount() == 0
-          || regionsI.Type_id() != regionsJ.Type_id())
-      {
-        #pragma omp critical
-        ++my_progress_bar;
-        continue;
-      }
+    IndMatches vec_putatives_matches;
+    threadData.matcher->Match(_f_dist_ratio, regionsJ, vec_putatives_matches);
+    if (!vec_putatives_matches.empty())
+    {
+      threadData.matches[pair].emplace(descType, std::move(vec_putatives_matches));
+    }
+  }, &my_progress_bar);
 
-      IndMatches vec_putatives_matches;
-      matcher.Match(_f_dist_ratio, regionsJ, vec_putatives_matches);
-      #pragma omp critical
-      {
-        ++my_progress_bar;
-        if (!vec_putatives_matches.empty())
-        {
-          map_PutativesMatches[std::make_pair(I,J)].emplace(descType, std::move(vec_putatives_matches));
-        }
-      }
+  // Merge the per thread matches
+  for (ThreadData& threadData : threadsData)
+  {
+    for (auto& matchesIt : threadData.matches)
+    {
+      for (auto& descMatchesIt : matchesIt.second)
+        map_PutativesMatches[matchesIt.first].emplace(descMatchesIt.first, std::move(descMatchesIt.second));
     }
   }
 }
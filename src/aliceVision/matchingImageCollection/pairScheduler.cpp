@@ -0,0 +1,80 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "pairScheduler.hpp"
+
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace aliceVision {
+namespace matchingImageCollection {
+
+PairScheduler::PairScheduler(const PairSet& pairs, int nbThreads)
+  : _pairs(pairs.begin(), pairs.end()) // PairSet is already sorted by first view
+  , _nbThreads(nbThreads > 0 ? nbThreads : omp_get_max_threads())
+{
+  if(_pairs.size() >= std::numeric_limits<std::uint32_t>::max())
+    throw std::out_of_range("Too many pairs to schedule: " + std::to_string(_pairs.size()));
+
+  _ranges.reset(new std::atomic<std::uint64_t>[_nbThreads]);
+  resetRanges();
+}
+
+void PairScheduler::resetRanges()
+{
+  const std::size_t nbPairs = _pairs.size();
+  for(int t = 0; t < _nbThreads; ++t)
+  {
+    const std::uint32_t begin = static_cast<std::uint32_t>(nbPairs * t / _nbThreads);
+    const std::uint32_t end = static_cast<std::uint32_t>(nbPairs * (t + 1) / _nbThreads);
+    _ranges[t].store(packRange(begin, end));
+  }
+}
+
+bool PairScheduler::popPair(int threadId, std::size_t& pairIndex)
+{
+  // own range: take from the front
+  {
+    std::atomic<std::uint64_t>& range = _ranges[threadId];
+    std::uint64_t current = range.load();
+    while(true)
+    {
+      const std::uint32_t begin = static_cast<std::uint32_t>(current >> 32);
+      const std::uint32_t end = static_cast<std::uint32_t>(current);
+      if(begin >= end)
+        break;
+      if(range.compare_exchange_weak(current, packRange(begin + 1, end)))
+      {
+        pairIndex = begin;
+        return true;
+      }
+    }
+  }
+
+  // steal from the back of the other ranges, starting with the neighbours
+  for(int offset = 1; offset < _nbThreads; ++offset)
+  {
+    std::atomic<std::uint64_t>& range = _ranges[(threadId + offset) % _nbThreads];
+    std::uint64_t current = range.load();
+    while(true)
+    {
+      const std::uint32_t begin = static_cast<std::uint32_t>(current >> 32);
+      const std::uint32_t end = static_cast<std::uint32_t>(current);
+      if(begin >= end)
+        break;
+      if(range.compare_exchange_weak(current, packRange(begin, end - 1)))
+      {
+        pairIndex = end - 1;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+} // namespace matchingImageCollection
+} // namespace aliceVision
@@ -0,0 +1,99 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <boost/progress.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace aliceVision {
+namespace matchingImageCollection {
+
+/**
+ * @brief Work-stealing scheduler of image pairs.
+ *
+ * All the (I,J) pairs are flattened and sorted by I, then split in one contiguous
+ * range per thread: consecutive pairs of a thread share the same I, so the matching
+ * structure built for I can be reused.
+ * A thread takes its pairs from the front of its range. Once empty, it steals pairs
+ * from the back of the other ranges, which keeps the front of the victim's range
+ * (and its cached I) untouched.
+ * There is no barrier between the I images and no global lock.
+ */
+class PairScheduler
+{
+public:
+  /**
+   * @param[in] pairs The pairs to process
+   * @param[in] nbThreads The number of threads, 0 for omp_get_max_threads()
+   */
+  explicit PairScheduler(const PairSet& pairs, int nbThreads = 0);
+
+  /// The pairs, sorted by first view
+  const PairVec& getPairs() const { return _pairs; }
+
+  int getNbThreads() const { return _nbThreads; }
+
+  /**
+   * @brief Process all the pairs, each one exactly once.
+   * @param[in] processPair Called as processPair(pair, threadId) with threadId in [0, getNbThreads()[
+   * @param[in] progressDisplay Optional progress display, only updated by the thread 0
+   */
+  template <typename ProcessPairFunc>
+  void run(ProcessPairFunc processPair, boost::progress_display* progressDisplay = nullptr)
+  {
+    resetRanges();
+    std::atomic<std::size_t> nbProcessed(0);
+    std::size_t nbDisplayed = 0;
+
+    #pragma omp parallel num_threads(_nbThreads)
+    {
+      const int threadId = omp_get_thread_num();
+      std::size_t pairIndex;
+      while(popPair(threadId, pairIndex))
+      {
+        processPair(_pairs[pairIndex], threadId);
+        ++nbProcessed;
+
+        if(progressDisplay != nullptr && threadId == 0)
+        {
+          const std::size_t processed = nbProcessed.load();
+          *progressDisplay += processed - nbDisplayed;
+          nbDisplayed = processed;
+        }
+      }
+    }
+
+    if(progressDisplay != nullptr)
+      *progressDisplay += _pairs.size() - nbDisplayed;
+  }
+
+private:
+  /// Range [begin, end[ of pair indexes packed in 64 bits, to be updated atomically.
+  static std::uint64_t packRange(std::uint32_t begin, std::uint32_t end)
+  {
+    return (static_cast<std::uint64_t>(begin) << 32) | end;
+  }
+
+  void resetRanges();
+
+  /// Pop a pair from the front of the thread range, else steal one from the back of another range.
+  bool popPair(int threadId, std::size_t& pairIndex);
+
+  PairVec _pairs;
+  int _nbThreads;
+  std::unique_ptr<std::atomic<std::uint64_t>[]> _ranges;
+};
+
+} // namespace matchingImageCollection
+} // namespace aliceVision
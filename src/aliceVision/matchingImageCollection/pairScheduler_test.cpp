@@ -0,0 +1,84 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "aliceVision/matchingImageCollection/pairScheduler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#define BOOST_TEST_MODULE matchingImageCollectionPairScheduler
+
+#include <boost/test/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::matchingImageCollection;
+
+BOOST_AUTO_TEST_CASE(matchingImageCollection_pairScheduler_sorted)
+{
+  const PairSet pairs = {{3, 4}, {0, 2}, {1, 5}, {0, 1}, {1, 2}};
+  PairScheduler scheduler(pairs, 2);
+
+  const PairVec& scheduledPairs = scheduler.getPairs();
+  BOOST_CHECK_EQUAL(scheduledPairs.size(), pairs.size());
+  for(std::size_t i = 1; i < scheduledPairs.size(); ++i)
+    BOOST_CHECK(scheduledPairs[i - 1] < scheduledPairs[i]);
+}
+
+BOOST_AUTO_TEST_CASE(matchingImageCollection_pairScheduler_allPairsOnce)
+{
+  // unbalanced pair list: a few views with many pairs, many views with a single pair
+  PairSet pairs;
+  for(IndexT i = 0; i < 5; ++i)
+    for(IndexT j = i + 1; j < 300; ++j)
+      pairs.insert(std::make_pair(i, j));
+  for(IndexT i = 5; i < 200; ++i)
+    pairs.insert(std::make_pair(i, i + 1));
+
+  for(int nbThreads : {1, 3, 8})
+  {
+    PairScheduler scheduler(pairs, nbThreads);
+    const PairVec& scheduledPairs = scheduler.getPairs();
+
+    std::vector<std::atomic<int>> nbProcessed(scheduledPairs.size());
+    for(auto& n : nbProcessed)
+      n = 0;
+    std::vector<std::atomic<int>> nbPairsPerThread(nbThreads);
+    for(auto& n : nbPairsPerThread)
+      n = 0;
+
+    // Boost.Test assertions are not thread safe: only count in the callback
+    std::atomic<int> nbInvalidThreadIds(0);
+    scheduler.run([&](const Pair& pair, int threadId)
+    {
+      if(threadId < 0 || threadId >= nbThreads)
+      {
+        ++nbInvalidThreadIds;
+        return;
+      }
+      const std::size_t index = std::lower_bound(scheduledPairs.begin(), scheduledPairs.end(), pair) - scheduledPairs.begin();
+      ++nbProcessed[index];
+      ++nbPairsPerThread[threadId];
+    });
+
+    BOOST_CHECK_EQUAL(nbInvalidThreadIds, 0);
+    for(const auto& n : nbProcessed)
+      BOOST_CHECK_EQUAL(n, 1);
+
+    int total = 0;
+    for(const auto& n : nbPairsPerThread)
+      total += n;
+    BOOST_CHECK_EQUAL(total, pairs.size());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(matchingImageCollection_pairScheduler_empty)
+{
+  PairScheduler scheduler(PairSet(), 4);
+  int nbProcessed = 0;
+  scheduler.run([&](const Pair&, int) { ++nbProcessed; });
+  BOOST_CHECK_EQUAL(nbProcessed, 0);
+}
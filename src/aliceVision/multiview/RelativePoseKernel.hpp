@@ -154,6 +154,14 @@ public:
     return _errorEstimator.error(modelF, PFRansacKernel::PFKernel::_x1.col(sample), PFRansacKernel::PFKernel::_x2.col(sample));
   }
 
+  void errors(const ModelT_& model, std::vector<double>& errors) const override
+  {
+    Mat3 F;
+    fundamentalFromEssential(model.getMatrix(), _K1, _K2, &F);
+    const ModelT_ modelF(F);
+    _errorEstimator.errors(modelF, PFRansacKernel::PFKernel::_x1, PFRansacKernel::PFKernel::_x2, errors);
+  }
+
   void unnormalize(ModelT_& model) const override
   {
     // do nothing, no normalization in this case
@@ -140,11 +140,7 @@ public:
    */
   inline double error(std::size_t sample, const ModelT& model) const
   {
-    Mat34 poseA, poseB;
-    P_from_KRt(Mat3::Identity(), Mat3::Identity(), Vec3::Zero(), &poseA);
-    P_from_KRt(Mat3::Identity(), _R, model.getMatrix(), &poseB);
-    const robustEstimation::Mat3Model F(F_from_P(poseA, poseB));
-    return _errorEstimator.error(F, _x1.col(sample), _x2.col(sample));
+    return _errorEstimator.error(fundamental(model), _x1.col(sample), _x2.col(sample));
   }
 
   /**
@@ -154,9 +150,7 @@ public:
    */
   inline virtual void errors(const ModelT& model, std::vector<double>& errors) const
   {
-    errors.resize(_x1.cols());
-    for(std::size_t sample = 0; sample < _x1.cols(); ++sample)
-      errors.at(sample) = error(sample, model);
+    _errorEstimator.errors(fundamental(model), _x1, _x2, errors);
   }
 
   /**
@@ -170,6 +164,19 @@ public:
 
 protected:
 
+  /**
+   * @brief Fundamental matrix between the two views for a given translation
+   * @param[in] model
+   * @return fundamental matrix model
+   */
+  inline robustEstimation::Mat3Model fundamental(const ModelT& model) const
+  {
+    Mat34 poseA, poseB;
+    P_from_KRt(Mat3::Identity(), Mat3::Identity(), Vec3::Zero(), &poseA);
+    P_from_KRt(Mat3::Identity(), _R, model.getMatrix(), &poseB);
+    return robustEstimation::Mat3Model(F_from_P(poseA, poseB));
+  }
+
   /// left corresponding point
   const Mat& _x1;
   /// right corresponding point
@@ -15,6 +15,45 @@ namespace aliceVision {
 namespace multiview {
 namespace relativePose {
 
+/**
+ * @brief Evaluate an epipolar error for all the correspondences in a single pass.
+ *        The coefficients of F are loaded once and each column is processed with scalar
+ *        arithmetic only, so that the loop can be vectorized by the compiler.
+ * @param[in] F The fundamental matrix
+ * @param[in] x1 The points in the first image, one per column
+ * @param[in] x2 The points in the second image, one per column
+ * @param[out] errors The error of each correspondence
+ * @param[in] errorFunctor Computes the error from the algebraic error y^T.F.x
+ *            and the squared norms of the first two coordinates of F.x and F^T.y
+ */
+template <typename ErrorFunctorT>
+inline void epipolarErrors(const Mat3& F, const Mat& x1, const Mat& x2, std::vector<double>& errors, ErrorFunctorT errorFunctor)
+{
+  const double f00 = F(0, 0), f01 = F(0, 1), f02 = F(0, 2);
+  const double f10 = F(1, 0), f11 = F(1, 1), f12 = F(1, 2);
+  const double f20 = F(2, 0), f21 = F(2, 1), f22 = F(2, 2);
+
+  const Mat::Index nbSamples = x1.cols();
+  const double* p1 = x1.data();
+  const double* p2 = x2.data();
+  errors.resize(nbSamples);
+  double* out = errors.data();
+
+  for(Mat::Index i = 0; i < nbSamples; ++i)
+  {
+    const double u0 = p1[2 * i], u1 = p1[2 * i + 1];
+    const double v0 = p2[2 * i], v1 = p2[2 * i + 1];
+
+    const double Fx0 = f00 * u0 + f01 * u1 + f02;
+    const double Fx1 = f10 * u0 + f11 * u1 + f12;
+    const double Fx2 = f20 * u0 + f21 * u1 + f22;
+    const double Fty0 = f00 * v0 + f10 * v1 + f20;
+    const double Fty1 = f01 * v0 + f11 * v1 + f21;
+
+    out[i] = errorFunctor(v0 * Fx0 + v1 * Fx1 + Fx2, Fx0 * Fx0 + Fx1 * Fx1, Fty0 * Fty0 + Fty1 * Fty1);
+  }
+}
+
 /**
  * @brief Compute FundamentalSampsonError related to the Fundamental matrix and 2 correspondences
  */
@@ -31,6 +70,14 @@ struct FundamentalSampsonError : public ISolverErrorRelativePose<robustEstimatio
 
     return Square(y.dot(F_x)) / (  F_x.head<2>().squaredNorm() + Ft_y.head<2>().squaredNorm());
   }
+
+  void errors(const robustEstimation::Mat3Model& F, const Mat& x1, const Mat& x2, std::vector<double>& errors) const override
+  {
+    epipolarErrors(F.getMatrix(), x1, x2, errors, [](double yFx, double Fx, double Fty)
+    {
+      return Square(yFx) / (Fx + Fty);
+    });
+  }
 };
 
 struct FundamentalSymmetricEpipolarDistanceError: public ISolverErrorRelativePose<robustEstimation::Mat3Model>
@@ -47,6 +94,14 @@ struct FundamentalSymmetricEpipolarDistanceError: public ISolverErrorRelativePos
     // @note the divide by 4 is to make this match the Sampson distance.
     return Square(y.dot(F_x)) * ( 1.0 / F_x.head<2>().squaredNorm() + 1.0 / Ft_y.head<2>().squaredNorm()) / 4.0;
   }
+
+  void errors(const robustEstimation::Mat3Model& F, const Mat& x1, const Mat& x2, std::vector<double>& errors) const override
+  {
+    epipolarErrors(F.getMatrix(), x1, x2, errors, [](double yFx, double Fx, double Fty)
+    {
+      return Square(yFx) * (1.0 / Fx + 1.0 / Fty) / 4.0;
+    });
+  }
 };
 
 struct FundamentalEpipolarDistanceError : public ISolverErrorRelativePose<robustEstimation::Mat3Model>
@@ -61,6 +116,14 @@ struct FundamentalEpipolarDistanceError : public ISolverErrorRelativePose<robust
 
     return Square(F_x.dot(y)) /  F_x.head<2>().squaredNorm();
   }
+
+  void errors(const robustEstimation::Mat3Model& F, const Mat& x1, const Mat& x2, std::vector<double>& errors) const override
+  {
+    epipolarErrors(F.getMatrix(), x1, x2, errors, [](double yFx, double Fx, double)
+    {
+      return Square(yFx) / Fx;
+    });
+  }
 };
 
 
@@ -74,6 +137,21 @@ struct EpipolarSphericalDistanceError
         Vec3 F_x = F.getMatrix() * x;
         return Square(F_x.dot(y));
     }
+
+    void errors(const robustEstimation::Mat3Model& F, const Mat& x1, const Mat& x2, std::vector<double>& errors) const
+    {
+        const Mat3& f = F.getMatrix();
+        errors.resize(x1.cols());
+        for(Mat::Index i = 0; i < x1.cols(); ++i)
+        {
+            const double* x = x1.col(i).data();
+            const double* y = x2.col(i).data();
+            const double yFx = y[0] * (f(0, 0) * x[0] + f(0, 1) * x[1] + f(0, 2) * x[2])
+                             + y[1] * (f(1, 0) * x[0] + f(1, 1) * x[1] + f(1, 2) * x[2])
+                             + y[2] * (f(2, 0) * x[0] + f(2, 1) * x[1] + f(2, 2) * x[2]);
+            errors[i] = Square(yFx);
+        }
+    }
 };
 
 
@@ -28,6 +28,29 @@ struct HomographyAsymmetricError : ISolverErrorRelativePose<robustEstimation::Ma
         const Vec2 x2_est = x2h_est.head<2>() / x2h_est[2];
         return (x2 - x2_est).squaredNorm();
     }
+
+    void errors(const robustEstimation::Mat3Model& H, const Mat& x1, const Mat& x2, std::vector<double>& errors) const override
+    {
+        const Mat3& h = H.getMatrix();
+        const double h00 = h(0, 0), h01 = h(0, 1), h02 = h(0, 2);
+        const double h10 = h(1, 0), h11 = h(1, 1), h12 = h(1, 2);
+        const double h20 = h(2, 0), h21 = h(2, 1), h22 = h(2, 2);
+
+        const Mat::Index nbSamples = x1.cols();
+        const double* p1 = x1.data();
+        const double* p2 = x2.data();
+        errors.resize(nbSamples);
+        double* out = errors.data();
+
+        for(Mat::Index i = 0; i < nbSamples; ++i)
+        {
+            const double u0 = p1[2 * i], u1 = p1[2 * i + 1];
+            const double invW = 1.0 / (h20 * u0 + h21 * u1 + h22);
+            const double dx = p2[2 * i] - (h00 * u0 + h01 * u1 + h02) * invW;
+            const double dy = p2[2 * i + 1] - (h10 * u0 + h11 * u1 + h12) * invW;
+            out[i] = dx * dx + dy * dy;
+        }
+    }
 };
 
 }  // namespace relativePose
@@ -74,6 +74,13 @@ struct RotationError
 
         return angle * angle;
     }
+
+    void errors(const robustEstimation::Mat3Model& R, const Mat& x1, const Mat& x2, std::vector<double>& errors) const
+    {
+        errors.resize(x1.cols());
+        for(Mat::Index i = 0; i < x1.cols(); ++i)
+            errors[i] = error(R, x1.col(i), x2.col(i));
+    }
 };
 
 
@@ -14,6 +14,8 @@
 #include <boost/test/unit_test.hpp>
 #include <boost/test/tools/floating_point_comparison.hpp>
 
+#include <random>
+
 using namespace aliceVision;
 using namespace aliceVision::multiview;
 
@@ -133,3 +135,39 @@ BOOST_AUTO_TEST_CASE(NormalizedFundamental8PKernel_EasyCase)
 
   BOOST_CHECK(expectKernelProperties<relativePose::NormalizedFundamental8PKernel>(x1, x2));
 }
+
+BOOST_AUTO_TEST_CASE(FundamentalError_BatchedErrors)
+{
+  std::mt19937 randomNumberGenerator(42);
+  std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+
+  Mat3 F;
+  for(int i = 0; i < 9; ++i)
+    F(i / 3, i % 3) = distribution(randomNumberGenerator);
+  const robustEstimation::Mat3Model model(F);
+
+  Mat x1(2, 37), x2(2, 37);
+  for(Mat::Index i = 0; i < x1.size(); ++i)
+  {
+    x1(i) = distribution(randomNumberGenerator);
+    x2(i) = distribution(randomNumberGenerator);
+  }
+
+  const relativePose::FundamentalSampsonError sampsonError;
+  const relativePose::FundamentalSymmetricEpipolarDistanceError symmetricError;
+  const relativePose::FundamentalEpipolarDistanceError epipolarError;
+  const std::vector<const relativePose::ISolverErrorRelativePose<robustEstimation::Mat3Model>*> errorEstimators = {&sampsonError, &symmetricError, &epipolarError};
+
+  for(const auto* errorEstimator : errorEstimators)
+  {
+    std::vector<double> errors;
+    errorEstimator->errors(model, x1, x2, errors);
+    BOOST_CHECK_EQUAL(errors.size(), x1.cols());
+
+    for(Mat::Index i = 0; i < x1.cols(); ++i)
+    {
+      const double error = errorEstimator->error(model, x1.col(i), x2.col(i));
+      BOOST_CHECK_SMALL(errors[i] - error, 1e-9 * std::max(1.0, error));
+    }
+  }
+}
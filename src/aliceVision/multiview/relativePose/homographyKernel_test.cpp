@@ -100,3 +100,27 @@ BOOST_AUTO_TEST_CASE(Homography4PKernel_Fitting)
     }
   }
 }
+
+BOOST_AUTO_TEST_CASE(Homography4PKernel_BatchedErrors)
+{
+  Mat3 H;
+  H << 1, -2,  3,
+       4,  5, -6,
+      -7,  8,  1;
+
+  Mat x(2, 9), y(2, 9);
+  x << 0, 0, 0, 1, 1, 1, 2, 2, 2,
+       0, 1, 2, 0, 1, 2, 0, 1, 2;
+  y << 3, 1, 4, 1, 5, 9, 2, 6, 5,
+       3, 5, 8, 9, 7, 9, 3, 2, 3;
+
+  const relativePose::Homography4PKernel kernel(x, y);
+  const robustEstimation::Mat3Model model(H);
+
+  std::vector<double> errors;
+  kernel.errors(model, errors);
+  BOOST_CHECK_EQUAL(errors.size(), x.cols());
+
+  for(std::size_t i = 0; i < errors.size(); ++i)
+    BOOST_CHECK_CLOSE(errors[i], kernel.error(i, model), 1e-9);
+}
@@ -16,6 +16,36 @@ namespace aliceVision {
 namespace multiview {
 namespace resection {
 
+/**
+ * @brief Compute the squared projection distances (pt2D, project(P,pt3D)) of all the correspondences
+ *        in a single pass, the coefficients of P being loaded once.
+ * @param[in] P The projection matrix
+ * @param[in] p2d The 2d points, one per column
+ * @param[in] p3d The 3d points, one per column
+ * @param[out] errors The squared distance of each correspondence
+ */
+inline void squaredProjectionDistances(const Mat34& P, const Mat& p2d, const Mat& p3d, std::vector<double>& errors)
+{
+  const double p00 = P(0, 0), p01 = P(0, 1), p02 = P(0, 2), p03 = P(0, 3);
+  const double p10 = P(1, 0), p11 = P(1, 1), p12 = P(1, 2), p13 = P(1, 3);
+  const double p20 = P(2, 0), p21 = P(2, 1), p22 = P(2, 2), p23 = P(2, 3);
+
+  const Mat::Index nbSamples = p2d.cols();
+  const double* x = p2d.data();
+  const double* X = p3d.data();
+  errors.resize(nbSamples);
+  double* out = errors.data();
+
+  for(Mat::Index i = 0; i < nbSamples; ++i)
+  {
+    const double X0 = X[3 * i], X1 = X[3 * i + 1], X2 = X[3 * i + 2];
+    const double invW = 1.0 / (p20 * X0 + p21 * X1 + p22 * X2 + p23);
+    const double dx = (p00 * X0 + p01 * X1 + p02 * X2 + p03) * invW - x[2 * i];
+    const double dy = (p10 * X0 + p11 * X1 + p12 * X2 + p13) * invW - x[2 * i + 1];
+    out[i] = dx * dx + dy * dy;
+  }
+}
+
 /**
  * @brief Compute the residual of the projection distance
  *        (pt2D, project(P,pt3D))
@@ -26,6 +56,13 @@ struct ProjectionDistanceError : public ISolverErrorResection<robustEstimation::
   {
     return (project(P.getMatrix(), p3d) - p2d).norm();
   }
+
+  void errors(const robustEstimation::Mat34Model& P, const Mat& p2d, const Mat& p3d, std::vector<double>& errors) const override
+  {
+    squaredProjectionDistances(P.getMatrix(), p2d, p3d, errors);
+    for(double& error : errors)
+      error = std::sqrt(error);
+  }
 };
 
 /**
@@ -38,6 +75,11 @@ struct ProjectionDistanceSquaredError : public ISolverErrorResection<robustEstim
   {
     return (project(P.getMatrix(), p3d) - p2d).squaredNorm();
   }
+
+  void errors(const robustEstimation::Mat34Model& P, const Mat& p2d, const Mat& p3d, std::vector<double>& errors) const override
+  {
+    squaredProjectionDistances(P.getMatrix(), p2d, p3d, errors);
+  }
 };
 
 }  // namespace resection
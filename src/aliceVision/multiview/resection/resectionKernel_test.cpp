@@ -211,3 +211,34 @@ BOOST_AUTO_TEST_CASE(EuclideanResection_Points6AllRandomInput) {
   }
 
 }
+
+BOOST_AUTO_TEST_CASE(Resection_Kernel_BatchedErrors)
+{
+  const int nViews = 3;
+  const int nbPoints = 10;
+  const NViewDataSet d = NRealisticCamerasRing(nViews, nbPoints,
+    NViewDatasetConfigurator(1,1,0,0,5,0));
+
+  // perturb the projection matrix to get non zero errors
+  Mat34 P = d.P(1);
+  P(0, 3) += 0.1;
+  P(1, 0) -= 0.05;
+  const robustEstimation::Mat34Model model(P);
+
+  const Mat x = d._x[1];
+  const Mat X = d._X;
+
+  const resection::ProjectionDistanceError distanceError;
+  const resection::ProjectionDistanceSquaredError squaredDistanceError;
+  const std::vector<const resection::ISolverErrorResection<robustEstimation::Mat34Model>*> errorEstimators = {&distanceError, &squaredDistanceError};
+
+  for(const auto* errorEstimator : errorEstimators)
+  {
+    std::vector<double> errors;
+    errorEstimator->errors(model, x, X, errors);
+    BOOST_CHECK_EQUAL(errors.size(), x.cols());
+
+    for(Mat::Index i = 0; i < x.cols(); ++i)
+      BOOST_CHECK_CLOSE(errors[i], errorEstimator->error(model, x.col(i), X.col(i)), 1e-9);
+  }
+}
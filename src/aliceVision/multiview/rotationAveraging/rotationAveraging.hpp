@@ -12,6 +12,7 @@
 // . Compute global rotation from a list of relative estimates.
 // - L2 -> See [1]
 // - L1 -> See [2]
+// - sparse IRLS -> See [3]
 //
 //- [1] "Robust Multiview Reconstruction."
 //- Author : Daniel Martinec.
@@ -21,8 +22,14 @@
 //- Authors: Avishek Chatterjee and Venu Madhav Govindu
 //- Date: December 2013.
 //- Conference: ICCV.
+//
+//- [3] "Robust Relative Rotation Averaging"
+//- Authors: Avishek Chatterjee and Venu Madhav Govindu
+//- Date: April 2018.
+//- Journal: TPAMI.
 //--
 
 #include <aliceVision/multiview/rotationAveraging/common.hpp>
 #include <aliceVision/multiview/rotationAveraging/l1.hpp>
 #include <aliceVision/multiview/rotationAveraging/l2.hpp>
+#include <aliceVision/multiview/rotationAveraging/sparse.hpp>
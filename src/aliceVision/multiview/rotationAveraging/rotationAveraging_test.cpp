@@ -10,8 +10,10 @@
 #include <aliceVision/system/Logger.hpp>
 #include "aliceVision/multiview/NViewDataSet.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
+#include <random>
 #include <vector>
 #include <iterator>
 #include <utility>
@@ -319,6 +321,147 @@ BOOST_AUTO_TEST_CASE ( rotationAveraging_RefineRotationsAvgL1IRLS_CompleteGraph_
   }
 }
 
+// Solve the 3 cameras scene of rotationAveraging_RotationLeastSquare_3_Camera
+// with the sparse chordal initialization and the IRLS refinement
+BOOST_AUTO_TEST_CASE ( rotationAveraging_SparseIRLS_3_Camera)
+{
+  const Mat3 R01 = RotationAroundZ(2.*M_PI/3.0); //120deg
+  const Mat3 R12 = RotationAroundZ(2.*M_PI/3.0); //120deg
+  const Mat3 R20 = RotationAroundZ(2.*M_PI/3.0); //120deg
+
+  RelativeRotations vec_relativeRotEstimate;
+  vec_relativeRotEstimate.push_back( RelativeRotation(0,1, R01));
+  vec_relativeRotEstimate.push_back( RelativeRotation(1,2, R12));
+  vec_relativeRotEstimate.push_back( RelativeRotation(2,0, R20));
+
+  std::vector<Mat3> vec_globalR;
+  std::vector<bool> inliers;
+  BOOST_CHECK(sparse::GlobalRotationsIRLS(3, vec_relativeRotEstimate, vec_globalR, 0, 5.0, &inliers));
+  BOOST_CHECK_EQUAL(3, vec_globalR.size());
+  BOOST_CHECK_EQUAL(3, std::count(inliers.begin(), inliers.end(), true));
+
+  // The main view is the Identity and the relative rotations are the expected ones
+  EXPECT_MATRIX_NEAR(Mat3::Identity(), vec_globalR[0], 1e-8);
+  EXPECT_MATRIX_NEAR(R01, Mat3(vec_globalR[1] * vec_globalR[0].transpose()), 1e-8);
+  EXPECT_MATRIX_NEAR(R12, Mat3(vec_globalR[2] * vec_globalR[1].transpose()), 1e-8);
+  EXPECT_MATRIX_NEAR(R20, Mat3(vec_globalR[0] * vec_globalR[2].transpose()), 1e-8);
+}
+
+// Test summary:
+// - Random global rotations and a random view graph (a ring and random edges)
+// - Noisy relative rotations, with random outliers on the edges out of the ring
+// - Check that the outliers are detected and that the global rotations are close to the true ones
+BOOST_AUTO_TEST_CASE ( rotationAveraging_SparseIRLS_RandomGraph_outliers)
+{
+  const std::size_t nCamera = 200;
+  const std::size_t nEdges = 2000;
+
+  std::mt19937 randomNumberGenerator(0);
+  std::normal_distribution<double> normal(0.0, 1.0);
+  std::uniform_int_distribution<std::size_t> cameraDistribution(0, nCamera - 1);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+  const auto randomRotation = [&](double angle)
+  {
+    const Vec3 axis = Vec3(normal(randomNumberGenerator), normal(randomNumberGenerator), normal(randomNumberGenerator)).normalized();
+    return Mat3(Eigen::AngleAxisd(angle, axis).toRotationMatrix());
+  };
+
+  std::vector<Mat3> groundTruth(nCamera);
+  for (std::size_t c = 0; c < nCamera; ++c)
+    groundTruth[c] = randomRotation(M_PI * uniform(randomNumberGenerator));
+
+  RelativeRotations vec_relativeRotEstimate;
+  std::vector<bool> isOutlier;
+  for (std::size_t e = 0; e < nEdges; ++e)
+  {
+    const bool ring = (e < nCamera);
+    const std::size_t i = ring ? e : cameraDistribution(randomNumberGenerator);
+    const std::size_t j = ring ? (e + 1) % nCamera : cameraDistribution(randomNumberGenerator);
+    if (i == j)
+      continue;
+
+    const bool outlier = !ring && uniform(randomNumberGenerator) < 0.1;
+    const Mat3 noise = outlier ? randomRotation(degreeToRadian(30.0) + M_PI * uniform(randomNumberGenerator))
+                               : randomRotation(degreeToRadian(0.3) * normal(randomNumberGenerator));
+
+    vec_relativeRotEstimate.emplace_back(i, j, noise * groundTruth[j] * groundTruth[i].transpose());
+    isOutlier.push_back(outlier);
+  }
+
+  std::vector<Mat3> vec_globalR;
+  std::vector<bool> inliers;
+  BOOST_CHECK(sparse::GlobalRotationsIRLS(nCamera, vec_relativeRotEstimate, vec_globalR, 0, 5.0, &inliers));
+  BOOST_CHECK_EQUAL(nCamera, vec_globalR.size());
+
+  // The outliers are detected
+  for (std::size_t e = 0; e < vec_relativeRotEstimate.size(); ++e)
+    BOOST_CHECK_EQUAL(inliers[e], !isOutlier[e]);
+
+  // The global rotations are the true ones up to the rotation of the main view
+  for (std::size_t c = 0; c < nCamera; ++c)
+  {
+    const Mat3 R = groundTruth[c] * groundTruth[0].transpose();
+    BOOST_CHECK_SMALL(radianToDegree(getRotationMagnitude(R.transpose() * vec_globalR[c])), 0.5);
+  }
+}
+
+// Test summary:
+// - A view graph with 2 connected components, then with an isolated camera,
+//   with a camera only linked by a zero weight edge and with a cycle not linked to the main camera
+// - Check that the chordal initialization and the IRLS refinement fail
+BOOST_AUTO_TEST_CASE ( rotationAveraging_SparseIRLS_NotConnected)
+{
+  RelativeRotations vec_relativeRotEstimate;
+  vec_relativeRotEstimate.push_back( RelativeRotation(0,1, RotationAroundZ(0.1)));
+  vec_relativeRotEstimate.push_back( RelativeRotation(2,3, RotationAroundZ(0.2)));
+
+  std::vector<Mat3> vec_globalR;
+  BOOST_CHECK(!sparse::ChordalRotationAveraging(4, vec_relativeRotEstimate, vec_globalR, 0));
+
+  vec_globalR.assign(4, Mat3::Identity());
+  BOOST_CHECK(!sparse::RefineRotationsIRLS(vec_relativeRotEstimate, vec_globalR, 0));
+
+  // the camera 3 is isolated
+  vec_relativeRotEstimate.clear();
+  vec_relativeRotEstimate.push_back( RelativeRotation(0,1, RotationAroundZ(0.1)));
+  vec_relativeRotEstimate.push_back( RelativeRotation(1,2, RotationAroundZ(0.2)));
+  vec_relativeRotEstimate.push_back( RelativeRotation(2,0, RotationAroundZ(-0.3)));
+
+  BOOST_CHECK(!sparse::ChordalRotationAveraging(4, vec_relativeRotEstimate, vec_globalR, 0));
+  vec_globalR.assign(4, Mat3::Identity());
+  BOOST_CHECK(!sparse::RefineRotationsIRLS(vec_relativeRotEstimate, vec_globalR, 0));
+
+  // the camera 3 is only linked by a zero weight edge
+  vec_relativeRotEstimate.push_back( RelativeRotation(2,3, RotationAroundZ(0.4), 0.0f));
+
+  BOOST_CHECK(!sparse::ChordalRotationAveraging(4, vec_relativeRotEstimate, vec_globalR, 0));
+  vec_globalR.assign(4, Mat3::Identity());
+  BOOST_CHECK(!sparse::RefineRotationsIRLS(vec_relativeRotEstimate, vec_globalR, 0));
+
+  // the rounding errors of a cycle not linked to the main camera give non-zero pivots
+  {
+    const Mat3 R1 = Eigen::AngleAxisd(0.7, Vec3(1.0, 2.0, 3.0).normalized()).toRotationMatrix();
+    const Mat3 R2 = Eigen::AngleAxisd(1.3, Vec3(-2.0, 1.0, 0.5).normalized()).toRotationMatrix();
+
+    RelativeRotations vec_relativeRotCycle;
+    vec_relativeRotCycle.push_back( RelativeRotation(0,1, R1, 0.3f));
+    vec_relativeRotCycle.push_back( RelativeRotation(2,3, R2, 0.7f));
+    vec_relativeRotCycle.push_back( RelativeRotation(3,4, R1, 0.9f));
+    vec_relativeRotCycle.push_back( RelativeRotation(4,2, R2 * R1, 0.3f));
+
+    BOOST_CHECK(!sparse::ChordalRotationAveraging(5, vec_relativeRotCycle, vec_globalR, 0));
+    vec_globalR.assign(5, Mat3::Identity());
+    BOOST_CHECK(!sparse::RefineRotationsIRLS(vec_relativeRotCycle, vec_globalR, 0));
+  }
+
+  // once linked, the graph is connected
+  vec_relativeRotEstimate.back().weight = 1.0f;
+
+  BOOST_CHECK(sparse::ChordalRotationAveraging(4, vec_relativeRotEstimate, vec_globalR, 0));
+  BOOST_CHECK(sparse::RefineRotationsIRLS(vec_relativeRotEstimate, vec_globalR, 0));
+}
+
 /*
 template<typename TYPE, int N>
 inline REAL ComputePSNR(const Eigen::Matrix<REAL, N,1>& x0, const Eigen::Matrix<REAL, N,1>& x)
@@ -0,0 +1,317 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "aliceVision/multiview/rotationAveraging/sparse.hpp"
+#include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <Eigen/SparseCholesky>
+
+#include <cmath>
+#include <vector>
+
+namespace aliceVision   {
+namespace rotationAveraging  {
+namespace sparse  {
+
+/**
+ * @brief Closest rotation of a 3x3 matrix in the Frobenius norm (with a positive determinant)
+ */
+Mat3 closestRotation(const Mat3& M)
+{
+  Eigen::JacobiSVD<Mat3> svd(M, Eigen::ComputeFullU | Eigen::ComputeFullV);
+  Mat3 D = Mat3::Identity();
+  D(2, 2) = (svd.matrixU() * svd.matrixV().transpose()).determinant() < 0.0 ? -1.0 : 1.0;
+  return svd.matrixU() * D * svd.matrixV().transpose();
+}
+
+/**
+ * @brief Index of the unknowns of a camera, the main camera is fixed and has no unknowns
+ */
+inline std::size_t unknownIndex(std::size_t camera, std::size_t nMainViewID)
+{
+  return (camera < nMainViewID) ? camera : camera - 1;
+}
+
+/**
+ * @brief Check that the relative rotations with a positive weight connect all the cameras.
+ *        The factorization of a singular Laplacian does not reliably report a failure,
+ *        the connectivity is checked with a union-find over the edges.
+ */
+bool isViewGraphConnected(std::size_t nCamera, const RelativeRotations& relativeRotations)
+{
+  std::vector<std::size_t> parent(nCamera);
+  for(std::size_t c = 0; c < nCamera; ++c)
+    parent[c] = c;
+
+  const auto find = [&parent](std::size_t c)
+  {
+    while(parent[c] != c)
+    {
+      parent[c] = parent[parent[c]];
+      c = parent[c];
+    }
+    return c;
+  };
+
+  std::size_t nComponents = nCamera;
+  for(const RelativeRotation& relativeRotation : relativeRotations)
+  {
+    if(relativeRotation.i >= nCamera || relativeRotation.j >= nCamera || !(relativeRotation.weight > 0.0))
+      continue;
+
+    const std::size_t rootI = find(relativeRotation.i);
+    const std::size_t rootJ = find(relativeRotation.j);
+    if(rootI != rootJ)
+    {
+      parent[rootI] = rootJ;
+      --nComponents;
+    }
+  }
+  return nComponents == 1;
+}
+
+bool ChordalRotationAveraging(
+  std::size_t nCamera,
+  const RelativeRotations& relativeRotations,
+  std::vector<Mat3>& globalRotations,
+  std::size_t nMainViewID)
+{
+  if(nCamera < 2 || nMainViewID >= nCamera)
+    return false;
+
+  if(!isViewGraphConnected(nCamera, relativeRotations))
+  {
+    ALICEVISION_LOG_WARNING("Chordal rotation averaging: the view graph is not connected.");
+    return false;
+  }
+
+  const std::size_t nUnknowns = 3 * (nCamera - 1);
+
+  // Normal equations of wij * ||xj - Rij * xi||^2 for each column x of the global rotations:
+  // the matrix is the same for the 3 columns, the main camera (Identity) gives the right hand sides.
+  std::vector<Eigen::Triplet<double>> tripletList;
+  tripletList.reserve(relativeRotations.size() * 24);
+  Mat B = Mat::Zero(nUnknowns, 3);
+
+  for(const RelativeRotation& relativeRotation : relativeRotations)
+  {
+    const std::size_t i = relativeRotation.i;
+    const std::size_t j = relativeRotation.j;
+    const double w = relativeRotation.weight;
+    const Mat3& Rij = relativeRotation.Rij;
+
+    if(i == j)
+      continue;
+
+    const bool fixedI = (i == nMainViewID);
+    const bool fixedJ = (j == nMainViewID);
+    const std::size_t I = fixedI ? 0 : 3 * unknownIndex(i, nMainViewID);
+    const std::size_t J = fixedJ ? 0 : 3 * unknownIndex(j, nMainViewID);
+
+    // d/dxi: w * Rij^T * (Rij * xi - xj) and d/dxj: w * (xj - Rij * xi)
+    for(int r = 0; r < 3; ++r)
+    {
+      if(!fixedI)
+        tripletList.emplace_back(I + r, I + r, w);
+      if(!fixedJ)
+        tripletList.emplace_back(J + r, J + r, w);
+
+      for(int c = 0; c < 3; ++c)
+      {
+        if(!fixedI && !fixedJ)
+        {
+          tripletList.emplace_back(I + r, J + c, -w * Rij(c, r));
+          tripletList.emplace_back(J + r, I + c, -w * Rij(r, c));
+        }
+      }
+    }
+
+    // xi or xj is known (Identity)
+    if(fixedI && !fixedJ)
+      B.block<3, 3>(J, 0) += w * Rij;
+    else if(fixedJ && !fixedI)
+      B.block<3, 3>(I, 0) += w * Rij.transpose();
+  }
+
+  sMat A(nUnknowns, nUnknowns);
+  A.setFromTriplets(tripletList.begin(), tripletList.end());
+
+  Eigen::SimplicialLDLT<sMat> solver(A);
+  if(solver.info() != Eigen::Success)
+    return false;
+
+  const Mat X = solver.solve(B);
+  if(solver.info() != Eigen::Success || !X.allFinite())
+    return false;
+
+  globalRotations.resize(nCamera);
+  for(std::size_t c = 0; c < nCamera; ++c)
+  {
+    if(c == nMainViewID)
+      globalRotations[c] = Mat3::Identity();
+    else
+      globalRotations[c] = closestRotation(X.block<3, 3>(3 * unknownIndex(c, nMainViewID), 0));
+  }
+  return true;
+}
+
+void ComputeResiduals(
+  const RelativeRotations& relativeRotations,
+  const std::vector<Mat3>& globalRotations,
+  std::vector<Vec3>& residuals)
+{
+  residuals.resize(relativeRotations.size());
+
+  #pragma omp parallel for
+  for(int e = 0; e < static_cast<int>(relativeRotations.size()); ++e)
+  {
+    const RelativeRotation& relativeRotation = relativeRotations[e];
+    const Mat3 Q = globalRotations[relativeRotation.j].transpose() * relativeRotation.Rij * globalRotations[relativeRotation.i];
+    const Eigen::AngleAxisd angleAxis(Q);
+    residuals[e] = angleAxis.angle() * angleAxis.axis();
+  }
+}
+
+bool RefineRotationsIRLS(
+  const RelativeRotations& relativeRotations,
+  std::vector<Mat3>& globalRotations,
+  std::size_t nMainViewID,
+  double sigma,
+  unsigned int maxIterations,
+  double eps)
+{
+  const std::size_t nCamera = globalRotations.size();
+  if(nCamera < 2 || nMainViewID >= nCamera)
+    return false;
+
+  if(!isViewGraphConnected(nCamera, relativeRotations))
+  {
+    ALICEVISION_LOG_WARNING("IRLS rotation averaging: the view graph is not connected.");
+    return false;
+  }
+
+  const std::size_t nUnknowns = nCamera - 1;
+  const double sigma2 = sigma * sigma;
+
+  // With Ri <- Ri * exp(wi), the residual log(Rj^T * Rij * Ri) is updated to first order by wi - wj:
+  // the updates minimize sum(weight_ij * ||wj - wi - residual_ij||^2), a graph Laplacian system
+  // with the same matrix for the 3 components of the updates.
+  std::vector<Eigen::Triplet<double>> tripletList;
+  tripletList.reserve(relativeRotations.size() * 4);
+  std::vector<Vec3> residuals;
+  sMat L(nUnknowns, nUnknowns);
+  Eigen::SimplicialLDLT<sMat> solver;
+  bool patternAnalyzed = false;
+
+  for(unsigned int iteration = 0; iteration < maxIterations; ++iteration)
+  {
+    ComputeResiduals(relativeRotations, globalRotations, residuals);
+
+    tripletList.clear();
+    Mat B = Mat::Zero(nUnknowns, 3);
+
+    for(std::size_t e = 0; e < relativeRotations.size(); ++e)
+    {
+      const std::size_t i = relativeRotations[e].i;
+      const std::size_t j = relativeRotations[e].j;
+      if(i == j)
+        continue;
+
+      // Geman-McClure weight
+      const double residual2 = residuals[e].squaredNorm();
+      const double robustWeight = sigma2 / (sigma2 + residual2);
+      const double w = relativeRotations[e].weight * robustWeight * robustWeight;
+
+      const bool fixedI = (i == nMainViewID);
+      const bool fixedJ = (j == nMainViewID);
+      const std::size_t I = unknownIndex(i, nMainViewID);
+      const std::size_t J = unknownIndex(j, nMainViewID);
+
+      if(!fixedI)
+      {
+        tripletList.emplace_back(I, I, w);
+        B.row(I) -= w * residuals[e].transpose();
+      }
+      if(!fixedJ)
+      {
+        tripletList.emplace_back(J, J, w);
+        B.row(J) += w * residuals[e].transpose();
+      }
+      if(!fixedI && !fixedJ)
+      {
+        tripletList.emplace_back(I, J, -w);
+        tripletList.emplace_back(J, I, -w);
+      }
+    }
+
+    L.setFromTriplets(tripletList.begin(), tripletList.end());
+
+    // the sparsity pattern does not change between the iterations
+    if(!patternAnalyzed)
+    {
+      solver.analyzePattern(L);
+      patternAnalyzed = true;
+    }
+    solver.factorize(L);
+    if(solver.info() != Eigen::Success)
+      return false;
+
+    const Mat updates = solver.solve(B);
+    if(solver.info() != Eigen::Success || !updates.allFinite())
+      return false;
+
+    double meanUpdate = 0.0;
+    for(std::size_t c = 0; c < nCamera; ++c)
+    {
+      if(c == nMainViewID)
+        continue;
+      const Vec3 update = updates.row(unknownIndex(c, nMainViewID)).transpose();
+      const double angle = update.norm();
+      meanUpdate += angle;
+      if(angle > 0.0)
+        globalRotations[c] = globalRotations[c] * Eigen::AngleAxisd(angle, update / angle).toRotationMatrix();
+    }
+    meanUpdate /= nUnknowns;
+
+    ALICEVISION_LOG_DEBUG("IRLS rotation averaging: iteration " << iteration << ", mean update: " << meanUpdate);
+
+    if(meanUpdate < eps)
+      break;
+  }
+  return true;
+}
+
+bool GlobalRotationsIRLS(
+  std::size_t nCamera,
+  const RelativeRotations& relativeRotations,
+  std::vector<Mat3>& globalRotations,
+  std::size_t nMainViewID,
+  double maxAngularError,
+  std::vector<bool>* inliers)
+{
+  if(!ChordalRotationAveraging(nCamera, relativeRotations, globalRotations, nMainViewID))
+    return false;
+
+  if(!RefineRotationsIRLS(relativeRotations, globalRotations, nMainViewID))
+    return false;
+
+  if(inliers != nullptr)
+  {
+    std::vector<Vec3> residuals;
+    ComputeResiduals(relativeRotations, globalRotations, residuals);
+
+    const double maxAngle = degreeToRadian(maxAngularError);
+    inliers->resize(relativeRotations.size());
+    for(std::size_t e = 0; e < relativeRotations.size(); ++e)
+      (*inliers)[e] = (residuals[e].norm() < maxAngle);
+  }
+  return true;
+}
+
+} // namespace sparse
+} // namespace rotationAveraging
+} // namespace aliceVision
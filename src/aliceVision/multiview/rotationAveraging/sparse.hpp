@@ -0,0 +1,99 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/multiview/rotationAveraging/common.hpp>
+#include <vector>
+
+//--
+//-- Implementation related to rotation averaging.
+// . Compute global rotation from a list of relative estimates,
+//   with sparse linear systems only (the cost grows linearly with the number of relative rotations).
+//
+//- [1] "Robust Relative Rotation Averaging"
+//- Authors: Avishek Chatterjee and Venu Madhav Govindu
+//- Date: April 2018.
+//- Journal: TPAMI.
+//--
+namespace aliceVision   {
+namespace rotationAveraging  {
+namespace sparse  {
+
+/**
+ * @brief Compute an initial estimation of the global rotations by minimizing the chordal distance
+ *        sum(wij * ||Rj - Rij * Ri||^2) without the orthogonality constraints, then by projecting
+ *        each solution on the closest rotation.
+ *        The normal equations are solved with a sparse Cholesky factorization.
+ *
+ * @param[in] nCamera The number of cameras to solve
+ * @param[in] relativeRotations Relative weighted rotation matrices (Rj = Rij * Ri)
+ * @param[out] globalRotations output global rotation matrices
+ * @param[in] nMainViewID Id of the camera considered as Identity (unit rotation)
+ * @return false if the view graph is not connected
+ */
+bool ChordalRotationAveraging(
+  std::size_t nCamera,
+  const RelativeRotations& relativeRotations,
+  std::vector<Mat3>& globalRotations,
+  std::size_t nMainViewID = 0);
+
+/**
+ * @brief Refine the global rotations with Iteratively Reweighted Least Squares (IRLS) [1].
+ *        At each iteration, the rotation updates are the solution of a sparse weighted graph Laplacian system
+ *        and the weights of the relative rotations are given by the Geman-McClure robust function of their residual.
+ *        The Laplacian sparsity pattern is analyzed once for all the iterations.
+ *
+ * @param[in] relativeRotations Relative weighted rotation matrices (Rj = Rij * Ri)
+ * @param[in,out] globalRotations global rotation matrices
+ * @param[in] nMainViewID Id of the camera considered as Identity (unit rotation)
+ * @param[in] sigma scale of the robust function (radian)
+ * @param[in] maxIterations maximum number of iterations
+ * @param[in] eps stop when the mean rotation update is below this value (radian)
+ * @return false if a linear system cannot be solved
+ */
+bool RefineRotationsIRLS(
+  const RelativeRotations& relativeRotations,
+  std::vector<Mat3>& globalRotations,
+  std::size_t nMainViewID = 0,
+  double sigma = aliceVision::degreeToRadian(5.0),
+  unsigned int maxIterations = 32,
+  double eps = 1e-6);
+
+/**
+ * @brief Compute the global rotations with a chordal initialization refined by IRLS,
+ *        and label the relative rotations as inliers or outliers.
+ *
+ * @param[in] nCamera The number of cameras to solve
+ * @param[in] relativeRotations Relative weighted rotation matrices (Rj = Rij * Ri)
+ * @param[out] globalRotations output global rotation matrices
+ * @param[in] nMainViewID Id of the camera considered as Identity (unit rotation)
+ * @param[in] maxAngularError angular error limit of the inlier relative rotations (degree)
+ * @param[out] inliers inlier, outlier labels
+ */
+bool GlobalRotationsIRLS(
+  std::size_t nCamera,
+  const RelativeRotations& relativeRotations,
+  std::vector<Mat3>& globalRotations,
+  std::size_t nMainViewID = 0,
+  double maxAngularError = 5.0,
+  std::vector<bool>* inliers = nullptr);
+
+/**
+ * @brief Compute the residual angle of each relative rotation: the angle of Rj^T * Rij * Ri.
+ *
+ * @param[in] relativeRotations Relative weighted rotation matrices (Rj = Rij * Ri)
+ * @param[in] globalRotations global rotation matrices
+ * @param[out] residuals residual rotations (angle axis, radian)
+ */
+void ComputeResiduals(
+  const RelativeRotations& relativeRotations,
+  const std::vector<Mat3>& globalRotations,
+  std::vector<Vec3>& residuals);
+
+} // namespace sparse
+} // namespace rotationAveraging
+} // namespace aliceVision
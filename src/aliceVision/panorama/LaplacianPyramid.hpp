@@ -0,0 +1,879 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/panorama/TiledPanorama.hpp>
+#include <aliceVision/image/Image.hpp>
+#include <aliceVision/image/pixelTypes.hpp>
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace panorama {
+
+inline bool feathering(image::Image<image::RGBfColor> & output, const image::Image<image::RGBfColor> & color, const image::Image<unsigned char> & inputMask) {
+
+  std::vector<image::Image<image::RGBfColor>> feathering;
+  std::vector<image::Image<unsigned char>> feathering_mask;
+  feathering.push_back(color);
+  feathering_mask.push_back(inputMask);
+
+  int lvl = 0;
+  int width = color.Width();
+  int height = color.Height();
+  
+  while (1) {
+    const image::Image<image::RGBfColor> & src = feathering[lvl];
+    const image::Image<unsigned char> & src_mask = feathering_mask[lvl];
+  
+    image::Image<image::RGBfColor> half(width / 2, height / 2);
+    image::Image<unsigned char> half_mask(width / 2, height / 2);
+
+    for (int i = 0; i < half.Height(); i++) {
+
+      int di = i * 2;
+      for (int j = 0; j < half.Width(); j++) {
+        int dj = j * 2;
+
+        int count = 0;
+        half(i, j) = image::RGBfColor(0.0,0.0,0.0);
+        
+        if (src_mask(di, dj)) {
+          half(i, j) += src(di, dj);
+          count++;
+        }
+
+        if (src_mask(di, dj + 1)) {
+          half(i, j) += src(di, dj + 1);
+          count++;
+        }
+
+        if (src_mask(di + 1, dj)) {
+          half(i, j) += src(di + 1, dj);
+          count++;
+        }
+
+        if (src_mask(di + 1, dj + 1)) {
+          half(i, j) += src(di + 1, dj + 1);
+          count++;
+        }
+
+        if (count > 0) {
+          half(i, j) /= float(count);
+          half_mask(i, j) = 1;
+        } 
+        else {
+          half_mask(i, j) = 0;
+        }
+      }
+
+      
+    }
+
+    feathering.push_back(half);
+    feathering_mask.push_back(half_mask);
+
+    
+    width = half.Width();
+    height = half.Height();
+
+    if (width < 2 || height < 2) break;
+
+    lvl++;  
+  }
+
+
+  for (int lvl = feathering.size() - 2; lvl >= 0; lvl--) {
+    
+    image::Image<image::RGBfColor> & src = feathering[lvl];
+    image::Image<unsigned char> & src_mask = feathering_mask[lvl];
+    image::Image<image::RGBfColor> & ref = feathering[lvl + 1];
+    image::Image<unsigned char> & ref_mask = feathering_mask[lvl + 1];
+
+    for (int i = 0; i < src_mask.Height(); i++) {
+      for (int j = 0; j < src_mask.Width(); j++) {
+        if (!src_mask(i, j)) {
+          int mi = i / 2;
+          int mj = j / 2;
+
+          if (mi >= ref_mask.Height()) {
+            mi = ref_mask.Height() - 1;
+          }
+
+          if (mj >= ref_mask.Width()) {
+            mj = ref_mask.Width() - 1;
+          }
+
+          src_mask(i, j) = ref_mask(mi, mj);
+          src(i, j) = ref(mi, mj);
+        }
+      }
+    }
+  }
+
+  output = feathering[0];
+
+  return true;
+}
+
+/*Binomial 5 taps kernel (1 4 6 4 1) / 16*/
+const float gaussianKernel5[5] = {1.0f / 16.0f, 4.0f / 16.0f, 6.0f / 16.0f, 4.0f / 16.0f, 1.0f / 16.0f};
+
+/**
+ * @brief Mirror (5432 | 123456 | 5432) or wrap (loop) an index out of [0, size)
+ */
+inline int borderIndex(int index, int size, bool loop) {
+
+  if (loop) {
+    if (index < 0) {
+      index = size + index;
+    }
+    else if (index >= size) {
+      index = index - size;
+    }
+  }
+  else {
+    if (index < 0) {
+      index = -index;
+    }
+    else if (index >= size) {
+      index = size - 1 - (index + 1 - size);
+    }
+  }
+
+  return std::min(std::max(index, 0), size - 1);
+}
+
+/**
+ * @brief Vertical pass: weighted sum of 5 rows of count floats
+ */
+inline void convolveRows5(float * output, const float * const rows[5], size_t count) {
+
+  const float * r0 = rows[0];
+  const float * r1 = rows[1];
+  const float * r2 = rows[2];
+  const float * r3 = rows[3];
+  const float * r4 = rows[4];
+
+  for (size_t k = 0; k < count; k++) {
+    output[k] = gaussianKernel5[0] * r0[k] + gaussianKernel5[1] * r1[k] + gaussianKernel5[2] * r2[k] + gaussianKernel5[3] * r3[k] + gaussianKernel5[4] * r4[k];
+  }
+}
+
+/**
+ * @brief Horizontal pass on a row of width pixels of C interleaved float channels.
+ * Computes the pixels 0, step, 2 * step, ... of the blurred row.
+ */
+template <int C>
+inline void convolveRow5(float * output, const float * input, int width, int step, bool loop) {
+
+  const int output_width = (step == 1) ? width : width / step;
+
+  auto convolveBorder = [&](int j) {
+    const int x = j * step;
+    float * out = output + j * C;
+    for (int c = 0; c < C; c++) {
+      out[c] = 0.0f;
+    }
+    for (int k = 0; k < 5; k++) {
+      const float * in = input + borderIndex(x + k - 2, width, loop) * C;
+      for (int c = 0; c < C; c++) {
+        out[c] += gaussianKernel5[k] * in[c];
+      }
+    }
+  };
+
+  /*Pixels which do not need the border handling are in [first, last)*/
+  const int first = std::min(output_width, (2 + step - 1) / step);
+  const int last = std::max(first, std::min(output_width, (width - 3) / step + 1));
+
+  for (int j = 0; j < first; j++) {
+    convolveBorder(j);
+  }
+
+  if (step == 1) {
+    for (int k = first * C; k < last * C; k++) {
+      output[k] = gaussianKernel5[0] * input[k - 2 * C] + gaussianKernel5[1] * input[k - C] + gaussianKernel5[2] * input[k] + gaussianKernel5[3] * input[k + C] + gaussianKernel5[4] * input[k + 2 * C];
+    }
+  }
+  else {
+    for (int j = first; j < last; j++) {
+      const float * in = input + j * step * C;
+      float * out = output + j * C;
+      for (int c = 0; c < C; c++) {
+        out[c] = gaussianKernel5[0] * in[c - 2 * C] + gaussianKernel5[1] * in[c - C] + gaussianKernel5[2] * in[c] + gaussianKernel5[3] * in[c + C] + gaussianKernel5[4] * in[c + 2 * C];
+      }
+    }
+  }
+
+  for (int j = last; j < output_width; j++) {
+    convolveBorder(j);
+  }
+}
+
+/**
+ * @brief Blur an image with the separable 5x5 binomial kernel and keep one pixel every step pixels.
+ * The image borders are mirrored, or wrapped horizontally if loop.
+ * If a mask is given, the input pixels with a null mask are considered as 0.
+ */
+template <class T>
+void convolveGaussian5x5Step(image::Image<T> & output, const image::Image<T> & input, int step, bool loop, const image::Image<float> * mask) {
+
+  static_assert(sizeof(T) % sizeof(float) == 0, "The pyramid images must store float channels.");
+  constexpr int C = sizeof(T) / sizeof(float);
+
+  const int width = input.Width();
+  const int height = input.Height();
+  const int output_height = (step == 1) ? height : height / step;
+  const float * input_data = reinterpret_cast<const float *>(input.data());
+
+  #pragma omp parallel
+  {
+    std::vector<float> row(size_t(width) * C);
+    std::vector<float> masked_rows(mask ? size_t(5) * width * C : 0);
+
+    #pragma omp for
+    for (int i = 0; i < output_height; i++) {
+
+      const float * rows[5];
+      for (int k = 0; k < 5; k++) {
+
+        const int y = borderIndex(i * step + k - 2, height, false);
+        rows[k] = input_data + size_t(y) * width * C;
+
+        if (mask) {
+          float * masked = masked_rows.data() + size_t(k) * width * C;
+          for (int j = 0; j < width; j++) {
+            const float m = (std::abs((*mask)(y, j)) > 1e-6) ? 1.0f : 0.0f;
+            for (int c = 0; c < C; c++) {
+              masked[j * C + c] = m * rows[k][j * C + c];
+            }
+          }
+          rows[k] = masked;
+        }
+      }
+
+      convolveRows5(row.data(), rows, row.size());
+      convolveRow5<C>(reinterpret_cast<float *>(&output(i, 0)), row.data(), width, step, loop);
+    }
+  }
+}
+
+template<class T>
+bool convolveGaussian5x5(image::Image<T> & output, const image::Image<T> & input, bool loop = false) {
+
+  if (output.size() != input.size()) {
+    return false;
+  }
+
+  convolveGaussian5x5Step(output, input, 1, loop, nullptr);
+
+  return true;
+}
+
+/**
+ * @brief Fused blur and downscale: output(i, j) = blur(input)(2i, 2j)
+ * If a mask is given, the input pixels with a null mask are considered as 0.
+ */
+template<class T>
+bool convolveGaussian5x5Downscale(image::Image<T> & output, const image::Image<T> & input, const image::Image<float> * mask = nullptr) {
+
+  if (output.Width() != input.Width() / 2 || output.Height() != input.Height() / 2) {
+    return false;
+  }
+
+  if (mask && (mask->Width() != input.Width() || mask->Height() != input.Height())) {
+    return false;
+  }
+
+  convolveGaussian5x5Step(output, input, 2, false, mask);
+
+  return true;
+}
+
+/**
+ * @brief Fused upscale, blur and addition: output += factor * blur(upscaled),
+ * where upscaled is an image of the output size, null except for upscaled(2i + 1, 2j + 1) = input(i, j).
+ */
+template<class T>
+bool upscaleGaussian5x5Add(image::Image<T> & output, const image::Image<T> & input, float factor, bool loop) {
+
+  static_assert(sizeof(T) % sizeof(float) == 0, "The pyramid images must store float channels.");
+  constexpr int C = sizeof(T) / sizeof(float);
+
+  const int width = output.Width();
+  const int height = output.Height();
+  const int input_width = input.Width();
+  const int input_height = input.Height();
+
+  if (2 * input_width > width || 2 * input_height > height) {
+    return false;
+  }
+
+  const float * input_data = reinterpret_cast<const float *>(input.data());
+
+  #pragma omp parallel
+  {
+    std::vector<float> low_row(size_t(input_width) * C);
+    std::vector<float> upscaled_row(size_t(width) * C, 0.0f);
+    std::vector<float> blurred_row(size_t(width) * C);
+
+    #pragma omp for
+    for (int i = 0; i < height; i++) {
+
+      /*Vertical pass on the input rows: only the odd rows of the upscaled image are not null*/
+      std::fill(low_row.begin(), low_row.end(), 0.0f);
+      for (int k = 0; k < 5; k++) {
+
+        const int y = borderIndex(i + k - 2, height, false);
+        if (y % 2 == 0 || (y - 1) / 2 >= input_height) {
+          continue;
+        }
+
+        const float * in = input_data + size_t((y - 1) / 2) * input_width * C;
+        for (size_t n = 0; n < low_row.size(); n++) {
+          low_row[n] += gaussianKernel5[k] * in[n];
+        }
+      }
+
+      /*Only the odd columns of the upscaled image are not null*/
+      for (int j = 0; j < input_width; j++) {
+        for (int c = 0; c < C; c++) {
+          upscaled_row[(2 * j + 1) * C + c] = low_row[j * C + c];
+        }
+      }
+
+      convolveRow5<C>(blurred_row.data(), upscaled_row.data(), width, 1, loop);
+
+      float * out = reinterpret_cast<float *>(&output(i, 0));
+      for (size_t n = 0; n < blurred_row.size(); n++) {
+        out[n] += factor * blurred_row[n];
+      }
+    }
+  }
+
+  return true;
+}
+
+/**
+ * @brief Index in the input of upscaleGaussian5x5Add of the pixel read by a tap of the blur.
+ * @return -1 if the tap reads a null pixel of the upscaled image
+ */
+inline int upscaledSourceIndex(int index, int size, int input_size, bool loop) {
+
+  const int x = borderIndex(index, size, loop);
+  if (x % 2 == 0 || (x - 1) / 2 >= input_size) {
+    return -1;
+  }
+
+  return (x - 1) / 2;
+}
+
+/**
+ * @brief Laplacian pyramid of a panorama, accumulated view by view.
+ *
+ * Each level is a tiled panorama storing the weighted sum of the colors in rgb and the sum of the weights in alpha,
+ * so only the tiles covered by the views are allocated and the number of tiles kept in memory is bounded.
+ * The level 0 is the output panorama given by the caller.
+ */
+class LaplacianPyramid {
+public:
+  /**
+   * @param[in] base the level 0, it receives the blended panorama on rebuild
+   * @param[in] max_levels the number of levels
+   * @param[in] maxResidentTiles the number of tiles kept in memory by the level 1, halved on each next level
+   * @param[in] scratchPath the prefix of the scratch files of the levels
+   */
+  LaplacianPyramid(TiledPanorama & base, size_t max_levels, size_t maxResidentTiles, const std::string & scratchPath) :
+  _maxResidentTiles(maxResidentTiles),
+  _scratchPath(scratchPath)
+  {
+    _levels.push_back(&base);
+    addLevels(max_levels);
+  }
+
+  size_t getLevelsCount() const {
+    return _levels.size();
+  }
+
+  TiledPanorama & getLevel(size_t level) {
+    return *_levels[level];
+  }
+
+  bool augment(size_t new_max_levels) {
+
+    if (new_max_levels <= _levels.size()) {
+      return false;
+    }
+
+    size_t old_max_level = _levels.size();
+    TiledPanorama & last = *_levels.back();
+
+    addLevels(new_max_levels);
+
+    bool empty = true;
+    for (size_t tile_y = 0; tile_y < last.getTilesY() && empty; tile_y++) {
+      for (size_t tile_x = 0; tile_x < last.getTilesX() && empty; tile_x++) {
+        empty = !last.isAllocated(tile_x, tile_y);
+      }
+    }
+
+    /*Nothing to distribute on the new levels*/
+    if (empty) {
+      return true;
+    }
+
+    /*
+    The last level is loaded in memory to be distributed on the new levels.
+    The views are appended by increasing number of levels, so this is a low resolution level.
+    */
+    image::Image<image::RGBfColor> current_color(last.Width(), last.Height());
+    image::Image<float> current_weights(last.Width(), last.Height());
+
+    last.forEachPixel(0, 0, last.Width(), last.Height(), [&](const image::RGBAfColor & pix, size_t i, size_t j) {
+      current_color(i, j) = image::RGBfColor(pix.r(), pix.g(), pix.b());
+      current_weights(i, j) = pix.a();
+    });
+    last.clear();
+
+    image::Image<unsigned char> current_mask(current_color.Width(), current_color.Height(), true, 0);
+    image::Image<image::RGBfColor> current_color_feathered(current_color.Width(), current_color.Height());
+
+    for (int i = 0; i < current_color.Height(); i++) {
+      for (int j = 0; j < current_color.Width(); j++) {
+        if (current_weights(i, j) < 1e-6) {
+          current_color(i, j) = image::RGBfColor(0.0);
+          continue;  
+        }
+        
+        current_color(i, j).r() = current_color(i, j).r() / current_weights(i, j);
+        current_color(i, j).g() = current_color(i, j).g() / current_weights(i, j);
+        current_color(i, j).b() = current_color(i, j).b() / current_weights(i, j);
+        current_mask(i ,j) = 255;
+      }
+    }
+
+
+    feathering(current_color_feathered, current_color, current_mask);
+    current_color = current_color_feathered;
+
+    int width = current_color.Width();
+    int height = current_color.Height();
+    image::Image<image::RGBfColor> next_color;
+    image::Image<float> next_weights;
+
+    for (int l = old_max_level - 1; l < new_max_levels - 1; l++)
+    {
+      next_color = aliceVision::image::Image<image::RGBfColor>(width / 2, height / 2);
+      next_weights = aliceVision::image::Image<float>(width / 2, height / 2);
+
+      convolveGaussian5x5Downscale(next_color, current_color);
+      convolveGaussian5x5Downscale(next_weights, current_weights);
+
+      /*Keep the details lost by the next level*/
+      upscaleGaussian5x5Add(current_color, next_color, -4.0f, false);
+
+      merge(current_color, current_weights, l, 0, 0);
+
+      current_color.swap(next_color);
+      current_weights.swap(next_weights);
+      width /= 2;
+      height /= 2;
+    }
+
+    merge(current_color, current_weights, _levels.size() - 1, 0, 0);
+
+    return true;
+  }
+
+  bool apply(const aliceVision::image::Image<image::RGBfColor> & source, const aliceVision::image::Image<unsigned char> & mask, const aliceVision::image::Image<float> & weights, size_t offset_x, size_t offset_y) {
+
+    int width = source.Width();
+    int height = source.Height();
+
+    /* Convert mask to alpha layer */
+    image::Image<float> mask_float(width, height);
+    #pragma omp parallel for
+    for (int i = 0; i < height; i++) {
+      for (int j = 0; j < width; j++) {
+        if (mask(i, j)) {
+          mask_float(i, j) = 1.0f;
+        }
+        else {
+          mask_float(i, j) = 0.0f;
+        }
+      }
+    }
+
+    image::Image<image::RGBfColor> current_color = source;
+    image::Image<image::RGBfColor> next_color;
+    image::Image<float> current_weights = weights;
+    image::Image<float> next_weights;
+    image::Image<float> current_mask = mask_float;
+    image::Image<float> next_mask;
+
+    for (int l = 0; l < _levels.size() - 1; l++)
+    {
+      next_color = aliceVision::image::Image<image::RGBfColor>(width / 2, height / 2);
+      next_weights = aliceVision::image::Image<float>(width / 2, height / 2);
+      next_mask = aliceVision::image::Image<float>(width / 2, height / 2);
+
+      /*Ignore the weights outside the mask*/
+      #pragma omp parallel for
+      for (int i = 0; i < current_color.Height(); i++) {
+        for (int j = 0; j < current_color.Width(); j++) {
+          if (!(std::abs(current_mask(i, j)) > 1e-6)) {
+            current_weights(i, j) = 0.0f;
+          }
+        }
+      }
+
+      /*Apply mask to content during the convolution*/
+      convolveGaussian5x5Downscale(next_color, current_color, &current_mask);
+      convolveGaussian5x5Downscale(next_mask, current_mask);
+      
+      /*
+      Normalize given mask
+      */
+      #pragma omp parallel for
+      for (int i = 0; i < next_color.Height(); i++) {
+        for (int j = 0; j < next_color.Width(); j++) {
+          
+          float m = next_mask(i, j);
+
+          if (std::abs(m) > 1e-6) {
+            next_color(i, j).r() = next_color(i, j).r() / m;
+            next_color(i, j).g() = next_color(i, j).g() / m;
+            next_color(i, j).b() = next_color(i, j).b() / m;
+            next_mask(i, j) = 1.0f;
+          }
+          else {
+            next_color(i, j).r() = 0.0f;
+            next_color(i, j).g() = 0.0f;
+            next_color(i, j).b() = 0.0f;
+            next_mask(i, j) = 0.0f;
+          }
+        }
+      }
+
+      /*Keep the details lost by the next level*/
+      upscaleGaussian5x5Add(current_color, next_color, -4.0f, false);
+
+      convolveGaussian5x5Downscale(next_weights, current_weights);
+
+      merge(current_color, current_weights, l, offset_x, offset_y);
+
+      current_color.swap(next_color);
+      current_weights.swap(next_weights);
+      current_mask.swap(next_mask);
+
+      width /= 2;
+      height /= 2;
+      offset_x /= 2;
+      offset_y /= 2;
+    }
+
+    merge(current_color, current_weights, _levels.size() - 1, offset_x, offset_y);
+
+    return true;
+  }
+  
+  bool merge(const aliceVision::image::Image<image::RGBfColor> & oimg, const aliceVision::image::Image<float> & oweight, size_t level, size_t offset_x, size_t offset_y) {
+
+    /*Only the bounding box of the non null weights is merged, to not allocate the tiles without contribution*/
+    int min_i = oweight.Height();
+    int max_i = -1;
+    int min_j = oweight.Width();
+    int max_j = -1;
+    for (int i = 0; i < oweight.Height(); i++) {
+      for (int j = 0; j < oweight.Width(); j++) {
+        if (oweight(i, j) != 0.0f) {
+          min_i = std::min(min_i, i);
+          max_i = std::max(max_i, i);
+          min_j = std::min(min_j, j);
+          max_j = std::max(max_j, j);
+        }
+      }
+    }
+
+    if (max_i < 0) {
+      return true;
+    }
+
+    _levels[level]->forEachPixel(offset_x + min_j, offset_y + min_i, max_j - min_j + 1, max_i - min_i + 1, [&](image::RGBAfColor & pix, size_t bi, size_t bj) {
+
+      const size_t i = bi + min_i;
+      const size_t j = bj + min_j;
+
+      pix.r() += oimg(i, j).r() * oweight(i, j);
+      pix.g() += oimg(i, j).g() * oweight(i, j);
+      pix.b() += oimg(i, j).b() * oweight(i, j);
+      pix.a() += oweight(i, j);
+    });
+
+    return true;
+  }
+
+  /**
+   * @brief Collapse the pyramid into the level 0.
+   * The rgb channels get the blended color (0 where no view contributes), the alpha channel keeps the sum of the weights.
+   * Only the tiles of the level 0 covered by a view, and the tiles of the other levels needed to rebuild them, are processed.
+   */
+  bool rebuild() {
+
+    const size_t count = _levels.size();
+
+    /*Select the tiles to rebuild, from the finest level to the coarsest*/
+    std::vector<std::vector<bool>> needed(count);
+    for (size_t l = 0; l < count; l++) {
+      needed[l].assign(_levels[l]->getTilesX() * _levels[l]->getTilesY(), false);
+    }
+
+    for (size_t tile_y = 0; tile_y < _levels[0]->getTilesY(); tile_y++) {
+      for (size_t tile_x = 0; tile_x < _levels[0]->getTilesX(); tile_x++) {
+        needed[0][tile_y * _levels[0]->getTilesX() + tile_x] = _levels[0]->isAllocated(tile_x, tile_y);
+      }
+    }
+
+    for (size_t l = 0; l + 1 < count; l++) {
+
+      const TiledPanorama & level = *_levels[l];
+      const TiledPanorama & low = *_levels[l + 1];
+
+      for (size_t tile_y = 0; tile_y < level.getTilesY(); tile_y++) {
+        for (size_t tile_x = 0; tile_x < level.getTilesX(); tile_x++) {
+
+          if (!needed[l][tile_y * level.getTilesX() + tile_x]) {
+            continue;
+          }
+
+          const UpscaleTaps taps = getUpscaleTaps(l, tile_x, tile_y);
+          for (int low_tile_y = taps.rowMin / low.getTileSize(); !taps.cols.empty() && low_tile_y <= taps.rowMax / low.getTileSize(); low_tile_y++) {
+            for (int col : taps.cols) {
+              needed[l + 1][low_tile_y * low.getTilesX() + col / low.getTileSize()] = true;
+            }
+          }
+        }
+      }
+    }
+
+    /*The coarsest level has no details to add*/
+    TiledPanorama & coarsest = *_levels[count - 1];
+    for (size_t tile_y = 0; tile_y < coarsest.getTilesY(); tile_y++) {
+      for (size_t tile_x = 0; tile_x < coarsest.getTilesX(); tile_x++) {
+
+        if (!needed[count - 1][tile_y * coarsest.getTilesX() + tile_x]) {
+          continue;
+        }
+
+        TiledPanorama::Tile & tile = coarsest.getTile(tile_x, tile_y);
+        for (int i = 0; i < tile.Height(); i++) {
+          for (int j = 0; j < tile.Width(); j++) {
+            normalize(tile(i, j));
+          }
+        }
+      }
+    }
+
+    for (int l = int(count) - 2; l >= 0; l--) {
+
+      const TiledPanorama & level = *_levels[l];
+      for (size_t tile_y = 0; tile_y < level.getTilesY(); tile_y++) {
+        for (size_t tile_x = 0; tile_x < level.getTilesX(); tile_x++) {
+          if (needed[l][tile_y * level.getTilesX() + tile_x]) {
+            rebuildTile(l, tile_x, tile_y);
+          }
+        }
+      }
+    }
+
+    return true;
+  }
+
+private:
+  /*Pixels of the next level read by the blur of the upscaled next level on a tile*/
+  struct UpscaleTaps {
+    int rowMin = INT_MAX;
+    int rowMax = -1;
+    /*Row of the next level read by each tap (5 per row of the tile), -1 for a null pixel of the upscaled image*/
+    std::vector<int> rows;
+    /*Sorted columns of the next level read by the tile*/
+    std::vector<int> cols;
+    /*Index in cols of the column read by each tap (5 per column of the tile), -1 for a null pixel of the upscaled image*/
+    std::vector<int> colIndices;
+  };
+
+  static void normalize(image::RGBAfColor & pix) {
+
+    if (pix.a() < 1e-6) {
+      pix.r() = 0.0f;
+      pix.g() = 0.0f;
+      pix.b() = 0.0f;
+      return;
+    }
+
+    pix.r() = pix.r() / pix.a();
+    pix.g() = pix.g() / pix.a();
+    pix.b() = pix.b() / pix.a();
+  }
+
+  void addLevels(size_t max_levels) {
+
+    while (_levels.size() < max_levels) {
+
+      const TiledPanorama & previous = *_levels.back();
+      const size_t level = _levels.size();
+      const size_t maxResidentTiles = std::max<size_t>(1, _maxResidentTiles >> (level - 1));
+
+      _ownedLevels.emplace_back(new TiledPanorama(previous.Width() / 2, previous.Height() / 2, previous.getTileSize(), maxResidentTiles, _scratchPath + "." + std::to_string(level)));
+      _levels.push_back(_ownedLevels.back().get());
+    }
+  }
+
+  /**
+   * @brief Get the pixels of the next level read by upscaleGaussian5x5Add(level, next level, 4, true) on a tile of the level
+   */
+  UpscaleTaps getUpscaleTaps(size_t level, size_t tile_x, size_t tile_y) const {
+
+    const TiledPanorama & img = *_levels[level];
+    const TiledPanorama & low = *_levels[level + 1];
+
+    const int x0 = tile_x * img.getTileSize();
+    const int y0 = tile_y * img.getTileSize();
+    const int width = std::min<int>(img.getTileSize(), int(img.Width()) - x0);
+    const int height = std::min<int>(img.getTileSize(), int(img.Height()) - y0);
+
+    UpscaleTaps taps;
+
+    taps.rows.resize(size_t(height) * 5);
+    for (int i = 0; i < height; i++) {
+      for (int k = 0; k < 5; k++) {
+        const int r = upscaledSourceIndex(y0 + i + k - 2, img.Height(), low.Height(), false);
+        taps.rows[i * 5 + k] = r;
+        if (r >= 0) {
+          taps.rowMin = std::min(taps.rowMin, r);
+          taps.rowMax = std::max(taps.rowMax, r);
+        }
+      }
+    }
+
+    taps.colIndices.resize(size_t(width) * 5);
+    for (int j = 0; j < width; j++) {
+      for (int k = 0; k < 5; k++) {
+        const int c = upscaledSourceIndex(x0 + j + k - 2, img.Width(), low.Width(), true);
+        taps.colIndices[j * 5 + k] = c;
+        if (c >= 0) {
+          taps.cols.push_back(c);
+        }
+      }
+    }
+
+    if (taps.rowMax < 0) {
+      taps.cols.clear();
+    }
+
+    std::sort(taps.cols.begin(), taps.cols.end());
+    taps.cols.erase(std::unique(taps.cols.begin(), taps.cols.end()), taps.cols.end());
+
+    for (int & c : taps.colIndices) {
+      if (c >= 0) {
+        c = taps.cols.empty() ? -1 : int(std::lower_bound(taps.cols.begin(), taps.cols.end(), c) - taps.cols.begin());
+      }
+    }
+
+    return taps;
+  }
+
+  /**
+   * @brief Normalize a tile of a level and add the upscaled next level (already rebuilt), tile-wise equivalent of
+   * upscaleGaussian5x5Add(level, next level, 4, true)
+   */
+  void rebuildTile(size_t level, size_t tile_x, size_t tile_y) {
+
+    TiledPanorama & img = *_levels[level];
+    TiledPanorama & low = *_levels[level + 1];
+
+    const UpscaleTaps taps = getUpscaleTaps(level, tile_x, tile_y);
+    const int ncols = taps.cols.size();
+    const int nrows = ncols ? taps.rowMax - taps.rowMin + 1 : 0;
+
+    /*Load the pixels of the next level read by the tile, by runs of consecutive columns*/
+    image::Image<image::RGBfColor> patch(ncols, nrows);
+    for (int start = 0; start < ncols;) {
+
+      int end = start + 1;
+      while (end < ncols && taps.cols[end] == taps.cols[end - 1] + 1) {
+        end++;
+      }
+
+      low.forEachPixel(taps.cols[start], taps.rowMin, end - start, nrows, [&](const image::RGBAfColor & pix, size_t i, size_t j) {
+        patch(i, start + j) = image::RGBfColor(pix.r(), pix.g(), pix.b());
+      });
+
+      start = end;
+    }
+
+    const int width = std::min<int>(img.getTileSize(), int(img.Width() - tile_x * img.getTileSize()));
+    const int height = std::min<int>(img.getTileSize(), int(img.Height() - tile_y * img.getTileSize()));
+    TiledPanorama::Tile & tile = img.getTile(tile_x, tile_y);
+
+    #pragma omp parallel
+    {
+      std::vector<image::RGBfColor> low_row(ncols);
+
+      #pragma omp for
+      for (int i = 0; i < height; i++) {
+
+        /*Vertical pass on the rows of the next level*/
+        std::fill(low_row.begin(), low_row.end(), image::RGBfColor(0.0f));
+        for (int k = 0; k < 5; k++) {
+
+          const int r = taps.rows[i * 5 + k];
+          if (r < 0) {
+            continue;
+          }
+
+          for (int c = 0; c < ncols; c++) {
+            low_row[c] += patch(r - taps.rowMin, c) * gaussianKernel5[k];
+          }
+        }
+
+        /*Horizontal pass, added to the normalized level*/
+        for (int j = 0; j < width; j++) {
+
+          image::RGBfColor upscaled(0.0f);
+          for (int k = 0; k < 5; k++) {
+            const int c = taps.colIndices[j * 5 + k];
+            if (c >= 0) {
+              upscaled += low_row[c] * gaussianKernel5[k];
+            }
+          }
+
+          image::RGBAfColor & pix = tile(i, j);
+          normalize(pix);
+          pix.r() += 4.0f * upscaled.r();
+          pix.g() += 4.0f * upscaled.g();
+          pix.b() += 4.0f * upscaled.b();
+        }
+      }
+    }
+  }
+
+  size_t _maxResidentTiles;
+  std::string _scratchPath;
+  /*All the levels, the level 0 is owned by the caller*/
+  std::vector<TiledPanorama *> _levels;
+  std::vector<std::unique_ptr<TiledPanorama>> _ownedLevels;
+};
+
+} // namespace panorama
+} // namespace aliceVision
@@ -0,0 +1,288 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/image/Image.hpp>
+#include <aliceVision/image/pixelTypes.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <list>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace aliceVision {
+namespace panorama {
+
+/**
+ * @brief Panorama image split in square tiles, with a bounded number of tiles kept in memory.
+ *
+ * Tiles are allocated on first access and the pixels of the tiles never accessed have the fill value.
+ * When more than maxResidentTiles tiles are in memory, the least recently used one is spilled
+ * to a scratch file and reloaded on its next access.
+ */
+class TiledPanorama {
+public:
+  using Tile = image::Image<image::RGBAfColor>;
+
+  TiledPanorama(size_t width, size_t height, size_t tileSize, size_t maxResidentTiles, const std::string & scratchPath) :
+  _width(width),
+  _height(height),
+  _tileSize(tileSize),
+  _tilesX((width + tileSize - 1) / tileSize),
+  _tilesY((height + tileSize - 1) / tileSize),
+  _maxResidentTiles(std::max<size_t>(1, maxResidentTiles)),
+  _scratchPath(scratchPath),
+  _spilled(_tilesX * _tilesY, false),
+  _fillValue(0.0f, 0.0f, 0.0f, 0.0f)
+  {
+  }
+
+  ~TiledPanorama() {
+
+    if (_scratch.is_open()) {
+      _scratch.close();
+      boost::system::error_code ec;
+      boost::filesystem::remove(_scratchPath, ec);
+    }
+  }
+
+  size_t Width() const {
+    return _width;
+  }
+
+  size_t Height() const {
+    return _height;
+  }
+
+  size_t getTileSize() const {
+    return _tileSize;
+  }
+
+  size_t getTilesX() const {
+    return _tilesX;
+  }
+
+  size_t getTilesY() const {
+    return _tilesY;
+  }
+
+  /**
+   * @brief Get the maximal number of tiles kept in memory at the same time since the creation
+   */
+  size_t getResidentTilesPeak() const {
+    return _residentTilesPeak;
+  }
+
+  size_t getMaxResidentTiles() const {
+    return _maxResidentTiles;
+  }
+
+  /**
+   * @brief Set the value of the pixels of the tiles never accessed
+   */
+  void setFillValue(const image::RGBAfColor & value) {
+    _fillValue = value;
+  }
+
+  const image::RGBAfColor & getFillValue() const {
+    return _fillValue;
+  }
+
+  bool isAllocated(size_t tile_x, size_t tile_y) const {
+    const size_t index = tile_y * _tilesX + tile_x;
+    return _spilled[index] || _resident.count(index);
+  }
+
+  /**
+   * @brief Release all the tiles, all the pixels get the fill value
+   */
+  void clear() {
+    _resident.clear();
+    _lru.clear();
+    std::fill(_spilled.begin(), _spilled.end(), false);
+    _lastIndex = std::numeric_limits<size_t>::max();
+    _lastTile = nullptr;
+  }
+
+  /**
+   * @brief Get a tile, loaded or allocated if needed
+   * @note The reference stays valid until maxResidentTiles other tiles are accessed
+   */
+  Tile & getTile(size_t tile_x, size_t tile_y) {
+
+    const size_t index = tile_y * _tilesX + tile_x;
+    if (index == _lastIndex) {
+      return *_lastTile;
+    }
+
+    auto it = _resident.find(index);
+    if (it != _resident.end()) {
+      _lru.splice(_lru.begin(), _lru, it->second.lru);
+    }
+    else {
+      std::unique_ptr<Tile> tile;
+
+      if (_resident.size() >= _maxResidentTiles) {
+        tile = spill();
+      }
+      else {
+        tile.reset(new Tile(_tileSize, _tileSize));
+      }
+
+      if (_spilled[index]) {
+        _scratch.seekg(index * tileBytes());
+        if (!_scratch.read(reinterpret_cast<char*>(tile->data()), tileBytes())) {
+          throw std::runtime_error("Unable to read the panorama tiles scratch file: " + _scratchPath);
+        }
+      }
+      else {
+        tile->fill(_fillValue);
+      }
+
+      _lru.push_front(index);
+      it = _resident.emplace(index, CachedTile{std::move(tile), _lru.begin()}).first;
+      _residentTilesPeak = std::max(_residentTilesPeak, _resident.size());
+    }
+
+    _lastIndex = index;
+    _lastTile = it->second.tile.get();
+
+    return *_lastTile;
+  }
+
+  image::RGBAfColor & operator()(size_t y, size_t x) {
+    return getTile(x / _tileSize, y / _tileSize)(y % _tileSize, x % _tileSize);
+  }
+
+  /**
+   * @brief Call f(pixel, i, j) for each panorama pixel covered by the pixel (i, j) of a block placed at (offset_x, offset_y).
+   * The block wraps horizontally around the panorama and is clipped vertically. Pixels are visited tile by tile.
+   */
+  template <class F>
+  void forEachPixel(size_t offset_x, size_t offset_y, size_t width, size_t height, F && f) {
+
+    const size_t end_y = std::min(offset_y + height, _height);
+
+    for (size_t tile_y = offset_y / _tileSize; tile_y * _tileSize < end_y; tile_y++) {
+
+      const size_t tile_start_y = tile_y * _tileSize;
+      const size_t y0 = std::max(offset_y, tile_start_y);
+      const size_t y1 = std::min(end_y, tile_start_y + _tileSize);
+
+      size_t j = 0;
+      while (j < width) {
+
+        size_t pano_j = offset_x + j;
+        if (pano_j >= _width) {
+          pano_j = pano_j - _width;
+        }
+        if (pano_j >= _width) {
+          break;
+        }
+
+        const size_t tile_x = pano_j / _tileSize;
+        const size_t tile_start_x = tile_x * _tileSize;
+        const size_t count = std::min(std::min(width - j, tile_start_x + _tileSize - pano_j), _width - pano_j);
+
+        Tile & tile = getTile(tile_x, tile_y);
+
+        for (size_t y = y0; y < y1; y++) {
+          for (size_t k = 0; k < count; k++) {
+            f(tile(y - tile_start_y, pano_j - tile_start_x + k), y - offset_y, j + k);
+          }
+        }
+
+        j += count;
+      }
+    }
+  }
+
+  /**
+   * @brief Call f(tile) for each tile already accessed
+   */
+  template <class F>
+  void forEachAllocatedTile(F && f) {
+
+    for (size_t tile_y = 0; tile_y < _tilesY; tile_y++) {
+      for (size_t tile_x = 0; tile_x < _tilesX; tile_x++) {
+        if (isAllocated(tile_x, tile_y)) {
+          f(getTile(tile_x, tile_y));
+        }
+      }
+    }
+  }
+
+private:
+  struct CachedTile {
+    std::unique_ptr<Tile> tile;
+    std::list<size_t>::iterator lru;
+  };
+
+  size_t tileBytes() const {
+    return _tileSize * _tileSize * sizeof(image::RGBAfColor);
+  }
+
+  /**
+   * @brief Write the least recently used tile to the scratch file and release it from the cache
+   * @return the memory of the released tile, for reuse
+   */
+  std::unique_ptr<Tile> spill() {
+
+    if (!_scratch.is_open()) {
+      _scratch.open(_scratchPath, std::ios::in | std::ios::out | std::ios::trunc | std::ios::binary);
+      if (!_scratch.is_open()) {
+        throw std::runtime_error("Unable to create the panorama tiles scratch file: " + _scratchPath);
+      }
+    }
+
+    const size_t index = _lru.back();
+    auto it = _resident.find(index);
+    std::unique_ptr<Tile> tile = std::move(it->second.tile);
+
+    _scratch.seekp(index * tileBytes());
+    if (!_scratch.write(reinterpret_cast<const char*>(tile->data()), tileBytes())) {
+      throw std::runtime_error("Unable to write the panorama tiles scratch file: " + _scratchPath);
+    }
+    _spilled[index] = true;
+
+    _resident.erase(it);
+    _lru.pop_back();
+
+    if (index == _lastIndex) {
+      _lastIndex = std::numeric_limits<size_t>::max();
+      _lastTile = nullptr;
+    }
+
+    return tile;
+  }
+
+  size_t _width;
+  size_t _height;
+  size_t _tileSize;
+  size_t _tilesX;
+  size_t _tilesY;
+  size_t _maxResidentTiles;
+  size_t _residentTilesPeak = 0;
+  std::string _scratchPath;
+  std::fstream _scratch;
+  std::unordered_map<size_t, CachedTile> _resident;
+  std::list<size_t> _lru;
+  std::vector<bool> _spilled;
+  size_t _lastIndex = std::numeric_limits<size_t>::max();
+  Tile * _lastTile = nullptr;
+  image::RGBAfColor _fillValue;
+};
+
+} // namespace panorama
+} // namespace aliceVision
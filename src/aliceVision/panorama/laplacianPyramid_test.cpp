@@ -0,0 +1,189 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/panorama/LaplacianPyramid.hpp>
+
+#define BOOST_TEST_MODULE laplacianPyramid
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/tools/floating_point_comparison.hpp>
+
+#include <boost/filesystem.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::panorama;
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+struct TestView
+{
+  image::Image<image::RGBfColor> color;
+  image::Image<unsigned char> mask;
+  image::Image<float> weights;
+  size_t offset_x;
+  size_t offset_y;
+};
+
+TestView createView(int width, int height, size_t offset_x, size_t offset_y, float phase)
+{
+  TestView view{image::Image<image::RGBfColor>(width, height), image::Image<unsigned char>(width, height, true, 1),
+                image::Image<float>(width, height), offset_x, offset_y};
+
+  for(int i = 0; i < height; ++i)
+  {
+    for(int j = 0; j < width; ++j)
+    {
+      view.color(i, j) = image::RGBfColor(std::sin(i * 0.1f + phase), std::cos(j * 0.07f - phase), 0.5f * std::sin((i + j) * 0.05f));
+      view.weights(i, j) = 1.0f + 0.5f * std::sin(i * 0.03f + j * 0.02f + phase);
+    }
+  }
+
+  return view;
+}
+
+std::string createScratchPath()
+{
+  return (fs::temp_directory_path() / fs::unique_path()).string();
+}
+
+/**
+ * @brief Run the multiband blending of a few views, the first ones on 2 levels then on 4 levels.
+ * One of the views wraps around the 360 seam.
+ */
+void blend(TiledPanorama & panorama, LaplacianPyramid & pyramid)
+{
+  const TestView view1 = createView(128, 96, 64, 64, 0.0f);
+  pyramid.apply(view1.color, view1.mask, view1.weights, view1.offset_x, view1.offset_y);
+
+  pyramid.augment(4);
+
+  const TestView view2 = createView(256, 192, 128, 96, 1.0f);
+  pyramid.apply(view2.color, view2.mask, view2.weights, view2.offset_x, view2.offset_y);
+
+  const TestView view3 = createView(256, 128, panorama.Width() - 128, 32, 2.0f);
+  pyramid.apply(view3.color, view3.mask, view3.weights, view3.offset_x, view3.offset_y);
+
+  pyramid.rebuild();
+}
+
+} // namespace
+
+//-----------------
+// Test summary:
+//-----------------
+// - Accumulate views in a tiled pyramid
+// - Collapse a copy of the levels with upscaleGaussian5x5Add on full images
+// - Assert that the tile-wise rebuild gives the same level 0
+//-----------------
+BOOST_AUTO_TEST_CASE(laplacianPyramid_rebuildSameAsFullImages)
+{
+  const size_t width = 200;
+  const size_t height = 90;
+  const std::string scratchPath = createScratchPath();
+
+  TiledPanorama panorama(width, height, 16, 1000, scratchPath);
+  LaplacianPyramid pyramid(panorama, 3, 1000, scratchPath);
+
+  const TestView view1 = createView(48, 40, 20, 12, 0.0f);
+  const TestView view2 = createView(64, 52, 168, 28, 1.0f);
+  pyramid.apply(view1.color, view1.mask, view1.weights, view1.offset_x, view1.offset_y);
+  pyramid.apply(view2.color, view2.mask, view2.weights, view2.offset_x, view2.offset_y);
+
+  // reference: normalize each level and add the upscaled next level, on full images
+  std::vector<image::Image<image::RGBfColor>> levels;
+  std::vector<image::Image<float>> weights;
+  for(size_t l = 0; l < pyramid.getLevelsCount(); ++l)
+  {
+    TiledPanorama & level = pyramid.getLevel(l);
+    levels.emplace_back(level.Width(), level.Height());
+    weights.emplace_back(level.Width(), level.Height());
+    level.forEachPixel(0, 0, level.Width(), level.Height(), [&](const image::RGBAfColor & pix, size_t i, size_t j) {
+      levels[l](i, j) = (pix.a() < 1e-6) ? image::RGBfColor(0.0f) : image::RGBfColor(pix.r() / pix.a(), pix.g() / pix.a(), pix.b() / pix.a());
+      weights[l](i, j) = pix.a();
+    });
+  }
+  for(int l = int(levels.size()) - 2; l >= 0; --l)
+    BOOST_CHECK(upscaleGaussian5x5Add(levels[l], levels[l + 1], 4.0f, true));
+
+  pyramid.rebuild();
+
+  for(size_t i = 0; i < height; ++i)
+  {
+    for(size_t j = 0; j < width; ++j)
+    {
+      const image::RGBAfColor & pix = panorama(i, j);
+      BOOST_CHECK_SMALL(pix.r() - levels[0](i, j).r(), 1e-4f);
+      BOOST_CHECK_SMALL(pix.g() - levels[0](i, j).g(), 1e-4f);
+      BOOST_CHECK_SMALL(pix.b() - levels[0](i, j).b(), 1e-4f);
+      BOOST_CHECK_EQUAL(pix.a(), weights[0](i, j));
+    }
+  }
+}
+
+//-----------------
+// Test summary:
+//-----------------
+// - Blend views in a large panorama with a small tile cache on every level
+// - Assert that the peak number of tiles in memory stays in the cache budget
+// - Assert that the tiles far from the views are never allocated
+// - Assert that the result is the same as with a cache large enough to never spill a tile
+//-----------------
+BOOST_AUTO_TEST_CASE(laplacianPyramid_boundedMemory)
+{
+  const size_t width = 2048;
+  const size_t height = 1024;
+  const size_t tileSize = 32;
+  const size_t tileBytes = tileSize * tileSize * sizeof(image::RGBAfColor);
+  const size_t maxResidentTiles = 16;
+  const std::string scratchPath = createScratchPath();
+
+  TiledPanorama panorama(width, height, tileSize, maxResidentTiles, scratchPath);
+  LaplacianPyramid pyramid(panorama, 2, maxResidentTiles / 2, scratchPath);
+  blend(panorama, pyramid);
+
+  TiledPanorama panoramaInMemory(width, height, tileSize, panorama.getTilesX() * panorama.getTilesY(), scratchPath + "_inMemory");
+  LaplacianPyramid pyramidInMemory(panoramaInMemory, 2, panorama.getTilesX() * panorama.getTilesY(), scratchPath + "_inMemory");
+  blend(panoramaInMemory, pyramidInMemory);
+
+  // peak memory of the tiles, on each level and in total
+  size_t peakBytes = 0;
+  size_t budgetBytes = 0;
+  for(size_t l = 0; l < pyramid.getLevelsCount(); ++l)
+  {
+    const TiledPanorama & level = pyramid.getLevel(l);
+    BOOST_CHECK_LE(level.getResidentTilesPeak(), level.getMaxResidentTiles());
+    peakBytes += level.getResidentTilesPeak() * tileBytes;
+    budgetBytes += level.getMaxResidentTiles() * tileBytes;
+  }
+  BOOST_CHECK_LE(budgetBytes, 2 * maxResidentTiles * tileBytes);
+  BOOST_CHECK_LE(peakBytes, budgetBytes);
+  // the views cover more tiles than the budget: the cache is used
+  BOOST_CHECK_GT(panoramaInMemory.getResidentTilesPeak(), maxResidentTiles);
+
+  // the tiles never covered by a view are not allocated
+  BOOST_CHECK(!panorama.isAllocated(panorama.getTilesX() / 2, panorama.getTilesY() - 1));
+  BOOST_CHECK(!pyramid.getLevel(1).isAllocated(pyramid.getLevel(1).getTilesX() / 2, pyramid.getLevel(1).getTilesY() - 1));
+
+  size_t allocatedTiles = 0;
+  for(size_t tile_y = 0; tile_y < panorama.getTilesY(); ++tile_y)
+  {
+    for(size_t tile_x = 0; tile_x < panorama.getTilesX(); ++tile_x)
+    {
+      BOOST_REQUIRE_EQUAL(panorama.isAllocated(tile_x, tile_y), panoramaInMemory.isAllocated(tile_x, tile_y));
+      if(!panorama.isAllocated(tile_x, tile_y))
+        continue;
+      ++allocatedTiles;
+
+      const TiledPanorama::Tile & tile = panorama.getTile(tile_x, tile_y);
+      const TiledPanorama::Tile & tileInMemory = panoramaInMemory.getTile(tile_x, tile_y);
+      BOOST_CHECK(std::memcmp(tile.data(), tileInMemory.data(), tileBytes) == 0);
+    }
+  }
+  BOOST_CHECK_GT(allocatedTiles, maxResidentTiles);
+  BOOST_CHECK_LT(allocatedTiles, panorama.getTilesX() * panorama.getTilesY() / 2);
+}
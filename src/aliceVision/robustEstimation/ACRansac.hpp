@@ -10,14 +10,19 @@
 #pragma once
 
 #include <aliceVision/robustEstimation/randSampling.hpp>
+#include <aliceVision/robustEstimation/ransacTools.hpp>
 #include <aliceVision/system/Logger.hpp>
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <iterator>
 #include <limits>
 #include <numeric>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
 /**
@@ -130,6 +135,154 @@ inline ErrorIndex bestNFA(int startIndex, //number of point required for estimat
 }
 
 
+/**
+ * @brief Evaluation mode of the NFA in ACRANSAC
+ */
+enum class EACRansacMode
+{
+  EXACT = 0, //< residuals sorted for each model, the NFA is evaluated for every number of inliers
+  FAST = 1   //< residuals binned in a logarithmic histogram, the NFA is evaluated at the bins boundaries,
+             //  and the iterations stop when a better model is unlikely to be found
+};
+
+inline std::string EACRansacMode_enumToString(EACRansacMode mode)
+{
+  switch(mode)
+  {
+    case EACRansacMode::EXACT: return "exact";
+    case EACRansacMode::FAST:  return "fast";
+  }
+  throw std::out_of_range("Invalid ACRansac mode enum");
+}
+
+inline EACRansacMode EACRansacMode_stringToEnum(const std::string& mode)
+{
+  if(mode == "exact")
+    return EACRansacMode::EXACT;
+  if(mode == "fast")
+    return EACRansacMode::FAST;
+  throw std::out_of_range("Invalid ACRansac mode string " + mode);
+}
+
+inline std::ostream& operator<<(std::ostream& os, EACRansacMode e)
+{
+  return os << EACRansacMode_enumToString(e);
+}
+
+inline std::istream& operator>>(std::istream& in, EACRansacMode& mode)
+{
+  std::string token;
+  in >> token;
+  mode = EACRansacMode_stringToEnum(token);
+  return in;
+}
+
+/**
+ * @brief Histogram of the residuals with fixed logarithmic bins, used by the fast NFA evaluation.
+ *
+ * The bins are given by the float representation of the residual (exponent and first mantissa bits),
+ * so the bin of a residual is computed without any logarithm. Each bin stores its number of residuals
+ * and its largest residual: the NFA evaluated at a bin boundary is the exact NFA for this number of inliers.
+ */
+class NFAHistogram
+{
+public:
+  /// number of bins per octave (power of 2)
+  static const int binsPerOctaveLog2 = 3;
+  /// residuals in [2^-64, 2^64[ have their own bins, the others are in the first or last bin
+  static const int minExponent = -64;
+  static const int maxExponent = 64;
+  static const std::size_t nbBins = std::size_t(maxExponent - minExponent) << binsPerOctaveLog2;
+
+  NFAHistogram()
+    : _counts(nbBins, 0)
+    , _maxResiduals(nbBins, 0.0)
+  {}
+
+  static std::size_t bin(double residual)
+  {
+    static const float minResidual = std::ldexp(1.f, minExponent);
+    static const float maxResidual = std::ldexp(1.f, maxExponent);
+    const float r = static_cast<float>(residual);
+    if(!(r > minResidual)) // also for NaN
+      return 0;
+    if(r >= maxResidual)
+      return nbBins - 1;
+    std::uint32_t bits;
+    std::memcpy(&bits, &r, sizeof(float));
+    // the IEEE 754 representation of a positive float is monotonic
+    return (bits >> (23 - binsPerOctaveLog2)) - (std::uint32_t(127 + minExponent) << binsPerOctaveLog2);
+  }
+
+  /**
+   * @brief Fill the histogram with the residuals lower or equal to maxThreshold.
+   */
+  void fill(const std::vector<double>& residuals, double maxThreshold)
+  {
+    std::fill(_counts.begin(), _counts.end(), 0);
+    _firstBin = nbBins;
+    _lastBin = 0;
+    for(const double residual : residuals)
+    {
+      if(!(residual <= maxThreshold))
+        continue;
+      const std::size_t b = bin(residual);
+      if(_counts[b] == 0 || residual > _maxResiduals[b])
+        _maxResiduals[b] = residual;
+      ++_counts[b];
+      _firstBin = std::min(_firstBin, b);
+      _lastBin = std::max(_lastBin, b);
+    }
+  }
+
+  /**
+   * @brief Find the best NFA evaluated at the bins boundaries.
+   * @see bestNFA
+   * @return the NFA and the number of inliers, the associated threshold is given by getThreshold
+   */
+  ErrorIndex bestNFA(int startIndex,
+                     double logalpha0,
+                     double loge0,
+                     const std::vector<float>& logc_n,
+                     const std::vector<float>& logc_k,
+                     double multError = 1.0)
+  {
+    ErrorIndex bestIndex(std::numeric_limits<double>::infinity(), startIndex);
+    _threshold = 0.0;
+    std::size_t k = 0;
+    for(std::size_t b = _firstBin; b <= _lastBin && b < nbBins; ++b)
+    {
+      if(_counts[b] == 0)
+        continue;
+      k += _counts[b];
+      if(k <= static_cast<std::size_t>(startIndex))
+        continue;
+      const double logalpha = logalpha0 +
+        multError * log10(_maxResiduals[b] + std::numeric_limits<float>::epsilon());
+      const double nfa = loge0 +
+                         logalpha * (double) (k - startIndex) +
+                         logc_n[k] +
+                         logc_k[k];
+      if(nfa < bestIndex.first)
+      {
+        bestIndex = ErrorIndex(nfa, k);
+        _threshold = _maxResiduals[b];
+      }
+    }
+    return bestIndex;
+  }
+
+  /// Largest inlier residual of the last best NFA
+  double getThreshold() const { return _threshold; }
+
+private:
+  std::vector<std::size_t> _counts;
+  std::vector<double> _maxResiduals;
+  std::size_t _firstBin = 0;
+  std::size_t _lastBin = 0;
+  double _threshold = 0.0;
+};
+
 /**
  * @brief ACRANSAC routine (ErrorThreshold, NFA)
  *
@@ -138,6 +291,9 @@ inline ErrorIndex bestNFA(int startIndex, //number of point required for estimat
  * @param[in] nIter maximum number of consecutive iterations
  * @param[out] model returned model if found
  * @param[in] precision upper bound of the precision (squared error)
+ * @param[in] mode NFA evaluation mode, FAST evaluates the NFA in O(n + bins) instead of O(n log(n))
+ *            and stops when no better model has been found for the number of iterations needed to draw
+ *            an outlier-free sample with a 99% confidence (with the inlier ratio of the best model).
  *
  * @return (errorMax, minNFA)
  */
@@ -146,7 +302,8 @@ std::pair<double, double> ACRANSAC(const Kernel& kernel,
                                    std::vector<size_t>& vec_inliers,
                                    std::size_t nIter = 1024,
                                    typename Kernel::ModelT* model = nullptr,
-                                   double precision = std::numeric_limits<double>::infinity())
+                                   double precision = std::numeric_limits<double>::infinity(),
+                                   EACRansacMode mode = EACRansacMode::EXACT)
 {
   vec_inliers.clear();
 
@@ -181,16 +338,25 @@ std::pair<double, double> ACRANSAC(const Kernel& kernel,
 
   bool bACRansacMode = (precision == std::numeric_limits<double>::infinity());
 
+  const bool fastMode = (mode == EACRansacMode::FAST);
+  NFAHistogram histogram;
+  // fast mode early termination
+  const double outliersProbability = 0.01;
+  std::size_t lastImprovementIter = 0;
+  std::size_t nIterNoImprovement = nIter;
+
+  std::vector<std::size_t> vec_sample(sizeSample); // Sample indices
+  std::vector<typename Kernel::ModelT> vec_models; // Up to max_models solutions
+
   // Main estimation loop.
   for(std::size_t iter = 0; iter < nIter; ++iter)
   {
-    std::vector<std::size_t> vec_sample(sizeSample); // Sample indices
     if (bACRansacMode)
       uniformSample(sizeSample, vec_index, vec_sample); // Get random sample
     else
       uniformSample(sizeSample, nData, vec_sample); // Get random sample
 
-    std::vector<typename Kernel::ModelT> vec_models; // Up to max_models solutions
+    vec_models.clear();
     kernel.fit(vec_sample, vec_models);
 
     // Evaluate models
@@ -211,7 +377,42 @@ std::pair<double, double> ACRANSAC(const Kernel& kernel,
         if (nInlier > 2.5 * sizeSample) // does the model is meaningful
           bACRansacMode = true;
       }
-      if (bACRansacMode)
+      if (bACRansacMode && fastMode)
+      {
+        // Most meaningful discrimination inliers/outliers, evaluated on the histogram
+        histogram.fill(vec_residuals_, maxThreshold);
+        const ErrorIndex best = histogram.bestNFA(
+          sizeSample,
+          kernel.logalpha0(),
+          loge0,
+          vec_logc_n,
+          vec_logc_k,
+          kernel.multError());
+
+        if (best.first < minNFA)
+        {
+          // A better model was found
+          better = true;
+          minNFA = best.first;
+          errorMax = histogram.getThreshold(); // Error threshold
+          vec_inliers.clear();
+          for (size_t i = 0; i < nData; ++i)
+          {
+            if (vec_residuals_[i] <= errorMax)
+              vec_inliers.push_back(i);
+          }
+          if(model) *model = vec_models[k];
+
+          ALICEVISION_LOG_TRACE("  nfa=" << minNFA
+            << " inliers=" << best.second << "/" << nData
+            << " precisionNormalized=" << errorMax
+            << " precision=" << kernel.unormalizeError(errorMax)
+            << " (iter=" << iter
+            << ",sample=" << vec_sample
+            << ")");
+        }
+      }
+      else if (bACRansacMode)
       {
         for (size_t i = 0; i < nData; ++i)
         {
@@ -257,6 +458,22 @@ std::pair<double, double> ACRANSAC(const Kernel& kernel,
     if (!bACRansacMode && iter > nIterReserve*2)
       break;
 
+    // Fast mode early exit test -> no better model found after the number of iterations needed
+    // to draw an outlier-free sample with the inlier ratio of the best model
+    if (fastMode && minNFA < 0)
+    {
+      if (better)
+      {
+        lastImprovementIter = iter;
+        const double inlierRatio = vec_inliers.size() / (double) nData;
+        nIterNoImprovement = (inlierRatio >= 1.0) ? 1 : std::max<std::size_t>(1, std::min(nIter, iterationsRequired(sizeSample, outliersProbability, inlierRatio)));
+      }
+      else if (iter - lastImprovementIter >= nIterNoImprovement)
+      {
+        break;
+      }
+    }
+
     // ACRANSAC optimization: draw samples among best set of inliers so far
     if (bACRansacMode && ((better && minNFA<0) || (iter+1==nIter && nIterReserve)))
     {
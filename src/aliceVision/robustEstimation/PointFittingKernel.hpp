@@ -40,6 +40,10 @@ namespace robustEstimation {
  *   2. kernel.getMinimumNbRequiredSamples()
  *   3. kernel.fit(std::vector<std::size_t>, std::vector<ModelT>&)
  *   4. kernel.error(std::size_t, ModelT) -> error
+ *   5. kernel.errors(ModelT, std::vector<double>&) -> errors of all the samples
+ *
+ * The error functor must provide error(model, x1.col(i), x2.col(i)) and the batched
+ * errors(model, x1, x2, std::vector<double>&) used to evaluate all the samples at once.
  *
  * The fit routine must not clear existing entries in the vector of models; it
  * should append new solutions to the end.
@@ -106,9 +110,7 @@ public:
    */
   inline virtual void errors(const ModelT& model, std::vector<double>& errors) const
   {
-    errors.resize(_x1.cols());
-    for(std::size_t sample = 0; sample < _x1.cols(); ++sample)
-      errors.at(sample) = error(sample, model);
+    _errorEstimator.errors(model, _x1, _x2, errors);
   }
 
   /**
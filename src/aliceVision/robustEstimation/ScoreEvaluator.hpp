@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <vector>
+
 namespace aliceVision {
 namespace robustEstimation{
 
@@ -30,10 +32,16 @@ public:
                std::vector<T>& inliers,
                double threshold) const
   {
+    // evaluate the errors of all the samples at once when the scored samples cover the whole data
+    const bool allSamples = (samples.size() == kernel.nbSamples());
+    std::vector<double> errors;
+    if(allSamples)
+      kernel.errors(model, errors);
+
     double cost = 0.0;
     for(std::size_t j = 0; j < samples.size(); ++j)
     {
-      double error = kernel.error(samples.at(j), model);
+      double error = allSamples ? errors[samples[j]] : kernel.error(samples.at(j), model);
       if (error < threshold) 
       {
         cost += error;
@@ -269,3 +269,102 @@ BOOST_AUTO_TEST_CASE(RansacLineFitter_ACRANSACSimu)
 
   }
 }
+
+// test the histogram NFA: evaluated at the bins boundaries, it gives the exact NFA for these numbers of inliers
+BOOST_AUTO_TEST_CASE(ACRansac_NFAHistogram)
+{
+  // bins are monotonic
+  BOOST_CHECK(NFAHistogram::bin(0.0) == 0);
+  BOOST_CHECK(NFAHistogram::bin(1e-30) < NFAHistogram::bin(1e-3));
+  BOOST_CHECK(NFAHistogram::bin(1e-3) < NFAHistogram::bin(1.0));
+  BOOST_CHECK(NFAHistogram::bin(1.0) < NFAHistogram::bin(1.2));
+  BOOST_CHECK(NFAHistogram::bin(1.2) < NFAHistogram::bin(2.0));
+  BOOST_CHECK_EQUAL(NFAHistogram::bin(1e30), NFAHistogram::nbBins - 1);
+
+  std::mt19937 gen;
+  std::uniform_real_distribution<double> inlierDistribution(0.0, 1.0);
+  std::uniform_real_distribution<double> outlierDistribution(0.0, 1000.0);
+
+  const std::size_t nData = 200;
+  const std::size_t sizeSample = 2;
+  std::vector<double> residuals(nData);
+  for(std::size_t i = 0; i < nData; ++i)
+    residuals[i] = (i % 3) ? inlierDistribution(gen) : outlierDistribution(gen);
+
+  std::vector<float> vec_logc_n, vec_logc_k;
+  makelogcombi(sizeSample, nData, vec_logc_k, vec_logc_n);
+  const double loge0 = log10(double(nData - sizeSample));
+  const double logalpha0 = log10(M_PI / (100.0 * 100.0));
+  const double maxThreshold = 1e4;
+
+  std::vector<ErrorIndex> sortedResiduals(nData);
+  for(std::size_t i = 0; i < nData; ++i)
+    sortedResiduals[i] = ErrorIndex(residuals[i], i);
+  std::sort(sortedResiduals.begin(), sortedResiduals.end());
+  const ErrorIndex exact = bestNFA(sizeSample, logalpha0, sortedResiduals, loge0, maxThreshold, vec_logc_n, vec_logc_k, 0.5);
+
+  NFAHistogram histogram;
+  histogram.fill(residuals, maxThreshold);
+  const ErrorIndex fast = histogram.bestNFA(sizeSample, logalpha0, loge0, vec_logc_n, vec_logc_k, 0.5);
+
+  // the histogram NFA is one of the exact NFAs, so it can't be better than the exact minimum
+  BOOST_CHECK(fast.first >= exact.first - 1e-6);
+  BOOST_CHECK(fast.first < 0);
+  BOOST_CHECK(fast.second > 0);
+  BOOST_CHECK_SMALL(histogram.getThreshold() - sortedResiduals[fast.second - 1].first, 1e-12);
+  // the inliers/outliers separation is found
+  BOOST_CHECK(histogram.getThreshold() < 1.0);
+  BOOST_CHECK(fast.second >= nData / 2);
+}
+
+// test the fast ACRANSAC mode finds the same line as the exact mode
+BOOST_AUTO_TEST_CASE(RansacLineFitter_FastMode)
+{
+  const int S = 100;
+  const int W = S, H = S;
+  const float outlierRatio = .3f;
+  Vec2 GTModel;
+  GTModel << -2, .3;
+  std::mt19937 gen;
+
+  const std::size_t numPoints = 2.0 * S * sqrt(2.0);
+  Mat2X points(2, numPoints);
+  std::vector<std::size_t> vec_inliersGT;
+  generateLine(numPoints, outlierRatio, 0.5, GTModel, gen, points, vec_inliersGT);
+
+  LineKernel lineKernel(points, W, H);
+
+  std::vector<std::size_t> exactInliers;
+  robustEstimation::MatrixModel<Vec2> exactModel;
+  const std::pair<double,double> exactRet = ACRANSAC(lineKernel, exactInliers, 1000, &exactModel);
+
+  std::vector<std::size_t> fastInliers;
+  robustEstimation::MatrixModel<Vec2> fastModel;
+  const std::pair<double,double> fastRet = ACRANSAC(lineKernel, fastInliers, 1000, &fastModel,
+                                                    std::numeric_limits<double>::infinity(), EACRansacMode::FAST);
+
+  BOOST_CHECK(fastRet.second < 0);
+  BOOST_CHECK(!fastInliers.empty());
+  BOOST_CHECK(fastInliers.size() <= vec_inliersGT.size());
+  BOOST_CHECK(std::abs(double(fastInliers.size()) - double(exactInliers.size())) <= 0.1 * exactInliers.size());
+  BOOST_CHECK_SMALL(fastModel.getMatrix()[1] - GTModel(1), 0.05);
+  BOOST_CHECK(std::abs(fastModel.getMatrix()[0] - GTModel(0)) < 1.0);
+  BOOST_CHECK(fastRet.first < 4 * exactRet.first + 1.0);
+
+  std::stringstream ss;
+  ss << EACRansacMode::FAST;
+  EACRansacMode mode;
+  ss >> mode;
+  BOOST_CHECK(mode == EACRansacMode::FAST);
+}
+
+// the number of iterations of the fast mode early exit stays defined for tiny inlier ratios
+BOOST_AUTO_TEST_CASE(RansacTools_IterationsRequired_TinyInlierRatio)
+{
+  // (1 - 0.5^2)^n <= 0.01 => n >= 16.008
+  BOOST_CHECK_EQUAL(iterationsRequired(2, 0.01, 0.5), 16);
+
+  // pow(inlierRatio, sampleSize) underflows, log(1 - 0) == 0
+  BOOST_CHECK_EQUAL(iterationsRequired(8, 0.01, 1e-50), std::numeric_limits<std::size_t>::max());
+  BOOST_CHECK_EQUAL(iterationsRequired(8, 0.01, 0.0), std::numeric_limits<std::size_t>::max());
+}
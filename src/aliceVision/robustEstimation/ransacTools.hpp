@@ -9,6 +9,8 @@
 #pragma once
 
 #include <cmath>
+#include <cstddef>
+#include <limits>
 
 namespace aliceVision {
 namespace robustEstimation{
@@ -26,9 +28,23 @@ inline std::size_t getNumSamples(double minProba, double outlierRatio, std::size
   return static_cast<std::size_t>(std::log(1.-minProba) / std::log(1.-std::pow(1.-outlierRatio, static_cast<int>(sampleSize))));
 }
 
+/**
+ * @brief Number of iterations to draw an outlier-free sample of \a min_samples elements
+ *        with a probability of failure below \a outliersProbability.
+ * @note If the probability of an outlier-free sample underflows (tiny inlier ratio),
+ *       the maximal std::size_t value is returned.
+ */
 inline std::size_t iterationsRequired(std::size_t min_samples, double outliersProbability, double inlierRatio)
 {
-  return static_cast<std::size_t>(std::log(outliersProbability) / std::log(1.0 - std::pow(inlierRatio, static_cast<int>(min_samples))));
+  const double logOutlierSample = std::log(1.0 - std::pow(inlierRatio, static_cast<int>(min_samples)));
+  if(!(logOutlierSample < 0.0))
+    return std::numeric_limits<std::size_t>::max();
+
+  const double iterations = std::log(outliersProbability) / logOutlierSample;
+  if(!(iterations < static_cast<double>(std::numeric_limits<std::size_t>::max())))
+    return std::numeric_limits<std::size_t>::max();
+
+  return static_cast<std::size_t>(iterations);
 }
 
 } // namespace robustEstimation
@@ -7,6 +7,7 @@
 
 #include <aliceVision/sfm/BundleAdjustmentCeres.hpp>
 #include <aliceVision/sfm/ResidualErrorFunctor.hpp>
+#include <aliceVision/sfm/ResidualErrorAnalyticCostFunction.hpp>
 #include <aliceVision/sfm/ResidualErrorConstraintFunctor.hpp>
 #include <aliceVision/sfm/ResidualErrorRotationPriorFunctor.hpp>
 #include <aliceVision/sfmData/SfMData.hpp>
@@ -18,7 +19,9 @@
 
 #include <ceres/rotation.h>
 
+#include <algorithm>
 #include <fstream>
+#include <limits>
 
 
 
@@ -30,6 +33,24 @@ namespace sfm {
 using namespace aliceVision::camera;
 using namespace aliceVision::geometry;
 
+/**
+ * @brief Get the constant parameters of an equidistant camera model, not refined by the Bundle Adjustment
+ * @param[in] intrinsicPtr The equidistant intrinsic pointer
+ * @param[out] focalToRadius The ratio between the camera plane radius of a ray and its angle times the focal length
+ * @param[out] circleRadius The radius of the image circle in pixels
+ */
+void getEquidistantConstants(const IntrinsicBase* intrinsicPtr, double& focalToRadius, double& circleRadius)
+{
+  const camera::EquiDistant& equi = dynamic_cast<const camera::EquiDistant&>(*intrinsicPtr);
+
+  // see EquiDistant::project: radius = angle_Z / (0.5 * fov), with fov = rsensor / (focal * rscale)
+  const double rsensor = std::min(equi.sensorWidth(), equi.sensorHeight());
+  const double rscale = equi.sensorWidth() / std::max(equi.w(), equi.h());
+
+  focalToRadius = 2.0 * rscale / rsensor;
+  circleRadius = equi.getCircleRadius();
+}
+
 /**
  * @brief Create the appropriate cost functor according the provided input camera intrinsic model
  * @param[in] intrinsicPtr The intrinsic pointer
@@ -52,6 +73,18 @@ ceres::CostFunction* createCostFunctionFromIntrinsics(const IntrinsicBase* intri
       return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_PinholeFisheye, 2, 7, 6, 3>(new ResidualErrorFunctor_PinholeFisheye(observation));
     case EINTRINSIC::PINHOLE_CAMERA_FISHEYE1:
       return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_PinholeFisheye1, 2, 4, 6, 3>(new ResidualErrorFunctor_PinholeFisheye1(observation));
+    case EINTRINSIC::EQUIDISTANT_CAMERA:
+    {
+      double focalToRadius, circleRadius;
+      getEquidistantConstants(intrinsicPtr, focalToRadius, circleRadius);
+      return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_Equidistant, 2, 3, 6, 3>(new ResidualErrorFunctor_Equidistant(observation, focalToRadius, circleRadius));
+    }
+    case EINTRINSIC::EQUIDISTANT_CAMERA_RADIAL3:
+    {
+      double focalToRadius, circleRadius;
+      getEquidistantConstants(intrinsicPtr, focalToRadius, circleRadius);
+      return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_EquidistantRadialK3, 2, 6, 6, 3>(new ResidualErrorFunctor_EquidistantRadialK3(observation, focalToRadius, circleRadius));
+    }
     default:
       throw std::logic_error("Cannot create cost function, unrecognized intrinsic type in BA.");
   }
@@ -79,6 +112,18 @@ ceres::CostFunction* createRigCostFunctionFromIntrinsics(const IntrinsicBase* in
       return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_PinholeFisheye, 2, 7, 6, 6, 3>(new ResidualErrorFunctor_PinholeFisheye(observation));
     case EINTRINSIC::PINHOLE_CAMERA_FISHEYE1:
       return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_PinholeFisheye1, 2, 4, 6, 6, 3>(new ResidualErrorFunctor_PinholeFisheye1(observation));
+    case EINTRINSIC::EQUIDISTANT_CAMERA:
+    {
+      double focalToRadius, circleRadius;
+      getEquidistantConstants(intrinsicPtr, focalToRadius, circleRadius);
+      return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_Equidistant, 2, 3, 6, 6, 3>(new ResidualErrorFunctor_Equidistant(observation, focalToRadius, circleRadius));
+    }
+    case EINTRINSIC::EQUIDISTANT_CAMERA_RADIAL3:
+    {
+      double focalToRadius, circleRadius;
+      getEquidistantConstants(intrinsicPtr, focalToRadius, circleRadius);
+      return new ceres::AutoDiffCostFunction<ResidualErrorFunctor_EquidistantRadialK3, 2, 6, 6, 6, 3>(new ResidualErrorFunctor_EquidistantRadialK3(observation, focalToRadius, circleRadius));
+    }
     default:
       throw std::logic_error("Cannot create rig cost function, unrecognized intrinsic type in BA.");
   }
@@ -258,6 +303,7 @@ void BundleAdjustmentCeres::Statistics::show() const
   ALICEVISION_LOG_INFO("Bundle Adjustment Statistics:\n"
                         << ss.str()
                         << "\t- adjustment duration: " << time << " s\n"
+                        << "\t- jacobians evaluation duration: " << jacobianEvaluationTime << " s\n"
                         << "\t- poses:\n"
                         << "\t    - # refined:  " << states[EParameter::POSE][EParameterState::REFINED]  << "\n"
                         << "\t    - # constant: " << states[EParameter::POSE][EParameterState::CONSTANT] << "\n"
@@ -277,6 +323,17 @@ void BundleAdjustmentCeres::Statistics::show() const
                         << "\t- final   RMSE: " << RMSEfinal);
 }
 
+void BundleAdjustmentCeres::setCeresOptions(const CeresOptions& options)
+{
+  // the residual blocks of the persistent problem use the loss function and the cost functions type
+  if(options.lossFunction != _ceresOptions.lossFunction ||
+     options.persistentProblem != _ceresOptions.persistentProblem ||
+     options.useAnalyticJacobians != _ceresOptions.useAnalyticJacobians)
+    resetProblem();
+
+  _ceresOptions = options;
+}
+
 void BundleAdjustmentCeres::setSolverOptions(ceres::Solver::Options& solverOptions) const
 {
   solverOptions.preconditioner_type = _ceresOptions.preconditionerType;
@@ -317,7 +374,10 @@ void BundleAdjustmentCeres::addExtrinsicsToProblem(const sfmData::SfMData& sfmDa
     poseBlock.at(5) = t(2);
 
     double* poseBlockPtr = poseBlock.data();
-    problem.AddParameterBlock(poseBlockPtr, 6);
+
+    // the block can already be in a persistent problem
+    if(!problem.HasParameterBlock(poseBlockPtr))
+      problem.AddParameterBlock(poseBlockPtr, 6);
 
     // add pose parameter to the all parameters blocks pointers list
     _allParametersBlocks.push_back(poseBlockPtr);
@@ -351,11 +411,8 @@ void BundleAdjustmentCeres::addExtrinsicsToProblem(const sfmData::SfMData& sfmDa
     }
 
     // subset parametrization
-    if(!constantExtrinsic.empty())
-    {
-      ceres::SubsetParameterization* subsetParameterization = new ceres::SubsetParameterization(6, constantExtrinsic);
-      problem.SetParameterization(poseBlockPtr, subsetParameterization);
-    }
+    setSubsetParameterization(poseBlockPtr, 6, constantExtrinsic, problem);
+    problem.SetParameterBlockVariable(poseBlockPtr);
 
     _statistics.addState(EParameter::POSE, EParameterState::REFINED);
   };
@@ -433,27 +490,55 @@ void BundleAdjustmentCeres::addIntrinsicsToProblem(const sfmData::SfMData& sfmDa
     // do not refine an intrinsic does not used by any reconstructed view
     if(usageCount <= 0 || getIntrinsicState(intrinsicId) == EParameterState::IGNORED)
     {
+      // remove the intrinsic from a persistent problem
+      const auto intrinsicBlockIt = _intrinsicsBlocks.find(intrinsicId);
+      if(intrinsicBlockIt != _intrinsicsBlocks.end())
+      {
+        removeParameterBlock(intrinsicBlockIt->second.data(), problem);
+        _intrinsicsBlocks.erase(intrinsicBlockIt);
+      }
+
       _statistics.addState(EParameter::INTRINSIC, EParameterState::IGNORED);
       continue;
     }
 
     assert(isValid(intrinsicPtr->getType()));
 
+    // assign the values in place to keep the block memory of a persistent problem
     std::vector<double>& intrinsicBlock = _intrinsicsBlocks[intrinsicId];
-    intrinsicBlock = intrinsicPtr->getParams();
+    const std::vector<double> intrinsicParams = intrinsicPtr->getParams();
+    intrinsicBlock.assign(intrinsicParams.begin(), intrinsicParams.end());
 
     double* intrinsicBlockPtr = intrinsicBlock.data();
-    problem.AddParameterBlock(intrinsicBlockPtr, intrinsicBlock.size());
+
+    // the block can already be in a persistent problem
+    if(!problem.HasParameterBlock(intrinsicBlockPtr))
+      problem.AddParameterBlock(intrinsicBlockPtr, intrinsicBlock.size());
 
     // add intrinsic parameter to the all parameters blocks pointers list
     _allParametersBlocks.push_back(intrinsicBlockPtr);
 
+    // bounds of the focal length and of the optical center, none by default
+    // note: the bounds are always set to overwrite the ones of a persistent problem
+    std::vector<double> lowerBounds(std::min<std::size_t>(3, intrinsicBlock.size()), std::numeric_limits<double>::lowest());
+    std::vector<double> upperBounds(lowerBounds.size(), std::numeric_limits<double>::max());
+
+    const auto setBounds = [&]()
+    {
+      for(std::size_t i = 0; i < lowerBounds.size(); ++i)
+      {
+        problem.SetParameterLowerBound(intrinsicBlockPtr, i, lowerBounds.at(i));
+        problem.SetParameterUpperBound(intrinsicBlockPtr, i, upperBounds.at(i));
+      }
+    };
+
     // keep the camera intrinsic constant
     if(intrinsicPtr->isLocked() || !refineIntrinsics || getIntrinsicState(intrinsicId) == EParameterState::CONSTANT)
     {
       // set the whole parameter block as constant.
       _statistics.addState(EParameter::INTRINSIC, EParameterState::CONSTANT);
       problem.SetParameterBlockConstant(intrinsicBlockPtr);
+      setBounds();
       continue;
     }
 
@@ -469,14 +554,14 @@ void BundleAdjustmentCeres::addIntrinsicsToProblem(const sfmData::SfMData& sfmDa
         // if we have an initial guess, we only authorize a margin around this value.
         assert(intrinsicBlock.size() >= 1);
         const unsigned int maxFocalError = 0.2 * std::max(intrinsicPtr->w(), intrinsicPtr->h()); // TODO : check if rounding is needed
-        problem.SetParameterLowerBound(intrinsicBlockPtr, 0, static_cast<double>(intrinsicScaleOffset->initialScale() - maxFocalError));
-        problem.SetParameterUpperBound(intrinsicBlockPtr, 0, static_cast<double>(intrinsicScaleOffset->initialScale() + maxFocalError));
+        lowerBounds.at(0) = static_cast<double>(intrinsicScaleOffset->initialScale() - maxFocalError);
+        upperBounds.at(0) = static_cast<double>(intrinsicScaleOffset->initialScale() + maxFocalError);
       }
       else // no initial guess
       {
         // we don't have an initial guess, but we assume that we use
         // a converging lens, so the focal length should be positive.
-        problem.SetParameterLowerBound(intrinsicBlockPtr, 0, 0.0);
+        lowerBounds.at(0) = 0.0;
       }
     }
     else
@@ -497,10 +582,10 @@ void BundleAdjustmentCeres::addIntrinsicsToProblem(const sfmData::SfMData& sfmDa
       const double opticalCenterMaxPercent = 0.55;
 
       // add bounds to the principal point
-      problem.SetParameterLowerBound(intrinsicBlockPtr, 1, opticalCenterMinPercent * intrinsicPtr->w());
-      problem.SetParameterUpperBound(intrinsicBlockPtr, 1, opticalCenterMaxPercent * intrinsicPtr->w());
-      problem.SetParameterLowerBound(intrinsicBlockPtr, 2, opticalCenterMinPercent * intrinsicPtr->h());
-      problem.SetParameterUpperBound(intrinsicBlockPtr, 2, opticalCenterMaxPercent * intrinsicPtr->h());
+      lowerBounds.at(1) = opticalCenterMinPercent * intrinsicPtr->w();
+      upperBounds.at(1) = opticalCenterMaxPercent * intrinsicPtr->w();
+      lowerBounds.at(2) = opticalCenterMinPercent * intrinsicPtr->h();
+      upperBounds.at(2) = opticalCenterMaxPercent * intrinsicPtr->h();
     }
     else
     {
@@ -514,11 +599,10 @@ void BundleAdjustmentCeres::addIntrinsicsToProblem(const sfmData::SfMData& sfmDa
       for(std::size_t i = 3; i < intrinsicBlock.size(); ++i)
         constantIntrinisc.push_back(i);
 
-    if(!constantIntrinisc.empty())
-    {
-      ceres::SubsetParameterization* subsetParameterization = new ceres::SubsetParameterization(intrinsicBlock.size(), constantIntrinisc);
-      problem.SetParameterization(intrinsicBlockPtr, subsetParameterization);
-    }
+    // subset parametrization
+    setSubsetParameterization(intrinsicBlockPtr, intrinsicBlock.size(), constantIntrinisc, problem);
+    problem.SetParameterBlockVariable(intrinsicBlockPtr);
+    setBounds();
 
     _statistics.addState(EParameter::INTRINSIC, EParameterState::REFINED);
   }
@@ -555,10 +639,14 @@ void BundleAdjustmentCeres::addLandmarksToProblem(const sfmData::SfMData& sfmDat
     // add landmark parameter to the all parameters blocks pointers list
     _allParametersBlocks.push_back(landmarkBlockPtr);
 
+    // residual blocks of the landmark observations, some of them can already be in a persistent problem
+    HashMap<IndexT, ObservationResidual>& observationsResiduals = _observationsResiduals[landmarkId];
+
     // iterate over 2D observation associated to the 3D landmark
     for(const auto& observationPair: landmark.observations)
     {
-      const sfmData::View& view = sfmData.getView(observationPair.first);
+      const IndexT viewId = observationPair.first;
+      const sfmData::View& view = sfmData.getView(viewId);
       const sfmData::Observation& observation = observationPair.second;
 
       // each residual block takes a point and a camera as input and outputs a 2
@@ -580,29 +668,51 @@ void BundleAdjustmentCeres::addLandmarksToProblem(const sfmData::SfMData& sfmDat
         _linearSolverOrdering.AddElementToGroup(intrinsicBlockPtr, 2);
       }
 
-      if(view.isPartOfRig() && !view.isPoseIndependant())
-      {
-        ceres::CostFunction* costFunction = createRigCostFunctionFromIntrinsics(sfmData.getIntrinsicPtr(view.getIntrinsicId()), observation);
+      const bool isRigResidual = view.isPartOfRig() && !view.isPoseIndependant();
+      double* rigBlockPtr = nullptr;
 
-        double* rigBlockPtr = _rigBlocks.at(view.getRigId()).at(view.getSubPoseId()).data();
+      if(isRigResidual)
+      {
+        rigBlockPtr = _rigBlocks.at(view.getRigId()).at(view.getSubPoseId()).data();
         _linearSolverOrdering.AddElementToGroup(rigBlockPtr, 1);
-
-        problem.AddResidualBlock(costFunction,
-            lossFunction,
-            intrinsicBlockPtr,
-            poseBlockPtr,
-            rigBlockPtr, // subpose of the cameras rig
-            landmarkBlockPtr); // do we need to copy 3D point to avoid false motion, if failure ?
       }
-      else
-      {
-        ceres::CostFunction* costFunction = createCostFunctionFromIntrinsics(sfmData.getIntrinsicPtr(view.getIntrinsicId()), observation);
 
-        problem.AddResidualBlock(costFunction,
-            lossFunction,
-            intrinsicBlockPtr,
-            poseBlockPtr,
-            landmarkBlockPtr); //do we need to copy 3D point to avoid false motion, if failure ?
+      // the residual block of a persistent problem is kept
+      if(observationsResiduals.find(viewId) == observationsResiduals.end())
+      {
+        ObservationResidual& observationResidual = observationsResiduals[viewId];
+        observationResidual.observation = observation;
+        observationResidual.intrinsicBlockPtr = intrinsicBlockPtr;
+        observationResidual.poseBlockPtr = poseBlockPtr;
+        observationResidual.rigBlockPtr = rigBlockPtr;
+
+        if(isRigResidual)
+        {
+          const IntrinsicBase* intrinsicPtr = sfmData.getIntrinsicPtr(view.getIntrinsicId());
+          // the analytic jacobians are only available for the pinhole camera models
+          ceres::CostFunction* costFunction = (_ceresOptions.useAnalyticJacobians && isPinhole(intrinsicPtr->getType())) ? new ResidualErrorAnalyticCostFunction(*intrinsicPtr, observation, true)
+                                                                                                                      : createRigCostFunctionFromIntrinsics(intrinsicPtr, observation);
+
+          observationResidual.residualBlockId = problem.AddResidualBlock(costFunction,
+              lossFunction,
+              intrinsicBlockPtr,
+              poseBlockPtr,
+              rigBlockPtr, // subpose of the cameras rig
+              landmarkBlockPtr); // do we need to copy 3D point to avoid false motion, if failure ?
+        }
+        else
+        {
+          const IntrinsicBase* intrinsicPtr = sfmData.getIntrinsicPtr(view.getIntrinsicId());
+          // the analytic jacobians are only available for the pinhole camera models
+          ceres::CostFunction* costFunction = (_ceresOptions.useAnalyticJacobians && isPinhole(intrinsicPtr->getType())) ? new ResidualErrorAnalyticCostFunction(*intrinsicPtr, observation, false)
+                                                                                                                      : createCostFunctionFromIntrinsics(intrinsicPtr, observation);
+
+          observationResidual.residualBlockId = problem.AddResidualBlock(costFunction,
+              lossFunction,
+              intrinsicBlockPtr,
+              poseBlockPtr,
+              landmarkBlockPtr); //do we need to copy 3D point to avoid false motion, if failure ?
+        }
       }
 
       if(!refineStructure || getLandmarkState(landmarkId) == EParameterState::CONSTANT)
@@ -614,6 +724,7 @@ void BundleAdjustmentCeres::addLandmarksToProblem(const sfmData::SfMData& sfmDat
       else
       {
         _statistics.addState(EParameter::LANDMARK, EParameterState::REFINED);
+        problem.SetParameterBlockVariable(landmarkBlockPtr);
       }
     }
   }
@@ -645,7 +756,7 @@ void BundleAdjustmentCeres::addConstraints2DToProblem(const sfmData::SfMData& sf
 
 
     ceres::CostFunction* costFunction = createConstraintsCostFunctionFromIntrinsics(sfmData.getIntrinsicPtr(view_1.getIntrinsicId()), constraint.ObservationFirst.x, constraint.ObservationSecond.x);
-    problem.AddResidualBlock(costFunction, lossFunction, intrinsicBlockPtr_1, poseBlockPtr_1, poseBlockPtr_2);
+    _otherResiduals.push_back(problem.AddResidualBlock(costFunction, lossFunction, intrinsicBlockPtr_1, poseBlockPtr_1, poseBlockPtr_2));
   }
 }
 
@@ -667,27 +778,86 @@ void BundleAdjustmentCeres::addRotationPriorsToProblem(const sfmData::SfMData& s
 
 
     ceres::CostFunction* costFunction = new ceres::AutoDiffCostFunction<ResidualErrorRotationPriorFunctor, 3, 6, 6>(new ResidualErrorRotationPriorFunctor(prior._second_R_first));
-    problem.AddResidualBlock(costFunction, lossFunction, poseBlockPtr_1, poseBlockPtr_2);
+    _otherResiduals.push_back(problem.AddResidualBlock(costFunction, lossFunction, poseBlockPtr_1, poseBlockPtr_2));
+  }
+}
+
+void BundleAdjustmentCeres::addParametersPriorsToProblem(ceres::Problem& problem)
+{
+  if(_parametersPriors == nullptr || _parametersPriors->weight <= 0.0)
+    return;
+
+  const double sqrtWeight = std::sqrt(_parametersPriors->weight);
+
+  const auto addPrior = [&](double* blockPtr, const double* target, int blockSize)
+  {
+    // only constrain the parameters of the problem
+    if(!problem.HasParameterBlock(blockPtr))
+      return;
+
+    // ceres::NormalPrior cost: 0.5 * ||A * (x - b)||^2
+    const ceres::Matrix A = sqrtWeight * ceres::Matrix::Identity(blockSize, blockSize);
+    const ceres::Vector b = Eigen::Map<const ceres::Vector>(target, blockSize);
+
+    _otherResiduals.push_back(problem.AddResidualBlock(new ceres::NormalPrior(A, b), nullptr, blockPtr));
+  };
+
+  for(const auto& posePair : _parametersPriors->targets.poses)
+  {
+    const auto blockIt = _posesBlocks.find(posePair.first);
+    if(blockIt != _posesBlocks.end())
+      addPrior(blockIt->second.data(), posePair.second.data(), 6);
+  }
+
+  for(const auto& intrinsicPair : _parametersPriors->targets.intrinsics)
+  {
+    const auto blockIt = _intrinsicsBlocks.find(intrinsicPair.first);
+    if(blockIt != _intrinsicsBlocks.end() && blockIt->second.size() == intrinsicPair.second.size())
+      addPrior(blockIt->second.data(), intrinsicPair.second.data(), intrinsicPair.second.size());
   }
+
+  for(const auto& landmarkPair : _parametersPriors->targets.landmarks)
+  {
+    const auto blockIt = _landmarksBlocks.find(landmarkPair.first);
+    if(blockIt != _landmarksBlocks.end())
+      addPrior(blockIt->second.data(), landmarkPair.second.data(), 3);
+  }
+}
+
+BundleAdjustmentCeres::ParametersBlocks BundleAdjustmentCeres::getParametersBlocks() const
+{
+  ParametersBlocks blocks;
+  blocks.poses = _posesBlocks;
+  blocks.intrinsics = _intrinsicsBlocks;
+  blocks.landmarks = _landmarksBlocks;
+  return blocks;
 }
 
 void BundleAdjustmentCeres::createProblem(const sfmData::SfMData& sfmData,
                                           ERefineOptions refineOptions,
                                           ceres::Problem& problem)
 {
-  // clear previously computed data
-  resetProblem();
+  // clear the data of the previous call, the blocks of a persistent problem are kept
+  _statistics = Statistics();
+  _allParametersBlocks.clear();
+  _linearSolverOrdering.Clear();
 
   // ensure we are not using incompatible options
   // REFINEINTRINSICS_OPTICALCENTER_ALWAYS and REFINEINTRINSICS_OPTICALCENTER_IF_ENOUGH_DATA cannot be used at the same time
   assert(!((refineOptions & REFINE_INTRINSICS_OPTICALCENTER_ALWAYS) && (refineOptions & REFINE_INTRINSICS_OPTICALCENTER_IF_ENOUGH_DATA)));
 
+  // remove the outdated blocks of a persistent problem
+  removeOutdatedBlocks(sfmData, problem);
+
   // add SfM extrincics to the Ceres problem
   addExtrinsicsToProblem(sfmData, refineOptions, problem);
 
   // add SfM intrinsics to the Ceres problem
   addIntrinsicsToProblem(sfmData, refineOptions, problem);
 
+  // the residual blocks of the parameter blocks created again have been removed
+  forgetResidualsOfRemovedBlocks();
+
   // add SfM landmarks to the Ceres problem
   addLandmarksToProblem(sfmData, refineOptions, problem);
 
@@ -696,21 +866,181 @@ void BundleAdjustmentCeres::createProblem(const sfmData::SfMData& sfmData,
 
   // add rotation priors to the Ceres problem
   addRotationPriorsToProblem(sfmData, refineOptions, problem);
+
+  // add parameters priors to the Ceres problem
+  addParametersPriorsToProblem(problem);
 }
 
  void BundleAdjustmentCeres::resetProblem()
 {
   _statistics = Statistics();
 
+  _problem.reset();
+
   _allParametersBlocks.clear();
   _posesBlocks.clear();
   _intrinsicsBlocks.clear();
   _landmarksBlocks.clear();
   _rigBlocks.clear();
 
+  _observationsResiduals.clear();
+  _otherResiduals.clear();
+  _subsetParameterizations.clear();
+  _removedParametersBlocks.clear();
+
   _linearSolverOrdering.Clear();
 }
 
+void BundleAdjustmentCeres::removeParameterBlock(double* blockPtr, ceres::Problem& problem)
+{
+  // note: Ceres also removes the residual blocks depending on this parameter block
+  if(problem.HasParameterBlock(blockPtr))
+    problem.RemoveParameterBlock(blockPtr);
+
+  _subsetParameterizations.erase(blockPtr);
+  _removedParametersBlocks.insert(blockPtr);
+}
+
+void BundleAdjustmentCeres::forgetResidualsOfRemovedBlocks()
+{
+  if(_removedParametersBlocks.empty())
+    return;
+
+  for(auto& observationsResidualsPair : _observationsResiduals)
+  {
+    HashMap<IndexT, ObservationResidual>& observationsResiduals = observationsResidualsPair.second;
+
+    for(auto it = observationsResiduals.begin(); it != observationsResiduals.end();)
+    {
+      const ObservationResidual& observationResidual = it->second;
+
+      if(_removedParametersBlocks.count(observationResidual.intrinsicBlockPtr) ||
+         _removedParametersBlocks.count(observationResidual.poseBlockPtr) ||
+         _removedParametersBlocks.count(observationResidual.rigBlockPtr))
+        it = observationsResiduals.erase(it);
+      else
+        ++it;
+    }
+  }
+
+  _removedParametersBlocks.clear();
+}
+
+void BundleAdjustmentCeres::removeOutdatedBlocks(const sfmData::SfMData& sfmData, ceres::Problem& problem)
+{
+  // 2D constraints and rotation priors are few, they are always created again
+  for(ceres::ResidualBlockId residualBlockId : _otherResiduals)
+    problem.RemoveResidualBlock(residualBlockId);
+
+  _otherResiduals.clear();
+
+  // poses removed from the scene or ignored by the local strategy
+  for(auto it = _posesBlocks.begin(); it != _posesBlocks.end();)
+  {
+    if(sfmData.getPoses().count(it->first) && getPoseState(it->first) != EParameterState::IGNORED)
+    {
+      ++it;
+      continue;
+    }
+    removeParameterBlock(it->second.data(), problem);
+    it = _posesBlocks.erase(it);
+  }
+
+  // intrinsics removed from the scene
+  // note: the unused or ignored intrinsics are removed in addIntrinsicsToProblem
+  for(auto it = _intrinsicsBlocks.begin(); it != _intrinsicsBlocks.end();)
+  {
+    if(sfmData.getIntrinsics().count(it->first))
+    {
+      ++it;
+      continue;
+    }
+    removeParameterBlock(it->second.data(), problem);
+    it = _intrinsicsBlocks.erase(it);
+  }
+
+  // uninitialized rig sub-poses
+  for(auto& rigBlocksPair : _rigBlocks)
+  {
+    const auto rigIt = sfmData.getRigs().find(rigBlocksPair.first);
+    HashMap<IndexT, std::array<double,6>>& subPosesBlocks = rigBlocksPair.second;
+
+    for(auto it = subPosesBlocks.begin(); it != subPosesBlocks.end();)
+    {
+      if(rigIt != sfmData.getRigs().end() &&
+         it->first < rigIt->second.getNbSubPoses() &&
+         rigIt->second.getSubPose(it->first).status != sfmData::ERigSubPoseStatus::UNINITIALIZED)
+      {
+        ++it;
+        continue;
+      }
+      removeParameterBlock(it->second.data(), problem);
+      it = subPosesBlocks.erase(it);
+    }
+  }
+
+  // landmarks removed from the scene or ignored by the local strategy
+  for(auto it = _landmarksBlocks.begin(); it != _landmarksBlocks.end();)
+  {
+    const IndexT landmarkId = it->first;
+
+    if(sfmData.getLandmarks().count(landmarkId) && getLandmarkState(landmarkId) != EParameterState::IGNORED)
+    {
+      ++it;
+      continue;
+    }
+    removeParameterBlock(it->second.data(), problem);
+    _observationsResiduals.erase(landmarkId);
+    it = _landmarksBlocks.erase(it);
+  }
+
+  forgetResidualsOfRemovedBlocks();
+
+  // removed or modified observations
+  for(auto& observationsResidualsPair : _observationsResiduals)
+  {
+    const sfmData::Observations& observations = sfmData.getLandmarks().at(observationsResidualsPair.first).observations;
+    HashMap<IndexT, ObservationResidual>& observationsResiduals = observationsResidualsPair.second;
+
+    for(auto it = observationsResiduals.begin(); it != observationsResiduals.end();)
+    {
+      const auto observationIt = observations.find(it->first);
+
+      if(observationIt != observations.end() &&
+         observationIt->second.x == it->second.observation.x &&
+         observationIt->second.scale == it->second.observation.scale)
+      {
+        ++it;
+        continue;
+      }
+      problem.RemoveResidualBlock(it->second.residualBlockId);
+      it = observationsResiduals.erase(it);
+    }
+  }
+}
+
+void BundleAdjustmentCeres::setSubsetParameterization(double* blockPtr, int blockSize, const std::vector<int>& constantParameters, ceres::Problem& problem)
+{
+  const auto it = _subsetParameterizations.find(blockPtr);
+
+  if(it != _subsetParameterizations.end())
+  {
+    if(it->second == constantParameters)
+      return;
+
+    // a Ceres parameterization cannot be changed, the parameter block is created again
+    removeParameterBlock(blockPtr, problem);
+    problem.AddParameterBlock(blockPtr, blockSize);
+  }
+
+  if(constantParameters.empty())
+    return;
+
+  ceres::SubsetParameterization* subsetParameterization = new ceres::SubsetParameterization(blockSize, constantParameters);
+  problem.SetParameterization(blockPtr, subsetParameterization);
+  _subsetParameterizations[blockPtr] = constantParameters;
+}
+
 void BundleAdjustmentCeres::updateFromSolution(sfmData::SfMData& sfmData, ERefineOptions refineOptions) const
 {
   const bool refinePoses = (refineOptions & REFINE_ROTATION) || (refineOptions & REFINE_TRANSLATION);
@@ -798,6 +1128,9 @@ void BundleAdjustmentCeres::createJacobian(const sfmData::SfMData& sfmData,
                                            ceres::CRSMatrix& jacobian)
 {
   // create problem
+  // note: it also resets the persistent problem
+  resetProblem();
+
   ceres::Problem::Options problemOptions;
   problemOptions.loss_function_ownership = ceres::DO_NOT_TAKE_OWNERSHIP;
   ceres::Problem problem(problemOptions);
@@ -816,10 +1149,19 @@ void BundleAdjustmentCeres::createJacobian(const sfmData::SfMData& sfmData,
 
 bool BundleAdjustmentCeres::adjust(sfmData::SfMData& sfmData, ERefineOptions refineOptions)
 {
-  // create problem
-  ceres::Problem::Options problemOptions;
-  problemOptions.loss_function_ownership = ceres::DO_NOT_TAKE_OWNERSHIP;
-  ceres::Problem problem(problemOptions);
+  // create problem, or update the persistent problem of the previous call
+  if(!_ceresOptions.persistentProblem || _problem == nullptr)
+  {
+    resetProblem();
+
+    ceres::Problem::Options problemOptions;
+    problemOptions.loss_function_ownership = ceres::DO_NOT_TAKE_OWNERSHIP;
+    // the outdated blocks of a persistent problem are removed at each call
+    problemOptions.enable_fast_removal = _ceresOptions.persistentProblem;
+    _problem.reset(new ceres::Problem(problemOptions));
+  }
+
+  ceres::Problem& problem = *_problem;
   createProblem(sfmData, refineOptions, problem);
 
   // configure a Bundle Adjustment engine and run it
@@ -831,6 +1173,10 @@ bool BundleAdjustmentCeres::adjust(sfmData::SfMData& sfmData, ERefineOptions ref
   ceres::Solver::Summary summary;  
   ceres::Solve(options, &problem, &summary);
 
+  // the blocks wrappers are kept until the next call
+  if(!_ceresOptions.persistentProblem)
+    _problem.reset();
+
   // print summary
   if(_ceresOptions.summary)
     ALICEVISION_LOG_INFO(summary.FullReport());
@@ -848,6 +1194,7 @@ bool BundleAdjustmentCeres::adjust(sfmData::SfMData& sfmData, ERefineOptions ref
 
   // store some statitics from the summary
   _statistics.time = summary.total_time_in_seconds;
+  _statistics.jacobianEvaluationTime = summary.jacobian_evaluation_time_in_seconds;
   _statistics.nbSuccessfullIterations = summary.num_successful_steps;
   _statistics.nbUnsuccessfullIterations = summary.num_unsuccessful_steps;
   _statistics.nbResidualBlocks = summary.num_residuals;
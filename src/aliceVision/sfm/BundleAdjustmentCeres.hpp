@@ -11,11 +11,13 @@
 #include <aliceVision/alicevision_omp.hpp>
 #include <aliceVision/sfm/BundleAdjustment.hpp>
 #include <aliceVision/sfm/LocalBundleAdjustmentGraph.hpp>
+#include <aliceVision/sfmData/Landmark.hpp>
 #include <aliceVision/numeric/numeric.hpp>
 
 #include <ceres/ceres.h>
 
 #include <memory>
+#include <set>
 
 
 namespace aliceVision {
@@ -54,6 +56,11 @@ public:
     bool useParametersOrdering = true;
     bool summary = false;
     bool verbose = true;
+    /// keep the Ceres problem between the calls to adjust and only update its outdated blocks
+    bool persistentProblem = false;
+    /// use the analytic jacobians of the pinhole camera models for the reprojection errors (instead of automatic differentiation),
+    /// the other camera models always use automatic differentiation
+    bool useAnalyticJacobians = false;
   };
 
   /**
@@ -104,12 +111,37 @@ public:
     double RMSEfinal = 0.0;
     /// time spent to solve the BA (s)
     double time = 0.0;
+    /// time spent to evaluate the jacobians (s)
+    double jacobianEvaluationTime = 0.0;
     /// number of states per parameter
     std::map<EParameter, std::map<EParameterState, std::size_t>> parametersStates;
     /// The distribution of the cameras for each graph distance <distance, numOfCam>
     std::map<int, std::size_t> nbCamerasPerDistance;
   };
 
+  /**
+   * @brief Parameters values in the format of the Ceres blocks
+   */
+  struct ParametersBlocks
+  {
+    /// block: ceres angleAxis(3) + translation(3)
+    HashMap<IndexT, std::array<double,6>> poses;
+    /// block: intrinsics params
+    HashMap<IndexT, std::vector<double>> intrinsics;
+    /// block: 3d position(3)
+    HashMap<IndexT, std::array<double,3>> landmarks;
+  };
+
+  /**
+   * @brief Quadratic priors pulling the parameters toward target values: 0.5 * weight * ||x - target||^2
+   * @note Used by the consensus iterations of the partitioned bundle adjustment
+   */
+  struct ParametersPriors
+  {
+    double weight = 0.0;
+    ParametersBlocks targets;
+  };
+
   /**
    * @brief Bundle adjustment constructor
    * @param[in] options The user Ceres options
@@ -119,6 +151,22 @@ public:
     : _ceresOptions(options)
   {}
 
+  /**
+   * @brief Get the user Ceres options
+   * @return Ceres options structure const ref
+   */
+  inline const CeresOptions& getCeresOptions() const
+  {
+    return _ceresOptions;
+  }
+
+  /**
+   * @brief Set the user Ceres options used by the next adjustments
+   * @note The persistent problem is reset if the loss function or the problem persistence changes
+   * @param[in] options The user Ceres options
+   */
+  void setCeresOptions(const CeresOptions& options);
+
   /**
    * @brief Create a jacobian CRSMatrix
    * @param[in] sfmData The input SfMData contains all the information about the reconstruction
@@ -131,6 +179,9 @@ public:
 
   /**
    * @brief Perform a Bundle Adjustment on the SfM scene with refinement of the requested parameters
+   * @note With a persistent problem, the blocks of the previous call are reused:
+   *       only the new observations, landmarks, poses and intrinsics are added,
+   *       the removed or ignored ones are removed and the states of the others are updated.
    * @param[in,out] sfmData The input SfMData contains all the information about the reconstruction
    * @param[in] refineOptions The chosen refine flag
    * @return false if the bundle adjustment failed else true
@@ -147,6 +198,21 @@ public:
     _localGraph = localGraph;
   }
 
+  /**
+   * @brief Add quadratic priors on the parameters of the next adjustments
+   * @param[in] priors The parameters priors or nullptr (no priors)
+   */
+  inline void useParametersPriors(const std::shared_ptr<const ParametersPriors>& priors)
+  {
+    _parametersPriors = priors;
+  }
+
+  /**
+   * @brief Get the values of the parameters blocks of the last adjustment
+   * @return parameters blocks values
+   */
+  ParametersBlocks getParametersBlocks() const;
+
   /**
    * @brief Get bundle adjustment statistics structure
    * @return statistics structure const ptr
@@ -172,6 +238,37 @@ private:
    */
   void resetProblem();
 
+  /**
+   * @brief Remove from a persistent problem the parameter and residual blocks which are not in the SfM scene anymore,
+   *        or ignored by the local strategy, or whose observation has changed.
+   * @param[in] sfmData The input SfMData contains all the information about the reconstruction
+   * @param[in,out] problem The Ceres bundle adjustement problem
+   */
+  void removeOutdatedBlocks(const sfmData::SfMData& sfmData, ceres::Problem& problem);
+
+  /**
+   * @brief Remove a parameter block from the problem, with the residual blocks depending on it
+   * @param[in] blockPtr The parameter block pointer
+   * @param[in,out] problem The Ceres bundle adjustement problem
+   */
+  void removeParameterBlock(double* blockPtr, ceres::Problem& problem);
+
+  /**
+   * @brief Forget the observation residual blocks using a parameter block removed from the problem
+   * @note Ceres removes the residual blocks depending on a removed parameter block
+   */
+  void forgetResidualsOfRemovedBlocks();
+
+  /**
+   * @brief Set the subset parameterization of a parameter block.
+   *        A Ceres parameterization cannot be changed: if it differs, the parameter block is created again.
+   * @param[in] blockPtr The parameter block pointer
+   * @param[in] blockSize The parameter block size
+   * @param[in] constantParameters The indexes of the constant parameters
+   * @param[in,out] problem The Ceres bundle adjustement problem
+   */
+  void setSubsetParameterization(double* blockPtr, int blockSize, const std::vector<int>& constantParameters, ceres::Problem& problem);
+
   /**
    * @brief Set user Ceres options to the solver
    * @param[in,out] solverOptions The solver options structure
@@ -219,7 +316,13 @@ private:
   void addRotationPriorsToProblem(const sfmData::SfMData& sfmData, ERefineOptions refineOptions, ceres::Problem& problem);
 
   /**
-   * @brief Create the Ceres bundle adjustement problem with:
+   * @brief Create a residual block for each parameter prior
+   * @param[out] problem The Ceres bundle adjustement problem
+   */
+  void addParametersPriorsToProblem(ceres::Problem& problem);
+
+  /**
+   * @brief Create (or update, if it already contains the blocks of a previous call) the Ceres bundle adjustement problem with:
    *  - extrincics and intrinsics parameters blocks.
    *  - residuals blocks for each observation.
    * @param[in,out] sfmData The input SfMData contains all the information about the reconstruction
@@ -270,6 +373,9 @@ private:
   /// use or not the local budle adjustment strategy
   std::shared_ptr<const LocalBundleAdjustmentGraph> _localGraph = nullptr;
 
+  /// quadratic priors on the parameters
+  std::shared_ptr<const ParametersPriors> _parametersPriors = nullptr;
+
   /// user Ceres options to use in the solver
   CeresOptions _ceresOptions;
 
@@ -296,6 +402,27 @@ private:
   /// block: ceres angleAxis(3) + translation(3)
   HashMap<IndexT, HashMap<IndexT, std::array<double,6>>> _rigBlocks;
 
+  /// observation residual block of a persistent problem
+  struct ObservationResidual
+  {
+    ceres::ResidualBlockId residualBlockId;
+    sfmData::Observation observation;
+    const double* intrinsicBlockPtr;
+    const double* poseBlockPtr;
+    const double* rigBlockPtr;
+  };
+
+  /// Ceres problem, kept between the calls to adjust if persistentProblem
+  std::unique_ptr<ceres::Problem> _problem;
+  /// observations residual blocks per landmark and view
+  HashMap<IndexT, HashMap<IndexT, ObservationResidual>> _observationsResiduals;
+  /// 2D constraints, rotation priors and parameters priors residual blocks
+  std::vector<ceres::ResidualBlockId> _otherResiduals;
+  /// constant parameters of the parameter blocks with a subset parameterization
+  HashMap<const double*, std::vector<int>> _subsetParameterizations;
+  /// parameter blocks removed from the problem since the last update of the residuals
+  std::set<const double*> _removedParametersBlocks;
+
   /// hinted order for ceres to eliminate blocks when solving.
   /// note: this ceres parameter is built internally and must be reset on each call to the solver.
   ceres::ParameterBlockOrdering _linearSolverOrdering;
@@ -0,0 +1,1116 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "BundleAdjustmentPartitioned.hpp"
+#include <aliceVision/sfm/utils/statistics.hpp>
+#include <aliceVision/sfmData/SfMData.hpp>
+#include <aliceVision/sfmDataIO/sfmDataIO.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <ceres/rotation.h>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <random>
+#include <set>
+#include <thread>
+
+namespace fs = boost::filesystem;
+
+namespace aliceVision {
+namespace sfm {
+
+using ParametersBlocks = BundleAdjustmentCeres::ParametersBlocks;
+using ParametersPriors = BundleAdjustmentCeres::ParametersPriors;
+
+namespace {
+
+/**
+ * @brief Co-visibility graph of the reconstructed views
+ */
+struct CovisibilityGraph
+{
+  /// view id of each node
+  std::vector<IndexT> viewIds;
+  /// neighbours of each node with the number of shared landmarks
+  std::vector<std::vector<std::pair<std::size_t, double>>> adjacency;
+};
+
+CovisibilityGraph buildCovisibilityGraph(const sfmData::SfMData& sfmData)
+{
+  CovisibilityGraph graph;
+
+  for(const auto& viewPair : sfmData.getViews())
+  {
+    if(sfmData.isPoseAndIntrinsicDefined(viewPair.second.get()))
+      graph.viewIds.push_back(viewPair.first);
+  }
+  std::sort(graph.viewIds.begin(), graph.viewIds.end());
+
+  HashMap<IndexT, std::size_t> nodePerView;
+  for(std::size_t i = 0; i < graph.viewIds.size(); ++i)
+    nodePerView[graph.viewIds.at(i)] = i;
+
+  // count the landmarks shared by each pair of views (i < j)
+  std::vector<HashMap<std::size_t, double>> weights(graph.viewIds.size());
+  std::vector<std::size_t> nodes;
+
+  for(const auto& landmarkPair : sfmData.getLandmarks())
+  {
+    nodes.clear();
+    for(const auto& observationPair : landmarkPair.second.observations)
+    {
+      const auto nodeIt = nodePerView.find(observationPair.first);
+      if(nodeIt != nodePerView.end())
+        nodes.push_back(nodeIt->second);
+    }
+    std::sort(nodes.begin(), nodes.end());
+
+    for(std::size_t i = 0; i < nodes.size(); ++i)
+      for(std::size_t j = i + 1; j < nodes.size(); ++j)
+        weights.at(nodes.at(i))[nodes.at(j)] += 1.0;
+  }
+
+  graph.adjacency.resize(graph.viewIds.size());
+  for(std::size_t i = 0; i < weights.size(); ++i)
+  {
+    for(const auto& weightPair : weights.at(i))
+    {
+      graph.adjacency.at(i).emplace_back(weightPair.first, weightPair.second);
+      graph.adjacency.at(weightPair.first).emplace_back(i, weightPair.second);
+    }
+  }
+
+  for(auto& neighbours : graph.adjacency)
+    std::sort(neighbours.begin(), neighbours.end());
+
+  return graph;
+}
+
+/**
+ * @brief Split the given nodes in two parts with the spectral relaxation of the normalized cut:
+ *        the nodes are sorted along the generalized Fiedler vector of the sub-graph (D - W) y = l D y
+ *        and split at the position minimizing the normalized cut, keeping at least a quarter of the nodes in each part.
+ */
+void bisectByNormalizedCut(const CovisibilityGraph& graph,
+                           const std::vector<std::size_t>& nodes,
+                           std::vector<std::size_t>& partA,
+                           std::vector<std::size_t>& partB)
+{
+  const std::size_t nbNodes = nodes.size();
+
+  HashMap<std::size_t, std::size_t> localIndex;
+  for(std::size_t i = 0; i < nbNodes; ++i)
+    localIndex[nodes.at(i)] = i;
+
+  // local sub-graph
+  std::vector<std::vector<std::pair<std::size_t, double>>> adjacency(nbNodes);
+  Vec degrees = Vec::Zero(nbNodes);
+
+  for(std::size_t i = 0; i < nbNodes; ++i)
+  {
+    for(const auto& neighbour : graph.adjacency.at(nodes.at(i)))
+    {
+      const auto localIt = localIndex.find(neighbour.first);
+      if(localIt == localIndex.end())
+        continue;
+      adjacency.at(i).emplace_back(localIt->second, neighbour.second);
+      degrees(i) += neighbour.second;
+    }
+  }
+
+  // isolated views get a unit virtual degree
+  for(std::size_t i = 0; i < nbNodes; ++i)
+    if(degrees(i) <= 0.0)
+      degrees(i) = 1.0;
+
+  const Vec invSqrtDegrees = degrees.cwiseSqrt().cwiseInverse();
+
+  // the largest eigenvector of M = (I + D^-1/2 W D^-1/2) / 2 is sqrt(D) (eigenvalue 1),
+  // the second one gives the Fiedler vector of the normalized laplacian
+  const Vec trivial = degrees.cwiseSqrt().normalized();
+
+  std::mt19937 generator(nbNodes);
+  std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+
+  Vec v(nbNodes);
+  for(std::size_t i = 0; i < nbNodes; ++i)
+    v(i) = distribution(generator);
+
+  v -= v.dot(trivial) * trivial;
+  v.normalize();
+
+  Vec Mv(nbNodes);
+  for(int iteration = 0; iteration < 1000; ++iteration)
+  {
+    for(std::size_t i = 0; i < nbNodes; ++i)
+    {
+      double sum = 0.0;
+      for(const auto& neighbour : adjacency.at(i))
+        sum += neighbour.second * invSqrtDegrees(neighbour.first) * v(neighbour.first);
+      Mv(i) = 0.5 * (v(i) + invSqrtDegrees(i) * sum);
+    }
+
+    Mv -= Mv.dot(trivial) * trivial;
+    const double norm = Mv.norm();
+    if(norm <= 0.0)
+      break;
+    Mv /= norm;
+
+    const double change = (Mv - v).norm();
+    v.swap(Mv);
+
+    if(change < 1e-9)
+      break;
+  }
+
+  // sort the nodes along the generalized eigenvector y = D^-1/2 v
+  const Vec y = invSqrtDegrees.cwiseProduct(v);
+
+  std::vector<std::size_t> order(nbNodes);
+  for(std::size_t i = 0; i < nbNodes; ++i)
+    order.at(i) = i;
+  std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return y(a) < y(b); });
+
+  // sweep the split positions: ncut(A, B) = cut(A, B) / assoc(A, V) + cut(A, B) / assoc(B, V)
+  const double totalAssociation = degrees.sum();
+  const std::size_t minSplit = std::max<std::size_t>(1, nbNodes / 4);
+  const std::size_t maxSplit = std::min<std::size_t>(nbNodes - 1, nbNodes - nbNodes / 4);
+
+  std::vector<bool> inA(nbNodes, false);
+  double cut = 0.0;
+  double associationA = 0.0;
+  double bestNormalizedCut = std::numeric_limits<double>::max();
+  std::size_t bestSplit = nbNodes / 2;
+
+  for(std::size_t k = 0; k < maxSplit; ++k)
+  {
+    const std::size_t i = order.at(k);
+    for(const auto& neighbour : adjacency.at(i))
+      cut += (inA.at(neighbour.first) ? -neighbour.second : neighbour.second);
+    inA.at(i) = true;
+    associationA += degrees(i);
+
+    const std::size_t split = k + 1;
+    if(split < minSplit)
+      continue;
+
+    const double normalizedCut = cut / associationA + cut / (totalAssociation - associationA);
+    if(normalizedCut < bestNormalizedCut)
+    {
+      bestNormalizedCut = normalizedCut;
+      bestSplit = split;
+    }
+  }
+
+  partA.clear();
+  partB.clear();
+  for(std::size_t k = 0; k < nbNodes; ++k)
+    (k < bestSplit ? partA : partB).push_back(nodes.at(order.at(k)));
+
+  std::sort(partA.begin(), partA.end());
+  std::sort(partB.begin(), partB.end());
+}
+
+std::vector<std::vector<std::size_t>> clusterByNormalizedCut(const CovisibilityGraph& graph, std::size_t maxNodesPerCluster)
+{
+  std::vector<std::vector<std::size_t>> clusters;
+
+  if(graph.viewIds.empty())
+    return clusters;
+
+  std::vector<std::vector<std::size_t>> toSplit(1);
+  for(std::size_t i = 0; i < graph.viewIds.size(); ++i)
+    toSplit.front().push_back(i);
+
+  while(!toSplit.empty())
+  {
+    std::vector<std::size_t> nodes;
+    nodes.swap(toSplit.back());
+    toSplit.pop_back();
+
+    if(nodes.size() <= std::max<std::size_t>(1, maxNodesPerCluster))
+    {
+      clusters.push_back(std::move(nodes));
+      continue;
+    }
+
+    std::vector<std::size_t> partA, partB;
+    bisectByNormalizedCut(graph, nodes, partA, partB);
+    toSplit.push_back(std::move(partB));
+    toSplit.push_back(std::move(partA));
+  }
+
+  return clusters;
+}
+
+/**
+ * @brief Add to each cluster its most connected views of the other clusters
+ */
+std::vector<std::vector<IndexT>> getOverlappingPartitions(const CovisibilityGraph& graph,
+                                                          const std::vector<std::vector<std::size_t>>& clusters,
+                                                          double overlapRatio)
+{
+  std::vector<std::vector<IndexT>> partitions;
+
+  for(const auto& cluster : clusters)
+  {
+    std::vector<std::size_t> nodes = cluster;
+    const std::size_t nbOverlap = static_cast<std::size_t>(std::ceil(std::max(0.0, overlapRatio) * cluster.size()));
+
+    if(nbOverlap > 0 && clusters.size() > 1)
+    {
+      const std::set<std::size_t> inCluster(cluster.begin(), cluster.end());
+      std::map<std::size_t, double> connections;
+
+      for(const std::size_t node : cluster)
+        for(const auto& neighbour : graph.adjacency.at(node))
+          if(inCluster.count(neighbour.first) == 0)
+            connections[neighbour.first] += neighbour.second;
+
+      std::vector<std::pair<std::size_t, double>> candidates(connections.begin(), connections.end());
+      std::stable_sort(candidates.begin(), candidates.end(), [](const std::pair<std::size_t, double>& a, const std::pair<std::size_t, double>& b) {
+        return a.second > b.second;
+      });
+
+      for(std::size_t i = 0; i < std::min(nbOverlap, candidates.size()); ++i)
+        nodes.push_back(candidates.at(i).first);
+    }
+
+    std::vector<IndexT> viewIds;
+    for(const std::size_t node : nodes)
+      viewIds.push_back(graph.viewIds.at(node));
+    std::sort(viewIds.begin(), viewIds.end());
+    partitions.push_back(std::move(viewIds));
+  }
+
+  return partitions;
+}
+
+/**
+ * @brief Create the SfMData of each partition: the views, poses, rigs and cloned intrinsics of the partition views,
+ *        and the landmarks observed by these views with their partition observations.
+ */
+void createPartitionsSfMData(const sfmData::SfMData& sfmData,
+                             const std::vector<std::vector<IndexT>>& partitionsViews,
+                             std::vector<sfmData::SfMData>& partitionsSfMData)
+{
+  partitionsSfMData.clear();
+  partitionsSfMData.resize(partitionsViews.size());
+
+  HashMap<IndexT, std::vector<std::size_t>> partitionsPerView;
+
+  for(std::size_t k = 0; k < partitionsViews.size(); ++k)
+  {
+    sfmData::SfMData& partition = partitionsSfMData.at(k);
+
+    for(const IndexT viewId : partitionsViews.at(k))
+    {
+      partitionsPerView[viewId].push_back(k);
+
+      const std::shared_ptr<sfmData::View>& view = sfmData.getViews().at(viewId);
+      partition.getViews().emplace(viewId, view);
+
+      if(partition.getPoses().count(view->getPoseId()) == 0)
+        partition.getPoses().emplace(view->getPoseId(), sfmData.getPoses().at(view->getPoseId()));
+
+      if(partition.getIntrinsics().count(view->getIntrinsicId()) == 0)
+        partition.getIntrinsics().emplace(view->getIntrinsicId(), std::shared_ptr<camera::IntrinsicBase>(sfmData.getIntrinsics().at(view->getIntrinsicId())->clone()));
+
+      if(view->isPartOfRig() && partition.getRigs().count(view->getRigId()) == 0)
+      {
+        sfmData::Rig rig = sfmData.getRigs().at(view->getRigId());
+
+        // the rig sub-poses are shared by all the partitions
+        for(std::size_t subPoseId = 0; subPoseId < rig.getNbSubPoses(); ++subPoseId)
+        {
+          sfmData::RigSubPose& subPose = rig.getSubPose(subPoseId);
+          if(subPose.status == sfmData::ERigSubPoseStatus::ESTIMATED)
+            subPose.status = sfmData::ERigSubPoseStatus::CONSTANT;
+        }
+        partition.getRigs().emplace(view->getRigId(), rig);
+      }
+    }
+  }
+
+  std::map<std::size_t, sfmData::Observations> observationsPerPartition;
+
+  for(const auto& landmarkPair : sfmData.getLandmarks())
+  {
+    observationsPerPartition.clear();
+
+    for(const auto& observationPair : landmarkPair.second.observations)
+    {
+      const auto partitionsIt = partitionsPerView.find(observationPair.first);
+      if(partitionsIt == partitionsPerView.end())
+        continue;
+
+      for(const std::size_t k : partitionsIt->second)
+        observationsPerPartition[k].emplace(observationPair.first, observationPair.second);
+    }
+
+    for(auto& observationsPair : observationsPerPartition)
+    {
+      sfmData::Landmark landmark(landmarkPair.second.X, landmarkPair.second.descType, sfmData::Observations(), landmarkPair.second.rgb);
+      landmark.observations.swap(observationsPair.second);
+      partitionsSfMData.at(observationsPair.first).getLandmarks().emplace(landmarkPair.first, std::move(landmark));
+    }
+  }
+}
+
+/**
+ * @brief Get the parameters of a SfMData in the format of the Ceres blocks
+ */
+ParametersBlocks getParametersBlocks(const sfmData::SfMData& sfmData)
+{
+  ParametersBlocks blocks;
+
+  for(const auto& posePair : sfmData.getPoses())
+  {
+    const Mat3& R = posePair.second.getTransform().rotation();
+    const Vec3& t = posePair.second.getTransform().translation();
+
+    std::array<double,6>& poseBlock = blocks.poses[posePair.first];
+    ceres::RotationMatrixToAngleAxis(static_cast<const double *>(R.data()), poseBlock.data());
+    poseBlock.at(3) = t(0);
+    poseBlock.at(4) = t(1);
+    poseBlock.at(5) = t(2);
+  }
+
+  for(const auto& intrinsicPair : sfmData.getIntrinsics())
+    blocks.intrinsics[intrinsicPair.first] = intrinsicPair.second->getParams();
+
+  for(const auto& landmarkPair : sfmData.getLandmarks())
+  {
+    const Vec3& X = landmarkPair.second.X;
+    blocks.landmarks[landmarkPair.first] = {X(0), X(1), X(2)};
+  }
+
+  return blocks;
+}
+
+/**
+ * @brief Replace an angle-axis by the equivalent rotation vector the nearest from the reference
+ *        (the rotation vectors of angle a and a - 2pi along the same axis are equivalent)
+ */
+void alignAngleAxis(double* angleAxis, const double* reference)
+{
+  Eigen::Map<Vec3> w(angleAxis);
+  const Eigen::Map<const Vec3> r(reference);
+  const double angle = w.norm();
+
+  if(angle < 1e-12)
+    return;
+
+  const Vec3 equivalent = w * (1.0 - 2.0 * M_PI / angle);
+  if((equivalent - r).squaredNorm() < (w - r).squaredNorm())
+    w = equivalent;
+}
+
+/**
+ * @brief Value shared by several partitions, stored in the flat consensus vector
+ */
+struct SharedValue
+{
+  BundleAdjustment::EParameter parameter;
+  IndexT id;
+  /// position in the consensus vector
+  std::size_t offset;
+  std::size_t size;
+};
+
+/**
+ * @brief Get the block of a shared value, created if needed
+ */
+double* getBlock(ParametersBlocks& blocks, const SharedValue& value)
+{
+  switch(value.parameter)
+  {
+    case BundleAdjustment::EParameter::POSE:      return blocks.poses[value.id].data();
+    case BundleAdjustment::EParameter::INTRINSIC: blocks.intrinsics[value.id].resize(value.size);
+                                                  return blocks.intrinsics[value.id].data();
+    case BundleAdjustment::EParameter::LANDMARK:  return blocks.landmarks[value.id].data();
+  }
+  throw std::out_of_range("Invalid parameter type: " + std::to_string(int(value.parameter)));
+}
+
+const double* getBlock(const ParametersBlocks& blocks, const SharedValue& value)
+{
+  switch(value.parameter)
+  {
+    case BundleAdjustment::EParameter::POSE:      return blocks.poses.at(value.id).data();
+    case BundleAdjustment::EParameter::INTRINSIC: return blocks.intrinsics.at(value.id).data();
+    case BundleAdjustment::EParameter::LANDMARK:  return blocks.landmarks.at(value.id).data();
+  }
+  throw std::out_of_range("Invalid parameter type: " + std::to_string(int(value.parameter)));
+}
+
+/**
+ * @brief Copy all the blocks of the source in the destination
+ */
+void copyBlocks(const ParametersBlocks& source, ParametersBlocks& destination)
+{
+  for(const auto& posePair : source.poses)
+    destination.poses[posePair.first] = posePair.second;
+  for(const auto& intrinsicPair : source.intrinsics)
+    destination.intrinsics[intrinsicPair.first] = intrinsicPair.second;
+  for(const auto& landmarkPair : source.landmarks)
+    destination.landmarks[landmarkPair.first] = landmarkPair.second;
+}
+
+// binary exchange of the partitions values with the worker processes
+
+template <typename T>
+void writeValue(std::ostream& stream, const T& value)
+{
+  stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+void readValue(std::istream& stream, T& value)
+{
+  stream.read(reinterpret_cast<char*>(&value), sizeof(T));
+}
+
+template <typename Blocks>
+void writeBlocks(std::ostream& stream, const Blocks& blocks)
+{
+  writeValue(stream, static_cast<std::uint64_t>(blocks.size()));
+  for(const auto& blockPair : blocks)
+  {
+    writeValue(stream, blockPair.first);
+    writeValue(stream, static_cast<std::uint64_t>(blockPair.second.size()));
+    stream.write(reinterpret_cast<const char*>(blockPair.second.data()), blockPair.second.size() * sizeof(double));
+  }
+}
+
+template <std::size_t N>
+bool readBlocks(std::istream& stream, HashMap<IndexT, std::array<double,N>>& blocks)
+{
+  std::uint64_t nbBlocks = 0;
+  readValue(stream, nbBlocks);
+
+  for(std::uint64_t i = 0; i < nbBlocks && stream; ++i)
+  {
+    IndexT id;
+    std::uint64_t blockSize = 0;
+    readValue(stream, id);
+    readValue(stream, blockSize);
+
+    if(blockSize != N)
+      return false;
+    stream.read(reinterpret_cast<char*>(blocks[id].data()), N * sizeof(double));
+  }
+  return static_cast<bool>(stream);
+}
+
+bool readBlocks(std::istream& stream, HashMap<IndexT, std::vector<double>>& blocks)
+{
+  std::uint64_t nbBlocks = 0;
+  readValue(stream, nbBlocks);
+
+  for(std::uint64_t i = 0; i < nbBlocks && stream; ++i)
+  {
+    IndexT id;
+    std::uint64_t blockSize = 0;
+    readValue(stream, id);
+    readValue(stream, blockSize);
+
+    std::vector<double>& block = blocks[id];
+    block.resize(blockSize);
+    stream.read(reinterpret_cast<char*>(block.data()), blockSize * sizeof(double));
+  }
+  return static_cast<bool>(stream);
+}
+
+void writeParametersBlocks(std::ostream& stream, const ParametersBlocks& blocks)
+{
+  writeBlocks(stream, blocks.poses);
+  writeBlocks(stream, blocks.intrinsics);
+  writeBlocks(stream, blocks.landmarks);
+}
+
+bool readParametersBlocks(std::istream& stream, ParametersBlocks& blocks)
+{
+  return readBlocks(stream, blocks.poses) &&
+         readBlocks(stream, blocks.intrinsics) &&
+         readBlocks(stream, blocks.landmarks);
+}
+
+/*
+ * Files of the working folder. Each run of the coordinator has its own id, written in the run file
+ * once the partitions are written, and all the other files are named after it.
+ * So the workers never read the files left by an earlier run.
+ */
+
+std::string getRunPath(const std::string& workingFolder)
+{
+  return (fs::path(workingFolder) / "run").string();
+}
+
+std::string getPartitionPath(const std::string& workingFolder, const std::string& runId, std::size_t partitionId)
+{
+  return (fs::path(workingFolder) / ("partition_" + runId + "_" + std::to_string(partitionId) + ".sfm")).string();
+}
+
+std::string getPriorsPath(const std::string& workingFolder, const std::string& runId, std::size_t partitionId, std::size_t iteration)
+{
+  return (fs::path(workingFolder) / ("partition_" + runId + "_" + std::to_string(partitionId) + "_iteration_" + std::to_string(iteration) + ".priors")).string();
+}
+
+std::string getResultPath(const std::string& workingFolder, const std::string& runId, std::size_t partitionId, std::size_t iteration)
+{
+  return (fs::path(workingFolder) / ("partition_" + runId + "_" + std::to_string(partitionId) + "_iteration_" + std::to_string(iteration) + ".result")).string();
+}
+
+std::string getDonePath(const std::string& workingFolder, const std::string& runId)
+{
+  return (fs::path(workingFolder) / ("done_" + runId)).string();
+}
+
+/**
+ * @brief Read the id of the current run of the coordinator
+ * @return the run id, or an empty string if there is no run in progress
+ */
+std::string readRunId(const std::string& workingFolder)
+{
+  std::ifstream stream(getRunPath(workingFolder));
+  std::string runId;
+  stream >> runId;
+  return runId;
+}
+
+/**
+ * @brief Remove the files of the working folder written by the runs matching a prefix
+ * @param[in] workingFolder The working folder
+ * @param[in] prefix The prefix of the removed files
+ */
+void removeRunFiles(const std::string& workingFolder, const std::string& prefix)
+{
+  boost::system::error_code ec;
+  std::vector<fs::path> paths;
+  for(fs::directory_iterator it(workingFolder, ec), end; !ec && it != end; it.increment(ec))
+  {
+    const std::string filename = it->path().filename().string();
+    if(filename.compare(0, prefix.size(), prefix) == 0)
+      paths.push_back(it->path());
+  }
+  for(const fs::path& path : paths)
+    fs::remove(path, ec);
+}
+
+/**
+ * @brief Write a file through a temporary file, so that the other processes never read a partial file
+ */
+template <typename Writer>
+void writeFileAtomically(const std::string& path, Writer writer)
+{
+  const fs::path bPath = fs::path(path);
+  const std::string tmpPath = (bPath.parent_path() / bPath.stem()).string() + "." + fs::unique_path().string() + ".tmp";
+
+  {
+    std::ofstream stream(tmpPath, std::ios::out | std::ios::binary);
+    if(!stream)
+      throw std::runtime_error("Cannot write file: " + tmpPath);
+    writer(stream);
+  }
+
+  fs::rename(tmpPath, path);
+}
+
+/**
+ * @brief Wait for one of the given files
+ * @param[in] paths The files
+ * @param[in] timeout Time to wait (s)
+ * @param[in] abort Optional condition to stop waiting, checked after the files
+ * @return the index of the first existing file, -1 after the timeout or -2 if aborted
+ */
+int waitForFiles(const std::vector<std::string>& paths, double timeout, const std::function<bool()>& abort = nullptr)
+{
+  const auto start = std::chrono::steady_clock::now();
+
+  for(;;)
+  {
+    for(std::size_t i = 0; i < paths.size(); ++i)
+      if(fs::exists(paths.at(i)))
+        return static_cast<int>(i);
+
+    if(abort && abort())
+      return -2;
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if(elapsed.count() > timeout)
+      return -1;
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+}
+
+} // namespace
+
+std::vector<std::vector<IndexT>> clusterViewsByNormalizedCut(const sfmData::SfMData& sfmData, std::size_t maxViewsPerCluster)
+{
+  const CovisibilityGraph graph = buildCovisibilityGraph(sfmData);
+  return getOverlappingPartitions(graph, clusterByNormalizedCut(graph, maxViewsPerCluster), 0.0);
+}
+
+void BundleAdjustmentPartitioned::Statistics::show() const
+{
+  ALICEVISION_LOG_INFO("Partitioned Bundle Adjustment Statistics:\n"
+                        << "\t- adjustment duration: " << time << " s\n"
+                        << "\t- # partitions: " << nbPartitions << "\n"
+                        << "\t- # consensus iterations: " << nbIterations << "\n"
+                        << "\t- consensus residual: " << consensusResidual << "\n"
+                        << "\t- RMSE initial: " << RMSEinitial << "\n"
+                        << "\t- RMSE final: " << RMSEfinal);
+}
+
+bool BundleAdjustmentPartitioned::adjust(sfmData::SfMData& sfmData, ERefineOptions refineOptions)
+{
+  system::Timer timer;
+  _statistics = Statistics();
+  _statistics.RMSEinitial = RMSE(sfmData);
+
+  // split the scene in overlapping partitions
+  const CovisibilityGraph graph = buildCovisibilityGraph(sfmData);
+  const std::vector<std::vector<IndexT>> partitionsViews = getOverlappingPartitions(graph, clusterByNormalizedCut(graph, _options.maxViewsPerPartition), _options.overlapRatio);
+  const std::size_t nbPartitions = partitionsViews.size();
+
+  if(nbPartitions == 0)
+  {
+    ALICEVISION_LOG_WARNING("Partitioned Bundle Adjustment: no reconstructed view.");
+    return false;
+  }
+
+  std::vector<sfmData::SfMData> partitionsSfMData;
+  createPartitionsSfMData(sfmData, partitionsViews, partitionsSfMData);
+
+  // last values of each partition (x_k)
+  std::vector<ParametersBlocks> partitionsValues(nbPartitions);
+  for(std::size_t k = 0; k < nbPartitions; ++k)
+    partitionsValues.at(k) = getParametersBlocks(partitionsSfMData.at(k));
+
+  // values shared by several partitions, constrained by the consensus
+  std::vector<SharedValue> sharedValues;
+  std::vector<std::vector<std::size_t>> partitionsSharedValues(nbPartitions);
+  std::size_t consensusSize = 0;
+  {
+    std::map<std::pair<EParameter, IndexT>, std::vector<std::size_t>> partitionsPerValue;
+    std::map<std::pair<EParameter, IndexT>, std::size_t> sizePerValue;
+
+    for(std::size_t k = 0; k < nbPartitions; ++k)
+    {
+      for(const auto& posePair : partitionsValues.at(k).poses)
+        partitionsPerValue[{EParameter::POSE, posePair.first}].push_back(k);
+      for(const auto& intrinsicPair : partitionsValues.at(k).intrinsics)
+      {
+        partitionsPerValue[{EParameter::INTRINSIC, intrinsicPair.first}].push_back(k);
+        sizePerValue[{EParameter::INTRINSIC, intrinsicPair.first}] = intrinsicPair.second.size();
+      }
+      for(const auto& landmarkPair : partitionsValues.at(k).landmarks)
+        partitionsPerValue[{EParameter::LANDMARK, landmarkPair.first}].push_back(k);
+    }
+
+    for(const auto& valuePair : partitionsPerValue)
+    {
+      if(valuePair.second.size() < 2)
+        continue;
+
+      const EParameter parameter = valuePair.first.first;
+      const std::size_t size = (parameter == EParameter::POSE) ? 6 : (parameter == EParameter::LANDMARK) ? 3 : sizePerValue.at(valuePair.first);
+
+      for(const std::size_t k : valuePair.second)
+        partitionsSharedValues.at(k).push_back(sharedValues.size());
+
+      sharedValues.push_back({parameter, valuePair.first.second, consensusSize, size});
+      consensusSize += size;
+    }
+  }
+
+  ALICEVISION_LOG_INFO("Partitioned Bundle Adjustment: " << nbPartitions << " partitions of " << graph.viewIds.size() << " views, " << sharedValues.size() << " shared parameters blocks.");
+
+  // consensus values (z), number of partitions of each value, partitions values (x_k) and scaled dual variables (u_k)
+  Vec z(consensusSize);
+  Vec nbPartitionsPerValue = Vec::Zero(consensusSize);
+  std::vector<Vec> x(nbPartitions);
+  std::vector<Vec> u(nbPartitions);
+
+  {
+    const ParametersBlocks initialValues = getParametersBlocks(sfmData);
+    for(const SharedValue& value : sharedValues)
+      z.segment(value.offset, value.size) = Eigen::Map<const Vec>(getBlock(initialValues, value), value.size);
+  }
+
+  for(std::size_t k = 0; k < nbPartitions; ++k)
+  {
+    std::size_t size = 0;
+    for(const std::size_t i : partitionsSharedValues.at(k))
+    {
+      nbPartitionsPerValue.segment(sharedValues.at(i).offset, sharedValues.at(i).size).array() += 1.0;
+      size += sharedValues.at(i).size;
+    }
+    x.at(k) = Vec::Zero(size);
+    u.at(k) = Vec::Zero(size);
+  }
+
+  // apply a function to the shared values of a partition: function(value, position in the partition vectors)
+  const auto forEachSharedValue = [&](std::size_t k, const std::function<void(const SharedValue&, std::size_t)>& function)
+  {
+    std::size_t localOffset = 0;
+    for(const std::size_t i : partitionsSharedValues.at(k))
+    {
+      function(sharedValues.at(i), localOffset);
+      localOffset += sharedValues.at(i).size;
+    }
+  };
+
+  // in-process solvers, or working folder shared with the worker processes
+  const bool useWorkers = !_options.workingFolder.empty();
+  std::vector<std::unique_ptr<BundleAdjustmentCeres>> solvers;
+
+  // id of this run in the names of the working folder files
+  const std::string runId = useWorkers ? fs::unique_path("%%%%%%%%%%%%%%%%").string() : std::string();
+
+  if(useWorkers)
+  {
+    fs::create_directories(_options.workingFolder);
+
+    // files left by the earlier runs
+    fs::remove(getRunPath(_options.workingFolder));
+    removeRunFiles(_options.workingFolder, "run.");
+    removeRunFiles(_options.workingFolder, "done_");
+    removeRunFiles(_options.workingFolder, "partition_");
+
+    for(std::size_t k = 0; k < nbPartitions; ++k)
+    {
+      const std::string partitionPath = getPartitionPath(_options.workingFolder, runId, k);
+      if(!sfmDataIO::Save(partitionsSfMData.at(k), partitionPath, sfmDataIO::ESfMData::ALL))
+      {
+        ALICEVISION_LOG_ERROR("Partitioned Bundle Adjustment: cannot save the partition file: " << partitionPath);
+        removeRunFiles(_options.workingFolder, "partition_" + runId);
+        return false;
+      }
+    }
+
+    // publish the run to the workers
+    writeFileAtomically(getRunPath(_options.workingFolder), [&](std::ostream& stream) { stream << runId; });
+    ALICEVISION_LOG_INFO("Partitioned Bundle Adjustment: partitions written in: " << _options.workingFolder << " (run " << runId << ")");
+  }
+  else
+  {
+    // share the threads between the partitions solved in parallel
+    BundleAdjustmentCeres::CeresOptions ceresOptions = _options.ceresOptions;
+    ceresOptions.persistentProblem = true;
+    ceresOptions.nbThreads = std::max<unsigned int>(1, ceresOptions.nbThreads / std::min<std::size_t>(nbPartitions, std::max(1, omp_get_max_threads())));
+
+    for(std::size_t k = 0; k < nbPartitions; ++k)
+      solvers.emplace_back(new BundleAdjustmentCeres(ceresOptions));
+  }
+
+  double rho = _options.consensusWeight;
+  std::vector<std::shared_ptr<const ParametersPriors>> priors(nbPartitions);
+  std::vector<char> partitionsOk(nbPartitions, 1);
+  bool success = true;
+
+  for(std::size_t iteration = 0; iteration < _options.maxIterations; ++iteration)
+  {
+    // consensus priors of each partition: z - u_k, in the angle-axis representation of the partition
+    for(std::size_t k = 0; k < nbPartitions; ++k)
+    {
+      auto partitionPriors = std::make_shared<ParametersPriors>();
+      partitionPriors->weight = rho;
+
+      forEachSharedValue(k, [&](const SharedValue& value, std::size_t localOffset) {
+        double* target = getBlock(partitionPriors->targets, value);
+        Eigen::Map<Vec>(target, value.size) = z.segment(value.offset, value.size) - u.at(k).segment(localOffset, value.size);
+        if(value.parameter == EParameter::POSE)
+          alignAngleAxis(target, getBlock(partitionsValues.at(k), value));
+      });
+
+      priors.at(k) = partitionPriors;
+    }
+
+    // solve the partitions: x_k
+    if(useWorkers)
+    {
+      for(std::size_t k = 0; k < nbPartitions; ++k)
+      {
+        writeFileAtomically(getPriorsPath(_options.workingFolder, runId, k, iteration), [&](std::ostream& stream) {
+          writeValue(stream, static_cast<std::int32_t>(refineOptions));
+          writeValue(stream, priors.at(k)->weight);
+          writeParametersBlocks(stream, priors.at(k)->targets);
+        });
+      }
+
+      for(std::size_t k = 0; k < nbPartitions; ++k)
+      {
+        const std::string resultPath = getResultPath(_options.workingFolder, runId, k, iteration);
+        if(waitForFiles({resultPath}, _options.workerTimeout) < 0)
+        {
+          ALICEVISION_LOG_ERROR("Partitioned Bundle Adjustment: no result from the worker of the partition " << k << " (iteration " << iteration << ").");
+          partitionsOk.at(k) = 0;
+          continue;
+        }
+
+        {
+          std::ifstream stream(resultPath, std::ios::in | std::ios::binary);
+          std::uint8_t ok = 0;
+          readValue(stream, ok);
+          partitionsOk.at(k) = ok && readParametersBlocks(stream, partitionsValues.at(k));
+        }
+        fs::remove(resultPath);
+      }
+    }
+    else
+    {
+      const int nbParallelPartitions = static_cast<int>(std::min<std::size_t>(nbPartitions, std::max(1, omp_get_max_threads())));
+
+      #pragma omp parallel for schedule(dynamic) num_threads(nbParallelPartitions)
+      for(int k = 0; k < static_cast<int>(nbPartitions); ++k)
+      {
+        BundleAdjustmentCeres& solver = *solvers.at(k);
+        solver.useParametersPriors(priors.at(k));
+        partitionsOk.at(k) = solver.adjust(partitionsSfMData.at(k), refineOptions);
+        if(partitionsOk.at(k))
+          partitionsValues.at(k) = solver.getParametersBlocks();
+      }
+    }
+
+    if(std::find(partitionsOk.begin(), partitionsOk.end(), 0) != partitionsOk.end())
+    {
+      ALICEVISION_LOG_WARNING("Partitioned Bundle Adjustment failed, the solution of a partition is not usable.");
+      success = false;
+      break;
+    }
+
+    // gather the shared values of the partitions, the rotations in the angle-axis representation of the consensus
+    for(std::size_t k = 0; k < nbPartitions; ++k)
+    {
+      forEachSharedValue(k, [&](const SharedValue& value, std::size_t localOffset) {
+        x.at(k).segment(localOffset, value.size) = Eigen::Map<const Vec>(getBlock(partitionsValues.at(k), value), value.size);
+        if(value.parameter == EParameter::POSE)
+          alignAngleAxis(x.at(k).data() + localOffset, z.data() + value.offset);
+      });
+    }
+
+    // update the consensus: z = mean_k(x_k + u_k)
+    const Vec previousZ = z;
+    z.setZero();
+    for(std::size_t k = 0; k < nbPartitions; ++k)
+    {
+      forEachSharedValue(k, [&](const SharedValue& value, std::size_t localOffset) {
+        z.segment(value.offset, value.size) += x.at(k).segment(localOffset, value.size) + u.at(k).segment(localOffset, value.size);
+      });
+    }
+    z = z.cwiseQuotient(nbPartitionsPerValue);
+
+    // update the scaled dual variables: u_k = u_k + x_k - z
+    double primalResidual2 = 0.0;
+    for(std::size_t k = 0; k < nbPartitions; ++k)
+    {
+      forEachSharedValue(k, [&](const SharedValue& value, std::size_t localOffset) {
+        const Vec difference = x.at(k).segment(localOffset, value.size) - z.segment(value.offset, value.size);
+        u.at(k).segment(localOffset, value.size) += difference;
+        primalResidual2 += difference.squaredNorm();
+      });
+    }
+
+    // relative primal residual (partitions to consensus) and dual residual (consensus change)
+    const double consensusNorm = std::max(std::sqrt(nbPartitionsPerValue.dot(z.cwiseAbs2())), 1e-12);
+    const double primalResidual = std::sqrt(primalResidual2) / consensusNorm;
+    const double dualResidual = std::sqrt(nbPartitionsPerValue.dot((z - previousZ).cwiseAbs2())) / consensusNorm;
+
+    _statistics.nbIterations = iteration + 1;
+    _statistics.consensusResidual = primalResidual;
+
+    ALICEVISION_LOG_INFO("Partitioned Bundle Adjustment: iteration " << iteration << ", consensus residual: " << primalResidual << ", consensus change: " << dualResidual << ", weight: " << rho);
+
+    if(primalResidual < _options.convergenceThreshold && dualResidual < _options.convergenceThreshold)
+      break;
+
+    // balance the primal and dual residuals, the scaled dual variables follow the weight
+    if(primalResidual > 10.0 * dualResidual || dualResidual > 10.0 * primalResidual)
+    {
+      const double factor = (primalResidual > dualResidual) ? 2.0 : 0.5;
+      rho *= factor;
+      for(Vec& dual : u)
+        dual /= factor;
+    }
+  }
+
+  if(useWorkers)
+  {
+    // stop the workers and remove the files of the run, the done file is kept for the workers still waiting
+    writeFileAtomically(getDonePath(_options.workingFolder, runId), [](std::ostream&) {});
+    fs::remove(getRunPath(_options.workingFolder));
+    removeRunFiles(_options.workingFolder, "partition_" + runId);
+  }
+
+  if(!success)
+    return false;
+
+  // final values: values of a single partition and consensus of the shared values
+  ParametersBlocks finalValues = getParametersBlocks(sfmData);
+  for(const ParametersBlocks& values : partitionsValues)
+    copyBlocks(values, finalValues);
+  for(const SharedValue& value : sharedValues)
+    Eigen::Map<Vec>(getBlock(finalValues, value), value.size) = z.segment(value.offset, value.size);
+
+  // update the scene
+  const bool refinePoses = (refineOptions & REFINE_ROTATION) || (refineOptions & REFINE_TRANSLATION);
+  const bool refineIntrinsics = (refineOptions & REFINE_INTRINSICS_FOCAL) ||
+                                (refineOptions & REFINE_INTRINSICS_OPTICALCENTER_ALWAYS) ||
+                                (refineOptions & REFINE_INTRINSICS_OPTICALCENTER_IF_ENOUGH_DATA) ||
+                                (refineOptions & REFINE_INTRINSICS_DISTORTION);
+  const bool refineStructure = (refineOptions & REFINE_STRUCTURE);
+
+  if(refinePoses)
+  {
+    for(auto& posePair : sfmData.getPoses())
+    {
+      if(posePair.second.isLocked())
+        continue;
+
+      const std::array<double,6>& poseBlock = finalValues.poses.at(posePair.first);
+
+      Mat3 R_refined;
+      ceres::AngleAxisToRotationMatrix(poseBlock.data(), R_refined.data());
+      const Vec3 t_refined(poseBlock.at(3), poseBlock.at(4), poseBlock.at(5));
+
+      posePair.second.setTransform(geometry::poseFromRT(R_refined, t_refined));
+    }
+  }
+
+  if(refineIntrinsics)
+  {
+    for(auto& intrinsicPair : sfmData.getIntrinsics())
+    {
+      if(!intrinsicPair.second->isLocked())
+        intrinsicPair.second->updateFromParams(finalValues.intrinsics.at(intrinsicPair.first));
+    }
+  }
+
+  if(refineStructure)
+  {
+    for(auto& landmarkPair : sfmData.getLandmarks())
+    {
+      const std::array<double,3>& landmarkBlock = finalValues.landmarks.at(landmarkPair.first);
+      landmarkPair.second.X = Vec3(landmarkBlock.at(0), landmarkBlock.at(1), landmarkBlock.at(2));
+    }
+  }
+
+  _statistics.nbPartitions = nbPartitions;
+  _statistics.RMSEfinal = RMSE(sfmData);
+  _statistics.time = timer.elapsed();
+
+  return true;
+}
+
+bool runBundleAdjustmentPartitionWorker(const std::string& workingFolder,
+                                        std::size_t partitionId,
+                                        const BundleAdjustmentCeres::CeresOptions& ceresOptions,
+                                        double timeout)
+{
+  // a new run of the coordinator replaces the run in progress (the earlier one did not finish)
+  for(;;)
+  {
+    if(waitForFiles({getRunPath(workingFolder)}, timeout) != 0)
+    {
+      ALICEVISION_LOG_ERROR("Partitioned Bundle Adjustment worker: no run of the coordinator in: " << workingFolder);
+      return false;
+    }
+
+    const std::string runId = readRunId(workingFolder);
+    if(runId.empty())
+      continue;
+
+    const auto runReplaced = [&]() {
+      const std::string currentRunId = readRunId(workingFolder);
+      return !currentRunId.empty() && currentRunId != runId;
+    };
+
+    const std::string partitionPath = getPartitionPath(workingFolder, runId, partitionId);
+    const std::string donePath = getDonePath(workingFolder, runId);
+
+    sfmData::SfMData sfmData;
+    if(!sfmDataIO::Load(sfmData, partitionPath, sfmDataIO::ESfMData::ALL))
+    {
+      // the run may have finished or been replaced meanwhile
+      if(fs::exists(donePath))
+        return true;
+      if(readRunId(workingFolder) != runId)
+        continue;
+      ALICEVISION_LOG_ERROR("Partitioned Bundle Adjustment worker: cannot load the partition file: " << partitionPath);
+      return false;
+    }
+
+    BundleAdjustmentCeres::CeresOptions options = ceresOptions;
+    options.persistentProblem = true;
+    BundleAdjustmentCeres solver(options);
+
+    bool replaced = false;
+    for(std::size_t iteration = 0; !replaced; ++iteration)
+    {
+      const std::string priorsPath = getPriorsPath(workingFolder, runId, partitionId, iteration);
+      const int found = waitForFiles({priorsPath, donePath}, timeout, runReplaced);
+
+      if(found == 1)
+        return true;
+
+      if(found == -2)
+      {
+        ALICEVISION_LOG_WARNING("Partitioned Bundle Adjustment worker: the run " << runId << " has been replaced by a new run of the coordinator.");
+        replaced = true;
+        continue;
+      }
+
+      if(found < 0)
+      {
+        ALICEVISION_LOG_ERROR("Partitioned Bundle Adjustment worker: no consensus priors for the iteration " << iteration << ".");
+        return false;
+      }
+
+      std::int32_t refineOptions = BundleAdjustment::REFINE_NONE;
+      auto priors = std::make_shared<ParametersPriors>();
+      bool ok;
+      {
+        std::ifstream stream(priorsPath, std::ios::in | std::ios::binary);
+        readValue(stream, refineOptions);
+        readValue(stream, priors->weight);
+        ok = readParametersBlocks(stream, priors->targets);
+      }
+
+      if(!ok)
+        ALICEVISION_LOG_ERROR("Partitioned Bundle Adjustment worker: cannot read the consensus priors: " << priorsPath);
+
+      if(ok)
+      {
+        solver.useParametersPriors(priors);
+        ok = solver.adjust(sfmData, static_cast<BundleAdjustment::ERefineOptions>(refineOptions));
+      }
+
+      ALICEVISION_LOG_INFO("Partitioned Bundle Adjustment worker: partition " << partitionId << ", iteration " << iteration << " done.");
+
+      writeFileAtomically(getResultPath(workingFolder, runId, partitionId, iteration), [&](std::ostream& stream) {
+        writeValue(stream, static_cast<std::uint8_t>(ok));
+        writeParametersBlocks(stream, ok ? solver.getParametersBlocks() : ParametersBlocks());
+      });
+
+      fs::remove(priorsPath);
+    }
+  }
+}
+
+} // namespace sfm
+} // namespace aliceVision
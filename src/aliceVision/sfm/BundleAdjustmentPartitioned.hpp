@@ -0,0 +1,156 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/sfm/BundleAdjustment.hpp>
+#include <aliceVision/sfm/BundleAdjustmentCeres.hpp>
+
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+
+namespace sfmData {
+class SfMData;
+} // namespace sfmData
+
+namespace sfm {
+
+/**
+ * @brief Split the reconstructed views into clusters of strongly co-visible views.
+ *        The co-visibility graph (weight: number of shared landmarks) is recursively bisected
+ *        with the spectral relaxation of the normalized cut (Shi & Malik).
+ * @param[in] sfmData The input SfMData
+ * @param[in] maxViewsPerCluster The maximum number of views in a cluster
+ * @return the view ids of each cluster
+ */
+std::vector<std::vector<IndexT>> clusterViewsByNormalizedCut(const sfmData::SfMData& sfmData, std::size_t maxViewsPerCluster);
+
+/**
+ * @brief Bundle adjustment of a very large scene split in overlapping partitions.
+ *        Each partition is solved by its own BundleAdjustmentCeres and the partitions
+ *        agree on their shared poses, intrinsics and landmarks with consensus ADMM iterations:
+ *        - x_k = argmin f_k(x) + rho/2 * ||x - z + u_k||^2 (partitions solved independently)
+ *        - z = mean_k(x_k + u_k)
+ *        - u_k = u_k + x_k - z
+ *
+ *        The partitions are solved in parallel in the current process, or by worker processes
+ *        (see runBundleAdjustmentPartitionWorker) exchanging files in a working folder.
+ *
+ * @note 2D constraints and rotation priors are not used, the rig sub-poses are kept constant.
+ */
+class BundleAdjustmentPartitioned : public BundleAdjustment
+{
+public:
+
+  /**
+   * @brief Contains all the partitioned bundle adjustment parameters.
+   */
+  struct Options
+  {
+    Options()
+      : ceresOptions(false, true)
+    {
+      ceresOptions.setSparseBA();
+    }
+
+    /// maximum number of views of a partition (before overlap)
+    std::size_t maxViewsPerPartition = 500;
+    /// number of views added to each partition from its neighbours, relative to the partition size
+    double overlapRatio = 0.1;
+    /// maximum number of consensus iterations
+    std::size_t maxIterations = 20;
+    /// weight (rho) of the consensus priors
+    double consensusWeight = 1000.0;
+    /// stop when the distance between the partitions values and the consensus, relative to the consensus norm, is below
+    double convergenceThreshold = 1e-6;
+    /// Ceres options of the partitions bundle adjustments
+    BundleAdjustmentCeres::CeresOptions ceresOptions;
+    /// folder used to exchange the partitions with worker processes (empty: solve the partitions in the current process)
+    std::string workingFolder;
+    /// time to wait for the worker processes results (s)
+    double workerTimeout = 3600.0;
+  };
+
+  /**
+   * @brief Contains all informations related to the performed bundle adjustment.
+   */
+  struct Statistics
+  {
+    /**
+     * @brief  Display statistics about bundle adjustment in the terminal
+     *  Logger need to accept <info> log level
+     */
+    void show() const;
+
+    /// number of partitions
+    std::size_t nbPartitions = 0;
+    /// number of consensus iterations
+    std::size_t nbIterations = 0;
+    /// last relative distance between the partitions values and the consensus
+    double consensusResidual = 0.0;
+    /// RMSE of the reprojection errors of the whole scene before the adjustment
+    double RMSEinitial = 0.0;
+    /// RMSE of the reprojection errors of the whole scene after the adjustment
+    double RMSEfinal = 0.0;
+    /// time spent in the bundle adjustment (s)
+    double time = 0.0;
+  };
+
+  /**
+   * @brief Bundle adjustment constructor
+   * @param[in] options The user options
+   */
+  explicit BundleAdjustmentPartitioned(const Options& options = Options())
+    : _options(options)
+  {}
+
+  /**
+   * @brief Perform a Bundle Adjustment on the SfM scene with refinement of the requested parameters
+   * @param[in,out] sfmData The input SfMData contains all the information about the reconstruction
+   * @param[in] refineOptions: choose what you want to refine
+   * @return false if the bundle adjustment failed else true
+   */
+  bool adjust(sfmData::SfMData& sfmData, ERefineOptions refineOptions = REFINE_ALL) override;
+
+  /**
+   * @brief Get bundle adjustment statistics structure
+   * @return statistics structure const ref
+   */
+  inline const Statistics& getStatistics() const
+  {
+    return _statistics;
+  }
+
+private:
+
+  /// user options
+  Options _options;
+
+  /// last adjustment statisics
+  Statistics _statistics;
+};
+
+/**
+ * @brief Solve the partition of a partitioned bundle adjustment, in a worker process.
+ *        Wait for a run of the coordinator, then for the consensus priors of each iteration in the working folder
+ *        and write back the partition values, until the coordinator has finished.
+ *        If a new run of the coordinator replaces the run in progress, the worker switches to the new run.
+ * @param[in] workingFolder The working folder of the partitioned bundle adjustment
+ * @param[in] partitionId The partition index
+ * @param[in] ceresOptions The Ceres options of the partition bundle adjustment
+ * @param[in] timeout Time to wait for the coordinator (s)
+ * @return false if the partition cannot be loaded or the coordinator does not answer, else true
+ */
+bool runBundleAdjustmentPartitionWorker(const std::string& workingFolder,
+                                        std::size_t partitionId,
+                                        const BundleAdjustmentCeres::CeresOptions& ceresOptions,
+                                        double timeout = 3600.0);
+
+} // namespace sfm
+} // namespace aliceVision
@@ -0,0 +1,202 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "LandmarksBuffer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace aliceVision {
+namespace sfm {
+
+void LandmarksBuffer::clear()
+{
+  landmarksIds.clear();
+  points.clear();
+  descTypes.clear();
+  colors.clear();
+  isValid.clear();
+  observationsOffsets.assign(1, 0);
+  observationsViewIds.clear();
+  observations.clear();
+}
+
+void LandmarksBuffer::addLandmark(IndexT landmarkId, const Vec3& X, feature::EImageDescriberType descType, const image::RGBColor& color)
+{
+  landmarksIds.push_back(landmarkId);
+  points.push_back(X);
+  descTypes.push_back(descType);
+  colors.push_back(color);
+  isValid.push_back(true);
+  observationsOffsets.push_back(observations.size());
+}
+
+void LandmarksBuffer::addInvalidLandmark(IndexT landmarkId)
+{
+  addLandmark(landmarkId, Vec3::Zero(), feature::EImageDescriberType::UNINITIALIZED);
+  isValid.back() = false;
+}
+
+void LandmarksBuffer::addObservation(IndexT viewId, const sfmData::Observation& observation)
+{
+  assert(!landmarksIds.empty());
+  assert(observations.size() == observationsOffsets[observationsOffsets.size() - 2] || observationsViewIds.back() < viewId);
+
+  observationsViewIds.push_back(viewId);
+  observations.push_back(observation);
+  observationsOffsets.back() = observations.size();
+}
+
+sfmData::Landmark LandmarksBuffer::getLandmark(std::size_t i) const
+{
+  sfmData::Landmark landmark(points[i], descTypes[i], sfmData::Observations(), colors[i]);
+  landmark.observations.reserve(nbObservations(i));
+
+  // view ids are sorted: append at the end of the flat map
+  for(std::size_t o = observationsOffsets[i]; o < observationsOffsets[i + 1]; ++o)
+    landmark.observations.emplace_hint(landmark.observations.end(), observationsViewIds[o], observations[o]);
+
+  return landmark;
+}
+
+ViewsGeometry::ViewsGeometry(const sfmData::SfMData& sfmData)
+{
+  std::vector<const sfmData::View*> views;
+  views.reserve(sfmData.getViews().size());
+
+  for(const auto& viewPair : sfmData.getViews())
+  {
+    if(sfmData.isPoseAndIntrinsicDefined(viewPair.second.get()))
+      views.push_back(viewPair.second.get());
+  }
+
+  centers.resize(3, views.size());
+  opticalAxes.resize(3, views.size());
+
+  for(std::size_t i = 0; i < views.size(); ++i)
+  {
+    const geometry::Pose3 pose = sfmData.getPose(*views[i]).getTransform();
+    indexes[views[i]->getViewId()] = i;
+    centers.col(i) = pose.center();
+    opticalAxes.col(i) = pose.rotation().row(2).transpose();
+  }
+}
+
+/**
+ * @brief Compute the rays from the camera centers to the landmarks for all the observations of the landmarks.
+ * @param[in] buffer The landmarks buffer
+ * @param[in] landmarksIndexes The landmarks (index in the buffer)
+ * @param[in] viewsGeometry The geometry of the views of the landmarks
+ * @param[out] rays The rays, the rays of a landmark are contiguous
+ * @param[out] viewsIndexes The index of the view of each ray
+ * @param[out] raysOffsets The rays of the landmark i are [raysOffsets[i], raysOffsets[i+1])
+ */
+void computeRays(const LandmarksBuffer& buffer,
+                 const std::vector<std::size_t>& landmarksIndexes,
+                 const ViewsGeometry& viewsGeometry,
+                 Mat3X& rays,
+                 std::vector<std::size_t>& viewsIndexes,
+                 std::vector<std::size_t>& raysOffsets)
+{
+  raysOffsets.resize(landmarksIndexes.size() + 1);
+  raysOffsets[0] = 0;
+  for(std::size_t i = 0; i < landmarksIndexes.size(); ++i)
+    raysOffsets[i + 1] = raysOffsets[i] + buffer.nbObservations(landmarksIndexes[i]);
+
+  const std::size_t nbRays = raysOffsets.back();
+  Mat3X points(3, nbRays);
+  Mat3X centers(3, nbRays);
+  viewsIndexes.resize(nbRays);
+
+  // gather the landmarks and the camera centers of all the observations
+  for(std::size_t i = 0; i < landmarksIndexes.size(); ++i)
+  {
+    const std::size_t l = landmarksIndexes[i];
+    const std::size_t firstObservation = buffer.observationsOffsets[l];
+
+    for(std::size_t r = raysOffsets[i]; r < raysOffsets[i + 1]; ++r)
+    {
+      const std::size_t viewIndex = viewsGeometry.indexes.at(buffer.observationsViewIds[firstObservation + r - raysOffsets[i]]);
+      viewsIndexes[r] = viewIndex;
+      points.col(r) = buffer.points[l];
+      centers.col(r) = viewsGeometry.centers.col(viewIndex);
+    }
+  }
+
+  rays = points - centers;
+}
+
+void checkChieralities(LandmarksBuffer& buffer, const std::vector<std::size_t>& landmarksIndexes, const ViewsGeometry& viewsGeometry)
+{
+  Mat3X rays;
+  std::vector<std::size_t> viewsIndexes;
+  std::vector<std::size_t> raysOffsets;
+  computeRays(buffer, landmarksIndexes, viewsGeometry, rays, viewsIndexes, raysOffsets);
+
+  Mat3X axes(3, rays.cols());
+  for(std::size_t r = 0; r < viewsIndexes.size(); ++r)
+    axes.col(r) = viewsGeometry.opticalAxes.col(viewsIndexes[r]);
+
+  // depth of the landmark in the camera of each observation
+  const Vec depths = rays.cwiseProduct(axes).colwise().sum().transpose();
+
+  for(std::size_t i = 0; i < landmarksIndexes.size(); ++i)
+  {
+    const std::size_t nbRays = raysOffsets[i + 1] - raysOffsets[i];
+    // check that the point is in front of all the cameras
+    if(nbRays > 0 && depths.segment(raysOffsets[i], nbRays).minCoeff() < 0.0)
+      buffer.isValid[landmarksIndexes[i]] = false;
+  }
+}
+
+void checkAngles(LandmarksBuffer& buffer, const std::vector<std::size_t>& landmarksIndexes, const ViewsGeometry& viewsGeometry, double minAngle)
+{
+  Mat3X rays;
+  std::vector<std::size_t> viewsIndexes;
+  std::vector<std::size_t> raysOffsets;
+  computeRays(buffer, landmarksIndexes, viewsGeometry, rays, viewsIndexes, raysOffsets);
+
+  rays.colwise().normalize();
+
+  // angle(a, b) >= minAngle <=> dot(a, b) <= cos(minAngle)
+  const double maxCosAngle = std::cos(degreeToRadian(minAngle));
+
+  for(std::size_t i = 0; i < landmarksIndexes.size(); ++i)
+  {
+    const std::size_t nbRays = raysOffsets[i + 1] - raysOffsets[i];
+    bool valid = false;
+
+    if(nbRays >= 2)
+    {
+      const auto landmarkRays = rays.middleCols(raysOffsets[i], nbRays);
+      // cosine of the angle of each pair of views, the diagonal is ignored
+      Mat gram = landmarkRays.transpose() * landmarkRays;
+      gram.diagonal().setConstant(1.0);
+      valid = (std::min(gram.minCoeff(), 1.0) <= maxCosAngle);
+    }
+
+    if(!valid)
+      buffer.isValid[landmarksIndexes[i]] = false;
+  }
+}
+
+void mergeLandmarksBuffers(const std::vector<LandmarksBuffer>& buffers, sfmData::Landmarks& landmarks)
+{
+  for(const LandmarksBuffer& buffer : buffers)
+  {
+    for(std::size_t i = 0; i < buffer.size(); ++i)
+    {
+      if(buffer.isValid[i])
+        landmarks[buffer.landmarksIds[i]] = buffer.getLandmark(i);
+      else
+        landmarks.erase(buffer.landmarksIds[i]);
+    }
+  }
+}
+
+} // namespace sfm
+} // namespace aliceVision
@@ -0,0 +1,134 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/numeric/numeric.hpp>
+#include <aliceVision/sfmData/SfMData.hpp>
+
+#include <vector>
+
+namespace aliceVision {
+namespace sfm {
+
+/**
+ * @brief Landmarks computed by a thread, stored as a structure of arrays.
+ *        The observations of a landmark are a contiguous span of the observations arrays,
+ *        added by increasing view id.
+ *        The buffers of all the threads are merged into the scene landmarks at once (see mergeLandmarksBuffers).
+ */
+struct LandmarksBuffer
+{
+  /// landmarks id
+  std::vector<IndexT> landmarksIds;
+  /// landmarks 3D position
+  std::vector<Vec3> points;
+  /// landmarks describer type
+  std::vector<feature::EImageDescriberType> descTypes;
+  /// landmarks color
+  std::vector<image::RGBColor> colors;
+  /// an invalid landmark is removed from the scene
+  std::vector<char> isValid;
+  /// the observations of the landmark i are [observationsOffsets[i], observationsOffsets[i+1])
+  std::vector<std::size_t> observationsOffsets = {0};
+  /// observations view id
+  std::vector<IndexT> observationsViewIds;
+  /// observations
+  std::vector<sfmData::Observation> observations;
+
+  inline std::size_t size() const
+  {
+    return landmarksIds.size();
+  }
+
+  inline std::size_t nbObservations(std::size_t i) const
+  {
+    return observationsOffsets[i + 1] - observationsOffsets[i];
+  }
+
+  void clear();
+
+  /**
+   * @brief Add a valid landmark, its observations are added after with addObservation
+   * @param[in] landmarkId The landmark id
+   * @param[in] X The landmark 3D position
+   * @param[in] descType The landmark describer type
+   * @param[in] color The landmark color
+   */
+  void addLandmark(IndexT landmarkId, const Vec3& X, feature::EImageDescriberType descType, const image::RGBColor& color = image::WHITE);
+
+  /**
+   * @brief Add a landmark to remove from the scene
+   * @param[in] landmarkId The landmark id
+   */
+  void addInvalidLandmark(IndexT landmarkId);
+
+  /**
+   * @brief Add an observation to the last landmark
+   * @param[in] viewId The observation view id, greater than the view id of the previous observation of the landmark
+   * @param[in] observation The observation
+   */
+  void addObservation(IndexT viewId, const sfmData::Observation& observation);
+
+  /**
+   * @brief Create the landmark i with its observations
+   * @param[in] i The landmark index in the buffer
+   * @return the landmark
+   */
+  sfmData::Landmark getLandmark(std::size_t i) const;
+};
+
+/**
+ * @brief Camera centers and optical axes of the views with a pose, in contiguous arrays,
+ *        used by the batched geometric checks of the landmarks.
+ */
+struct ViewsGeometry
+{
+  /**
+   * @brief Gather the geometry of the views with a valid pose and intrinsic
+   * @param[in] sfmData The scene
+   */
+  explicit ViewsGeometry(const sfmData::SfMData& sfmData);
+
+  /// index of the view in the arrays
+  HashMap<IndexT, std::size_t> indexes;
+  /// camera center of each view
+  Mat3X centers;
+  /// optical axis (third row of the rotation) of each view
+  Mat3X opticalAxes;
+};
+
+/**
+ * @brief Invalidate the landmarks located behind one of their views (negative depth).
+ *        The depths of all the observations of the landmarks are computed at once.
+ * @param[in,out] buffer The landmarks buffer
+ * @param[in] landmarksIndexes The landmarks to check (index in the buffer)
+ * @param[in] viewsGeometry The geometry of the views of the landmarks
+ */
+void checkChieralities(LandmarksBuffer& buffer, const std::vector<std::size_t>& landmarksIndexes, const ViewsGeometry& viewsGeometry);
+
+/**
+ * @brief Invalidate the landmarks for which no pair of views forms an angle above a min. angle.
+ *        The normalized rays of all the observations are computed at once and the angles
+ *        of the views pairs of a landmark are given by the Gram matrix of its rays.
+ * @param[in,out] buffer The landmarks buffer
+ * @param[in] landmarksIndexes The landmarks to check (index in the buffer)
+ * @param[in] viewsGeometry The geometry of the views of the landmarks
+ * @param[in] minAngle The angle limit (degree)
+ */
+void checkAngles(LandmarksBuffer& buffer, const std::vector<std::size_t>& landmarksIndexes, const ViewsGeometry& viewsGeometry, double minAngle);
+
+/**
+ * @brief Merge the buffers into the landmarks, in the buffers order:
+ *        the valid landmarks are added or replace the existing ones, the invalid landmarks are removed.
+ * @param[in] buffers The landmarks buffers
+ * @param[in,out] landmarks The scene landmarks
+ */
+void mergeLandmarksBuffers(const std::vector<LandmarksBuffer>& buffers, sfmData::Landmarks& landmarks);
+
+} // namespace sfm
+} // namespace aliceVision
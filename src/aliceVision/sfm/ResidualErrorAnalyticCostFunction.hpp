@@ -0,0 +1,162 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/camera/camera.hpp>
+#include <aliceVision/sfmData/SfMData.hpp>
+#include <aliceVision/sfm/liealgebra.hpp>
+
+#include <ceres/ceres.h>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace sfm {
+
+/**
+ * @brief Ceres cost function of the reprojection error of a 3D point in a Pinhole camera,
+ *        with analytic jacobians built from the derivatives of the camera model.
+ *        It is a drop-in replacement of the autodiff ResidualErrorFunctor_* functors
+ *        and uses the same parameter blocks:
+ *  - the intrinsic data block [focal, principal point x, principal point y, distortion...],
+ *  - the camera extrinsic data block [rX,rY,rZ,tx,ty,tz] (rotation as angle axis),
+ *  - (rig only) the sub-pose extrinsic data block [rX,rY,rZ,tx,ty,tz],
+ *  - a 3D point data block.
+ */
+class ResidualErrorAnalyticCostFunction : public ceres::CostFunction
+{
+public:
+
+  /**
+   * @param[in] intrinsic The camera intrinsic (only its model is used, the values come from the parameter block)
+   * @param[in] obs The observation of the 3D point
+   * @param[in] withRigSubPose Use the sub-pose parameter block of a camera rig
+   */
+  ResidualErrorAnalyticCostFunction(const camera::IntrinsicBase& intrinsic, const sfmData::Observation& obs, bool withRigSubPose)
+    : _intrinsicType(intrinsic.getType())
+    , _nbIntrinsicParams(intrinsic.getParams().size())
+    , _obs(obs)
+    , _withRigSubPose(withRigSubPose)
+  {
+    if(!camera::isPinhole(_intrinsicType))
+      throw std::logic_error("Cannot create analytic cost function, unsupported intrinsic type in BA.");
+
+    set_num_residuals(2);
+
+    mutable_parameter_block_sizes()->push_back(_nbIntrinsicParams);
+    mutable_parameter_block_sizes()->push_back(6);
+    if(_withRigSubPose)
+      mutable_parameter_block_sizes()->push_back(6);
+    mutable_parameter_block_sizes()->push_back(3);
+  }
+
+  bool Evaluate(double const* const* parameters, double* residuals, double** jacobians) const override
+  {
+    const double* cam_K = parameters[0];
+    const double* cam_Rt = parameters[1];
+    const double* subpose_Rt = _withRigSubPose ? parameters[2] : nullptr;
+    const double* pos_3dpoint = parameters[_withRigSubPose ? 3 : 2];
+
+    // update the camera of the current thread with the intrinsic data block
+    camera::Pinhole& camera = getCamera();
+    camera.setScale(cam_K[0], cam_K[0]);
+    camera.setOffset(cam_K[1], cam_K[2]);
+    if(camera.hasDistortion())
+      std::copy(cam_K + 3, cam_K + _nbIntrinsicParams, camera.getDistortion()->getParameters().begin());
+
+    // apply external parameters (pose and sub-pose)
+    const Eigen::Map<const Vec3> cam_R(cam_Rt);
+    const Eigen::Map<const Vec3> cam_t(cam_Rt + 3);
+    const Eigen::Map<const Vec3> X(pos_3dpoint);
+
+    const Mat3 R = SO3::expm(cam_R);
+    const Vec3 X_pose = R * X + cam_t;
+
+    Mat3 R_subpose = Mat3::Identity();
+    Vec3 X_cam = X_pose;
+
+    if(_withRigSubPose)
+    {
+      R_subpose = SO3::expm(Eigen::Map<const Vec3>(subpose_Rt));
+      X_cam = R_subpose * X_pose + Eigen::Map<const Vec3>(subpose_Rt + 3);
+    }
+
+    // the point is already in the camera frame
+    const geometry::Pose3 identity;
+
+    const double invScale = 1.0 / (_obs.scale > 0.0 ? _obs.scale : 1.0);
+    const Vec2 proj = camera.project(identity, X_cam);
+
+    residuals[0] = (proj(0) - _obs.x(0)) * invScale;
+    residuals[1] = (proj(1) - _obs.x(1)) * invScale;
+
+    if(jacobians == nullptr)
+      return true;
+
+    const Eigen::Matrix<double, 2, 3> d_res_d_Xcam = camera.getDerivativeProjectWrtPoint(identity, X_cam) * invScale;
+    const Eigen::Matrix<double, 2, 3> d_res_d_Xpose = d_res_d_Xcam * R_subpose;
+
+    if(jacobians[0] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, Eigen::Dynamic, Eigen::RowMajor>> J(jacobians[0], 2, _nbIntrinsicParams);
+      J = camera.getDerivativeProjectWrtParams(identity, X_cam) * invScale;
+    }
+
+    if(jacobians[1] != nullptr)
+    {
+      // R(r + dr) = R(r) * expm(Jr(r) * dr) => d(R * X) / dr = -R * [X]x * Jr(r)
+      Eigen::Map<Eigen::Matrix<double, 2, 6, Eigen::RowMajor>> J(jacobians[1]);
+      J.leftCols<3>() = d_res_d_Xpose * (-R * SO3::skew(X) * SO3::rightJacobian(cam_R));
+      J.rightCols<3>() = d_res_d_Xpose;
+    }
+
+    if(_withRigSubPose && jacobians[2] != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 6, Eigen::RowMajor>> J(jacobians[2]);
+      J.leftCols<3>() = d_res_d_Xcam * (-R_subpose * SO3::skew(X_pose) * SO3::rightJacobian(Eigen::Map<const Vec3>(subpose_Rt)));
+      J.rightCols<3>() = d_res_d_Xcam;
+    }
+
+    double* jacobianPoint = jacobians[_withRigSubPose ? 3 : 2];
+    if(jacobianPoint != nullptr)
+    {
+      Eigen::Map<Eigen::Matrix<double, 2, 3, Eigen::RowMajor>> J(jacobianPoint);
+      J = d_res_d_Xpose * R;
+    }
+
+    return true;
+  }
+
+private:
+
+  /**
+   * @brief Get the camera of the current thread for the intrinsic model.
+   *        The cost functions share the camera model of each thread (the Pinhole copies share their distortion object),
+   *        its values are updated from the intrinsic data block at each evaluation.
+   * @return the camera of the intrinsic model
+   */
+  camera::Pinhole& getCamera() const
+  {
+    thread_local std::map<camera::EINTRINSIC, std::shared_ptr<camera::Pinhole>> cameras;
+
+    std::shared_ptr<camera::Pinhole>& camera = cameras[_intrinsicType];
+    if(camera == nullptr)
+      camera = std::dynamic_pointer_cast<camera::Pinhole>(camera::createIntrinsic(_intrinsicType));
+    return *camera;
+  }
+
+  const camera::EINTRINSIC _intrinsicType;
+  const std::size_t _nbIntrinsicParams;
+  const sfmData::Observation _obs;
+  const bool _withRigSubPose;
+};
+
+} // namespace sfm
+} // namespace aliceVision
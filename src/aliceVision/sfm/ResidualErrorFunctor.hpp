@@ -163,7 +163,7 @@ struct ResidualErrorFunctor_Pinhole
     return true;
   }
 
-  const sfmData::Observation& _obs; // The 2D observation
+  const sfmData::Observation _obs; // The 2D observation
 };
 
 /**
@@ -317,7 +317,7 @@ struct ResidualErrorFunctor_PinholeRadialK1
     return true;
   }
 
-  const sfmData::Observation& _obs; // The 2D observation
+  const sfmData::Observation _obs; // The 2D observation
 };
 
 /**
@@ -471,7 +471,7 @@ struct ResidualErrorFunctor_PinholeRadialK3
     return true;
   }
 
-  const sfmData::Observation& _obs; // The 2D observation
+  const sfmData::Observation _obs; // The 2D observation
 };
 
 /**
@@ -637,7 +637,7 @@ struct ResidualErrorFunctor_PinholeBrownT2
     return true;
   }
 
-  const sfmData::Observation& _obs; // The 2D observation
+  const sfmData::Observation _obs; // The 2D observation
 };
 
 
@@ -805,7 +805,7 @@ struct ResidualErrorFunctor_PinholeFisheye
     return true;
   }
 
-  const sfmData::Observation& _obs; // The 2D observation
+  const sfmData::Observation _obs; // The 2D observation
 };
 
 /**
@@ -959,9 +959,193 @@ struct ResidualErrorFunctor_PinholeFisheye1
     return true;
   }
 
-  const sfmData::Observation& _obs; // The 2D observation
+  const sfmData::Observation _obs; // The 2D observation
 };
 
 
+/**
+ * @brief Ceres functor to use an Equidistant (equidistant fisheye camera model) and a 3D point,
+ *        optionally with a radial distortion (EquidistantRadialK3).
+ *
+ *  Data parameter blocks are the following <2,3,6,3> or <2,6,6,3> with the radial distortion
+ *  - 2 => dimension of the residuals,
+ *  - 3 => the intrinsic data block [focal, principal point x, principal point y],
+ *    6 => the intrinsic data block [focal, principal point x, principal point y, K1, K2, K3],
+ *  - 6 => the camera extrinsic data block (camera orientation and position) [R;t],
+ *         - rotation(angle axis), and translation [rX,rY,rZ,tx,ty,tz].
+ *  - 3 => a 3D point data block.
+ *
+ *  The radius of the image circle and the sensor size are not refined, they are given at construction.
+ *
+ * @tparam withRadialK3 Apply the 3 radial distortion coefficients of the intrinsic data block
+ */
+template <bool withRadialK3>
+struct ResidualErrorFunctor_EquidistantBase
+{
+  /**
+   * @param[in] obs The 2D observation
+   * @param[in] focalToRadius The ratio between the camera plane radius of a ray and its angle times the focal length
+   * @param[in] circleRadius The radius of the image circle in pixels
+   */
+  ResidualErrorFunctor_EquidistantBase(const sfmData::Observation& obs, double focalToRadius, double circleRadius)
+      : _obs(obs)
+      , _focalToRadius(focalToRadius)
+      , _circleRadius(circleRadius)
+  {
+  }
+
+  // Enum to map intrinsics parameters between aliceVision & ceres camera data parameter block.
+  enum {
+    OFFSET_FOCAL_LENGTH = 0,
+    OFFSET_PRINCIPAL_POINT_X = 1,
+    OFFSET_PRINCIPAL_POINT_Y = 2,
+    OFFSET_DISTO_K1 = 3,
+    OFFSET_DISTO_K2 = 4,
+    OFFSET_DISTO_K3 = 5,
+  };
+
+  template <typename T>
+  void applyIntrinsicParameters(const T* const cam_K,
+                                const T* const pos_proj,
+                                T* out_residuals) const
+  {
+    const T& focal = cam_K[OFFSET_FOCAL_LENGTH];
+    const T& principal_point_x = cam_K[OFFSET_PRINCIPAL_POINT_X];
+    const T& principal_point_y = cam_K[OFFSET_PRINCIPAL_POINT_Y];
+
+    // The distance to the image center is proportional to the angle with the optical axis
+    const T len2d = sqrt(pos_proj[0] * pos_proj[0] + pos_proj[1] * pos_proj[1]);
+    const T focalScale = focal * _focalToRadius;
+
+    // near the optical axis, the angle is len2d / z
+    const T radiusPerLen = len2d > T(1e-8) ? focalScale * atan2(len2d, pos_proj[2]) / len2d : focalScale / pos_proj[2];
+
+    T x_d = pos_proj[0] * radiusPerLen;
+    T y_d = pos_proj[1] * radiusPerLen;
+
+    if(withRadialK3)
+    {
+      // Apply distortion (xd,yd) = disto(x_u,y_u)
+      const T& k1 = cam_K[OFFSET_DISTO_K1];
+      const T& k2 = cam_K[OFFSET_DISTO_K2];
+      const T& k3 = cam_K[OFFSET_DISTO_K3];
+
+      const T r2 = x_d * x_d + y_d * y_d;
+      const T r4 = r2 * r2;
+      const T r6 = r4 * r2;
+      const T r_coeff = (T(1) + k1 * r2 + k2 * r4 + k3 * r6) / (T(1) + k1 + k2 + k3);
+
+      x_d *= r_coeff;
+      y_d *= r_coeff;
+    }
+
+    // Apply the image circle radius and principal point to get the final image coordinates
+    const T projected_x = principal_point_x + _circleRadius * x_d;
+    const T projected_y = principal_point_y + _circleRadius * y_d;
+
+    // Compute and return the error is the difference between the predicted
+    //  and observed position
+    const T scale(_obs.scale > 0.0 ? _obs.scale : 1.0);
+    out_residuals[0] = (projected_x - T(_obs.x[0])) / scale;
+    out_residuals[1] = (projected_y - T(_obs.x[1])) / scale;
+  }
+
+  template <typename T>
+  bool operator()(
+    const T* const cam_K,
+    const T* const cam_Rt,
+    const T* const subpose_Rt,
+    const T* const pos_3dpoint,
+    T* out_residuals) const
+  {
+    //--
+    // Apply external parameters (Pose)
+    //--
+
+    T pos_proj[3];
+
+    {
+      const T * cam_R = cam_Rt;
+      const T * cam_t = &cam_Rt[3];
+
+      // Rotate the point according the camera rotation
+      ceres::AngleAxisRotatePoint(cam_R, pos_3dpoint, pos_proj);
+
+      // Apply the camera translation
+      pos_proj[0] += cam_t[0];
+      pos_proj[1] += cam_t[1];
+      pos_proj[2] += cam_t[2];
+    }
+
+    {
+      const T * cam_R = subpose_Rt;
+      const T * cam_t = &subpose_Rt[3];
+
+      // Rotate the point according to the camera rotation
+      ceres::AngleAxisRotatePoint(cam_R, pos_proj, pos_proj);
+
+      // Apply the camera translation
+      pos_proj[0] += cam_t[0];
+      pos_proj[1] += cam_t[1];
+      pos_proj[2] += cam_t[2];
+    }
+
+    //--
+    // Apply intrinsic parameters
+    //--
+
+    applyIntrinsicParameters(cam_K, pos_proj, out_residuals);
+
+    return true;
+  }
+
+  /**
+   * @param[in] cam_K: Camera intrinsics( focal, principal point [x,y] (, k1, k2, k3) )
+   * @param[in] cam_Rt: Camera parameterized using one block of 6 parameters [R;t]:
+   *   - 3 for rotation(angle axis), 3 for translation
+   * @param[in] pos_3dpoint
+   * @param[out] out_residuals
+   */
+  template <typename T>
+  bool operator()(
+    const T* const cam_K,
+    const T* const cam_Rt,
+    const T* const pos_3dpoint,
+    T* out_residuals) const
+  {
+    //--
+    // Apply external parameters (Pose)
+    //--
+
+    const T * cam_R = cam_Rt;
+    const T * cam_t = &cam_Rt[3];
+
+    T pos_proj[3];
+    // Rotate the point according the camera rotation
+    ceres::AngleAxisRotatePoint(cam_R, pos_3dpoint, pos_proj);
+
+    // Apply the camera translation
+    pos_proj[0] += cam_t[0];
+    pos_proj[1] += cam_t[1];
+    pos_proj[2] += cam_t[2];
+
+    //--
+    // Apply intrinsic parameters
+    //--
+
+    applyIntrinsicParameters(cam_K, pos_proj, out_residuals);
+
+    return true;
+  }
+
+  const sfmData::Observation _obs; // The 2D observation
+  const double _focalToRadius;
+  const double _circleRadius;
+};
+
+using ResidualErrorFunctor_Equidistant = ResidualErrorFunctor_EquidistantBase<false>;
+using ResidualErrorFunctor_EquidistantRadialK3 = ResidualErrorFunctor_EquidistantBase<true>;
+
+
 } // namespace sfm
 } // namespace aliceVision
@@ -11,7 +11,12 @@
 
 #include <cmath>
 #include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <map>
+#include <thread>
+
+#include <boost/filesystem.hpp>
 
 #define BOOST_TEST_MODULE bundleAdjustment
 
@@ -242,6 +247,290 @@ BOOST_AUTO_TEST_CASE(LOCAL_BUNDLE_ADJUSTMENT_EffectiveMinimization_Pinhole_Camer
   BOOST_CHECK(dResidual_before > dResidual_after);
 }
 
+// Test summary:
+// - Create a SfMData scene from a synthetic dataset
+// - Adjust it several times with a persistent problem, removing observations and a landmark between the calls
+// - Check that each adjustment gives the same residual as a new problem
+
+BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_PersistentProblem)
+{
+  const int nviews = 4;
+  const int npoints = 10;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  SfMData sfmData = getInputScene(d, config, EINTRINSIC::PINHOLE_CAMERA_RADIAL3);
+
+  BundleAdjustmentCeres::CeresOptions options;
+  options.persistentProblem = true;
+  BundleAdjustmentCeres persistentBA(options);
+
+  for(int iteration = 0; iteration < 3; ++iteration)
+  {
+    // the refine options change from the first call, like in the sequential SfM
+    const BundleAdjustment::ERefineOptions refineOptions = (iteration == 0) ?
+      BundleAdjustment::REFINE_ROTATION | BundleAdjustment::REFINE_TRANSLATION | BundleAdjustment::REFINE_STRUCTURE :
+      BundleAdjustment::REFINE_ALL;
+
+    SfMData sfmDataNewProblem = sfmData;
+    const double dResidual_before = RMSE(sfmData);
+
+    BOOST_CHECK( persistentBA.adjust(sfmData, refineOptions) );
+
+    BundleAdjustmentCeres newBA;
+    BOOST_CHECK( newBA.adjust(sfmDataNewProblem, refineOptions) );
+
+    BOOST_CHECK(dResidual_before > RMSE(sfmData));
+    BOOST_CHECK_SMALL(RMSE(sfmData) - RMSE(sfmDataNewProblem), 1e-4);
+    BOOST_CHECK_EQUAL(persistentBA.getStatistics().nbResidualBlocks, newBA.getStatistics().nbResidualBlocks);
+
+    // remove some observations and a landmark before the next call
+    sfmData.getLandmarks().at(iteration).observations.erase(iteration);
+    sfmData.getLandmarks().erase(npoints - 1 - iteration);
+  }
+}
+
+// Test summary:
+// - Create a SfMData scene from a synthetic dataset
+// - Adjust it with a persistent problem, then insert observations in the landmarks before the next call
+//   (the observations of a landmark are stored in a vector, an insertion moves them)
+// - Check that each adjustment gives the same residual as a new problem
+
+BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_PersistentProblem_InsertedObservations)
+{
+  const int nviews = 4;
+  const int npoints = 10;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  SfMData sfmData = getInputScene(d, config, EINTRINSIC::PINHOLE_CAMERA_RADIAL3);
+
+  // remove the observations of the first view in half of the landmarks, they are inserted back later
+  std::map<IndexT, Observation> removedObservations;
+  for(auto& landmarkPair : sfmData.getLandmarks())
+  {
+    if(landmarkPair.first % 2 != 0)
+      continue;
+    Observations& observations = landmarkPair.second.observations;
+    removedObservations.emplace(landmarkPair.first, observations.at(0));
+    observations.erase(0);
+  }
+
+  BundleAdjustmentCeres::CeresOptions options;
+  options.persistentProblem = true;
+  BundleAdjustmentCeres persistentBA(options);
+
+  for(int iteration = 0; iteration < 2; ++iteration)
+  {
+    SfMData sfmDataNewProblem = sfmData;
+
+    BOOST_CHECK( persistentBA.adjust(sfmData, BundleAdjustment::REFINE_ALL) );
+
+    BundleAdjustmentCeres newBA;
+    BOOST_CHECK( newBA.adjust(sfmDataNewProblem, BundleAdjustment::REFINE_ALL) );
+
+    BOOST_CHECK_SMALL(RMSE(sfmData) - RMSE(sfmDataNewProblem), 1e-4);
+    BOOST_CHECK_EQUAL(persistentBA.getStatistics().nbResidualBlocks, newBA.getStatistics().nbResidualBlocks);
+
+    // insert the observations before the existing ones of the landmarks
+    for(const auto& observationPair : removedObservations)
+      sfmData.getLandmarks().at(observationPair.first).observations.emplace(0, observationPair.second);
+    removedObservations.clear();
+  }
+}
+
+//-----------------
+// Test summary:
+//-----------------
+// - Create a SfMData scene from a synthetic dataset, for all the camera models
+// - Check that the Bundle Adjustment with analytic jacobians reaches the same residual
+//   as the Bundle Adjustment with automatic differentiation
+//-----------------
+BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_AnalyticJacobians)
+{
+  const int nviews = 4;
+  const int npoints = 10;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  for(EINTRINSIC eintrinsic : {EINTRINSIC::PINHOLE_CAMERA,
+                               EINTRINSIC::PINHOLE_CAMERA_RADIAL1,
+                               EINTRINSIC::PINHOLE_CAMERA_RADIAL3,
+                               EINTRINSIC::PINHOLE_CAMERA_BROWN,
+                               EINTRINSIC::PINHOLE_CAMERA_FISHEYE,
+                               EINTRINSIC::PINHOLE_CAMERA_FISHEYE1})
+  {
+    SfMData sfmDataAutoDiff = getInputScene(d, config, eintrinsic);
+    SfMData sfmDataAnalytic = sfmDataAutoDiff;
+
+    const double dResidual_before = RMSE(sfmDataAnalytic);
+
+    BundleAdjustmentCeres autoDiffBA;
+    BOOST_CHECK( autoDiffBA.adjust(sfmDataAutoDiff) );
+
+    BundleAdjustmentCeres::CeresOptions options;
+    options.useAnalyticJacobians = true;
+    BundleAdjustmentCeres analyticBA(options);
+    BOOST_CHECK( analyticBA.adjust(sfmDataAnalytic) );
+
+    BOOST_CHECK(dResidual_before > RMSE(sfmDataAnalytic));
+    BOOST_CHECK_SMALL(RMSE(sfmDataAnalytic) - RMSE(sfmDataAutoDiff), 1e-4);
+  }
+}
+
+//-----------------
+// Test summary:
+//-----------------
+// - Create a SfMData scene from a synthetic dataset, half of the views use an equidistant camera
+// - Check that the Bundle Adjustment with analytic jacobians falls back to automatic differentiation
+//   for the equidistant camera and reaches the same residual as the Bundle Adjustment with automatic differentiation
+//-----------------
+BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_AnalyticJacobians_MixedPinholeEquidistant)
+{
+  const int nviews = 6;
+  const int npoints = 32;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  for(EINTRINSIC eintrinsic : {EINTRINSIC::EQUIDISTANT_CAMERA, EINTRINSIC::EQUIDISTANT_CAMERA_RADIAL3})
+  {
+    SfMData sfmDataAutoDiff = getInputScene(d, config, EINTRINSIC::PINHOLE_CAMERA);
+
+    // the odd views use an equidistant camera, their observations are projected with it
+    const IndexT equidistantId = 1;
+    sfmDataAutoDiff.intrinsics[equidistantId] = createIntrinsic(eintrinsic, config._cx * 2, config._cy * 2, config._fx, config._cx, config._cy);
+    const IntrinsicBase& equidistant = *sfmDataAutoDiff.intrinsics.at(equidistantId);
+
+    for(int i = 1; i < nviews; i += 2)
+    {
+      View& view = *sfmDataAutoDiff.views.at(i);
+      view.setIntrinsicId(equidistantId);
+
+      const Pose3 pose = sfmDataAutoDiff.getPose(view).getTransform();
+      for(auto& landmarkPair : sfmDataAutoDiff.structure)
+      {
+        // => random noise between [-.5,.5] is added
+        Vec2 pt = equidistant.project(pose, landmarkPair.second.X);
+        pt(0) += rand() / double(RAND_MAX) - .5;
+        pt(1) += rand() / double(RAND_MAX) - .5;
+        landmarkPair.second.observations.at(i).x = pt;
+      }
+    }
+
+    SfMData sfmDataAnalytic = sfmDataAutoDiff;
+
+    const double dResidual_before = RMSE(sfmDataAnalytic);
+
+    BundleAdjustmentCeres autoDiffBA;
+    BOOST_CHECK( autoDiffBA.adjust(sfmDataAutoDiff) );
+
+    BundleAdjustmentCeres::CeresOptions options;
+    options.useAnalyticJacobians = true;
+    BundleAdjustmentCeres analyticBA(options);
+    BOOST_CHECK_NO_THROW( BOOST_CHECK( analyticBA.adjust(sfmDataAnalytic) ) );
+
+    BOOST_CHECK(dResidual_before > RMSE(sfmDataAnalytic));
+    BOOST_CHECK_SMALL(RMSE(sfmDataAnalytic) - RMSE(sfmDataAutoDiff), 1e-4);
+  }
+}
+
+//-----------------
+// Test summary:
+//-----------------
+// - Create a SfMData scene from a synthetic dataset
+// - Check that the normalized cut clusters cover all the views, with the maximum cluster size
+// - Check that the residual is smaller once the partitioned Bundle Adjustment has been called
+//-----------------
+BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_Partitioned)
+{
+  const int nviews = 12;
+  const int npoints = 40;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  SfMData sfmData = getInputScene(d, config, EINTRINSIC::PINHOLE_CAMERA_RADIAL3);
+
+  const std::vector<std::vector<IndexT>> clusters = clusterViewsByNormalizedCut(sfmData, 4);
+  std::set<IndexT> clusteredViews;
+  for(const std::vector<IndexT>& cluster : clusters)
+  {
+    BOOST_CHECK(cluster.size() <= 4);
+    clusteredViews.insert(cluster.begin(), cluster.end());
+  }
+  BOOST_CHECK_EQUAL(clusteredViews.size(), nviews);
+
+  const double dResidual_before = RMSE(sfmData);
+
+  BundleAdjustmentPartitioned::Options options;
+  options.maxViewsPerPartition = 4;
+  options.overlapRatio = 0.5;
+  BundleAdjustmentPartitioned partitionedBA(options);
+
+  BOOST_CHECK( partitionedBA.adjust(sfmData) );
+  BOOST_CHECK(partitionedBA.getStatistics().nbPartitions > 1);
+
+  BOOST_CHECK(dResidual_before > RMSE(sfmData));
+}
+
+//-----------------
+// Test summary:
+//-----------------
+// - Fill a working folder with the files left by an earlier run
+// - Solve the partitioned Bundle Adjustment with a worker thread per partition, started before the coordinator
+// - Check that the residual is smaller and that only the done file of the run is left in the working folder
+//-----------------
+BOOST_AUTO_TEST_CASE(BUNDLE_ADJUSTMENT_PartitionedWorkers)
+{
+  namespace fs = boost::filesystem;
+
+  const int nviews = 12;
+  const int npoints = 40;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  SfMData sfmData = getInputScene(d, config, EINTRINSIC::PINHOLE_CAMERA_RADIAL3);
+  const std::size_t nbPartitions = clusterViewsByNormalizedCut(sfmData, 4).size();
+
+  const fs::path workingFolder = fs::temp_directory_path() / fs::unique_path();
+  fs::create_directories(workingFolder);
+  for(const std::string filename : {"done_earlier", "partition_earlier_0.sfm", "partition_earlier_0_iteration_0.result"})
+    std::ofstream((workingFolder / filename).string()) << "earlier run";
+
+  BundleAdjustmentPartitioned::Options options;
+  options.maxViewsPerPartition = 4;
+  options.overlapRatio = 0.5;
+  options.workingFolder = workingFolder.string();
+  options.workerTimeout = 120.0;
+
+  std::vector<std::thread> workers;
+  std::vector<char> workersOk(nbPartitions, 0);
+  for(std::size_t k = 0; k < nbPartitions; ++k)
+    workers.emplace_back([&, k]() {
+      workersOk.at(k) = runBundleAdjustmentPartitionWorker(options.workingFolder, k, options.ceresOptions, options.workerTimeout);
+    });
+
+  const double dResidual_before = RMSE(sfmData);
+
+  BundleAdjustmentPartitioned partitionedBA(options);
+  BOOST_CHECK( partitionedBA.adjust(sfmData) );
+
+  for(std::thread& worker : workers)
+    worker.join();
+
+  BOOST_CHECK_EQUAL(partitionedBA.getStatistics().nbPartitions, nbPartitions);
+  BOOST_CHECK(std::find(workersOk.begin(), workersOk.end(), 0) == workersOk.end());
+  BOOST_CHECK(dResidual_before > RMSE(sfmData));
+
+  std::vector<std::string> files;
+  for(fs::directory_iterator it(workingFolder), end; it != end; ++it)
+    files.push_back(it->path().filename().string());
+  BOOST_REQUIRE_EQUAL(files.size(), 1);
+  BOOST_CHECK(files.front().compare(0, 5, "done_") == 0);
+  BOOST_CHECK(files.front() != "done_earlier");
+
+  fs::remove_all(workingFolder);
+}
+
 /// Compute the Root Mean Square Error of the residuals
 double RMSE(const SfMData & sfm_data)
 {
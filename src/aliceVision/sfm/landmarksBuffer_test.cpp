@@ -0,0 +1,141 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/sfm/LandmarksBuffer.hpp>
+#include <aliceVision/sfm/utils/syntheticScene.hpp>
+#include <aliceVision/camera/camera.hpp>
+#include <aliceVision/multiview/NViewDataSet.hpp>
+
+#include <random>
+
+#define BOOST_TEST_MODULE landmarksBuffer
+
+#include <boost/test/unit_test.hpp>
+#include <boost/test/tools/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::sfm;
+using namespace aliceVision::sfmData;
+
+/**
+ * @brief Fill a buffer with a landmark of the scene.
+ */
+void addLandmark(LandmarksBuffer& buffer, IndexT landmarkId, const Landmark& landmark)
+{
+  buffer.addLandmark(landmarkId, landmark.X, landmark.descType, landmark.rgb);
+  for(const auto& observationPair : landmark.observations)
+    buffer.addObservation(observationPair.first, observationPair.second);
+}
+
+// Test summary:
+// - Split the landmarks of a synthetic scene in several buffers
+// - Merge the buffers in a structure with outdated landmarks
+// - Check that the structure is the scene structure and that the invalid landmarks are removed
+BOOST_AUTO_TEST_CASE(LANDMARKS_BUFFER_Merge)
+{
+  const NViewDatasetConfigurator config;
+  const NViewDataSet dataset = NRealisticCamerasRing(6, 64, config);
+  const SfMData sfmData = getInputScene(dataset, config, camera::EINTRINSIC::PINHOLE_CAMERA);
+
+  const IndexT invalidLandmarkId = sfmData.getLandmarks().size();
+
+  // outdated structure: a landmark with another position and a landmark to remove
+  Landmarks landmarks;
+  landmarks[0] = Landmark(Vec3(1.0, 2.0, 3.0), feature::EImageDescriberType::UNKNOWN);
+  landmarks[invalidLandmarkId] = sfmData.getLandmarks().at(1);
+
+  std::vector<LandmarksBuffer> buffers(3);
+  std::size_t i = 0;
+  for(const auto& landmarkPair : sfmData.getLandmarks())
+    addLandmark(buffers[i++ % buffers.size()], landmarkPair.first, landmarkPair.second);
+  buffers.back().addInvalidLandmark(invalidLandmarkId);
+
+  BOOST_CHECK_EQUAL(buffers.front().nbObservations(0), sfmData.getLandmarks().at(0).observations.size());
+
+  mergeLandmarksBuffers(buffers, landmarks);
+
+  BOOST_CHECK_EQUAL(landmarks.size(), sfmData.getLandmarks().size());
+  BOOST_CHECK(landmarks.find(invalidLandmarkId) == landmarks.end());
+
+  for(const auto& landmarkPair : sfmData.getLandmarks())
+    BOOST_CHECK(landmarks.at(landmarkPair.first) == landmarkPair.second);
+
+  buffers.front().clear();
+  BOOST_CHECK_EQUAL(buffers.front().size(), 0);
+  BOOST_CHECK_EQUAL(buffers.front().observationsOffsets.size(), 1);
+}
+
+// Test summary:
+// - Move the landmarks of a synthetic scene randomly, some of them behind the cameras or far away
+// - Check the angles and chieralities of the landmarks by batch
+// - Check that the results are the same as the check of each landmark and view
+BOOST_AUTO_TEST_CASE(LANDMARKS_BUFFER_Checks)
+{
+  const NViewDatasetConfigurator config;
+  const NViewDataSet dataset = NRealisticCamerasRing(6, 256, config);
+  const SfMData sfmData = getInputScene(dataset, config, camera::EINTRINSIC::PINHOLE_CAMERA);
+  const ViewsGeometry viewsGeometry(sfmData);
+  const double minAngle = 2.0;
+
+  BOOST_CHECK_EQUAL(viewsGeometry.centers.cols(), sfmData.getViews().size());
+
+  std::mt19937 randomNumberGenerator(0);
+  std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+
+  LandmarksBuffer buffer;
+  std::vector<std::size_t> landmarksIndexes;
+
+  for(const auto& landmarkPair : sfmData.getLandmarks())
+  {
+    Landmark landmark = landmarkPair.second;
+    const Vec3 direction(distribution(randomNumberGenerator), distribution(randomNumberGenerator), distribution(randomNumberGenerator));
+    landmark.X += 20.0 * direction;
+    if(landmarkPair.first % 5 == 0)
+      landmark.X *= 200.0;
+
+    // the last landmark is not checked
+    if(buffer.size() + 1 < sfmData.getLandmarks().size())
+      landmarksIndexes.push_back(buffer.size());
+    addLandmark(buffer, landmarkPair.first, landmark);
+  }
+
+  LandmarksBuffer anglesBuffer = buffer;
+  checkAngles(anglesBuffer, landmarksIndexes, viewsGeometry, minAngle);
+  LandmarksBuffer chieralitiesBuffer = buffer;
+  checkChieralities(chieralitiesBuffer, landmarksIndexes, viewsGeometry);
+
+  std::size_t nbInvalidAngles = 0;
+  std::size_t nbInvalidChieralities = 0;
+
+  for(std::size_t i = 0; i < buffer.size(); ++i)
+  {
+    bool validAngle = false;
+    bool validChierality = true;
+
+    for(std::size_t a = buffer.observationsOffsets[i]; a < buffer.observationsOffsets[i + 1]; ++a)
+    {
+      const geometry::Pose3 poseA = sfmData.getPose(*sfmData.getViews().at(buffer.observationsViewIds[a])).getTransform();
+      validChierality = validChierality && (poseA.depth(buffer.points[i]) >= 0.0);
+
+      for(std::size_t b = a + 1; b < buffer.observationsOffsets[i + 1]; ++b)
+      {
+        const geometry::Pose3 poseB = sfmData.getPose(*sfmData.getViews().at(buffer.observationsViewIds[b])).getTransform();
+        validAngle = validAngle || (camera::angleBetweenRays(poseA, poseB, buffer.points[i]) >= minAngle);
+      }
+    }
+
+    const bool checked = (i + 1 < buffer.size());
+    BOOST_CHECK_EQUAL(bool(anglesBuffer.isValid[i]), validAngle || !checked);
+    BOOST_CHECK_EQUAL(bool(chieralitiesBuffer.isValid[i]), validChierality || !checked);
+
+    nbInvalidAngles += !validAngle;
+    nbInvalidChieralities += !validChierality;
+  }
+
+  // both checks reject some landmarks
+  BOOST_CHECK(nbInvalidAngles > 0 && nbInvalidAngles < buffer.size());
+  BOOST_CHECK(nbInvalidChieralities > 0 && nbInvalidChieralities < buffer.size());
+}
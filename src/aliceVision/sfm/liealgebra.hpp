@@ -86,6 +86,31 @@ inline Eigen::Vector3d logm(const Eigen::Matrix3d & R) {
     return ret;
 }
 
+/**
+Compute the right jacobian of the exponential map
+expm(algebra + delta) ~= expm(algebra) * expm(rightJacobian(algebra) * delta)
+@param algebra the 3d vector
+@return the 3*3 jacobian matrix
+*/
+inline Eigen::Matrix3d rightJacobian(const Eigen::Vector3d & algebra) {
+    const double angle = algebra.norm();
+    const double angle2 = angle * angle;
+    const Eigen::Matrix3d omega = skew(algebra);
+
+    double a, b;
+    if (angle < 1e-4) {
+        // Taylor expansions of (1 - cos(angle)) / angle^2 and (angle - sin(angle)) / angle^3
+        a = 0.5 - angle2 / 24.0;
+        b = 1.0 / 6.0 - angle2 / 120.0;
+    }
+    else {
+        a = (1.0 - cos(angle)) / angle2;
+        b = (angle - sin(angle)) / (angle2 * angle);
+    }
+
+    return Eigen::Matrix3d::Identity() - a * omega + b * omega * omega;
+}
+
 /**
 Compute the jacobian of the logarithm wrt changes in the rotation matrix values
 @param R the input rotation matrix
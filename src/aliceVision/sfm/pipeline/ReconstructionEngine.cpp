@@ -57,7 +57,7 @@ void retrieveMarkersId(sfmData::SfMData& sfmData)
         const auto obs = landmark.observations.begin();
         const feature::Regions& regions = regionPerView.getRegions(obs->first, landmark.descType);
         const feature::CCTAG_Regions& cctagRegions = dynamic_cast<const feature::CCTAG_Regions&>(regions);
-        const auto& d = cctagRegions.Descriptors()[obs->second.id_feat];
+        const auto& d = cctagRegions.GetDescriptor(obs->second.id_feat);
         for (int i = 0; i < d.size(); ++i)
         {
             if (d[i] == 255)
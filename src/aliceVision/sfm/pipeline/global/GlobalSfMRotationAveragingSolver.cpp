@@ -10,6 +10,7 @@
 #include <aliceVision/graph/graph.hpp>
 #include <aliceVision/multiview/rotationAveraging/rotationAveraging.hpp>
 #include <aliceVision/stl/mapUtils.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <aliceVision/utils/Histogram.hpp>
 
@@ -140,6 +141,28 @@ bool GlobalSfMRotationAveragingSolver::Run(
       }
     }
     break;
+    case ROTATION_AVERAGING_IRLS:
+    {
+      //- Solve the global rotation estimation problem with sparse linear systems only:
+      const size_t nMainViewID = 0; //arbitrary choice
+      std::vector<bool> vec_inliers;
+      bSuccess = rotationAveraging::sparse::GlobalRotationsIRLS(
+        _reindexForward.size(), relativeRotations, vec_globalR, nMainViewID, max_angular_error, &vec_inliers);
+
+      ALICEVISION_LOG_DEBUG("rotationAveraging::sparse::GlobalRotationsIRLS: success: " << bSuccess);
+
+      // save kept pairs (restore original pose indices using the backward reindexing)
+      for (size_t i = 0; i < vec_inliers.size(); ++i)
+      {
+        if (vec_inliers[i])
+        {
+          used_pairs.insert(
+            Pair(_reindexBackward[relativeRotations[i].i],
+                 _reindexBackward[relativeRotations[i].j]));
+        }
+      }
+    }
+    break;
     default:
       ALICEVISION_LOG_DEBUG(
         "Unknown rotation averaging method: " << (int) eRotationAveragingMethod);
@@ -178,51 +201,53 @@ void GlobalSfMRotationAveragingSolver::TripletRotationRejection(
   std::vector< graph::Triplet > vec_triplets_validated;
   vec_triplets_validated.reserve(vec_triplets.size());
 
-  std::vector<float> vec_errToIdentityPerTriplet;
-  vec_errToIdentityPerTriplet.reserve(vec_triplets.size());
-  // Compute the composition error for each length 3 cycles
-  for (size_t i = 0; i < vec_triplets.size(); ++i)
+  std::vector<float> vec_errToIdentityPerTriplet(vec_triplets.size());
+
+  // Compute the composition error for each length 3 cycles (read only access to the relative rotations)
+  #pragma omp parallel for schedule(dynamic, 256)
+  for (int i = 0; i < static_cast<int>(vec_triplets.size()); ++i)
   {
     const graph::Triplet & triplet = vec_triplets[i];
     const IndexT I = triplet.i, J = triplet.j , K = triplet.k;
 
-    ALICEVISION_LOG_DEBUG("GlobalSfMRotationAveragingSolver::TripletRotationRejection: i: " << i << ", (" << I << ", " << J << ", " << K << ").");
-
     //-- Find the three relative rotations
     const Pair ij(I,J), ji(J,I);
-    const Mat3 RIJ = (map_relatives.count(ij)) ?
-      map_relatives.at(ij).Rij : Mat3(map_relatives.at(ji).Rij.transpose());
+    const auto itIJ = map_relatives.find(ij);
+    const Mat3 RIJ = (itIJ != map_relatives.end()) ?
+      itIJ->second.Rij : Mat3(map_relatives.at(ji).Rij.transpose());
 
     const Pair jk(J,K), kj(K,J);
-    const Mat3 RJK = (map_relatives.count(jk)) ?
-      map_relatives.at(jk).Rij : Mat3(map_relatives.at(kj).Rij.transpose());
+    const auto itJK = map_relatives.find(jk);
+    const Mat3 RJK = (itJK != map_relatives.end()) ?
+      itJK->second.Rij : Mat3(map_relatives.at(kj).Rij.transpose());
 
     const Pair ki(K,I), ik(I,K);
-    const Mat3 RKI = (map_relatives.count(ki)) ?
-      map_relatives.at(ki).Rij : Mat3(map_relatives.at(ik).Rij.transpose());
+    const auto itKI = map_relatives.find(ki);
+    const Mat3 RKI = (itKI != map_relatives.end()) ?
+      itKI->second.Rij : Mat3(map_relatives.at(ik).Rij.transpose());
 
     const Mat3 Rot_To_Identity = RIJ * RJK * RKI; // motion composition
-    const float angularErrorDegree = static_cast<float>(radianToDegree(getRotationMagnitude(Rot_To_Identity)));
-    vec_errToIdentityPerTriplet.push_back(angularErrorDegree);
+    vec_errToIdentityPerTriplet[i] = static_cast<float>(radianToDegree(getRotationMagnitude(Rot_To_Identity)));
+  }
+
+  // Keep the relative rotations of the valid triplets
+  for (size_t i = 0; i < vec_triplets.size(); ++i)
+  {
+    const graph::Triplet & triplet = vec_triplets[i];
+    const float angularErrorDegree = vec_errToIdentityPerTriplet[i];
 
     if (angularErrorDegree < max_angular_error)
     {
       vec_triplets_validated.push_back(triplet);
 
-      if (map_relatives.count(ij))
-        map_relatives_validated[ij] = map_relatives.at(ij);
-      else
-        map_relatives_validated[ji] = map_relatives.at(ji);
-
-      if (map_relatives.count(jk))
-        map_relatives_validated[jk] = map_relatives.at(jk);
-      else
-        map_relatives_validated[kj] = map_relatives.at(kj);
-
-      if (map_relatives.count(ki))
-        map_relatives_validated[ki] = map_relatives.at(ki);
-      else
-        map_relatives_validated[ik] = map_relatives.at(ik);
+      for (const Pair& edge : {Pair(triplet.i, triplet.j), Pair(triplet.j, triplet.k), Pair(triplet.k, triplet.i)})
+      {
+        const auto it = map_relatives.find(edge);
+        if (it != map_relatives.end())
+          map_relatives_validated[edge] = it->second;
+        else
+          map_relatives_validated[Pair(edge.second, edge.first)] = map_relatives.at(Pair(edge.second, edge.first));
+      }
     }
     else
     {
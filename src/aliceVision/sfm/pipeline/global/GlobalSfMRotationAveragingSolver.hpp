@@ -17,7 +17,8 @@ namespace sfm {
 enum ERotationAveragingMethod
 {
   ROTATION_AVERAGING_L1 = 1,
-  ROTATION_AVERAGING_L2 = 2
+  ROTATION_AVERAGING_L2 = 2,
+  ROTATION_AVERAGING_IRLS = 3
 };
 
 enum ERelativeRotationInferenceMethod
@@ -34,6 +35,8 @@ inline std::string ERotationAveragingMethod_enumToString(ERotationAveragingMetho
       return "L1_minimization";
     case ERotationAveragingMethod::ROTATION_AVERAGING_L2:
       return "L2_minimization";
+    case ERotationAveragingMethod::ROTATION_AVERAGING_IRLS:
+      return "IRLS_minimization";
   }
   throw std::out_of_range("Invalid rotation averaging method type");
 }
@@ -42,6 +45,7 @@ inline ERotationAveragingMethod ERotationAveragingMethod_stringToEnum(const std:
 {
   if(RotationAveragingMethodName == "L1_minimization")      return ERotationAveragingMethod::ROTATION_AVERAGING_L1;
   if(RotationAveragingMethodName == "L2_minimization")   return ERotationAveragingMethod::ROTATION_AVERAGING_L2;
+  if(RotationAveragingMethodName == "IRLS_minimization")   return ERotationAveragingMethod::ROTATION_AVERAGING_IRLS;
 
   throw std::out_of_range("Invalid rotation averaging method name : '" + RotationAveragingMethodName + "'");
 }
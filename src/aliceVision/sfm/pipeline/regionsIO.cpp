@@ -22,7 +22,8 @@ using namespace sfmData;
 
 std::unique_ptr<feature::Regions> loadRegions(const std::vector<std::string>& folders,
                                               IndexT viewId,
-                                              const feature::ImageDescriber& imageDescriber)
+                                              const feature::ImageDescriber& imageDescriber,
+                                              bool mapDescriptors)
 {
   assert(!folders.empty());
 
@@ -55,7 +56,10 @@ std::unique_ptr<feature::Regions> loadRegions(const std::vector<std::string>& fo
 
   try
   {
-    regionsPtr->Load(featFilename, descFilename);
+    if(mapDescriptors)
+      regionsPtr->LoadMapped(featFilename, descFilename);
+    else
+      regionsPtr->Load(featFilename, descFilename);
   }
   catch(const std::exception& e)
   {
@@ -127,7 +131,8 @@ bool loadRegionsPerView(feature::RegionsPerView& regionsPerView,
             const SfMData& sfmData,
             const std::vector<std::string>& folders,
             const std::vector<feature::EImageDescriberType>& imageDescriberTypes,
-            const std::set<IndexT>& viewIdFilter)
+            const std::set<IndexT>& viewIdFilter,
+            bool mapDescriptors)
 {
   std::vector<std::string> featuresFolders = sfmData.getFeaturesFolders(); // add sfm features folders
   featuresFolders.insert(featuresFolders.end(), folders.begin(), folders.end()); // add user features folders
@@ -151,7 +156,7 @@ bool loadRegionsPerView(feature::RegionsPerView& regionsPerView,
      {
        if(viewIdFilter.empty() || viewIdFilter.find(iter->second.get()->getViewId()) != viewIdFilter.end())
        {
-         std::unique_ptr<feature::Regions> regionsPtr = loadRegions(featuresFolders, iter->second.get()->getViewId(), *(imageDescribers.at(i)));
+         std::unique_ptr<feature::Regions> regionsPtr = loadRegions(featuresFolders, iter->second.get()->getViewId(), *(imageDescribers.at(i)), mapDescriptors);
          if(regionsPtr)
          {
 #pragma omp critical
@@ -203,7 +208,7 @@ bool loadFeaturesPerView(feature::FeaturesPerView& featuresPerView,
 #pragma omp critical
         {
           // save loaded Features as PointFeature
-          featuresPerView.addFeatures(iter->second.get()->getViewId(), imageDescriberTypes[i], regionsPtr->GetRegionsPositions());
+          featuresPerView.addFeatures(iter->second.get()->getViewId(), imageDescriberTypes[i], std::move(regionsPtr->Features()));
           ++progressBar;
         }
       }
@@ -24,9 +24,10 @@ namespace sfm {
  * @param[in] folders The list of featureFolders
  * @param[in] viewId The view id
  * @param[in] imageDescriber The imageDescriber type
+ * @param[in] mapDescriptors Map the descriptors file instead of loading it in memory
  * @return loaded Regions
  */
-std::unique_ptr<feature::Regions> loadRegions(const std::vector<std::string>& folders, IndexT viewId, const feature::ImageDescriber& imageDescriber);
+std::unique_ptr<feature::Regions> loadRegions(const std::vector<std::string>& folders, IndexT viewId, const feature::ImageDescriber& imageDescriber, bool mapDescriptors = false);
 
 /**
  * @brief Load Features for one view.
@@ -44,13 +45,16 @@ std::unique_ptr<feature::Regions> loadFeatures(const std::vector<std::string>& f
  * @param[in] folders The feature Folders
  * @param[in] imageDescriberTypes The imageDescriber types
  * @param[in] filter To load Regions only for a sub-set of the views contained in the sfmData
+ * @param[in] mapDescriptors Map the descriptors files (read-only) instead of loading them in memory,
+ *            descriptors are then only accessible through Regions::DescriptorRawData()
  * @return true if the regions are correctlty loaded
  */
 bool loadRegionsPerView(feature::RegionsPerView& regionsPerView,
                         const sfmData::SfMData& sfmData,
                         const std::vector<std::string>& folders,
                         const std::vector<feature::EImageDescriberType>& imageDescriberTypes,
-                        const std::set<IndexT>& filter = std::set<IndexT>());
+                        const std::set<IndexT>& filter = std::set<IndexT>(),
+                        bool mapDescriptors = false);
 
 /**
  * @brief Load Features for each view of the provided SfMData container.
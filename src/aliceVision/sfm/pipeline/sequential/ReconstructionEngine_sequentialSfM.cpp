@@ -27,8 +27,9 @@
 #include <aliceVision/system/Timer.hpp>
 #include <aliceVision/system/cpu.hpp>
 #include <aliceVision/system/MemoryInfo.hpp>
-#include <aliceVision/track/TracksBuilder.hpp>
+#include <aliceVision/track/StreamingTracksBuilder.hpp>
 #include <aliceVision/track/tracksUtils.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <dependencies/htmlDoc/htmlDoc.hpp>
 
@@ -40,6 +41,7 @@
 #include <tuple>
 #include <iostream>
 #include <algorithm>
+#include <iterator>
 
 #ifdef _MSC_VER
 #pragma warning( once : 4267 ) //warning C4267: 'argument' : conversion from 'size_t' to 'const int', possible loss of data
@@ -59,7 +61,7 @@ using namespace aliceVision::sfmData;
  * These precomputed values are useful to the next best view selection for incremental SfM.
  *
  * @param[in] tracksPerView: The list of TrackID per view
- * @param[in] map_tracks: All putative tracks
+ * @param[in] tracks: All putative tracks, with their features per view
  * @param[in] views: All views
  * @param[in] featuresProvider: Input features and descriptors
  * @param[in] pyramidDepth: Depth of the pyramid.
@@ -68,7 +70,7 @@ using namespace aliceVision::sfmData;
  */
 void computeTracksPyramidPerView(
     const track::TracksPerView& tracksPerView,
-    const track::TracksMap& map_tracks,
+    const track::TracksStore& tracks,
     const Views& views,
     const feature::FeaturesPerView& featuresProvider,
     const std::size_t pyramidBase,
@@ -105,12 +107,13 @@ void computeTracksPyramidPerView(
       cellWidthPerLevel[level] = (double)view.getWidth() / (double)widthPerLevel[level];
       cellHeightPerLevel[level] = (double)view.getHeight() / (double)widthPerLevel[level];
     }
-    for(std::size_t i = 0; i < viewTracks.second.size(); ++i)
+    // the reverse index gives the feature of each track in the view, without any lookup in the tracks
+    const track::TracksStore::ViewTracks storeViewTracks = tracks.getViewTracks(viewId);
+    for(std::size_t i = 0; i < storeViewTracks.size; ++i)
     {
-      const std::size_t trackId = viewTracks.second[i];
-      const track::Track& track = map_tracks.at(trackId);
-      const std::size_t featIndex = track.featPerView.at(viewId);
-      const auto& feature = featuresProvider.getFeatures(viewId, track.descType)[featIndex]; 
+      const std::size_t trackId = storeViewTracks.trackIds[i];
+      const std::size_t featIndex = storeViewTracks.featIds[i];
+      const auto& feature = featuresProvider.getFeatures(viewId, tracks.at(trackId).descType)[featIndex];
       
       for(std::size_t level = 0; level < pyramidDepth; ++level)
       {
@@ -212,10 +215,12 @@ void ReconstructionEngine_sequentialSfM::initializePyramidScoring()
   if(_pyramidWeights.size() != _params.pyramidDepth)
   {
     _pyramidWeights.resize(_params.pyramidDepth);
+    _pyramidNbCells = 0;
     std::size_t maxWeight = 0;
     for(std::size_t level = 0; level < _params.pyramidDepth; ++level)
     {
       std::size_t nbCells = Square(std::pow(_params.pyramidBase, level+1));
+      _pyramidNbCells += nbCells;
       // We use a different weighting strategy than [Schonberger 2016].
       // They use w = 2^l with l={1...L} (even if there is a typo in the text where they say to use w=2^{2*l}.
       // We prefer to give more importance to the first levels of the pyramid, so:
@@ -230,7 +235,7 @@ void ReconstructionEngine_sequentialSfM::initializePyramidScoring()
 std::size_t ReconstructionEngine_sequentialSfM::fuseMatchesIntoTracks()
 {
   // compute tracks from matches
-  track::TracksBuilder tracksBuilder;
+  track::StreamingTracksBuilder tracksBuilder;
 
   {
     // list of features matches for each couple of images
@@ -239,12 +244,12 @@ std::size_t ReconstructionEngine_sequentialSfM::fuseMatchesIntoTracks()
     ALICEVISION_LOG_DEBUG("Track building");
     tracksBuilder.build(matches);
 
-    ALICEVISION_LOG_DEBUG("Track filtering");
-    tracksBuilder.filter(_params.filterTrackForks, _params.minInputTrackLength);
-
-    ALICEVISION_LOG_DEBUG("Track export to internal structure");
-    // build tracks with STL compliant type
-    tracksBuilder.exportToSTL(_map_tracks);
+    ALICEVISION_LOG_DEBUG("Track filtering and export to internal structure");
+    {
+      track::TracksCSR tracks;
+      tracksBuilder.exportToCSR(tracks, _params.filterTrackForks, _params.minInputTrackLength);
+      _map_tracks = track::TracksStore(tracks);
+    }
     ALICEVISION_LOG_DEBUG("Build tracks per view");
 
     // Init tracksPerView to have an entry in the map for each view (even if there is no track at all)
@@ -264,7 +269,7 @@ std::size_t ReconstructionEngine_sequentialSfM::fuseMatchesIntoTracks()
       track::imageIdInTracks(_map_tracksPerView, imagesId);
 
       ALICEVISION_LOG_INFO("Fuse matches into tracks: " << std::endl
-        << "\t- # tracks: " << tracksBuilder.nbTracks() << std::endl
+        << "\t- # tracks: " << _map_tracks.size() << std::endl
         << "\t- # images in tracks: " << imagesId.size());
 
       std::map<size_t, size_t> map_Occurence_TrackLength;
@@ -356,7 +361,7 @@ void ReconstructionEngine_sequentialSfM::remapLandmarkIdsToTrackIds()
   for(const auto& trackPair : _map_tracks)
   {
     const IndexT trackId = trackPair.first;
-    const Track& track = trackPair.second;
+    const track::TrackRef& track = trackPair.second;
 
     for(const auto& featView : track.featPerView)
     {
@@ -434,7 +439,10 @@ double ReconstructionEngine_sequentialSfM::incrementalReconstruction()
                          << "\t- # remaining images: " << remainingViewIds.size()
                          );
     // compute robust resection of remaining images
-    while(findNextBestViews(bestViewCandidates, remainingViewIds))
+    // (the pipelined mode is only available with the multiview triangulation)
+    if(_params.pipelinedResection && _params.minNbObservationsForTriangulation > 0)
+      pipelinedReconstruction(resectionId, remainingViewIds);
+    else while(findNextBestViews(bestViewCandidates, remainingViewIds))
     {
       ALICEVISION_LOG_INFO("Update Reconstruction:" << std::endl
         << "\t- resection id: " << resectionId << std::endl
@@ -501,80 +509,187 @@ double ReconstructionEngine_sequentialSfM::incrementalReconstruction()
   return timer.elapsed();
 }
 
- std::set<IndexT> ReconstructionEngine_sequentialSfM::resection(IndexT resectionId,
-                                                                const std::vector<IndexT>& bestViewIds,
-                                                                const std::set<IndexT>& prevReconstructedViews,
-                                                                std::set<IndexT>& remainingViewIds)
+void ReconstructionEngine_sequentialSfM::pipelinedReconstruction(IndexT& resectionId, std::set<IndexT>& remainingViewIds)
 {
-  auto chrono_start = std::chrono::steady_clock::now();
+  std::vector<IndexT> bestViewCandidates;
+  // views localized by the previous step, not yet triangulated
+  std::set<IndexT> viewsToTriangulate;
 
-  // add images to the 3D reconstruction
-#pragma omp parallel for
-  for(int i = 0; i < bestViewIds.size(); ++i)
+  while(true)
   {
-    const IndexT viewId = bestViewIds.at(i);
-    const View& view = *_sfmData.getViews().at(viewId);
-
-    if(view.isPartOfRig())
-    {
-      // some views can become indirectly localized when the sub-pose becomes defined
-      if(_sfmData.isPoseAndIntrinsicDefined(view.getViewId()))
-      {
-        ALICEVISION_LOG_DEBUG("Resection of image " << i << " was skipped." << std::endl
-          << "View indirectly localized, sub-pose and pose already defined." << std::endl
-          << "\t- view id: " << viewId << std::endl
-          << "\t- rig id: " << view.getRigId() << std::endl
-          << "\t- sub-pose id: " << view.getSubPoseId());
+    const bool hasCandidates = findNextBestViews(bestViewCandidates, remainingViewIds);
 
-#pragma omp critical
-        remainingViewIds.erase(viewId);
+    if(!hasCandidates && viewsToTriangulate.empty())
+      break;
 
-        continue;
-      }
+    ALICEVISION_LOG_INFO("Update Reconstruction (pipelined):" << std::endl
+      << "\t- resection id: " << resectionId << std::endl
+      << "\t- # images in the resection group: " << bestViewCandidates.size() << std::endl
+      << "\t- # images to triangulate: " << viewsToTriangulate.size() << std::endl
+      << "\t- # images remaining: " << remainingViewIds.size());
 
-      // we cannot localize a view if it is part of an initialized rig with unknown rig pose and unknown sub-pose
-      const bool knownPose = _sfmData.existsPose(view);
-      const Rig& rig = _sfmData.getRig(view);
-      const RigSubPose& subpose = rig.getSubPose(view.getSubPoseId());
+    auto chrono_start = std::chrono::steady_clock::now();
 
-      if(rig.isInitialized() && !knownPose && (subpose.status == ERigSubPoseStatus::UNINITIALIZED))
-      {
-        ALICEVISION_LOG_DEBUG("Resection of image " << i << " was skipped." << std::endl
-          << "Rig initialized but unkown pose and sub-pose." << std::endl
-          << "\t- view id: " << viewId << std::endl
-          << "\t- rig id: " << view.getRigId() << std::endl
-          << "\t- sub-pose id: " << view.getSubPoseId());
+    // get reconstructed views before resection
+    const std::set<IndexT> prevReconstructedViews = _sfmData.getValidViews();
 
-#pragma omp critical
-        remainingViewIds.erase(viewId);
-
-        continue;
-      }
+    TriangulationData triangulationData;
+    if(!viewsToTriangulate.empty())
+    {
+      std::set<IndexT> prevTriangulatedViews;
+      std::set_difference(prevReconstructedViews.begin(), prevReconstructedViews.end(),
+                          viewsToTriangulate.begin(), viewsToTriangulate.end(),
+                          std::inserter(prevTriangulatedViews, prevTriangulatedViews.end()));
+      prepareTriangulation(prevTriangulatedViews, viewsToTriangulate, triangulationData);
     }
 
-    ResectionData newResectionData;
-    newResectionData.error_max = _params.localizerEstimatorError;
-    newResectionData.max_iteration = _params.localizerEstimatorMaxIterations;
-    const bool hasResected = computeResection(viewId, newResectionData);
+    // resection of the new group and triangulation of the previous one only read the scene,
+    // resections come first as they are the longest tasks
+    const int nbResections = bestViewCandidates.size();
+    const int nbTracks = triangulationData.tracksIds.size();
+    std::vector<ResectionData> resectionsData(nbResections);
+    std::vector<char> hasResected(nbResections, 0);
 
-#pragma omp critical
+#pragma omp parallel for schedule(dynamic)
+    for(int i = 0; i < nbResections + nbTracks; ++i)
     {
-      if(hasResected)
+      if(i < nbResections)
       {
-        updateScene(viewId, newResectionData);
-        ALICEVISION_LOG_DEBUG("Resection of image " << i << " ( view id: " << viewId << " ) succeed.");
-        _sfmData.getViews().at(viewId)->setResectionId(resectionId);
+        hasResected[i] = resectView(bestViewCandidates[i], resectionsData[i]);
       }
       else
       {
-        ALICEVISION_LOG_DEBUG("Resection of image " << i << " ( view id: " << viewId << " ) was not possible.");
+        const int t = i - nbResections;
+        const int threadId = omp_get_thread_num();
+        triangulateTrack_multiViewsLORANSAC(_sfmData, triangulationData.tracksIds[t], triangulationData.observations[t],
+                                            triangulationData.landmarksBuffers[threadId], triangulationData.landmarksToCheck[threadId]);
       }
-      remainingViewIds.erase(viewId);
     }
+
+    // merge the new landmarks first, so the observations of the new views are added to them
+    applyTriangulation(_sfmData, triangulationData);
+    std::set<IndexT> newReconstructedViews = mergeResections(resectionId, bestViewCandidates, resectionsData, hasResected, prevReconstructedViews, remainingViewIds);
+
+    ALICEVISION_LOG_DEBUG("Resection of " << nbResections << " new images and triangulation of " << nbTracks << " tracks took "
+                          << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - chrono_start).count() << " msec.");
+
+    std::set<IndexT> updatedViews = viewsToTriangulate;
+    updatedViews.insert(newReconstructedViews.begin(), newReconstructedViews.end());
+
+    if(!updatedViews.empty())
+      bundleAdjustment(updatedViews);
+
+    // the bundle adjustment can remove unstable views
+    viewsToTriangulate.clear();
+    for(IndexT viewId : newReconstructedViews)
+    {
+      if(updatedViews.count(viewId))
+        viewsToTriangulate.insert(viewId);
+    }
+
+    if(!hasCandidates)
+      continue;
+
+    // scene logging for visual debug
+    if((resectionId % 3) == 0)
+    {
+      auto chrono_start = std::chrono::steady_clock::now();
+      std::ostringstream os;
+      os << "sfm_" << std::setw(8) << std::setfill('0') << resectionId;
+      sfmDataIO::Save(_sfmData, (fs::path(_sfmStepFolder) / (os.str() + _params.sfmStepFileExtension)).string(), _params.sfmStepFilter);
+      ALICEVISION_LOG_DEBUG("Save of file " << os.str() << " took " << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - chrono_start).count() << " msec.");
+    }
+
+    ++resectionId;
+  }
+}
+
+std::set<IndexT> ReconstructionEngine_sequentialSfM::resection(IndexT resectionId,
+                                                               const std::vector<IndexT>& bestViewIds,
+                                                               const std::set<IndexT>& prevReconstructedViews,
+                                                               std::set<IndexT>& remainingViewIds)
+{
+  auto chrono_start = std::chrono::steady_clock::now();
+
+  // compute the resections, each thread works on its own ResectionData
+  std::vector<ResectionData> resectionsData(bestViewIds.size());
+  std::vector<char> hasResected(bestViewIds.size(), 0);
+
+#pragma omp parallel for schedule(dynamic)
+  for(std::size_t i = 0; i < bestViewIds.size(); ++i)
+  {
+    hasResected[i] = resectView(bestViewIds[i], resectionsData[i]);
   }
 
   ALICEVISION_LOG_DEBUG("Resection of " << bestViewIds.size() << " new images took " << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - chrono_start).count() << " msec.");
 
+  // add images to the 3D reconstruction
+  return mergeResections(resectionId, bestViewIds, resectionsData, hasResected, prevReconstructedViews, remainingViewIds);
+}
+
+bool ReconstructionEngine_sequentialSfM::resectView(IndexT viewId, ResectionData& resectionData) const
+{
+  const View& view = *_sfmData.getViews().at(viewId);
+
+  if(view.isPartOfRig())
+  {
+    // some views can become indirectly localized when the sub-pose becomes defined
+    if(_sfmData.isPoseAndIntrinsicDefined(view.getViewId()))
+    {
+      ALICEVISION_LOG_DEBUG("Resection of image " << viewId << " was skipped." << std::endl
+        << "View indirectly localized, sub-pose and pose already defined." << std::endl
+        << "\t- view id: " << viewId << std::endl
+        << "\t- rig id: " << view.getRigId() << std::endl
+        << "\t- sub-pose id: " << view.getSubPoseId());
+      return false;
+    }
+
+    // we cannot localize a view if it is part of an initialized rig with unknown rig pose and unknown sub-pose
+    const bool knownPose = _sfmData.existsPose(view);
+    const Rig& rig = _sfmData.getRig(view);
+    const RigSubPose& subpose = rig.getSubPose(view.getSubPoseId());
+
+    if(rig.isInitialized() && !knownPose && (subpose.status == ERigSubPoseStatus::UNINITIALIZED))
+    {
+      ALICEVISION_LOG_DEBUG("Resection of image " << viewId << " was skipped." << std::endl
+        << "Rig initialized but unkown pose and sub-pose." << std::endl
+        << "\t- view id: " << viewId << std::endl
+        << "\t- rig id: " << view.getRigId() << std::endl
+        << "\t- sub-pose id: " << view.getSubPoseId());
+      return false;
+    }
+  }
+
+  resectionData.error_max = _params.localizerEstimatorError;
+  resectionData.max_iteration = _params.localizerEstimatorMaxIterations;
+  const bool hasResected = computeResection(viewId, resectionData);
+
+  if(!hasResected)
+    ALICEVISION_LOG_DEBUG("Resection of image ( view id: " << viewId << " ) was not possible.");
+
+  return hasResected;
+}
+
+std::set<IndexT> ReconstructionEngine_sequentialSfM::mergeResections(IndexT resectionId,
+                                                                     const std::vector<IndexT>& viewIds,
+                                                                     const std::vector<ResectionData>& resectionsData,
+                                                                     const std::vector<char>& hasResected,
+                                                                     const std::set<IndexT>& prevReconstructedViews,
+                                                                     std::set<IndexT>& remainingViewIds)
+{
+  // update the scene in the group order, so the result does not depend on the threads
+  for(std::size_t i = 0; i < viewIds.size(); ++i)
+  {
+    const IndexT viewId = viewIds[i];
+    if(hasResected[i])
+    {
+      updateScene(viewId, resectionsData[i]);
+      ALICEVISION_LOG_DEBUG("Resection of image " << i << " ( view id: " << viewId << " ) succeed.");
+      _sfmData.getViews().at(viewId)->setResectionId(resectionId);
+    }
+    remainingViewIds.erase(viewId);
+  }
+
   // get new reconstructed views
   std::set<IndexT> newReconstructedViews;
   {
@@ -610,7 +725,16 @@ bool ReconstructionEngine_sequentialSfM::bundleAdjustment(std::set<IndexT>& newR
   ALICEVISION_LOG_INFO("Bundle adjustment start.");
   auto chronoStart = std::chrono::steady_clock::now();
 
-  BundleAdjustmentCeres::CeresOptions options;
+  // the bundle adjustment is kept between the iterations to reuse its persistent problem
+  if(_bundleAdjustment == nullptr)
+  {
+    BundleAdjustmentCeres::CeresOptions defaultOptions;
+    defaultOptions.persistentProblem = _params.usePersistentBundleAdjustment;
+    _bundleAdjustment = std::make_shared<BundleAdjustmentCeres>(defaultOptions);
+  }
+
+  // start from the current options to keep the loss function used by the persistent problem
+  BundleAdjustmentCeres::CeresOptions options = _bundleAdjustment->getCeresOptions();
   BundleAdjustment::ERefineOptions refineOptions = BundleAdjustment::REFINE_ROTATION | BundleAdjustment::REFINE_TRANSLATION | BundleAdjustment::REFINE_STRUCTURE;
 
   if(!isInitialPair && !_params.lockAllIntrinsics)
@@ -664,11 +788,11 @@ bool ReconstructionEngine_sequentialSfM::bundleAdjustment(std::set<IndexT>& newR
     }
   }
 
-  BundleAdjustmentCeres BA(options);
+  _bundleAdjustment->setCeresOptions(options);
+  BundleAdjustmentCeres& BA = *_bundleAdjustment;
 
   // give the local strategy graph is local strategy is enable
-  if(enableLocalStrategy)
-    BA.useLocalStrategyGraph(_localStrategyGraph);
+  BA.useLocalStrategyGraph(enableLocalStrategy ? _localStrategyGraph : nullptr);
 
   // perform BA until all point are under the given precision
   do
@@ -861,26 +985,25 @@ bool ReconstructionEngine_sequentialSfM::findConnectedViews(
   if (remainingViewIds.empty() || _sfmData.getLandmarks().empty())
     return false;
 
-  // Collect tracksIds
-  std::set<size_t> reconstructed_trackId;
-  std::transform(_sfmData.getLandmarks().begin(), _sfmData.getLandmarks().end(),
-                 std::inserter(reconstructed_trackId, reconstructed_trackId.begin()),
-                 stl::RetrieveKey());
+  // Update the number of reconstructed tracks and the pyramid occupancy
+  // of the remaining views with the tracks modified since the last call
+  updateNextBestViewScoring(remainingViewIds);
 
   const std::set<IndexT> reconstructedIntrinsics = _sfmData.getReconstructedIntrinsics();
+  const std::vector<IndexT> viewIds(remainingViewIds.begin(), remainingViewIds.end());
+  std::vector<ViewConnectionScore> viewsScore(viewIds.size());
+  std::vector<char> isConnectedView(viewIds.size(), 0);
 
 #pragma omp parallel for
-  for(int i = 0; i < remainingViewIds.size(); ++i)
+  for(std::size_t i = 0; i < viewIds.size(); ++i)
   {
-    std::set<IndexT>::const_iterator iter = remainingViewIds.cbegin();
-    std::advance(iter, i);
-    const IndexT viewId = *iter;
+    const IndexT viewId = viewIds[i];
     const IndexT intrinsicId = _sfmData.getViews().at(viewId)->getIntrinsicId();
     const bool isIntrinsicsReconstructed = reconstructedIntrinsics.count(intrinsicId);
 
-    // Compute 2D - 3D possible content
-    const aliceVision::track::TrackIdSet& set_tracksIds = _map_tracksPerView.at(viewId);
-    if (set_tracksIds.empty())
+    // Views without any track have no scoring data
+    const auto scoringIt = _nbvViewScoring.find(viewId);
+    if(scoringIt == _nbvViewScoring.end())
       continue;
 
     // Check if the view is part of a rig
@@ -909,31 +1032,145 @@ bool ReconstructionEngine_sequentialSfM::findConnectedViews(
       }
     }
 
-    // Count the common possible putative point
-    //  with the already 3D reconstructed trackId
-    std::vector<std::size_t> vec_trackIdForResection;
-    vec_trackIdForResection.reserve(set_tracksIds.size());
-    std::set_intersection(set_tracksIds.begin(), set_tracksIds.end(),
-                          reconstructed_trackId.begin(),
-                          reconstructed_trackId.end(),
-                          std::back_inserter(vec_trackIdForResection));
     // Compute an image score based on the number of matches to the 3D scene
     // and the repartition of these features in the image.
-    std::size_t score = computeCandidateImageScore(viewId, vec_trackIdForResection);
-#pragma omp critical
-    {
-      out_connectedViews.emplace_back(viewId, vec_trackIdForResection.size(), score, isIntrinsicsReconstructed);
-    }
+    const ViewScoringData& scoringData = scoringIt->second;
+    viewsScore[i] = ViewConnectionScore(viewId, scoringData.nbReconstructedTracks, computeCandidateImageScore(scoringData), isIntrinsicsReconstructed);
+    isConnectedView[i] = 1;
   }
 
-  // Sort by the image score
-  std::sort(out_connectedViews.begin(), out_connectedViews.end(),
+  for(std::size_t i = 0; i < viewIds.size(); ++i)
+  {
+    if(isConnectedView[i])
+      out_connectedViews.push_back(viewsScore[i]);
+  }
+
+  // Sort by the image score, ties keep the view ids order
+  std::stable_sort(out_connectedViews.begin(), out_connectedViews.end(),
             [](const ViewConnectionScore& t1, const ViewConnectionScore& t2) {
     return std::get<2>(t1) > std::get<2>(t2);
   });
   return !out_connectedViews.empty();
 }
 
+void ReconstructionEngine_sequentialSfM::updateNextBestViewScoring(const std::set<IndexT>& remainingViewIds) const
+{
+  if(_nbvIsTrackReconstructed.size() != _map_tracks.size())
+  {
+    // new tracks, reset the cache
+    _nbvIsTrackReconstructed.assign(_map_tracks.size(), 0);
+    _nbvReconstructedTracks.clear();
+    _nbvViewScoring.clear();
+  }
+
+  // Find the tracks reconstructed or removed since the last update (landmarkId == trackId),
+  // the landmarks are not sorted if HashMap is an unordered map.
+  std::vector<IndexT> reconstructedTracks;
+  std::vector<IndexT> addedTracks;
+  std::vector<IndexT> removedTracks;
+  reconstructedTracks.reserve(_sfmData.getLandmarks().size());
+  for(const auto& landmarkPair : _sfmData.getLandmarks())
+  {
+    if(landmarkPair.first < _map_tracks.size())
+      reconstructedTracks.push_back(landmarkPair.first);
+  }
+  std::sort(reconstructedTracks.begin(), reconstructedTracks.end());
+
+  std::set_difference(reconstructedTracks.begin(), reconstructedTracks.end(),
+                      _nbvReconstructedTracks.begin(), _nbvReconstructedTracks.end(),
+                      std::back_inserter(addedTracks));
+  std::set_difference(_nbvReconstructedTracks.begin(), _nbvReconstructedTracks.end(),
+                      reconstructedTracks.begin(), reconstructedTracks.end(),
+                      std::back_inserter(removedTracks));
+  _nbvReconstructedTracks.swap(reconstructedTracks);
+
+  for(IndexT trackId : addedTracks)
+    _nbvIsTrackReconstructed[trackId] = 1;
+  for(IndexT trackId : removedTracks)
+    _nbvIsTrackReconstructed[trackId] = 0;
+
+  // Forget the views which are no longer remaining
+  for(auto it = _nbvViewScoring.begin(); it != _nbvViewScoring.end();)
+  {
+    if(remainingViewIds.count(it->first))
+      ++it;
+    else
+      it = _nbvViewScoring.erase(it);
+  }
+
+  // Apply the modified tracks to the views already scored
+  for(const std::vector<IndexT>* modifiedTracks : {&addedTracks, &removedTracks})
+  {
+    const bool add = (modifiedTracks == &addedTracks);
+    for(IndexT trackId : *modifiedTracks)
+    {
+      for(const auto& featView : _map_tracks.at(trackId).featPerView)
+      {
+        const auto scoringIt = _nbvViewScoring.find(featView.first);
+        if(scoringIt != _nbvViewScoring.end())
+          updateViewScoring(_map_featsPyramidPerView.at(featView.first), trackId, add, scoringIt->second);
+      }
+    }
+  }
+
+  // Initialize the new remaining views from all their reconstructed tracks
+  std::vector<IndexT> newViewIds;
+  for(IndexT viewId : remainingViewIds)
+  {
+    if(!_nbvViewScoring.count(viewId) && !_map_tracks.getViewTracks(viewId).empty())
+      newViewIds.push_back(viewId);
+  }
+  std::vector<ViewScoringData*> newViewsScoring(newViewIds.size());
+  for(std::size_t i = 0; i < newViewIds.size(); ++i)
+    newViewsScoring[i] = &_nbvViewScoring[newViewIds[i]];
+
+#pragma omp parallel for schedule(dynamic)
+  for(std::size_t i = 0; i < newViewIds.size(); ++i)
+  {
+    const IndexT viewId = newViewIds[i];
+    const auto& featsPyramid = _map_featsPyramidPerView.at(viewId);
+    for(IndexT trackId : _map_tracks.getViewTracks(viewId))
+    {
+      if(_nbvIsTrackReconstructed[trackId])
+        updateViewScoring(featsPyramid, trackId, true, *newViewsScoring[i]);
+    }
+  }
+
+  ALICEVISION_LOG_DEBUG("Next best view scoring update: " << addedTracks.size() << " new tracks, "
+                        << removedTracks.size() << " removed tracks, " << newViewIds.size() << " new views.");
+}
+
+void ReconstructionEngine_sequentialSfM::updateViewScoring(const stl::flat_map<std::size_t, std::size_t>& featsPyramid,
+                                                            std::size_t trackId,
+                                                            bool add,
+                                                            ViewScoringData& scoringData) const
+{
+  if(scoringData.cellsNbTracks.empty())
+  {
+    scoringData.cellsNbTracks.assign(_pyramidNbCells, 0);
+    scoringData.nbOccupiedCells.assign(_params.pyramidDepth, 0);
+  }
+
+  if(add)
+    ++scoringData.nbReconstructedTracks;
+  else
+    --scoringData.nbReconstructedTracks;
+
+  for(int level = 0; level < _params.pyramidDepth; ++level)
+  {
+    std::uint32_t& cellNbTracks = scoringData.cellsNbTracks[featsPyramid.at(trackId * _params.pyramidDepth + level)];
+    if(add)
+    {
+      if(cellNbTracks++ == 0)
+        ++scoringData.nbOccupiedCells[level];
+    }
+    else if(--cellNbTracks == 0)
+    {
+      --scoringData.nbOccupiedCells[level];
+    }
+  }
+}
+
 bool ReconstructionEngine_sequentialSfM::findNextBestViews(
   std::vector<IndexT> & out_selectedViewIds,
   const std::set<IndexT>& remainingViewIds) const
@@ -1029,10 +1266,8 @@ bool ReconstructionEngine_sequentialSfM::findNextBestViews(
 
   // Limit to a maximum number of cameras added to ensure that
   // we don't add too much data in one step without bundle adjustment.
-  static const std::size_t maxImagesPerGroup = 30;
-
-  if(out_selectedViewIds.size() > maxImagesPerGroup)
-    out_selectedViewIds.resize(maxImagesPerGroup);
+  if(out_selectedViewIds.size() > _params.maxImagesPerGroup)
+    out_selectedViewIds.resize(_params.maxImagesPerGroup);
 
   ALICEVISION_LOG_DEBUG(
     "Find next best views took: " << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - chrono_start).count() << " msec\n"
@@ -1338,7 +1573,14 @@ bool ReconstructionEngine_sequentialSfM::getBestInitialImagePairs(std::vector<Pa
             vec_angles.begin() + median_index,
             vec_angles.end());
       const float scoring_angle = vec_angles[median_index];
-      const double imagePairScore = std::min(computeCandidateImageScore(I, validCommonTracksIds), computeCandidateImageScore(J, validCommonTracksIds));
+      ViewScoringData scoringDataI;
+      ViewScoringData scoringDataJ;
+      for(const std::size_t trackId : validCommonTracksIds)
+      {
+        updateViewScoring(_map_featsPyramidPerView.at(I), trackId, true, scoringDataI);
+        updateViewScoring(_map_featsPyramidPerView.at(J), trackId, true, scoringDataJ);
+      }
+      const double imagePairScore = std::min(computeCandidateImageScore(scoringDataI), computeCandidateImageScore(scoringDataJ));
       double score = scoring_angle * imagePairScore;
 
       // If the image pair is outside the reasonable angle range: [fRequired_min_angle;fLimit_max_angle]
@@ -1377,25 +1619,16 @@ bool ReconstructionEngine_sequentialSfM::getBestInitialImagePairs(std::vector<Pa
   return true;
 }
 
-std::size_t ReconstructionEngine_sequentialSfM::computeCandidateImageScore(IndexT viewId, const std::vector<std::size_t>& trackIds) const
+std::size_t ReconstructionEngine_sequentialSfM::computeCandidateImageScore(const ViewScoringData& scoringData) const
 {
 #ifdef ALICEVISION_NEXTBESTVIEW_WITHOUT_SCORE
-  return trackIds.size();
+  return scoringData.nbReconstructedTracks;
 #else
   std::size_t score = 0;
   // The number of cells of the pyramid grid represent the score
   // and ensure a proper repartition of features in images.
-  const auto& featsPyramid = _map_featsPyramidPerView.at(viewId);
-  for(std::size_t level = 0; level < _params.pyramidDepth; ++level)
-  {
-    std::set<std::size_t> featIndexes; // Set of grid cell indexes in the pyramid
-    for(IndexT trackId: trackIds)
-    {
-      std::size_t pyramidIndex = featsPyramid.at(trackId * _params.pyramidDepth + level);
-      featIndexes.insert(pyramidIndex);
-    }
-    score += featIndexes.size() * _pyramidWeights[level];
-  }
+  for(std::size_t level = 0; level < scoringData.nbOccupiedCells.size(); ++level)
+    score += scoringData.nbOccupiedCells[level] * _pyramidWeights[level];
   return score;
 #endif
 }
@@ -1412,7 +1645,7 @@ std::size_t ReconstructionEngine_sequentialSfM::computeCandidateImageScore(Index
  * C. Do the resectioning: compute the camera pose.
  * D. Refine the pose of the found camera
  */
-bool ReconstructionEngine_sequentialSfM::computeResection(const IndexT viewId, ResectionData& resectionData)
+bool ReconstructionEngine_sequentialSfM::computeResection(const IndexT viewId, ResectionData& resectionData) const
 {
   using namespace track;
 
@@ -1453,7 +1686,10 @@ bool ReconstructionEngine_sequentialSfM::computeResection(const IndexT viewId, R
   
   // B. Look if intrinsic data is known or not
   const View * view_I = _sfmData.getViews().at(viewId).get();
-  resectionData.optionalIntrinsic = _sfmData.getIntrinsicsharedPtr(view_I->getIntrinsicId());
+  // work on a copy of the intrinsic, the scene is updated in updateScene
+  const std::shared_ptr<camera::IntrinsicBase> intrinsic = _sfmData.getIntrinsicsharedPtr(view_I->getIntrinsicId());
+  if(intrinsic != nullptr)
+    resectionData.optionalIntrinsic.reset(intrinsic->clone());
   
   std::size_t cpt = 0;
   std::set<std::size_t>::const_iterator iterTrackId = resectionData.tracksId.begin();
@@ -1482,10 +1718,6 @@ bool ReconstructionEngine_sequentialSfM::computeResection(const IndexT viewId, R
   {
     using namespace htmlDocument;
     std::ostringstream os;
-    os << "Robust resection of view " << viewId << ": <br>";
-    _htmlDocStream->pushInfo(htmlMarkup("h4",os.str()));
-
-    os.str("");
     os << std::endl
       << "- Image path: " << view_I->getImagePath() << "<br>"
       << "- Threshold (error max): " << resectionData.error_max << "<br>"
@@ -1495,7 +1727,14 @@ bool ReconstructionEngine_sequentialSfM::computeResection(const IndexT viewId, R
       << "- % points validated: "
       << resectionData.vec_inliers.size()/static_cast<float>(resectionData.featuresId.size()) << "<br>";
 
-    _htmlDocStream->pushInfo(os.str());
+    // the resections can run concurrently
+#pragma omp critical(htmlDocStream)
+    {
+      std::ostringstream title;
+      title << "Robust resection of view " << viewId << ": <br>";
+      _htmlDocStream->pushInfo(htmlMarkup("h4",title.str()));
+      _htmlDocStream->pushInfo(os.str());
+    }
   }
   
   if (!bResection)
@@ -1537,9 +1776,11 @@ bool ReconstructionEngine_sequentialSfM::computeResection(const IndexT viewId, R
     // If we use a camera intrinsic for the first time we need to refine it.
     const bool intrinsicsFirstUsage = (reconstructedIntrinsics.count(view_I->getIntrinsicId()) == 0);
 
+    resectionData.isIntrinsicRefined = resectionData.isNewIntrinsic || intrinsicsFirstUsage;
+
     if(!sfm::SfMLocalizer::RefinePose(
       resectionData.optionalIntrinsic.get(), resectionData.pose,
-      resectionData, true, resectionData.isNewIntrinsic || intrinsicsFirstUsage))
+      resectionData, true, resectionData.isIntrinsicRefined))
     {
       ALICEVISION_LOG_INFO("Resection of view " << viewId << " failed during pose refinement.");
       return false;
@@ -1558,18 +1799,28 @@ void ReconstructionEngine_sequentialSfM::updateScene(const IndexT viewIndex, con
   const View& view = *_sfmData.views.at(viewIndex);
   _sfmData.setPose(view, CameraPose(resectionData.pose));
 
+  // the resection has estimated a copy of the intrinsic
+  if(resectionData.isIntrinsicRefined)
+    _sfmData.getIntrinsics().at(view.getIntrinsicId())->assign(*resectionData.optionalIntrinsic);
+
   // B. Update the observations into the global scene structure
   // - Add the new 2D observations to the reconstructed tracks
   std::set<std::size_t>::const_iterator iterTrackId = resectionData.tracksId.begin();
-  for (std::size_t i = 0; i < resectionData.pt2D.cols(); ++i, ++iterTrackId)
+  for (Eigen::Index i = 0; i < resectionData.pt2D.cols(); ++i, ++iterTrackId)
   {
-    const Vec3 X = resectionData.pt3D.col(i);
+    // the landmark may have been removed or moved by the triangulation done during the resection (pipelined mode),
+    // the inliers are checked against the current scene
+    const auto landmarkIt = _sfmData.structure.find(*iterTrackId);
+    if(landmarkIt == _sfmData.structure.end())
+      continue;
+
+    Landmark& landmark = landmarkIt->second;
+    const Vec3& X = landmark.X;
     const Vec2 x = resectionData.pt2D.col(i);
     const Vec2 residual = resectionData.optionalIntrinsic->residual(resectionData.pose, X, x);
     if (residual.norm() < resectionData.error_max &&
         resectionData.pose.depth(X) > 0)
     {
-      Landmark& landmark = _sfmData.structure[*iterTrackId];
       const IndexT idFeat = resectionData.featuresId[i].second;
       const double scale = (_params.featureConstraint == EFeatureConstraint::BASIC) ? 0.0 : _featuresPerView->getFeatures(viewIndex, landmark.descType)[idFeat].scale();
       // Inlier, add the point to the reconstructed track
@@ -1578,41 +1829,6 @@ void ReconstructionEngine_sequentialSfM::updateScene(const IndexT viewIndex, con
   }
 }
 
-bool ReconstructionEngine_sequentialSfM::checkChieralities(
-  const Vec3& pt3D, 
-  const std::set<IndexT> & viewsId, 
-  const SfMData& scene)
-{
-  for (const IndexT & viewId : viewsId)
-  {
-    const View* view = scene.getViews().at(viewId).get();
-    const Pose3 pose = scene.getPose(*view).getTransform();
-    // Check that the point is in front of all the cameras.
-    if (pose.depth(pt3D) < 0) 
-      return false;
-  }
-  return true;
-}
-
-bool ReconstructionEngine_sequentialSfM::checkAngles(const Vec3 &pt3D, const std::set<IndexT> &viewsId, const SfMData &scene, const double &kMinAngle)
-{ 
-  for (const std::size_t & viewIdA : viewsId)
-  {
-    for (const std::size_t & viewIdB : viewsId)
-    {
-      if (viewIdA < viewIdB)
-      {
-        double angle_deg = angleBetweenRays(scene.getPose(*scene.getViews().at(viewIdA).get()).getTransform(),
-                                           scene.getPose(*scene.getViews().at(viewIdB).get()).getTransform(),
-                                           pt3D);
-        if (angle_deg >= kMinAngle)
-          return true;
-      }
-    }
-  }
-  return false;
-}
-
 void ReconstructionEngine_sequentialSfM::getTracksToTriangulate(const std::set<IndexT>& previousReconstructedViews, 
                                                                 const std::set<IndexT>& newReconstructedViews, 
                                                                 std::map<IndexT, std::set<IndexT>> & mapTracksToTriangulate) const
@@ -1623,206 +1839,236 @@ void ReconstructionEngine_sequentialSfM::getTracksToTriangulate(const std::set<I
   
   std::set<IndexT> allTracksInNewViews;
   track::getTracksInImagesFast(newReconstructedViews, _map_tracksPerView, allTracksInNewViews);
-  
-  std::set<IndexT>::iterator it;
-#pragma omp parallel private(it)
+
+  // observations of a track are contiguous and sorted by view id
+  const std::vector<IndexT> reconstructedViews(allReconstructedViews.begin(), allReconstructedViews.end());
+  const std::vector<IndexT> tracksIds(allTracksInNewViews.begin(), allTracksInNewViews.end());
+  std::vector<std::vector<IndexT>> reconstructedViewsPerTrack(tracksIds.size());
+
+#pragma omp parallel for schedule(dynamic, 256)
+  for(std::size_t i = 0; i < tracksIds.size(); ++i)
   {
-    for (it = allTracksInNewViews.begin(); it != allTracksInNewViews.end(); ++it)
+    const track::TrackRef track = _map_tracks.at(tracksIds[i]);
+    std::vector<IndexT>& allReconstructedViewsSharingTheTrack = reconstructedViewsPerTrack[i];
+
+    for(const auto& featView : track.featPerView)
     {
-#pragma omp single nowait
-      {
-        const std::size_t trackId = *it;
-        
-        const track::Track& track = _map_tracks.at(trackId);
-        
-        std::set<IndexT> allViewsSharingTheTrack;
-        std::transform(track.featPerView.begin(), track.featPerView.end(),
-                       std::inserter(allViewsSharingTheTrack, allViewsSharingTheTrack.begin()),
-                       stl::RetrieveKey());
-        
-        std::set<IndexT> allReconstructedViewsSharingTheTrack;
-        std::set_intersection(allViewsSharingTheTrack.begin(), allViewsSharingTheTrack.end(),
-                              allReconstructedViews.begin(), allReconstructedViews.end(),
-                              std::inserter(allReconstructedViewsSharingTheTrack, allReconstructedViewsSharingTheTrack.begin()));
-        
-        if (allReconstructedViewsSharingTheTrack.size() >= _params.minNbObservationsForTriangulation)
-        {
-#pragma omp critical        
-          mapTracksToTriangulate[trackId] = allReconstructedViewsSharingTheTrack;
-        }
-      }
+      if(std::binary_search(reconstructedViews.begin(), reconstructedViews.end(), featView.first))
+        allReconstructedViewsSharingTheTrack.push_back(featView.first);
     }
   }
+
+  for(std::size_t i = 0; i < tracksIds.size(); ++i)
+  {
+    const std::vector<IndexT>& allReconstructedViewsSharingTheTrack = reconstructedViewsPerTrack[i];
+    if(allReconstructedViewsSharingTheTrack.size() >= _params.minNbObservationsForTriangulation)
+      mapTracksToTriangulate.emplace_hint(mapTracksToTriangulate.end(), tracksIds[i],
+                                          std::set<IndexT>(allReconstructedViewsSharingTheTrack.begin(), allReconstructedViewsSharingTheTrack.end()));
+  }
 }
 
 void ReconstructionEngine_sequentialSfM::triangulate_multiViewsLORANSAC(SfMData& scene, const std::set<IndexT>& previousReconstructedViews, const std::set<IndexT>& newReconstructedViews)
 {
   ALICEVISION_LOG_DEBUG("Triangulating (mode: multi-view LO-RANSAC)... ");
 
+  TriangulationData triangulationData;
+  prepareTriangulation(previousReconstructedViews, newReconstructedViews, triangulationData);
+
+#pragma omp parallel for
+  for (std::size_t i = 0; i < triangulationData.tracksIds.size(); i++) // each track (already reconstructed or not)
+  {
+    const int threadId = omp_get_thread_num();
+    triangulateTrack_multiViewsLORANSAC(scene, triangulationData.tracksIds[i], triangulationData.observations[i],
+                                        triangulationData.landmarksBuffers[threadId], triangulationData.landmarksToCheck[threadId]);
+  }
+
+  applyTriangulation(scene, triangulationData);
+}
+
+void ReconstructionEngine_sequentialSfM::prepareTriangulation(const std::set<IndexT>& previousReconstructedViews,
+                                                              const std::set<IndexT>& newReconstructedViews,
+                                                              TriangulationData& triangulationData) const
+{
   // -- Identify the track to triangulate :
   // This map contains all the tracks that will be triangulated (for the first time, or not)
-  // These tracks are seen by at least one new reconstructed view.  
-  std::map<IndexT, std::set<IndexT>> mapTracksToTriangulate; // <trackId, observations> 
+  // These tracks are seen by at least one new reconstructed view.
+  std::map<IndexT, std::set<IndexT>> mapTracksToTriangulate; // <trackId, observations>
   getTracksToTriangulate(previousReconstructedViews, newReconstructedViews, mapTracksToTriangulate);
-  
-  std::vector<IndexT> setTracksId; // <trackId>
-  std::transform(mapTracksToTriangulate.begin(), mapTracksToTriangulate.end(),
-                 std::inserter(setTracksId, setTracksId.begin()),
-                 stl::RetrieveKey());
 
-#pragma omp parallel for 
-  for (int i = 0; i < setTracksId.size(); i++) // each track (already reconstructed or not)
+  triangulationData.tracksIds.clear();
+  triangulationData.observations.clear();
+  triangulationData.tracksIds.reserve(mapTracksToTriangulate.size());
+  triangulationData.observations.reserve(mapTracksToTriangulate.size());
+  for(auto& trackPair : mapTracksToTriangulate)
   {
-    const IndexT trackId = setTracksId.at(i);
-    bool isValidTrack = true;
-    const track::Track& track = _map_tracks.at(trackId);
-    std::set<IndexT>& observations = mapTracksToTriangulate.at(trackId); // all the posed views possessing the track
-    
-    // The track needs to be seen by a min. number of views to be triangulated
-    if (observations.size() < _params.minNbObservationsForTriangulation)
-      continue;
-    
-    Vec3 X_euclidean = Vec3::Zero();
-    std::set<IndexT> inliers;
-    
-    if (observations.size() == 2) 
-    {
-      /* --------------------------------------------
-       *    2 observations : triangulation using DLT
-       * -------------------------------------------- */ 
-       
-      inliers = observations;
-      
-      // -- Prepare:
-      IndexT I =  *(observations.begin());
-      IndexT J =  *(observations.rbegin());
-      const View* viewI = scene.getViews().at(I).get();
-      const View* viewJ = scene.getViews().at(J).get();
+    triangulationData.tracksIds.push_back(trackPair.first);
+    triangulationData.observations.push_back(std::move(trackPair.second));
+  }
 
-      std::shared_ptr<camera::IntrinsicBase> camI = scene.getIntrinsics().at(viewI->getIntrinsicId());
-      std::shared_ptr<camera::Pinhole> camIPinHole = std::dynamic_pointer_cast<camera::Pinhole>(camI);
-      if (!camIPinHole) {
-        ALICEVISION_LOG_ERROR("Camera is not pinhole in triangulate_multiViewsLORANSAC");
-        continue;
-      }
+  // one result buffer per thread
+  const int nbThreads = omp_get_max_threads();
+  triangulationData.landmarksBuffers.assign(nbThreads, LandmarksBuffer());
+  triangulationData.landmarksToCheck.assign(nbThreads, std::vector<std::size_t>());
+}
 
-      std::shared_ptr<camera::IntrinsicBase> camJ = scene.getIntrinsics().at(viewJ->getIntrinsicId());
-      std::shared_ptr<camera::Pinhole> camJPinHole = std::dynamic_pointer_cast<camera::Pinhole>(camJ);
-      if (!camJPinHole) {
-        ALICEVISION_LOG_ERROR("Camera is not pinhole in triangulate_multiViewsLORANSAC");
-        continue;
-      }
+void ReconstructionEngine_sequentialSfM::triangulateTrack_multiViewsLORANSAC(const SfMData& scene,
+                                                                             IndexT trackId,
+                                                                             const std::set<IndexT>& observations,
+                                                                             LandmarksBuffer& landmarks,
+                                                                             std::vector<std::size_t>& landmarksToCheck) const
+{
+  const track::TrackRef track = _map_tracks.at(trackId);
 
-      const Pose3 poseI = scene.getPose(*viewI).getTransform();
-      const Pose3 poseJ = scene.getPose(*viewJ).getTransform();
-      const Vec2 xI = _featuresPerView->getFeatures(I, track.descType)[track.featPerView.at(I)].coords().cast<double>();
-      const Vec2 xJ = _featuresPerView->getFeatures(J, track.descType)[track.featPerView.at(J)].coords().cast<double>();
+  Vec3 X_euclidean = Vec3::Zero();
+  std::set<IndexT> inliers;
   
-      // -- Triangulate:
-      multiview::TriangulateDLT(camIPinHole->getProjectiveEquivalent(poseI),
-                     camI->get_ud_pixel(xI),
-                     camJPinHole->getProjectiveEquivalent(poseJ),
-                     camI->get_ud_pixel(xJ),
-                     &X_euclidean);
-
-      // -- Check:
-      //  - angle (small angle leads imprecise triangulation)
-      //  - positive depth
-      //  - residual values
-      // TODO assert(acThresholdIt != _map_ACThreshold.end());
-      const auto& acThresholdItI = _map_ACThreshold.find(I);
-      const auto& acThresholdItJ = _map_ACThreshold.find(J);
-      const double& acThresholdI = (acThresholdItI != _map_ACThreshold.end()) ? acThresholdItI->second : 4.0;
-      const double& acThresholdJ = (acThresholdItJ != _map_ACThreshold.end()) ? acThresholdItJ->second : 4.0;
-      
-      if (angleBetweenRays(poseI, camI.get(), poseJ, camJ.get(), xI, xJ) < _params.minAngleForTriangulation ||
-          poseI.depth(X_euclidean) < 0 || 
-          poseJ.depth(X_euclidean) < 0 || 
-          camI->residual(poseI, X_euclidean, xI).norm() > acThresholdI || 
-          camJ->residual(poseJ, X_euclidean, xJ).norm() > acThresholdJ)
-        isValidTrack = false;
+  if (observations.size() == 2) 
+  {
+    /* --------------------------------------------
+     *    2 observations : triangulation using DLT
+     * -------------------------------------------- */ 
+     
+    inliers = observations;
+    
+    // -- Prepare:
+    IndexT I =  *(observations.begin());
+    IndexT J =  *(observations.rbegin());
+    const View* viewI = scene.getViews().at(I).get();
+    const View* viewJ = scene.getViews().at(J).get();
+
+    std::shared_ptr<camera::IntrinsicBase> camI = scene.getIntrinsics().at(viewI->getIntrinsicId());
+    std::shared_ptr<camera::Pinhole> camIPinHole = std::dynamic_pointer_cast<camera::Pinhole>(camI);
+    if (!camIPinHole) {
+      ALICEVISION_LOG_ERROR("Camera is not pinhole in triangulate_multiViewsLORANSAC");
+      landmarks.addInvalidLandmark(trackId);
+      return;
+    }
+
+    std::shared_ptr<camera::IntrinsicBase> camJ = scene.getIntrinsics().at(viewJ->getIntrinsicId());
+    std::shared_ptr<camera::Pinhole> camJPinHole = std::dynamic_pointer_cast<camera::Pinhole>(camJ);
+    if (!camJPinHole) {
+      ALICEVISION_LOG_ERROR("Camera is not pinhole in triangulate_multiViewsLORANSAC");
+      landmarks.addInvalidLandmark(trackId);
+      return;
     }
-    else 
+
+    const Pose3 poseI = scene.getPose(*viewI).getTransform();
+    const Pose3 poseJ = scene.getPose(*viewJ).getTransform();
+    const Vec2 xI = _featuresPerView->getFeatures(I, track.descType)[track.featPerView.at(I)].coords().cast<double>();
+    const Vec2 xJ = _featuresPerView->getFeatures(J, track.descType)[track.featPerView.at(J)].coords().cast<double>();
+
+    // -- Triangulate:
+    multiview::TriangulateDLT(camIPinHole->getProjectiveEquivalent(poseI),
+                   camI->get_ud_pixel(xI),
+                   camJPinHole->getProjectiveEquivalent(poseJ),
+                   camI->get_ud_pixel(xJ),
+                   &X_euclidean);
+
+    // -- Check:
+    //  - angle (small angle leads imprecise triangulation)
+    //  - positive depth
+    //  - residual values
+    // TODO assert(acThresholdIt != _map_ACThreshold.end());
+    const auto& acThresholdItI = _map_ACThreshold.find(I);
+    const auto& acThresholdItJ = _map_ACThreshold.find(J);
+    const double& acThresholdI = (acThresholdItI != _map_ACThreshold.end()) ? acThresholdItI->second : 4.0;
+    const double& acThresholdJ = (acThresholdItJ != _map_ACThreshold.end()) ? acThresholdItJ->second : 4.0;
+    
+    if (angleBetweenRays(poseI, camI.get(), poseJ, camJ.get(), xI, xJ) < _params.minAngleForTriangulation ||
+        poseI.depth(X_euclidean) < 0 || 
+        poseJ.depth(X_euclidean) < 0 || 
+        camI->residual(poseI, X_euclidean, xI).norm() > acThresholdI || 
+        camJ->residual(poseJ, X_euclidean, xJ).norm() > acThresholdJ)
     {
-      /* -------------------------------------------------------
-       *    N obsevations (N>2) : triangulation using LORANSAC 
-       * ------------------------------------------------------- */ 
-     
-      // -- Prepare:
-      Mat2X features(2, observations.size()); // undistorted 2D features (one per pose)
-      std::vector<Mat34> Ps; // projective matrices (one per pose)
+      landmarks.addInvalidLandmark(trackId);
+      return;
+    }
+  }
+  else 
+  {
+    /* -------------------------------------------------------
+     *    N obsevations (N>2) : triangulation using LORANSAC 
+     * ------------------------------------------------------- */ 
+   
+    // -- Prepare:
+    Mat2X features(2, observations.size()); // undistorted 2D features (one per pose)
+    std::vector<Mat34> Ps; // projective matrices (one per pose)
+    {
+      const track::TrackRef track = _map_tracks.at(trackId);
+      
+      int i = 0;
+      for (const IndexT& viewId : observations)
       {
-        const track::Track& track = _map_tracks.at(trackId);
-        
-        int i = 0;
-        for (const IndexT& viewId : observations)
-        {
-          const View* view = scene.getViews().at(viewId).get();
-  
-          std::shared_ptr<camera::IntrinsicBase> cam = scene.getIntrinsics().at(view->getIntrinsicId());
-          std::shared_ptr<camera::Pinhole> camPinHole = std::dynamic_pointer_cast<camera::Pinhole>(cam);
-          if (!camPinHole) {
-            ALICEVISION_LOG_ERROR("Camera is not pinhole in triangulate_multiViewsLORANSAC");
-            continue;
-          }
+        const View* view = scene.getViews().at(viewId).get();
 
-          const Vec2 x_ud = cam->get_ud_pixel(_featuresPerView->getFeatures(viewId, track.descType)[track.featPerView.at(viewId)].coords().cast<double>()); // undistorted 2D point
-          features(0,i) = x_ud(0); 
-          features(1,i) = x_ud(1);  
-          Ps.push_back(camPinHole->getProjectiveEquivalent(scene.getPose(*view).getTransform()));
-          i++;
+        std::shared_ptr<camera::IntrinsicBase> cam = scene.getIntrinsics().at(view->getIntrinsicId());
+        std::shared_ptr<camera::Pinhole> camPinHole = std::dynamic_pointer_cast<camera::Pinhole>(cam);
+        if (!camPinHole) {
+          ALICEVISION_LOG_ERROR("Camera is not pinhole in triangulate_multiViewsLORANSAC");
+          continue;
         }
+
+        const Vec2 x_ud = cam->get_ud_pixel(_featuresPerView->getFeatures(viewId, track.descType)[track.featPerView.at(viewId)].coords().cast<double>()); // undistorted 2D point
+        features(0,i) = x_ud(0); 
+        features(1,i) = x_ud(1);  
+        Ps.push_back(camPinHole->getProjectiveEquivalent(scene.getPose(*view).getTransform()));
+        i++;
       }
-      
-      // -- Triangulate: 
-      Vec4 X_homogeneous = Vec4::Zero();
-      std::vector<std::size_t> inliersIndex;
-      
-      multiview::TriangulateNViewLORANSAC(features, Ps, &X_homogeneous, &inliersIndex, 8.0);
-      
-      homogeneousToEuclidean(X_homogeneous, &X_euclidean);     
-      
-      // observations = {350, 380, 442} | inliersIndex = [0, 1] | inliers = {350, 380}
-      for (const auto & id : inliersIndex)
-        inliers.insert(*std::next(observations.begin(), id));
-
-      // -- Check:
-      //  - nb of cameras validing the track 
-      //  - angle (small angle leads imprecise triangulation)
-      //  - positive depth (chierality)
-      if (inliers.size() < _params.minNbObservationsForTriangulation ||
-          !checkAngles(X_euclidean, inliers, scene, _params.minAngleForTriangulation) ||
-          !checkChieralities(X_euclidean, inliers, scene))
-        isValidTrack = false;
-    }  
-
-    // -- Add the tringulated point to the scene
-    if (isValidTrack)
-    {
-      Landmark landmark;
-      landmark.X = X_euclidean;
-      landmark.descType = track.descType;
-      for (const IndexT & viewId : inliers) // add inliers as observations
-      {
-        const Vec2 x = _featuresPerView->getFeatures(viewId, track.descType)[track.featPerView.at(viewId)].coords().cast<double>();
-        const feature::PointFeature& p = _featuresPerView->getFeatures(viewId, track.descType)[track.featPerView.at(viewId)];
-        const double scale = (_params.featureConstraint == EFeatureConstraint::BASIC) ? 0.0 : p.scale();
-        landmark.observations[viewId] = Observation(x, track.featPerView.at(viewId), scale);
-      }
-#pragma omp critical
-      {
-        scene.structure[trackId] = landmark;
-      }      
     }
-    else
+    
+    // -- Triangulate: 
+    Vec4 X_homogeneous = Vec4::Zero();
+    std::vector<std::size_t> inliersIndex;
+    
+    multiview::TriangulateNViewLORANSAC(features, Ps, &X_homogeneous, &inliersIndex, 8.0);
+    
+    homogeneousToEuclidean(X_homogeneous, &X_euclidean);     
+    
+    // observations = {350, 380, 442} | inliersIndex = [0, 1] | inliers = {350, 380}
+    for (const auto & id : inliersIndex)
+      inliers.insert(*std::next(observations.begin(), id));
+
+    // -- Check:
+    //  - nb of cameras validing the track 
+    // angle (small angle leads imprecise triangulation) and positive depth (chierality)
+    // are checked by batch in applyTriangulation
+    if (inliers.size() < _params.minNbObservationsForTriangulation)
     {
-#pragma omp critical
-      {
-        if (scene.structure.find(trackId) != scene.structure.end()) 
-          scene.structure.erase(trackId);
-      }
+      landmarks.addInvalidLandmark(trackId);
+      return;
     }
-  } // for all shared tracks 
+    landmarksToCheck.push_back(landmarks.size());
+  }  
+
+  // -- Fill the tringulated point
+  landmarks.addLandmark(trackId, X_euclidean, track.descType);
+  for (const IndexT & viewId : inliers) // add inliers as observations
+  {
+    const Vec2 x = _featuresPerView->getFeatures(viewId, track.descType)[track.featPerView.at(viewId)].coords().cast<double>();
+    const feature::PointFeature& p = _featuresPerView->getFeatures(viewId, track.descType)[track.featPerView.at(viewId)];
+    const double scale = (_params.featureConstraint == EFeatureConstraint::BASIC) ? 0.0 : p.scale();
+    landmarks.addObservation(viewId, Observation(x, track.featPerView.at(viewId), scale));
+  }
+}
+
+void ReconstructionEngine_sequentialSfM::applyTriangulation(SfMData& scene, TriangulationData& triangulationData) const
+{
+  const ViewsGeometry viewsGeometry(scene);
+
+  // -- Check the landmarks triangulated from more than 2 views:
+  //  - angle (small angle leads imprecise triangulation)
+  //  - positive depth (chierality)
+#pragma omp parallel for
+  for(std::size_t t = 0; t < triangulationData.landmarksBuffers.size(); ++t)
+  {
+    LandmarksBuffer& landmarks = triangulationData.landmarksBuffers[t];
+    const std::vector<std::size_t>& landmarksToCheck = triangulationData.landmarksToCheck[t];
+
+    checkAngles(landmarks, landmarksToCheck, viewsGeometry, _params.minAngleForTriangulation);
+    checkChieralities(landmarks, landmarksToCheck, viewsGeometry);
+  }
+
+  mergeLandmarksBuffers(triangulationData.landmarksBuffers, scene.structure);
 }
 
 void ReconstructionEngine_sequentialSfM::triangulate_2Views(SfMData& scene, const std::set<IndexT>& previousReconstructedViews, const std::set<IndexT>& newReconstructedViews)
@@ -1843,12 +2089,35 @@ void ReconstructionEngine_sequentialSfM::triangulate_2Views(SfMData& scene, cons
   allReconstructedViews.insert(previousReconstructedViews.begin(), previousReconstructedViews.end());
   allReconstructedViews.insert(newReconstructedViews.begin(), newReconstructedViews.end());
 
+  // check if an observation can be added to an existing 3D point:
+  //  - positive depth
+  //  - residual value
+  const auto isObservationValid = [&](const Pose3& pose, const camera::IntrinsicBase& cam, IndexT viewId, const Vec3& X, const Vec2& x)
+  {
+    const Vec2 residual = cam.residual(pose, X, x);
+    // TODO: scale in residual
+    const auto& acThresholdIt = _map_ACThreshold.find(viewId);
+    // TODO assert(acThresholdIt != _map_ACThreshold.end());
+    const double acThreshold = (acThresholdIt != _map_ACThreshold.end()) ? acThresholdIt->second : 4.0;
+    return (pose.depth(X) > 0 && residual.norm() < std::max(4.0, acThreshold));
+  };
+
+  // the scene is only read by the threads, the results of each thread are merged afterwards:
+  //  - observations to add to the 3D points triangulated before
+  //  - new 3D points
+  const int nbThreads = omp_get_max_threads();
+  std::vector<LandmarksBuffer> extendedLandmarksPerThread(nbThreads);
+  std::vector<LandmarksBuffer> newLandmarksPerThread(nbThreads);
+
 #pragma omp parallel for schedule(dynamic)
   for (ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(allReconstructedViews.size()); ++i)
   {
     std::set<IndexT>::const_iterator iter = allReconstructedViews.begin();
     std::advance(iter, i);
     const IndexT indexAll = *iter;
+
+    LandmarksBuffer& extendedLandmarks = extendedLandmarksPerThread[omp_get_thread_num()];
+    LandmarksBuffer& newLandmarks = newLandmarksPerThread[omp_get_thread_num()];
     
     for(IndexT indexNew: newReconstructedViews)
     {
@@ -1884,7 +2153,6 @@ void ReconstructionEngine_sequentialSfM::triangulate_2Views(SfMData& scene, cons
       const Pose3 poseI = scene.getPose(*viewI).getTransform();
       const Pose3 poseJ = scene.getPose(*viewJ).getTransform();
       
-      std::size_t new_putative_track = 0, new_added_track = 0, extented_track = 0;
       for (const std::pair<std::size_t, track::Track >& trackIt : map_tracksCommonIJ)
       {
         const std::size_t trackId = trackIt.first;
@@ -1895,55 +2163,30 @@ void ReconstructionEngine_sequentialSfM::triangulate_2Views(SfMData& scene, cons
         
         const feature::PointFeature& featI = _featuresPerView->getFeatures(I, track.descType)[track.featPerView.at(I)];
         const feature::PointFeature& featJ = _featuresPerView->getFeatures(J, track.descType)[track.featPerView.at(J)];
+        const double scaleI = (_params.featureConstraint == EFeatureConstraint::BASIC) ? 0.0 : featI.scale();
+        const double scaleJ = (_params.featureConstraint == EFeatureConstraint::BASIC) ? 0.0 : featJ.scale();
+
         // test if the track already exists in 3D
-        bool trackIdExists;
-#pragma omp critical
-        {
-          trackIdExists = scene.structure.find(trackId) != scene.structure.end();
-        }
-        if (trackIdExists)
+        const auto landmarkIt = scene.structure.find(trackId);
+        if (landmarkIt != scene.structure.end())
         {
           // 3D point triangulated before, only add image observation if needed
-#pragma omp critical
+          const Landmark& landmark = landmarkIt->second;
+          const bool addI = (landmark.observations.count(I) == 0 && isObservationValid(poseI, *camI, I, landmark.X, xI));
+          const bool addJ = (landmark.observations.count(J) == 0 && isObservationValid(poseJ, *camJ, J, landmark.X, xJ));
+
+          if (addI || addJ)
           {
-            Landmark& landmark = scene.structure.at(trackId);
-            if (landmark.observations.count(I) == 0)
-            {
-              const Vec2 residual = camI->residual(poseI, landmark.X, xI);
-              // TODO: scale in residual
-              const auto& acThresholdIt = _map_ACThreshold.find(I);
-              // TODO assert(acThresholdIt != _map_ACThreshold.end());
-              const double acThreshold = (acThresholdIt != _map_ACThreshold.end()) ? acThresholdIt->second : 4.0;
-              if (poseI.depth(landmark.X) > 0 && residual.norm() < std::max(4.0, acThreshold))
-              {
-                const double scale = (_params.featureConstraint == EFeatureConstraint::BASIC) ? 0.0 : featI.scale();
-                landmark.observations[I] = Observation(xI, track.featPerView.at(I), scale);
-                ++extented_track;
-              }
-            }
-            if (landmark.observations.count(J) == 0)
-            {
-              const Vec2 residual = camJ->residual(poseJ, landmark.X, xJ);
-              const auto& acThresholdIt = _map_ACThreshold.find(J);
-              // TODO assert(acThresholdIt != _map_ACThreshold.end());
-              const double acThreshold = (acThresholdIt != _map_ACThreshold.end()) ? acThresholdIt->second : 4.0;
-              if (poseJ.depth(landmark.X) > 0 && residual.norm() < std::max(4.0, acThreshold))
-              {
-                const double scale = (_params.featureConstraint == EFeatureConstraint::BASIC) ? 0.0 : featJ.scale();
-                landmark.observations[J] = Observation(xJ, track.featPerView.at(J), scale);
-                ++extented_track;
-              }
-            }
+            extendedLandmarks.addLandmark(trackId, landmark.X, landmark.descType);
+            if (addI)
+              extendedLandmarks.addObservation(I, Observation(xI, track.featPerView.at(I), scaleI));
+            if (addJ)
+              extendedLandmarks.addObservation(J, Observation(xJ, track.featPerView.at(J), scaleJ));
           }
         }
         else
         {
           // A new 3D point must be added
-#pragma omp critical
-          {
-            ++new_putative_track;
-          }
-          
           Vec3 X_euclidean = Vec3::Zero();
           const Vec2 xI_ud = camI->get_ud_pixel(xI);
           const Vec2 xJ_ud = camJ->get_ud_pixel(xJ);
@@ -1974,33 +2217,57 @@ void ReconstructionEngine_sequentialSfM::triangulate_2Views(SfMData& scene, cons
               residualI.norm() < acThresholdI &&
               residualJ.norm() < acThresholdJ)
           {
-#pragma omp critical
-            {
-              // Add a new track
-              Landmark & landmark = scene.structure[trackId];
-              landmark.X = X_euclidean;
-              landmark.descType = track.descType;
-              
-              const double scaleI = (_params.featureConstraint == EFeatureConstraint::BASIC) ? 0.0 : featI.scale();
-              const double scaleJ = (_params.featureConstraint == EFeatureConstraint::BASIC) ? 0.0 : featJ.scale();
-              landmark.observations[I] = Observation(xI, track.featPerView.at(I), scaleI);
-              landmark.observations[J] = Observation(xJ, track.featPerView.at(J), scaleJ);
-              
-              ++new_added_track;
-            } // critical
+            // Add a new track
+            newLandmarks.addLandmark(trackId, X_euclidean, track.descType);
+            newLandmarks.addObservation(I, Observation(xI, track.featPerView.at(I), scaleI));
+            newLandmarks.addObservation(J, Observation(xJ, track.featPerView.at(J), scaleJ));
           } // 3D point is valid
         } // else (New 3D point)
       }// for all correspondences
     }
+  }
 
-//  #pragma omp critical
-//  if (!map_tracksCommonIJ.empty())
-//  {
-//    ALICEVISION_LOG_DEBUG("--Triangulated 3D points [" << I << "-" << J << "]:\n"
-//                      "\t#Track extented: " << extented_track << "\n"
-//                      "\t#Validated/#Possible: " << new_added_track << "/" << new_putative_track << "\n"
-//                      "\t#3DPoint for the entire scene: " << scene.getLandmarks().size());
-//  }
+  // add the observations of the 3D points triangulated before
+  for(const LandmarksBuffer& extendedLandmarks : extendedLandmarksPerThread)
+  {
+    for(std::size_t i = 0; i < extendedLandmarks.size(); ++i)
+    {
+      Landmark& landmark = scene.structure.at(extendedLandmarks.landmarksIds[i]);
+      for(std::size_t o = extendedLandmarks.observationsOffsets[i]; o < extendedLandmarks.observationsOffsets[i + 1]; ++o)
+        landmark.observations.emplace(extendedLandmarks.observationsViewIds[o], extendedLandmarks.observations[o]);
+    }
+  }
+
+  // add the new 3D points, a track triangulated by several pairs of views is created by the first one
+  // and extended with the observations of the others
+  for(const LandmarksBuffer& newLandmarks : newLandmarksPerThread)
+  {
+    for(std::size_t i = 0; i < newLandmarks.size(); ++i)
+    {
+      const IndexT trackId = newLandmarks.landmarksIds[i];
+      auto landmarkIt = scene.structure.find(trackId);
+
+      if(landmarkIt == scene.structure.end())
+      {
+        scene.structure.emplace(trackId, newLandmarks.getLandmark(i));
+        continue;
+      }
+
+      Landmark& landmark = landmarkIt->second;
+      for(std::size_t o = newLandmarks.observationsOffsets[i]; o < newLandmarks.observationsOffsets[i + 1]; ++o)
+      {
+        const IndexT viewId = newLandmarks.observationsViewIds[o];
+        const Observation& observation = newLandmarks.observations[o];
+
+        if(landmark.observations.count(viewId) != 0)
+          continue;
+
+        const View& view = *scene.getViews().at(viewId);
+        const camera::IntrinsicBase& cam = *scene.getIntrinsics().at(view.getIntrinsicId());
+        if(isObservationValid(scene.getPose(view).getTransform(), cam, viewId, landmark.X, observation.x))
+          landmark.observations.emplace(viewId, observation);
+      }
+    }
   }
 }
 
@@ -9,23 +9,29 @@
 
 #include <aliceVision/sfm/pipeline/ReconstructionEngine.hpp>
 #include <aliceVision/sfm/LocalBundleAdjustmentGraph.hpp>
+#include <aliceVision/sfm/LandmarksBuffer.hpp>
 #include <aliceVision/sfm/pipeline/localization/SfMLocalizer.hpp>
 #include <aliceVision/sfm/pipeline/pairwiseMatchesIO.hpp>
 #include <aliceVision/sfmDataIO/sfmDataIO.hpp>
 #include <aliceVision/feature/FeaturesPerView.hpp>
-#include <aliceVision/track/TracksBuilder.hpp>
+#include <aliceVision/track/TracksStore.hpp>
 #include <dependencies/htmlDoc/htmlDoc.hpp>
 #include <aliceVision/utils/Histogram.hpp>
 
 #include <boost/filesystem.hpp>
 #include <boost/property_tree/ptree.hpp>
 
+#include <cstdint>
+#include <unordered_map>
+
 namespace fs = boost::filesystem;
 namespace pt = boost::property_tree;
 
 namespace aliceVision {
 namespace sfm {
 
+class BundleAdjustmentCeres;
+
 /// Image score contains <ImageId, NbPutativeCommonPoint, score, isIntrinsicsReconstructed>
 typedef std::tuple<IndexT, std::size_t, std::size_t, bool> ViewConnectionScore;
 
@@ -43,6 +49,8 @@ public:
     int minPointsPerPose = 30;
     bool useLocalBundleAdjustment = false;
     int localBundelAdjustementGraphDistanceLimit = 1;
+    /// keep the bundle adjustment problem between the iterations and only update its outdated blocks
+    bool usePersistentBundleAdjustment = false;
 
     bool useRigConstraint = true;
 
@@ -62,6 +70,10 @@ public:
     robustEstimation::ERobustEstimator localizerEstimator = robustEstimation::ERobustEstimator::ACRANSAC;
     double localizerEstimatorError = std::numeric_limits<double>::infinity();
     size_t localizerEstimatorMaxIterations = 4096;
+    /// maximum number of images added in one resection group
+    std::size_t maxImagesPerGroup = 30;
+    /// resect the next group of images while the previous group is triangulated
+    bool pipelinedResection = false;
 
     // Pyramid scoring
 
@@ -157,6 +169,17 @@ public:
                              const std::set<IndexT>& prevReconstructedViews,
                              std::set<IndexT>& viewIds);
 
+  /**
+   * @brief Pipelined loop of reconstruction updates.
+   * The resection of a group of images is done at the same time as the triangulation of
+   * the previous group, both only read the scene. The results are merged in a single pass
+   * followed by one bundle adjustment.
+   * The new images are thus localized without the points triangulated from the previous group.
+   * @param[in,out] resectionId The resection id
+   * @param[in,out] remainingViewIds The remaining view ids
+   */
+  void pipelinedReconstruction(IndexT& resectionId, std::set<IndexT>& remainingViewIds);
+
   /**
    * @brief triangulate
    * @param[in] prevReconstructedViews The previously reconstructed view ids
@@ -225,6 +248,20 @@ private:
     std::shared_ptr<camera::IntrinsicBase> optionalIntrinsic = nullptr;
     /// the instrinsic already exists in the scene or not.
     bool isNewIntrinsic;
+    /// the intrinsic has been estimated or refined by the resection and should be updated in the scene
+    bool isIntrinsicRefined = false;
+  };
+
+  /// Tracks of a triangulation step and their triangulation results
+  struct TriangulationData
+  {
+    std::vector<IndexT> tracksIds;
+    /// reconstructed views observing each track
+    std::vector<std::set<IndexT>> observations;
+    /// triangulated landmarks of each thread
+    std::vector<LandmarksBuffer> landmarksBuffers;
+    /// landmarks of each buffer triangulated from more than 2 views, their angles and chieralities are checked by batch
+    std::vector<std::vector<std::size_t>> landmarksToCheck;
   };
 
   /**
@@ -242,8 +279,19 @@ private:
    */
   bool getBestInitialImagePairs(std::vector<Pair>& out_bestImagePairs, IndexT filterViewId = UndefinedIndexT) const;
 
+  /// Next best view scoring data of a remaining view, updated incrementally
+  struct ViewScoringData
+  {
+    /// number of reconstructed tracks visible in the view
+    std::size_t nbReconstructedTracks = 0;
+    /// number of reconstructed tracks in each cell of the pyramid (all levels)
+    std::vector<std::uint32_t> cellsNbTracks;
+    /// number of non-empty cells per pyramid level
+    std::vector<std::size_t> nbOccupiedCells;
+  };
+
   /**
-   * @brief Compute a score of the view for a subset of features. This is
+   * @brief Compute a score of the view from its reconstructed tracks. This is
    *        used for the next best view choice.
    *
    * The score is based on a pyramid which allows to compute a weighting
@@ -256,11 +304,56 @@ private:
    * We don't use the same weighting strategy. The weighting choice
    * is not justified in the paper.
    *
-   * @param[in] viewId: the ID of the view
-   * @param[in] trackIds: set of track IDs contained in viewId
+   * @param[in] scoringData: the pyramid cells occupancy of the view
    * @return the computed score
    */
-  std::size_t computeCandidateImageScore(IndexT viewId, const std::vector<std::size_t>& trackIds) const;
+  std::size_t computeCandidateImageScore(const ViewScoringData& scoringData) const;
+
+  /**
+   * @brief Update the next best view scoring data of the remaining views.
+   * Only the tracks reconstructed or removed since the last update are visited,
+   * views which become remaining are initialized from all their reconstructed tracks.
+   * @param[in] remainingViewIds: the views to score
+   */
+  void updateNextBestViewScoring(const std::set<IndexT>& remainingViewIds) const;
+
+  /**
+   * @brief Add (or remove) a reconstructed track to the scoring data of a view.
+   * @param[in] featsPyramid: the pyramid cells of the view tracks
+   * @param[in] trackId: the track id
+   * @param[in] add: add or remove the track
+   * @param[in,out] scoringData: the scoring data of the view
+   */
+  void updateViewScoring(const stl::flat_map<std::size_t, std::size_t>& featsPyramid,
+                         std::size_t trackId,
+                         bool add,
+                         ViewScoringData& scoringData) const;
+
+  /**
+   * @brief Check if a view can be localized (rig constraints) and compute its resection.
+   * It only reads the scene and can be called concurrently.
+   * @param[in] viewId: the view id
+   * @param[out] resectionData: contains the result (P) and all the data used during the resection.
+   * @return false if the view is skipped or if the resection failed
+   */
+  bool resectView(IndexT viewId, ResectionData& resectionData) const;
+
+  /**
+   * @brief Update the scene with the resections of a group of views, in the group order.
+   * @param[in] resectionId The resection id
+   * @param[in] viewIds The resected view ids
+   * @param[in] resectionsData The resection data of each view
+   * @param[in] hasResected The resection status of each view
+   * @param[in] prevReconstructedViews The reconstructed view ids before the update
+   * @param[in,out] remainingViewIds The remaining view ids
+   * @return new reconstructed view ids
+   */
+  std::set<IndexT> mergeResections(IndexT resectionId,
+                                   const std::vector<IndexT>& viewIds,
+                                   const std::vector<ResectionData>& resectionsData,
+                                   const std::vector<char>& hasResected,
+                                   const std::set<IndexT>& prevReconstructedViews,
+                                   std::set<IndexT>& remainingViewIds);
 
   /**
    * @brief Apply the resection on a single view.
@@ -268,7 +361,7 @@ private:
    * @param[out] resectionData: contains the result (P) and all the data used during the resection.
    * @return false if resection failed
    */
-  bool computeResection(const IndexT viewIndex, ResectionData& resectionData);
+  bool computeResection(const IndexT viewIndex, ResectionData& resectionData) const;
 
   /**
    * @brief Update the global scene with the new found camera pose, intrinsic (if not defined) and 
@@ -296,23 +389,38 @@ private:
   void triangulate_multiViewsLORANSAC(sfmData::SfMData& scene, const std::set<IndexT>& previousReconstructedViews, const std::set<IndexT>& newReconstructedViews);
 
   /**
-   * @brief Check if a 3D points is well located in front of a set of views.
-   * @param[in] pt3D A 3D point (euclidian coordinates)
-   * @param[in] viewsId A set of views index
-   * @param[in] scene All the data about the 3D reconstruction. 
-   * @return false if the 3D points is located behind one view (or more), else \c true.
+   * @brief List the tracks to triangulate with the multiview triangulation.
+   * @param[in] previousReconstructedViews The list of the old reconstructed views (views index).
+   * @param[in] newReconstructedViews The list of the new reconstructed views (views index).
+   * @param[out] triangulationData The tracks to triangulate and their observations.
+   */
+  void prepareTriangulation(const std::set<IndexT>& previousReconstructedViews,
+                            const std::set<IndexT>& newReconstructedViews,
+                            TriangulationData& triangulationData) const;
+
+  /**
+   * @brief Triangulate a track from its observations using the Lo-RANSAC algorithm.
+   * It only reads the scene and can be called concurrently with a buffer per thread.
+   * The angles and chieralities of the landmarks triangulated from more than 2 views are checked afterwards by applyTriangulation.
+   * @param[in] scene All the data about the 3D reconstruction.
+   * @param[in] trackId The track id
+   * @param[in] observations The reconstructed views observing the track
+   * @param[in,out] landmarks The buffer receiving the triangulated landmark, or an invalid landmark if the track cannot be triangulated
+   * @param[in,out] landmarksToCheck The index of the landmark in the buffer is added if its angles and chieralities have to be checked
    */
-  bool checkChieralities(const Vec3& pt3D, const std::set<IndexT>& viewsId, const sfmData::SfMData& scene);
-  
+  void triangulateTrack_multiViewsLORANSAC(const sfmData::SfMData& scene,
+                                           IndexT trackId,
+                                           const std::set<IndexT>& observations,
+                                           LandmarksBuffer& landmarks,
+                                           std::vector<std::size_t>& landmarksToCheck) const;
+
   /**
-   * @brief Check if the maximal angle formed by a 3D points and 2 views exceeds a min. angle, among a set of views.
-   * @param[in] pt3D A 3D point (euclidian coordinates)
-   * @param[in] viewsId A set of views index   
-   * @param[in] scene All the data about the 3D reconstruction. 
-   * @param[in] kMinAngle The angle limit.
-   * @return false if the maximal angle does not exceed the limit, else \c true.
+   * @brief Check the angles and chieralities of the triangulated landmarks, add them to the scene
+   *        and remove the tracks which cannot be triangulated anymore.
+   * @param[in,out] scene All the data about the 3D reconstruction.
+   * @param[in,out] triangulationData The triangulation results
    */
-  bool checkAngles(const Vec3& pt3D, const std::set<IndexT>& viewsId, const sfmData::SfMData& scene, const double& kMinAngle);
+  void applyTriangulation(sfmData::SfMData& scene, TriangulationData& triangulationData) const;
 
   /**
    * @brief Select the candidate tracks for the next triangulation step. 
@@ -352,11 +460,22 @@ private:
   /// internal cache of precomputed values for the weighting of the pyramid levels
   std::vector<int> _pyramidWeights;
   int _pyramidThreshold;
+  /// number of cells of the pyramid (all levels)
+  std::size_t _pyramidNbCells = 0;
+
+  // Next best view scoring cache, updated incrementally by findConnectedViews
+
+  /// reconstructed state of each track at the last update
+  mutable std::vector<char> _nbvIsTrackReconstructed;
+  /// sorted reconstructed track ids at the last update
+  mutable std::vector<IndexT> _nbvReconstructedTracks;
+  /// scoring data of the remaining views with tracks
+  mutable std::unordered_map<IndexT, ViewScoringData> _nbvViewScoring;
 
   // Temporary data
 
   /// Putative landmark tracks (visibility per potential 3D point)
-  track::TracksMap _map_tracks;
+  track::TracksStore _map_tracks;
   /// Putative tracks per view
   track::TracksPerView _map_tracksPerView;
   /// Precomputed pyramid index for each trackId of each viewId.
@@ -368,6 +487,8 @@ private:
 
   /// Contains all the data used by the Local BA approach
   std::shared_ptr<LocalBundleAdjustmentGraph> _localStrategyGraph;
+  /// Bundle adjustment kept between the iterations (with its persistent problem if usePersistentBundleAdjustment)
+  std::shared_ptr<BundleAdjustmentCeres> _bundleAdjustment;
 
   // Log
 
@@ -194,3 +194,136 @@ BOOST_AUTO_TEST_CASE(SEQUENTIAL_SFM_Known_Rig)
   BOOST_CHECK_EQUAL(sfmEngine.getSfMData().getLandmarks().size(), nbPoints);
 }
 
+
+// Test that the pipelined resection mode reconstructs the same scene as the sequential mode
+BOOST_AUTO_TEST_CASE(SEQUENTIAL_SFM_Pipelined_Resection)
+{
+  const int nviews = 12;
+  const int npoints = 256;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  // Translate the input dataset to a SfMData scene
+  const SfMData sfmData = getInputScene(d, config, EINTRINSIC::PINHOLE_CAMERA);
+
+  // Remove poses and structure
+  SfMData sfmData2 = sfmData;
+  sfmData2.getPoses().clear();
+  sfmData2.structure.clear();
+
+  // Add a tiny noise in 2D observations to make data more realistic
+  std::normal_distribution<double> distribution(0.0,0.5);
+
+  // Configure the featuresPerView & the matches_provider from the synthetic dataset
+  feature::FeaturesPerView featuresPerView;
+  generateSyntheticFeatures(featuresPerView, feature::EImageDescriberType::UNKNOWN, sfmData, distribution);
+
+  matching::PairwiseMatches pairwiseMatches;
+  generateSyntheticMatches(pairwiseMatches, sfmData, feature::EImageDescriberType::UNKNOWN);
+
+  std::vector<SfMData> results;
+  for(bool pipelinedResection : {false, true})
+  {
+    ReconstructionEngine_sequentialSfM::Params sfmParams;
+    sfmParams.userInitialImagePair = Pair(0, 1);
+    sfmParams.lockAllIntrinsics = true;
+    // small resection groups, so several groups are pipelined
+    sfmParams.maxImagesPerGroup = 2;
+    sfmParams.pipelinedResection = pipelinedResection;
+
+    ReconstructionEngine_sequentialSfM sfmEngine(sfmData2, sfmParams, "./");
+    sfmEngine.setFeatures(&featuresPerView);
+    sfmEngine.setMatches(&pairwiseMatches);
+
+    BOOST_CHECK(sfmEngine.process());
+
+    const double residual = RMSE(sfmEngine.getSfMData());
+    ALICEVISION_LOG_DEBUG("RMSE residual (pipelined resection: " << pipelinedResection << "): " << residual);
+    BOOST_CHECK_LT(residual, 0.5);
+    BOOST_CHECK_EQUAL(nviews, sfmEngine.getSfMData().getPoses().size());
+    BOOST_CHECK_EQUAL(npoints, sfmEngine.getSfMData().getLandmarks().size());
+    results.push_back(sfmEngine.getSfMData());
+  }
+
+  // same landmarks and observations
+  const Landmarks& sequentialLandmarks = results.front().getLandmarks();
+  const Landmarks& pipelinedLandmarks = results.back().getLandmarks();
+  for(const auto& landmarkIt : sequentialLandmarks)
+  {
+    const auto pipelinedIt = pipelinedLandmarks.find(landmarkIt.first);
+    BOOST_REQUIRE(pipelinedIt != pipelinedLandmarks.end());
+    BOOST_CHECK_EQUAL(landmarkIt.second.observations.size(), pipelinedIt->second.observations.size());
+  }
+}
+
+// Test that the next best view scores updated incrementally between two landmarks
+// changes are the same as the scores computed from scratch
+BOOST_AUTO_TEST_CASE(SEQUENTIAL_SFM_NextBestViewScoring)
+{
+  const int nviews = 6;
+  const int npoints = 128;
+  const NViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  // Translate the input dataset to a SfMData scene
+  const SfMData sfmData = getInputScene(d, config, EINTRINSIC::PINHOLE_CAMERA);
+
+  // Remove poses and structure
+  SfMData sfmData2 = sfmData;
+  sfmData2.getPoses().clear();
+  sfmData2.structure.clear();
+
+  std::normal_distribution<double> distribution(0.0,0.5);
+  feature::FeaturesPerView featuresPerView;
+  generateSyntheticFeatures(featuresPerView, feature::EImageDescriberType::UNKNOWN, sfmData, distribution);
+
+  matching::PairwiseMatches pairwiseMatches;
+  generateSyntheticMatches(pairwiseMatches, sfmData, feature::EImageDescriberType::UNKNOWN);
+
+  const ReconstructionEngine_sequentialSfM::Params sfmParams;
+  ReconstructionEngine_sequentialSfM incrementalEngine(sfmData2, sfmParams, "./");
+  ReconstructionEngine_sequentialSfM referenceEngine(sfmData2, sfmParams, "./");
+
+  for(ReconstructionEngine_sequentialSfM* sfmEngine : {&incrementalEngine, &referenceEngine})
+  {
+    sfmEngine->setFeatures(&featuresPerView);
+    sfmEngine->setMatches(&pairwiseMatches);
+    sfmEngine->initializePyramidScoring();
+    BOOST_CHECK_EQUAL(npoints, sfmEngine->fuseMatchesIntoTracks());
+  }
+
+  std::set<IndexT> remainingViewIds;
+  for(const auto& viewIt : sfmData2.getViews())
+    remainingViewIds.insert(viewIt.first);
+
+  // landmarks are inserted in decreasing order, with ids which are not tracks ids
+  Landmarks& landmarks = incrementalEngine.getSfMData().getLandmarks();
+  landmarks[npoints + 10];
+  for(int trackId = npoints - 1; trackId >= 0; trackId -= 2)
+    landmarks[trackId];
+  landmarks[npoints];
+
+  std::vector<ViewConnectionScore> connectedViews;
+  BOOST_CHECK(incrementalEngine.findConnectedViews(connectedViews, remainingViewIds));
+  BOOST_CHECK_EQUAL(nviews, connectedViews.size());
+  for(const ViewConnectionScore& viewScore : connectedViews)
+    BOOST_CHECK_EQUAL(npoints / 2, std::get<1>(viewScore));
+
+  // remove and add tracks, the first views are no longer remaining
+  for(int trackId = 0; trackId < npoints; trackId += 3)
+  {
+    if(!landmarks.erase(trackId))
+      landmarks[trackId];
+  }
+  remainingViewIds.erase(remainingViewIds.begin());
+  remainingViewIds.erase(remainingViewIds.begin());
+
+  BOOST_CHECK(incrementalEngine.findConnectedViews(connectedViews, remainingViewIds));
+
+  referenceEngine.getSfMData().getLandmarks() = landmarks;
+  std::vector<ViewConnectionScore> referenceConnectedViews;
+  BOOST_CHECK(referenceEngine.findConnectedViews(referenceConnectedViews, remainingViewIds));
+
+  BOOST_CHECK_EQUAL(nviews - 2, connectedViews.size());
+  BOOST_CHECK(referenceConnectedViews == connectedViews);
+}
@@ -15,6 +15,7 @@
 #include <aliceVision/track/TracksBuilder.hpp>
 #include <aliceVision/sfm/sfmTriangulation.hpp>
 #include <aliceVision/config.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <boost/progress.hpp>
 
@@ -183,80 +184,94 @@ void StructureEstimationFromKnownPoses::filter(
 
   boost::progress_display my_progress_bar( triplets.size(), std::cout,
     "Per triplet tracks validation (discard spurious correspondences):\n" );
-  #pragma omp parallel
-  for( Triplets::const_iterator it = triplets.begin(); it != triplets.end(); ++it)
+
+  // validated matches of each thread, merged after the triplets validation
+  std::vector<matching::PairwiseMatches> tripletMatchesPerThread(omp_get_max_threads());
+
+  #pragma omp parallel for schedule(dynamic)
+  for (int t = 0; t < static_cast<int>(triplets.size()); ++t)
   {
-    #pragma omp single nowait
-    {
-      #pragma omp critical
-      {++my_progress_bar;}
+    #pragma omp critical
+    {++my_progress_bar;}
 
-      const graph::Triplet & triplet = *it;
-      const IndexT I = triplet.i, J = triplet.j , K = triplet.k;
+    const graph::Triplet & triplet = triplets[t];
+    const IndexT I = triplet.i, J = triplet.j , K = triplet.k;
+    matching::PairwiseMatches & tripletMatches = tripletMatchesPerThread[omp_get_thread_num()];
 
-      track::TracksMap map_tracksCommon;
-      track::TracksBuilder tracksBuilder;
-      {
-        matching::PairwiseMatches map_matchesIJK;
-        if (_putativeMatches.count(std::make_pair(I,J)))
-          map_matchesIJK.insert(*_putativeMatches.find(std::make_pair(I,J)));
+    track::TracksMap map_tracksCommon;
+    track::TracksBuilder tracksBuilder;
+    {
+      matching::PairwiseMatches map_matchesIJK;
+      if (_putativeMatches.count(std::make_pair(I,J)))
+        map_matchesIJK.insert(*_putativeMatches.find(std::make_pair(I,J)));
 
-        if (_putativeMatches.count(std::make_pair(I,K)))
-          map_matchesIJK.insert(*_putativeMatches.find(std::make_pair(I,K)));
+      if (_putativeMatches.count(std::make_pair(I,K)))
+        map_matchesIJK.insert(*_putativeMatches.find(std::make_pair(I,K)));
 
-        if (_putativeMatches.count(std::make_pair(J,K)))
-          map_matchesIJK.insert(*_putativeMatches.find(std::make_pair(J,K)));
+      if (_putativeMatches.count(std::make_pair(J,K)))
+        map_matchesIJK.insert(*_putativeMatches.find(std::make_pair(J,K)));
 
-        if (map_matchesIJK.size() >= 2) {
-          tracksBuilder.build(map_matchesIJK);
-          tracksBuilder.filter(true,3, false);
-          tracksBuilder.exportToSTL(map_tracksCommon);
-        }
+      if (map_matchesIJK.size() >= 2) {
+        tracksBuilder.build(map_matchesIJK);
+        tracksBuilder.filter(true,3, false);
+        tracksBuilder.exportToSTL(map_tracksCommon);
+      }
 
-        // Triangulate the tracks
-        for (track::TracksMap::const_iterator iterTracks = map_tracksCommon.begin();
-          iterTracks != map_tracksCommon.end(); ++iterTracks) {
+      // Triangulate the tracks
+      for (track::TracksMap::const_iterator iterTracks = map_tracksCommon.begin();
+        iterTracks != map_tracksCommon.end(); ++iterTracks) {
+        {
+          const track::Track & subTrack = iterTracks->second;
+          multiview::Triangulation trianObj;
+          for (auto iter = subTrack.featPerView.begin(); iter != subTrack.featPerView.end(); ++iter)
           {
-            const track::Track & subTrack = iterTracks->second;
-            multiview::Triangulation trianObj;
-            for (auto iter = subTrack.featPerView.begin(); iter != subTrack.featPerView.end(); ++iter)
-            {
-              const size_t imaIndex = iter->first;
-              const size_t featIndex = iter->second;
-              const View * view = sfmData.getViews().at(imaIndex).get();
-              
-              std::shared_ptr<camera::IntrinsicBase> cam = sfmData.getIntrinsics().at(view->getIntrinsicId());
-              std::shared_ptr<camera::Pinhole> camPinHole = std::dynamic_pointer_cast<camera::Pinhole>(cam);
-              if (!camPinHole) {
-                ALICEVISION_LOG_ERROR("Camera is not pinhole in filter");
-                continue;
-              }
-
-              const Pose3 pose = sfmData.getPose(*view).getTransform();
-              const Vec2 pt = regionsPerView.getRegions(imaIndex, subTrack.descType).GetRegionPosition(featIndex);
-              trianObj.add(camPinHole->getProjectiveEquivalent(pose), cam->get_ud_pixel(pt));
-            }
-            const Vec3 Xs = trianObj.compute();
-            if (trianObj.minDepth() > 0 && trianObj.error()/(double)trianObj.size() < 4.0)
-            // TODO: Add an angular check ?
-            {
-              #pragma omp critical
-              {
-                track::Track::FeatureIdPerView::const_iterator iterI, iterJ, iterK;
-                iterI = iterJ = iterK = subTrack.featPerView.begin();
-                std::advance(iterJ,1);
-                std::advance(iterK,2);
-
-                _tripletMatches[std::make_pair(I,J)][subTrack.descType].emplace_back(iterI->second, iterJ->second);
-                _tripletMatches[std::make_pair(J,K)][subTrack.descType].emplace_back(iterJ->second, iterK->second);
-                _tripletMatches[std::make_pair(I,K)][subTrack.descType].emplace_back(iterI->second, iterK->second);
-              }
+            const size_t imaIndex = iter->first;
+            const size_t featIndex = iter->second;
+            const View * view = sfmData.getViews().at(imaIndex).get();
+            
+            std::shared_ptr<camera::IntrinsicBase> cam = sfmData.getIntrinsics().at(view->getIntrinsicId());
+            std::shared_ptr<camera::Pinhole> camPinHole = std::dynamic_pointer_cast<camera::Pinhole>(cam);
+            if (!camPinHole) {
+              ALICEVISION_LOG_ERROR("Camera is not pinhole in filter");
+              continue;
             }
+
+            const Pose3 pose = sfmData.getPose(*view).getTransform();
+            const Vec2 pt = regionsPerView.getRegions(imaIndex, subTrack.descType).GetRegionPosition(featIndex);
+            trianObj.add(camPinHole->getProjectiveEquivalent(pose), cam->get_ud_pixel(pt));
+          }
+          const Vec3 Xs = trianObj.compute();
+          if (trianObj.minDepth() > 0 && trianObj.error()/(double)trianObj.size() < 4.0)
+          // TODO: Add an angular check ?
+          {
+            track::Track::FeatureIdPerView::const_iterator iterI, iterJ, iterK;
+            iterI = iterJ = iterK = subTrack.featPerView.begin();
+            std::advance(iterJ,1);
+            std::advance(iterK,2);
+
+            tripletMatches[std::make_pair(I,J)][subTrack.descType].emplace_back(iterI->second, iterJ->second);
+            tripletMatches[std::make_pair(J,K)][subTrack.descType].emplace_back(iterJ->second, iterK->second);
+            tripletMatches[std::make_pair(I,K)][subTrack.descType].emplace_back(iterI->second, iterK->second);
           }
         }
       }
     }
   }
+
+  // Merge the validated matches of all the threads
+  for (const matching::PairwiseMatches & tripletMatches : tripletMatchesPerThread)
+  {
+    for (const auto & pairMatches : tripletMatches)
+    {
+      matching::MatchesPerDescType & matchesPerDesc = _tripletMatches[pairMatches.first];
+      for (const auto & descMatches : pairMatches.second)
+      {
+        matching::IndMatches & matches = matchesPerDesc[descMatches.first];
+        matches.insert(matches.end(), descMatches.second.begin(), descMatches.second.end());
+      }
+    }
+  }
+
   // Clear putatives matches since they are no longer required
   matching::PairwiseMatches().swap(_putativeMatches);
 }
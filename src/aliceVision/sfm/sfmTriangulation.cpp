@@ -9,11 +9,12 @@
 #include <aliceVision/multiview/triangulation/Triangulation.hpp>
 #include <aliceVision/robustEstimation/randSampling.hpp>
 #include <aliceVision/config.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <boost/progress.hpp>
 
-#include <deque>
 #include <memory>
+#include <vector>
 
 namespace aliceVision {
 namespace sfm {
@@ -29,78 +30,92 @@ StructureComputation_blind::StructureComputation_blind(bool verbose)
   : StructureComputation_basis(verbose)
 {}
 
+/**
+ * @brief List the landmarks of the structure, to process them with a parallel loop.
+ */
+std::vector<std::pair<IndexT, sfmData::Landmark*>> getLandmarksList(sfmData::Landmarks& landmarks)
+{
+  std::vector<std::pair<IndexT, sfmData::Landmark*>> landmarksList;
+  landmarksList.reserve(landmarks.size());
+  for(auto& landmarkPair : landmarks)
+    landmarksList.emplace_back(landmarkPair.first, &landmarkPair.second);
+  return landmarksList;
+}
+
+/**
+ * @brief Erase the unsuccessful triangulated tracks of each thread.
+ */
+void eraseRejectedLandmarks(const std::vector<std::vector<IndexT>>& rejectedIdPerThread, sfmData::Landmarks& landmarks)
+{
+  for(const std::vector<IndexT>& rejectedId : rejectedIdPerThread)
+  {
+    for(const IndexT landmarkId : rejectedId)
+      landmarks.erase(landmarkId);
+  }
+}
+
 void StructureComputation_blind::triangulate(sfmData::SfMData& sfmData) const
 {
-  std::deque<IndexT> rejectedId;
+  const std::vector<std::pair<IndexT, sfmData::Landmark*>> landmarksList = getLandmarksList(sfmData.structure);
+  std::vector<std::vector<IndexT>> rejectedIdPerThread(omp_get_max_threads());
+
   std::unique_ptr<boost::progress_display> my_progress_bar;
   if (_bConsoleVerbose)
     my_progress_bar.reset( new boost::progress_display(
     sfmData.structure.size(),
     std::cout,
     "Blind triangulation progress:\n" ));
-  #pragma omp parallel
-  for(sfmData::Landmarks::iterator iterTracks = sfmData.structure.begin();
-    iterTracks != sfmData.structure.end();
-    ++iterTracks)
+  #pragma omp parallel for schedule(dynamic, 64)
+  for(int i = 0; i < static_cast<int>(landmarksList.size()); ++i)
   {
-    #pragma omp single nowait
+    if (_bConsoleVerbose)
     {
-      if (_bConsoleVerbose)
-      {
-        #pragma omp critical
-        ++(*my_progress_bar);
-      }
-      // Triangulate each landmark
-      multiview::Triangulation trianObj;
-      const sfmData::Observations & observations = iterTracks->second.observations;
-      for(const auto& itObs : observations)
+      #pragma omp critical
+      ++(*my_progress_bar);
+    }
+    sfmData::Landmark& landmark = *landmarksList[i].second;
+
+    // Triangulate each landmark
+    multiview::Triangulation trianObj;
+    const sfmData::Observations & observations = landmark.observations;
+    for(const auto& itObs : observations)
+    {
+      const sfmData::View * view = sfmData.views.at(itObs.first).get();
+      if (sfmData.isPoseAndIntrinsicDefined(view))
       {
-        const sfmData::View * view = sfmData.views.at(itObs.first).get();
-        if (sfmData.isPoseAndIntrinsicDefined(view))
-        {
-          std::shared_ptr<IntrinsicBase> cam = sfmData.getIntrinsics().at(view->getIntrinsicId());
-          std::shared_ptr<camera::Pinhole> pinHoleCam = std::dynamic_pointer_cast<camera::Pinhole>(cam);
-          if (!pinHoleCam) {
-            ALICEVISION_LOG_ERROR("Camera is not pinhole in triangulate");
-            continue;
-          }
-
-          const Pose3 pose = sfmData.getPose(*view).getTransform();
-          trianObj.add(
-            pinHoleCam->getProjectiveEquivalent(pose),
-            cam->get_ud_pixel(itObs.second.x));
+        std::shared_ptr<IntrinsicBase> cam = sfmData.getIntrinsics().at(view->getIntrinsicId());
+        std::shared_ptr<camera::Pinhole> pinHoleCam = std::dynamic_pointer_cast<camera::Pinhole>(cam);
+        if (!pinHoleCam) {
+          ALICEVISION_LOG_ERROR("Camera is not pinhole in triangulate");
+          continue;
         }
+
+        const Pose3 pose = sfmData.getPose(*view).getTransform();
+        trianObj.add(
+          pinHoleCam->getProjectiveEquivalent(pose),
+          cam->get_ud_pixel(itObs.second.x));
       }
-      if (trianObj.size() < 2)
+    }
+    if (trianObj.size() < 2)
+    {
+      rejectedIdPerThread[omp_get_thread_num()].push_back(landmarksList[i].first);
+    }
+    else
+    {
+      // Compute the 3D point
+      const Vec3 X = trianObj.compute();
+      if (trianObj.minDepth() > 0) // Keep the point only if it have a positive depth
       {
-        #pragma omp critical
-        {
-          rejectedId.push_front(iterTracks->first);
-        }
+        landmark.X = X;
       }
       else
       {
-        // Compute the 3D point
-        const Vec3 X = trianObj.compute();
-        if (trianObj.minDepth() > 0) // Keep the point only if it have a positive depth
-        {
-          iterTracks->second.X = X;
-        }
-        else
-        {
-          #pragma omp critical
-          {
-            rejectedId.push_front(iterTracks->first);
-          }
-        }
+        rejectedIdPerThread[omp_get_thread_num()].push_back(landmarksList[i].first);
       }
     }
   }
   // Erase the unsuccessful triangulated tracks
-  for (auto& it : rejectedId)
-  {
-    sfmData.structure.erase(it);
-  }
+  eraseRejectedLandmarks(rejectedIdPerThread, sfmData.structure);
 }
 
 StructureComputation_robust::StructureComputation_robust(bool verbose)
@@ -117,43 +132,35 @@ void StructureComputation_robust::triangulate(sfmData::SfMData& sfmData) const
 /// Invalid landmark are removed.
 void StructureComputation_robust::robust_triangulation(sfmData::SfMData& sfmData) const
 {
-  std::deque<IndexT> rejectedId;
+  const std::vector<std::pair<IndexT, sfmData::Landmark*>> landmarksList = getLandmarksList(sfmData.structure);
+  std::vector<std::vector<IndexT>> rejectedIdPerThread(omp_get_max_threads());
+
   std::unique_ptr<boost::progress_display> my_progress_bar;
   if(_bConsoleVerbose)
     my_progress_bar.reset( new boost::progress_display(
     sfmData.structure.size(),
     std::cout,
     "Robust triangulation progress:\n" ));
-  #pragma omp parallel
-  for(sfmData::Landmarks::iterator iterTracks = sfmData.structure.begin();
-    iterTracks != sfmData.structure.end();
-    ++iterTracks)
+  #pragma omp parallel for schedule(dynamic, 64)
+  for(int i = 0; i < static_cast<int>(landmarksList.size()); ++i)
   {
-    #pragma omp single nowait
+    if (_bConsoleVerbose)
     {
-      if (_bConsoleVerbose)
-      {
-        #pragma omp critical
-        ++(*my_progress_bar);
-      }
-      Vec3 X;
-      if (robust_triangulation(sfmData, iterTracks->second.observations, X)) {
-        iterTracks->second.X = X;
-      }
-      else {
-        iterTracks->second.X = Vec3::Zero();
-        #pragma omp critical
-        {
-          rejectedId.push_front(iterTracks->first);
-        }
-      }
+      #pragma omp critical
+      ++(*my_progress_bar);
+    }
+    sfmData::Landmark& landmark = *landmarksList[i].second;
+    Vec3 X;
+    if (robust_triangulation(sfmData, landmark.observations, X)) {
+      landmark.X = X;
+    }
+    else {
+      landmark.X = Vec3::Zero();
+      rejectedIdPerThread[omp_get_thread_num()].push_back(landmarksList[i].first);
     }
   }
   // Erase the unsuccessful triangulated tracks
-  for(auto& it : rejectedId)
-  {
-    sfmData.structure.erase(it);
-  }
+  eraseRejectedLandmarks(rejectedIdPerThread, sfmData.structure);
 }
 
 /// Robustly try to estimate the best 3D point using a ransac Scheme
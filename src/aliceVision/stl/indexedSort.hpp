@@ -8,6 +8,9 @@
 #ifndef ALICEVISION_STL_INDEXED_SORT_H
 #define ALICEVISION_STL_INDEXED_SORT_H
 
+#include <algorithm>
+#include <vector>
+
 namespace stl
 {
 namespace indexed_sort
@@ -0,0 +1,78 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "MemoryMappedFile.hpp"
+
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/filesystem.hpp>
+
+#include <stdexcept>
+
+namespace fs = boost::filesystem;
+
+namespace aliceVision {
+namespace system {
+
+MemoryMappedFile::MemoryMappedFile() = default;
+
+MemoryMappedFile::MemoryMappedFile(const std::string& path)
+{
+  open(path);
+}
+
+MemoryMappedFile::~MemoryMappedFile() = default;
+
+MemoryMappedFile::MemoryMappedFile(MemoryMappedFile&& other) = default;
+
+MemoryMappedFile& MemoryMappedFile::operator=(MemoryMappedFile&& other) = default;
+
+void MemoryMappedFile::open(const std::string& path)
+{
+  close();
+
+  boost::system::error_code ec;
+  const boost::uintmax_t fileSize = fs::file_size(path, ec);
+
+  if(ec)
+    throw std::runtime_error("Can't map file, can't open '" + path + "' !");
+
+  // an empty file can't be mapped
+  if(fileSize > 0)
+  {
+    try
+    {
+      _mapping.reset(new boost::iostreams::mapped_file_source(path));
+    }
+    catch(const std::exception& e)
+    {
+      _mapping.reset();
+      throw std::runtime_error("Can't map file '" + path + "': " + e.what());
+    }
+  }
+
+  _path = path;
+  _isOpen = true;
+}
+
+void MemoryMappedFile::close()
+{
+  _mapping.reset();
+  _path.clear();
+  _isOpen = false;
+}
+
+const char* MemoryMappedFile::data() const
+{
+  return (_mapping ? _mapping->data() : nullptr);
+}
+
+std::size_t MemoryMappedFile::size() const
+{
+  return (_mapping ? _mapping->size() : 0);
+}
+
+} // namespace system
+} // namespace aliceVision
@@ -0,0 +1,89 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace boost {
+namespace iostreams {
+class mapped_file_source;
+}
+}
+
+namespace aliceVision {
+namespace system {
+
+/**
+ * @brief Read-only memory mapping of a whole file.
+ *
+ * The mapping is released when the object is destroyed.
+ * Pages are loaded on demand by the OS and can be shared between processes
+ * mapping the same file.
+ */
+class MemoryMappedFile
+{
+public:
+  MemoryMappedFile();
+
+  /**
+   * @brief Map the given file.
+   * @param[in] path The file path
+   * @throw std::runtime_error if the file can't be mapped
+   */
+  explicit MemoryMappedFile(const std::string& path);
+
+  ~MemoryMappedFile();
+
+  MemoryMappedFile(MemoryMappedFile&& other);
+  MemoryMappedFile& operator=(MemoryMappedFile&& other);
+
+  MemoryMappedFile(const MemoryMappedFile&) = delete;
+  MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+
+  /**
+   * @brief Map the given file, release the previous mapping if any.
+   * @param[in] path The file path
+   * @throw std::runtime_error if the file can't be mapped
+   */
+  void open(const std::string& path);
+
+  /**
+   * @brief Release the mapping.
+   */
+  void close();
+
+  /**
+   * @brief Is there a file currently mapped.
+   * @note An empty file is considered as opened but has a null data pointer.
+   */
+  bool isOpen() const { return _isOpen; }
+
+  /**
+   * @brief Get a pointer on the first byte of the mapped file.
+   */
+  const char* data() const;
+
+  /**
+   * @brief Get the mapped file size in bytes.
+   */
+  std::size_t size() const;
+
+  /**
+   * @brief Get the mapped file path.
+   */
+  const std::string& path() const { return _path; }
+
+private:
+  std::unique_ptr<boost::iostreams::mapped_file_source> _mapping;
+  std::string _path;
+  bool _isOpen = false;
+};
+
+} // namespace system
+} // namespace aliceVision
@@ -164,3 +164,137 @@ int get_total_cpus(void)
 
 #endif /* GET_TOTAL_CPUS_DEFINED */
 
+
+
+/* SIMD features detection */
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define ALICEVISION_CPUID_X86
+static void cpuidex(unsigned int leaf, unsigned int subleaf, unsigned int regs[4])
+{
+  int r[4];
+  __cpuidex(r, static_cast<int>(leaf), static_cast<int>(subleaf));
+  for(int i = 0; i < 4; ++i)
+    regs[i] = static_cast<unsigned int>(r[i]);
+}
+static unsigned long long xgetbv0()
+{
+  return _xgetbv(0);
+}
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#define ALICEVISION_CPUID_X86
+static void cpuidex(unsigned int leaf, unsigned int subleaf, unsigned int regs[4])
+{
+  __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+}
+static unsigned long long xgetbv0()
+{
+  unsigned int eax, edx;
+  __asm__ volatile(".byte 0x0f, 0x01, 0xd0" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (static_cast<unsigned long long>(edx) << 32) | eax;
+}
+#endif
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+namespace aliceVision {
+namespace system {
+
+std::string ESimdLevel_enumToString(ESimdLevel level)
+{
+  switch(level)
+  {
+    case ESimdLevel::NONE:   return "none";
+    case ESimdLevel::SSE2:   return "sse2";
+    case ESimdLevel::AVX2:   return "avx2";
+    case ESimdLevel::AVX512: return "avx512";
+  }
+  return "none";
+}
+
+static CpuFeatures detectCpuFeatures()
+{
+  CpuFeatures features;
+#ifdef ALICEVISION_CPUID_X86
+  unsigned int regs[4] = {0, 0, 0, 0};
+  cpuidex(0, 0, regs);
+  const unsigned int maxLeaf = regs[0];
+  if(maxLeaf < 1)
+    return features;
+
+  cpuidex(1, 0, regs);
+  features.sse2   = (regs[3] & (1u << 26)) != 0;
+  features.sse41  = (regs[2] & (1u << 19)) != 0;
+  features.sse42  = (regs[2] & (1u << 20)) != 0;
+  features.popcnt = (regs[2] & (1u << 23)) != 0;
+  const bool fma     = (regs[2] & (1u << 12)) != 0;
+  const bool osxsave = (regs[2] & (1u << 27)) != 0;
+  const bool avx     = (regs[2] & (1u << 28)) != 0;
+
+  if(!osxsave)
+    return features;
+
+  // check that the OS saves the YMM (bits 1-2) and ZMM/opmask (bits 5-7) states
+  const unsigned long long xcr0 = xgetbv0();
+  const bool osYmm = (xcr0 & 0x6) == 0x6;
+  const bool osZmm = (xcr0 & 0xe6) == 0xe6;
+
+  features.avx = avx && osYmm;
+  features.fma = fma && osYmm;
+
+  if(maxLeaf >= 7)
+  {
+    cpuidex(7, 0, regs);
+    features.avx2     = features.avx && (regs[1] & (1u << 5)) != 0;
+    features.avx512f  = osZmm && (regs[1] & (1u << 16)) != 0;
+    features.avx512bw = osZmm && (regs[1] & (1u << 30)) != 0;
+  }
+#endif
+  return features;
+}
+
+const CpuFeatures& getCpuFeatures()
+{
+  static const CpuFeatures features = detectCpuFeatures();
+  return features;
+}
+
+static ESimdLevel detectSimdLevel()
+{
+  const CpuFeatures& f = getCpuFeatures();
+  ESimdLevel level = ESimdLevel::NONE;
+  if(f.sse2)
+    level = ESimdLevel::SSE2;
+  if(level == ESimdLevel::SSE2 && f.avx2 && f.fma && f.popcnt)
+    level = ESimdLevel::AVX2;
+  if(level == ESimdLevel::AVX2 && f.avx512f && f.avx512bw)
+    level = ESimdLevel::AVX512;
+
+  const char* envLevel = std::getenv("ALICEVISION_SIMD_LEVEL");
+  if(envLevel != nullptr)
+  {
+    std::string value(envLevel);
+    std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+    for(ESimdLevel l : {ESimdLevel::NONE, ESimdLevel::SSE2, ESimdLevel::AVX2, ESimdLevel::AVX512})
+    {
+      if(value == ESimdLevel_enumToString(l))
+      {
+        level = std::min(level, l);
+        break;
+      }
+    }
+  }
+  return level;
+}
+
+ESimdLevel getSimdLevel()
+{
+  static const ESimdLevel level = detectSimdLevel();
+  return level;
+}
+
+}
+}
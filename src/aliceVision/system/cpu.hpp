@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include <string>
+
 namespace aliceVision {
 namespace system {
 
@@ -22,6 +24,49 @@ int cpu_clock_by_os();
  */
 int get_total_cpus();
 
+/**
+ * @brief SIMD instruction set levels, ordered from the least to the most capable.
+ */
+enum class ESimdLevel
+{
+  NONE = 0,
+  SSE2,
+  AVX2,     //< AVX2 + FMA + POPCNT
+  AVX512    //< AVX-512 F + BW
+};
+
+std::string ESimdLevel_enumToString(ESimdLevel level);
+
+/**
+ * @brief SIMD features of the running CPU, as reported by CPUID.
+ * Extended register sets are only reported if the OS saves them on context switch.
+ */
+struct CpuFeatures
+{
+  bool sse2 = false;
+  bool sse41 = false;
+  bool sse42 = false;
+  bool popcnt = false;
+  bool avx = false;
+  bool avx2 = false;
+  bool fma = false;
+  bool avx512f = false;
+  bool avx512bw = false;
+};
+
+/**
+ * @brief Returns the SIMD features of the running CPU.
+ * Detection is done once, the result is cached.
+ */
+const CpuFeatures& getCpuFeatures();
+
+/**
+ * @brief Returns the highest SIMD level supported by the running CPU.
+ * It can be lowered with the ALICEVISION_SIMD_LEVEL environment variable (none, sse2, avx2, avx512),
+ * which is useful to compare or debug the dispatched code paths.
+ */
+ESimdLevel getSimdLevel();
+
 }
 }
 
@@ -0,0 +1,461 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "StreamingTracksBuilder.hpp"
+
+#include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <algorithm>
+#include <exception>
+#include <limits>
+#include <map>
+#include <stdexcept>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace aliceVision {
+namespace track {
+
+namespace {
+
+inline unsigned int popcount64(std::uint64_t n)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<unsigned int>(__builtin_popcountll(n));
+#else
+  n -= ((n >> 1) & 0x5555555555555555ULL);
+  n = (n & 0x3333333333333333ULL) + ((n >> 2) & 0x3333333333333333ULL);
+  return static_cast<unsigned int>((((n + (n >> 4)) & 0x0f0f0f0f0f0f0f0fULL) * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/// Index of the lowest set bit, n must not be 0
+inline unsigned int lowestBit64(std::uint64_t n)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<unsigned int>(__builtin_ctzll(n));
+#elif defined(_MSC_VER) && defined(_M_X64)
+  unsigned long index;
+  _BitScanForward64(&index, n);
+  return static_cast<unsigned int>(index);
+#else
+  return popcount64((n & (~n + 1)) - 1);
+#endif
+}
+
+/**
+ * @brief Fixed random priority of a node, the union-find always links the root with
+ *        the lowest priority under the other one. It is a bijection, so the priorities
+ *        are a total order and the forest can't have cycles whatever the concurrent unions.
+ */
+inline std::uint64_t nodePriority(std::uint64_t node)
+{
+  return node * 0x9E3779B97F4A7C15ULL;
+}
+
+inline void setBit(std::vector<std::uint64_t>& bits, IndexT index)
+{
+  const std::size_t word = index >> 6;
+  if(word >= bits.size())
+    bits.resize(word + 1, 0);
+  bits[word] |= std::uint64_t(1) << (index & 63);
+}
+
+using ViewDescKey = std::pair<IndexT, feature::EImageDescriberType>;
+using FeaturesBitsets = std::map<ViewDescKey, std::vector<std::uint64_t>>;
+
+/// Root marker used during the export, when the parents are replaced by track ids
+const std::uint64_t trackIdFlag = std::uint64_t(1) << 63;
+
+} // namespace
+
+PairwiseMatchesStream::PairwiseMatchesStream(const PairwiseMatches& pairwiseMatches)
+{
+  _pairs.reserve(pairwiseMatches.size());
+  for(const auto& matchesIt : pairwiseMatches)
+    _pairs.push_back(&matchesIt);
+}
+
+const MatchesPerDescType& PairwiseMatchesStream::read(std::size_t pairIndex, Pair& pair, MatchesPerDescType& buffer) const
+{
+  pair = _pairs.at(pairIndex)->first;
+  return _pairs[pairIndex]->second;
+}
+
+MatchesBinFilesStream::MatchesBinFilesStream(const std::vector<std::string>& filepaths)
+{
+  _firstPairIndex.push_back(0);
+  for(const std::string& filepath : filepaths)
+  {
+    _readers.emplace_back(new matching::MatchesBinReader(filepath));
+    _firstPairIndex.push_back(_firstPairIndex.back() + _readers.back()->getNbPairs());
+  }
+}
+
+const MatchesPerDescType& MatchesBinFilesStream::read(std::size_t pairIndex, Pair& pair, MatchesPerDescType& buffer) const
+{
+  if(pairIndex >= getNbPairs())
+    throw std::out_of_range("Invalid pair index " + std::to_string(pairIndex) + " in matches files stream.");
+
+  const std::size_t fileIndex = std::upper_bound(_firstPairIndex.begin(), _firstPairIndex.end(), pairIndex) - _firstPairIndex.begin() - 1;
+  _readers[fileIndex]->readAt(pairIndex - _firstPairIndex[fileIndex], pair, buffer);
+  return buffer;
+}
+
+std::size_t StreamingTracksBuilder::ViewDescNodes::nodeId(IndexT featId) const
+{
+  const std::size_t word = featId >> 6;
+  const std::uint64_t lowerBits = bits[word] & ((std::uint64_t(1) << (featId & 63)) - 1);
+  return firstNode + ranks[word] + popcount64(lowerBits);
+}
+
+StreamingTracksBuilder::StreamingTracksBuilder() = default;
+
+StreamingTracksBuilder::~StreamingTracksBuilder() = default;
+
+const StreamingTracksBuilder::ViewDescNodes& StreamingTracksBuilder::getViewDescNodes(IndexT viewId, feature::EImageDescriberType descType) const
+{
+  const ViewDescKey key(viewId, descType);
+  const auto it = std::lower_bound(_viewDescNodes.begin(), _viewDescNodes.end(), key,
+    [](const ViewDescNodes& nodes, const ViewDescKey& k)
+    {
+      return ViewDescKey(nodes.viewId, nodes.descType) < k;
+    });
+  if(it == _viewDescNodes.end() || it->viewId != viewId || it->descType != descType)
+    throw std::runtime_error("The matches of the view " + std::to_string(viewId) + " have changed since the nodes registration.");
+  return *it;
+}
+
+std::size_t StreamingTracksBuilder::find(std::size_t node)
+{
+  while(true)
+  {
+    const std::uint64_t parent = _parents[node].load(std::memory_order_relaxed);
+    if(parent == node)
+      return node;
+    const std::uint64_t grandParent = _parents[parent].load(std::memory_order_relaxed);
+    if(grandParent != parent)
+    {
+      // path halving, the new parent is always an ancestor so a lost exchange is harmless
+      std::uint64_t expected = parent;
+      _parents[node].compare_exchange_weak(expected, grandParent, std::memory_order_relaxed);
+    }
+    node = grandParent;
+  }
+}
+
+void StreamingTracksBuilder::unite(std::size_t nodeA, std::size_t nodeB)
+{
+  while(true)
+  {
+    nodeA = find(nodeA);
+    nodeB = find(nodeB);
+    if(nodeA == nodeB)
+      return;
+    if(nodePriority(nodeA) > nodePriority(nodeB))
+      std::swap(nodeA, nodeB);
+    // fails if nodeA is no longer a root, then retry from the new roots
+    std::uint64_t expected = nodeA;
+    if(_parents[nodeA].compare_exchange_strong(expected, nodeB))
+      return;
+  }
+}
+
+void StreamingTracksBuilder::build(const PairwiseMatches& pairwiseMatches, bool multithreaded)
+{
+  build(PairwiseMatchesStream(pairwiseMatches), multithreaded);
+}
+
+void StreamingTracksBuilder::build(const IMatchesStream& matchesStream, bool multithreaded)
+{
+  _viewDescNodes.clear();
+  _nbNodes = 0;
+  _parents.reset();
+
+  const int nbPairs = static_cast<int>(matchesStream.getNbPairs());
+  const int nbThreads = multithreaded ? omp_get_max_threads() : 1;
+
+  // first pass: register the matched features of each view
+  std::vector<FeaturesBitsets> featuresPerThread(nbThreads);
+
+  // exceptions cannot escape an OpenMP region: keep the first one and rethrow it after the region
+  std::exception_ptr error;
+  bool hasError = false;
+
+  #pragma omp parallel num_threads(nbThreads)
+  {
+    FeaturesBitsets& features = featuresPerThread[omp_get_thread_num()];
+    MatchesPerDescType buffer;
+
+    #pragma omp for schedule(dynamic)
+    for(int i = 0; i < nbPairs; ++i)
+    {
+      bool failed;
+      #pragma omp atomic read
+      failed = hasError;
+      if(failed)
+        continue;
+
+      try
+      {
+        Pair pair;
+        const MatchesPerDescType& matchesPerDesc = matchesStream.read(i, pair, buffer);
+
+        for(const auto& matchesIt : matchesPerDesc)
+        {
+          if(matchesIt.second.empty())
+            continue;
+          std::vector<std::uint64_t>& bitsI = features[ViewDescKey(pair.first, matchesIt.first)];
+          std::vector<std::uint64_t>& bitsJ = features[ViewDescKey(pair.second, matchesIt.first)];
+          for(const IndMatch& m : matchesIt.second)
+          {
+            setBit(bitsI, m._i);
+            setBit(bitsJ, m._j);
+          }
+        }
+      }
+      catch(...)
+      {
+        #pragma omp critical(StreamingTracksBuilder_error)
+        {
+          if(!error)
+            error = std::current_exception();
+        }
+        #pragma omp atomic write
+        hasError = true;
+      }
+    }
+  }
+
+  if(error)
+    std::rethrow_exception(error);
+
+  FeaturesBitsets features = std::move(featuresPerThread.front());
+  for(int t = 1; t < nbThreads; ++t)
+  {
+    for(auto& bitsIt : featuresPerThread[t])
+    {
+      std::vector<std::uint64_t>& bits = features[bitsIt.first];
+      if(bits.size() < bitsIt.second.size())
+        bits.resize(bitsIt.second.size(), 0);
+      for(std::size_t w = 0; w < bitsIt.second.size(); ++w)
+        bits[w] |= bitsIt.second[w];
+    }
+    FeaturesBitsets().swap(featuresPerThread[t]);
+  }
+
+  // nodes are numbered by (viewId, descType, featId)
+  _viewDescNodes.reserve(features.size());
+  for(auto& bitsIt : features)
+  {
+    _viewDescNodes.emplace_back();
+    ViewDescNodes& nodes = _viewDescNodes.back();
+    nodes.viewId = bitsIt.first.first;
+    nodes.descType = bitsIt.first.second;
+    nodes.bits.swap(bitsIt.second);
+    nodes.ranks.resize(nodes.bits.size());
+    nodes.firstNode = _nbNodes;
+
+    std::uint32_t rank = 0;
+    for(std::size_t w = 0; w < nodes.bits.size(); ++w)
+    {
+      nodes.ranks[w] = rank;
+      rank += popcount64(nodes.bits[w]);
+    }
+    _nbNodes += rank;
+  }
+  FeaturesBitsets().swap(features);
+
+  if(_nbNodes >= trackIdFlag)
+    throw std::out_of_range("Too many matched features to build tracks: " + std::to_string(_nbNodes));
+
+  // second pass: union of the matched features
+  _parents.reset(new std::atomic<std::uint64_t>[_nbNodes]);
+
+  #pragma omp parallel for num_threads(nbThreads)
+  for(std::ptrdiff_t n = 0; n < static_cast<std::ptrdiff_t>(_nbNodes); ++n)
+    _parents[n].store(n, std::memory_order_relaxed);
+
+  #pragma omp parallel num_threads(nbThreads)
+  {
+    MatchesPerDescType buffer;
+
+    #pragma omp for schedule(dynamic)
+    for(int i = 0; i < nbPairs; ++i)
+    {
+      bool failed;
+      #pragma omp atomic read
+      failed = hasError;
+      if(failed)
+        continue;
+
+      try
+      {
+        Pair pair;
+        const MatchesPerDescType& matchesPerDesc = matchesStream.read(i, pair, buffer);
+
+        for(const auto& matchesIt : matchesPerDesc)
+        {
+          if(matchesIt.second.empty())
+            continue;
+          const ViewDescNodes& nodesI = getViewDescNodes(pair.first, matchesIt.first);
+          const ViewDescNodes& nodesJ = getViewDescNodes(pair.second, matchesIt.first);
+          for(const IndMatch& m : matchesIt.second)
+            unite(nodesI.nodeId(m._i), nodesJ.nodeId(m._j));
+        }
+      }
+      catch(...)
+      {
+        #pragma omp critical(StreamingTracksBuilder_error)
+        {
+          if(!error)
+            error = std::current_exception();
+        }
+        #pragma omp atomic write
+        hasError = true;
+      }
+    }
+  }
+
+  if(error)
+  {
+    _viewDescNodes.clear();
+    _nbNodes = 0;
+    _parents.reset();
+    std::rethrow_exception(error);
+  }
+
+  ALICEVISION_LOG_DEBUG("Streaming tracks builder: " << nbPairs << " pairs, " << _nbNodes << " nodes.");
+}
+
+void StreamingTracksBuilder::exportToCSR(TracksCSR& tracks, bool clearForks, std::size_t minTrackLength, bool multithreaded)
+{
+  tracks.clear();
+  if(_nbNodes == 0)
+    return;
+
+  const std::ptrdiff_t nbNodes = static_cast<std::ptrdiff_t>(_nbNodes);
+
+  // full path compression: each node points to its root
+  #pragma omp parallel for if(multithreaded)
+  for(std::ptrdiff_t n = 0; n < nbNodes; ++n)
+    _parents[n].store(find(n), std::memory_order_relaxed);
+
+  // number the tracks in roots order, the roots temporarily store their track id
+  std::vector<std::uint64_t> trackRoots;
+  for(std::ptrdiff_t n = 0; n < nbNodes; ++n)
+  {
+    if(_parents[n].load(std::memory_order_relaxed) == static_cast<std::uint64_t>(n))
+    {
+      _parents[n].store(trackIdFlag | trackRoots.size(), std::memory_order_relaxed);
+      trackRoots.push_back(n);
+    }
+  }
+
+  #pragma omp parallel for if(multithreaded)
+  for(std::ptrdiff_t n = 0; n < nbNodes; ++n)
+  {
+    const std::uint64_t parent = _parents[n].load(std::memory_order_relaxed);
+    if(!(parent & trackIdFlag))
+      _parents[n].store(_parents[parent].load(std::memory_order_relaxed), std::memory_order_relaxed);
+  }
+
+  // count the observations and detect the forks, nodes are visited by increasing view id
+  const std::size_t nbTracks = trackRoots.size();
+  const std::uint32_t invalidIndex = std::numeric_limits<std::uint32_t>::max();
+  std::vector<std::uint32_t> trackLengths(nbTracks, 0);
+  std::vector<std::uint32_t> trackNbViews(nbTracks, 0);
+  std::vector<IndexT> lastViews(nbTracks, UndefinedIndexT);
+  std::vector<char> forks(nbTracks, 0);
+
+  for(const ViewDescNodes& nodes : _viewDescNodes)
+  {
+    std::size_t node = nodes.firstNode;
+    for(std::uint64_t bits : nodes.bits)
+    {
+      for(; bits != 0; bits &= bits - 1, ++node)
+      {
+        const std::size_t trackId = _parents[node].load(std::memory_order_relaxed) & ~trackIdFlag;
+        ++trackLengths[trackId];
+        if(lastViews[trackId] == nodes.viewId)
+          forks[trackId] = 1;
+        else
+          ++trackNbViews[trackId];
+        lastViews[trackId] = nodes.viewId;
+      }
+    }
+  }
+
+  // lastViews is reused to store the output track ids
+  std::vector<std::uint32_t>& outputTrackIds = lastViews;
+  for(std::size_t t = 0; t < nbTracks; ++t)
+  {
+    // as TracksBuilder, the track length is its number of views
+    if(trackNbViews[t] < minTrackLength || (clearForks && forks[t]))
+    {
+      outputTrackIds[t] = invalidIndex;
+      continue;
+    }
+    outputTrackIds[t] = static_cast<std::uint32_t>(tracks.offsets.size() - 1);
+    tracks.offsets.push_back(tracks.offsets.back() + trackLengths[t]);
+  }
+  std::vector<char>().swap(forks);
+  std::vector<std::uint32_t>().swap(trackNbViews);
+  std::vector<std::uint32_t>().swap(trackLengths);
+
+  const std::size_t nbOutputTracks = tracks.offsets.size() - 1;
+  tracks.descTypes.resize(nbOutputTracks);
+  tracks.viewIds.resize(tracks.offsets.back());
+  tracks.featIds.resize(tracks.offsets.back());
+
+  std::vector<std::size_t> cursors(tracks.offsets.begin(), tracks.offsets.end() - 1);
+  for(const ViewDescNodes& nodes : _viewDescNodes)
+  {
+    std::size_t node = nodes.firstNode;
+    for(std::size_t w = 0; w < nodes.bits.size(); ++w)
+    {
+      for(std::uint64_t bits = nodes.bits[w]; bits != 0; bits &= bits - 1, ++node)
+      {
+        const std::uint32_t trackId = outputTrackIds[_parents[node].load(std::memory_order_relaxed) & ~trackIdFlag];
+        if(trackId == invalidIndex)
+          continue;
+        const std::size_t i = cursors[trackId]++;
+        tracks.viewIds[i] = nodes.viewId;
+        tracks.featIds[i] = static_cast<IndexT>(w * 64 + lowestBit64(bits));
+        tracks.descTypes[trackId] = nodes.descType;
+      }
+    }
+  }
+
+  // restore the union-find forest
+  #pragma omp parallel for if(multithreaded)
+  for(std::ptrdiff_t n = 0; n < nbNodes; ++n)
+    _parents[n].store(trackRoots[_parents[n].load(std::memory_order_relaxed) & ~trackIdFlag], std::memory_order_relaxed);
+}
+
+void StreamingTracksBuilder::exportToSTL(TracksMap& tracks, bool clearForks, std::size_t minTrackLength, bool multithreaded)
+{
+  TracksCSR tracksCSR;
+  exportToCSR(tracksCSR, clearForks, minTrackLength, multithreaded);
+  tracksCSR.toTracksMap(tracks);
+}
+
+std::size_t StreamingTracksBuilder::nbTracks() const
+{
+  std::size_t nbRoots = 0;
+  for(std::size_t n = 0; n < _nbNodes; ++n)
+  {
+    if(_parents[n].load(std::memory_order_relaxed) == n)
+      ++nbRoots;
+  }
+  return nbRoots;
+}
+
+} // namespace track
+} // namespace aliceVision
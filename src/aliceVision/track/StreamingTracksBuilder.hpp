@@ -0,0 +1,171 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/track/Track.hpp>
+#include <aliceVision/matching/matchesBinIO.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace track {
+
+/**
+ * @brief Random access to a series of pairwise matches, one pair at a time.
+ */
+class IMatchesStream
+{
+public:
+  virtual ~IMatchesStream() = default;
+
+  virtual std::size_t getNbPairs() const = 0;
+
+  /**
+   * @brief Get the matches of a pair, must be thread-safe.
+   * @param[in] pairIndex The pair index in [0, getNbPairs()[
+   * @param[out] pair The image pair
+   * @param[in,out] buffer Storage that can be used by the implementation to load the matches
+   * @return the matches of the pair (either buffer or data owned by the stream)
+   */
+  virtual const MatchesPerDescType& read(std::size_t pairIndex, Pair& pair, MatchesPerDescType& buffer) const = 0;
+};
+
+/**
+ * @brief Stream over matches already loaded in memory.
+ */
+class PairwiseMatchesStream : public IMatchesStream
+{
+public:
+  explicit PairwiseMatchesStream(const PairwiseMatches& pairwiseMatches);
+
+  std::size_t getNbPairs() const override { return _pairs.size(); }
+
+  const MatchesPerDescType& read(std::size_t pairIndex, Pair& pair, MatchesPerDescType& buffer) const override;
+
+private:
+  std::vector<PairwiseMatches::const_pointer> _pairs;
+};
+
+/**
+ * @brief Stream over binary matches files (.bin), the pairs are read from the
+ *        memory-mapped files when needed.
+ */
+class MatchesBinFilesStream : public IMatchesStream
+{
+public:
+  explicit MatchesBinFilesStream(const std::vector<std::string>& filepaths);
+
+  std::size_t getNbPairs() const override { return _firstPairIndex.back(); }
+
+  const MatchesPerDescType& read(std::size_t pairIndex, Pair& pair, MatchesPerDescType& buffer) const override;
+
+private:
+  std::vector<std::unique_ptr<matching::MatchesBinReader>> _readers;
+  /// index of the first pair of each file (nbFiles + 1 values)
+  std::vector<std::size_t> _firstPairIndex;
+};
+
+/**
+ * @brief Create tracks from pairwise matches streamed pair by pair.
+ *
+ * Same tracks as TracksBuilder with a much smaller memory footprint:
+ * - matches are read twice from the stream (nodes registration, then unions)
+ *   and never need to be fully loaded,
+ * - a node is only created for matched features and is identified by its rank
+ *   in a per-view bitset of the matched features, there is no node map,
+ * - the union-find is a single 64-bit word per node, updated lock-free
+ *   (linking by random priority and path halving), so the unions can be done in parallel,
+ * - tracks are exported in a compressed sparse row layout (TracksCSR).
+ *
+ * Usage:
+ * @code{.cpp}
+ *  MatchesBinFilesStream matchesStream({"0.matches.bin", "1.matches.bin"});
+ *  StreamingTracksBuilder tracksBuilder;
+ *  tracksBuilder.build(matchesStream);
+ *  TracksCSR tracks;
+ *  tracksBuilder.exportToCSR(tracks); // remove forks and tracks shorter than 2
+ * @endcode
+ */
+class StreamingTracksBuilder
+{
+public:
+  StreamingTracksBuilder();
+  ~StreamingTracksBuilder();
+
+  /**
+   * @brief Build tracks from a stream of pairwise matches
+   * @param[in] matchesStream The pairwise matches stream
+   * @param[in] multithreaded Read the pairs and make the unions in parallel
+   */
+  void build(const IMatchesStream& matchesStream, bool multithreaded = true);
+
+  /**
+   * @brief Build tracks from pairwise matches loaded in memory
+   * @param[in] pairwiseMatches PairWise matches
+   * @param[in] multithreaded Make the unions in parallel
+   */
+  void build(const PairwiseMatches& pairwiseMatches, bool multithreaded = true);
+
+  /**
+   * @brief Export the tracks in a compressed sparse row layout, tracks are numbered from 0
+   * @param[out] tracks The output tracks
+   * @param[in] clearForks Remove tracks with multiple observations in a single image
+   * @param[in] minTrackLength Minimal number of views to keep the track
+   * @param[in] multithreaded Is multithreaded
+   * @note Not const: the union-find forest is fully compressed and used as scratch memory during the export.
+   */
+  void exportToCSR(TracksCSR& tracks, bool clearForks = true, std::size_t minTrackLength = 2, bool multithreaded = true);
+
+  /**
+   * @brief Export the tracks as a map, see exportToCSR
+   */
+  void exportToSTL(TracksMap& tracks, bool clearForks = true, std::size_t minTrackLength = 2, bool multithreaded = true);
+
+  /**
+   * @brief Return the number of tracks before filtering
+   */
+  std::size_t nbTracks() const;
+
+  /**
+   * @brief Return the number of nodes, i.e. the number of matched features
+   */
+  std::size_t nbNodes() const { return _nbNodes; }
+
+private:
+  /// Matched features of a view for a describer type
+  struct ViewDescNodes
+  {
+    IndexT viewId;
+    feature::EImageDescriberType descType;
+    /// bitset of the matched features
+    std::vector<std::uint64_t> bits;
+    /// number of matched features before each word of the bitset
+    std::vector<std::uint32_t> ranks;
+    /// node id of the first matched feature
+    std::size_t firstNode;
+
+    std::size_t nodeId(IndexT featId) const;
+  };
+
+  const ViewDescNodes& getViewDescNodes(IndexT viewId, feature::EImageDescriberType descType) const;
+
+  std::size_t find(std::size_t node);
+  void unite(std::size_t nodeA, std::size_t nodeB);
+
+  /// sorted by (viewId, descType), so nodes are ordered by (viewId, descType, featId)
+  std::vector<ViewDescNodes> _viewDescNodes;
+  std::size_t _nbNodes = 0;
+  /// union-find forest: parent of each node (a root is its own parent), compressed on find
+  std::unique_ptr<std::atomic<std::uint64_t>[]> _parents;
+};
+
+} // namespace track
+} // namespace aliceVision
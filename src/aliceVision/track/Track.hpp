@@ -8,6 +8,7 @@
 #pragma once
 
 #include <aliceVision/config.hpp>
+#include <aliceVision/types.hpp>
 #include <aliceVision/feature/imageDescriberCommon.hpp>
 #include <aliceVision/matching/IndMatch.hpp>
 #include <aliceVision/stl/FlatMap.hpp>
@@ -79,6 +80,55 @@ struct Track
 using TracksMap = stl::flat_map<std::size_t, Track>;
 using TrackIdSet = std::vector<std::size_t>;
 
+/**
+ * @brief Tracks stored in a compressed sparse row layout.
+ * The observations of the track t are in [offsets[t], offsets[t+1][ of the viewIds and featIds arrays,
+ * sorted by view id. It avoids one allocation per track compared to TracksMap.
+ */
+struct TracksCSR
+{
+  /// Observations range of each track (nbTracks + 1 values)
+  std::vector<std::size_t> offsets{0};
+  /// View id of each observation
+  std::vector<IndexT> viewIds;
+  /// Feature id of each observation
+  std::vector<IndexT> featIds;
+  /// Descriptor type of each track
+  std::vector<feature::EImageDescriberType> descTypes;
+
+  std::size_t nbTracks() const { return descTypes.size(); }
+
+  std::size_t nbObservations() const { return viewIds.size(); }
+
+  std::size_t trackLength(std::size_t trackId) const { return offsets[trackId + 1] - offsets[trackId]; }
+
+  void clear()
+  {
+    offsets.assign(1, 0);
+    viewIds.clear();
+    featIds.clear();
+    descTypes.clear();
+  }
+
+  /**
+   * @brief Convert to the TracksMap representation, track ids are kept.
+   * @param[out] tracks The tracks map
+   */
+  void toTracksMap(TracksMap& tracks) const
+  {
+    tracks.clear();
+    tracks.reserve(nbTracks());
+    for(std::size_t trackId = 0; trackId < nbTracks(); ++trackId)
+    {
+      Track& track = tracks.emplace_hint(tracks.end(), trackId, Track())->second;
+      track.descType = descTypes[trackId];
+      track.featPerView.reserve(trackLength(trackId));
+      for(std::size_t i = offsets[trackId]; i < offsets[trackId + 1]; ++i)
+        track.featPerView.emplace_hint(track.featPerView.end(), viewIds[i], featIds[i]);
+    }
+  }
+};
+
 /**
  * @brief Data structure that contains for each features of each view, its corresponding cell positions for each level of the pyramid, i.e.
  * for each view:
@@ -0,0 +1,107 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "TracksStore.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace aliceVision {
+namespace track {
+
+TracksStore::TracksStore(const TracksCSR& tracks)
+{
+  _descTypes = tracks.descTypes;
+  _trackOffsets.reserve(tracks.nbTracks() + 1);
+  _observations.reserve(tracks.nbObservations());
+
+  for(std::size_t trackId = 0; trackId < tracks.nbTracks(); ++trackId)
+  {
+    const std::size_t begin = _observations.size();
+    for(std::size_t i = tracks.offsets[trackId]; i < tracks.offsets[trackId + 1]; ++i)
+    {
+      // observations are sorted by view, a fork has consecutive observations in the same view
+      if(_observations.size() > begin && _observations.back().first == tracks.viewIds[i])
+        throw std::invalid_argument("Can't store the tracks, the track " + std::to_string(trackId) + " has several features in the view " + std::to_string(tracks.viewIds[i]) + " (fork).");
+      _observations.emplace_back(tracks.viewIds[i], tracks.featIds[i]);
+    }
+    _trackOffsets.push_back(_observations.size());
+  }
+  buildViewIndex();
+}
+
+TracksStore::TracksStore(const TracksMap& tracks)
+{
+  _descTypes.reserve(tracks.size());
+  _trackOffsets.reserve(tracks.size() + 1);
+
+  std::size_t nbObservations = 0;
+  for(const auto& trackIt : tracks)
+    nbObservations += trackIt.second.featPerView.size();
+  _observations.reserve(nbObservations);
+
+  for(const auto& trackIt : tracks)
+  {
+    if(trackIt.first != _descTypes.size())
+      throw std::invalid_argument("Can't store the tracks, the track ids should be contiguous from 0 (invalid track id " + std::to_string(trackIt.first) + ").");
+
+    _descTypes.push_back(trackIt.second.descType);
+    for(const auto& featView : trackIt.second.featPerView)
+      _observations.emplace_back(static_cast<IndexT>(featView.first), static_cast<IndexT>(featView.second));
+    _trackOffsets.push_back(_observations.size());
+  }
+  buildViewIndex();
+}
+
+void TracksStore::clear()
+{
+  _trackOffsets.assign(1, 0);
+  _observations.clear();
+  _descTypes.clear();
+  _viewIds.clear();
+  _viewIndexes.clear();
+  _viewOffsets.assign(1, 0);
+  _viewTrackIds.clear();
+  _viewFeatIds.clear();
+}
+
+void TracksStore::buildViewIndex()
+{
+  _viewIds.clear();
+  for(const TrackObservation& observation : _observations)
+    _viewIds.push_back(observation.first);
+  std::sort(_viewIds.begin(), _viewIds.end());
+  _viewIds.erase(std::unique(_viewIds.begin(), _viewIds.end()), _viewIds.end());
+
+  _viewIndexes.clear();
+  _viewIndexes.reserve(_viewIds.size());
+  for(std::size_t i = 0; i < _viewIds.size(); ++i)
+    _viewIndexes.emplace(_viewIds[i], i);
+
+  // counting sort of the observations by view, tracks are visited by increasing id
+  std::vector<std::size_t> cursors(_viewIds.size() + 1, 0);
+  for(const TrackObservation& observation : _observations)
+    ++cursors[_viewIndexes.at(observation.first) + 1];
+  for(std::size_t i = 1; i < cursors.size(); ++i)
+    cursors[i] += cursors[i - 1];
+  _viewOffsets = cursors;
+
+  _viewTrackIds.resize(_observations.size());
+  _viewFeatIds.resize(_observations.size());
+  for(std::size_t trackId = 0; trackId < size(); ++trackId)
+  {
+    for(std::size_t i = _trackOffsets[trackId]; i < _trackOffsets[trackId + 1]; ++i)
+    {
+      const std::size_t position = cursors[_viewIndexes.at(_observations[i].first)]++;
+      _viewTrackIds[position] = static_cast<IndexT>(trackId);
+      _viewFeatIds[position] = _observations[i].second;
+    }
+  }
+}
+
+} // namespace track
+} // namespace aliceVision
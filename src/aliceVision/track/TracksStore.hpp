@@ -0,0 +1,220 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/track/Track.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace aliceVision {
+namespace track {
+
+/// Observation of a track: {ViewId, FeatureId}
+using TrackObservation = std::pair<IndexT, IndexT>;
+
+/**
+ * @brief Read-only access to the observations of a track, sorted by view id.
+ * Same interface as Track::FeatureIdPerView for lookups and iterations.
+ */
+class TrackFeatures
+{
+public:
+  using const_iterator = const TrackObservation*;
+  using iterator = const_iterator;
+
+  TrackFeatures(const TrackObservation* begin, const TrackObservation* end)
+    : _begin(begin)
+    , _end(end)
+  {}
+
+  const_iterator begin() const { return _begin; }
+  const_iterator end() const { return _end; }
+  std::size_t size() const { return _end - _begin; }
+  bool empty() const { return _begin == _end; }
+
+  const_iterator find(IndexT viewId) const
+  {
+    const_iterator it = std::lower_bound(_begin, _end, viewId,
+      [](const TrackObservation& observation, IndexT v) { return observation.first < v; });
+    return (it != _end && it->first == viewId) ? it : _end;
+  }
+
+  std::size_t count(IndexT viewId) const { return find(viewId) != _end; }
+
+  IndexT at(IndexT viewId) const
+  {
+    const_iterator it = find(viewId);
+    if(it == _end)
+      throw std::out_of_range("The view " + std::to_string(viewId) + " is not in the track.");
+    return it->second;
+  }
+
+private:
+  const TrackObservation* _begin;
+  const TrackObservation* _end;
+};
+
+/**
+ * @brief Read-only access to a track of a TracksStore, same members as Track.
+ */
+struct TrackRef
+{
+  feature::EImageDescriberType descType;
+  TrackFeatures featPerView;
+};
+
+/**
+ * @brief Tracks and visible tracks per view stored in contiguous arrays.
+ *
+ * The observations of all the tracks are in a single array (compressed sparse row layout),
+ * the reverse index lists for each view its tracks (sorted by track id) and the corresponding features.
+ * Track ids are contiguous from 0 so a track is accessed in O(1) and the iteration
+ * over the store gives the same {trackId, track} pairs as TracksMap.
+ */
+class TracksStore
+{
+public:
+  using value_type = std::pair<std::size_t, TrackRef>;
+
+  class const_iterator
+  {
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = TracksStore::value_type;
+    using difference_type = std::ptrdiff_t;
+    using reference = value_type;
+
+    struct pointer
+    {
+      value_type value;
+      const value_type* operator->() const { return &value; }
+    };
+
+    const_iterator() = default;
+    const_iterator(const TracksStore* store, std::size_t trackId)
+      : _store(store)
+      , _trackId(trackId)
+    {}
+
+    reference operator*() const { return value_type(_trackId, _store->at(_trackId)); }
+    pointer operator->() const { return pointer{**this}; }
+
+    const_iterator& operator++() { ++_trackId; return *this; }
+    const_iterator operator++(int) { const_iterator it = *this; ++_trackId; return it; }
+    const_iterator& operator--() { --_trackId; return *this; }
+    const_iterator operator--(int) { const_iterator it = *this; --_trackId; return it; }
+    const_iterator& operator+=(difference_type n) { _trackId += n; return *this; }
+    const_iterator& operator-=(difference_type n) { _trackId -= n; return *this; }
+    const_iterator operator+(difference_type n) const { return const_iterator(_store, _trackId + n); }
+    const_iterator operator-(difference_type n) const { return const_iterator(_store, _trackId - n); }
+    difference_type operator-(const const_iterator& other) const { return difference_type(_trackId) - difference_type(other._trackId); }
+    reference operator[](difference_type n) const { return *(*this + n); }
+
+    bool operator==(const const_iterator& other) const { return _trackId == other._trackId; }
+    bool operator!=(const const_iterator& other) const { return _trackId != other._trackId; }
+    bool operator<(const const_iterator& other) const { return _trackId < other._trackId; }
+
+  private:
+    const TracksStore* _store = nullptr;
+    std::size_t _trackId = 0;
+  };
+  using iterator = const_iterator;
+
+  /**
+   * @brief Tracks visible in a view, sorted by track id, with the corresponding feature ids.
+   */
+  struct ViewTracks
+  {
+    const IndexT* trackIds;
+    const IndexT* featIds;
+    std::size_t size;
+
+    const IndexT* begin() const { return trackIds; }
+    const IndexT* end() const { return trackIds + size; }
+    bool empty() const { return size == 0; }
+  };
+
+  TracksStore() = default;
+
+  /**
+   * @brief Build from tracks in a compressed sparse row layout (e.g. from StreamingTracksBuilder).
+   * @throw std::invalid_argument if a track has several observations in a view (fork),
+   *        forks are removed by StreamingTracksBuilder::exportToCSR with clearForks
+   */
+  explicit TracksStore(const TracksCSR& tracks);
+
+  /**
+   * @brief Build from a tracks map.
+   * @throw std::invalid_argument if the track ids are not contiguous from 0
+   */
+  explicit TracksStore(const TracksMap& tracks);
+
+  std::size_t size() const { return _descTypes.size(); }
+  bool empty() const { return _descTypes.empty(); }
+  std::size_t nbObservations() const { return _observations.size(); }
+
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, size()); }
+
+  std::size_t count(std::size_t trackId) const { return trackId < size(); }
+  const_iterator find(std::size_t trackId) const { return trackId < size() ? const_iterator(this, trackId) : end(); }
+
+  TrackRef at(std::size_t trackId) const
+  {
+    if(trackId >= size())
+      throw std::out_of_range("Invalid track id " + std::to_string(trackId) + ".");
+    return TrackRef{_descTypes[trackId],
+                    TrackFeatures(_observations.data() + _trackOffsets[trackId],
+                                  _observations.data() + _trackOffsets[trackId + 1])};
+  }
+
+  /// Sorted ids of the views with at least one track
+  const std::vector<IndexT>& getViewIds() const { return _viewIds; }
+
+  /**
+   * @brief Get the tracks visible in a view, empty if the view has no track.
+   */
+  ViewTracks getViewTracks(IndexT viewId) const
+  {
+    const auto it = _viewIndexes.find(viewId);
+    if(it == _viewIndexes.end())
+      return ViewTracks{nullptr, nullptr, 0};
+    const std::size_t begin = _viewOffsets[it->second];
+    return ViewTracks{_viewTrackIds.data() + begin, _viewFeatIds.data() + begin, _viewOffsets[it->second + 1] - begin};
+  }
+
+  void clear();
+
+private:
+  /// Build the reverse index from the tracks
+  void buildViewIndex();
+
+  /// Observations range of each track (nbTracks + 1 values)
+  std::vector<std::size_t> _trackOffsets{0};
+  /// Observations of all the tracks, sorted by view id in each track
+  std::vector<TrackObservation> _observations;
+  std::vector<feature::EImageDescriberType> _descTypes;
+
+  /// Sorted view ids
+  std::vector<IndexT> _viewIds;
+  /// Index of each view id in _viewIds
+  std::unordered_map<IndexT, std::size_t> _viewIndexes;
+  /// Tracks range of each view (nbViews + 1 values)
+  std::vector<std::size_t> _viewOffsets{0};
+  std::vector<IndexT> _viewTrackIds;
+  std::vector<IndexT> _viewFeatIds;
+};
+
+} // namespace track
+} // namespace aliceVision
@@ -6,9 +6,19 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "aliceVision/track/TracksBuilder.hpp"
+#include "aliceVision/track/StreamingTracksBuilder.hpp"
+#include "aliceVision/track/TracksStore.hpp"
 #include "aliceVision/track/tracksUtils.hpp"
 #include "aliceVision/matching/IndMatch.hpp"
+#include "aliceVision/matching/matchesBinIO.hpp"
 
+#include <boost/filesystem.hpp>
+
+#include <atomic>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
 #include <vector>
 #include <utility>
 
@@ -17,10 +27,30 @@
 #include <boost/test/unit_test.hpp>
 #include <boost/test/tools/floating_point_comparison.hpp>
 
+using namespace aliceVision;
 using namespace aliceVision::feature;
 using namespace aliceVision::track;
 using namespace aliceVision::matching;
 
+namespace fs = boost::filesystem;
+
+/// Tracks content without the track ids, to compare tracks builders
+std::set<std::vector<std::pair<std::size_t, std::size_t>>> tracksContent(const TracksMap& tracks, bool viewsOnly = false)
+{
+  std::set<std::vector<std::pair<std::size_t, std::size_t>>> content;
+  for(const auto& trackIt : tracks)
+  {
+    std::vector<std::pair<std::size_t, std::size_t>> track(trackIt.second.featPerView.begin(), trackIt.second.featPerView.end());
+    if(viewsOnly)
+    {
+      for(auto& observation : track)
+        observation.second = 0;
+    }
+    content.insert(track);
+  }
+  return content;
+}
+
 
 BOOST_AUTO_TEST_CASE(Track_Simple) {
 
@@ -228,3 +258,291 @@ BOOST_AUTO_TEST_CASE(Track_GetCommonTracksInImages)
     BOOST_CHECK_EQUAL(base.size(), set_visibleTracks.size());
   }
 }
+
+BOOST_AUTO_TEST_CASE(StreamingTrack_Conflict) {
+
+  //A    B    C
+  //0 -> 0 -> 0
+  //1 -> 1 -> 6
+  //{2 -> 3 -> 2
+  //      3 -> 8 } This track must be deleted, index 3 appears two times
+
+  PairwiseMatches map_pairwisematches;
+  map_pairwisematches[std::make_pair(0,1)][EImageDescriberType::UNKNOWN] = {IndMatch(0,0), IndMatch(1,1), IndMatch(2,3)};
+  map_pairwisematches[std::make_pair(1,2)][EImageDescriberType::UNKNOWN] = {IndMatch(0,0), IndMatch(1,6), IndMatch(3,2), IndMatch(3,8)};
+
+  StreamingTracksBuilder trackBuilder;
+  trackBuilder.build(map_pairwisematches);
+  BOOST_CHECK_EQUAL(10, trackBuilder.nbNodes());
+  BOOST_CHECK_EQUAL(3, trackBuilder.nbTracks());
+
+  TracksCSR tracks;
+  trackBuilder.exportToCSR(tracks, false, 0);
+  BOOST_CHECK_EQUAL(3, tracks.nbTracks());
+  BOOST_CHECK_EQUAL(10, tracks.nbObservations());
+
+  trackBuilder.exportToCSR(tracks, true, 2);
+  BOOST_CHECK_EQUAL(2, tracks.nbTracks());
+  // the union-find is still usable after an export
+  BOOST_CHECK_EQUAL(3, trackBuilder.nbTracks());
+
+  TracksMap map_tracks;
+  tracks.toTracksMap(map_tracks);
+
+  const std::set<std::vector<std::pair<std::size_t, std::size_t>>> GT_Tracks = {
+    {{0,0}, {1,0}, {2,0}},
+    {{0,1}, {1,1}, {2,6}}};
+  BOOST_CHECK(GT_Tracks == tracksContent(map_tracks));
+
+  for(std::size_t t = 0; t < tracks.nbTracks(); ++t)
+  {
+    BOOST_CHECK_EQUAL(3, tracks.trackLength(t));
+    BOOST_CHECK(tracks.descTypes[t] == EImageDescriberType::UNKNOWN);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(StreamingTrack_CompareTracksBuilder) {
+
+  // random matches between 12 views with 2 describer types
+  std::mt19937 randomNumberGenerator(7);
+  std::uniform_int_distribution<int> featureDistribution(0, 300);
+  PairwiseMatches map_pairwisematches;
+  for(std::size_t I = 0; I < 12; ++I)
+  {
+    for(std::size_t J = I + 1; J < 12; ++J)
+    {
+      for(EImageDescriberType descType : {EImageDescriberType::SIFT, EImageDescriberType::AKAZE})
+      {
+        IndMatches& matches = map_pairwisematches[std::make_pair(I, J)][descType];
+        for(int m = 0; m < 40; ++m)
+          matches.emplace_back(featureDistribution(randomNumberGenerator), featureDistribution(randomNumberGenerator));
+      }
+    }
+  }
+
+  for(bool clearForks : {false, true})
+  {
+    for(std::size_t minTrackLength : {2, 4})
+    {
+      TracksBuilder trackBuilder;
+      trackBuilder.build(map_pairwisematches);
+      trackBuilder.filter(clearForks, minTrackLength, false);
+      TracksMap expectedTracks;
+      trackBuilder.exportToSTL(expectedTracks);
+
+      for(bool multithreaded : {false, true})
+      {
+        StreamingTracksBuilder streamingTrackBuilder;
+        streamingTrackBuilder.build(map_pairwisematches, multithreaded);
+        TracksMap map_tracks;
+        streamingTrackBuilder.exportToSTL(map_tracks, clearForks, minTrackLength, multithreaded);
+
+        BOOST_CHECK_EQUAL(expectedTracks.size(), map_tracks.size());
+        // with forks, the feature kept in a view is not specified
+        BOOST_CHECK(tracksContent(expectedTracks, !clearForks) == tracksContent(map_tracks, !clearForks));
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(StreamingTrack_MatchesBinFiles) {
+
+  const std::string testFolder = "trackStreamingTestFolder";
+  fs::remove_all(testFolder);
+  fs::create_directory(testFolder);
+
+  //A    B    C
+  //0 -> 0 -> 0
+  //1 -> 1 -> 6
+  //2 -> 3
+  std::vector<std::string> filepaths = {(fs::path(testFolder) / "0.matches.bin").string(),
+                                        (fs::path(testFolder) / "1.matches.bin").string()};
+  {
+    MatchesPerDescType matchesAB;
+    matchesAB[EImageDescriberType::SIFT] = {IndMatch(0,0), IndMatch(1,1), IndMatch(2,3)};
+    MatchesBinWriter writer(filepaths[0]);
+    writer.append(std::make_pair(0,1), matchesAB);
+  }
+  {
+    MatchesPerDescType matchesBC;
+    matchesBC[EImageDescriberType::SIFT] = {IndMatch(0,0), IndMatch(1,6)};
+    MatchesBinWriter writer(filepaths[1]);
+    writer.append(std::make_pair(1,2), matchesBC);
+  }
+
+  {
+    MatchesBinFilesStream matchesStream(filepaths);
+    BOOST_CHECK_EQUAL(2, matchesStream.getNbPairs());
+
+    StreamingTracksBuilder trackBuilder;
+    trackBuilder.build(matchesStream);
+    TracksMap map_tracks;
+    trackBuilder.exportToSTL(map_tracks, true, 2);
+
+    const std::set<std::vector<std::pair<std::size_t, std::size_t>>> GT_Tracks = {
+      {{0,0}, {1,0}, {2,0}},
+      {{0,1}, {1,1}, {2,6}},
+      {{0,2}, {1,3}}};
+    BOOST_CHECK(GT_Tracks == tracksContent(map_tracks));
+    for(const auto& trackIt : map_tracks)
+      BOOST_CHECK(trackIt.second.descType == EImageDescriberType::SIFT);
+  }
+
+  fs::remove_all(testFolder);
+}
+
+/// Stream that fails on a given read, to check the errors raised by the parallel reads
+class FailingMatchesStream : public PairwiseMatchesStream
+{
+public:
+  FailingMatchesStream(const PairwiseMatches& pairwiseMatches, std::size_t failingRead)
+    : PairwiseMatchesStream(pairwiseMatches)
+    , _failingRead(failingRead)
+  {}
+
+  const MatchesPerDescType& read(std::size_t pairIndex, Pair& pair, MatchesPerDescType& buffer) const override
+  {
+    if(_nbReads++ == _failingRead)
+      throw std::runtime_error("Cannot read the matches of the pair " + std::to_string(pairIndex));
+    return PairwiseMatchesStream::read(pairIndex, pair, buffer);
+  }
+
+private:
+  std::size_t _failingRead;
+  mutable std::atomic<std::size_t> _nbReads{0};
+};
+
+BOOST_AUTO_TEST_CASE(StreamingTrack_ReadError) {
+
+  PairwiseMatches map_pairwisematches;
+  for(IndexT i = 0; i < 50; ++i)
+    map_pairwisematches[std::make_pair(i, i + 1)][EImageDescriberType::UNKNOWN] = {IndMatch(0,0), IndMatch(1,1)};
+  const std::size_t nbPairs = map_pairwisematches.size();
+
+  // the first pass reads each pair once, the second pass reads them again
+  for(std::size_t failingRead : {std::size_t(0), nbPairs / 2, nbPairs, nbPairs + nbPairs / 2, 2 * nbPairs - 1})
+  {
+    for(bool multithreaded : {false, true})
+    {
+      StreamingTracksBuilder trackBuilder;
+      BOOST_CHECK_THROW(trackBuilder.build(FailingMatchesStream(map_pairwisematches, failingRead), multithreaded), std::runtime_error);
+      BOOST_CHECK_EQUAL(0, trackBuilder.nbTracks());
+
+      // the builder can still be used after an error
+      trackBuilder.build(map_pairwisematches, multithreaded);
+      BOOST_CHECK_EQUAL(2, trackBuilder.nbTracks());
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(TracksStore_CompareTracksMap) {
+
+  std::mt19937 randomNumberGenerator(11);
+  std::uniform_int_distribution<int> featureDistribution(0, 200);
+  PairwiseMatches map_pairwisematches;
+  for(std::size_t I = 0; I < 8; ++I)
+  {
+    for(std::size_t J = I + 1; J < 8; ++J)
+    {
+      IndMatches& matches = map_pairwisematches[std::make_pair(I * 10, J * 10)][EImageDescriberType::SIFT];
+      for(int m = 0; m < 30; ++m)
+        matches.emplace_back(featureDistribution(randomNumberGenerator), featureDistribution(randomNumberGenerator));
+    }
+  }
+
+  TracksBuilder trackBuilder;
+  trackBuilder.build(map_pairwisematches);
+  trackBuilder.filter(true, 2, false);
+  TracksMap map_tracks;
+  trackBuilder.exportToSTL(map_tracks);
+
+  const TracksStore tracks(map_tracks);
+  BOOST_CHECK_EQUAL(map_tracks.size(), tracks.size());
+
+  // same iteration and lookups as the tracks map
+  TracksMap::const_iterator mapIt = map_tracks.begin();
+  for(const auto& trackIt : tracks)
+  {
+    BOOST_CHECK_EQUAL(mapIt->first, trackIt.first);
+    BOOST_CHECK(mapIt->second.descType == trackIt.second.descType);
+    BOOST_CHECK_EQUAL(mapIt->second.featPerView.size(), trackIt.second.featPerView.size());
+    BOOST_CHECK(std::equal(mapIt->second.featPerView.begin(), mapIt->second.featPerView.end(), trackIt.second.featPerView.begin(),
+      [](const std::pair<std::size_t, std::size_t>& a, const TrackObservation& b) { return a.first == b.first && a.second == b.second; }));
+
+    for(const auto& featView : mapIt->second.featPerView)
+      BOOST_CHECK_EQUAL(featView.second, tracks.at(trackIt.first).featPerView.at(featView.first));
+    BOOST_CHECK_EQUAL(0, trackIt.second.featPerView.count(5));
+    BOOST_CHECK_THROW(trackIt.second.featPerView.at(5), std::out_of_range);
+    ++mapIt;
+  }
+  BOOST_CHECK(tracks.find(tracks.size()) == tracks.end());
+  BOOST_CHECK_THROW(tracks.at(tracks.size()), std::out_of_range);
+
+  // reverse index
+  TracksPerView expectedTracksPerView;
+  computeTracksPerView(map_tracks, expectedTracksPerView);
+  TracksPerView tracksPerView;
+  computeTracksPerView(tracks, tracksPerView);
+  BOOST_CHECK(expectedTracksPerView == tracksPerView);
+
+  for(IndexT viewId : tracks.getViewIds())
+  {
+    const TracksStore::ViewTracks viewTracks = tracks.getViewTracks(viewId);
+    for(std::size_t i = 0; i < viewTracks.size; ++i)
+      BOOST_CHECK_EQUAL(map_tracks.at(viewTracks.trackIds[i]).featPerView.at(viewId), viewTracks.featIds[i]);
+  }
+  BOOST_CHECK(tracks.getViewTracks(5).empty());
+
+  // tracks utils
+  const std::set<std::size_t> imageIndexes = {10, 20};
+  TracksMap expectedCommonTracks, commonTracks;
+  getCommonTracksInImagesFast(imageIndexes, map_tracks, tracksPerView, expectedCommonTracks);
+  getCommonTracksInImagesFast(imageIndexes, tracks, tracksPerView, commonTracks);
+  BOOST_CHECK(tracksContent(expectedCommonTracks) == tracksContent(commonTracks));
+
+  std::map<std::size_t, std::size_t> expectedLengths, lengths;
+  tracksLength(map_tracks, expectedLengths);
+  tracksLength(tracks, lengths);
+  BOOST_CHECK(expectedLengths == lengths);
+
+  // the track ids must be contiguous
+  map_tracks.erase(map_tracks.begin());
+  BOOST_CHECK_THROW(TracksStore{map_tracks}, std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(TracksStore_FromCSR) {
+
+  //A    B    C
+  //0 -> 0 -> 0
+  //1 -> 1 -> 6
+  //{2 -> 3 -> 2
+  //      3 -> 8 } fork
+  PairwiseMatches map_pairwisematches;
+  map_pairwisematches[std::make_pair(0,1)][EImageDescriberType::UNKNOWN] = {IndMatch(0,0), IndMatch(1,1), IndMatch(2,3)};
+  map_pairwisematches[std::make_pair(1,2)][EImageDescriberType::UNKNOWN] = {IndMatch(0,0), IndMatch(1,6), IndMatch(3,2), IndMatch(3,8)};
+
+  StreamingTracksBuilder trackBuilder;
+  trackBuilder.build(map_pairwisematches);
+
+  // the fork is rejected
+  TracksCSR tracksCSR;
+  trackBuilder.exportToCSR(tracksCSR, false, 2);
+  BOOST_CHECK_EQUAL(10, tracksCSR.nbObservations());
+  BOOST_CHECK_THROW(TracksStore{tracksCSR}, std::invalid_argument);
+
+  // the fork is removed
+  trackBuilder.exportToCSR(tracksCSR, true, 2);
+  BOOST_CHECK_EQUAL(6, tracksCSR.nbObservations());
+
+  const TracksStore tracks(tracksCSR);
+  BOOST_CHECK_EQUAL(2, tracks.size());
+  BOOST_CHECK_EQUAL(6, tracks.nbObservations());
+  BOOST_CHECK((std::vector<IndexT>{0, 1, 2}) == tracks.getViewIds());
+
+  for(const auto& trackIt : tracks)
+  {
+    BOOST_CHECK_EQUAL(3, trackIt.second.featPerView.size());
+    BOOST_CHECK(trackIt.second.featPerView.at(0) != 2);
+  }
+  BOOST_CHECK_EQUAL(2, tracks.getViewTracks(2).size);
+}
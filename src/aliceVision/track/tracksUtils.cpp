@@ -89,10 +89,13 @@ void getCommonTracksInImages(const std::set<std::size_t>& imageIndexes,
   }
 }
 
-bool getCommonTracksInImagesFast(const std::set<std::size_t>& imageIndexes,
-                                 const TracksMap& tracksIn,
-                                 const TracksPerView& tracksPerView,
-                                 TracksMap& tracksOut)
+namespace {
+
+template <typename TracksT>
+bool getCommonTracksInImagesFastImpl(const std::set<std::size_t>& imageIndexes,
+                                     const TracksT& tracksIn,
+                                     const TracksPerView& tracksPerView,
+                                     TracksMap& tracksOut)
 {
   assert(!imageIndexes.empty());
   tracksOut.clear();
@@ -103,10 +106,9 @@ bool getCommonTracksInImagesFast(const std::set<std::size_t>& imageIndexes,
   // go along the tracks
   for(std::size_t visibleTrack: set_visibleTracks)
   {
-    TracksMap::const_iterator itTrackIn = tracksIn.find(visibleTrack);
-    if(itTrackIn == tracksIn.end())
+    if(!tracksIn.count(visibleTrack))
       continue;
-    const Track& trackFeatsIn = itTrackIn->second;
+    const auto& trackFeatsIn = tracksIn.at(visibleTrack);
     Track& trackFeatsOut = tracksOut[visibleTrack];
     trackFeatsOut.descType = trackFeatsIn.descType;
     for(std::size_t imageIndex: imageIndexes)
@@ -120,6 +122,53 @@ bool getCommonTracksInImagesFast(const std::set<std::size_t>& imageIndexes,
   return !tracksOut.empty();
 }
 
+template <typename TracksT>
+bool getFeatureIdInViewPerTrackImpl(const TracksT& allTracks,
+                                    const std::set<std::size_t>& trackIds,
+                                    IndexT viewId,
+                                    std::vector<FeatureId>* out_featId)
+{
+  for(std::size_t trackId: trackIds)
+  {
+    // ignore it if the track doesn't exist
+    if(!allTracks.count(trackId))
+      continue;
+
+    // try to find imageIndex
+    const auto& map_ref = allTracks.at(trackId);
+    auto iterSearch = map_ref.featPerView.find(viewId);
+    if(iterSearch != map_ref.featPerView.end())
+      out_featId->emplace_back(map_ref.descType, iterSearch->second);
+  }
+  return !out_featId->empty();
+}
+
+template <typename TracksT>
+void tracksLengthImpl(const TracksT& tracks,
+                      std::map<std::size_t, std::size_t>& occurenceTrackLength)
+{
+  for(const auto& trackIt : tracks)
+    ++occurenceTrackLength[trackIt.second.featPerView.size()];
+}
+
+} // namespace
+
+bool getCommonTracksInImagesFast(const std::set<std::size_t>& imageIndexes,
+                                 const TracksMap& tracksIn,
+                                 const TracksPerView& tracksPerView,
+                                 TracksMap& tracksOut)
+{
+  return getCommonTracksInImagesFastImpl(imageIndexes, tracksIn, tracksPerView, tracksOut);
+}
+
+bool getCommonTracksInImagesFast(const std::set<std::size_t>& imageIndexes,
+                                 const TracksStore& tracksIn,
+                                 const TracksPerView& tracksPerView,
+                                 TracksMap& tracksOut)
+{
+  return getCommonTracksInImagesFastImpl(imageIndexes, tracksIn, tracksPerView, tracksOut);
+}
+
 void getTracksInImages(const std::set<std::size_t>& imagesId,
                        const TracksMap& tracks,
                        std::set<std::size_t>& tracksId)
@@ -194,6 +243,16 @@ void computeTracksPerView(const TracksMap& tracks, TracksPerView& tracksPerView)
   }
 }
 
+void computeTracksPerView(const TracksStore& tracks, TracksPerView& tracksPerView)
+{
+  for(IndexT viewId : tracks.getViewIds())
+  {
+    const TracksStore::ViewTracks viewTracks = tracks.getViewTracks(viewId);
+    TrackIdSet& tracksSet = tracksPerView[viewId];
+    tracksSet.assign(viewTracks.begin(), viewTracks.end());
+  }
+}
+
 void getTracksIdVector(const TracksMap& tracks,
                               std::set<std::size_t>* tracksIds)
 {
@@ -207,21 +266,15 @@ bool getFeatureIdInViewPerTrack(const TracksMap& allTracks,
                                        IndexT viewId,
                                        std::vector<FeatureId>* out_featId)
 {
-  for(std::size_t trackId: trackIds)
-  {
-    TracksMap::const_iterator iterT = allTracks.find(trackId);
-
-    // ignore it if the track doesn't exist
-    if(iterT == allTracks.end())
-      continue;
+  return getFeatureIdInViewPerTrackImpl(allTracks, trackIds, viewId, out_featId);
+}
 
-    // try to find imageIndex
-    const Track& map_ref = iterT->second;
-    auto iterSearch = map_ref.featPerView.find(viewId);
-    if(iterSearch != map_ref.featPerView.end())
-      out_featId->emplace_back(map_ref.descType, iterSearch->second);
-  }
-  return !out_featId->empty();
+bool getFeatureIdInViewPerTrack(const TracksStore& allTracks,
+                                const std::set<std::size_t>& trackIds,
+                                IndexT viewId,
+                                std::vector<FeatureId>* out_featId)
+{
+  return getFeatureIdInViewPerTrackImpl(allTracks, trackIds, viewId, out_featId);
 }
 
 void tracksToIndexedMatches(const TracksMap& tracks,
@@ -253,15 +306,13 @@ void tracksToIndexedMatches(const TracksMap& tracks,
 void tracksLength(const TracksMap& tracks,
                          std::map<std::size_t, std::size_t>& occurenceTrackLength)
 {
-  for(TracksMap::const_iterator iterT = tracks.begin(); iterT != tracks.end(); ++iterT)
-  {
-    const std::size_t trLength = iterT->second.featPerView.size();
+  tracksLengthImpl(tracks, occurenceTrackLength);
+}
 
-    if(occurenceTrackLength.end() == occurenceTrackLength.find(trLength))
-      occurenceTrackLength[trLength] = 1;
-    else
-      occurenceTrackLength[trLength] += 1;
-  }
+void tracksLength(const TracksStore& tracks,
+                  std::map<std::size_t, std::size_t>& occurenceTrackLength)
+{
+  tracksLengthImpl(tracks, occurenceTrackLength);
 }
 
 void imageIdInTracks(const TracksPerView& tracksPerView,
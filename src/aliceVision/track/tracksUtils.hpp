@@ -7,6 +7,7 @@
 
 #pragma once
 #include <aliceVision/track/Track.hpp>
+#include <aliceVision/track/TracksStore.hpp>
 
 
 namespace aliceVision {
@@ -43,6 +44,11 @@ bool getCommonTracksInImagesFast(const std::set<std::size_t>& imageIndexes,
                                           const TracksMap& tracksIn,
                                           const TracksPerView& tracksPerView,
                                           TracksMap& tracksOut);
+
+bool getCommonTracksInImagesFast(const std::set<std::size_t>& imageIndexes,
+                                 const TracksStore& tracksIn,
+                                 const TracksPerView& tracksPerView,
+                                 TracksMap& tracksOut);
   
 /**
  * @brief Find all the visible tracks from a set of images.
@@ -91,6 +97,13 @@ void getTracksInImageFast(const std::size_t& imageId,
  */
 void computeTracksPerView(const TracksMap& tracks, TracksPerView& tracksPerView);
 
+/**
+ * @brief Compute the tracks of each view from the reverse index of the store, track ids are already sorted
+ * @param[in] tracks all tracks of the scene
+ * @param[out] tracksPerView : for each view the id of the visible tracks as a map {viewID, vector<trackID>}
+ */
+void computeTracksPerView(const TracksStore& tracks, TracksPerView& tracksPerView);
+
 /**
  * @brief Return the tracksId as a set (sorted increasing)
  * @param[in] tracks all tracks of the scene as a map {trackId, track}
@@ -112,6 +125,11 @@ bool getFeatureIdInViewPerTrack(const TracksMap& allTracks,
                                        IndexT viewId,
                                        std::vector<FeatureId>* out_featId);
 
+bool getFeatureIdInViewPerTrack(const TracksStore& allTracks,
+                                const std::set<std::size_t>& trackIds,
+                                IndexT viewId,
+                                std::vector<FeatureId>* out_featId);
+
 
 struct FunctorMapFirstEqual : public std::unary_function <TracksMap , bool>
 {
@@ -150,6 +168,9 @@ void tracksToIndexedMatches(const TracksMap& tracks,
 void tracksLength(const TracksMap& tracks,
                          std::map<std::size_t, std::size_t>& occurenceTrackLength);
 
+void tracksLength(const TracksStore& tracks,
+                  std::map<std::size_t, std::size_t>& occurenceTrackLength);
+
 /**
  * @brief Return a set containing the image Id considered in the tracks container.
  * @param[in] tracksPerView the visible tracks as a map {viewID, vector<trackID>}
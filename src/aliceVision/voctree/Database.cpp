@@ -5,9 +5,11 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "Database.hpp"
+#include <aliceVision/alicevision_omp.hpp>
 #include <boost/accumulators/accumulators.hpp>
 #include <boost/accumulators/statistics/tail.hpp>
 #include <boost/progress.hpp>
+#include <algorithm>
 #include <cmath>
 #include <fstream>
 #include <stdexcept>
@@ -16,6 +18,19 @@
 namespace aliceVision{
 namespace voctree{
 
+namespace {
+
+/// Distance methods computed with the inverted index
+bool isInvertedIndexMethod(const std::string& distanceMethod)
+{
+  return distanceMethod == "classic" ||
+         distanceMethod == "commonPoints" ||
+         distanceMethod == "strongCommonPoints" ||
+         distanceMethod == "tfidf";
+}
+
+} // namespace
+
 std::ostream& operator<<(std::ostream& os, const SparseHistogram &dv)	
 {
 	for( const auto &e : dv )
@@ -35,18 +50,27 @@ DocId Database::insert(DocId doc_id, const SparseHistogram& document)
   // Ensure that the new document to insert is not already there.
   assert(database_.find(doc_id) == database_.end());
 
-  // For each word, retrieve its inverted file and increment the count for doc_id.
+  const uint32_t docIndex = doc_ids_.size();
+  uint32_t docSize = 0;
+
+  // For each word, retrieve its inverted file and add the count for doc_id.
   for(SparseHistogram::const_iterator it = document.begin(), end = document.end(); it != end; ++it)
   {
-    Word word = it->first;
-    InvertedFile& file = word_files_[word];
-    if(file.empty() || file.back().id != doc_id)
-      file.push_back(WordFrequency(doc_id, it->second.size()));
-    else
-      file.back().count += it->second.size();
+    const Word word = it->first;
+    if(word >= word_files_.size())
+    {
+      word_files_.resize(word + 1);
+      word_weights_.resize(word + 1, 1.0f);
+    }
+    // a word appears once in a sparse histogram
+    word_files_[word].push_back(WordFrequency(docIndex, it->second.size()));
+    docSize += it->second.size();
   }
 
   database_[doc_id] = document;
+  doc_ids_.push_back(doc_id);
+  doc_sizes_.push_back(docSize);
+  doc_norms_.push_back(documentNorm(document));
 
   return doc_id;
 }
@@ -67,19 +91,12 @@ void Database::sanityCheck(std::size_t N, std::map<std::size_t, DocMatches>& mat
   }
 
   matches.clear();
-  // since we already know the size of the vectors, in order to parallelize the 
-  // query allocate the whole memory
-  boost::progress_display display(database_.size());
-  
-  //#pragma omp parallel for default(none) shared(database_)
-  for(const auto &doc : database_)
-  {
-    std::vector<DocMatch> m;
-    find(doc.second, N, m);
-    //		matches.emplace_back( m );
-    matches[doc.first] = m;
-    ++display;
-  }
+
+  std::map<DocId, DocMatches> matchesPerDoc;
+  find(database_, N, matchesPerDoc);
+
+  for(auto& docMatches : matchesPerDoc)
+    matches[docMatches.first].swap(docMatches.second);
 }
 
 /**
@@ -110,6 +127,13 @@ void Database::find(const std::vector<Word>& document, std::size_t N, std::vecto
  */
 void Database::find( const SparseHistogram& query, std::size_t N, std::vector<DocMatch>& matches, const std::string &distanceMethod) const
 {
+    if(isInvertedIndexMethod(distanceMethod))
+    {
+      std::vector<float> scores;
+      findInvertedIndex(query, N, matches, distanceMethod, scores);
+      return;
+    }
+
     matches.clear();
     matches.reserve(database_.size());
     for(const auto& document : database_)
@@ -124,6 +148,126 @@ void Database::find( const SparseHistogram& query, std::size_t N, std::vector<Do
     matches.resize(nMatches);
 }
 
+void Database::find(const SparseHistogramPerImage& queries, std::size_t N, std::map<DocId, DocMatches>& matches, const std::string& distanceMethod) const
+{
+  // check the distance method before the parallel loop (throw std::invalid_argument)
+  sparseDistance(SparseHistogram(), SparseHistogram(), distanceMethod);
+
+  const bool useInvertedIndex = isInvertedIndexMethod(distanceMethod);
+
+  matches.clear();
+  std::vector<const SparseHistogram*> queriesHistograms;
+  std::vector<DocMatches*> queriesMatches;
+  queriesHistograms.reserve(queries.size());
+  queriesMatches.reserve(queries.size());
+  for(const auto& query : queries)
+  {
+    queriesHistograms.push_back(&query.second);
+    queriesMatches.push_back(&matches[query.first]);
+  }
+
+  // scores buffer of each thread
+  std::vector<std::vector<float>> scoresPerThread(omp_get_max_threads());
+
+  #pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < queriesHistograms.size(); ++i)
+  {
+    if(useInvertedIndex)
+      findInvertedIndex(*queriesHistograms[i], N, *queriesMatches[i], distanceMethod, scoresPerThread[omp_get_thread_num()]);
+    else
+      find(*queriesHistograms[i], N, *queriesMatches[i], distanceMethod);
+  }
+}
+
+void Database::findInvertedIndex(const SparseHistogram& query, std::size_t N, DocMatches& matches,
+                                 const std::string& distanceMethod, std::vector<float>& scores) const
+{
+  const std::size_t nbDocs = doc_ids_.size();
+  matches.resize(nbDocs);
+
+  // Scores are accumulated over the words shared by the query and each document,
+  // in the word order, as sparseDistance would do.
+  if(distanceMethod == "tfidf")
+  {
+    // L1 distance between the L1-normalized TF-IDF vectors:
+    // |q - d| = |q| + |d| + sum over the shared words of (|q_i - d_i| - q_i - d_i)
+    const float queryNorm = documentNorm(query);
+    const float queryInvNorm = queryNorm > 0 ? 1.f / queryNorm : 0.f;
+
+    scores.resize(nbDocs);
+    for(std::size_t d = 0; d < nbDocs; ++d)
+      scores[d] = (queryNorm > 0 ? 1.f : 0.f) + (doc_norms_[d] > 0 ? 1.f : 0.f);
+
+    for(const auto& wordPair : query)
+    {
+      if(wordPair.first >= word_files_.size())
+        continue;
+      const float weight = word_weights_[wordPair.first];
+      const float q = wordPair.second.size() * weight * queryInvNorm;
+      for(const WordFrequency& wordFrequency : word_files_[wordPair.first])
+      {
+        const float docNorm = doc_norms_[wordFrequency.docIndex];
+        const float d = wordFrequency.count * weight * (docNorm > 0 ? 1.f / docNorm : 0.f);
+        scores[wordFrequency.docIndex] += std::abs(q - d) - q - d;
+      }
+    }
+
+    for(std::size_t d = 0; d < nbDocs; ++d)
+      matches[d] = DocMatch(doc_ids_[d], scores[d]);
+  }
+  else
+  {
+    // number of features shared with each document
+    scores.assign(nbDocs, 0.f);
+
+    if(distanceMethod == "strongCommonPoints")
+    {
+      // words seen once in both documents
+      for(const auto& wordPair : query)
+      {
+        if(wordPair.first >= word_files_.size() || wordPair.second.size() != 1)
+          continue;
+        for(const WordFrequency& wordFrequency : word_files_[wordPair.first])
+        {
+          if(wordFrequency.count == 1)
+            scores[wordFrequency.docIndex] += 1;
+        }
+      }
+    }
+    else
+    {
+      for(const auto& wordPair : query)
+      {
+        if(wordPair.first >= word_files_.size())
+          continue;
+        const uint32_t queryCount = wordPair.second.size();
+        for(const WordFrequency& wordFrequency : word_files_[wordPair.first])
+          scores[wordFrequency.docIndex] += std::min(queryCount, wordFrequency.count);
+      }
+    }
+
+    if(distanceMethod == "classic")
+    {
+      // |q - d| = |q| + |d| - 2 * sum over the shared words of min(q_i, d_i)
+      uint64_t querySize = 0;
+      for(const auto& wordPair : query)
+        querySize += wordPair.second.size();
+
+      for(std::size_t d = 0; d < nbDocs; ++d)
+        matches[d] = DocMatch(doc_ids_[d], static_cast<float>(querySize + doc_sizes_[d] - 2 * static_cast<uint64_t>(scores[d])));
+    }
+    else
+    {
+      for(std::size_t d = 0; d < nbDocs; ++d)
+        matches[d] = DocMatch(doc_ids_[d], - scores[d]);
+    }
+  }
+
+  const std::size_t nMatches = std::min(N, matches.size());
+  std::partial_sort(matches.begin(), matches.begin() + nMatches, matches.end());
+  matches.resize(nMatches);
+}
+
 /**
  * @brief Compute the TF-IDF weights of all the words. To be called after inserting a corpus of
  * training examples into the database.
@@ -142,6 +286,22 @@ void Database::computeTfIdfWeights(float default_weight)
     else
       word_weights_[i] = default_weight;
   }
+  computeDocumentNorms();
+}
+
+void Database::computeDocumentNorms()
+{
+  std::size_t docIndex = 0;
+  for(const DocId docId : doc_ids_)
+    doc_norms_[docIndex++] = documentNorm(database_.at(docId));
+}
+
+float Database::documentNorm(const SparseHistogram& document) const
+{
+  float norm = 0.0f;
+  for(const auto& wordPair : document)
+    norm += wordPair.second.size() * (wordPair.first < word_weights_.size() ? word_weights_[wordPair.first] : 1.0f);
+  return norm;
 }
 
 void Database::saveWeights(const std::string& file) const
@@ -162,14 +322,19 @@ void Database::loadWeights(const std::string& file)
     in.open(file.c_str(), std::ios_base::binary);
     uint32_t num_words = 0;
     in.read((char*) (&num_words), sizeof (uint32_t));
-    word_files_.resize(num_words); // Inverted files start out empty
     word_weights_.resize(num_words);
     in.read((char*) (&word_weights_[0]), num_words * sizeof (float));
+    // keep the inverted files of the documents already inserted
+    if(word_files_.size() > num_words)
+      word_weights_.resize(word_files_.size(), 1.0f);
+    else
+      word_files_.resize(num_words);
   }
   catch(std::ifstream::failure& e)
   {
     throw std::runtime_error((boost::format("Failed to load vocabulary weights file '%s'") % file).str());
   }
+  computeDocumentNorms();
 }
 
 ///**
@@ -11,7 +11,9 @@
 
 #include <map>
 #include <cstddef>
+#include <cstdint>
 #include <string>
+#include <vector>
 
 namespace aliceVision{
 namespace voctree{
@@ -33,9 +35,10 @@ struct DocMatch
   {}
 
   /// Allows sorting DocMatches in best-to-worst order with std::sort.
+  /// Equal scores are sorted by id, so the order does not depend on the sort algorithm.
   bool operator<(const DocMatch& other) const
   {
-    return score < other.score;
+    return score < other.score || (score == other.score && id < other.id);
   }
 
   bool operator==(const DocMatch& other) const
@@ -54,6 +57,11 @@ typedef std::vector<DocMatch> DocMatches;
 /**
  * @brief Class for efficiently matching a bag-of-words representation of a document (image) against
  * a database of known documents.
+ *
+ * The database keeps an inverted index (for each word, the list of the documents containing it),
+ * so the "classic", "commonPoints", "strongCommonPoints" and "tfidf" distances are only accumulated
+ * over the words shared by the query and each document. The other distance methods compare
+ * the query with every document histogram.
  */
 class Database
 {
@@ -104,6 +112,16 @@ public:
    */
   void find(const SparseHistogram& query, std::size_t N, std::vector<DocMatch>& matches, const std::string &distanceMethod = "strongCommonPoints") const;
 
+  /**
+   * @brief Find the top N matches in the database for several query documents, in parallel.
+   *
+   * @param[in] queries The query documents, normalized sets of quantized words.
+   * @param[in] N The number of matches to return per query.
+   * @param[out] matches IDs and scores for the top N matching database documents, per query.
+   * @param[in] distanceMethod distance method (norm L1, etc.)
+   */
+  void find(const SparseHistogramPerImage& queries, std::size_t N, std::map<DocId, DocMatches>& matches, const std::string &distanceMethod = "strongCommonPoints") const;
+
   /**
    * @brief Compute the TF-IDF weights of all the words. To be called after inserting a corpus of
    * training examples into the database.
@@ -136,19 +154,33 @@ private:
 
   struct WordFrequency
   {
-    DocId id;
+    /// index of the document in doc_ids_
+    uint32_t docIndex;
     uint32_t count;
 
     WordFrequency() = default;
-    WordFrequency(DocId _id, uint32_t _count)
-      : id(_id)
+    WordFrequency(uint32_t _docIndex, uint32_t _count)
+      : docIndex(_docIndex)
       , count(_count)
     {}
   };
 
-  // Stored in increasing order by DocId
+  // Stored in increasing order by document index (insertion order)
   typedef std::vector<WordFrequency> InvertedFile;
 
+  /**
+   * @brief Find the top N matches using the inverted index.
+   * @param[in,out] scores Buffer of the documents scores (one per document)
+   */
+  void findInvertedIndex(const SparseHistogram& query, std::size_t N, DocMatches& matches,
+                         const std::string& distanceMethod, std::vector<float>& scores) const;
+
+  /// Compute the TF-IDF norms of the documents with the current word weights
+  void computeDocumentNorms();
+
+  /// TF-IDF norm of a document with the current word weights
+  float documentNorm(const SparseHistogram& document) const;
+
   /// @todo Use sorted vector?
   // typedef std::vector< std::pair<Word, float> > DocumentVector;
   
@@ -158,6 +190,13 @@ private:
   std::vector<float> word_weights_;
   SparseHistogramPerImage database_; // Precomputed for inserted documents
 
+  // Documents in insertion order, indexed by WordFrequency::docIndex
+  std::vector<DocId> doc_ids_;
+  /// number of features of each document
+  std::vector<uint32_t> doc_sizes_;
+  /// TF-IDF norm of each document
+  std::vector<float> doc_norms_;
+
   /**
    * Normalize a document vector representing the histogram of visual words for a given image
    * @param[in/out] v the unnormalized histogram of visual words
@@ -0,0 +1,80 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "DefaultAllocator.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace aliceVision {
+namespace voctree {
+
+/**
+ * @brief Sequential access to a set of training features, chunk by chunk,
+ * so the features don't have to be all loaded in memory.
+ */
+template<class Feature, class FeatureAllocator = typename DefaultAllocator<Feature>::type>
+class FeaturesStream
+{
+public:
+  virtual ~FeaturesStream() = default;
+
+  /**
+   * @brief Restart the stream from the first features.
+   */
+  virtual void rewind() = 0;
+
+  /**
+   * @brief Read the next chunk of features.
+   * @param[out] chunk The features of the chunk (the vector is cleared)
+   * @return false if there is no more features
+   */
+  virtual bool read(std::vector<Feature, FeatureAllocator>& chunk) = 0;
+};
+
+/**
+ * @brief Stream over features already loaded in memory.
+ */
+template<class Feature, class FeatureAllocator = typename DefaultAllocator<Feature>::type>
+class FeaturesVectorStream : public FeaturesStream<Feature, FeatureAllocator>
+{
+public:
+  /**
+   * @param[in] features The features, must outlive the stream
+   * @param[in] chunkSize The number of features per chunk
+   */
+  FeaturesVectorStream(const std::vector<Feature, FeatureAllocator>& features, std::size_t chunkSize)
+    : _features(features)
+    , _chunkSize(std::max(chunkSize, std::size_t(1)))
+  {}
+
+  void rewind() override
+  {
+    _position = 0;
+  }
+
+  bool read(std::vector<Feature, FeatureAllocator>& chunk) override
+  {
+    chunk.clear();
+    if(_position >= _features.size())
+      return false;
+    const std::size_t end = std::min(_position + _chunkSize, _features.size());
+    chunk.assign(_features.begin() + _position, _features.begin() + end);
+    _position = end;
+    return true;
+  }
+
+private:
+  const std::vector<Feature, FeatureAllocator>& _features;
+  const std::size_t _chunkSize;
+  std::size_t _position = 0;
+};
+
+} // namespace voctree
+} // namespace aliceVision
@@ -35,6 +35,13 @@ public:
     this->setNodeCounts();
   }
 
+  /// Load vocabulary from a file, the centers are always copied to be modifiable.
+  void load(const std::string& file) override
+  {
+    BaseClass::load(file);
+    this->detachMapping();
+  }
+
   uint32_t nodes() const
   {
     return this->word_start_ + this->num_words_;
@@ -42,6 +49,8 @@ public:
 
   std::vector<Feature, FeatureAllocator>& centers()
   {
+    // the centers may be modified, the cached norms are not valid anymore
+    this->centers_squared_norms_.clear();
     return this->centers_;
   }
 
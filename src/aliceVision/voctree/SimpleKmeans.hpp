@@ -18,6 +18,7 @@
 #include <numeric>
 #include <vector>
 #include <limits>
+#include <random>
 #include <stdio.h>
 #include <stdlib.h>
 #include <iostream>
@@ -33,13 +34,20 @@ struct InitRandom
 
   template<class Feature, class Distance, class FeatureAllocator>
   void operator()(const std::vector<Feature*>& features, size_t k, std::vector<Feature, FeatureAllocator>& centers, Distance distance, const int verbose = 0)
+  {
+    std::mt19937 generator(rand());
+    (*this)(features, k, centers, distance, generator, verbose);
+  }
+
+  template<class Feature, class Distance, class FeatureAllocator>
+  void operator()(const std::vector<Feature*>& features, size_t k, std::vector<Feature, FeatureAllocator>& centers, Distance distance, std::mt19937& generator, const int verbose = 0)
   {
     ALICEVISION_LOG_DEBUG("#\t\tRandom initialization");
     // Construct a random permutation of the features using a Fisher-Yates shuffle
     std::vector<Feature*> features_perm = features;
     for(size_t i = features.size(); i > 1; --i)
     {
-      size_t k = rand() % i;
+      size_t k = std::uniform_int_distribution<size_t>(0, i - 1)(generator);
       std::swap(features_perm[i - 1], features_perm[k]);
     }
     // Take the first k permuted features as the initial centers
@@ -61,6 +69,13 @@ struct InitKmeanspp
 
   template<class Feature, class Distance, class FeatureAllocator>
   void operator()(const std::vector<Feature*>& features, size_t k, std::vector<Feature, FeatureAllocator>& centers, Distance distance, const int verbose = 0)
+  {
+    std::mt19937 generator(rand());
+    (*this)(features, k, centers, distance, generator, verbose);
+  }
+
+  template<class Feature, class Distance, class FeatureAllocator>
+  void operator()(const std::vector<Feature*>& features, size_t k, std::vector<Feature, FeatureAllocator>& centers, Distance distance, std::mt19937& generator, const int verbose = 0)
   {
     typedef typename Distance::result_type squared_distance_type;
 
@@ -86,7 +101,7 @@ struct InitKmeanspp
     typename std::vector<Feature*>::const_iterator featiter;
 
     // 1. Choose a random center
-    size_t randCenter = rand() % features.size();
+    size_t randCenter = std::uniform_int_distribution<size_t>(0, features.size() - 1)(generator);
 
     // add it to the centers
     centers[0] = *features[ randCenter ];
@@ -118,7 +133,7 @@ struct InitKmeanspp
         // 0 and this sum, then start compute the sum from the first element again
         // until the partial sum is greater than the number drawn: the
         // the previous element is what we are looking for
-        const float perc = (float)rand() / RAND_MAX;
+        const float perc = std::uniform_real_distribution<float>(0.f, 1.f)(generator);
         squared_distance_type partial = (squared_distance_type)(currSum * perc);
         // look for the element that cap the partial sum that has been
         // drawn
@@ -190,6 +205,12 @@ struct InitGiven
   {
     // Do nothing!
   }
+
+  template<class Feature, class Distance, class FeatureAllocator>
+  void operator()(const std::vector<Feature*>& features, std::size_t k, std::vector<Feature, FeatureAllocator>& centers, Distance distance, std::mt19937& generator, const int verbose = 0)
+  {
+    // Do nothing!
+  }
 };
 
 template<class Feature>
@@ -257,6 +278,10 @@ bool checkVectorElements(const std::vector<Feature, FeatureAllocator> &f, const
  * @brief Class for performing K-means clustering, optimized for a particular feature type and metric.
  *
  * The standard Lloyd's algorithm is used. By default, cluster centers are initialized randomly.
+ * With a mini-batch size, the mini-batch k-means is used instead:
+ *
+ *  Sculley, D. (2010). "Web-scale k-means clustering" Proceedings of the 19th
+ *  international conference on World Wide Web. pp. 1177-1178.
  */
 template<class Feature,
          class Distance = L2<Feature, Feature>,
@@ -265,7 +290,7 @@ class SimpleKmeans
 {
 public:
   typedef typename Distance::result_type squared_distance_type;
-  typedef boost::function<void(const std::vector<Feature*>&, std::size_t, std::vector<Feature, FeatureAllocator>&, Distance, const int verbose) > Initializer;
+  typedef boost::function<void(const std::vector<Feature*>&, std::size_t, std::vector<Feature, FeatureAllocator>&, Distance, std::mt19937&, const int verbose) > Initializer;
 
   /**
    * @brief Constructor
@@ -304,6 +329,21 @@ public:
     restarts_ = restarts;
   }
 
+  std::size_t getMiniBatchSize() const
+  {
+    return mini_batch_size_;
+  }
+
+  /**
+   * @brief Set the number of features randomly drawn at each iteration of the mini-batch k-means.
+   * The centers are initialized from a random subset of 3 mini-batches.
+   * @param[in] miniBatchSize The mini-batch size, 0 to use the Lloyd's algorithm on all the features
+   */
+  void setMiniBatchSize(std::size_t miniBatchSize)
+  {
+    mini_batch_size_ = miniBatchSize;
+  }
+
   int getVerbose() const
   {
     return verbose_;
@@ -341,17 +381,44 @@ public:
                                         std::vector<Feature, FeatureAllocator>& centers,
                                         std::vector<unsigned int>& membership) const;
 
+  /**
+   * @brief Partition a set of features into k clusters, drawing the random numbers from the given generator.
+   *
+   * Unlike rand(), the generator is not shared: use one generator per concurrent call.
+   *
+   * @param      features   The features to be clustered.
+   * @param      k          The number of clusters.
+   * @param[out] centers    A set of k cluster centers.
+   * @param[out] membership Cluster assignment for each feature
+   * @param[in,out] generator The random number generator
+   */
+  squared_distance_type clusterPointers(const std::vector<Feature*>& features, std::size_t k,
+                                        std::vector<Feature, FeatureAllocator>& centers,
+                                        std::vector<unsigned int>& membership,
+                                        std::mt19937& generator) const;
+
 private:
 
   squared_distance_type clusterOnce(const std::vector<Feature*>& features, std::size_t k,
                                     std::vector<Feature, FeatureAllocator>& centers,
-                                    std::vector<unsigned int>& membership) const;
+                                    std::vector<unsigned int>& membership,
+                                    std::mt19937& generator) const;
+
+  /// Mini-batch k-means iterations from the given centers, the membership is computed for all the features
+  squared_distance_type clusterOnceMiniBatch(const std::vector<Feature*>& features, std::size_t k,
+                                             std::vector<Feature, FeatureAllocator>& centers,
+                                             std::vector<unsigned int>& membership,
+                                             std::mt19937& generator) const;
+
+  /// Index of the nearest center of a feature
+  unsigned int nearestCenter(const Feature& feature, const std::vector<Feature, FeatureAllocator>& centers, std::size_t k) const;
 
   Feature zero_;
   Distance distance_;
   Initializer choose_centers_;
   std::size_t max_iterations_;
   std::size_t restarts_;
+  std::size_t mini_batch_size_;
   int verbose_;
 };
 
@@ -362,8 +429,9 @@ distance_(d),
 //    choose_centers_( InitRandom( ) ),
 choose_centers_(InitKmeanspp()),
 max_iterations_(100),
-verbose_(verbose),
-restarts_(1)
+restarts_(1),
+mini_batch_size_(0),
+verbose_(verbose)
 {
 }
 
@@ -385,18 +453,47 @@ typename SimpleKmeans<Feature, Distance, FeatureAllocator>::squared_distance_typ
 SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterPointers(const std::vector<Feature*>& features, size_t k,
                                                                    std::vector<Feature, FeatureAllocator>& centers,
                                                                    std::vector<unsigned int>& membership) const
+{
+  std::mt19937 generator(rand());
+  return clusterPointers(features, k, centers, membership, generator);
+}
+
+template < class Feature, class Distance, class FeatureAllocator >
+typename SimpleKmeans<Feature, Distance, FeatureAllocator>::squared_distance_type
+SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterPointers(const std::vector<Feature*>& features, size_t k,
+                                                                   std::vector<Feature, FeatureAllocator>& centers,
+                                                                   std::vector<unsigned int>& membership,
+                                                                   std::mt19937& generator) const
 {
   std::vector<Feature, FeatureAllocator> new_centers(centers);
   new_centers.resize(k);
   std::vector<unsigned int> new_membership(features.size());
 
+  const bool useMiniBatch = (mini_batch_size_ > 0 && features.size() > mini_batch_size_);
+  // with mini-batches, the initial centers are chosen from a random subset of the features
+  std::vector<Feature*> init_features;
+
   squared_distance_type least_sse = std::numeric_limits<squared_distance_type>::max();
   assert(restarts_ > 0);
   for(std::size_t starts = 0; starts < restarts_; ++starts)
   {
     if(verbose_ > 0) ALICEVISION_LOG_DEBUG("Trial " << starts + 1 << "/" << restarts_);
-    choose_centers_(features, k, new_centers, distance_, verbose_);
-    squared_distance_type sse = clusterOnce(features, k, new_centers, new_membership);
+    squared_distance_type sse;
+    if(useMiniBatch)
+    {
+      const std::size_t init_size = std::min(features.size(), std::max(k, 3 * mini_batch_size_));
+      init_features = features;
+      for(std::size_t i = 0; i < init_size; ++i)
+        std::swap(init_features[i], init_features[std::uniform_int_distribution<std::size_t>(i, features.size() - 1)(generator)]);
+      init_features.resize(init_size);
+      choose_centers_(init_features, k, new_centers, distance_, generator, verbose_);
+      sse = clusterOnceMiniBatch(features, k, new_centers, new_membership, generator);
+    }
+    else
+    {
+      choose_centers_(features, k, new_centers, distance_, generator, verbose_);
+      sse = clusterOnce(features, k, new_centers, new_membership, generator);
+    }
     if(verbose_ > 0) ALICEVISION_LOG_DEBUG("End of Trial " << starts + 1 << "/" << restarts_);
     if(sse < least_sse)
     {
@@ -415,7 +512,8 @@ template < class Feature, class Distance, class FeatureAllocator >
 typename SimpleKmeans<Feature, Distance, FeatureAllocator>::squared_distance_type
 SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterOnce(const std::vector<Feature*>& features, std::size_t k,
                                                                std::vector<Feature, FeatureAllocator>& centers,
-                                                               std::vector<unsigned int>& membership) const
+                                                               std::vector<unsigned int>& membership,
+                                                               std::mt19937& generator) const
 {
   typedef typename std::vector<Feature, FeatureAllocator>::value_type centerType;
   typedef typename Distance::value_type feature_value_type;
@@ -509,7 +607,7 @@ SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterOnce(const std::vector
       {
         // Choose a new center randomly from the input features
         // @todo use a better strategy like taking splitting the largest cluster
-        unsigned int index = rand() % features.size();
+        unsigned int index = std::uniform_int_distribution<unsigned int>(0, features.size() - 1)(generator);
         centers[i] = *features[index];
         ALICEVISION_LOG_DEBUG("Choosing a new center: " << index);
       }
@@ -529,6 +627,81 @@ SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterOnce(const std::vector
   }
   return sse;
 }
+template < class Feature, class Distance, class FeatureAllocator >
+unsigned int SimpleKmeans<Feature, Distance, FeatureAllocator>::nearestCenter(const Feature& feature,
+                                                                            const std::vector<Feature, FeatureAllocator>& centers,
+                                                                            std::size_t k) const
+{
+  squared_distance_type d_min = std::numeric_limits<squared_distance_type>::max();
+  unsigned int nearest = 0;
+  for(unsigned int j = 0; j < k; ++j)
+  {
+    const squared_distance_type distance = distance_(feature, centers[j]);
+    if(distance < d_min)
+    {
+      d_min = distance;
+      nearest = j;
+    }
+  }
+  return nearest;
+}
+
+template < class Feature, class Distance, class FeatureAllocator >
+typename SimpleKmeans<Feature, Distance, FeatureAllocator>::squared_distance_type
+SimpleKmeans<Feature, Distance, FeatureAllocator>::clusterOnceMiniBatch(const std::vector<Feature*>& features, std::size_t k,
+                                                                        std::vector<Feature, FeatureAllocator>& centers,
+                                                                        std::vector<unsigned int>& membership,
+                                                                        std::mt19937& generator) const
+{
+  assert(features.size() > 0);
+  assert(mini_batch_size_ > 0);
+
+  std::uniform_int_distribution<std::size_t> feature_distribution(0, features.size() - 1);
+
+  // number of features assigned to each center so far, the learning rate of a center is 1 / count
+  std::vector<std::size_t> center_counts(k, 0);
+  std::vector<std::size_t> batch(mini_batch_size_);
+  std::vector<unsigned int> batch_membership(mini_batch_size_);
+  std::vector<Feature, FeatureAllocator> previous_centers(k);
+
+  if(verbose_ > 0) ALICEVISION_LOG_DEBUG("Mini-batch iterations");
+  for(std::size_t iter = 0; iter < max_iterations_; ++iter)
+  {
+    for(std::size_t i = 0; i < batch.size(); ++i)
+      batch[i] = feature_distribution(generator);
+
+    // Assign the mini-batch features to the current centers
+    #pragma omp parallel for
+    for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(batch.size()); ++i)
+      batch_membership[i] = nearestCenter(*features[batch[i]], centers, k);
+
+    // Gradient step: each center moves towards its features with a per-center learning rate
+    std::copy(centers.begin(), centers.begin() + k, previous_centers.begin());
+    for(std::size_t i = 0; i < batch.size(); ++i)
+    {
+      const Feature& feature = *features[batch[i]];
+      Feature& center = centers[batch_membership[i]];
+      const float eta = 1.f / ++center_counts[batch_membership[i]];
+      for(std::size_t d = 0; d < feature.size(); ++d)
+        center[d] += eta * (feature[d] - center[d]);
+    }
+
+    squared_distance_type max_center_shift = 0;
+    for(std::size_t i = 0; i < k; ++i)
+      max_center_shift = std::max(max_center_shift, distance_(previous_centers[i], centers[i]));
+    if(max_center_shift <= 10e-10) break;
+  }
+
+  // Final assignment of all the features and sum squared error
+  squared_distance_type sse = squared_distance_type(0);
+  #pragma omp parallel for reduction(+:sse)
+  for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(features.size()); ++i)
+  {
+    membership[i] = nearestCenter(*features[i], centers, k);
+    sse += distance_(*features[i], centers[membership[i]]);
+  }
+  return sse;
+}
 
 }
 }
@@ -8,7 +8,13 @@
 
 #include "MutableVocabularyTree.hpp"
 #include "SimpleKmeans.hpp"
+#include "FeaturesStream.hpp"
+
+#include <aliceVision/alicevision_omp.hpp>
+
+#include <algorithm>
 #include <deque>
+#include <random>
 //#include <cstdio> //DEBUG
 
 namespace aliceVision {
@@ -48,6 +54,44 @@ public:
    */
   void build(const FeatureVector& training_features, uint32_t k, uint32_t levels);
 
+  /**
+   * @brief Build a new vocabulary tree from features streamed chunk by chunk, in bounded memory.
+   *
+   * The tree is built level by level, each level needs 1 + nbPasses reads of the stream:
+   * - the features are quantized to the nodes of the previous level and a random subset of at most
+   *   maxSampleSize features (shared between the nodes) is kept to initialize the children of each node
+   *   with the k-means clusterer,
+   * - then the children centers are refined on all the features with mini-batch k-means updates,
+   *   the chunks being the mini-batches.
+   *
+   * @param featuresStream The training features.
+   * @param k              The branching factor, or max children of any node.
+   * @param levels         The number of levels in the tree.
+   */
+  void build(FeaturesStream<Feature, FeatureAllocator>& featuresStream, uint32_t k, uint32_t levels);
+
+  /// Set the maximum number of features kept in memory to initialize the nodes of a level (streamed build).
+  void setMaxSampleSize(std::size_t maxSampleSize)
+  {
+    maxSampleSize_ = maxSampleSize;
+  }
+
+  std::size_t getMaxSampleSize() const
+  {
+    return maxSampleSize_;
+  }
+
+  /// Set the number of refinement passes over the features for each level (streamed build).
+  void setNbPasses(std::size_t nbPasses)
+  {
+    nbPasses_ = nbPasses;
+  }
+
+  std::size_t getNbPasses() const
+  {
+    return nbPasses_;
+  }
+
   /// Get the built vocabulary tree.
 
   const Tree& tree() const
@@ -83,7 +127,12 @@ protected:
   Tree tree_;
   Kmeans kmeans_;
   Feature zero_;
+  std::size_t maxSampleSize_ = 1000000;
+  std::size_t nbPasses_ = 1;
 private:
+  /// Get the node of the given level reached by a feature in the tree being built, -1 for the root.
+  int32_t quantizeToLevel(const Feature& feature, int32_t level) const;
+
   unsigned char verbose_;
 };
 
@@ -118,16 +167,32 @@ void TreeBuilder<Feature, DistanceT, FeatureAllocator>::build(const FeatureVecto
       feature_ptrs.push_back(const_cast<Feature*> (&f));
     }
   }
-  FeatureVector centers; // always size k
+  std::mt19937 generator(rand());
   for(uint32_t level = 0; level < levels; ++level)
   {
     if(verbose_) printf("# Level %u\n", level);
-    std::vector<unsigned int> membership;
 
-    for(std::size_t i = 0, ie = subset_queue.size(); i < ie; ++i)
+    // the subsets of a level are clustered in parallel when there are enough of them,
+    // otherwise the k-means clusterer is parallel
+    const std::size_t nbSubsets = subset_queue.size();
+    // each subset has its own generator, so the tree does not depend on the threads scheduling
+    std::vector<std::mt19937::result_type> subsets_seeds(nbSubsets);
+    for(std::mt19937::result_type& seed : subsets_seeds)
+      seed = generator();
+    std::vector<FeatureVector> subsets_centers(nbSubsets);
+    std::vector<std::vector<uint8_t> > subsets_valid(nbSubsets);
+    std::vector<std::vector<std::vector<Feature*> > > subsets_children(nbSubsets);
+
+    #pragma omp parallel for schedule(dynamic) if(nbSubsets >= static_cast<std::size_t>(omp_get_max_threads()))
+    for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(nbSubsets); ++i)
     {
-      std::vector<Feature*> &subset = subset_queue.front();
-      if(verbose_ > 1) printf("#\tClustering subset %lu/%lu of size %lu\n", i + 1, ie, subset.size());
+      const std::vector<Feature*> &subset = subset_queue[i];
+      FeatureVector& centers = subsets_centers[i]; // always size k
+      std::vector<uint8_t>& valid = subsets_valid[i];
+      std::vector<std::vector<Feature*> >& new_subsets = subsets_children[i];
+      new_subsets.resize(k);
+
+      if(verbose_ > 1) printf("#\tClustering subset %lu/%lu of size %lu\n", i + 1, nbSubsets, subset.size());
 
       // If the subset already has k or fewer elements, just use those as the centers.
       if(subset.size() <= k)
@@ -135,27 +200,24 @@ void TreeBuilder<Feature, DistanceT, FeatureAllocator>::build(const FeatureVecto
         if(verbose_ > 2) printf("#\tno need to cluster %lu elements\n", subset.size());
         for(std::size_t j = 0; j < subset.size(); ++j)
         {
-          tree_.centers().push_back(*subset[j]);
-          tree_.validCenters().push_back(1);
+          centers.push_back(*subset[j]);
+          valid.push_back(1);
         }
         // Mark non-existent centers as invalid.
-        tree_.centers().insert(tree_.centers().end(), k - subset.size(), zero_);
-        tree_.validCenters().insert(tree_.validCenters().end(), k - subset.size(), 0);
-
-        // Push k empty subsets into the queue so all children get marked invalid.
-        subset_queue.pop_front();
-        subset_queue.insert(subset_queue.end(), k, std::vector<Feature*>());
+        centers.insert(centers.end(), k - subset.size(), zero_);
+        valid.insert(valid.end(), k - subset.size(), 0);
+        // The k children subsets stay empty so all children get marked invalid.
       }
       else
       {
         // Cluster the current subset into k centers.
         if(verbose_ > 2) printf("#\tclustering the current subset of %lu elements into %d centers\n", subset.size(), k);
-        kmeans_.clusterPointers(subset, k, centers, membership);
-        // Add the centers and mark them as valid.
-        tree_.centers().insert(tree_.centers().end(), centers.begin(), centers.end());
-        tree_.validCenters().insert(tree_.validCenters().end(), k, 1);
+        std::vector<unsigned int> membership;
+        std::mt19937 subset_generator(subsets_seeds[i]);
+        kmeans_.clusterPointers(subset, k, centers, membership, subset_generator);
+        // Mark the centers as valid.
+        valid.assign(k, 1);
         // Partition the current subset into k new subsets based on the cluster assignments.
-        std::vector< std::vector<Feature*> > new_subsets(k);
         assert(membership.size() >= subset.size());
         for(std::size_t j = 0; j < subset.size(); ++j)
         {
@@ -163,14 +225,241 @@ void TreeBuilder<Feature, DistanceT, FeatureAllocator>::build(const FeatureVecto
           assert(membership[j] < new_subsets.size());
           new_subsets[ membership[j] ].push_back(subset[j]);
         }
-        // Update the queue
-        subset_queue.pop_front();
-        subset_queue.insert(subset_queue.end(), new_subsets.begin(), new_subsets.end());
+      }
+    }
+
+    // Add the centers in the subsets order and update the queue
+    subset_queue.clear();
+    for(std::size_t i = 0; i < nbSubsets; ++i)
+    {
+      tree_.centers().insert(tree_.centers().end(), subsets_centers[i].begin(), subsets_centers[i].end());
+      tree_.validCenters().insert(tree_.validCenters().end(), subsets_valid[i].begin(), subsets_valid[i].end());
+      for(std::vector<Feature*>& new_subset : subsets_children[i])
+      {
+        subset_queue.emplace_back();
+        subset_queue.back().swap(new_subset);
       }
     }
     if(verbose_) printf("# centers so far = %lu\n", tree_.centers().size());
   }
 }
 
+
+template<class Feature, template<typename, typename> class DistanceT, class FeatureAllocator>
+int32_t TreeBuilder<Feature, DistanceT, FeatureAllocator>::quantizeToLevel(const Feature& feature, int32_t level) const
+{
+  const int32_t k = tree_.splits();
+  const FeatureVector& centers = tree_.centers();
+  const std::vector<uint8_t>& validCenters = tree_.validCenters();
+  Distance distance;
+
+  int32_t index = -1; // virtual "root" index, which has no associated center.
+  for(int32_t l = 0; l <= level; ++l)
+  {
+    const int32_t firstChild = (index + 1) * k;
+    int32_t bestChild = firstChild;
+    typename Distance::result_type bestDistance = std::numeric_limits<typename Distance::result_type>::max();
+    for(int32_t child = firstChild; child < firstChild + k; ++child)
+    {
+      if(!validCenters[child])
+        break; // Fewer than k children.
+      const typename Distance::result_type childDistance = distance(feature, centers[child]);
+      if(childDistance < bestDistance)
+      {
+        bestChild = child;
+        bestDistance = childDistance;
+      }
+    }
+    index = bestChild;
+  }
+  return index;
+}
+
+template<class Feature, template<typename, typename> class DistanceT, class FeatureAllocator>
+void TreeBuilder<Feature, DistanceT, FeatureAllocator>::build(FeaturesStream<Feature, FeatureAllocator>& featuresStream,
+                                                             uint32_t k, uint32_t levels)
+{
+  tree_.clear();
+  tree_.setSize(levels, k);
+  tree_.centers().reserve(tree_.nodes());
+  tree_.validCenters().reserve(tree_.nodes());
+
+  std::mt19937 generator(rand());
+  FeatureVector chunk;
+  std::vector<int32_t> chunkParents;
+
+  int32_t firstParent = -1; // first node of the previous level, -1 for the virtual root
+  std::size_t nbParents = 1;
+
+  for(uint32_t level = 0; level < levels; ++level)
+  {
+    if(verbose_) printf("# Level %u\n", level);
+
+    const int32_t firstNode = (firstParent + 1) * static_cast<int32_t>(k);
+    const std::size_t nbNodes = nbParents * k;
+
+    std::size_t nbValidParents = 1;
+    if(level > 0)
+      nbValidParents = std::count(tree_.validCenters().begin() + firstParent, tree_.validCenters().begin() + firstNode, 1);
+
+    // parent index in the level (from 0) of each feature of the chunk, -1 if it has no parent in the tree
+    const auto quantizeChunkParents = [&]()
+    {
+      chunkParents.resize(chunk.size());
+      #pragma omp parallel for
+      for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(chunk.size()); ++i)
+        chunkParents[i] = (level == 0) ? 0 : quantizeToLevel(chunk[i], level - 1) - firstParent;
+    };
+
+    // 1. random subset of the features of each parent (reservoir sampling), at least k + 1 so the parents
+    //    with k or fewer features are known exactly
+    const std::size_t sampleSize = std::max<std::size_t>(k + 1, maxSampleSize_ / nbValidParents);
+    std::vector<FeatureVector> samples(nbParents);
+    std::vector<std::size_t> parentsNbFeatures(nbParents, 0);
+
+    featuresStream.rewind();
+    while(featuresStream.read(chunk))
+    {
+      quantizeChunkParents();
+      for(std::size_t i = 0; i < chunk.size(); ++i)
+      {
+        const int32_t parent = chunkParents[i];
+        const std::size_t nbFeatures = ++parentsNbFeatures[parent];
+        if(samples[parent].size() < sampleSize)
+        {
+          samples[parent].push_back(chunk[i]);
+        }
+        else
+        {
+          const std::size_t j = std::uniform_int_distribution<std::size_t>(0, nbFeatures - 1)(generator);
+          if(j < sampleSize)
+            samples[parent][j] = chunk[i];
+        }
+      }
+    }
+
+    // 2. initialize the children centers of each parent, the parents are clustered in parallel when
+    //    there are enough of them, otherwise the k-means clusterer is parallel
+    FeatureVector centers(nbNodes, zero_);
+    std::vector<uint8_t> validCenters(nbNodes, 0);
+    std::vector<std::size_t> centersNbFeatures(nbNodes, 0);
+    // the children of a parent with k or fewer features are the features themselves
+    std::vector<uint8_t> isRefined(nbParents, 0);
+    // each parent has its own generator, so the tree does not depend on the threads scheduling
+    std::vector<std::mt19937::result_type> parentsSeeds(nbParents);
+    for(std::mt19937::result_type& seed : parentsSeeds)
+      seed = generator();
+
+    #pragma omp parallel for schedule(dynamic) if(nbParents >= static_cast<std::size_t>(omp_get_max_threads()))
+    for(ptrdiff_t p = 0; p < static_cast<ptrdiff_t>(nbParents); ++p)
+    {
+      FeatureVector& sample = samples[p];
+      const std::size_t firstChild = p * k;
+
+      if(sample.size() <= k)
+      {
+        std::copy(sample.begin(), sample.end(), centers.begin() + firstChild);
+        std::fill(validCenters.begin() + firstChild, validCenters.begin() + firstChild + sample.size(), 1);
+      }
+      else
+      {
+        std::vector<Feature*> samplePtrs;
+        samplePtrs.reserve(sample.size());
+        for(Feature& f : sample)
+          samplePtrs.push_back(&f);
+
+        FeatureVector parentCenters;
+        std::vector<unsigned int> membership;
+        std::mt19937 parentGenerator(parentsSeeds[p]);
+        kmeans_.clusterPointers(samplePtrs, k, parentCenters, membership, parentGenerator);
+
+        std::copy(parentCenters.begin(), parentCenters.end(), centers.begin() + firstChild);
+        std::fill(validCenters.begin() + firstChild, validCenters.begin() + firstChild + k, 1);
+        // the sample features give the initial weights of the centers
+        for(std::size_t j = 0; j < sample.size(); ++j)
+          ++centersNbFeatures[firstChild + membership[j]];
+        isRefined[p] = 1;
+      }
+      FeatureVector().swap(sample);
+    }
+    if(verbose_ > 1) printf("#\tinitialized %lu nodes from %lu parents\n", nbNodes, nbValidParents);
+
+    // 3. mini-batch refinement of the centers on all the features
+    std::vector<int32_t> chunkNodes;
+    std::vector<std::pair<int32_t, int32_t> > nodesFeatures;
+    for(std::size_t pass = 0; pass < nbPasses_; ++pass)
+    {
+      if(verbose_ > 1) printf("#\trefinement pass %lu/%lu\n", pass + 1, nbPasses_);
+
+      featuresStream.rewind();
+      while(featuresStream.read(chunk))
+      {
+        quantizeChunkParents();
+
+        // nearest child center of each feature, -1 if the parent is not refined
+        chunkNodes.resize(chunk.size());
+        #pragma omp parallel for
+        for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(chunk.size()); ++i)
+        {
+          const int32_t parent = chunkParents[i];
+          chunkNodes[i] = -1;
+          if(!isRefined[parent])
+            continue;
+          Distance distance;
+          typename Distance::result_type bestDistance = std::numeric_limits<typename Distance::result_type>::max();
+          for(int32_t child = parent * k; child < (parent + 1) * static_cast<int32_t>(k); ++child)
+          {
+            const typename Distance::result_type childDistance = distance(chunk[i], centers[child]);
+            if(childDistance < bestDistance)
+            {
+              chunkNodes[i] = child;
+              bestDistance = childDistance;
+            }
+          }
+        }
+
+        // gather the features by node, the nodes are updated in parallel
+        nodesFeatures.clear();
+        for(std::size_t i = 0; i < chunk.size(); ++i)
+        {
+          if(chunkNodes[i] >= 0)
+            nodesFeatures.emplace_back(chunkNodes[i], i);
+        }
+        std::sort(nodesFeatures.begin(), nodesFeatures.end());
+
+        std::vector<std::size_t> groupsBegin;
+        for(std::size_t i = 0; i < nodesFeatures.size(); ++i)
+        {
+          if(i == 0 || nodesFeatures[i].first != nodesFeatures[i - 1].first)
+            groupsBegin.push_back(i);
+        }
+        groupsBegin.push_back(nodesFeatures.size());
+
+        #pragma omp parallel for schedule(dynamic)
+        for(ptrdiff_t g = 0; g < static_cast<ptrdiff_t>(groupsBegin.size()) - 1; ++g)
+        {
+          const int32_t node = nodesFeatures[groupsBegin[g]].first;
+          Feature& center = centers[node];
+          for(std::size_t i = groupsBegin[g]; i < groupsBegin[g + 1]; ++i)
+          {
+            // per-center learning rate 1 / count
+            const Feature& feature = chunk[nodesFeatures[i].second];
+            const float eta = 1.f / ++centersNbFeatures[node];
+            for(std::size_t d = 0; d < feature.size(); ++d)
+              center[d] += eta * (feature[d] - center[d]);
+          }
+        }
+      }
+    }
+
+    tree_.centers().insert(tree_.centers().end(), centers.begin(), centers.end());
+    tree_.validCenters().insert(tree_.validCenters().end(), validCenters.begin(), validCenters.end());
+    if(verbose_) printf("# centers so far = %lu\n", tree_.centers().size());
+
+    firstParent = firstNode;
+    nbParents = nbNodes;
+  }
+}
+
 }
 }
@@ -7,10 +7,90 @@
 #include "VocabularyTree.hpp"
 
 #include <algorithm>
+#include <cmath>
+#include <cstring>
 
 namespace aliceVision {
 namespace voctree {
 
+namespace {
+
+const char mappableTreeMagic[4] = {'A', 'V', 'V', 'T'};
+const uint32_t mappableTreeVersion = 1;
+const uint64_t mappableTreeAlignment = 64;
+
+static_assert(sizeof(MappableTreeHeader) == 64, "The mappable vocabulary tree header must not have padding.");
+
+inline uint64_t alignOffset(uint64_t offset)
+{
+  return (offset + mappableTreeAlignment - 1) / mappableTreeAlignment * mappableTreeAlignment;
+}
+
+} // namespace
+
+std::size_t treeCentersTypeSize(ETreeCentersType centersType)
+{
+  switch(centersType)
+  {
+    case ETreeCentersType::FLOAT: return sizeof(float);
+    case ETreeCentersType::UINT8: return sizeof(uint8_t);
+  }
+  throw std::out_of_range("Invalid vocabulary tree centers type: " + std::to_string(static_cast<uint32_t>(centersType)));
+}
+
+MappableTreeHeader createMappableTreeHeader(uint32_t k, uint32_t levels, uint32_t nbNodes, uint32_t dimension, ETreeCentersType centersType)
+{
+  MappableTreeHeader header;
+  std::memset(&header, 0, sizeof(MappableTreeHeader));
+  std::memcpy(header.magic, mappableTreeMagic, sizeof(mappableTreeMagic));
+  header.version = mappableTreeVersion;
+  header.k = k;
+  header.levels = levels;
+  header.nbNodes = nbNodes;
+  header.dimension = dimension;
+  header.centersType = static_cast<uint32_t>(centersType);
+  header.centersOffset = alignOffset(sizeof(MappableTreeHeader));
+  header.validCentersOffset = alignOffset(header.centersOffset + uint64_t(nbNodes) * dimension * treeCentersTypeSize(centersType));
+  header.squaredNormsOffset = alignOffset(header.validCentersOffset + nbNodes);
+  header.fileSize = header.squaredNormsOffset + uint64_t(nbNodes) * sizeof(float);
+  return header;
+}
+
+const MappableTreeHeader& readMappableTreeHeader(const char* data, std::size_t size, const std::string& file)
+{
+  if(data == nullptr || size < sizeof(MappableTreeHeader) || std::memcmp(data, mappableTreeMagic, sizeof(mappableTreeMagic)) != 0)
+    throw std::runtime_error("Invalid mappable vocabulary tree file: " + file);
+
+  const MappableTreeHeader& header = *reinterpret_cast<const MappableTreeHeader*>(data);
+
+  if(header.version != mappableTreeVersion)
+    throw std::runtime_error("Unsupported mappable vocabulary tree version (" + std::to_string(header.version) + "): " + file);
+
+  if(header.centersType != static_cast<uint32_t>(ETreeCentersType::FLOAT) &&
+     header.centersType != static_cast<uint32_t>(ETreeCentersType::UINT8))
+    throw std::runtime_error("Invalid mappable vocabulary tree centers type (" + std::to_string(header.centersType) + "): " + file);
+
+  const MappableTreeHeader expected = createMappableTreeHeader(header.k, header.levels, header.nbNodes, header.dimension,
+                                                               static_cast<ETreeCentersType>(header.centersType));
+  if(header.centersOffset != expected.centersOffset ||
+     header.validCentersOffset != expected.validCentersOffset ||
+     header.squaredNormsOffset != expected.squaredNormsOffset ||
+     header.fileSize != expected.fileSize ||
+     size < header.fileSize)
+    throw std::runtime_error("Corrupted mappable vocabulary tree file: " + file);
+
+  return header;
+}
+
+bool isMappableTreeFile(const std::string& file)
+{
+  std::ifstream in(file.c_str(), std::ios_base::binary);
+  char magic[sizeof(mappableTreeMagic)];
+  if(!in.read(magic, sizeof(magic)))
+    return false;
+  return std::memcmp(magic, mappableTreeMagic, sizeof(mappableTreeMagic)) == 0;
+}
+
 float sparseDistance(const SparseHistogram& v1, const SparseHistogram& v2, const std::string &distanceMethod, const std::vector<float>& word_weights)
 {
 
@@ -38,8 +118,10 @@ float sparseDistance(const SparseHistogram& v1, const SparseHistogram& v2, const
       }
       else
       {
-        const auto val = std::minmax(i1->second.size(), i2->second.size());
-        distance += static_cast<float>(val.second - val.first);
+        // std::minmax would return references to the temporary sizes
+        const std::size_t size1 = i1->second.size();
+        const std::size_t size2 = i2->second.size();
+        distance += static_cast<float>(std::max(size1, size2) - std::min(size1, size2));
         ++i1;
         ++i2;
       }
@@ -236,6 +318,43 @@ float sparseDistance(const SparseHistogram& v1, const SparseHistogram& v2, const
     
     distance = - score;
   }
+  else if(distanceMethod == "tfidf")
+  {
+    // L1 distance between the L1-normalized TF-IDF vectors, in [0,2]
+    const auto weight = [&word_weights](Word word) { return word < word_weights.size() ? word_weights[word] : 1.0f; };
+
+    float N1{0.f};
+    float N2{0.f};
+    for(const auto& wordPair : v1)
+      N1 += wordPair.second.size() * weight(wordPair.first);
+    for(const auto& wordPair : v2)
+      N2 += wordPair.second.size() * weight(wordPair.first);
+    const float invN1 = N1 > 0 ? 1.f / N1 : 0.f;
+    const float invN2 = N2 > 0 ? 1.f / N2 : 0.f;
+
+    // |v1 - v2| = |v1| + |v2| + sum over the shared words of (|v1_i - v2_i| - v1_i - v2_i)
+    distance = (N1 > 0 ? 1.f : 0.f) + (N2 > 0 ? 1.f : 0.f);
+    while(i1 != i1e && i2 != i2e)
+    {
+      if(i2->first < i1->first)
+      {
+        ++i2;
+      }
+      else if(i1->first < i2->first)
+      {
+        ++i1;
+      }
+      else
+      {
+        const float w = weight(i1->first);
+        const float q = i1->second.size() * w * invN1;
+        const float d = i2->second.size() * w * invN2;
+        distance += std::abs(q - d) - q - d;
+        ++i1;
+        ++i2;
+      }
+    }
+  }
   else
   {
     throw std::invalid_argument("distance method "+ distanceMethod +" unknown!");
@@ -15,10 +15,18 @@
 
 #include <aliceVision/types.hpp>
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/MemoryMappedFile.hpp>
+
+#include <Eigen/Core>
 
 #include <stdint.h>
 #include <vector>
 #include <map>
+#include <memory>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
 #include <cassert>
 #include <limits>
 #include <fstream>
@@ -88,6 +96,82 @@ public:
 
 inline IVocabularyTree::~IVocabularyTree() {}
 
+/**
+ * @brief Type of the centers values in the mappable vocabulary tree format.
+ */
+enum class ETreeCentersType : uint32_t
+{
+  FLOAT = 0,
+  UINT8 = 1 //< values rounded and clamped to [0, 255]
+};
+
+/**
+ * @brief Header of the mappable vocabulary tree format.
+ *
+ * The file contains the header followed by 3 blocks, each starting at an offset aligned on 64 bytes:
+ * - the centers: nbNodes x dimension values of type centersType,
+ * - the valid flags of the centers: nbNodes bytes,
+ * - the squared norms of the centers: nbNodes floats (used by the batched quantization).
+ * So the file can be memory-mapped and used in place, the pages being shared between processes.
+ */
+struct MappableTreeHeader
+{
+  char magic[4];
+  uint32_t version;
+  uint32_t k;
+  uint32_t levels;
+  uint32_t nbNodes;
+  uint32_t dimension;
+  uint32_t centersType;
+  uint32_t reserved;
+  uint64_t centersOffset;
+  uint64_t validCentersOffset;
+  uint64_t squaredNormsOffset;
+  uint64_t fileSize;
+};
+
+/**
+ * @brief Get the size in bytes of a center value.
+ */
+std::size_t treeCentersTypeSize(ETreeCentersType centersType);
+
+/**
+ * @brief Create the header of a mappable vocabulary tree file, with the blocks offsets.
+ */
+MappableTreeHeader createMappableTreeHeader(uint32_t k, uint32_t levels, uint32_t nbNodes, uint32_t dimension, ETreeCentersType centersType);
+
+/**
+ * @brief Get and check the header of a mappable vocabulary tree file.
+ * @param[in] data The file data
+ * @param[in] size The file size
+ * @param[in] file The file path, for the error messages
+ * @throw std::runtime_error if the file is not a valid mappable vocabulary tree
+ */
+const MappableTreeHeader& readMappableTreeHeader(const char* data, std::size_t size, const std::string& file);
+
+/**
+ * @brief Is the file a vocabulary tree in the mappable format (otherwise the legacy format is assumed).
+ */
+bool isMappableTreeFile(const std::string& file);
+
+/**
+ * @brief Descriptor types supported by the batched quantization:
+ * feature::Descriptor of float or unsigned char values.
+ */
+template<class DescriptorT>
+struct BatchQuantizationTraits
+{
+  static const bool supported = false;
+  static const std::size_t dimension = 0;
+};
+
+template<typename T, std::size_t N>
+struct BatchQuantizationTraits<feature::Descriptor<T, N> >
+{
+  static const bool supported = std::is_same<T, float>::value || std::is_same<T, unsigned char>::value;
+  static const std::size_t dimension = N;
+};
+
 /**
  * @brief Optimized vocabulary tree quantizer, templated on feature type and distance metric
  * for maximum efficiency.
@@ -117,7 +201,14 @@ public:
   template<class DescriptorT>
   Word quantize(const DescriptorT& feature) const;
 
-  /// Quantizes a set of features into visual words.
+  /**
+   * @brief Quantizes a set of features into visual words.
+   *
+   * With L2 distance and feature::Descriptor of float or unsigned char (for the features and the centers),
+   * the features are quantized level by level: the features reaching the same node are gathered and
+   * compared to all the children centers with a single matrix product (see quantizeBatch).
+   * Otherwise each feature descends the tree on its own.
+   */
   template<class DescriptorT>
   std::vector<Word> quantize(const std::vector<DescriptorT>& features) const;
 
@@ -141,15 +232,37 @@ public:
   /// Clears vocabulary, leaving an empty tree.
   void clear() override;
 
-  /// Save vocabulary to a file.
+  /// Save vocabulary to a file (legacy format).
   void save(const std::string& file) const override;
-  /// Load vocabulary from a file.
+
+  /**
+   * @brief Save vocabulary to a file in the mappable format (see MappableTreeHeader).
+   * Only supported for feature::Descriptor of float or unsigned char values.
+   * @param[in] file The output file path
+   * @param[in] centersType The type of the stored centers values, UINT8 divides the file size by 4 for float centers
+   */
+  void saveMappable(const std::string& file, ETreeCentersType centersType = ETreeCentersType::FLOAT) const;
+
+  /**
+   * @brief Load vocabulary from a file, in the legacy or the mappable format.
+   *
+   * A file in the mappable format is memory-mapped and used in place if its centers have the type of Feature,
+   * so the loading is immediate and the memory is shared between the processes using the same tree.
+   * Otherwise the centers are converted.
+   */
   void load(const std::string& file) override;
 
+  /// Is the vocabulary used in place from a memory-mapped file.
+  bool isMapped() const
+  {
+    return mapped_file_ != nullptr;
+  }
+
   bool operator==(const VocabularyTree& other) const
   {
-    return (centers_ == other.centers_) &&
-        (valid_centers_ == other.valid_centers_) &&
+    return (nbCenters() == other.nbCenters()) &&
+        std::equal(centersData(), centersData() + nbCenters(), other.centersData()) &&
+        std::equal(validCentersData(), validCentersData() + nbCenters(), other.validCentersData()) &&
         (k_ == other.k_) &&
         (levels_ == other.levels_) &&
         (num_words_ == other.num_words_) &&
@@ -171,6 +284,84 @@ protected:
   }
 
   void setNodeCounts();
+
+  /// Compute the cache of the squared norms of the centers used by the batched quantization
+  void computeCentersSquaredNorms();
+
+  /// Number of centers, from the mapped file or owned
+  std::size_t nbCenters() const
+  {
+    return isMapped() ? word_start_ + num_words_ : centers_.size();
+  }
+
+  const Feature* centersData() const
+  {
+    return isMapped() ? mapped_centers_ : centers_.data();
+  }
+
+  const uint8_t* validCentersData() const
+  {
+    return isMapped() ? mapped_valid_centers_ : valid_centers_.data();
+  }
+
+  /// Squared norms of the centers, nullptr if not available
+  const float* centersSquaredNormsData() const
+  {
+    if(isMapped())
+      return mapped_centers_squared_norms_;
+    return (!centers_.empty() && centers_squared_norms_.size() == centers_.size()) ? centers_squared_norms_.data() : nullptr;
+  }
+
+  /// Copy the mapped data in the owned vectors and release the mapping, no-op if not mapped
+  void detachMapping();
+
+  /// squared norms of the centers (batched quantization), empty if not computed
+  std::vector<float> centers_squared_norms_;
+
+  /// memory-mapped file of the vocabulary, null if the data are owned
+  std::shared_ptr<const system::MemoryMappedFile> mapped_file_;
+  const Feature* mapped_centers_ = nullptr;
+  const uint8_t* mapped_valid_centers_ = nullptr;
+  const float* mapped_centers_squared_norms_ = nullptr;
+
+private:
+  template<class DescriptorT>
+  struct IsBatchQuantizable : std::integral_constant<bool,
+      BatchQuantizationTraits<Feature>::supported &&
+      BatchQuantizationTraits<DescriptorT>::supported &&
+      BatchQuantizationTraits<Feature>::dimension == BatchQuantizationTraits<DescriptorT>::dimension &&
+      std::is_same<Distance<DescriptorT, Feature>, L2<DescriptorT, Feature> >::value>
+  {};
+
+  template<class DescriptorT>
+  void quantize(const std::vector<DescriptorT>& features, std::vector<Word>& words, std::false_type) const;
+
+  template<class DescriptorT>
+  void quantize(const std::vector<DescriptorT>& features, std::vector<Word>& words, std::true_type) const
+  {
+    quantizeBatch(features, words);
+  }
+
+  /**
+   * @brief Batched quantization, see quantize.
+   * Features are processed by blocks of at most 256 features reaching the same node.
+   * For each block, the distances to the children centers C are computed as |c|^2 - 2 C^T X (float).
+   */
+  template<class DescriptorT>
+  void quantizeBatch(const std::vector<DescriptorT>& features, std::vector<Word>& words) const;
+
+  /// Center value type in memory
+  typedef typename std::decay<decltype(std::declval<const Feature&>()[0])>::type CenterValue;
+
+  void saveMappable(const std::string& file, ETreeCentersType centersType, std::false_type) const;
+  void saveMappable(const std::string& file, ETreeCentersType centersType, std::true_type) const;
+
+  void loadMappable(const std::string& file, std::false_type);
+  void loadMappable(const std::string& file, std::true_type);
+
+  /// Convert the centers values from a mapped file into the owned centers
+  template<typename StoredValue>
+  void convertMappedCenters(const StoredValue* values, std::size_t nbNodes, std::size_t dimension);
 };
 
 template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
@@ -205,9 +396,9 @@ Word VocabularyTree<Feature, Distance, FeatureAllocator>::quantize(const Descrip
     distance_type best_distance = std::numeric_limits<distance_type>::max();
     for(int32_t child = first_child; child < first_child + (int32_t) splits(); ++child)
     {
-      if(!valid_centers_[child])
+      if(!validCentersData()[child])
         break; // Fewer than splits() children.
-      distance_type child_distance = Distance<DescriptorT, Feature>()(feature, centers_[child]);
+      distance_type child_distance = Distance<DescriptorT, Feature>()(feature, centersData()[child]);
       if(child_distance < best_distance)
       {
         best_child = child;
@@ -228,15 +419,165 @@ std::vector<Word> VocabularyTree<Feature, Distance, FeatureAllocator>::quantize(
   std::vector<Word> imgVisualWords(features.size(), 0);
 
   // quantize the features
+  quantize(features, imgVisualWords, IsBatchQuantizable<DescriptorT>());
+
+  // add the vector to the documents
+  return imgVisualWords;
+}
+
+template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
+template<class DescriptorT>
+void VocabularyTree<Feature, Distance, FeatureAllocator>::quantize(const std::vector<DescriptorT>& features, std::vector<Word>& words, std::false_type) const
+{
   #pragma omp parallel for
   for(ptrdiff_t j = 0; j < static_cast<ptrdiff_t>(features.size()); ++j)
   {
     // store the visual word associated to the feature in the temporary list
-    imgVisualWords[j] = quantize<DescriptorT>(features[j]);
+    words[j] = quantize<DescriptorT>(features[j]);
   }
+}
 
-  // add the vector to the documents
-  return imgVisualWords;
+template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
+template<class DescriptorT>
+void VocabularyTree<Feature, Distance, FeatureAllocator>::quantizeBatch(const std::vector<DescriptorT>& features, std::vector<Word>& words) const
+{
+  typedef typename Feature::bin_type CenterScalar;
+  typedef typename DescriptorT::bin_type DescriptorScalar;
+  typedef Eigen::Matrix<CenterScalar, Eigen::Dynamic, Eigen::Dynamic> CentersMatrix;
+  typedef Eigen::Matrix<DescriptorScalar, Eigen::Dynamic, Eigen::Dynamic> DescriptorsMatrix;
+  static_assert(sizeof(Feature) == sizeof(CenterScalar) * BatchQuantizationTraits<Feature>::dimension, "Centers are not contiguous.");
+  static_assert(sizeof(DescriptorT) == sizeof(DescriptorScalar) * BatchQuantizationTraits<DescriptorT>::dimension, "Descriptors are not contiguous.");
+
+  assert(initialized());
+
+  const int dimension = BatchQuantizationTraits<Feature>::dimension;
+  const int32_t nbFeatures = features.size();
+  const int32_t k = splits();
+  static const int32_t blockSize = 256;
+
+  if(nbFeatures == 0)
+    return;
+
+  const Eigen::Map<const DescriptorsMatrix> descriptors(features.front().getData(), dimension, nbFeatures);
+  const Feature* centers = centersData();
+  const uint8_t* validCenters = validCentersData();
+  const float* centersSquaredNorms = centersSquaredNormsData();
+
+  // current node of each feature, features reaching the same node are contiguous in featuresOrder
+  std::vector<int32_t> nodes(nbFeatures, -1); // virtual "root" index, which has no associated center.
+  std::vector<int32_t> featuresOrder(nbFeatures);
+  std::vector<int32_t> nextFeaturesOrder(nbFeatures);
+  for(int32_t i = 0; i < nbFeatures; ++i)
+    featuresOrder[i] = i;
+
+  // ranges of featuresOrder with the same node
+  std::vector<std::pair<int32_t, int32_t>> groups(1, std::make_pair(0, nbFeatures));
+
+  for(unsigned level = 0; level < levels_; ++level)
+  {
+    // split the groups in blocks
+    std::vector<std::pair<int32_t, int32_t>> blocks;
+    for(const auto& group : groups)
+    {
+      for(int32_t begin = group.first; begin < group.second; begin += blockSize)
+        blocks.emplace_back(begin, std::min(begin + blockSize, group.second));
+    }
+
+    #pragma omp parallel
+    {
+      Eigen::MatrixXf blockDescriptors;
+      Eigen::MatrixXf childrenCenters;
+      Eigen::VectorXf childrenSquaredNorms;
+      Eigen::MatrixXf dotProducts;
+
+      #pragma omp for schedule(dynamic)
+      for(int b = 0; b < static_cast<int>(blocks.size()); ++b)
+      {
+        const int32_t begin = blocks[b].first;
+        const int32_t nbBlockFeatures = blocks[b].second - begin;
+
+        // Calculate the offset to the first child of the current index.
+        const int32_t firstChild = (nodes[featuresOrder[begin]] + 1) * k;
+        int32_t nbChildren = 0;
+        while(nbChildren < k && validCenters[firstChild + nbChildren])
+          ++nbChildren; // Fewer than splits() children.
+
+        if(nbChildren <= 1)
+        {
+          for(int32_t i = 0; i < nbBlockFeatures; ++i)
+            nodes[featuresOrder[begin + i]] = firstChild;
+          continue;
+        }
+
+        childrenCenters = Eigen::Map<const CentersMatrix>(centers[firstChild].getData(), dimension, nbChildren).template cast<float>();
+        if(centersSquaredNorms != nullptr)
+          childrenSquaredNorms = Eigen::Map<const Eigen::VectorXf>(centersSquaredNorms + firstChild, nbChildren);
+        else
+          childrenSquaredNorms = childrenCenters.colwise().squaredNorm().transpose();
+
+        blockDescriptors.resize(dimension, nbBlockFeatures);
+        for(int32_t i = 0; i < nbBlockFeatures; ++i)
+          blockDescriptors.col(i) = descriptors.col(featuresOrder[begin + i]).template cast<float>();
+
+        dotProducts.noalias() = childrenCenters.transpose() * blockDescriptors;
+
+        // Find the child center closest to each feature: |x - c|^2 = |x|^2 + |c|^2 - 2 x.c
+        for(int32_t i = 0; i < nbBlockFeatures; ++i)
+        {
+          int32_t bestChild = 0;
+          float bestDistance = childrenSquaredNorms(0) - 2.f * dotProducts(0, i);
+          for(int32_t c = 1; c < nbChildren; ++c)
+          {
+            const float distance = childrenSquaredNorms(c) - 2.f * dotProducts(c, i);
+            if(distance < bestDistance)
+            {
+              bestChild = c;
+              bestDistance = distance;
+            }
+          }
+          nodes[featuresOrder[begin + i]] = firstChild + bestChild;
+        }
+      }
+    }
+
+    if(level + 1 == levels_)
+      break;
+
+    // gather the features by node for the next level (counting sort of each group by child)
+    std::vector<std::vector<std::pair<int32_t, int32_t>>> nextGroupsPerGroup(groups.size());
+
+    #pragma omp parallel for schedule(dynamic)
+    for(int g = 0; g < static_cast<int>(groups.size()); ++g)
+    {
+      const int32_t begin = groups[g].first;
+      const int32_t end = groups[g].second;
+      const int32_t firstChild = nodes[featuresOrder[begin]] / k * k;
+      std::vector<int32_t> offsets(k + 1, 0);
+
+      for(int32_t i = begin; i < end; ++i)
+        ++offsets[nodes[featuresOrder[i]] - firstChild + 1];
+      for(int32_t c = 0; c < k; ++c)
+        offsets[c + 1] += offsets[c];
+      for(int32_t c = 0; c < k; ++c)
+      {
+        if(offsets[c + 1] > offsets[c])
+          nextGroupsPerGroup[g].emplace_back(begin + offsets[c], begin + offsets[c + 1]);
+      }
+      for(int32_t i = begin; i < end; ++i)
+      {
+        const int32_t feature = featuresOrder[i];
+        nextFeaturesOrder[begin + offsets[nodes[feature] - firstChild]++] = feature;
+      }
+    }
+
+    featuresOrder.swap(nextFeaturesOrder);
+    groups.clear();
+    for(const auto& nextGroups : nextGroupsPerGroup)
+      groups.insert(groups.end(), nextGroups.begin(), nextGroups.end());
+  }
+
+  for(int32_t i = 0; i < nbFeatures; ++i)
+    words[i] = nodes[i] - word_start_;
 }
 
 template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
@@ -272,6 +613,11 @@ void VocabularyTree<Feature, Distance, FeatureAllocator>::clear()
 {
   centers_.clear();
   valid_centers_.clear();
+  centers_squared_norms_.clear();
+  mapped_file_.reset();
+  mapped_centers_ = nullptr;
+  mapped_valid_centers_ = nullptr;
+  mapped_centers_squared_norms_ = nullptr;
   k_ = levels_ = num_words_ = word_start_ = 0;
 }
 
@@ -285,10 +631,78 @@ void VocabularyTree<Feature, Distance, FeatureAllocator>::save(const std::string
   std::ofstream out(file.c_str(), std::ios_base::binary);
   out.write((char*) (&k_), sizeof (uint32_t));
   out.write((char*) (&levels_), sizeof (uint32_t));
-  uint32_t size = centers_.size();
+  uint32_t size = nbCenters();
   out.write((char*) (&size), sizeof (uint32_t));
-  out.write((char*) (&centers_[0]), centers_.size() * sizeof (Feature));
-  out.write((char*) (&valid_centers_[0]), valid_centers_.size());
+  out.write((char*) centersData(), size * sizeof (Feature));
+  out.write((char*) validCentersData(), size);
+}
+
+template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
+void VocabularyTree<Feature, Distance, FeatureAllocator>::saveMappable(const std::string& file, ETreeCentersType centersType) const
+{
+  saveMappable(file, centersType, std::integral_constant<bool, BatchQuantizationTraits<Feature>::supported>());
+}
+
+template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
+void VocabularyTree<Feature, Distance, FeatureAllocator>::saveMappable(const std::string& file, ETreeCentersType centersType, std::false_type) const
+{
+  throw std::runtime_error("The mappable vocabulary tree format is not supported for this descriptor type: " + file);
+}
+
+template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
+void VocabularyTree<Feature, Distance, FeatureAllocator>::saveMappable(const std::string& file, ETreeCentersType centersType, std::true_type) const
+{
+  assert(initialized());
+
+  const std::size_t dimension = BatchQuantizationTraits<Feature>::dimension;
+  const uint32_t nbNodes = nbCenters();
+  const MappableTreeHeader header = createMappableTreeHeader(k_, levels_, nbNodes, dimension, centersType);
+  const Feature* centers = centersData();
+
+  std::vector<char> centersBlock(header.validCentersOffset - header.centersOffset, 0);
+  std::vector<float> squaredNorms(nbNodes);
+
+  #pragma omp parallel for
+  for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(nbNodes); ++i)
+  {
+    float squaredNorm = 0.f;
+    if(centersType == ETreeCentersType::UINT8)
+    {
+      uint8_t* values = reinterpret_cast<uint8_t*>(centersBlock.data()) + i * dimension;
+      for(std::size_t d = 0; d < dimension; ++d)
+      {
+        const float value = std::round(static_cast<float>(centers[i][d]));
+        values[d] = static_cast<uint8_t>(std::min(255.f, std::max(0.f, value)));
+        squaredNorm += static_cast<float>(values[d]) * static_cast<float>(values[d]);
+      }
+    }
+    else
+    {
+      float* values = reinterpret_cast<float*>(centersBlock.data()) + i * dimension;
+      for(std::size_t d = 0; d < dimension; ++d)
+      {
+        values[d] = static_cast<float>(centers[i][d]);
+        squaredNorm += values[d] * values[d];
+      }
+    }
+    squaredNorms[i] = squaredNorm;
+  }
+
+  std::ofstream out(file.c_str(), std::ios_base::binary);
+  if(!out.is_open())
+    throw std::runtime_error("Failed to open vocabulary tree file for writing: " + file);
+
+  // the gaps between the blocks are smaller than the blocks alignment
+  const std::vector<char> padding(64, 0);
+  out.write((const char*) (&header), sizeof (MappableTreeHeader));
+  out.write(padding.data(), header.centersOffset - sizeof (MappableTreeHeader));
+  out.write(centersBlock.data(), centersBlock.size());
+  out.write((const char*) validCentersData(), nbNodes);
+  out.write(padding.data(), header.squaredNormsOffset - header.validCentersOffset - nbNodes);
+  out.write((const char*) squaredNorms.data(), nbNodes * sizeof (float));
+
+  if(!out.good())
+    throw std::runtime_error("Failed to write vocabulary tree file: " + file);
 }
 
 template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
@@ -296,6 +710,12 @@ void VocabularyTree<Feature, Distance, FeatureAllocator>::load(const std::string
 {
   clear();
 
+  if(isMappableTreeFile(file))
+  {
+    loadMappable(file, std::integral_constant<bool, BatchQuantizationTraits<Feature>::supported>());
+    return;
+  }
+
   std::ifstream in;
   in.exceptions(std::ifstream::eofbit | std::ifstream::failbit | std::ifstream::badbit);
 
@@ -318,6 +738,110 @@ void VocabularyTree<Feature, Distance, FeatureAllocator>::load(const std::string
 
   setNodeCounts();
   assert(size == num_words_ + word_start_);
+
+  computeCentersSquaredNorms();
+}
+
+template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
+void VocabularyTree<Feature, Distance, FeatureAllocator>::loadMappable(const std::string& file, std::false_type)
+{
+  throw std::runtime_error("The mappable vocabulary tree format is not supported for this descriptor type: " + file);
+}
+
+template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
+void VocabularyTree<Feature, Distance, FeatureAllocator>::loadMappable(const std::string& file, std::true_type)
+{
+  std::shared_ptr<system::MemoryMappedFile> mappedFile = std::make_shared<system::MemoryMappedFile>(file);
+  const MappableTreeHeader& header = readMappableTreeHeader(mappedFile->data(), mappedFile->size(), file);
+
+  if(header.dimension != BatchQuantizationTraits<Feature>::dimension)
+    throw std::runtime_error("Invalid descriptor dimension (" + std::to_string(header.dimension) + ") in vocabulary tree file: " + file);
+
+  k_ = header.k;
+  levels_ = header.levels;
+  setNodeCounts();
+  if(header.nbNodes != word_start_ + num_words_)
+    throw std::runtime_error("Invalid number of nodes in vocabulary tree file: " + file);
+
+  const ETreeCentersType centersType = static_cast<ETreeCentersType>(header.centersType);
+  const char* data = mappedFile->data();
+  const bool isSameType = (treeCentersTypeSize(centersType) == sizeof(CenterValue)) &&
+      (std::is_same<CenterValue, float>::value == (centersType == ETreeCentersType::FLOAT));
+
+  if(isSameType && sizeof(Feature) == sizeof(CenterValue) * header.dimension)
+  {
+    // use the file in place
+    mapped_centers_ = reinterpret_cast<const Feature*>(data + header.centersOffset);
+    mapped_valid_centers_ = reinterpret_cast<const uint8_t*>(data + header.validCentersOffset);
+    mapped_centers_squared_norms_ = reinterpret_cast<const float*>(data + header.squaredNormsOffset);
+    mapped_file_ = mappedFile;
+    return;
+  }
+
+  ALICEVISION_LOG_DEBUG("Convert the centers of the vocabulary tree file: " << file);
+
+  if(centersType == ETreeCentersType::UINT8)
+    convertMappedCenters(reinterpret_cast<const uint8_t*>(data + header.centersOffset), header.nbNodes, header.dimension);
+  else
+    convertMappedCenters(reinterpret_cast<const float*>(data + header.centersOffset), header.nbNodes, header.dimension);
+
+  valid_centers_.assign(data + header.validCentersOffset, data + header.validCentersOffset + header.nbNodes);
+  computeCentersSquaredNorms();
+}
+
+template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
+template<typename StoredValue>
+void VocabularyTree<Feature, Distance, FeatureAllocator>::convertMappedCenters(const StoredValue* values, std::size_t nbNodes, std::size_t dimension)
+{
+  centers_.resize(nbNodes);
+
+  #pragma omp parallel for
+  for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(nbNodes); ++i)
+  {
+    for(std::size_t d = 0; d < dimension; ++d)
+    {
+      const StoredValue value = values[i * dimension + d];
+      if(std::is_floating_point<CenterValue>::value)
+        centers_[i][d] = static_cast<CenterValue>(value);
+      else
+        centers_[i][d] = static_cast<CenterValue>(std::min(255.f, std::max(0.f, std::round(static_cast<float>(value)))));
+    }
+  }
+}
+
+template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
+void VocabularyTree<Feature, Distance, FeatureAllocator>::detachMapping()
+{
+  if(!isMapped())
+    return;
+
+  const std::size_t nbNodes = nbCenters();
+  centers_.assign(mapped_centers_, mapped_centers_ + nbNodes);
+  valid_centers_.assign(mapped_valid_centers_, mapped_valid_centers_ + nbNodes);
+  centers_squared_norms_.assign(mapped_centers_squared_norms_, mapped_centers_squared_norms_ + nbNodes);
+
+  mapped_file_.reset();
+  mapped_centers_ = nullptr;
+  mapped_valid_centers_ = nullptr;
+  mapped_centers_squared_norms_ = nullptr;
+}
+
+template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
+void VocabularyTree<Feature, Distance, FeatureAllocator>::computeCentersSquaredNorms()
+{
+  centers_squared_norms_.clear();
+  if(!BatchQuantizationTraits<Feature>::supported || isMapped())
+    return;
+
+  centers_squared_norms_.resize(centers_.size());
+  #pragma omp parallel for
+  for(ptrdiff_t i = 0; i < static_cast<ptrdiff_t>(centers_.size()); ++i)
+  {
+    float squaredNorm = 0.f;
+    for(std::size_t d = 0; d < centers_[i].size(); ++d)
+      squaredNorm += static_cast<float>(centers_[i][d]) * static_cast<float>(centers_[i][d]);
+    centers_squared_norms_[i] = squaredNorm;
+  }
 }
 
 template<class Feature, template<typename, typename> class Distance, class FeatureAllocator>
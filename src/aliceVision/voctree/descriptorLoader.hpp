@@ -10,6 +10,7 @@
 #include <aliceVision/sfmData/SfMData.hpp>
 #include <aliceVision/voctree/Database.hpp>
 #include <aliceVision/voctree/VocabularyTree.hpp>
+#include <aliceVision/voctree/FeaturesStream.hpp>
 
 #include <string>
 
@@ -52,6 +53,39 @@ std::size_t readDescFromFiles(const sfmData::SfMData& sfmData,
                          std::vector<DescriptorT>& descriptors,
                          std::vector<std::size_t>& numFeatures);
 
+/**
+ * @brief Stream over the descriptor files of a sfmData, the files are read when needed
+ * and gathered in chunks of at least chunkSize descriptors (or the last files).
+ */
+template<class DescriptorT, class FileDescriptorT>
+class DescriptorFilesStream : public FeaturesStream<DescriptorT, std::allocator<DescriptorT> >
+{
+public:
+  /**
+   * @param[in] sfmData The input sfmData
+   * @param[in] featuresFolders The folder(s) containing the descriptor files (optional)
+   * @param[in] chunkSize The minimal number of descriptors per chunk
+   */
+  DescriptorFilesStream(const sfmData::SfMData& sfmData,
+                        const std::vector<std::string>& featuresFolders,
+                        std::size_t chunkSize);
+
+  void rewind() override;
+
+  bool read(std::vector<DescriptorT>& chunk) override;
+
+  /// Descriptor file of each view
+  const std::map<IndexT, std::string>& getDescriptorsFiles() const
+  {
+    return _descriptorsFiles;
+  }
+
+private:
+  std::map<IndexT, std::string> _descriptorsFiles;
+  std::map<IndexT, std::string>::const_iterator _nextFile;
+  const std::size_t _chunkSize;
+};
+
 } // namespace voctree
 } // namespace aliceVision
 
@@ -89,5 +89,33 @@ std::size_t readDescFromFiles(const sfmData::SfMData& sfmData,
   return numDescriptors;
 }
 
+template<class DescriptorT, class FileDescriptorT>
+DescriptorFilesStream<DescriptorT, FileDescriptorT>::DescriptorFilesStream(const sfmData::SfMData& sfmData,
+                                                                           const std::vector<std::string>& featuresFolders,
+                                                                           std::size_t chunkSize)
+  : _chunkSize(chunkSize)
+{
+  getListOfDescriptorFiles(sfmData, featuresFolders, _descriptorsFiles);
+  _nextFile = _descriptorsFiles.begin();
+}
+
+template<class DescriptorT, class FileDescriptorT>
+void DescriptorFilesStream<DescriptorT, FileDescriptorT>::rewind()
+{
+  _nextFile = _descriptorsFiles.begin();
+}
+
+template<class DescriptorT, class FileDescriptorT>
+bool DescriptorFilesStream<DescriptorT, FileDescriptorT>::read(std::vector<DescriptorT>& chunk)
+{
+  chunk.clear();
+  while(_nextFile != _descriptorsFiles.end() && (chunk.empty() || chunk.size() < _chunkSize))
+  {
+    feature::loadDescsFromBinFile<DescriptorT, FileDescriptorT>(_nextFile->second, chunk, true);
+    ++_nextFile;
+  }
+  return !chunk.empty();
+}
+
 } // namespace voctree
 } // namespace aliceVision
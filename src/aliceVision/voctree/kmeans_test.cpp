@@ -291,3 +291,49 @@ BOOST_AUTO_TEST_CASE(kmeanVarying)
     }
   }
 }
+
+BOOST_AUTO_TEST_CASE(kmeanMiniBatch)
+{
+  using namespace aliceVision;
+
+  const std::size_t DIMENSION = 8;
+  const std::size_t FEATURENUMBER = 2000;
+  const std::size_t K = 10;
+  const float STEP = 10.f;
+
+  typedef Eigen::Matrix<float, 1, DIMENSION> FeatureFloat;
+  typedef std::vector<FeatureFloat, Eigen::aligned_allocator<FeatureFloat> > FeatureFloatVector;
+
+  // K well separated clusters
+  FeatureFloatVector features;
+  FeatureFloatVector centersGT;
+  features.reserve(FEATURENUMBER * K);
+  for(std::size_t i = 0; i < K; ++i)
+  {
+    centersGT.push_back(FeatureFloat::Random() * STEP * K);
+    for(std::size_t j = 0; j < FEATURENUMBER; ++j)
+      features.push_back(centersGT.back() + FeatureFloat::Random());
+  }
+
+  voctree::SimpleKmeans<FeatureFloat> kmeans(FeatureFloat::Zero());
+  kmeans.setRestarts(3);
+  kmeans.setMiniBatchSize(500);
+  BOOST_CHECK_EQUAL(kmeans.getMiniBatchSize(), 500);
+
+  FeatureFloatVector centers;
+  std::vector<unsigned int> membership;
+  kmeans.cluster(features, K, centers, membership);
+
+  BOOST_REQUIRE_EQUAL(centers.size(), K);
+  BOOST_REQUIRE_EQUAL(membership.size(), features.size());
+
+  // each ground truth cluster is found and its features have the same membership
+  voctree::L2<FeatureFloat, FeatureFloat> distance;
+  for(std::size_t i = 0; i < K; ++i)
+  {
+    const unsigned int cluster = membership[i * FEATURENUMBER];
+    BOOST_CHECK_LT(distance(centers[cluster], centersGT[i]), 0.1f);
+    for(std::size_t j = 0; j < FEATURENUMBER; ++j)
+      BOOST_CHECK_EQUAL(membership[i * FEATURENUMBER + j], cluster);
+  }
+}
@@ -84,3 +84,119 @@ BOOST_AUTO_TEST_CASE(voctreeBuilder)
   }
 //  voctree::printFeatVector( features ); 
 }
+
+BOOST_AUTO_TEST_CASE(voctreeBuilderStreaming)
+{
+  using namespace aliceVision;
+
+  const std::size_t DIMENSION = 3;
+  const std::size_t FEATURENUMBER = 200;
+  const std::size_t K = 4;
+  const std::size_t LEVELS = 3;
+  const std::size_t LEAVESNUMBER = std::pow(K, LEVELS);
+
+  typedef Eigen::Matrix<float, 1, DIMENSION> FeatureFloat;
+  typedef std::vector<FeatureFloat, Eigen::aligned_allocator<FeatureFloat> > FeatureFloatVector;
+
+  // LEAVESNUMBER clusters with a hierarchical structure matching the tree
+  FeatureFloatVector features;
+  features.reserve(FEATURENUMBER * LEAVESNUMBER);
+  FeatureFloatVector levelCenters(1, FeatureFloat::Zero());
+  float scale = 1000.f;
+  for(std::size_t level = 0; level < LEVELS; ++level, scale /= 10.f)
+  {
+    FeatureFloatVector childrenCenters;
+    for(const FeatureFloat& center : levelCenters)
+      for(std::size_t i = 0; i < K; ++i)
+        childrenCenters.push_back(center + FeatureFloat::Random() * scale);
+    levelCenters.swap(childrenCenters);
+  }
+  for(const FeatureFloat& center : levelCenters)
+    for(std::size_t j = 0; j < FEATURENUMBER; ++j)
+      features.push_back(center + FeatureFloat::Random() * 0.1f);
+
+  // sum of the squared distances of the features to their leaf
+  const auto computeSSE = [&](const voctree::MutableVocabularyTree<FeatureFloat>& tree)
+  {
+    voctree::L2<FeatureFloat, FeatureFloat> distance;
+    double sse = 0.0;
+    for(const FeatureFloat& f : features)
+      sse += distance(f, tree.centers()[tree.quantize(f) + tree.nodes() - tree.words()]);
+    return sse;
+  };
+
+  voctree::TreeBuilder<FeatureFloat> builder(FeatureFloat::Zero());
+  builder.kmeans().setRestarts(5);
+  builder.build(features, K, LEVELS);
+  const double sse = computeSSE(builder.tree());
+
+  // streamed by chunks, with a small sample to initialize the nodes and mini-batch k-means
+  voctree::TreeBuilder<FeatureFloat> streamingBuilder(FeatureFloat::Zero());
+  streamingBuilder.kmeans().setRestarts(5);
+  streamingBuilder.kmeans().setMiniBatchSize(100);
+  streamingBuilder.setMaxSampleSize(2000);
+  streamingBuilder.setNbPasses(2);
+  BOOST_CHECK_EQUAL(streamingBuilder.getMaxSampleSize(), 2000);
+  BOOST_CHECK_EQUAL(streamingBuilder.getNbPasses(), 2);
+
+  voctree::FeaturesVectorStream<FeatureFloat> featuresStream(features, 1000);
+  streamingBuilder.build(featuresStream, K, LEVELS);
+
+  const voctree::MutableVocabularyTree<FeatureFloat>& tree = streamingBuilder.tree();
+  BOOST_CHECK_EQUAL(tree.centers().size(), tree.nodes());
+  BOOST_CHECK_EQUAL(tree.validCenters().size(), tree.nodes());
+  for(std::size_t i = 0; i < K; ++i)
+    BOOST_CHECK(tree.validCenters()[i] != 0);
+
+  const double streamingSSE = computeSSE(tree);
+  ALICEVISION_LOG_DEBUG("SSE: " << sse << ", streaming SSE: " << streamingSSE);
+  BOOST_CHECK_LT(streamingSSE, 2.0 * sse);
+
+  // fewer features than leaves: the leaves are the features themselves
+  FeatureFloatVector fewFeatures(features.begin(), features.begin() + FEATURENUMBER * 2);
+  fewFeatures.resize(10);
+  voctree::FeaturesVectorStream<FeatureFloat> fewFeaturesStream(fewFeatures, 3);
+  streamingBuilder.build(fewFeaturesStream, K, LEVELS);
+  for(const FeatureFloat& f : fewFeatures)
+  {
+    const voctree::Word word = streamingBuilder.tree().quantize(f);
+    BOOST_CHECK_SMALL((streamingBuilder.tree().centers()[word + tree.nodes() - tree.words()] - f).norm(), 1e-5f);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(voctreeBuilderDeterministic)
+{
+  using namespace aliceVision;
+
+  const std::size_t DIMENSION = 3;
+  const std::size_t FEATURENUMBER = 5000;
+  const std::size_t K = 4;
+  const std::size_t LEVELS = 3;
+
+  typedef Eigen::Matrix<float, 1, DIMENSION> FeatureFloat;
+  typedef std::vector<FeatureFloat, Eigen::aligned_allocator<FeatureFloat> > FeatureFloatVector;
+
+  FeatureFloatVector features;
+  features.reserve(FEATURENUMBER);
+  for(std::size_t i = 0; i < FEATURENUMBER; ++i)
+    features.push_back(FeatureFloat::Random());
+
+  // the subsets of a level are clustered in parallel, each one with its own generator:
+  // with the same seed, the tree does not depend on the threads
+  // (mini-batch k-means, as the Lloyd's algorithm accumulates the centers in the threads order)
+  const auto buildTree = [&]()
+  {
+    voctree::TreeBuilder<FeatureFloat> builder(FeatureFloat::Zero());
+    builder.kmeans().setMiniBatchSize(100);
+    srand(0);
+    builder.build(features, K, LEVELS);
+    return builder.tree().centers();
+  };
+
+  const FeatureFloatVector centers = buildTree();
+  const FeatureFloatVector otherCenters = buildTree();
+
+  BOOST_CHECK_EQUAL(centers.size(), otherCenters.size());
+  for(std::size_t i = 0; i < std::min(centers.size(), otherCenters.size()); ++i)
+    BOOST_CHECK(centers[i] == otherCenters[i]);
+}
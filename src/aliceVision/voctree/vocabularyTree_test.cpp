@@ -5,9 +5,16 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include <aliceVision/voctree/Database.hpp>
+#include <aliceVision/voctree/MutableVocabularyTree.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
 #include <iostream>
 #include <fstream>
+#include <random>
+#include <string>
 #include <vector>
 
 #define BOOST_TEST_MODULE vocabularyTree
@@ -58,3 +65,241 @@ BOOST_AUTO_TEST_CASE(database)
     BOOST_CHECK_SMALL(static_cast<double>(match[0].score), 0.001);
   }
 }
+
+BOOST_AUTO_TEST_CASE(database_invertedIndex)
+{
+  const int nbDocuments = 50;
+  const int nbWords = 200;
+
+  std::mt19937 generator(42);
+  std::uniform_int_distribution<int> wordDistribution(0, nbWords - 1);
+  std::uniform_int_distribution<int> sizeDistribution(1, 60);
+
+  // random documents inserted in a random order, with repeated words
+  SparseHistogramPerImage documents;
+  for(int i = 0; i < nbDocuments; ++i)
+  {
+    std::vector<Word> document(sizeDistribution(generator));
+    for(Word& word : document)
+      word = wordDistribution(generator);
+    computeSparseHistogram(document, documents[(i * 17) % nbDocuments]);
+  }
+
+  Database db(nbWords);
+  for(const auto& document : documents)
+    db.insert(document.first, document.second);
+  db.computeTfIdfWeights();
+
+  std::vector<float> weights(nbWords);
+  {
+    // same weights as the database
+    std::map<Word, int> nbDocumentsPerWord;
+    for(const auto& document : documents)
+      for(const auto& wordPair : document.second)
+        ++nbDocumentsPerWord[wordPair.first];
+    for(int w = 0; w < nbWords; ++w)
+      weights[w] = nbDocumentsPerWord.count(w) ? std::log(float(nbDocuments) / nbDocumentsPerWord.at(w)) : 1.0f;
+  }
+
+  for(const std::string distanceMethod : {"classic", "commonPoints", "strongCommonPoints", "tfidf"})
+  {
+    std::map<DocId, DocMatches> allMatches;
+    db.find(documents, 10, allMatches, distanceMethod);
+    BOOST_CHECK_EQUAL(allMatches.size(), documents.size());
+
+    for(const auto& query : documents)
+    {
+      // brute force
+      DocMatches expectedMatches;
+      for(const auto& document : documents)
+        expectedMatches.emplace_back(document.first, sparseDistance(query.second, document.second, distanceMethod, weights));
+      std::sort(expectedMatches.begin(), expectedMatches.end());
+      expectedMatches.resize(10);
+
+      DocMatches matches;
+      db.find(query.second, 10, matches, distanceMethod);
+      BOOST_CHECK(matches == allMatches.at(query.first));
+
+      if(distanceMethod == "tfidf")
+      {
+        BOOST_REQUIRE_EQUAL(matches.size(), expectedMatches.size());
+        BOOST_CHECK_EQUAL(matches.front().id, query.first);
+        for(std::size_t i = 0; i < matches.size(); ++i)
+          BOOST_CHECK_SMALL(matches[i].score - expectedMatches[i].score, 1e-5f);
+      }
+      else
+      {
+        BOOST_CHECK(matches == expectedMatches);
+      }
+    }
+  }
+}
+
+template<class DescriptorT>
+void checkBatchQuantization(const MutableVocabularyTree<aliceVision::feature::Descriptor<float, 128>>& tree, std::mt19937& generator)
+{
+  std::uniform_int_distribution<int> valueDistribution(0, 255);
+
+  std::vector<DescriptorT> descriptors(3000);
+  for(DescriptorT& descriptor : descriptors)
+    for(std::size_t d = 0; d < descriptor.size(); ++d)
+      descriptor[d] = valueDistribution(generator);
+
+  // batched quantization
+  const std::vector<Word> words = tree.quantize(descriptors);
+  BOOST_REQUIRE_EQUAL(words.size(), descriptors.size());
+
+  // one descriptor at a time, distances are computed in double
+  for(std::size_t i = 0; i < descriptors.size(); ++i)
+  {
+    BOOST_CHECK_LT(words[i], tree.words());
+    BOOST_CHECK_EQUAL(words[i], tree.quantize(descriptors[i]));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(vocabularyTree_batchQuantization)
+{
+  typedef aliceVision::feature::Descriptor<float, 128> CenterT;
+
+  const uint32_t k = 6;
+  const uint32_t levels = 4;
+
+  // integer values in [0, 255]: the float matrix products are exact (all the sums are below 2^24),
+  // so the batched words are identical to the words of the per-feature descent, ties included
+  std::mt19937 generator(7);
+  std::uniform_int_distribution<int> valueDistribution(0, 255);
+
+  MutableVocabularyTree<CenterT> tree;
+  tree.setSize(levels, k);
+  tree.centers().resize(tree.nodes());
+  tree.validCenters().assign(tree.nodes(), 1);
+  for(CenterT& center : tree.centers())
+    for(std::size_t d = 0; d < center.size(); ++d)
+      center[d] = valueDistribution(generator);
+
+  // some nodes have fewer than k children
+  for(uint32_t node = 0; node < tree.nodes(); node += 7 * k)
+    tree.validCenters()[node + k - 1] = 0;
+
+  checkBatchQuantization<aliceVision::feature::Descriptor<unsigned char, 128>>(tree, generator);
+  checkBatchQuantization<CenterT>(tree, generator);
+
+  // with the cached norms of the centers
+  const std::string treeFilepath = "batchQuantization.tree";
+  tree.save(treeFilepath);
+  MutableVocabularyTree<CenterT> loadedTree;
+  loadedTree.load(treeFilepath);
+  checkBatchQuantization<aliceVision::feature::Descriptor<unsigned char, 128>>(loadedTree, generator);
+  std::remove(treeFilepath.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(vocabularyTree_mappableFormat)
+{
+  typedef aliceVision::feature::Descriptor<float, 128> CenterT;
+  typedef aliceVision::feature::Descriptor<unsigned char, 128> CenterUCharT;
+
+  const uint32_t k = 5;
+  const uint32_t levels = 3;
+
+  std::mt19937 generator(11);
+  std::uniform_real_distribution<float> valueDistribution(0.f, 255.f);
+
+  MutableVocabularyTree<CenterT> tree;
+  tree.setSize(levels, k);
+  tree.centers().resize(tree.nodes());
+  tree.validCenters().assign(tree.nodes(), 1);
+  for(CenterT& center : tree.centers())
+    for(std::size_t d = 0; d < center.size(); ++d)
+      center[d] = valueDistribution(generator);
+  for(uint32_t node = 0; node < tree.nodes(); node += 3 * k)
+    tree.validCenters()[node + k - 1] = 0;
+
+  std::vector<CenterUCharT> descriptors(2000);
+  for(CenterUCharT& descriptor : descriptors)
+    for(std::size_t d = 0; d < descriptor.size(); ++d)
+      descriptor[d] = static_cast<unsigned char>(valueDistribution(generator));
+
+  // reference: tree loaded from the legacy format
+  const std::string legacyFilepath = "mappableFormat.tree";
+  tree.save(legacyFilepath);
+  BOOST_CHECK(!isMappableTreeFile(legacyFilepath));
+  VocabularyTree<CenterT> legacyTree(legacyFilepath);
+  BOOST_CHECK(!legacyTree.isMapped());
+
+  // float centers: used in place
+  const std::string floatFilepath = "mappableFormat.float.tree";
+  tree.saveMappable(floatFilepath);
+  BOOST_CHECK(isMappableTreeFile(floatFilepath));
+  {
+    VocabularyTree<CenterT> mappedTree(floatFilepath);
+    BOOST_CHECK(mappedTree.isMapped());
+    BOOST_CHECK(mappedTree == legacyTree);
+    BOOST_CHECK_EQUAL(mappedTree.words(), legacyTree.words());
+    BOOST_CHECK(mappedTree.quantize(descriptors) == legacyTree.quantize(descriptors));
+    for(std::size_t i = 0; i < 100; ++i)
+      BOOST_CHECK_EQUAL(mappedTree.quantize(descriptors[i]), legacyTree.quantize(descriptors[i]));
+
+    // a mutable tree owns its centers
+    MutableVocabularyTree<CenterT> mutableTree;
+    mutableTree.load(floatFilepath);
+    BOOST_CHECK(!mutableTree.isMapped());
+    BOOST_CHECK(mutableTree == tree);
+
+    // mapped tree saved in the legacy format
+    const std::string resavedFilepath = "mappableFormat.resaved.tree";
+    mappedTree.save(resavedFilepath);
+    VocabularyTree<CenterT> resavedTree(resavedFilepath);
+    BOOST_CHECK(resavedTree == legacyTree);
+    std::remove(resavedFilepath.c_str());
+  }
+
+  // uint8 centers: used in place by a uint8 tree, converted for a float tree
+  const std::string uint8Filepath = "mappableFormat.uint8.tree";
+  tree.saveMappable(uint8Filepath, ETreeCentersType::UINT8);
+  {
+    std::ifstream floatFile(floatFilepath, std::ios::binary | std::ios::ate);
+    std::ifstream uint8File(uint8Filepath, std::ios::binary | std::ios::ate);
+    BOOST_CHECK_LT(4 * static_cast<std::size_t>(uint8File.tellg()), 2 * static_cast<std::size_t>(floatFile.tellg()));
+  }
+
+  MutableVocabularyTree<CenterT> roundedTree;
+  roundedTree.setSize(levels, k);
+  roundedTree.centers() = tree.centers();
+  roundedTree.validCenters() = tree.validCenters();
+  for(CenterT& center : roundedTree.centers())
+    for(std::size_t d = 0; d < center.size(); ++d)
+      center[d] = std::round(center[d]);
+
+  VocabularyTree<CenterUCharT> uint8Tree(uint8Filepath);
+  BOOST_CHECK(uint8Tree.isMapped());
+  VocabularyTree<CenterT> convertedTree(uint8Filepath);
+  BOOST_CHECK(!convertedTree.isMapped());
+  BOOST_CHECK(convertedTree == roundedTree);
+
+  const std::vector<Word> convertedWords = convertedTree.quantize(descriptors);
+  BOOST_CHECK(uint8Tree.quantize(descriptors) == convertedWords);
+  for(std::size_t i = 0; i < 100; ++i)
+    BOOST_CHECK_EQUAL(uint8Tree.quantize(descriptors[i]), convertedWords[i]);
+
+  // invalid files
+  {
+    std::ofstream out(uint8Filepath, std::ios::binary | std::ios::in | std::ios::out);
+    out.seekp(4);
+    const uint32_t version = 42;
+    out.write(reinterpret_cast<const char*>(&version), sizeof(version));
+  }
+  BOOST_CHECK_THROW(VocabularyTree<CenterT>{uint8Filepath}, std::runtime_error);
+  typedef aliceVision::feature::Descriptor<float, 64> OtherCenterT;
+  BOOST_CHECK_THROW(VocabularyTree<OtherCenterT>{floatFilepath}, std::runtime_error);
+  {
+    std::ofstream out(floatFilepath, std::ios::binary | std::ios::in | std::ios::out);
+    out.seekp(offsetof(MappableTreeHeader, centersType));
+    const uint32_t centersType = 42;
+    out.write(reinterpret_cast<const char*>(&centersType), sizeof(centersType));
+  }
+  BOOST_CHECK_THROW(VocabularyTree<CenterT>{floatFilepath}, std::runtime_error);
+
+  std::remove(legacyFilepath.c_str());
+  std::remove(floatFilepath.c_str());
+  std::remove(uint8Filepath.c_str());
+}
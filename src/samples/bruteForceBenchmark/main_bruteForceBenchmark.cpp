@@ -0,0 +1,156 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/matching/bruteForceKernels.hpp>
+#include <aliceVision/feature/metric.hpp>
+#include <aliceVision/feature/Hamming.hpp>
+#include <aliceVision/system/cpu.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/stl/indexedSort.hpp>
+#include <aliceVision/system/Timer.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// These constants define the current software version.
+// They must be updated when the command line is changed.
+#define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+
+using namespace aliceVision;
+using namespace aliceVision::matching;
+
+namespace po = boost::program_options;
+
+/**
+ * @brief Per-pair metric loop followed by a partial sort,
+ * as done by ArrayMatcher_bruteForce before the tiled kernels.
+ */
+template <typename T, typename Metric>
+void referenceNN2(const std::vector<T>& queries, const std::vector<T>& database, int dimension)
+{
+  typedef typename Metric::ResultType DistanceType;
+  const int nbQueries = queries.size() / dimension;
+  const int nbDatabase = database.size() / dimension;
+  Metric metric;
+
+  #pragma omp parallel for schedule(dynamic)
+  for(int q = 0; q < nbQueries; ++q)
+  {
+    std::vector<DistanceType> distances(nbDatabase);
+    for(int d = 0; d < nbDatabase; ++d)
+      distances[d] = metric(&queries[q * dimension], &database[d * dimension], dimension);
+
+    using namespace stl::indexed_sort;
+    std::vector<sort_index_packet_ascend<DistanceType, int> > packets(nbDatabase);
+    sort_index_helper(packets, &distances[0], 2);
+  }
+}
+
+void printResult(const std::string& name, int nbQueries, int nbDatabase, double seconds, double referenceSeconds)
+{
+  std::cout << std::left << std::setw(24) << name
+            << std::right << std::setw(14) << std::fixed << std::setprecision(0) << nbQueries / seconds << " desc/s"
+            << std::setw(10) << std::setprecision(2) << (double(nbQueries) * nbDatabase) / seconds * 1e-9 << " Gpairs/s"
+            << std::setw(8) << std::setprecision(2) << referenceSeconds / seconds << "x" << std::endl;
+}
+
+template <typename T, typename DistanceT, typename Metric, typename NN2Function, typename Generator>
+void benchmark(const std::string& name, int nbQueries, int nbDatabase, int dimension, int nbRuns,
+               Generator generator, NN2Function nn2Function)
+{
+  std::vector<T> queries(nbQueries * dimension);
+  std::vector<T> database(nbDatabase * dimension);
+  for(T& v : queries) v = generator();
+  for(T& v : database) v = generator();
+
+  std::cout << "\n" << name << " (" << nbQueries << " x " << nbDatabase << " descriptors, dimension " << dimension << ")" << std::endl;
+
+  system::Timer timer;
+  for(int i = 0; i < nbRuns; ++i)
+    referenceNN2<T, Metric>(queries, database, dimension);
+  const double referenceSeconds = timer.elapsed() / nbRuns;
+  printResult("per-pair metric", nbQueries, nbDatabase, referenceSeconds, referenceSeconds);
+
+  std::vector<NearestNeighbours2<DistanceT> > nearestNeighbours(nbQueries);
+  for(system::ESimdLevel level : {system::ESimdLevel::NONE, system::ESimdLevel::SSE2, system::ESimdLevel::AVX2, system::ESimdLevel::AVX512})
+  {
+    if(level > system::getSimdLevel())
+      break;
+    timer.reset();
+    for(int i = 0; i < nbRuns; ++i)
+      nn2Function(&queries[0], nbQueries, &database[0], nbDatabase, dimension, &nearestNeighbours[0], level);
+    printResult("tiled " + system::ESimdLevel_enumToString(level), nbQueries, nbDatabase, timer.elapsed() / nbRuns, referenceSeconds);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  int nbQueries = 5000;
+  int nbDatabase = 5000;
+  int nbRuns = 3;
+
+  po::options_description allParams("AliceVision Sample bruteForceBenchmark\n"
+                                    "Compare the brute force nearest neighbours kernels on random descriptors.");
+  allParams.add_options()
+    ("help,h", "Print this message.")
+    ("nbQueries", po::value<int>(&nbQueries)->default_value(nbQueries),
+      "Number of query descriptors.")
+    ("nbDatabase", po::value<int>(&nbDatabase)->default_value(nbDatabase),
+      "Number of database descriptors.")
+    ("nbRuns", po::value<int>(&nbRuns)->default_value(nbRuns),
+      "Number of runs to average.");
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help"))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  if(nbQueries < 1 || nbDatabase < 2 || nbRuns < 1)
+  {
+    ALICEVISION_CERR("ERROR: at least 1 query, 2 database descriptors and 1 run are needed.");
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "CPU SIMD level: " << system::ESimdLevel_enumToString(system::getSimdLevel()) << std::endl;
+
+  std::mt19937 randomNumberGenerator(42);
+  std::uniform_int_distribution<int> byteDistribution(0, 255);
+  std::uniform_real_distribution<float> floatDistribution(0.f, 1.f);
+  auto randomByte = [&]() { return static_cast<unsigned char>(byteDistribution(randomNumberGenerator)); };
+  auto randomFloat = [&]() { return floatDistribution(randomNumberGenerator); };
+
+  void (*nn2L2Uchar)(const unsigned char*, int, const unsigned char*, int, int, NearestNeighbours2<int>*, system::ESimdLevel) = &bruteForceNN2L2;
+  void (*nn2L2Float)(const float*, int, const float*, int, int, NearestNeighbours2<float>*, system::ESimdLevel) = &bruteForceNN2L2;
+
+  benchmark<unsigned char, int, feature::L2_Vectorized<unsigned char> >(
+    "uint8 L2 (SIFT)", nbQueries, nbDatabase, 128, nbRuns, randomByte, nn2L2Uchar);
+  benchmark<float, float, feature::L2_Vectorized<float> >(
+    "float L2 (SIFT_FLOAT)", nbQueries, nbDatabase, 128, nbRuns, randomFloat, nn2L2Float);
+  benchmark<unsigned char, int, feature::Hamming<unsigned char> >(
+    "Hamming (AKAZE_MLDB)", nbQueries, nbDatabase, 64, nbRuns, randomByte, &bruteForceNN2Hamming);
+
+  return EXIT_SUCCESS;
+}
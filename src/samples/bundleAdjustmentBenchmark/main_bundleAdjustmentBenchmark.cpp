@@ -0,0 +1,147 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/sfm/BundleAdjustmentCeres.hpp>
+#include <aliceVision/sfm/utils/syntheticScene.hpp>
+#include <aliceVision/sfmData/SfMData.hpp>
+#include <aliceVision/multiview/NViewDataSet.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+// These constants define the current software version.
+// They must be updated when the command line is changed.
+#define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+
+using namespace aliceVision;
+
+namespace po = boost::program_options;
+
+void printResult(const std::string& name, const sfm::BundleAdjustmentCeres::Statistics& statistics, double referenceJacobianSeconds)
+{
+  std::cout << std::left << std::setw(24) << name
+            << std::right << std::fixed << std::setprecision(3)
+            << std::setw(10) << statistics.jacobianEvaluationTime << " s jacobians"
+            << std::setw(8) << std::setprecision(2) << referenceJacobianSeconds / statistics.jacobianEvaluationTime << "x"
+            << std::setw(10) << std::setprecision(3) << statistics.time << " s total"
+            << std::setw(10) << std::setprecision(4) << statistics.RMSEfinal << " RMSE" << std::endl;
+}
+
+/**
+ * @brief Compare the bundle adjustment of a noisy synthetic scene with the autodiff
+ *        and the analytic jacobians of a camera model.
+ */
+void benchmark(camera::EINTRINSIC intrinsicType, const NViewDataSet& dataset, const NViewDatasetConfigurator& config, bool rig, int nbThreads)
+{
+  sfmData::SfMData sfmData = rig ? sfm::getInputRigScene(dataset, config, intrinsicType) :
+                                   sfm::getInputScene(dataset, config, intrinsicType);
+
+  // noise on the observations and the landmarks, the same for both adjustments
+  std::mt19937 randomNumberGenerator(42);
+  std::normal_distribution<double> observationNoise(0.0, 0.5);
+  std::normal_distribution<double> landmarkNoise(0.0, 0.01);
+
+  for(auto& landmarkIt : sfmData.getLandmarks())
+  {
+    sfmData::Landmark& landmark = landmarkIt.second;
+    for(int i = 0; i < 3; ++i)
+      landmark.X(i) += landmarkNoise(randomNumberGenerator);
+    for(auto& observationIt : landmark.observations)
+    {
+      observationIt.second.x(0) += observationNoise(randomNumberGenerator);
+      observationIt.second.x(1) += observationNoise(randomNumberGenerator);
+    }
+  }
+
+  std::cout << "\n" << camera::EINTRINSIC_enumToString(intrinsicType)
+            << " (" << sfmData.getViews().size() << " views, " << sfmData.getLandmarks().size() << " landmarks)" << std::endl;
+
+  sfm::BundleAdjustmentCeres::CeresOptions options(false, true);
+  options.setSparseBA();
+  options.nbThreads = nbThreads;
+
+  sfmData::SfMData autoDiffSfMData = sfmData;
+  sfm::BundleAdjustmentCeres autoDiffBA(options);
+  autoDiffBA.adjust(autoDiffSfMData);
+
+  const double referenceJacobianSeconds = autoDiffBA.getStatistics().jacobianEvaluationTime;
+  printResult("autodiff", autoDiffBA.getStatistics(), referenceJacobianSeconds);
+
+  options.useAnalyticJacobians = true;
+  sfm::BundleAdjustmentCeres analyticBA(options);
+  analyticBA.adjust(sfmData);
+
+  printResult("analytic", analyticBA.getStatistics(), referenceJacobianSeconds);
+}
+
+int main(int argc, char **argv)
+{
+  int nbViews = 100;
+  int nbPoints = 20000;
+  int nbThreads = 1;
+  bool rig = false;
+
+  po::options_description allParams("AliceVision Sample bundleAdjustmentBenchmark\n"
+                                    "Compare the bundle adjustment with autodiff and analytic jacobians on noisy synthetic scenes, for each camera model.");
+  allParams.add_options()
+    ("help,h", "Print this message.")
+    ("nbViews", po::value<int>(&nbViews)->default_value(nbViews),
+      "Number of views.")
+    ("nbPoints", po::value<int>(&nbPoints)->default_value(nbPoints),
+      "Number of landmarks.")
+    ("nbThreads", po::value<int>(&nbThreads)->default_value(nbThreads),
+      "Number of threads of the bundle adjustment.")
+    ("rig", po::value<bool>(&rig)->default_value(rig),
+      "Use a camera rig (the views are sub-poses of the rig).");
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help"))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  if(nbViews < 2 || nbPoints < 1 || nbThreads < 1)
+  {
+    ALICEVISION_CERR("ERROR: at least 2 views, 1 landmark and 1 thread are needed.");
+    return EXIT_FAILURE;
+  }
+
+  system::Logger::get()->setLogLevel(system::EVerboseLevel::Warning);
+
+  const NViewDatasetConfigurator config;
+  const NViewDataSet dataset = NRealisticCamerasRing(nbViews, nbPoints, config);
+
+  for(camera::EINTRINSIC intrinsicType : {camera::EINTRINSIC::PINHOLE_CAMERA,
+                                          camera::EINTRINSIC::PINHOLE_CAMERA_RADIAL1,
+                                          camera::EINTRINSIC::PINHOLE_CAMERA_RADIAL3,
+                                          camera::EINTRINSIC::PINHOLE_CAMERA_BROWN,
+                                          camera::EINTRINSIC::PINHOLE_CAMERA_FISHEYE,
+                                          camera::EINTRINSIC::PINHOLE_CAMERA_FISHEYE1})
+  {
+    benchmark(intrinsicType, dataset, config, rig, nbThreads);
+  }
+
+  return EXIT_SUCCESS;
+}
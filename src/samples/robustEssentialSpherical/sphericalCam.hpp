@@ -134,6 +134,13 @@ struct AngularError
     angleVal /= (x2.norm() * Em1.norm());
     return abs(asin(angleVal));
   }
+
+  void errors(const robustEstimation::Mat3Model& model, const Mat& x1, const Mat& x2, std::vector<double>& errors) const
+  {
+    errors.resize(x1.cols());
+    for(Mat::Index i = 0; i < x1.cols(); ++i)
+      errors[i] = error(model, x1.col(i), x2.col(i));
+  }
 };
 
 class EssentialKernel_spherical
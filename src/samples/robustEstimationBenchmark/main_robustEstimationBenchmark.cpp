@@ -0,0 +1,142 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/multiview/relativePose/FundamentalKernel.hpp>
+#include <aliceVision/multiview/relativePose/EssentialKernel.hpp>
+#include <aliceVision/multiview/relativePose/HomographyKernel.hpp>
+#include <aliceVision/multiview/resection/ResectionKernel.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// These constants define the current software version.
+// They must be updated when the command line is changed.
+#define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+
+using namespace aliceVision;
+using namespace aliceVision::multiview;
+
+namespace po = boost::program_options;
+
+void printResult(const std::string& name, std::size_t nbSamples, double seconds, double referenceSeconds)
+{
+  std::cout << std::left << std::setw(24) << name
+            << std::right << std::setw(10) << std::fixed << std::setprecision(1) << nbSamples / seconds * 1e-6 << " Msamples/s"
+            << std::setw(8) << std::setprecision(2) << referenceSeconds / seconds << "x" << std::endl;
+}
+
+/**
+ * @brief Compare the per-sample error() loop, as done by the estimators before
+ *        the batched interface, with the batched errors() of a kernel.
+ */
+template <typename KernelT>
+void benchmark(const std::string& name, const KernelT& kernel, const typename KernelT::ModelT& model, int nbRuns)
+{
+  const std::size_t nbSamples = kernel.nbSamples();
+  std::vector<double> errors(nbSamples);
+  double checksum = 0.0;
+
+  std::cout << "\n" << name << " (" << nbSamples << " samples)" << std::endl;
+
+  system::Timer timer;
+  for(int r = 0; r < nbRuns; ++r)
+  {
+    for(std::size_t i = 0; i < nbSamples; ++i)
+      errors[i] = kernel.error(i, model);
+    checksum += errors.back();
+  }
+  const double referenceSeconds = timer.elapsed() / nbRuns;
+  printResult("per-sample error", nbSamples, referenceSeconds, referenceSeconds);
+
+  timer.reset();
+  for(int r = 0; r < nbRuns; ++r)
+  {
+    kernel.errors(model, errors);
+    checksum -= errors.back();
+  }
+  printResult("batched errors", nbSamples, timer.elapsed() / nbRuns, referenceSeconds);
+
+  // keep the evaluations observable, the difference should be numerical noise
+  ALICEVISION_LOG_DEBUG("checksum: " << checksum);
+}
+
+int main(int argc, char **argv)
+{
+  int nbSamples = 100000;
+  int nbRuns = 20;
+
+  po::options_description allParams("AliceVision Sample robustEstimationBenchmark\n"
+                                    "Compare the per-sample and batched residual evaluation of the robust estimation kernels on random data.");
+  allParams.add_options()
+    ("help,h", "Print this message.")
+    ("nbSamples", po::value<int>(&nbSamples)->default_value(nbSamples),
+      "Number of correspondences.")
+    ("nbRuns", po::value<int>(&nbRuns)->default_value(nbRuns),
+      "Number of runs to average.");
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help"))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  if(nbSamples < 1 || nbRuns < 1)
+  {
+    ALICEVISION_CERR("ERROR: at least 1 sample and 1 run are needed.");
+    return EXIT_FAILURE;
+  }
+
+  std::mt19937 randomNumberGenerator(42);
+  std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+  auto randomMatrix = [&](int rows, int cols)
+  {
+    Mat m(rows, cols);
+    for(Mat::Index i = 0; i < m.size(); ++i)
+      m(i) = distribution(randomNumberGenerator);
+    return m;
+  };
+
+  const Mat x1 = randomMatrix(2, nbSamples) * 500.0;
+  const Mat x2 = randomMatrix(2, nbSamples) * 500.0;
+  Mat X = randomMatrix(3, nbSamples);
+  X.row(2).array() += 5.0;
+
+  const Mat3 M = randomMatrix(3, 3);
+  Mat3 K;
+  K << 800.0,   0.0, 0.0,
+         0.0, 800.0, 0.0,
+         0.0,   0.0, 1.0;
+  Mat34 P;
+  P << K, Vec3(0.1, -0.2, 0.3);
+
+  benchmark("Fundamental (Sampson)", relativePose::Fundamental8PKernel(x1, x2), robustEstimation::Mat3Model(M), nbRuns);
+  benchmark("Essential (Sampson)", relativePose::Essential8PKernel(x1, x2, K, K), robustEstimation::Mat3Model(M), nbRuns);
+  benchmark("Homography (asymmetric)", relativePose::Homography4PKernel(x1, x2), robustEstimation::Mat3Model(M), nbRuns);
+  benchmark("Resection (projection)", resection::Resection6PKernel(x1, X), robustEstimation::Mat34Model(P), nbRuns);
+
+  return EXIT_SUCCESS;
+}
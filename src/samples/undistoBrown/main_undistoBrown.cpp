@@ -122,6 +122,7 @@ int main(int argc, char **argv)
     << " with suffix " << suffix;
 
   boost::progress_display my_progress_bar( vec_fileNames.size() );
+  UndistortionMapCache undistortionMaps;
   for (size_t j = 0; j < vec_fileNames.size(); ++j, ++my_progress_bar)
   {
     const string inFileName = (fs::path(inputImagePath) / fs::path(vec_fileNames[j]).filename()).string();
@@ -132,7 +133,7 @@ int main(int argc, char **argv)
 
     const PinholeRadialK3 cam(image.Width(), image.Height(), f, c(0), c(1), k(0), k(1), k(2));
 
-    UndistortImage(image, &cam, imageUd, BLACK);
+    UndistortImage(image, *undistortionMaps.get(cam, image.Width(), image.Height()), imageUd, BLACK);
     writeImage(outFileName, imageUd, image::EImageColorSpace::NO_CONVERSION);
 
   } //end loop for each file
@@ -0,0 +1,148 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/feature/PointFeature.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/cmdline.hpp>
+#include <aliceVision/system/main.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp> 
+#include <boost/algorithm/string/case_conv.hpp> 
+
+#include <cstdlib>
+
+// These constants define the current software version.
+// They must be updated when the command line is changed.
+#define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+
+using namespace aliceVision;
+
+namespace po = boost::program_options;
+namespace fs = boost::filesystem;
+
+int aliceVision_main( int argc, char** argv )
+{
+  std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
+  std::string outputFolder;
+  std::string inputFolder;
+  std::string outputFormat = "binary";
+
+  po::options_description allParams("This program is used to convert features files (.feat) between the legacy ASCII format and the binary format\n"
+                                    "AliceVision convertFeaturesFormat");
+
+  po::options_description requiredParams("Required parameters");
+  requiredParams.add_options()
+    ("input,i", po::value<std::string>(&inputFolder)->required(),
+      "Input folder containing the features files.")
+    ("output,o", po::value<std::string>(&outputFolder)->required(),
+      "Output folder that stores the converted features files.");
+
+  po::options_description optionalParams("Optional parameters");
+  optionalParams.add_options()
+    ("outputFormat", po::value<std::string>(&outputFormat)->default_value(outputFormat),
+      "Output features file format (binary, ascii).");
+
+  po::options_description logParams("Log parameters");
+  logParams.add_options()
+    ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+      "verbosity level (fatal,  error, warning, info, debug, trace).");
+
+  allParams.add(requiredParams).add(optionalParams).add(logParams);
+
+  po::variables_map vm;
+
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help") || (argc == 1))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+
+    po::notify(vm);
+  }
+  catch(boost::program_options::required_option& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what() << std::endl);
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what() << std::endl);
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  ALICEVISION_COUT("Program called with the following parameters:");
+  ALICEVISION_COUT(vm);
+
+  // set verbose level
+  system::Logger::get()->setLogLevel(verboseLevel);
+
+  boost::to_lower(outputFormat);
+  if(outputFormat != "binary" && outputFormat != "ascii")
+  {
+    ALICEVISION_LOG_ERROR("Unknown output format '" << outputFormat << "'");
+    return EXIT_FAILURE;
+  }
+
+  if(!(fs::exists(inputFolder) && fs::is_directory(inputFolder)))
+  {
+    ALICEVISION_LOG_ERROR(inputFolder << " does not exists or it is not a folder");
+    return EXIT_FAILURE;
+  }
+
+  // if the folder does not exist create it (recursively)
+  if(!fs::exists(outputFolder))
+  {
+    fs::create_directories(outputFolder);
+  }
+
+  std::size_t countFeat = 0;
+
+  fs::directory_iterator iterator(inputFolder);
+  for(; iterator != fs::directory_iterator(); ++iterator)
+  {
+    std::string ext = iterator->path().extension().string();
+    boost::to_lower(ext);
+
+    if(ext != ".feat")
+      continue;
+
+    const std::string outpath = (fs::path(outputFolder) / iterator->path().filename()).string();
+
+    // features filenames are <viewId>.<describerType>.feat
+    const std::string describerType = fs::path(iterator->path().stem()).extension().string();
+
+    feature::PointFeatures features;
+    try
+    {
+      feature::loadFeatsFromFile(iterator->path().string(), features);
+
+      if(outputFormat == "binary")
+        feature::saveFeatsToBinFile(outpath, features, describerType.empty() ? "" : describerType.substr(1));
+      else
+        feature::saveFeatsToTextFile(outpath, features);
+    }
+    catch(const std::exception& e)
+    {
+      ALICEVISION_LOG_ERROR("Can't convert features file '" << iterator->path().string() << "': " << e.what());
+      return EXIT_FAILURE;
+    }
+
+    ALICEVISION_LOG_TRACE("Converted " << iterator->path().string() << " (" << features.size() << " features)");
+    ++countFeat;
+  }
+
+  ALICEVISION_LOG_INFO("Converted " << countFeat << " files .feat to the " << outputFormat << " format");
+
+  return EXIT_SUCCESS;
+}
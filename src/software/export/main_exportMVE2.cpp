@@ -107,6 +107,7 @@ bool exportToMVE2Format(
     boost::progress_display my_progress_bar(sfm_data.getViews().size());
     std::pair<int,int> w_h_image_size;
     Image<RGBColor> image, image_ud, thumbnail;
+    UndistortionMapCache undistortionMaps;
     std::string sOutViewIteratorDirectory;
     std::size_t view_index = 0;
     std::map<std::size_t, IndexT> viewIdToviewIndex;
@@ -140,7 +141,7 @@ bool exportToMVE2Format(
       {
         // Undistort and save the image
         readImage(srcImage, image, image::EImageColorSpace::NO_CONVERSION);
-        UndistortImage(image, cam, image_ud, BLACK);
+        UndistortImage(image, *undistortionMaps.get(*cam, image.Width(), image.Height()), image_ud, BLACK);
         writeImage(dstImage, image_ud, image::EImageColorSpace::NO_CONVERSION);
       }
       else // (no distortion)
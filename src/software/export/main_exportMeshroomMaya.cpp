@@ -104,6 +104,7 @@ int aliceVision_main(int argc, char **argv)
 
   // export undistorted images and thumbnail images
   boost::progress_display progressBar(sfmData.getViews().size(), std::cout, "Exporting Images for MeshroomMaya\n");
+  camera::UndistortionMapCache undistortionMaps;
   for(auto& viewPair : sfmData.getViews())
   {
     const sfmData::View& view = *viewPair.second;
@@ -120,7 +121,7 @@ int aliceVision_main(int argc, char **argv)
 
     // compute undistorted image
     if(intrinsicPtr->isValid() && intrinsicPtr->hasDistortion())
-      camera::UndistortImage(image, intrinsicPtr.get(), imageUd, image::BLACK, true);
+      camera::UndistortImage(image, *undistortionMaps.get(*intrinsicPtr, image.Width(), image.Height(), true), imageUd, image::BLACK);
     else
       imageUd = image;
 
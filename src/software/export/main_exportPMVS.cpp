@@ -106,6 +106,7 @@ bool exportToPMVSFormat(
 
     // Export (calibrated) views as undistorted images
     Image<RGBColor> image, image_ud;
+    UndistortionMapCache undistortionMaps;
     for(Views::const_iterator iter = sfm_data.getViews().begin();
       iter != sfm_data.getViews().end(); ++iter, ++my_progress_bar)
     {
@@ -125,7 +126,7 @@ bool exportToPMVSFormat(
       {
         // undistort the image and save it
         readImage( srcImage, image, image::EImageColorSpace::NO_CONVERSION);
-        UndistortImage(image, cam, image_ud, BLACK);
+        UndistortImage(image, *undistortionMaps.get(*cam, image.Width(), image.Height()), image_ud, BLACK);
         writeImage(dstImage, image_ud, image::EImageColorSpace::NO_CONVERSION);
       }
       else // (no distortion)
@@ -42,7 +42,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 2
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 using namespace aliceVision::camera;
@@ -106,6 +106,7 @@ int aliceVision_main(int argc, char **argv)
   int rangeSize = 0;
   std::string nearestMatchingMethod = "ANN_L2";
   robustEstimation::ERobustEstimator geometricEstimator = robustEstimation::ERobustEstimator::ACRANSAC;
+  robustEstimation::EACRansacMode acRansacMode = robustEstimation::EACRansacMode::EXACT;
   double geometricErrorMax = 0.0; //< the maximum reprojection error allowed for image matching with geometric validation
   double knownPosesGeometricErrorMax = 4.0;
   bool savePutativeMatches = false;
@@ -116,7 +117,8 @@ int aliceVision_main(int argc, char **argv)
   bool useGridSort = true;
   bool exportDebugFiles = false;
   bool matchFromKnownCameraPoses = false;
-  const std::string fileExtension = "txt";
+  bool memoryMappedDescriptors = false;
+  std::string fileExtension = "bin";
 
   po::options_description allParams(
      "Compute corresponding features between a series of views:\n"
@@ -156,6 +158,11 @@ int aliceVision_main(int argc, char **argv)
       "Geometric estimator:\n"
       "* acransac: A-Contrario Ransac\n"
       "* loransac: LO-Ransac (only available for fundamental matrix). Need to set '--geometricError'")
+    ("acRansacMode", po::value<robustEstimation::EACRansacMode>(&acRansacMode)->default_value(acRansacMode),
+      "A-Contrario Ransac NFA evaluation mode:\n"
+      "* exact: the NFA is evaluated for each number of inliers on the sorted residuals\n"
+      "* fast: the NFA is evaluated on a logarithmic histogram of the residuals and the iterations stop "
+      "when a better model is unlikely to be found")
     ("geometricError", po::value<double>(&geometricErrorMax)->default_value(geometricErrorMax), 
       "Maximum error (in pixels) allowed for features matching during geometric verification. "
       "If set to 0 it lets the ACRansac select an optimal value.")
@@ -171,6 +178,10 @@ int aliceVision_main(int argc, char **argv)
       "Use the found model to improve the pairwise correspondences.")
     ("matchFilePerImage", po::value<bool>(&matchFilePerImage)->default_value(matchFilePerImage),
       "Save matches in a separate file per image.")
+    ("matchesFileExtension", po::value<std::string>(&fileExtension)->default_value(fileExtension),
+      "Matches file format:\n"
+      "* bin: indexed binary file (fast loading, random access by pair)\n"
+      "* txt: text file")
     ("distanceRatio", po::value<float>(&distRatio)->default_value(distRatio),
       "Distance ratio to discard non meaningful matches.")
     ("maxIteration", po::value<int>(&maxIteration)->default_value(maxIteration),
@@ -181,6 +192,9 @@ int aliceVision_main(int argc, char **argv)
       "Export debug files (svg, dot).")
     ("maxMatches", po::value<std::size_t>(&numMatchesToKeep)->default_value(numMatchesToKeep),
       "Maximum number pf matches to keep.")
+    ("memoryMappedDescriptors", po::value<bool>(&memoryMappedDescriptors)->default_value(memoryMappedDescriptors),
+      "Map the descriptors files instead of loading them in memory. "
+      "Descriptors are paged in on demand by the OS, which bounds the resident memory on large datasets.")
     ("rangeStart", po::value<int>(&rangeStart)->default_value(rangeStart),
       "Range image index start.")
     ("rangeSize", po::value<int>(&rangeSize)->default_value(rangeSize),
@@ -310,7 +324,7 @@ int aliceVision_main(int argc, char **argv)
 
   // load the corresponding view regions
   RegionsPerView regionPerView;
-  if(!sfm::loadRegionsPerView(regionPerView, sfmData, featuresFolders, describerTypes, filter))
+  if(!sfm::loadRegionsPerView(regionPerView, sfmData, featuresFolders, describerTypes, filter, memoryMappedDescriptors))
   {
     ALICEVISION_LOG_ERROR("Invalid regions in '" + sfmDataFilename + "'");
     return EXIT_FAILURE;
@@ -460,7 +474,7 @@ int aliceVision_main(int argc, char **argv)
       matchingImageCollection::robustModelEstimation(geometricMatches,
         &sfmData,
         regionPerView,
-        GeometricFilterMatrix_F_AC(geometricErrorMax, maxIteration, geometricEstimator),
+        GeometricFilterMatrix_F_AC(geometricErrorMax, maxIteration, geometricEstimator, false, acRansacMode),
         mapPutativesMatches,
         guidedMatching);
     }
@@ -471,7 +485,7 @@ int aliceVision_main(int argc, char **argv)
     matchingImageCollection::robustModelEstimation(geometricMatches,
       &sfmData,
       regionPerView,
-      GeometricFilterMatrix_F_AC(geometricErrorMax, maxIteration, geometricEstimator, true),
+      GeometricFilterMatrix_F_AC(geometricErrorMax, maxIteration, geometricEstimator, true, acRansacMode),
       mapPutativesMatches,
       guidedMatching);
   }
@@ -482,7 +496,7 @@ int aliceVision_main(int argc, char **argv)
       matchingImageCollection::robustModelEstimation(geometricMatches,
         &sfmData,
         regionPerView,
-        GeometricFilterMatrix_E_AC(geometricErrorMax, maxIteration),
+        GeometricFilterMatrix_E_AC(geometricErrorMax, maxIteration, acRansacMode),
         mapPutativesMatches,
         guidedMatching);
 
@@ -511,7 +525,7 @@ int aliceVision_main(int argc, char **argv)
       matchingImageCollection::robustModelEstimation(geometricMatches,
         &sfmData,
         regionPerView,
-        GeometricFilterMatrix_H_AC(geometricErrorMax, maxIteration),
+        GeometricFilterMatrix_H_AC(geometricErrorMax, maxIteration, acRansacMode),
         mapPutativesMatches, guidedMatching,
         onlyGuidedMatching ? -1.0 : 0.6);
     }
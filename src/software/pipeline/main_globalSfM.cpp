@@ -76,7 +76,8 @@ int aliceVision_main(int argc, char **argv)
       feature::EImageDescriberType_informations().c_str())
     ("rotationAveraging", po::value<sfm::ERotationAveragingMethod>(&rotationAveragingMethod)->default_value(rotationAveragingMethod),
       "* 1: L1 minimization\n"
-      "* 2: L2 minimization")
+      "* 2: L2 minimization\n"
+      "* 3: IRLS minimization on sparse view graphs")
     ("translationAveraging", po::value<sfm::ETranslationAveragingMethod>(&translationAveragingMethod)->default_value(translationAveragingMethod),
       "* 1: L1 minimization\n"
       "* 2: L2 minimization of sum of squared Chordal distances\n"
@@ -123,7 +124,7 @@ int aliceVision_main(int argc, char **argv)
   system::Logger::get()->setLogLevel(verboseLevel);
 
   if (rotationAveragingMethod < sfm::ROTATION_AVERAGING_L1 ||
-      rotationAveragingMethod > sfm::ROTATION_AVERAGING_L2 )
+      rotationAveragingMethod > sfm::ROTATION_AVERAGING_IRLS )
   {
     ALICEVISION_LOG_ERROR("Rotation averaging method is invalid");
     return EXIT_FAILURE;
@@ -153,12 +153,22 @@ int aliceVision_main(int argc, char **argv)
       "It reduces the reconstruction time, especially for big datasets (500+ images).")
     ("localBAGraphDistance", po::value<int>(&sfmParams.localBundelAdjustementGraphDistanceLimit)->default_value(sfmParams.localBundelAdjustementGraphDistanceLimit),
       "Graph-distance limit setting the Active region in the Local Bundle Adjustment strategy.")
+    ("usePersistentBA", po::value<bool>(&sfmParams.usePersistentBundleAdjustment)->default_value(sfmParams.usePersistentBundleAdjustment),
+      "Enable/Disable the persistent bundle adjustment problem.\n"
+      "The problem is kept between the iterations and only updated with the new or removed observations,\n"
+      "instead of being created again. It reduces the reconstruction time of long sequences.")
     ("localizerEstimator", po::value<robustEstimation::ERobustEstimator>(&sfmParams.localizerEstimator)->default_value(sfmParams.localizerEstimator),
       "Estimator type used to localize cameras (acransac (default), ransac, lsmeds, loransac, maxconsensus)")
     ("localizerEstimatorError", po::value<double>(&sfmParams.localizerEstimatorError)->default_value(0.0),
       "Reprojection error threshold (in pixels) for the localizer estimator (0 for default value according to the estimator).")
     ("localizerEstimatorMaxIterations", po::value<std::size_t>(&sfmParams.localizerEstimatorMaxIterations)->default_value(sfmParams.localizerEstimatorMaxIterations),
       "Max number of RANSAC iterations.")
+    ("maxImagesPerGroup", po::value<std::size_t>(&sfmParams.maxImagesPerGroup)->default_value(sfmParams.maxImagesPerGroup),
+      "Maximum number of images localized in one resection group before the bundle adjustment.")
+    ("pipelinedResection", po::value<bool>(&sfmParams.pipelinedResection)->default_value(sfmParams.pipelinedResection),
+      "Enable/Disable the pipelined resection: a group of images is localized while the previous group is triangulated.\n"
+      "It reduces the reconstruction time on long sequences, the new images are localized without the last triangulated points.\n"
+      "Only used with the multiview triangulation (minNumberOfObservationsForTriangulation > 0).")
     ("useOnlyMatchesFromInputFolder", po::value<bool>(&useOnlyMatchesFromInputFolder)->default_value(useOnlyMatchesFromInputFolder),
       "Use only matches from the input matchesFolder parameter.\n"
       "Matches folders previously added to the SfMData file will be ignored.")
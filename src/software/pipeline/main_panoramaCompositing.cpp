@@ -11,6 +11,8 @@
 // Image stuff
 #include <aliceVision/image/all.hpp>
 #include <aliceVision/mvsData/imageAlgo.hpp>
+#include <aliceVision/panorama/TiledPanorama.hpp>
+#include <aliceVision/panorama/LaplacianPyramid.hpp>
 
 // Logging stuff
 #include <aliceVision/system/Logger.hpp>
@@ -23,6 +25,8 @@
 // IO
 #include <fstream>
 #include <algorithm>
+#include <memory>
+#include <boost/algorithm/string/case_conv.hpp>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/filesystem.hpp>
@@ -30,12 +34,16 @@
 #include <boost/graph/adjacency_list.hpp>
 #include <boost/graph/boykov_kolmogorov_max_flow.hpp>
 
+#include <OpenImageIO/imageio.h>
+#include <OpenEXR/half.h>
+
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
+using namespace aliceVision::panorama;
 
 namespace po = boost::program_options;
 namespace bpt = boost::property_tree;
@@ -337,112 +345,89 @@ bool computeDistanceMap(image::Image<int> & distance, const image::Image<unsigne
   return true;
 }
 
-bool feathering(aliceVision::image::Image<image::RGBfColor> & output, const aliceVision::image::Image<image::RGBfColor> & color, const aliceVision::image::Image<unsigned char> & inputMask) {
-
-  std::vector<image::Image<image::RGBfColor>> feathering;
-  std::vector<image::Image<unsigned char>> feathering_mask;
-  feathering.push_back(color);
-  feathering_mask.push_back(inputMask);
-
-  int lvl = 0;
-  int width = color.Width();
-  int height = color.Height();
-  
-  while (1) {
-    const image::Image<image::RGBfColor> & src = feathering[lvl];
-    const image::Image<unsigned char> & src_mask = feathering_mask[lvl];
-  
-    image::Image<image::RGBfColor> half(width / 2, height / 2);
-    image::Image<unsigned char> half_mask(width / 2, height / 2);
+bool containsHalfFloatOverflow(const image::RGBAfColor & pix) {
+  return pix.maxCoeff() > HALF_MAX || pix.minCoeff() < -HALF_MAX;
+}
 
-    for (int i = 0; i < half.Height(); i++) {
+/**
+ * @brief Write a tiled panorama. EXR files are streamed tile by tile as a tiled EXR,
+ * other formats are assembled in memory and written with image::writeImage.
+ */
+void writePanorama(TiledPanorama & panorama, const std::string & path, const oiio::ParamValueList & metadata, image::EStorageDataType storageDataType) {
 
-      int di = i * 2;
-      for (int j = 0; j < half.Width(); j++) {
-        int dj = j * 2;
+  const fs::path bPath = fs::path(path);
+  const std::string extension = boost::to_lower_copy(bPath.extension().string());
 
-        int count = 0;
-        half(i, j) = image::RGBfColor(0.0,0.0,0.0);
-        
-        if (src_mask(di, dj)) {
-          half(i, j) += src(di, dj);
-          count++;
-        }
+  if (extension != ".exr") {
 
-        if (src_mask(di, dj + 1)) {
-          half(i, j) += src(di, dj + 1);
-          count++;
-        }
+    image::Image<image::RGBAfColor> panoramaImage(panorama.Width(), panorama.Height());
+    panorama.forEachPixel(0, 0, panorama.Width(), panorama.Height(), [&](const image::RGBAfColor & pix, size_t i, size_t j) {
+      panoramaImage(i, j) = pix;
+    });
+    image::writeImage(path, panoramaImage, image::EImageColorSpace::AUTO, metadata);
+    return;
+  }
 
-        if (src_mask(di + 1, dj)) {
-          half(i, j) += src(di + 1, dj);
-          count++;
-        }
+  if (storageDataType == image::EStorageDataType::Auto) {
 
-        if (src_mask(di + 1, dj + 1)) {
-          half(i, j) += src(di + 1, dj + 1);
-          count++;
-        }
-
-        if (count > 0) {
-          half(i, j) /= float(count);
-          half_mask(i, j) = 1;
-        } 
-        else {
-          half_mask(i, j) = 0;
+    bool overflow = containsHalfFloatOverflow(panorama.getFillValue());
+    panorama.forEachAllocatedTile([&](const TiledPanorama::Tile & tile) {
+      for (size_t i = 0; i < tile.Height() && !overflow; i++) {
+        for (size_t j = 0; j < tile.Width() && !overflow; j++) {
+          overflow = containsHalfFloatOverflow(tile(i, j));
         }
       }
+    });
+    storageDataType = overflow ? image::EStorageDataType::Float : image::EStorageDataType::Half;
+  }
 
-      
-    }
-
-    feathering.push_back(half);
-    feathering_mask.push_back(half_mask);
-
-    
-    width = half.Width();
-    height = half.Height();
+  const bool isHalf = (storageDataType == image::EStorageDataType::Half || storageDataType == image::EStorageDataType::HalfFinite);
+  const std::string tmpPath = (bPath.parent_path() / bPath.stem()).string() + "." + fs::unique_path().string() + extension;
 
-    if (width < 2 || height < 2) break;
+  oiio::ImageSpec spec(panorama.Width(), panorama.Height(), 4, isHalf ? oiio::TypeDesc::HALF : oiio::TypeDesc::FLOAT);
+  spec.extra_attribs = metadata;
+  spec.attribute("compression", "piz");
+  spec.tile_width = panorama.getTileSize();
+  spec.tile_height = panorama.getTileSize();
 
-    lvl++;  
+  std::unique_ptr<oiio::ImageOutput> out(oiio::ImageOutput::create(tmpPath));
+  if (out.get() == nullptr || !out->supports("tiles") || !out->open(tmpPath, spec)) {
+    throw std::runtime_error("Can't write output image file '" + path + "'.");
   }
 
+  TiledPanorama::Tile fillTile(panorama.getTileSize(), panorama.getTileSize(), true, panorama.getFillValue());
+  TiledPanorama::Tile clampedTile;
 
-  for (int lvl = feathering.size() - 2; lvl >= 0; lvl--) {
-    
-    image::Image<image::RGBfColor> & src = feathering[lvl];
-    image::Image<unsigned char> & src_mask = feathering_mask[lvl];
-    image::Image<image::RGBfColor> & ref = feathering[lvl + 1];
-    image::Image<unsigned char> & ref_mask = feathering_mask[lvl + 1];
-
-    for (int i = 0; i < src_mask.Height(); i++) {
-      for (int j = 0; j < src_mask.Width(); j++) {
-        if (!src_mask(i, j)) {
-          int mi = i / 2;
-          int mj = j / 2;
-
-          if (mi >= ref_mask.Height()) {
-            mi = ref_mask.Height() - 1;
-          }
+  for (size_t tile_y = 0; tile_y < panorama.getTilesY(); tile_y++) {
+    for (size_t tile_x = 0; tile_x < panorama.getTilesX(); tile_x++) {
 
-          if (mj >= ref_mask.Width()) {
-            mj = ref_mask.Width() - 1;
-          }
+      const TiledPanorama::Tile * tile = panorama.isAllocated(tile_x, tile_y) ? &panorama.getTile(tile_x, tile_y) : &fillTile;
 
-          src_mask(i, j) = ref_mask(mi, mj);
-          src(i, j) = ref(mi, mj);
+      if (storageDataType == image::EStorageDataType::HalfFinite) {
+        clampedTile = *tile;
+        for (size_t i = 0; i < clampedTile.Height(); i++) {
+          for (size_t j = 0; j < clampedTile.Width(); j++) {
+            for (int c = 0; c < 4; c++) {
+              clampedTile(i, j)(c) = std::max(-HALF_MAX, std::min(HALF_MAX, clampedTile(i, j)(c)));
+            }
+          }
         }
+        tile = &clampedTile;
+      }
+
+      if (!out->write_tile(tile_x * panorama.getTileSize(), tile_y * panorama.getTileSize(), 0, oiio::TypeDesc::FLOAT, tile->data())) {
+        throw std::runtime_error("Can't write output image file '" + path + "'.");
       }
     }
   }
 
-  output = feathering[0];
+  out->close();
 
-  return true;
+  // rename temporay filename
+  fs::rename(tmpPath, path);
 }
 
-void drawBorders(aliceVision::image::Image<image::RGBAfColor> & inout, aliceVision::image::Image<unsigned char> & mask, size_t offset_x, size_t offset_y) {
+void drawBorders(TiledPanorama & inout, aliceVision::image::Image<unsigned char> & mask, size_t offset_x, size_t offset_y) {
 
   
   for (int i = 0; i < mask.Height(); i++) {
@@ -524,7 +509,7 @@ void drawBorders(aliceVision::image::Image<image::RGBAfColor> & inout, aliceVisi
   }
 }
 
-void drawSeams(aliceVision::image::Image<image::RGBAfColor> & inout, aliceVision::image::Image<IndexT> & labels) {
+void drawSeams(TiledPanorama & inout, aliceVision::image::Image<IndexT> & labels) {
 
   for (int i = 1; i < labels.Height() - 1; i++) {
 
@@ -630,37 +615,26 @@ bool makeImagePyramidCompatible(image::Image<T> & output, size_t & out_offset_x,
 
 class Compositer {
 public:
-  Compositer(size_t outputWidth, size_t outputHeight) :
-  _panorama(outputWidth, outputHeight, true, image::RGBAfColor(0.0f, 0.0f, 0.0f, 0.0f))
+  Compositer(size_t outputWidth, size_t outputHeight, size_t tileSize, size_t maxResidentTiles, const std::string & scratchPath) :
+  _panorama(outputWidth, outputHeight, tileSize, maxResidentTiles, scratchPath)
   {
   }
 
+  virtual ~Compositer() = default;
+
   virtual bool append(const aliceVision::image::Image<image::RGBfColor> & color, const aliceVision::image::Image<unsigned char> & inputMask, const aliceVision::image::Image<float> & inputWeights, size_t offset_x, size_t offset_y) {
 
-    for (size_t i = 0; i < color.Height(); i++) {
+    _panorama.forEachPixel(offset_x, offset_y, color.Width(), color.Height(), [&](image::RGBAfColor & pix, size_t i, size_t j) {
 
-      size_t pano_i = offset_y + i;
-      if (pano_i >= _panorama.Height()) {
-        continue;
+      if (!inputMask(i, j)) {
+        return;
       }
 
-      for (size_t j = 0; j < color.Width(); j++) {
-
-        if (!inputMask(i, j)) {
-          continue;
-        }
-
-        size_t pano_j = offset_x + j;
-        if (pano_j >= _panorama.Width()) {
-          pano_j = pano_j - _panorama.Width();
-        }
-
-        _panorama(pano_i, pano_j).r() = color(i, j).r();
-        _panorama(pano_i, pano_j).g() = color(i, j).g();
-        _panorama(pano_i, pano_j).b() = color(i, j).b();
-        _panorama(pano_i, pano_j).a() = 1.0f;
-      }
-    }
+      pix.r() = color(i, j).r();
+      pix.g() = color(i, j).g();
+      pix.b() = color(i, j).b();
+      pix.a() = 1.0f;
+    });
 
     return true;
   }
@@ -669,622 +643,69 @@ public:
     return true;
   }
 
-  aliceVision::image::Image<image::RGBAfColor> & getPanorama() {
+  TiledPanorama & getPanorama() {
     return _panorama;
   }
 
 protected:
-  aliceVision::image::Image<image::RGBAfColor> _panorama;
+  TiledPanorama _panorama;
 };
 
 class AlphaCompositer : public Compositer {
 public:
 
-  AlphaCompositer(size_t outputWidth, size_t outputHeight) :
-  Compositer(outputWidth, outputHeight) {
+  AlphaCompositer(size_t outputWidth, size_t outputHeight, size_t tileSize, size_t maxResidentTiles, const std::string & scratchPath) :
+  Compositer(outputWidth, outputHeight, tileSize, maxResidentTiles, scratchPath) {
 
   }
 
   virtual bool append(const aliceVision::image::Image<image::RGBfColor> & color, const aliceVision::image::Image<unsigned char> & inputMask, const aliceVision::image::Image<float> & inputWeights, size_t offset_x, size_t offset_y) {
 
-    for (size_t i = 0; i < color.Height(); i++) {
+    _panorama.forEachPixel(offset_x, offset_y, color.Width(), color.Height(), [&](image::RGBAfColor & pix, size_t i, size_t j) {
 
-      size_t pano_i = offset_y + i;
-      if (pano_i >= _panorama.Height()) {
-        continue;
+      if (!inputMask(i, j)) {
+        return;
       }
 
-      for (size_t j = 0; j < color.Width(); j++) {
-
-        if (!inputMask(i, j)) {
-          continue;
-        }
+      float wc = inputWeights(i, j);
 
-        size_t pano_j = offset_x + j;
-        if (pano_j >= _panorama.Width()) {
-          pano_j = pano_j - _panorama.Width();
-        }
-
-        float wc = inputWeights(i, j);
-          
-        _panorama(pano_i, pano_j).r() += wc * color(i, j).r();
-        _panorama(pano_i, pano_j).g() += wc * color(i, j).g();
-        _panorama(pano_i, pano_j).b() += wc * color(i, j).b();
-        _panorama(pano_i, pano_j).a() += wc;
-      }
-    }
+      pix.r() += wc * color(i, j).r();
+      pix.g() += wc * color(i, j).g();
+      pix.b() += wc * color(i, j).b();
+      pix.a() += wc;
+    });
 
     return true;
   }
 
   virtual bool terminate() {
 
-    for (int i = 0; i  < _panorama.Height(); i++) {
-      for (int j = 0; j < _panorama.Width(); j++) {
-        
-        if (_panorama(i, j).a() < 1e-6) {
-          _panorama(i, j).r() = 1.0f;
-          _panorama(i, j).g() = 0.0f;
-          _panorama(i, j).b() = 0.0f;
-          _panorama(i, j).a() = 0.0f;
-        }
-        else {
-          _panorama(i, j).r() = _panorama(i, j).r() / _panorama(i, j).a();
-          _panorama(i, j).g() = _panorama(i, j).g() / _panorama(i, j).a();
-          _panorama(i, j).b() = _panorama(i, j).b() / _panorama(i, j).a();
-          _panorama(i, j).a() = 1.0f;
-        }
-      }
-    }
-
-    return true;
-  }
-};
-
-template<class T>
-inline void convolveRow(typename image::Image<T>::RowXpr output_row, typename image::Image<T>::ConstRowXpr input_row, const Eigen::Matrix<float, 5, 1> & kernel, bool loop) {
-
-  const int radius = 2;
-
-  for (int j = 0; j < input_row.cols(); j++) {
-
-    T sum = T();
-    float sumw = 0.0f;
-
-    for (int k = 0; k < kernel.size(); k++) {
-
-      float w = kernel(k);
-      int col = j + k - radius;
-
-      /* mirror 5432 | 123456 | 5432 */
-
-      if (!loop) {
-        if (col < 0) {
-          col = - col;
-        }
-
-        if (col >= input_row.cols()) {
-          col = input_row.cols() - 1 - (col + 1 - input_row.cols());
-        }
-      }
-      else {
-        if (col < 0) {
-          col = input_row.cols() + col;
-        }
-
-        if (col >= input_row.cols()) {
-          col = col - input_row.cols();
-        }
-      }
-
-      sum += w * input_row(col);
-      sumw += w;
-    }
-
-    output_row(j) = sum / sumw;
-  }
-}
-
-template<class T>
-inline void convolveColumns(typename image::Image<T>::RowXpr output_row, const image::Image<T> & input_rows, const Eigen::Matrix<float, 5, 1> & kernel) {
-  
-  for (int j = 0; j < output_row.cols(); j++) {
-
-    T sum = T();
-    float sumw = 0.0f;
-
-    for (int k = 0; k < kernel.size(); k++) {
-
-      float w = kernel(k);
-      sum += w * input_rows(k, j);
-      sumw += w;
-    }
-
-    output_row(j) = sum / sumw;
-  }
-}
-
-template<class T>
-bool convolveGaussian5x5(image::Image<T> & output, const image::Image<T> & input, bool loop = false) {
-
-  if (output.size() != input.size()) {
-    return false;
-  }
-
-  Eigen::Matrix<float, 5, 1> kernel;
-  kernel[0] = 1.0f;
-  kernel[1] = 4.0f;
-  kernel[2] = 6.0f;
-  kernel[3] = 4.0f;
-  kernel[4] = 1.0f;
-  kernel = kernel / kernel.sum();
-
-  image::Image<T> buf(output.Width(), 5);
-
-  int radius = 2;
-
-  convolveRow<T>(buf.row(0), input.row(2), kernel, loop);
-  convolveRow<T>(buf.row(1), input.row(1), kernel, loop);
-  convolveRow<T>(buf.row(2), input.row(0), kernel, loop);
-  convolveRow<T>(buf.row(3), input.row(1), kernel, loop);
-  convolveRow<T>(buf.row(4), input.row(2), kernel, loop);
-
-  for (int i = 0; i < output.Height() - 3; i++) {
-
-    convolveColumns<T>(output.row(i), buf, kernel);
-
-
-    buf.row(0) = buf.row(1);
-    buf.row(1) = buf.row(2);
-    buf.row(2) = buf.row(3);
-    buf.row(3) = buf.row(4);
-    convolveRow<T>(buf.row(4), input.row(i + 3), kernel, loop);
-  }
-
-  /**
-  current row : -5 -4 -3 -2 -1
-  next 1 : -4 -3 -2 -1 -2
-  next 2 : -3 -2 -1 -2 -3
-  */
-  convolveColumns<T>(output.row(output.Height() - 3), buf, kernel);
-
-  buf.row(0) = buf.row(1);
-  buf.row(1) = buf.row(2);
-  buf.row(2) = buf.row(3);
-  buf.row(3) = buf.row(4);
-  convolveRow<T>(buf.row(4), input.row(output.Height() - 2), kernel, loop);
-  convolveColumns<T>(output.row(output.Height() - 2), buf, kernel);
-
-  buf.row(0) = buf.row(1);
-  buf.row(1) = buf.row(2);
-  buf.row(2) = buf.row(3);
-  buf.row(3) = buf.row(4);
-  convolveRow<T>(buf.row(4), input.row(output.Height() - 3), kernel, loop);
-  convolveColumns<T>(output.row(output.Height() - 1), buf, kernel);
-
-  return true;
-}
-
-
-template <class T>
-bool downscale(aliceVision::image::Image<T> & outputColor, const aliceVision::image::Image<T> & inputColor) {
-
-  size_t output_width = inputColor.Width() / 2;
-  size_t output_height = inputColor.Height() / 2;
-
-  for (int i = 0; i < output_height; i++) {
-    for (int j = 0; j < output_width; j++) {
-      outputColor(i, j) = inputColor(i * 2, j * 2);
-    }
-  }
-
-  return true;
-}
-
-template <class T>
-bool upscale(aliceVision::image::Image<T> & outputColor, const aliceVision::image::Image<T> & inputColor) {
-
-  size_t width = inputColor.Width();
-  size_t height = inputColor.Height();
-
-  for (int i = 0; i < height; i++) {
-
-    int di = i * 2;
-
-    for (int j = 0; j < width; j++) {
-      int dj = j * 2;
-
-      outputColor(di, dj) = T();
-      outputColor(di, dj + 1) = T();
-      outputColor(di + 1, dj) = T();
-      outputColor(di + 1, dj + 1) = inputColor(i, j);
-    }
-  }
-
-  return true;
-}
-
-template <class T>
-bool substract(aliceVision::image::Image<T> & AminusB, const aliceVision::image::Image<T> & A, const aliceVision::image::Image<T> & B) {
+    _panorama.forEachAllocatedTile([](TiledPanorama::Tile & tile) {
 
-  size_t width = AminusB.Width();
-  size_t height = AminusB.Height();
+      for (int i = 0; i  < tile.Height(); i++) {
+        for (int j = 0; j < tile.Width(); j++) {
 
-  if (AminusB.size() != A.size()) {
-    return false;
-  }
-
-  if (AminusB.size() != B.size()) {
-    return false;
-  }
-
-  for (int i = 0; i < height; i++) {
-
-    for (int j = 0; j < width; j++) {
-
-      AminusB(i, j) = A(i, j) - B(i, j);
-    }
-  }
-
-  return true;
-}
-
-template <class T>
-bool addition(aliceVision::image::Image<T> & AplusB, const aliceVision::image::Image<T> & A, const aliceVision::image::Image<T> & B) {
-
-  size_t width = AplusB.Width();
-  size_t height = AplusB.Height();
-
-  if (AplusB.size() != A.size()) {
-    return false;
-  }
-
-  if (AplusB.size() != B.size()) {
-    return false;
-  }
-
-  for (int i = 0; i < height; i++) {
-
-    for (int j = 0; j < width; j++) {
-
-      AplusB(i, j) = A(i, j) + B(i, j);
-    }
-  }
-
-  return true;
-}
-
-void removeNegativeValues(aliceVision::image::Image<image::RGBfColor> & img) {
-  for (int i = 0; i < img.Height(); i++) {
-    for (int j = 0; j < img.Width(); j++) {
-      image::RGBfColor & pix = img(i, j);
-      image::RGBfColor rpix;
-      rpix.r() = std::exp(pix.r());
-      rpix.g() = std::exp(pix.g());
-      rpix.b() = std::exp(pix.b());
-
-      if (rpix.r() < 0.0) {
-        pix.r() = 0.0;
-      }
-
-      if (rpix.g() < 0.0) {
-        pix.g() = 0.0;
-      }
-
-      if (rpix.b() < 0.0) {
-        pix.b() = 0.0;
-      }
-    }
-  }
-}
-
-class LaplacianPyramid {
-public:
-  LaplacianPyramid(size_t base_width, size_t base_height, size_t max_levels) {
-
-    size_t width = base_width;
-    size_t height = base_height;
-
-    /*Make sure pyramid size can be divided by 2 on each levels*/
-    double max_scale = 1.0 / pow(2.0, max_levels - 1);
-    //width = size_t(ceil(double(width) * max_scale) / max_scale);
-    //height = size_t(ceil(double(height) * max_scale) / max_scale);
-
-    /*Prepare pyramid*/
-    for (int lvl = 0; lvl < max_levels; lvl++) {
-
-      _levels.push_back(aliceVision::image::Image<image::RGBfColor>(width, height, true, image::RGBfColor(0.0f,0.0f,0.0f)));
-      _weights.push_back(aliceVision::image::Image<float>(width, height, true, 0.0f));
-      
-      height /= 2;
-      width /= 2;
-    }
-  }
-
-  bool augment(size_t new_max_levels) {
-
-    if (new_max_levels <= _levels.size()) {
-      return false;
-    }
-
-    size_t old_max_level = _levels.size();
-
-    image::Image<image::RGBfColor> current_color = _levels[_levels.size() - 1];
-    image::Image<float> current_weights = _weights[_weights.size() - 1];
-
-    _levels[_levels.size() - 1].fill(image::RGBfColor(0.0f, 0.0f, 0.0f));
-    _weights[_weights.size() - 1].fill(0.0f);
-
-    image::Image<unsigned char> current_mask(current_color.Width(), current_color.Height(), true, 0);
-    image::Image<image::RGBfColor> current_color_feathered(current_color.Width(), current_color.Height());
-
-    for (int i = 0; i < current_color.Height(); i++) {
-      for (int j = 0; j < current_color.Width(); j++) {
-        if (current_weights(i, j) < 1e-6) {
-          current_color(i, j) = image::RGBfColor(0.0);
-          continue;  
-        }
-        
-        current_color(i, j).r() = current_color(i, j).r() / current_weights(i, j);
-        current_color(i, j).g() = current_color(i, j).g() / current_weights(i, j);
-        current_color(i, j).b() = current_color(i, j).b() / current_weights(i, j);
-        current_mask(i ,j) = 255;
-      }
-    }
-
-
-    feathering(current_color_feathered, current_color, current_mask);
-    current_color = current_color_feathered;
-
-
-    for (int l = old_max_level; l < new_max_levels; l++) {
-
-      _levels.emplace_back(_levels[l - 1].Width() / 2, _levels[l - 1].Height() / 2, true, image::RGBfColor(0.0f, 0.0f, 0.0f));
-      _weights.emplace_back(_weights[l - 1].Width() / 2, _weights[l - 1].Height() / 2, true, 0.0f);
-    }
-
-    int width = current_color.Width();
-    int height = current_color.Height();
-    image::Image<image::RGBfColor> next_color;
-    image::Image<float> next_weights;
-
-    for (int l = old_max_level - 1; l < new_max_levels - 1; l++)
-    {
-      aliceVision::image::Image<image::RGBfColor> buf(width, height);
-      aliceVision::image::Image<image::RGBfColor> buf2(width, height);
-      aliceVision::image::Image<float> bufw(width, height);
-      
-      next_color = aliceVision::image::Image<image::RGBfColor>(width / 2, height / 2);
-      next_weights = aliceVision::image::Image<float>(width / 2, height / 2);
-
-      convolveGaussian5x5<image::RGBfColor>(buf, current_color);
-      downscale(next_color,  buf);
-
-      convolveGaussian5x5<float>(bufw, current_weights);
-      downscale(next_weights,  bufw);
-
-      upscale(buf, next_color);
-      convolveGaussian5x5<image::RGBfColor>(buf2, buf);
-
-      for (int i = 0; i  < buf2.Height(); i++) {
-        for (int j = 0; j < buf2.Width(); j++) {
-          buf2(i,j) *= 4.0f;
-        }
-      }
-
-      substract(current_color, current_color, buf2);
-
-      merge(current_color, current_weights, l, 0, 0);
-      
-      current_color = next_color;
-      current_weights = next_weights;
-      width /= 2;
-      height /= 2;
-    }
-
-    merge(current_color, current_weights, _levels.size() - 1, 0, 0);
-
-    return true;
-  }
-
-  bool apply(const aliceVision::image::Image<image::RGBfColor> & source, const aliceVision::image::Image<unsigned char> & mask, const aliceVision::image::Image<float> & weights, size_t offset_x, size_t offset_y) {
-
-    int width = source.Width();
-    int height = source.Height();
-
-    /* Convert mask to alpha layer */
-    image::Image<float> mask_float(width, height);
-    for (int i = 0; i < height; i++) {
-      for (int j = 0; j < width; j++) {
-        if (mask(i, j)) {
-          mask_float(i, j) = 1.0f;
-        }
-        else {
-          mask_float(i, j) = 0.0f;
-        }
-      }
-    }
-
-    image::Image<image::RGBfColor> current_color = source;
-    image::Image<image::RGBfColor> next_color;
-    image::Image<float> current_weights = weights;
-    image::Image<float> next_weights;
-    image::Image<float> current_mask = mask_float;
-    image::Image<float> next_mask;
-
-    for (int l = 0; l < _levels.size() - 1; l++)
-    {
-      aliceVision::image::Image<image::RGBfColor> buf_masked(width, height);
-      aliceVision::image::Image<image::RGBfColor> buf(width, height);
-      aliceVision::image::Image<image::RGBfColor> buf2(width, height);
-      aliceVision::image::Image<float> buf_float(width, height);
-      
-      next_color = aliceVision::image::Image<image::RGBfColor>(width / 2, height / 2);
-      next_weights = aliceVision::image::Image<float>(width / 2, height / 2);
-      next_mask = aliceVision::image::Image<float>(width / 2, height / 2);
-
-      /*Apply mask to content before convolution*/
-      for (int i = 0; i < current_color.Height(); i++) {
-        for (int j = 0; j < current_color.Width(); j++) {
-          if (std::abs(current_mask(i, j)) > 1e-6) {
-            buf_masked(i, j) = current_color(i, j);
+          if (tile(i, j).a() < 1e-6) {
+            tile(i, j).r() = 1.0f;
+            tile(i, j).g() = 0.0f;
+            tile(i, j).b() = 0.0f;
+            tile(i, j).a() = 0.0f;
           }
           else {
-            buf_masked(i, j).r() = 0.0f;
-            buf_masked(i, j).g() = 0.0f;
-            buf_masked(i, j).b() = 0.0f;
-            current_weights(i, j) = 0.0f;
+            tile(i, j).r() = tile(i, j).r() / tile(i, j).a();
+            tile(i, j).g() = tile(i, j).g() / tile(i, j).a();
+            tile(i, j).b() = tile(i, j).b() / tile(i, j).a();
+            tile(i, j).a() = 1.0f;
           }
         }
       }
+    });
 
-      convolveGaussian5x5<image::RGBfColor>(buf, buf_masked);
-      convolveGaussian5x5<float>(buf_float, current_mask);
-      
-      /*
-      Normalize given mask
-      */
-      for (int i = 0; i < current_color.Height(); i++) {
-        for (int j = 0; j < current_color.Width(); j++) {
-          
-          float m = buf_float(i, j);
-
-          if (std::abs(m) > 1e-6) {
-            buf(i, j).r() = buf(i, j).r() / m;
-            buf(i, j).g() = buf(i, j).g() / m;
-            buf(i, j).b() = buf(i, j).b() / m;
-            buf_float(i, j) = 1.0f;
-          }
-          else {
-            buf(i, j).r() = 0.0f;
-            buf(i, j).g() = 0.0f;
-            buf(i, j).b() = 0.0f;
-            buf_float(i, j) = 0.0f;
-          }
-        }
-      }
-
-      downscale(next_color,  buf);
-      downscale(next_mask,  buf_float);
-
-      upscale(buf, next_color);
-      convolveGaussian5x5<image::RGBfColor>(buf2, buf);
-
-      for (int i = 0; i  < buf2.Height(); i++) {
-        for (int j = 0; j < buf2.Width(); j++) {
-          buf2(i,j) *= 4.0f;
-        }
-      }
-
-      substract(current_color, current_color, buf2);
-
-      convolveGaussian5x5<float>(buf_float, current_weights);
-      downscale(next_weights, buf_float);
-
-      merge(current_color, current_weights, l, offset_x, offset_y);
-      
-      
-      current_color = next_color;
-      current_weights = next_weights;
-      current_mask = next_mask;
-
-      width /= 2;
-      height /= 2;
-      offset_x /= 2;
-      offset_y /= 2;
-    }
-
-    merge(current_color, current_weights, _levels.size() - 1, offset_x, offset_y);
+    /*Pixels never covered*/
+    _panorama.setFillValue(image::RGBAfColor(1.0f, 0.0f, 0.0f, 0.0f));
 
     return true;
   }
-  
-  bool merge(const aliceVision::image::Image<image::RGBfColor> & oimg, const aliceVision::image::Image<float> & oweight, size_t level, size_t offset_x, size_t offset_y) {
-
-    image::Image<image::RGBfColor> & img = _levels[level];
-    image::Image<float> & weight = _weights[level];
-
-    for (int i = 0; i  < oimg.Height(); i++) {
-
-      int di = i + offset_y;
-      if (di >= img.Height()) continue;
-
-      for (int j = 0; j < oimg.Width(); j++) {
-          
-        int dj = j + offset_x;
-        if (dj >= weight.Width()) {
-          dj = dj - weight.Width();
-        }
-
-        img(di, dj).r() += oimg(i, j).r() * oweight(i, j);
-        img(di, dj).g() += oimg(i, j).g() * oweight(i, j);
-        img(di, dj).b() += oimg(i, j).b() * oweight(i, j);
-        weight(di, dj) += oweight(i, j);
-      }
-    }    
-
-    return true;
-  }
-
-  bool rebuild(image::Image<image::RGBAfColor> & output) {
-
-    for (int l = 0; l < _levels.size(); l++) {
-      for (int i = 0; i < _levels[l].Height(); i++) {
-        for (int j = 0; j < _levels[l].Width(); j++) {
-          if (_weights[l](i, j) < 1e-6) {
-            _levels[l](i, j) = image::RGBfColor(0.0);
-            continue;  
-          }
-          
-          _levels[l](i, j).r() = _levels[l](i, j).r() / _weights[l](i, j);
-          _levels[l](i, j).g() = _levels[l](i, j).g() / _weights[l](i, j);
-          _levels[l](i, j).b() = _levels[l](i, j).b() / _weights[l](i, j);
-        }
-      }
-    }
-
-    removeNegativeValues(_levels[_levels.size() - 1]);
-
-    for (int l = _levels.size() - 2; l >= 0; l--) {
-
-      aliceVision::image::Image<image::RGBfColor> buf(_levels[l].Width(), _levels[l].Height());
-      aliceVision::image::Image<image::RGBfColor> buf2(_levels[l].Width(), _levels[l].Height());
-
-      upscale(buf, _levels[l + 1]);
-      convolveGaussian5x5<image::RGBfColor>(buf2, buf, true);
-      
-      for (int i = 0; i  < buf2.Height(); i++) {
-        for (int j = 0; j < buf2.Width(); j++) {
-          buf2(i,j) *= 4.0f;
-        }
-      }
-
-      addition(_levels[l], _levels[l], buf2);
-      removeNegativeValues(_levels[l]);
-    }
-
-    // Write output to RGBA
-    for (int i = 0; i < output.Height(); i++) {
-      for (int j = 0; j < output.Width(); j++) {
-        output(i, j).r() = _levels[0](i, j).r();
-        output(i, j).g() = _levels[0](i, j).g();
-        output(i, j).b() = _levels[0](i, j).b();
-
-        if (_weights[0](i, j) < 1e-6) {
-          output(i, j).a() = 0.0f;
-        }
-        else {
-          output(i, j).a() = 1.0f;
-        }
-      }
-    }
-
-    return true;
-  }
-
-private:
-  std::vector<aliceVision::image::Image<image::RGBfColor>> _levels;
-  std::vector<aliceVision::image::Image<float>> _weights;
 };
 
 class DistanceSeams {
@@ -1977,12 +1398,10 @@ public:
 
     for (int l = 1; l <= _levelOfInterest; l++) {
       
-      aliceVision::image::Image<image::RGBfColor> buf(current_color.Width(), current_color.Height());
       aliceVision::image::Image<image::RGBfColor> next_color(current_color.Width() / 2, current_color.Height() / 2);
       aliceVision::image::Image<unsigned char> next_mask(current_color.Width() / 2, current_color.Height() / 2);
       
-      convolveGaussian5x5<image::RGBfColor>(buf, current_color);
-      downscale(next_color, buf);
+      convolveGaussian5x5Downscale(next_color, current_color);
 
       for (int i = 0; i < next_mask.Height(); i++) {
         int di = i * 2;
@@ -2060,9 +1479,13 @@ class LaplacianCompositer : public Compositer
 {
 public:
 
-  LaplacianCompositer(size_t outputWidth, size_t outputHeight, size_t bands) :
-  Compositer(outputWidth, outputHeight),
-  _pyramid_panorama(outputWidth, outputHeight, bands),
+  /**
+   * The output panorama is the level 0 of the pyramid: it keeps half of the maxResidentTiles tiles,
+   * the other levels share the other half.
+   */
+  LaplacianCompositer(size_t outputWidth, size_t outputHeight, size_t bands, size_t tileSize, size_t maxResidentTiles, const std::string & scratchPath) :
+  Compositer(outputWidth, outputHeight, tileSize, std::max<size_t>(1, maxResidentTiles / 2), scratchPath),
+  _pyramid_panorama(_panorama, bands, std::max<size_t>(1, maxResidentTiles / 4), scratchPath),
   _bands(bands) {
 
   }
@@ -2120,16 +1543,19 @@ public:
 
   virtual bool terminate() {
 
-    _pyramid_panorama.rebuild(_panorama);
+    _pyramid_panorama.rebuild();
 
-    /*Go back to normal space from log space*/
-    for (int i = 0; i  < _panorama.Height(); i++) {
-      for (int j = 0; j < _panorama.Width(); j++) {
-        _panorama(i, j).r() = std::exp(_panorama(i, j).r());
-        _panorama(i, j).g() = std::exp(_panorama(i, j).g());
-        _panorama(i, j).b() = std::exp(_panorama(i, j).b());
+    /*Go back to normal space from log space, the alpha channel stores the sum of the weights*/
+    _panorama.forEachAllocatedTile([](TiledPanorama::Tile & tile) {
+      for (int i = 0; i  < tile.Height(); i++) {
+        for (int j = 0; j < tile.Width(); j++) {
+          tile(i, j).r() = std::exp(tile(i, j).r());
+          tile(i, j).g() = std::exp(tile(i, j).g());
+          tile(i, j).b() = std::exp(tile(i, j).b());
+          tile(i, j).a() = (tile(i, j).a() < 1e-6) ? 0.0f : 1.0f;
+        }
       }
-    }
+    });
 
     return true;
   }
@@ -2152,6 +1578,7 @@ int aliceVision_main(int argc, char **argv)
   bool showSeams = false;
 
   image::EStorageDataType storageDataType = image::EStorageDataType::Float;
+  int maxTileCacheSize = 4096;
 
   system::EVerboseLevel verboseLevel = system::Logger::getDefaultVerboseLevel();
 
@@ -2176,7 +1603,10 @@ int aliceVision_main(int argc, char **argv)
     ("overlayType,c", po::value<std::string>(&overlayType)->required(), "Overlay Type [none, borders, seams, all].")
     ("useGraphCut,c", po::value<bool>(&useGraphCut)->default_value(useGraphCut), "Do we use graphcut for ghost removal ?")
     ("storageDataType", po::value<image::EStorageDataType>(&storageDataType)->default_value(storageDataType),
-      ("Storage data type: " + image::EStorageDataType_informations()).c_str());
+      ("Storage data type: " + image::EStorageDataType_informations()).c_str())
+    ("maxTileCacheSize", po::value<int>(&maxTileCacheSize)->default_value(maxTileCacheSize),
+      "Maximum size (in MB) of the panorama tiles kept in memory (output panorama and multiband pyramid levels), "
+      "the other tiles are stored in scratch files next to the output.");
   allParams.add(optionalParams);
 
   // Setup log level given command line
@@ -2253,20 +1683,27 @@ int aliceVision_main(int argc, char **argv)
       ALICEVISION_LOG_INFO("Output panorama size set to " << panoramaSize.first << "x" << panoramaSize.second);
   }
 
+  // Output panorama tiles
+  const size_t tileSize = 256;
+  const size_t tileBytes = tileSize * tileSize * sizeof(image::RGBAfColor);
+  const size_t maxResidentTiles = std::max<size_t>(1, size_t(std::max(0, maxTileCacheSize)) * 1024 * 1024 / tileBytes);
+  const fs::path outputPath(outputPanorama);
+  const std::string scratchPath = (outputPath.parent_path() / outputPath.stem()).string() + "." + fs::unique_path().string() + ".tiles";
+
   std::unique_ptr<Compositer> compositer;
   bool isMultiBand = false;
   if (compositerType == "multiband")
   {
-    compositer = std::unique_ptr<Compositer>(new LaplacianCompositer(panoramaSize.first, panoramaSize.second, 1));
+    compositer = std::unique_ptr<Compositer>(new LaplacianCompositer(panoramaSize.first, panoramaSize.second, 1, tileSize, maxResidentTiles, scratchPath));
     isMultiBand = true;
   }
   else if (compositerType == "alpha")
   {
-    compositer = std::unique_ptr<Compositer>(new AlphaCompositer(panoramaSize.first, panoramaSize.second));
+    compositer = std::unique_ptr<Compositer>(new AlphaCompositer(panoramaSize.first, panoramaSize.second, tileSize, maxResidentTiles, scratchPath));
   }
   else
   {
-    compositer = std::unique_ptr<Compositer>(new Compositer(panoramaSize.first, panoramaSize.second));
+    compositer = std::unique_ptr<Compositer>(new Compositer(panoramaSize.first, panoramaSize.second, tileSize, maxResidentTiles, scratchPath));
   }
 
 
@@ -2488,12 +1925,10 @@ int aliceVision_main(int argc, char **argv)
 
   // Store output
   ALICEVISION_LOG_INFO("Write output panorama to file " << outputPanorama);
-  const aliceVision::image::Image<image::RGBAfColor> & panorama = compositer->getPanorama();
-
   // Select storage data type
   outputMetadata.push_back(oiio::ParamValue("AliceVision:storageDataType", image::EStorageDataType_enumToString(storageDataType)));
 
-  image::writeImage(outputPanorama, panorama, image::EImageColorSpace::AUTO, outputMetadata);
+  writePanorama(compositer->getPanorama(), outputPanorama, outputMetadata, storageDataType);
 
   return EXIT_SUCCESS;
 }
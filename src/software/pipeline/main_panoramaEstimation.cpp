@@ -76,7 +76,8 @@ int aliceVision_main(int argc, char **argv)
       feature::EImageDescriberType_informations().c_str())
     ("rotationAveraging", po::value<sfm::ERotationAveragingMethod>(&params.eRotationAveragingMethod)->default_value(params.eRotationAveragingMethod),
       "* 1: L1 minimization\n"
-      "* 2: L2 minimization")
+      "* 2: L2 minimization\n"
+      "* 3: IRLS minimization on sparse view graphs")
     ("relativeRotation", po::value<sfm::ERelativeRotationMethod>(&params.eRelativeRotationMethod)->default_value(params.eRelativeRotationMethod),
       "* from essential matrix"
       "* from rotation matrix"
@@ -139,7 +140,7 @@ int aliceVision_main(int argc, char **argv)
   system::Logger::get()->setLogLevel(verboseLevel);
 
   if (params.eRotationAveragingMethod < sfm::ROTATION_AVERAGING_L1 ||
-      params.eRotationAveragingMethod > sfm::ROTATION_AVERAGING_L2 )
+      params.eRotationAveragingMethod > sfm::ROTATION_AVERAGING_IRLS )
   {
     ALICEVISION_LOG_ERROR("Rotation averaging method is invalid");
     return EXIT_FAILURE;
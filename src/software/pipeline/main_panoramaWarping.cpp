@@ -238,34 +238,40 @@ public:
       size_t row_min_y = panoramaSize.second;
 
 
+      Mat3X rays(3, coarse_bbox.width);
       for (size_t x = 0; x < coarse_bbox.width; x++) {
 
         size_t cx = x + coarse_bbox.left;
 
-        Vec3 ray = SphericalMapping::fromEquirectangular(Vec2(cx, cy), panoramaSize.first, panoramaSize.second);
+        rays.col(x) = SphericalMapping::fromEquirectangular(Vec2(cx, cy), panoramaSize.first, panoramaSize.second);
+      }
+
+      /**
+       * Project the rays of the row to camera pixel coordinates
+       */
+      const Mat3X transformedRays = pose(rays);
+      Mat2X pix_disto;
+      // the rays are already in the camera frame
+      intrinsics.project(geometry::Pose3(), transformedRays, pix_disto, true);
+
+      for (size_t x = 0; x < coarse_bbox.width; x++) {
 
         /**
         * Check that this ray should be visible.
         * This test is camera type dependent
         */
-        Vec3 transformedRay = pose(ray);
-        if (!intrinsics.isVisibleRay(transformedRay)) {
+        if (!intrinsics.isVisibleRay(transformedRays.col(x))) {
           continue;
         }
 
-        /**
-         * Project this ray to camera pixel coordinates
-         */
-        const Vec2 pix_disto = intrinsics.project(pose, ray, true);
-
         /**
          * Ignore invalid coordinates
          */
-        if (!intrinsics.isVisible(pix_disto)) {
+        if (!intrinsics.isVisible(pix_disto.col(x))) {
           continue;
         }
 
-        buffer_coordinates(y, x) = pix_disto;
+        buffer_coordinates(y, x) = pix_disto.col(x);
         buffer_mask(y, x) = 1;
   
         row_min_x = std::min(x, row_min_x);
@@ -20,6 +20,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <cmath>
+#include <exception>
 #include <vector>
 #include <set>
 #include <iterator>
@@ -28,7 +29,7 @@
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 2
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 using namespace aliceVision;
 using namespace aliceVision::camera;
@@ -48,7 +49,8 @@ bool prepareDenseScene(const SfMData& sfmData,
                        image::EImageFileType outputFileType,
                        bool saveMetadata,
                        bool saveMatricesFiles,
-                       bool evCorrection)
+                       bool evCorrection,
+                       const std::string& undistortionMapsFolder)
 {
   // defined view Ids
   std::set<IndexT> viewIds;
@@ -84,154 +86,185 @@ bool prepareDenseScene(const SfMData& sfmData,
   const float medianCameraExposure = sfmData.getMedianCameraExposureSetting();
   ALICEVISION_LOG_INFO("Median Camera Exposure: " << medianCameraExposure << ", Median EV: " << std::log2(1.0f/medianCameraExposure));
 
+  // undistortion maps shared by the views of the same intrinsic
+  UndistortionMapCache undistortionMaps(undistortionMapsFolder);
+
+  // first error raised by a view
+  std::exception_ptr error;
+  bool hasError = false;
+
 #pragma omp parallel for num_threads(3)
   for(int i = 0; i < viewIds.size(); ++i)
   {
-    auto itView = viewIds.begin();
-    std::advance(itView, i);
-
-    const IndexT viewId = *itView;
-    const View* view = sfmData.getViews().at(viewId).get();
-
-    Intrinsics::const_iterator iterIntrinsic = sfmData.getIntrinsics().find(view->getIntrinsicId());
-
-    //we have a valid view with a corresponding camera & pose
-    const std::string baseFilename = std::to_string(viewId);
-
-    // get metadata from source image to be sure we get all metadata. We don't use the metadatas from the Views inside the SfMData to avoid type conversion problems with string maps.
-    std::string srcImage = view->getImagePath();
-    oiio::ParamValueList metadata = image::readImageMetadata(srcImage);
+    bool failed;
+    #pragma omp atomic read
+    failed = hasError;
+    if(failed)
+      continue;
 
-    // export camera
-    if(saveMetadata || saveMatricesFiles)
+    try
     {
-      // get camera pose / projection
-      const Pose3 pose = sfmData.getPose(*view).getTransform();
-
-      std::shared_ptr<camera::IntrinsicBase> cam = iterIntrinsic->second;
-      std::shared_ptr<camera::Pinhole> camPinHole = std::dynamic_pointer_cast<camera::Pinhole>(cam);
-      if (!camPinHole) {
-        ALICEVISION_LOG_ERROR("Camera is not pinhole in filter");
-        continue;
-      }
+      auto itView = viewIds.begin();
+      std::advance(itView, i);
 
-      Mat34 P = camPinHole->getProjectiveEquivalent(pose);
+      const IndexT viewId = *itView;
+      const View* view = sfmData.getViews().at(viewId).get();
 
-      // get camera intrinsics matrices
-      const Mat3 K = dynamic_cast<const Pinhole*>(sfmData.getIntrinsicPtr(view->getIntrinsicId()))->K();
-      const Mat3& R = pose.rotation();
-      const Vec3& t = pose.translation();
+      Intrinsics::const_iterator iterIntrinsic = sfmData.getIntrinsics().find(view->getIntrinsicId());
 
-      if(saveMatricesFiles)
-      {
-        std::ofstream fileP((fs::path(outFolder) / (baseFilename + "_P.txt")).string());
-        fileP << std::setprecision(10)
-             << P(0, 0) << " " << P(0, 1) << " " << P(0, 2) << " " << P(0, 3) << "\n"
-             << P(1, 0) << " " << P(1, 1) << " " << P(1, 2) << " " << P(1, 3) << "\n"
-             << P(2, 0) << " " << P(2, 1) << " " << P(2, 2) << " " << P(2, 3) << "\n";
-        fileP.close();
-
-        std::ofstream fileKRt((fs::path(outFolder) / (baseFilename + "_KRt.txt")).string());
-        fileKRt << std::setprecision(10)
-             << K(0, 0) << " " << K(0, 1) << " " << K(0, 2) << "\n"
-             << K(1, 0) << " " << K(1, 1) << " " << K(1, 2) << "\n"
-             << K(2, 0) << " " << K(2, 1) << " " << K(2, 2) << "\n"
-             << "\n"
-             << R(0, 0) << " " << R(0, 1) << " " << R(0, 2) << "\n"
-             << R(1, 0) << " " << R(1, 1) << " " << R(1, 2) << "\n"
-             << R(2, 0) << " " << R(2, 1) << " " << R(2, 2) << "\n"
-             << "\n"
-             << t(0) << " " << t(1) << " " << t(2) << "\n";
-        fileKRt.close();
-      }
+      //we have a valid view with a corresponding camera & pose
+      const std::string baseFilename = std::to_string(viewId);
 
-      if(saveMetadata)
-      {
-        // convert to 44 matix
-        Mat4 projectionMatrix;
-        projectionMatrix << P(0, 0), P(0, 1), P(0, 2), P(0, 3),
-                            P(1, 0), P(1, 1), P(1, 2), P(1, 3),
-                            P(2, 0), P(2, 1), P(2, 2), P(2, 3),
-                                  0,       0,       0,       1;
-
-        // convert matrices to rowMajor
-        std::vector<double> vP(projectionMatrix.size());
-        std::vector<double> vK(K.size());
-        std::vector<double> vR(R.size());
-
-        typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMatrixXd;
-        Eigen::Map<RowMatrixXd>(vP.data(), projectionMatrix.rows(), projectionMatrix.cols()) = projectionMatrix;
-        Eigen::Map<RowMatrixXd>(vK.data(), K.rows(), K.cols()) = K;
-        Eigen::Map<RowMatrixXd>(vR.data(), R.rows(), R.cols()) = R;
-
-        // add metadata
-        metadata.push_back(oiio::ParamValue("AliceVision:downscale", 1));
-        metadata.push_back(oiio::ParamValue("AliceVision:P", oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::MATRIX44), 1, vP.data()));
-        metadata.push_back(oiio::ParamValue("AliceVision:K", oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::MATRIX33), 1, vK.data()));
-        metadata.push_back(oiio::ParamValue("AliceVision:R", oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::MATRIX33), 1, vR.data()));
-        metadata.push_back(oiio::ParamValue("AliceVision:t", oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::VEC3), 1, t.data()));
-      }
-    }
+      // get metadata from source image to be sure we get all metadata. We don't use the metadatas from the Views inside the SfMData to avoid type conversion problems with string maps.
+      std::string srcImage = view->getImagePath();
+      oiio::ParamValueList metadata = image::readImageMetadata(srcImage);
 
-    // export undistort image
-    {      
-      if(!imagesFolders.empty())
+      // export camera
+      if(saveMetadata || saveMatricesFiles)
       {
-          std::vector<std::string> paths = sfmDataIO::viewPathsFromFolders(*view, imagesFolders);
-
-          // if path was not found
-          if(paths.empty())
-          {
-              throw std::runtime_error("Cannot find view '" + std::to_string(view->getViewId()) + "' image file in given folder(s)");
-          }
-          else if(paths.size() > 1)
-          {
-              throw std::runtime_error( "Ambiguous case: Multiple source image files found in given folder(s) for the view '" + 
-                  std::to_string(view->getViewId()) + "'.");
-          }
-
-          srcImage = paths[0];
+        // get camera pose / projection
+        const Pose3 pose = sfmData.getPose(*view).getTransform();
+
+        std::shared_ptr<camera::IntrinsicBase> cam = iterIntrinsic->second;
+        std::shared_ptr<camera::Pinhole> camPinHole = std::dynamic_pointer_cast<camera::Pinhole>(cam);
+        if (!camPinHole) {
+          ALICEVISION_LOG_ERROR("Camera is not pinhole in filter");
+          continue;
+        }
+
+        Mat34 P = camPinHole->getProjectiveEquivalent(pose);
+
+        // get camera intrinsics matrices
+        const Mat3 K = dynamic_cast<const Pinhole*>(sfmData.getIntrinsicPtr(view->getIntrinsicId()))->K();
+        const Mat3& R = pose.rotation();
+        const Vec3& t = pose.translation();
+
+        if(saveMatricesFiles)
+        {
+          std::ofstream fileP((fs::path(outFolder) / (baseFilename + "_P.txt")).string());
+          fileP << std::setprecision(10)
+               << P(0, 0) << " " << P(0, 1) << " " << P(0, 2) << " " << P(0, 3) << "\n"
+               << P(1, 0) << " " << P(1, 1) << " " << P(1, 2) << " " << P(1, 3) << "\n"
+               << P(2, 0) << " " << P(2, 1) << " " << P(2, 2) << " " << P(2, 3) << "\n";
+          fileP.close();
+
+          std::ofstream fileKRt((fs::path(outFolder) / (baseFilename + "_KRt.txt")).string());
+          fileKRt << std::setprecision(10)
+               << K(0, 0) << " " << K(0, 1) << " " << K(0, 2) << "\n"
+               << K(1, 0) << " " << K(1, 1) << " " << K(1, 2) << "\n"
+               << K(2, 0) << " " << K(2, 1) << " " << K(2, 2) << "\n"
+               << "\n"
+               << R(0, 0) << " " << R(0, 1) << " " << R(0, 2) << "\n"
+               << R(1, 0) << " " << R(1, 1) << " " << R(1, 2) << "\n"
+               << R(2, 0) << " " << R(2, 1) << " " << R(2, 2) << "\n"
+               << "\n"
+               << t(0) << " " << t(1) << " " << t(2) << "\n";
+          fileKRt.close();
+        }
+
+        if(saveMetadata)
+        {
+          // convert to 44 matix
+          Mat4 projectionMatrix;
+          projectionMatrix << P(0, 0), P(0, 1), P(0, 2), P(0, 3),
+                              P(1, 0), P(1, 1), P(1, 2), P(1, 3),
+                              P(2, 0), P(2, 1), P(2, 2), P(2, 3),
+                                    0,       0,       0,       1;
+
+          // convert matrices to rowMajor
+          std::vector<double> vP(projectionMatrix.size());
+          std::vector<double> vK(K.size());
+          std::vector<double> vR(R.size());
+
+          typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMatrixXd;
+          Eigen::Map<RowMatrixXd>(vP.data(), projectionMatrix.rows(), projectionMatrix.cols()) = projectionMatrix;
+          Eigen::Map<RowMatrixXd>(vK.data(), K.rows(), K.cols()) = K;
+          Eigen::Map<RowMatrixXd>(vR.data(), R.rows(), R.cols()) = R;
+
+          // add metadata
+          metadata.push_back(oiio::ParamValue("AliceVision:downscale", 1));
+          metadata.push_back(oiio::ParamValue("AliceVision:P", oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::MATRIX44), 1, vP.data()));
+          metadata.push_back(oiio::ParamValue("AliceVision:K", oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::MATRIX33), 1, vK.data()));
+          metadata.push_back(oiio::ParamValue("AliceVision:R", oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::MATRIX33), 1, vR.data()));
+          metadata.push_back(oiio::ParamValue("AliceVision:t", oiio::TypeDesc(oiio::TypeDesc::DOUBLE, oiio::TypeDesc::VEC3), 1, t.data()));
+        }
       }
-      const std::string dstColorImage = (fs::path(outFolder) / (baseFilename + "." + image::EImageFileType_enumToString(outputFileType))).string();
-      const IntrinsicBase* cam = iterIntrinsic->second.get();
-      Image<RGBfColor> image, image_ud;
 
-      readImage(srcImage, image, image::EImageColorSpace::LINEAR);
-
-      // add exposure values to images metadata
-      float cameraExposure = view->getCameraExposureSetting();
-      float ev = std::log2(1.0 / cameraExposure);
-      float exposureCompensation = medianCameraExposure / cameraExposure;
-      metadata.push_back(oiio::ParamValue("AliceVision:EV", ev));
-      metadata.push_back(oiio::ParamValue("AliceVision:EVComp", exposureCompensation));
-
-      //exposure correction
-      if(evCorrection)
-      {
-          ALICEVISION_LOG_INFO("View: " << viewId << ", Ev: " << ev << ", Ev compensation: " << exposureCompensation);
-
-          for(int pix = 0; pix < image.Width() * image.Height(); ++pix)
-              image(pix) = image(pix) * exposureCompensation;
-
-      }
+      // export undistort image
+      {      
+        if(!imagesFolders.empty())
+        {
+            std::vector<std::string> paths = sfmDataIO::viewPathsFromFolders(*view, imagesFolders);
+
+            // if path was not found
+            if(paths.empty())
+            {
+                throw std::runtime_error("Cannot find view '" + std::to_string(view->getViewId()) + "' image file in given folder(s)");
+            }
+            else if(paths.size() > 1)
+            {
+                throw std::runtime_error( "Ambiguous case: Multiple source image files found in given folder(s) for the view '" + 
+                    std::to_string(view->getViewId()) + "'.");
+            }
+
+            srcImage = paths[0];
+        }
+        const std::string dstColorImage = (fs::path(outFolder) / (baseFilename + "." + image::EImageFileType_enumToString(outputFileType))).string();
+        const IntrinsicBase* cam = iterIntrinsic->second.get();
+        Image<RGBfColor> image, image_ud;
+
+        readImage(srcImage, image, image::EImageColorSpace::LINEAR);
+
+        // add exposure values to images metadata
+        float cameraExposure = view->getCameraExposureSetting();
+        float ev = std::log2(1.0 / cameraExposure);
+        float exposureCompensation = medianCameraExposure / cameraExposure;
+        metadata.push_back(oiio::ParamValue("AliceVision:EV", ev));
+        metadata.push_back(oiio::ParamValue("AliceVision:EVComp", exposureCompensation));
+
+        //exposure correction
+        if(evCorrection)
+        {
+            ALICEVISION_LOG_INFO("View: " << viewId << ", Ev: " << ev << ", Ev compensation: " << exposureCompensation);
+
+            for(int pix = 0; pix < image.Width() * image.Height(); ++pix)
+                image(pix) = image(pix) * exposureCompensation;
+
+        }
       
-      // undistort
-      if(cam->isValid() && cam->hasDistortion())
-      {
-        // undistort the image and save it
-        UndistortImage(image, cam, image_ud, FBLACK);
-        writeImage(dstColorImage, image_ud, image::EImageColorSpace::AUTO, metadata);
+        // undistort
+        if(cam->isValid() && cam->hasDistortion())
+        {
+          // undistort the image and save it
+          UndistortImage(image, *undistortionMaps.get(*cam, image.Width(), image.Height()), image_ud, FBLACK);
+          writeImage(dstColorImage, image_ud, image::EImageColorSpace::AUTO, metadata);
+        }
+        else
+        {
+          writeImage(dstColorImage, image, image::EImageColorSpace::AUTO, metadata);
+        }
       }
-      else
+    }
+    catch(...)
+    {
+      // exceptions cannot escape the OpenMP loop, the first one is rethrown after the loop
+      #pragma omp critical(prepareDenseScene_error)
       {
-        writeImage(dstColorImage, image, image::EImageColorSpace::AUTO, metadata);
+        if(!error)
+          error = std::current_exception();
       }
+      #pragma omp atomic write
+      hasError = true;
+      continue;
     }
 
     #pragma omp critical
     ++progressBar;
   }
 
+  if(error)
+    std::rethrow_exception(error);
+
   return true;
 }
 
@@ -249,6 +282,7 @@ int aliceVision_main(int argc, char *argv[])
   bool saveMetadata = true;
   bool saveMatricesTxtFiles = false;
   bool evCorrection = false;
+  std::string undistortionMapsFolder;
 
   po::options_description allParams("AliceVision prepareDenseScene");
 
@@ -275,7 +309,9 @@ int aliceVision_main(int argc, char *argv[])
     ("rangeSize", po::value<int>(&rangeSize)->default_value(rangeSize),
       "Range size.")
     ("evCorrection", po::value<bool>(&evCorrection)->default_value(evCorrection),
-      "Correct exposure value.");
+      "Correct exposure value.")
+    ("undistortionMapsFolder", po::value<std::string>(&undistortionMapsFolder)->default_value(undistortionMapsFolder),
+      "Folder to save and reuse the undistortion maps of the intrinsics (useful when the scene is processed in several chunks).");
 
   po::options_description logParams("Log parameters");
   logParams.add_options()
@@ -352,8 +388,12 @@ int aliceVision_main(int argc, char *argv[])
     rangeStart = 0;
   }
 
+  // create undistortion maps folder
+  if(!undistortionMapsFolder.empty() && !fs::exists(undistortionMapsFolder))
+    fs::create_directory(undistortionMapsFolder);
+
   // export
-  if(prepareDenseScene(sfmData, imagesFolders, rangeStart, rangeEnd, outFolder, outputFileType, saveMetadata, saveMatricesTxtFiles, evCorrection))
+  if(prepareDenseScene(sfmData, imagesFolders, rangeStart, rangeEnd, outFolder, outputFileType, saveMetadata, saveMatricesTxtFiles, evCorrection, undistortionMapsFolder))
     return EXIT_SUCCESS;
 
   return EXIT_FAILURE;
@@ -0,0 +1,169 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2020 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/sfmData/SfMData.hpp>
+#include <aliceVision/sfmDataIO/sfmDataIO.hpp>
+#include <aliceVision/sfm/BundleAdjustmentPartitioned.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/cmdline.hpp>
+#include <aliceVision/system/main.hpp>
+#include <aliceVision/config.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <string>
+
+// These constants define the current software version.
+// They must be updated when the command line is changed.
+#define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+
+using namespace aliceVision;
+
+namespace po = boost::program_options;
+
+int aliceVision_main(int argc, char **argv)
+{
+  // command-line parameters
+
+  std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
+  std::string sfmDataFilename;
+  std::string outSfMDataFilename;
+
+  // user optional parameters
+  sfm::BundleAdjustmentPartitioned::Options options;
+  int partitionId = -1;
+  bool refineIntrinsics = true;
+
+  po::options_description allParams(
+    "AliceVision sfmBundleAdjustment\n"
+    "Bundle adjustment of a large scene split in partitions of co-visible views.\n"
+    "The partitions are solved in the current process, or by worker processes sharing a working folder:\n"
+    " - coordinator: --input --output --workingFolder\n"
+    " - worker of each partition: --workingFolder --partition <id>");
+
+  po::options_description coordinatorParams("Coordinator parameters");
+  coordinatorParams.add_options()
+    ("input,i", po::value<std::string>(&sfmDataFilename),
+      "SfMData file to adjust (coordinator).")
+    ("output,o", po::value<std::string>(&outSfMDataFilename),
+      "Output SfMData scene (coordinator).");
+
+  po::options_description optionalParams("Optional parameters");
+  optionalParams.add_options()
+    ("workingFolder", po::value<std::string>(&options.workingFolder)->default_value(options.workingFolder),
+      "Folder shared with the worker processes. If empty, the partitions are solved in the current process.")
+    ("partition", po::value<int>(&partitionId)->default_value(partitionId),
+      "Index of the partition solved by this worker process (-1: coordinator).")
+    ("maxViewsPerPartition", po::value<std::size_t>(&options.maxViewsPerPartition)->default_value(options.maxViewsPerPartition),
+      "Maximum number of views of a partition, before the overlap.")
+    ("overlapRatio", po::value<double>(&options.overlapRatio)->default_value(options.overlapRatio),
+      "Number of views added to each partition from its neighbours, relative to the partition size.")
+    ("maxIterations", po::value<std::size_t>(&options.maxIterations)->default_value(options.maxIterations),
+      "Maximum number of consensus iterations.")
+    ("consensusWeight", po::value<double>(&options.consensusWeight)->default_value(options.consensusWeight),
+      "Initial weight of the consensus priors.")
+    ("convergenceThreshold", po::value<double>(&options.convergenceThreshold)->default_value(options.convergenceThreshold),
+      "Relative distance between the partitions and the consensus to stop the iterations.")
+    ("workerTimeout", po::value<double>(&options.workerTimeout)->default_value(options.workerTimeout),
+      "Time to wait for the other processes (s).")
+    ("refineIntrinsics", po::value<bool>(&refineIntrinsics)->default_value(refineIntrinsics),
+      "Refine the camera intrinsics.")
+    ("useAnalyticJacobians", po::value<bool>(&options.ceresOptions.useAnalyticJacobians)->default_value(options.ceresOptions.useAnalyticJacobians),
+      "Use the analytic jacobians of the camera models instead of automatic differentiation.");
+
+  po::options_description logParams("Log parameters");
+  logParams.add_options()
+    ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+      "verbosity level (fatal,  error, warning, info, debug, trace).");
+
+  allParams.add(coordinatorParams).add(optionalParams).add(logParams);
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help") || (argc == 1))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(boost::program_options::required_option& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  ALICEVISION_COUT("Program called with the following parameters:");
+  ALICEVISION_COUT(vm);
+
+  // set verbose level
+  system::Logger::get()->setLogLevel(verboseLevel);
+
+  // worker process
+  if(partitionId >= 0)
+  {
+    if(options.workingFolder.empty())
+    {
+      ALICEVISION_LOG_ERROR("A worker process needs the --workingFolder option");
+      return EXIT_FAILURE;
+    }
+
+    if(!sfm::runBundleAdjustmentPartitionWorker(options.workingFolder, partitionId, options.ceresOptions, options.workerTimeout))
+      return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+  }
+
+  if(sfmDataFilename.empty() || outSfMDataFilename.empty())
+  {
+    ALICEVISION_LOG_ERROR("The coordinator needs the --input and --output options");
+    return EXIT_FAILURE;
+  }
+
+  // Load input scene
+  sfmData::SfMData sfmData;
+  if(!sfmDataIO::Load(sfmData, sfmDataFilename, sfmDataIO::ESfMData::ALL))
+  {
+    ALICEVISION_LOG_ERROR("The input SfMData file '" << sfmDataFilename << "' cannot be read");
+    return EXIT_FAILURE;
+  }
+
+  sfm::BundleAdjustment::ERefineOptions refineOptions = sfm::BundleAdjustment::REFINE_ROTATION |
+                                                        sfm::BundleAdjustment::REFINE_TRANSLATION |
+                                                        sfm::BundleAdjustment::REFINE_STRUCTURE;
+  if(refineIntrinsics)
+    refineOptions |= sfm::BundleAdjustment::REFINE_INTRINSICS_ALL;
+
+  sfm::BundleAdjustmentPartitioned BA(options);
+  if(!BA.adjust(sfmData, refineOptions))
+  {
+    ALICEVISION_LOG_ERROR("The partitioned bundle adjustment failed");
+    return EXIT_FAILURE;
+  }
+  BA.getStatistics().show();
+
+  ALICEVISION_LOG_INFO("Save into '" << outSfMDataFilename << "'");
+
+  // Export the SfMData scene in the expected format
+  if(!sfmDataIO::Save(sfmData, outSfMDataFilename, sfmDataIO::ESfMData::ALL))
+  {
+    ALICEVISION_LOG_ERROR("An error occurred while trying to save '" << outSfMDataFilename << "'");
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
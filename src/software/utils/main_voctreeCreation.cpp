@@ -21,13 +21,14 @@
 
 #include <iostream>
 #include <fstream>
+#include <memory>
 #include <string>
 #include <chrono>
 
 // These constants define the current software version.
 // They must be updated when the command line is changed.
 #define ALICEVISION_SOFTWARE_VERSION_MAJOR 1
-#define ALICEVISION_SOFTWARE_VERSION_MINOR 0
+#define ALICEVISION_SOFTWARE_VERSION_MINOR 1
 
 static const int DIMENSION = 128;
 
@@ -55,6 +56,13 @@ int aliceVision_main(int argc, char** argv)
   std::uint32_t restart = 5;
   std::uint32_t LEVELS = 6;
   bool sanityCheck = true;
+  bool mappableTree = false;
+  std::size_t miniBatchSize = 0;
+  bool streaming = false;
+  std::size_t chunkSize = 1000000;
+  std::size_t maxSampleSize = 1000000;
+  std::size_t nbPasses = 1;
+  bool uint8Centers = false;
 
   po::options_description allParams("This program is used to load the sift descriptors from a SfMData file and create a vocabulary tree\n"
                                     "It takes as input either a list.txt file containing the a simple list of images (bundler format and older AliceVision version format)\n"
@@ -74,6 +82,16 @@ int aliceVision_main(int argc, char** argv)
     (",k", po::value<uint32_t>(&K)->default_value(10), "The branching factor of the tree")
     ("restart,r", po::value<uint32_t>(&restart)->default_value(5), "Number of times that the kmean is launched for each cluster, the best solution is kept")
     (",L", po::value<uint32_t>(&LEVELS)->default_value(6), "Number of levels of the tree")
+    ("miniBatchSize", po::value<std::size_t>(&miniBatchSize)->default_value(miniBatchSize), "Number of descriptors randomly drawn at each k-means iteration (mini-batch k-means), "
+      "0 to use all the descriptors at each iteration (Lloyd's algorithm)")
+    ("streaming", po::value<bool>(&streaming)->default_value(streaming), "Read the descriptors from disk by chunks to build the tree in bounded memory, instead of loading all the descriptors. "
+      "Each level of the tree is initialized from a subset of the descriptors then refined on all the descriptors")
+    ("chunkSize", po::value<std::size_t>(&chunkSize)->default_value(chunkSize), "Streaming: minimal number of descriptors read at once")
+    ("maxSampleSize", po::value<std::size_t>(&maxSampleSize)->default_value(maxSampleSize), "Streaming: maximal number of descriptors kept in memory to initialize the nodes of a level")
+    ("nbPasses", po::value<std::size_t>(&nbPasses)->default_value(nbPasses), "Streaming: number of refinement passes over the descriptors for each level")
+    ("mappableTree", po::value<bool>(&mappableTree)->default_value(mappableTree), "Save the tree in the mappable format: the tree file is memory-mapped when loaded, "
+      "so the loading is immediate and the memory is shared between the processes using the same tree")
+    ("uint8Centers", po::value<bool>(&uint8Centers)->default_value(uint8Centers), "Store the centers of the tree as 8-bit values (mappable format only), the tree file is 4 times smaller")
     ("sanitycheck,s", po::value<bool>(&sanityCheck)->default_value(sanityCheck), "Perform a sanity check at the end of the creation of the vocabulary tree. The sanity check is a query to the database with the same documents/images useed to train the vocabulary tree");
 
   po::options_description logParams("Log parameters");
@@ -115,6 +133,12 @@ int aliceVision_main(int argc, char** argv)
   // set verbose level
   system::Logger::get()->setLogLevel(verboseLevel);
 
+  if(uint8Centers && !mappableTree)
+  {
+    ALICEVISION_LOG_ERROR("The 8-bit centers are only available with the mappable tree format (use --mappableTree).");
+    return EXIT_FAILURE;
+  }
+
   // load SfMData
   sfmData::SfMData sfmData;
   if(!sfmDataIO::Load(sfmData, sfmDataFilename, sfmDataIO::ESfMData::ALL))
@@ -124,35 +148,57 @@ int aliceVision_main(int argc, char** argv)
   }
 
   std::vector<DescriptorFloat> descriptors;
-
   std::vector<size_t> descRead;
-  ALICEVISION_COUT("Reading descriptors from " << sfmDataFilename);
+  // streaming: the descriptors are read from the files when needed
+  std::unique_ptr<aliceVision::voctree::DescriptorFilesStream<DescriptorFloat, DescriptorUChar>> descriptorsStream;
+
   auto detect_start = std::chrono::steady_clock::now();
-  size_t numTotDescriptors = aliceVision::voctree::readDescFromFiles<DescriptorFloat, DescriptorUChar>(sfmData, featuresFolders, descriptors, descRead);
-  auto detect_end = std::chrono::steady_clock::now();
+  auto detect_end = detect_start;
   auto detect_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(detect_end - detect_start);
-  if(descriptors.size() == 0)
+
+  if(streaming)
   {
-    ALICEVISION_CERR("No descriptors loaded!!");
-    return EXIT_FAILURE;
+    descriptorsStream.reset(new aliceVision::voctree::DescriptorFilesStream<DescriptorFloat, DescriptorUChar>(sfmData, featuresFolders, chunkSize));
+    ALICEVISION_COUT(descriptorsStream->getDescriptorsFiles().size() << " descriptor files will be streamed by chunks of " << chunkSize << " descriptors");
   }
+  else
+  {
+    ALICEVISION_COUT("Reading descriptors from " << sfmDataFilename);
+    size_t numTotDescriptors = aliceVision::voctree::readDescFromFiles<DescriptorFloat, DescriptorUChar>(sfmData, featuresFolders, descriptors, descRead);
+    detect_end = std::chrono::steady_clock::now();
+    detect_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(detect_end - detect_start);
+    if(descriptors.size() == 0)
+    {
+      ALICEVISION_CERR("No descriptors loaded!!");
+      return EXIT_FAILURE;
+    }
 
-  ALICEVISION_COUT("Done! " << descRead.size() << " sets of descriptors read for a total of " << numTotDescriptors << " features");
-  ALICEVISION_COUT("Reading took " << detect_elapsed.count() << " sec");
+    ALICEVISION_COUT("Done! " << descRead.size() << " sets of descriptors read for a total of " << numTotDescriptors << " features");
+    ALICEVISION_COUT("Reading took " << detect_elapsed.count() << " sec");
+  }
 
   // Create tree
   aliceVision::voctree::TreeBuilder<DescriptorFloat> builder(DescriptorFloat(0));
   builder.setVerbose(tbVerbosity);
   builder.kmeans().setRestarts(restart);
+  builder.kmeans().setMiniBatchSize(miniBatchSize);
+  builder.setMaxSampleSize(maxSampleSize);
+  builder.setNbPasses(nbPasses);
   ALICEVISION_COUT("Building a tree of L=" << LEVELS << " levels with a branching factor of k=" << K);
   detect_start = std::chrono::steady_clock::now();
-  builder.build(descriptors, K, LEVELS);
+  if(streaming)
+    builder.build(*descriptorsStream, K, LEVELS);
+  else
+    builder.build(descriptors, K, LEVELS);
   detect_end = std::chrono::steady_clock::now();
   detect_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(detect_end - detect_start);
   ALICEVISION_COUT("Tree created in " << ((float) detect_elapsed.count()) / 1000 << " sec");
   ALICEVISION_COUT(builder.tree().centers().size() << " centers");
   ALICEVISION_COUT("Saving vocabulary tree as " << treeName);
-  builder.tree().save(treeName);
+  if(mappableTree)
+    builder.tree().saveMappable(treeName, uint8Centers ? aliceVision::voctree::ETreeCentersType::UINT8 : aliceVision::voctree::ETreeCentersType::FLOAT);
+  else
+    builder.tree().save(treeName);
 
   aliceVision::voctree::SparseHistogramPerImage allSparseHistograms;
   // temporary vector used to save all the visual word for each image before adding them to documents
@@ -160,21 +206,42 @@ int aliceVision_main(int argc, char** argv)
   ALICEVISION_COUT("Quantizing the features");
   size_t offset = 0; ///< this is used to align to the features of a given image in 'feature'
   detect_start = std::chrono::steady_clock::now();
+  const size_t nbImages = streaming ? descriptorsStream->getDescriptorsFiles().size() : descRead.size();
+  std::map<IndexT, std::string>::const_iterator descriptorsFileIt;
+  if(streaming)
+    descriptorsFileIt = descriptorsStream->getDescriptorsFiles().begin();
+  std::vector<DescriptorFloat> imageDescriptors;
   // pass each feature through the vocabulary tree to get the associated visual word
   // for each read images, recover the number of features in it from descRead and loop over the features
-  for(size_t i = 0; i < descRead.size(); ++i)
+  for(size_t i = 0; i < nbImages; ++i)
   {
     // for each image:
+    // get its descriptors, from the file in streaming mode
+    const DescriptorFloat* imageDescriptorsPtr;
+    size_t nbImageDescriptors;
+    if(streaming)
+    {
+      feature::loadDescsFromBinFile<DescriptorFloat, DescriptorUChar>(descriptorsFileIt->second, imageDescriptors);
+      ++descriptorsFileIt;
+      imageDescriptorsPtr = imageDescriptors.data();
+      nbImageDescriptors = imageDescriptors.size();
+    }
+    else
+    {
+      imageDescriptorsPtr = descriptors.data() + offset;
+      nbImageDescriptors = descRead[i];
+    }
+
     // clear the temporary vector used to save all the visual word and allocate the proper size
     imgVisualWords.clear();
     // allocate as many visual words as the number of the features in the image
-    imgVisualWords.resize(descRead[i], 0);
+    imgVisualWords.resize(nbImageDescriptors, 0);
 
     #pragma omp parallel for
-    for(ptrdiff_t j = 0; j < static_cast<ptrdiff_t>(descRead[i]); ++j)
+    for(ptrdiff_t j = 0; j < static_cast<ptrdiff_t>(nbImageDescriptors); ++j)
     {
       //	store the visual word associated to the feature in the temporary list
-      imgVisualWords[j] = builder.tree().quantize(descriptors[ j + offset ]);
+      imgVisualWords[j] = builder.tree().quantize(imageDescriptorsPtr[j]);
     }
     aliceVision::voctree::SparseHistogram histo;
     aliceVision::voctree::computeSparseHistogram(imgVisualWords, histo);
@@ -182,7 +249,7 @@ int aliceVision_main(int argc, char** argv)
     allSparseHistograms[i] = histo;
 
     // update the offset
-    offset += descRead[i];
+    offset += nbImageDescriptors;
   }
   detect_end = std::chrono::steady_clock::now();
   detect_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(detect_end - detect_start);
@@ -110,7 +110,8 @@ int aliceVision_main(int argc, char** argv)
                                                                           "-commonPoints: counts common points between histograms \n"
                                                                           "-strongCommonPoints: counts common 1 values \n"
                                                                           "-weightedStrongCommonPoints: strongCommonPoints with weights \n"
-                                                                          "-inversedWeightedCommonPoints: strongCommonPoints with inverted weights");
+                                                                          "-inversedWeightedCommonPoints: strongCommonPoints with inverted weights \n"
+                                                                          "-tfidf: L1 distance between the normalized TF-IDF histograms");
 
   po::options_description logParams("Log parameters");
   logParams.add_options()